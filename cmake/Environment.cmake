@@ -18,6 +18,33 @@ ENDIF()
 
 set_property(GLOBAL PROPERTY USE_FOLDERS ON)
 
+# Instruction set the tracker's BGR->HSV converter is compiled for.
+# Only that one file gets these flags, so the rest of the service still runs on any x86 cpu.
+set(PSM_TRACKER_SIMD "SSE4" CACHE STRING "SIMD kernel used for the tracker BGR->HSV conversion: NONE, SSE4 or AVX2 on x86, NEON (unverified) on ARM")
+set_property(CACHE PSM_TRACKER_SIMD PROPERTY STRINGS NONE SSE4 AVX2 NEON)
+set(PSM_TRACKER_SIMD_FLAGS "")
+IF(${CMAKE_SYSTEM_PROCESSOR} MATCHES "(x86_64|AMD64|amd64|i[3-6]86|x86)")
+    IF(${PSM_TRACKER_SIMD} STREQUAL "AVX2")
+        IF(MSVC)
+            set(PSM_TRACKER_SIMD_FLAGS "/arch:AVX2")
+        ELSE()
+            set(PSM_TRACKER_SIMD_FLAGS "-mavx2")
+        ENDIF()
+    ELSEIF(${PSM_TRACKER_SIMD} STREQUAL "SSE4")
+        IF(MSVC)
+            # MSVC has no SSE4.1 switch (or macro), the intrinsics are always available
+            set(PSM_TRACKER_SIMD_FLAGS "/DPSM_TRACKER_SIMD_SSE41")
+        ELSE()
+            set(PSM_TRACKER_SIMD_FLAGS "-msse4.1")
+        ENDIF()
+    ENDIF()
+ELSEIF(${CMAKE_SYSTEM_PROCESSOR} MATCHES "(arm|ARM|aarch64|AARCH64)")
+    # The NEON kernel hasn't been checked against cv::cvtColor (test_bgr_to_hsv) yet, so ARM builds use the plain C++ one unless asked
+    IF(${PSM_TRACKER_SIMD} STREQUAL "NEON")
+        set(PSM_TRACKER_SIMD_FLAGS "-DPSM_TRACKER_SIMD_NEON")
+    ENDIF()
+ENDIF()
+
 # Shared architecture label used for install folder locations
 if (${CMAKE_C_SIZEOF_DATA_PTR} EQUAL 8)
     set(BITNESS "64")
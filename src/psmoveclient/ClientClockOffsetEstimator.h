@@ -0,0 +1,120 @@
+#ifndef CLIENT_CLOCK_OFFSET_ESTIMATOR_H
+#define CLIENT_CLOCK_OFFSET_ESTIMATOR_H
+
+//-- includes -----
+#include <chrono>
+
+//-- definitions -----
+// -Client Clock Offset Estimator-
+// Estimates the offset between the service monotonic clock (see GET_SERVICE_TIME)
+// and the client monotonic clock from request round trips.
+// Each round trip gives the offset to within half of its duration, assuming the request
+// took as long to get to the service as the response took to get back.
+// The estimate comes from the shortest round trip of the last k_sample_window_size samples,
+// since it has the least room for queuing delay on either leg.
+class ClientClockOffsetEstimator
+{
+public:
+    static const int k_sample_window_size = 16;
+
+    ClientClockOffsetEstimator()
+    {
+        reset();
+    }
+
+    // The client monotonic clock in seconds
+    static double get_client_time_seconds()
+    {
+        const std::chrono::duration<double> time_since_epoch= std::chrono::steady_clock::now().time_since_epoch();
+
+        return time_since_epoch.count();
+    }
+
+    void reset()
+    {
+        m_sample_count= 0;
+        m_next_sample_index= 0;
+    }
+
+    // Adds one round trip.
+    // \param client_send_time Client clock time the request was sent
+    // \param service_time Service clock time the request was handled
+    // \param client_receive_time Client clock time the response arrived
+    // \return false if the round trip was rejected (negative duration)
+    bool add_sample(double client_send_time, double service_time, double client_receive_time)
+    {
+        const double round_trip_seconds= client_receive_time - client_send_time;
+
+        if (round_trip_seconds < 0.0)
+            return false;
+
+        Sample &sample= m_samples[m_next_sample_index];
+        sample.service_to_client_offset= (client_send_time + 0.5*round_trip_seconds) - service_time;
+        sample.round_trip_seconds= round_trip_seconds;
+
+        m_next_sample_index= (m_next_sample_index + 1) % k_sample_window_size;
+        if (m_sample_count < k_sample_window_size)
+        {
+            ++m_sample_count;
+        }
+
+        return true;
+    }
+
+    int get_sample_count() const
+    {
+        return m_sample_count;
+    }
+
+    bool get_has_estimate() const
+    {
+        return m_sample_count > 0;
+    }
+
+    // Add to a service clock time to get the client clock time (0 without an estimate)
+    double get_service_to_client_offset() const
+    {
+        const Sample *best_sample= get_best_sample();
+
+        return (best_sample != nullptr) ? best_sample->service_to_client_offset : 0.0;
+    }
+
+    // Duration of the round trip the estimate comes from.
+    // Half of it bounds the error of the estimate.
+    double get_round_trip_seconds() const
+    {
+        const Sample *best_sample= get_best_sample();
+
+        return (best_sample != nullptr) ? best_sample->round_trip_seconds : 0.0;
+    }
+
+private:
+    struct Sample
+    {
+        double service_to_client_offset;
+        double round_trip_seconds;
+    };
+
+    const Sample *get_best_sample() const
+    {
+        const Sample *best_sample= nullptr;
+
+        for (int sample_index= 0; sample_index < m_sample_count; ++sample_index)
+        {
+            const Sample &sample= m_samples[sample_index];
+
+            if (best_sample == nullptr || sample.round_trip_seconds < best_sample->round_trip_seconds)
+            {
+                best_sample= &sample;
+            }
+        }
+
+        return best_sample;
+    }
+
+    Sample m_samples[k_sample_window_size];
+    int m_sample_count;
+    int m_next_sample_index;
+};
+
+#endif // CLIENT_CLOCK_OFFSET_ESTIMATOR_H
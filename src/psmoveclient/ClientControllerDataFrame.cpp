@@ -0,0 +1,298 @@
+//-- includes -----
+#include "ClientControllerDataFrame.h"
+#include "ClientGeometry_CAPI.h"
+#include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
+#include <cstddef>
+#include <cstring>
+
+//-- public methods -----
+void applyPSMoveDataFrame(
+	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet,
+	PSMPSMove *psmove)
+{
+	const auto &psmove_packet= controller_packet.psmove_state();
+
+    psmove->bHasValidHardwareCalibration = psmove_packet.validhardwarecalibration();
+    psmove->bIsTrackingEnabled = psmove_packet.istrackingenabled();
+    psmove->bIsCurrentlyTracking = psmove_packet.iscurrentlytracking();
+	psmove->bIsOrientationValid = psmove_packet.isorientationvalid();
+	psmove->bIsPositionValid = psmove_packet.ispositionvalid();
+            
+    psmove->Pose.Orientation.w= psmove_packet.orientation().w();
+    psmove->Pose.Orientation.x= psmove_packet.orientation().x();
+    psmove->Pose.Orientation.y= psmove_packet.orientation().y();
+    psmove->Pose.Orientation.z= psmove_packet.orientation().z();
+
+    psmove->Pose.Position.x= psmove_packet.position_cm().x();
+    psmove->Pose.Position.y= psmove_packet.position_cm().y();
+    psmove->Pose.Position.z= psmove_packet.position_cm().z();
+            
+    if (psmove_packet.has_physics_data())
+    {
+        const auto &raw_physics_data = psmove_packet.physics_data();
+
+        psmove->PhysicsData.LinearVelocityCmPerSec.x = raw_physics_data.velocity_cm_per_sec().i();
+        psmove->PhysicsData.LinearVelocityCmPerSec.y = raw_physics_data.velocity_cm_per_sec().j();
+        psmove->PhysicsData.LinearVelocityCmPerSec.z = raw_physics_data.velocity_cm_per_sec().k();
+
+        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.x = raw_physics_data.acceleration_cm_per_sec_sqr().i();
+        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.y = raw_physics_data.acceleration_cm_per_sec_sqr().j();
+        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.z = raw_physics_data.acceleration_cm_per_sec_sqr().k();
+
+        psmove->PhysicsData.AngularVelocityRadPerSec.x = raw_physics_data.angular_velocity_rad_per_sec().i();
+        psmove->PhysicsData.AngularVelocityRadPerSec.y = raw_physics_data.angular_velocity_rad_per_sec().j();
+        psmove->PhysicsData.AngularVelocityRadPerSec.z = raw_physics_data.angular_velocity_rad_per_sec().k();
+
+        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.x = raw_physics_data.angular_acceleration_rad_per_sec_sqr().i();
+        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.y = raw_physics_data.angular_acceleration_rad_per_sec_sqr().j();
+        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.z = raw_physics_data.angular_acceleration_rad_per_sec_sqr().k();
+    }
+    else
+    {
+        memset(&psmove->PhysicsData, 0, sizeof(PSMPhysicsData));
+    }
+            
+    if (psmove_packet.has_raw_sensor_data())
+    {
+        const auto &raw_sensor_data = psmove_packet.raw_sensor_data();
+
+        psmove->RawSensorData.Magnetometer.x= raw_sensor_data.magnetometer().i();
+        psmove->RawSensorData.Magnetometer.y= raw_sensor_data.magnetometer().j();
+        psmove->RawSensorData.Magnetometer.z= raw_sensor_data.magnetometer().k();
+
+        psmove->RawSensorData.Accelerometer.x= raw_sensor_data.accelerometer().i();
+        psmove->RawSensorData.Accelerometer.y= raw_sensor_data.accelerometer().j();
+        psmove->RawSensorData.Accelerometer.z= raw_sensor_data.accelerometer().k();
+
+        psmove->RawSensorData.Gyroscope.x= raw_sensor_data.gyroscope().i();
+        psmove->RawSensorData.Gyroscope.y= raw_sensor_data.gyroscope().j();
+        psmove->RawSensorData.Gyroscope.z= raw_sensor_data.gyroscope().k();
+    }
+    else
+    {
+		memset(&psmove->RawSensorData, 0, sizeof(PSMPSMoveRawSensorData));
+	}
+
+	if (psmove_packet.has_calibrated_sensor_data())
+	{
+		const auto &calibrated_sensor_data = psmove_packet.calibrated_sensor_data();
+
+		psmove->CalibratedSensorData.Magnetometer.x = calibrated_sensor_data.magnetometer().i();
+		psmove->CalibratedSensorData.Magnetometer.y = calibrated_sensor_data.magnetometer().j();
+		psmove->CalibratedSensorData.Magnetometer.z = calibrated_sensor_data.magnetometer().k();
+
+		psmove->CalibratedSensorData.Accelerometer.x = calibrated_sensor_data.accelerometer().i();
+		psmove->CalibratedSensorData.Accelerometer.y = calibrated_sensor_data.accelerometer().j();
+		psmove->CalibratedSensorData.Accelerometer.z = calibrated_sensor_data.accelerometer().k();
+
+		psmove->CalibratedSensorData.Gyroscope.x = calibrated_sensor_data.gyroscope().i();
+		psmove->CalibratedSensorData.Gyroscope.y = calibrated_sensor_data.gyroscope().j();
+		psmove->CalibratedSensorData.Gyroscope.z = calibrated_sensor_data.gyroscope().k();
+	}
+	else
+	{
+		memset(&psmove->CalibratedSensorData, 0, sizeof(PSMPSMoveCalibratedSensorData));
+	}
+
+	if (psmove_packet.has_raw_tracker_data())
+	{
+		const auto &raw_tracker_data = psmove_packet.raw_tracker_data();
+
+		const PSMoveProtocol::Pixel &locationOnTracker = raw_tracker_data.screen_location();
+		const PSMoveProtocol::Position &positionOnTracker = raw_tracker_data.relative_position_cm();
+
+		psmove->RawTrackerData.TrackerID = raw_tracker_data.tracker_id();
+		psmove->RawTrackerData.ScreenLocation = { locationOnTracker.x(), locationOnTracker.y() };
+		psmove->RawTrackerData.RelativePositionCm = { positionOnTracker.x(), positionOnTracker.y(), positionOnTracker.z() };
+		psmove->RawTrackerData.RelativeOrientation = *k_psm_quaternion_identity;
+		psmove->RawTrackerData.ValidTrackerBitmask = raw_tracker_data.valid_tracker_bitmask();
+
+        if (raw_tracker_data.has_projected_sphere())
+		{
+			const PSMoveProtocol::Ellipse &protocolEllipse = raw_tracker_data.projected_sphere();
+			PSMTrackingProjection &projection = psmove->RawTrackerData.TrackingProjection;
+
+			projection.shape.ellipse.center.x = protocolEllipse.center().x();
+			projection.shape.ellipse.center.y = protocolEllipse.center().y();
+			projection.shape.ellipse.half_x_extent = protocolEllipse.half_x_extent();
+			projection.shape.ellipse.half_y_extent = protocolEllipse.half_y_extent();
+			projection.shape.ellipse.angle = protocolEllipse.angle();
+			projection.shape_type = PSMTrackingProjection::PSMShape_Ellipse;
+		}
+        else
+		{
+			PSMTrackingProjection &projection = psmove->RawTrackerData.TrackingProjection;
+
+			projection.shape_type = PSMTrackingProjection::PSMShape_INVALID_PROJECTION;
+		}
+
+
+		if (raw_tracker_data.has_multicam_position_cm())
+		{
+			const PSMoveProtocol::Position &multicam_position = raw_tracker_data.multicam_position_cm();
+
+			psmove->RawTrackerData.MulticamPositionCm.x = multicam_position.x();
+			psmove->RawTrackerData.MulticamPositionCm.y = multicam_position.y();
+			psmove->RawTrackerData.MulticamPositionCm.z = multicam_position.z();
+			psmove->RawTrackerData.bMulticamPositionValid = true;
+		}
+
+		// No optical orientation from sphere projection
+		psmove->RawTrackerData.bMulticamOrientationValid = false;
+		psmove->RawTrackerData.MulticamOrientation = *k_psm_quaternion_identity;
+	}
+	else
+	{
+		memset(&psmove->RawTrackerData, 0, sizeof(PSMRawTrackerData));
+	}
+
+	unsigned int button_bitmask = controller_packet.button_down_bitmask();
+	applyPSMButtonState(psmove->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
+	applyPSMButtonState(psmove->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+	applyPSMButtonState(psmove->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+	applyPSMButtonState(psmove->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
+	applyPSMButtonState(psmove->SelectButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SELECT);
+	applyPSMButtonState(psmove->StartButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_START);
+	applyPSMButtonState(psmove->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+	applyPSMButtonState(psmove->MoveButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_MOVE);
+	applyPSMButtonState(psmove->TriggerButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIGGER);
+
+	// Trigger value in range [0,255]
+	psmove->TriggerValue = static_cast<unsigned char>(psmove_packet.trigger_value());
+
+	// Battery level range [0, 5] - EE charging & EF full
+	psmove->BatteryValue = static_cast<PSMBatteryState>(psmove_packet.battery_value());
+}
+
+// The raw sections share the layout of the client structs, so they copy straight over
+static_assert(sizeof(RawPosef) == sizeof(PSMPosef) && offsetof(PSMPosef, Orientation) == offsetof(RawPosef, orientation),
+    "RawPosef must match PSMPosef");
+static_assert(offsetof(PSMPhysicsData, TimeInSeconds) >= sizeof(RawPhysicsDataSection),
+    "RawPhysicsDataSection must match the start of PSMPhysicsData");
+static_assert(offsetof(PSMPSMoveRawSensorData, TimeInSeconds) >= sizeof(RawPSMoveRawSensorSection),
+    "RawPSMoveRawSensorSection must match the start of PSMPSMoveRawSensorData");
+static_assert(offsetof(PSMPSMoveCalibratedSensorData, TimeInSeconds) >= sizeof(RawPSMoveCalibratedSensorSection),
+    "RawPSMoveCalibratedSensorSection must match the start of PSMPSMoveCalibratedSensorData");
+
+void applyRawPSMoveDataFrame(
+	const RawPSMoveDataFrame &raw_frame,
+	PSMPSMove *psmove)
+{
+    const unsigned int section_flags= raw_frame.header.section_flags;
+
+    psmove->bHasValidHardwareCalibration = (raw_frame.status_flags & RAW_DEVICE_STATUS_VALID_HARDWARE_CALIBRATION) != 0;
+    psmove->bIsTrackingEnabled = (raw_frame.status_flags & RAW_DEVICE_STATUS_TRACKING_ENABLED) != 0;
+    psmove->bIsCurrentlyTracking = (raw_frame.status_flags & RAW_DEVICE_STATUS_CURRENTLY_TRACKING) != 0;
+	psmove->bIsOrientationValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_ORIENTATION_VALID) != 0;
+	psmove->bIsPositionValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_POSITION_VALID) != 0;
+
+    memcpy(&psmove->Pose, &raw_frame.pose, sizeof(RawPosef));
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_PHYSICS) != 0)
+    {
+        memcpy(&psmove->PhysicsData, &raw_frame.physics_data, sizeof(RawPhysicsDataSection));
+    }
+    else
+    {
+        memset(&psmove->PhysicsData, 0, sizeof(PSMPhysicsData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_SENSOR) != 0)
+    {
+        memcpy(&psmove->RawSensorData, &raw_frame.raw_sensor_data, sizeof(RawPSMoveRawSensorSection));
+    }
+    else
+    {
+		memset(&psmove->RawSensorData, 0, sizeof(PSMPSMoveRawSensorData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR) != 0)
+    {
+        memcpy(&psmove->CalibratedSensorData, &raw_frame.calibrated_sensor_data, sizeof(RawPSMoveCalibratedSensorSection));
+    }
+    else
+    {
+		memset(&psmove->CalibratedSensorData, 0, sizeof(PSMPSMoveCalibratedSensorData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_TRACKER) != 0)
+    {
+        const RawTrackerDataSection &raw_tracker_data= raw_frame.raw_tracker_data;
+        PSMTrackingProjection &projection = psmove->RawTrackerData.TrackingProjection;
+
+		psmove->RawTrackerData.TrackerID = raw_tracker_data.tracker_id;
+		psmove->RawTrackerData.ScreenLocation = { raw_tracker_data.screen_location_x, raw_tracker_data.screen_location_y };
+		psmove->RawTrackerData.RelativePositionCm = { 
+            raw_tracker_data.relative_position_cm.x, raw_tracker_data.relative_position_cm.y, raw_tracker_data.relative_position_cm.z };
+		psmove->RawTrackerData.RelativeOrientation = *k_psm_quaternion_identity;
+		psmove->RawTrackerData.ValidTrackerBitmask = raw_tracker_data.valid_tracker_bitmask;
+
+        if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_PROJECTED_SPHERE_VALID) != 0)
+        {
+			projection.shape.ellipse.center.x = raw_tracker_data.projected_sphere_center_x;
+			projection.shape.ellipse.center.y = raw_tracker_data.projected_sphere_center_y;
+			projection.shape.ellipse.half_x_extent = raw_tracker_data.projected_sphere_half_x_extent;
+			projection.shape.ellipse.half_y_extent = raw_tracker_data.projected_sphere_half_y_extent;
+			projection.shape.ellipse.angle = raw_tracker_data.projected_sphere_angle;
+			projection.shape_type = PSMTrackingProjection::PSMShape_Ellipse;
+        }
+        else
+        {
+			projection.shape_type = PSMTrackingProjection::PSMShape_INVALID_PROJECTION;
+        }
+
+        if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_MULTICAM_POSITION_VALID) != 0)
+        {
+			psmove->RawTrackerData.MulticamPositionCm = { 
+                raw_tracker_data.multicam_position_cm.x, raw_tracker_data.multicam_position_cm.y, raw_tracker_data.multicam_position_cm.z };
+			psmove->RawTrackerData.bMulticamPositionValid = true;
+        }
+
+		// No optical orientation from sphere projection
+		psmove->RawTrackerData.bMulticamOrientationValid = false;
+		psmove->RawTrackerData.MulticamOrientation = *k_psm_quaternion_identity;
+    }
+    else
+    {
+		memset(&psmove->RawTrackerData, 0, sizeof(PSMRawTrackerData));
+    }
+
+	unsigned int button_bitmask = raw_frame.button_down_bitmask;
+	applyPSMButtonState(psmove->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
+	applyPSMButtonState(psmove->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+	applyPSMButtonState(psmove->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+	applyPSMButtonState(psmove->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
+	applyPSMButtonState(psmove->SelectButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SELECT);
+	applyPSMButtonState(psmove->StartButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_START);
+	applyPSMButtonState(psmove->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+	applyPSMButtonState(psmove->MoveButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_MOVE);
+	applyPSMButtonState(psmove->TriggerButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIGGER);
+
+	psmove->TriggerValue = raw_frame.trigger_value;
+	psmove->BatteryValue = static_cast<PSMBatteryState>(raw_frame.battery_value);
+}
+
+void applyPSMButtonState(
+    PSMButtonState &button,
+    unsigned int button_bitmask,
+    unsigned int button_bit)
+{
+    const bool is_down= (button_bitmask & (1 << button_bit)) > 0;
+
+    switch (button)
+    {
+    case PSMButtonState_UP:
+        button= is_down ? PSMButtonState_PRESSED : PSMButtonState_UP;
+        break;
+    case PSMButtonState_PRESSED:
+        button= is_down ? PSMButtonState_DOWN : PSMButtonState_RELEASED;
+        break;
+    case PSMButtonState_DOWN:
+        button= is_down ? PSMButtonState_DOWN : PSMButtonState_RELEASED;
+        break;
+    case PSMButtonState_RELEASED:
+        button= is_down ? PSMButtonState_PRESSED : PSMButtonState_UP;
+        break;
+    };
+}
@@ -0,0 +1,32 @@
+#ifndef CLIENT_CONTROLLER_DATA_FRAME_H
+#define CLIENT_CONTROLLER_DATA_FRAME_H
+
+//-- includes -----
+#include "PSMoveClient_CAPI.h"
+
+//-- pre-declarations -----
+struct RawPSMoveDataFrame;
+namespace PSMoveProtocol
+{
+    class DeviceOutputDataFrame_ControllerDataPacket;
+};
+
+//-- interface -----
+/// Copies the PSMove state of a protobuf controller data frame into the client controller state.
+void applyPSMoveDataFrame(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet,
+    PSMPSMove *psmove);
+
+/// Copies the PSMove state of a raw controller data frame into the client controller state.
+/// Sections missing from the frame's section_flags get zeroed, same as the protobuf path.
+void applyRawPSMoveDataFrame(
+    const RawPSMoveDataFrame &raw_frame,
+    PSMPSMove *psmove);
+
+/// Steps a button through UP -> PRESSED -> DOWN -> RELEASED given its bit in the button bitmask.
+void applyPSMButtonState(
+    PSMButtonState &button,
+    unsigned int button_bitmask,
+    unsigned int button_bit);
+
+#endif // CLIENT_CONTROLLER_DATA_FRAME_H
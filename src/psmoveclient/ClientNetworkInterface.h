@@ -3,6 +3,7 @@
 
 //-- includes -----
 #include "PSMoveClient_export.h"
+#include "PSMoveProtocolInterface.h"
 #include <boost/system/error_code.hpp>
 
 //-- interface -----
@@ -16,4 +17,13 @@ public:
 	virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) = 0;
 };
 
+// Called on the client network thread as soon as a data frame is decoded,
+// ahead of the IDataFrameListener call that gets deferred to the next update()
+class PSM_CPP_PRIVATE_CLASS IDataFrameSnapshotListener
+{
+public:
+	virtual void snapshot_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) = 0;
+	virtual void snapshot_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size) = 0;
+};
+
 #endif // CLIENT_NETWORK_INTERFACE_H
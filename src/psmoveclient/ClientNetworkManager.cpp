@@ -1,16 +1,25 @@
 //-- includes -----
 #include "ClientNetworkManager.h"
+#include "ClientClockOffsetEstimator.h"
 #include "ClientLog.h"
 #include "PackedMessage.h"
 #include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
 #include <cassert>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <deque>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/cstdint.hpp>
 
@@ -21,6 +30,19 @@ using asio::ip::tcp;
 using asio::ip::udp;
 using boost::uint8_t;
 
+//-- constants -----
+// Data frames held for the next update() when running the network thread.
+// The oldest ones get dropped when the application stops calling update().
+static const size_t k_max_deferred_data_frame_count = 1024;
+
+// Clock sync requests (GET_SERVICE_TIME) are sent and handled by the network manager itself,
+// under a request id the request manager never hands out
+static const int k_clock_sync_request_id = -2;
+
+// Quick round trips until the estimator window is full, then one a second to follow clock drift
+static const int k_clock_sync_initial_interval_ms = 50;
+static const int k_clock_sync_interval_ms = 1000;
+
 //-- implementation -----
 
 // -ClientNetworkManagerImpl-
@@ -34,11 +56,15 @@ public:
         IDataFrameListener *dataFrameListener,
         INotificationListener *notificationListener,
         IResponseListener *responseListener,
-        IClientNetworkEventListener *netEventListener)
+        IClientNetworkEventListener *netEventListener,
+        bool useNetworkThread,
+        IDataFrameSnapshotListener *dataFrameSnapshotListener)
         : m_server_host(host)
         , m_server_port(port)
 
         , m_io_service()
+        , m_activity_timer(m_io_service)
+        , m_clock_sync_timer(m_io_service)
         , m_tcp_socket(m_io_service)
         , m_tcp_connection_id(-1)
         , m_udp_socket(m_io_service, udp::endpoint(udp::v4(), 0))
@@ -56,17 +82,42 @@ public:
         , m_packed_output_data_frame(std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame>(new PSMoveProtocol::DeviceOutputDataFrame()))
     
         , m_write_bufer()
-        , m_packed_request()
+        , m_written_request_count(0)
 
         , m_data_frame_listener(dataFrameListener)
         , m_notification_listener(notificationListener)
         , m_response_listener(responseListener)
         , m_netEventListener(netEventListener)
         , m_pending_requests()
+
+        , m_use_network_thread(useNetworkThread)
+        , m_data_frame_snapshot_listener(dataFrameSnapshotListener)
+        , m_network_thread()
+        , m_network_thread_work()
+        , m_deferred_call_mutex()
+        , m_deferred_call_condition()
+        , m_deferred_listener_calls()
+        , m_deferred_data_frames()
+
+        , m_clock_offset_estimator()
+        , m_clock_sync_send_time(0.0)
+        , m_has_pending_clock_sync(false)
+        , m_has_clock_offset(false)
+        , m_service_to_client_clock_offset(0.0)
     {
         memset(m_output_data_frame_buffer, 0, sizeof(m_output_data_frame_buffer));
     }
 
+    virtual ~ClientNetworkManagerImpl()
+    {
+        // In case shutdown() was never called
+        if (m_network_thread.joinable())
+        {
+            m_io_service.stop();
+            m_network_thread.join();
+        }
+    }
+
     bool start()
     {
         tcp::resolver resolver(m_io_service);
@@ -75,26 +126,48 @@ public:
         m_connection_stopped= false;
         bool success= start_tcp_connect(endpoint_iter);
 
+        if (success && m_use_network_thread)
+        {
+            start_network_thread();
+        }
+
         return success;
     }
 
     void send_request(RequestPtr request)
     {
-        m_pending_requests.push_back(request);
-        start_tcp_write_request();
+        if (m_use_network_thread)
+        {
+            // The sockets and the send queues belong to the network thread
+            m_io_service.post(boost::bind(&ClientNetworkManagerImpl::queue_request, this, request));
+        }
+        else
+        {
+            queue_request(request);
+        }
     }
 
     void send_device_data_frame(DeviceInputDataFramePtr data_frame)
     {
-        // Stamp the packet with the connection ID before it goes out
-        data_frame->set_connection_id(m_tcp_connection_id);
-
-        m_pending_data_frames.push_back(data_frame);
-        start_udp_queued_data_frame_write();
+        if (m_use_network_thread)
+        {
+            m_io_service.post(boost::bind(&ClientNetworkManagerImpl::queue_device_data_frame, this, data_frame));
+        }
+        else
+        {
+            queue_device_data_frame(data_frame);
+        }
     }
 
     void poll()
     {
+        if (m_use_network_thread)
+        {
+            // The network thread already did the I/O, just hand over what it received
+            dispatch_deferred_calls();
+            return;
+        }
+
         bool keep_polling = true;
         int iteration_count = 0;
         const static int k_max_iteration_count = 32;
@@ -120,14 +193,92 @@ public:
 
     }
 
+    void wait_for_activity(int timeout_ms)
+    {
+        if (timeout_ms <= 0)
+        {
+            return;
+        }
+
+        if (m_use_network_thread)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_deferred_call_mutex);
+
+                m_deferred_call_condition.wait_for(
+                    lock,
+                    std::chrono::milliseconds(timeout_ms),
+                    [this]() { return !m_deferred_listener_calls.empty() || !m_deferred_data_frames.empty(); });
+            }
+
+            dispatch_deferred_calls();
+            return;
+        }
+
+        // The timer bounds the wait in case nothing comes in
+        m_activity_timer.expires_from_now(std::chrono::milliseconds(timeout_ms));
+        m_activity_timer.async_wait(
+            boost::bind(&ClientNetworkManagerImpl::handle_activity_timeout, this, asio::placeholders::error));
+
+        // Sleeps until the first handler is ready to run and then runs it:
+        // either a network handler (i.e. a response was just received and dispatched) or the timer.
+        if (m_io_service.stopped())
+        {
+            m_io_service.reset();
+        }
+        m_io_service.run_one();
+
+        // Flush the cancelled timer handler so that it can't cut the next wait short.
+        // This also runs anything else that became ready in the meantime.
+        m_activity_timer.cancel();
+        m_io_service.poll();
+    }
+
+    void handle_activity_timeout(const boost::system::error_code& error)
+    {
+        // Nothing to do: the timer only exists to wake up wait_for_activity()
+    }
+
+    bool get_service_to_client_clock_offset(double &out_offset) const
+    {
+        // The flag is only raised after the offset it covers was stored
+        if (m_has_clock_offset.load(std::memory_order_acquire))
+        {
+            out_offset= m_service_to_client_clock_offset.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    void shutdown()
+    {
+        if (m_network_thread.joinable())
+        {
+            // Close the connection on the network thread and then let it exit
+            m_io_service.post(boost::bind(&ClientNetworkManagerImpl::stop_network_thread, this));
+            m_network_thread.join();
+            m_network_thread_work.reset();
+
+            // Deliver the request cancellations and the connection closed event
+            dispatch_deferred_calls();
+        }
+        else
+        {
+            stop();
+        }
+    }
+
     void stop()
     {
         // drain any pending requests
         while (m_pending_requests.size() > 0)
         {
-            if (m_response_listener)
+            // Clock sync requests never went through the request manager
+            if (m_response_listener && m_pending_requests.front()->request_id() != k_clock_sync_request_id)
             {
-                m_response_listener->handle_request_canceled(m_pending_requests.front());
+                dispatch_to_listener(
+                    boost::bind(&IResponseListener::handle_request_canceled, m_response_listener, m_pending_requests.front()));
             }
 
             m_pending_requests.pop_front();
@@ -153,26 +304,143 @@ public:
 
                 if (m_netEventListener)
                 {
-                    m_netEventListener->handle_server_connection_close_failed(close_error);
+                    dispatch_to_listener(
+                        boost::bind(&IClientNetworkEventListener::handle_server_connection_close_failed, m_netEventListener, close_error));
                 }
             }
             else
             {
                 if (m_netEventListener)
                 {
-                    m_netEventListener->handle_server_connection_closed();
+                    dispatch_to_listener(
+                        boost::bind(&IClientNetworkEventListener::handle_server_connection_closed, m_netEventListener));
                 }
             }
         }
 
+        // The next connection could be to another service (clock)
+        m_clock_sync_timer.cancel();
+        m_clock_offset_estimator.reset();
+        m_has_pending_clock_sync= false;
+        m_has_clock_offset.store(false, std::memory_order_release);
+
         m_connection_stopped= true;
         m_has_pending_tcp_read= false;
         m_has_pending_tcp_write= false;
+        m_written_request_count= 0;
         m_has_pending_udp_read = false;
         m_has_pending_udp_write = false;
     }
 
 private:
+    void start_network_thread()
+    {
+        if (m_io_service.stopped())
+        {
+            m_io_service.reset();
+        }
+
+        // Keeps run() going while there's nothing in flight (i.e. before the first request)
+        m_network_thread_work.reset(new asio::io_service::work(m_io_service));
+        m_network_thread = std::thread(&ClientNetworkManagerImpl::network_thread_func, this);
+    }
+
+    void network_thread_func()
+    {
+        // Runs every socket handler until stop_network_thread()
+        m_io_service.run();
+    }
+
+    void stop_network_thread()
+    {
+        stop();
+
+        // The UDP socket still has a read in flight, so don't wait for run() to run out of work
+        m_io_service.stop();
+    }
+
+    // Calls into the listeners are made on the thread that calls update(),
+    // so with the network thread they get queued until then.
+    void dispatch_to_listener(const boost::function<void()> &listener_call)
+    {
+        if (m_use_network_thread)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_deferred_call_mutex);
+                m_deferred_listener_calls.push_back(listener_call);
+            }
+
+            m_deferred_call_condition.notify_one();
+        }
+        else
+        {
+            listener_call();
+        }
+    }
+
+    void defer_data_frame(const boost::function<void()> &data_frame_call)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_deferred_call_mutex);
+
+            if (m_deferred_data_frames.size() >= k_max_deferred_data_frame_count)
+            {
+                m_deferred_data_frames.pop_front();
+            }
+
+            m_deferred_data_frames.push_back(data_frame_call);
+        }
+
+        m_deferred_call_condition.notify_one();
+    }
+
+    void dispatch_deferred_calls()
+    {
+        std::deque< boost::function<void()> > data_frames;
+        std::deque< boost::function<void()> > listener_calls;
+
+        {
+            std::lock_guard<std::mutex> lock(m_deferred_call_mutex);
+            data_frames.swap(m_deferred_data_frames);
+            listener_calls.swap(m_deferred_listener_calls);
+        }
+
+        for (const boost::function<void()> &data_frame_call : data_frames)
+        {
+            data_frame_call();
+        }
+
+        for (const boost::function<void()> &listener_call : listener_calls)
+        {
+            listener_call();
+        }
+    }
+
+    void dispatch_data_frame(DeviceOutputDataFramePtr data_frame)
+    {
+        m_data_frame_listener->handle_data_frame(data_frame.get());
+    }
+
+    void dispatch_raw_data_frame(std::shared_ptr< std::vector<uint8_t> > data_frame)
+    {
+        m_data_frame_listener->handle_raw_data_frame(data_frame->data(), data_frame->size());
+    }
+
+    void queue_request(RequestPtr request)
+    {
+        m_pending_requests.push_back(request);
+        start_tcp_write_request();
+    }
+
+    void queue_device_data_frame(DeviceInputDataFramePtr data_frame)
+    {
+        // Stamp the packet with the connection ID before it goes out
+        data_frame->set_connection_id(m_tcp_connection_id);
+
+        m_pending_data_frames.push_back(data_frame);
+        start_udp_queued_data_frame_write();
+    }
+
     bool start_tcp_connect(tcp::resolver::iterator endpoint_iter)
     {
         bool success= true;
@@ -194,7 +462,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_open_failed(boost::asio::error::host_unreachable);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_open_failed, m_netEventListener, boost::system::error_code(boost::asio::error::host_unreachable)));
             }
         }
 
@@ -217,7 +486,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_open_failed(boost::asio::error::timed_out);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_open_failed, m_netEventListener, boost::system::error_code(boost::asio::error::timed_out)));
             }
 
             // Try the next available endpoint.
@@ -230,7 +500,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_open_failed(ec);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_open_failed, m_netEventListener, ec));
             }
 
             // We need to close the socket used in the previous connection attempt
@@ -269,6 +540,66 @@ private:
         // Send the connection id back to the server over UDP
         // to establish a UDP connected and associate it with the TCP connection
         send_udp_connection_id();
+
+        // Start estimating the service clock offset so data frame time stamps can be converted
+        send_clock_sync_request();
+    }
+
+    void send_clock_sync_request()
+    {
+        if (m_connection_stopped || m_has_pending_clock_sync)
+            return;
+
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_GET_SERVICE_TIME);
+        request->set_request_id(k_clock_sync_request_id);
+
+        // The send time gets stamped once the request actually goes out (see start_tcp_write_request)
+        m_has_pending_clock_sync= true;
+        queue_request(request);
+    }
+
+    void start_clock_sync_timer()
+    {
+        const int interval_ms=
+            (m_clock_offset_estimator.get_sample_count() < ClientClockOffsetEstimator::k_sample_window_size)
+            ? k_clock_sync_initial_interval_ms
+            : k_clock_sync_interval_ms;
+
+        m_clock_sync_timer.expires_from_now(std::chrono::milliseconds(interval_ms));
+        m_clock_sync_timer.async_wait(
+            boost::bind(&ClientNetworkManagerImpl::handle_clock_sync_timer, this, asio::placeholders::error));
+    }
+
+    void handle_clock_sync_timer(const boost::system::error_code& error)
+    {
+        if (!error)
+        {
+            send_clock_sync_request();
+        }
+    }
+
+    void handle_clock_sync_response(ResponsePtr response, double client_receive_time)
+    {
+        m_has_pending_clock_sync= false;
+
+        if (response->type() != PSMoveProtocol::Response_ResponseType_SERVICE_TIME ||
+            response->result_code() != PSMoveProtocol::Response_ResultCode_RESULT_OK)
+        {
+            CLIENT_LOG_WARNING("ClientNetworkManager::handle_clock_sync_response") 
+                << "Service didn't report its time. Data frame time stamps won't be available." << std::endl;
+            return;
+        }
+
+        m_clock_offset_estimator.add_sample(
+            m_clock_sync_send_time,
+            response->result_service_time().service_time_seconds(),
+            client_receive_time);
+
+        m_service_to_client_clock_offset.store(m_clock_offset_estimator.get_service_to_client_offset(), std::memory_order_relaxed);
+        m_has_clock_offset.store(m_clock_offset_estimator.get_has_estimate(), std::memory_order_release);
+
+        start_clock_sync_timer();
     }
 
     void send_udp_connection_id()
@@ -338,7 +669,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_open_failed(error);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_open_failed, m_netEventListener, error));
             }
         }
         else if (m_udp_connection_result_read_buffer == false)
@@ -348,7 +680,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_open_failed(boost::system::error_code());
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_open_failed, m_netEventListener, boost::system::error_code()));
             }
         }
         else
@@ -365,7 +698,8 @@ private:
             // Tell the network event listener that we are finally all connected
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_opened();
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_opened, m_netEventListener));
             }
         }
     }
@@ -417,7 +751,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_socket_error(error);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, error));
             }
         }
     }
@@ -465,7 +800,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_socket_error(error);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, error));
             }
         }
     }
@@ -474,6 +810,9 @@ private:
     // Parse the response and forward it on to the response handler.
     void handle_tcp_response_received()
     {
+        // Taken before parsing, as close as we get to the arrival time
+        const double receive_time= ClientClockOffsetEstimator::get_client_time_seconds();
+
         // No longer is there a pending read
         m_has_pending_tcp_read= false;
 
@@ -482,11 +821,17 @@ private:
         {
             ResponsePtr response = m_packed_response.get_msg();
 
-            if (response->request_id() != -1)
+            if (response->request_id() == k_clock_sync_request_id)
+            {
+                // SPECIAL CASE: Clock sync responses stay in the network manager
+                handle_clock_sync_response(response, receive_time);
+            }
+            else if (response->request_id() != -1)
             {
                 CLIENT_LOG_INFO("ClientNetworkManager::handle_tcp_response_received") 
                     << "Received response type " << response->type() << std::endl;
-                m_response_listener->handle_response(response);
+                dispatch_to_listener(
+                    boost::bind(&IResponseListener::handle_response, m_response_listener, response));
             }
             else
             {
@@ -501,7 +846,8 @@ private:
                 else
                 {
                     // Responses without a request ID are notifications
-                    m_notification_listener->handle_notification(response);
+                    dispatch_to_listener(
+                        boost::bind(&INotificationListener::handle_notification, m_notification_listener, response));
                 }
             }
         }
@@ -514,7 +860,8 @@ private:
             if (m_netEventListener)
             {
                 //###bwalker $TODO pick a better error code that means "malformed data"
-                m_netEventListener->handle_server_connection_socket_error(boost::asio::error::message_size);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, boost::system::error_code(boost::asio::error::message_size)));
             }
         }
     }
@@ -526,12 +873,24 @@ private:
 
         if (m_pending_requests.size() > 0 && !m_has_pending_tcp_write)
         {
-            RequestPtr request= m_pending_requests[0];
+            // Everything queued up so far goes out in a single write
+            m_write_bufer.clear();
+            for (const RequestPtr &request : m_pending_requests)
+            {
+                const int msg_size= request->ByteSize();
+                const size_t msg_offset= m_write_bufer.size();
 
-            m_packed_request.set_msg(request);
-            m_packed_request.pack(m_write_bufer);
+                m_write_bufer.resize(msg_offset + HEADER_SIZE + msg_size);
+                PackedMessage<PSMoveProtocol::Request>::pack_exact(*request, &m_write_bufer[msg_offset], msg_size);
 
-            // The queue should prevent us from writing more than one request as once
+                if (request->request_id() == k_clock_sync_request_id)
+                {
+                    m_clock_sync_send_time= ClientClockOffsetEstimator::get_client_time_seconds();
+                }
+            }
+            m_written_request_count= m_pending_requests.size();
+
+            // The queue should prevent us from having more than one write in flight
             m_has_pending_tcp_write= true;
 
             // Start an asynchronous operation to send a heartbeat message.
@@ -552,8 +911,9 @@ private:
             // no longer is there a pending write
             m_has_pending_tcp_write= false;
 
-            // Remove the request from the pending send queue not that it's sent
-            m_pending_requests.pop_front();
+            // Remove the requests from the pending send queue now that they're sent
+            m_pending_requests.erase(m_pending_requests.begin(), m_pending_requests.begin() + m_written_request_count);
+            m_written_request_count= 0;
             
             // Start listening for the response
             start_tcp_read_response_header();
@@ -569,7 +929,8 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_socket_error(ec);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, ec));
             }
         }
     }
@@ -629,6 +990,12 @@ private:
 
             // Remove the dataframe from the pending send queue now that it's sent
             m_pending_data_frames.pop_front();
+
+            // Nobody polls the network thread, so keep the queue moving from here
+            if (m_use_network_thread)
+            {
+                start_udp_queued_data_frame_write();
+            }
         }
         else
         {
@@ -648,11 +1015,12 @@ private:
                 boost::bind(
                     &ClientNetworkManagerImpl::handle_udp_read_data_frame, 
                     this,
-                    asio::placeholders::error));
+                    asio::placeholders::error,
+                    asio::placeholders::bytes_transferred));
         }
     }
 
-    void handle_udp_read_data_frame(const boost::system::error_code& error)
+    void handle_udp_read_data_frame(const boost::system::error_code& error, std::size_t bytes_transferred)
     {
         if (m_connection_stopped)
             return;
@@ -662,7 +1030,7 @@ private:
             CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_read_data_frame") << "Received DataFrame" << std::endl;
 
             // Process the data frame now that we have received all of it
-            handle_udp_data_frame_received();
+            handle_udp_data_frame_received(bytes_transferred);
 
             // Start reading the next incoming data frame
             start_udp_read_data_frame();
@@ -675,18 +1043,26 @@ private:
 
             if (m_netEventListener)
             {
-                m_netEventListener->handle_server_connection_socket_error(error);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, error));
             }
         }
     }
 
     // Called when enough data was read into m_data_frame_read_buffer for a complete data frame message. 
     // Parse the data_frame and forward it on to the response handler.
-    void handle_udp_data_frame_received()
+    void handle_udp_data_frame_received(std::size_t bytes_transferred)
     {
         // No longer is there a pending read
         m_has_pending_udp_read= false;
 
+        // Streams that asked for the raw format get fixed-layout data frames instead of protobuf
+        if (is_raw_data_frame(m_output_data_frame_buffer, bytes_transferred))
+        {
+            handle_udp_raw_data_frame_received(bytes_transferred);
+            return;
+        }
+
         CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_data_frame_received") << "Parsing DataFrame" << std::endl;
         
         // TODO: Switch on data frame type to choose which m_packed_data_frame_X to use.
@@ -698,9 +1074,25 @@ private:
         // Parse the response buffer
         if (m_packed_output_data_frame.unpack(m_output_data_frame_buffer, total_len))
         {
-            const PSMoveProtocol::DeviceOutputDataFrame *data_frame = m_packed_output_data_frame.get_msg().get();
+            if (m_use_network_thread)
+            {
+                DeviceOutputDataFramePtr data_frame = m_packed_output_data_frame.get_msg();
 
-            m_data_frame_listener->handle_data_frame(data_frame);
+                if (m_data_frame_snapshot_listener)
+                {
+                    m_data_frame_snapshot_listener->snapshot_data_frame(data_frame.get());
+                }
+
+                // Hand the decoded message over to update() and decode the next one into a fresh message
+                m_packed_output_data_frame.set_msg(DeviceOutputDataFramePtr(new PSMoveProtocol::DeviceOutputDataFrame()));
+                defer_data_frame(boost::bind(&ClientNetworkManagerImpl::dispatch_data_frame, this, data_frame));
+            }
+            else
+            {
+                const PSMoveProtocol::DeviceOutputDataFrame *data_frame = m_packed_output_data_frame.get_msg().get();
+
+                m_data_frame_listener->handle_data_frame(data_frame);
+            }
         }
         else
         {
@@ -710,9 +1102,42 @@ private:
             if (m_netEventListener)
             {
                 //###HipsterSloth $TODO pick a better error code that means "malformed data"
-                m_netEventListener->handle_server_connection_socket_error(boost::asio::error::message_size);
+                dispatch_to_listener(
+                    boost::bind(&IClientNetworkEventListener::handle_server_connection_socket_error, m_netEventListener, boost::system::error_code(boost::asio::error::message_size)));
+            }
+        }
+    }
+
+    void handle_udp_raw_data_frame_received(std::size_t bytes_transferred)
+    {
+        RawDataFrameHeader header;
+
+        if (decode_raw_data_frame_header(m_output_data_frame_buffer, bytes_transferred, header))
+        {
+            if (m_use_network_thread)
+            {
+                if (m_data_frame_snapshot_listener)
+                {
+                    m_data_frame_snapshot_listener->snapshot_raw_data_frame(m_output_data_frame_buffer, header.frame_size);
+                }
+
+                // The receive buffer gets reused by the next read
+                std::shared_ptr< std::vector<uint8_t> > data_frame(
+                    new std::vector<uint8_t>(m_output_data_frame_buffer, m_output_data_frame_buffer + header.frame_size));
+                defer_data_frame(boost::bind(&ClientNetworkManagerImpl::dispatch_raw_data_frame, this, data_frame));
+            }
+            else
+            {
+                m_data_frame_listener->handle_raw_data_frame(m_output_data_frame_buffer, header.frame_size);
             }
         }
+        else
+        {
+            // Most likely a service built with another raw layout version.
+            // Not fatal, the stream can be restarted in the protobuf format.
+            CLIENT_LOG_WARNING("ClientNetworkManager::handle_udp_raw_data_frame_received") 
+                << "Dropping raw data frame with unexpected version or size (" << bytes_transferred << " bytes)" << std::endl;
+        }
     }
 
 private:
@@ -720,6 +1145,8 @@ private:
     std::string m_server_port;
 
     asio::io_service m_io_service;
+    asio::steady_timer m_activity_timer;
+    asio::steady_timer m_clock_sync_timer;
     tcp::socket m_tcp_socket;
     int m_tcp_connection_id;
 
@@ -744,7 +1171,7 @@ private:
     PackedMessage<PSMoveProtocol::DeviceInputDataFrame> m_packed_input_data_frame;
     
     vector<uint8_t> m_write_bufer;
-    PackedMessage<PSMoveProtocol::Request> m_packed_request;
+    size_t m_written_request_count; // front of m_pending_requests covered by the write in flight
 
     IDataFrameListener *m_data_frame_listener;
     INotificationListener *m_notification_listener;
@@ -753,6 +1180,27 @@ private:
 
     deque<RequestPtr> m_pending_requests;
     deque<DeviceInputDataFramePtr> m_pending_data_frames;
+
+    // Network thread (the socket handlers above run on it when enabled)
+    bool m_use_network_thread;
+    IDataFrameSnapshotListener *m_data_frame_snapshot_listener;
+    std::thread m_network_thread;
+    std::unique_ptr<asio::io_service::work> m_network_thread_work;
+
+    // Listener calls made on the network thread, waiting for the next update()
+    std::mutex m_deferred_call_mutex;
+    std::condition_variable m_deferred_call_condition;
+    deque< boost::function<void()> > m_deferred_listener_calls;
+    deque< boost::function<void()> > m_deferred_data_frames;
+
+    // Clock sync state, only touched by the thread doing the I/O
+    ClientClockOffsetEstimator m_clock_offset_estimator;
+    double m_clock_sync_send_time;
+    bool m_has_pending_clock_sync;
+
+    // Latest service clock offset estimate, readable from any thread
+    std::atomic<bool> m_has_clock_offset;
+    std::atomic<double> m_service_to_client_clock_offset;
 };
 
 // -ClientNetworkManager-
@@ -765,7 +1213,9 @@ ClientNetworkManager::ClientNetworkManager(
     IDataFrameListener *dataFrameListener,
     INotificationListener *notificationListener,
     IResponseListener *responseListener,
-    IClientNetworkEventListener *netEventListener)
+    IClientNetworkEventListener *netEventListener,
+    bool useNetworkThread,
+    IDataFrameSnapshotListener *dataFrameSnapshotListener)
     : m_implementation_ptr(
         new ClientNetworkManagerImpl(
             host, 
@@ -773,7 +1223,9 @@ ClientNetworkManager::ClientNetworkManager(
             dataFrameListener,
             notificationListener,
             responseListener,
-            netEventListener))
+            netEventListener,
+            useNetworkThread,
+            dataFrameSnapshotListener))
 {
 }
 
@@ -805,8 +1257,18 @@ void ClientNetworkManager::update()
     m_implementation_ptr->poll();
 }
 
+void ClientNetworkManager::wait_for_activity(int timeout_ms)
+{
+    m_implementation_ptr->wait_for_activity(timeout_ms);
+}
+
 void ClientNetworkManager::shutdown()
 {
-    m_implementation_ptr->stop();
+    m_implementation_ptr->shutdown();
     m_instance = NULL;
 }
+
+bool ClientNetworkManager::get_service_to_client_clock_offset(double &out_offset) const
+{
+    return m_implementation_ptr->get_service_to_client_clock_offset(out_offset);
+}
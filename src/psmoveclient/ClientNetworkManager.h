@@ -10,6 +10,9 @@
 // -Server Network Manager-
 // Maintains TCP/UDP connection state with PSMoveService.
 // Routes requests to the given request handler.
+// With useNetworkThread the sockets are serviced on a thread of their own.
+// The listeners are still only called from update() (and wait_for_activity()),
+// except for the data frame snapshot listener, which gets every data frame on the network thread.
 class PSM_CPP_PRIVATE_CLASS ClientNetworkManager 
 {
 public:
@@ -18,7 +21,9 @@ public:
         IDataFrameListener *dataFrameListener,
         INotificationListener *notificationListener,
         IResponseListener *responseListener,
-        IClientNetworkEventListener *netEventListener);
+        IClientNetworkEventListener *netEventListener,
+        bool useNetworkThread,
+        IDataFrameSnapshotListener *dataFrameSnapshotListener);
     virtual ~ClientNetworkManager();
 
     static ClientNetworkManager *get_instance() { return m_instance; }
@@ -27,8 +32,15 @@ public:
     void send_request(RequestPtr request);
     void send_device_data_frame(DeviceInputDataFramePtr data_frame);
     void update();
+    // Blocks until the network layer handled some I/O (i.e. received a response) or the timeout elapsed
+    void wait_for_activity(int timeout_ms);
     void shutdown();
 
+    // Offset to add to a service clock time (i.e. a data frame time stamp) to get the client clock time
+    // (see ClientClockOffsetEstimator). Returns false until the first clock sync round trip completes.
+    // Can be called from any thread.
+    bool get_service_to_client_clock_offset(double &out_offset) const;
+
 private:
     // Must use the overloaded constructor
     ClientNetworkManager();
@@ -29,6 +29,7 @@ public:
         , m_callback(callback)
         , m_callback_userdata(userdata)
         , m_pending_requests()
+        , m_queued_requests()
         , m_next_request_id(0)
     {
     }
@@ -56,12 +57,53 @@ public:
         assert(m_pending_requests.find(request->request_id()) == m_pending_requests.end());
         m_pending_requests.insert(t_id_request_context_pair(request->request_id(), context));
 
-        // Send the request off to the network manager to get sent to the server
-        ClientNetworkManager::get_instance()->send_request(request);
+        // Held back until the next flush so that everything sent in one update goes out together
+        m_queued_requests.push_back(request);
+    }
+
+    void flush_requests()
+    {
+        if (m_queued_requests.size() == 1)
+        {
+            // Send the request off to the network manager to get sent to the server
+            ClientNetworkManager::get_instance()->send_request(m_queued_requests[0]);
+        }
+        else if (m_queued_requests.size() > 1)
+        {
+            // One message (and one response) for the whole lot.
+            // The batch isn't tracked as a pending request, only its sub-requests are.
+            RequestPtr batch_request(new PSMoveProtocol::Request);
+            PSMoveProtocol::Request_RequestBatch *batch= batch_request->mutable_request_batch();
+
+            batch_request->set_type(PSMoveProtocol::Request_RequestType_BATCH);
+            batch_request->set_request_id(m_next_request_id);
+            ++m_next_request_id;
+
+            for (RequestPtr &request : m_queued_requests)
+            {
+                // Copied since the original stays referenced by the response message
+                batch->add_requests()->CopyFrom(*request);
+            }
+
+            ClientNetworkManager::get_instance()->send_request(batch_request);
+        }
+
+        m_queued_requests.clear();
     }
 
     void handle_request_canceled(RequestPtr request)
     {
+        if (request->type() == PSMoveProtocol::Request_RequestType_BATCH)
+        {
+            // Cancel each of the batched requests instead
+            for (int request_index = 0; request_index < request->request_batch().requests_size(); ++request_index)
+            {
+                handle_request_canceled(RequestPtr(request, request->mutable_request_batch()->mutable_requests(request_index)));
+            }
+
+            return;
+        }
+
         // Create a general canceled result
         ResponsePtr response(new PSMoveProtocol::Response);
 
@@ -74,6 +116,17 @@ public:
 
     void handle_response(ResponsePtr response)
     {
+        if (response->type() == PSMoveProtocol::Response_ResponseType_BATCH_RESULT)
+        {
+            // Handle each sub-response as if it had arrived on its own
+            for (int response_index = 0; response_index < response->result_batch().responses_size(); ++response_index)
+            {
+                handle_response(ResponsePtr(response, response->mutable_result_batch()->mutable_responses(response_index)));
+            }
+
+            return;
+        }
+
         // Get the request awaiting completion
         t_request_context_map_iterator pending_request_entry= m_pending_requests.find(response->request_id());
         assert(pending_request_entry != m_pending_requests.end());
@@ -398,6 +451,7 @@ private:
     PSMResponseCallback m_callback;
     void *m_callback_userdata;
     t_request_context_map m_pending_requests;
+    t_request_reference_cache m_queued_requests;
     int m_next_request_id;
 
     // These vectors is used solely to keep the ref counted pointers to the 
@@ -432,6 +486,11 @@ void ClientRequestManager::send_request(
     m_implementation_ptr->send_request(request);
 }
 
+void ClientRequestManager::flush_requests()
+{
+    m_implementation_ptr->flush_requests();
+}
+
 void ClientRequestManager::handle_request_canceled(RequestPtr request)
 {
     m_implementation_ptr->handle_request_canceled(request);
@@ -14,7 +14,11 @@ public:
                          void *userdata);
     virtual ~ClientRequestManager();
 
+    // Queues the request until the next flush_requests()
     void send_request(RequestPtr request);
+    // Sends everything queued since the last flush in a single message
+    // (a BATCH request when there is more than one)
+    void flush_requests();
 
     virtual void handle_request_canceled(RequestPtr request) override;
     virtual void handle_response(ResponsePtr response) override;
@@ -1,13 +1,16 @@
 //-- includes -----
 #include "PSMoveClient.h"
+#include "ClientControllerDataFrame.h"
 #include "ClientRequestManager.h"
 #include "ClientNetworkManager.h"
 #include "ClientLog.h"
 #include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
+#include "SharedPoseState.h"
 #include "SharedTrackerState.h"
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/asio/ip/address.hpp>
 #include <algorithm>
 #include <iostream>
 #include <thread>
@@ -26,20 +29,43 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 #define IS_VALID_TRACKER_INDEX(x) ((x) >= 0 && (x) < PSMOVESERVICE_MAX_TRACKER_COUNT)
 #define IS_VALID_HMD_INDEX(x) ((x) >= 0 && (x) < PSMOVESERVICE_MAX_HMD_COUNT)
 
+// -- definitions -----
+// Data frame time stamps converted to the client clock, -1 when unknown
+struct ClientDataFrameTimes
+{
+    double sample_time_seconds; // IMU sample behind the data frame
+    double pose_time_seconds;   // Time the pose and physics describe
+};
+
 // -- prototypes -----
 static void processPSMoveRecenterAction(PSMController *controller);
 static void processDualShock4RecenterAction(PSMController *controller);
 
-static void applyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMController *controller);
-static void applyPSMoveDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMPSMove *psmove);
+static bool applyControllerDataFrameHeader(int controller_id, PSMControllerType controller_type, int sequence_num, bool is_connected, PSMController *controller);
+template <typename t_raw_data_frame>
+static bool getRawDataFrame(const uint8_t *data_frame, size_t data_frame_size, t_raw_data_frame &out_raw_frame);
+static void applyRawControllerDataFrame(const RawPSMoveDataFrame &raw_frame, const ClientDataFrameTimes &times, PSMController *controller);
+static void applyRawControllerDataFrame(const RawDualShock4DataFrame &raw_frame, const ClientDataFrameTimes &times, PSMController *controller);
+static void applyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, const ClientDataFrameTimes &times, PSMController *controller);
+static void applyControllerDataFrameTimes(const ClientDataFrameTimes &times, PSMController *controller);
 static void applyPSNaviDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMPSNavi *psnavi);
 static void applyDualShock4DataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMDualShock4 *ds4);
+static void applyRawDualShock4DataFrame(const RawDualShock4DataFrame &raw_frame, PSMDualShock4 *ds4);
+static void applyRawTrackerPointsData(const RawTrackerDataSection &raw_tracker_data, const RawTrackerPointsSection &raw_tracker_points, PSMTrackingProjection::eShapeType points_shape_type, PSMRawTrackerData *tracker_data);
 static void applyVirtualControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMVirtualController *virtual_controller);
-static void applyPSMButtonState(PSMButtonState &button, unsigned int button_bitmask, unsigned int button_bit);
 static void applyTrackerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket& tracker_packet, PSMTracker *tracker);
-static void applyHmdDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMHeadMountedDisplay *hmd);
+static bool applyHmdDataFrameHeader(int hmd_id, PSMHmdType hmd_type, int sequence_num, bool is_connected, PSMHeadMountedDisplay *hmd);
+static void applyHmdDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, const ClientDataFrameTimes &times, PSMHeadMountedDisplay *hmd);
+static void applyRawHmdDataFrame(const RawHMDDataFrame &raw_frame, const ClientDataFrameTimes &times, PSMHeadMountedDisplay *hmd);
+static void applyHmdDataFrameTimes(const ClientDataFrameTimes &times, PSMHeadMountedDisplay *hmd);
 static void applyMorpheusDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMMorpheus *morpheus);
 static void applyVirtualHMDDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMVirtualHMD *virtualHMD);
+static void applySharedControllerPose(const SharedPoseData &pose_data, double pose_time_seconds, PSMController *controller);
+static void applySharedHmdPose(const SharedPoseData &pose_data, double pose_time_seconds, PSMHeadMountedDisplay *hmd);
+static bool getControllerPoseSnapshot(const PSMController *controller, SharedPoseData &out_pose_data);
+static bool getHmdPoseSnapshot(const PSMHeadMountedDisplay *hmd, SharedPoseData &out_pose_data);
+static uint32_t makeSharedPoseStatusFlags(bool bIsConnected, bool bIsTrackingEnabled, bool bIsCurrentlyTracking, bool bIsOrientationValid, bool bIsPositionValid);
+static bool isLoopbackHost(const std::string &host);
 
 // -- private definitions -----
 class SharedVideoFrameReadOnlyAccessor
@@ -82,7 +108,19 @@ public:
             // Map all of the shared memory for read/write access
             m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
 
-            bSuccess = true;
+            // Refuse to read a layout we weren't built for (e.g. an older or newer server)
+            const int layout_version = getFrameHeader()->layout_version;
+            if (layout_version == SharedVideoFrameHeader::k_layout_version &&
+                m_region->get_size() >= getFrameHeader()->computeTotalSize())
+            {
+                bSuccess = true;
+            }
+            else
+            {
+                CLIENT_LOG_ERROR("SharedMemory::initialize()") << "Unsupported shared memory layout: " << m_shared_memory_name
+                    << ", version: " << layout_version << " (expected " << SharedVideoFrameHeader::k_layout_version << ")";
+                dispose();
+            }
         }
         catch (boost::interprocess::interprocess_exception &ex)
         {
@@ -124,17 +162,7 @@ public:
     bool readVideoFrame()
     {
         bool bNewFrame = false;
-        SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
-        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
-
-        // Make sure the target buffer is big enough to read the video frame into
-        size_t buffer_size =
-            SharedVideoFrameHeader::computeVideoBufferSize(sharedFrameState->stride, sharedFrameState->height);
-
-        // Make sure the shared memory is the size we expect
-        size_t total_shared_mem_size =
-            SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
-        assert(m_region->get_size() >= total_shared_mem_size);
+        const SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
 
         // Re-allocate the buffer if any of the video properties changed
         if (m_frame_width != sharedFrameState->width ||
@@ -150,22 +178,34 @@ public:
             allocateVideoBuffer();
         }
 
-        // Copy over the video frame if the frame index changed
-        if (m_last_frame_index != sharedFrameState->frame_index)
+        // Copy over the newest video frame if the frame index changed.
+        // The server doesn't wait for us, so this can fail if it keeps overwriting the slot we read.
+        if (m_bgr_frame_buffer != nullptr &&
+            m_last_frame_index != sharedFrameState->latest_frame_index.load())
         {
-            if (buffer_size > 0)
+            int frame_index = 0;
+
+            if (sharedFrameState->readLatestVideoFrame(m_bgr_frame_buffer, frame_index))
             {
-                std::memcpy(m_bgr_frame_buffer, sharedFrameState->getBufferMutable(), buffer_size);
+                m_last_frame_index = frame_index;
+                bNewFrame = true;
             }
-
-            m_last_frame_index = sharedFrameState->frame_index;
-
-            bNewFrame = true;
         }
 
         return bNewFrame;
     }
 
+    // Point straight at the newest frame in shared memory (no copy)
+    const unsigned char *getLatestVideoFrameNoCopy(int &out_frame_index) const
+    {
+        return getFrameHeader()->getLatestVideoFrame(out_frame_index);
+    }
+
+    bool getIsVideoFrameIntact(int frame_index) const
+    {
+        return getFrameHeader()->getIsVideoFrameIntact(frame_index);
+    }
+
     void allocateVideoBuffer()
     {
         size_t buffer_size = SharedVideoFrameHeader::computeVideoBufferSize(m_frame_stride, m_frame_height);
@@ -194,9 +234,9 @@ public:
     inline int getLastVideoFrameIndex() const { return m_last_frame_index; }
 
 protected:
-    SharedVideoFrameHeader *getFrameHeader()
+    const SharedVideoFrameHeader *getFrameHeader() const
     {
-        return reinterpret_cast<SharedVideoFrameHeader *>(m_region->get_address());
+        return reinterpret_cast<const SharedVideoFrameHeader *>(m_region->get_address());
     }
 
 private:
@@ -208,12 +248,109 @@ private:
     int m_last_frame_index;
 };
 
+class SharedPoseTableReadOnlyAccessor
+{
+public:
+    SharedPoseTableReadOnlyAccessor()
+        : m_shared_memory_object(nullptr)
+        , m_region(nullptr)
+    {}
+
+    ~SharedPoseTableReadOnlyAccessor()
+    {
+        dispose();
+    }
+
+    bool initialize(const char *shared_memory_name)
+    {
+        bool bSuccess = false;
+
+        try
+        {
+            CLIENT_LOG_INFO("SharedMemory::initialize()") << "Opening shared memory: " << shared_memory_name;
+
+            // Create the shared memory object
+            m_shared_memory_object =
+                new boost::interprocess::shared_memory_object(
+                boost::interprocess::open_only,
+                shared_memory_name,
+                boost::interprocess::read_only);
+
+            // Map all of the shared memory for read only access
+            m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_only);
+
+            // Refuse to read a layout we weren't built for (e.g. an older or newer server)
+            const SharedPoseTableHeader *poseTable = getPoseTable();
+            if (m_region->get_size() >= SharedPoseTableHeader::computeTotalSize() &&
+                poseTable->layout_version == SharedPoseTableHeader::k_layout_version &&
+                poseTable->controller_slot_count == PSMOVESERVICE_MAX_CONTROLLER_COUNT &&
+                poseTable->hmd_slot_count == PSMOVESERVICE_MAX_HMD_COUNT)
+            {
+                bSuccess = true;
+            }
+            else
+            {
+                CLIENT_LOG_ERROR("SharedMemory::initialize()") << "Unsupported shared memory layout: " << shared_memory_name
+                    << ", version: " << poseTable->layout_version << " (expected " << SharedPoseTableHeader::k_layout_version << ")";
+                dispose();
+            }
+        }
+        catch (boost::interprocess::interprocess_exception &ex)
+        {
+            dispose();
+            CLIENT_LOG_ERROR("SharedMemory::initialize()") << "Failed to open shared memory: " << shared_memory_name
+                << ", reason: " << ex.what();
+        }
+
+        return bSuccess;
+    }
+
+    void dispose()
+    {
+        if (m_region != nullptr)
+        {
+            delete m_region;
+            m_region = nullptr;
+        }
+
+        if (m_shared_memory_object != nullptr)
+        {
+            delete m_shared_memory_object;
+            m_shared_memory_object = nullptr;
+        }
+    }
+
+    bool readControllerPose(PSMControllerID controller_id, SharedPoseData &out_pose_data) const
+    {
+        return SharedPoseTableHeader::readSlot(getPoseTable()->getControllerSlot(controller_id), out_pose_data);
+    }
+
+    bool readHmdPose(PSMHmdID hmd_id, SharedPoseData &out_pose_data) const
+    {
+        return SharedPoseTableHeader::readSlot(getPoseTable()->getHMDSlot(hmd_id), out_pose_data);
+    }
+
+protected:
+    const SharedPoseTableHeader *getPoseTable() const
+    {
+        return reinterpret_cast<const SharedPoseTableHeader *>(m_region->get_address());
+    }
+
+private:
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
+};
+
 // -- methods -----
 PSMoveClient::PSMoveClient(
     const std::string &host, 
-    const std::string &port)
+    const std::string &port,
+    unsigned int connection_options)
     : m_request_manager(nullptr)  // ClientPSMoveAPIImpl::handle_response_message userdata
     , m_network_manager(nullptr) // IClientNetworkEventListener
+    , m_host(host)
+    , m_connection_options(connection_options)
+    , m_shared_pose_table(nullptr)
 	, m_bIsConnected(false)
 	, m_bHasConnectionStatusChanged(false)
 	, m_bHasControllerListChanged(false)
@@ -231,11 +368,17 @@ PSMoveClient::PSMoveClient(
 			this, // IDataFrameListener
 			this, // INotificationListener
 			m_request_manager, // IResponseListener
-			this); // IClientNetworkEventListener
+			this, // IClientNetworkEventListener
+			(connection_options & PSMConnectionOptions_networkThread) != 0,
+			this); // IDataFrameSnapshotListener
+
+    memset(m_controller_stream_rate_limits, 0, sizeof(m_controller_stream_rate_limits));
+    memset(m_hmd_stream_rate_limits, 0, sizeof(m_hmd_stream_rate_limits));
 }
 
 PSMoveClient::~PSMoveClient()
 {
+	close_shared_pose_table();
 	delete m_network_manager;
 	delete m_request_manager;
 }
@@ -301,6 +444,23 @@ bool PSMoveClient::startup(e_log_severity_level log_level)
 	m_bHasHMDListChanged= false;
 	m_bWasSystemButtonPressed = false;
 
+	// The network thread (if any) starts publishing pose snapshots as soon as the network manager starts up
+	memset(m_snapshot_controllers, 0, sizeof(PSMController)*PSMOVESERVICE_MAX_CONTROLLER_COUNT);
+	for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)    
+	{
+		m_snapshot_controllers[controller_id].ControllerID= controller_id;
+		m_snapshot_controllers[controller_id].ControllerType= PSMController_None;
+		m_controller_pose_snapshots[controller_id].clear();
+	}
+
+	memset(m_snapshot_HMDs, 0, sizeof(PSMHeadMountedDisplay)*PSMOVESERVICE_MAX_HMD_COUNT);
+	for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)    
+	{
+		m_snapshot_HMDs[hmd_id].HmdID= hmd_id;
+		m_snapshot_HMDs[hmd_id].HmdType= PSMHmd_None;
+		m_hmd_pose_snapshots[hmd_id].clear();
+	}
+
     // Attempt to connect to the server
     if (success)
     {
@@ -358,8 +518,26 @@ void PSMoveClient::update()
     // Publish modified device state back to the service
     publish();
 
+    // Send the requests made since the last update together
+    m_request_manager->flush_requests();
+
     // Process incoming/outgoing networking requests
     m_network_manager->update();
+
+    // Overwrite the poses from the data frames with the newer ones in the shared memory pose table
+    if (m_shared_pose_table != nullptr)
+    {
+        update_shared_poses();
+    }
+}
+
+void PSMoveClient::wait_for_network_activity(int timeout_ms)
+{
+    // A blocking request may still be queued
+    m_request_manager->flush_requests();
+
+    // Any response received during the wait gets dispatched (and its callback executed) before this returns
+    m_network_manager->wait_for_activity(timeout_ms);
 }
 
 void PSMoveClient::process_messages()
@@ -501,6 +679,71 @@ void PSMoveClient::publish()
 	}
 }
 
+void PSMoveClient::open_shared_pose_table()
+{
+    // The pose table only describes a service on this machine
+    if (!isLoopbackHost(m_host))
+    {
+        CLIENT_LOG_WARNING("open_shared_pose_table") << "Service host " << m_host << " isn't local, using data frames for poses";
+        return;
+    }
+
+    if (m_shared_pose_table == nullptr)
+    {
+        m_shared_pose_table = new SharedPoseTableReadOnlyAccessor();
+
+        if (!m_shared_pose_table->initialize(PSMOVESERVICE_POSE_TABLE_SHARED_MEMORY_NAME))
+        {
+            CLIENT_LOG_WARNING("open_shared_pose_table") << "Pose table unavailable, using data frames for poses";
+            delete m_shared_pose_table;
+            m_shared_pose_table = nullptr;
+        }
+    }
+}
+
+void PSMoveClient::close_shared_pose_table()
+{
+    if (m_shared_pose_table != nullptr)
+    {
+        delete m_shared_pose_table;
+        m_shared_pose_table = nullptr;
+    }
+}
+
+void PSMoveClient::update_shared_poses()
+{
+    SharedPoseData pose_data;
+
+    // Only touch devices that are already getting data frames, so the rest of their state is valid.
+    // A slot is never older than the last data frame received for it,
+    // but check the sequence number anyway in case the service restarted under us.
+    for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+    {
+        PSMController *controller= &m_controllers[controller_id];
+
+        if (controller->bValid && controller->ListenerCount > 0 &&
+            m_shared_pose_table->readControllerPose(controller_id, pose_data) &&
+            pose_data.device_type == static_cast<int32_t>(controller->ControllerType) &&
+            pose_data.sequence_num >= controller->OutputSequenceNum)
+        {
+            applySharedControllerPose(pose_data, to_client_time_seconds(pose_data.pose_time_seconds), controller);
+        }
+    }
+
+    for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+    {
+        PSMHeadMountedDisplay *hmd= &m_HMDs[hmd_id];
+
+        if (hmd->bValid && hmd->ListenerCount > 0 &&
+            m_shared_pose_table->readHmdPose(hmd_id, pose_data) &&
+            pose_data.device_type == static_cast<int32_t>(hmd->HmdType) &&
+            pose_data.sequence_num >= hmd->OutputSequenceNum)
+        {
+            applySharedHmdPose(pose_data, to_client_time_seconds(pose_data.pose_time_seconds), hmd);
+        }
+    }
+}
+
 static void processPSMoveRecenterAction(PSMController *controller)
 {
 	PSMPSMove *psmove= &controller->ControllerState.PSMoveState;
@@ -614,9 +857,15 @@ bool PSMoveClient::poll_next_message(PSMMessage *message, size_t message_size)
 
 void PSMoveClient::shutdown()
 {
+    // Get out any requests made since the last update
+    m_request_manager->flush_requests();
+
     // Close all active network connections
     m_network_manager->shutdown();
 
+    // Stop reading poses from the service's shared memory
+    close_shared_pose_table();
+
     // Drop an unread messages from the previous call to update
     m_message_queue.clear();
 
@@ -685,6 +934,30 @@ void PSMoveClient::free_controller_listener(PSMControllerID ControllerID)
 	}
 }
     
+bool PSMoveClient::get_controller_pose_snapshot(PSMControllerID controller_id, SharedPoseData &out_pose_data) const
+{
+    // Safe to call from any thread
+    return
+        (m_connection_options & PSMConnectionOptions_networkThread) != 0 &&
+        IS_VALID_CONTROLLER_INDEX(controller_id) &&
+        m_controller_pose_snapshots[controller_id].read(out_pose_data) &&
+        out_pose_data.device_type != -1;
+}
+
+bool PSMoveClient::get_latest_controller_pose(PSMControllerID controller_id, SharedPoseData &out_pose_data) const
+{
+    if (get_controller_pose_snapshot(controller_id, out_pose_data))
+    {
+        return true;
+    }
+
+    return
+        (m_connection_options & PSMConnectionOptions_networkThread) == 0 &&
+        IS_VALID_CONTROLLER_INDEX(controller_id) &&
+        m_controllers[controller_id].bValid &&
+        getControllerPoseSnapshot(&m_controllers[controller_id], out_pose_data);
+}
+
 PSMController* PSMoveClient::get_controller_view(PSMControllerID controller_id)
 {
 	return IS_VALID_CONTROLLER_INDEX(controller_id) ? &m_controllers[controller_id] : nullptr;
@@ -707,6 +980,19 @@ PSMRequestID PSMoveClient::get_controller_list()
     return request->request_id();
 }
 
+bool PSMoveClient::set_controller_data_stream_rate_limit(PSMControllerID controller_id, const PSMDataStreamRateLimit &rate_limit)
+{
+	bool bSuccess= false;
+
+	if (IS_VALID_CONTROLLER_INDEX(controller_id))
+	{
+		m_controller_stream_rate_limits[controller_id]= rate_limit;
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
 PSMRequestID PSMoveClient::start_controller_data_stream(PSMControllerID controller_id, unsigned int flags)
 {
 	PSMRequestID requestID= PSM_INVALID_REQUEST_ID;
@@ -750,6 +1036,24 @@ PSMRequestID PSMoveClient::start_controller_data_stream(PSMControllerID controll
 			request->mutable_request_start_psmove_data_stream()->set_disable_roi(true);
 		}
 
+		if ((flags & PSMStreamFlags_coalesceDataFrames) > 0)
+		{
+			request->mutable_request_start_psmove_data_stream()->set_coalesce_data_frames(true);
+		}
+
+		if ((flags & PSMStreamFlags_rawDataFrameFormat) > 0)
+		{
+			request->mutable_request_start_psmove_data_stream()->set_raw_data_frame_format(true);
+		}
+
+		{
+			const PSMDataStreamRateLimit &rate_limit= m_controller_stream_rate_limits[controller_id];
+
+			request->mutable_request_start_psmove_data_stream()->set_max_data_frame_rate(rate_limit.max_data_frame_rate);
+			request->mutable_request_start_psmove_data_stream()->set_position_change_threshold_cm(rate_limit.position_change_threshold_cm);
+			request->mutable_request_start_psmove_data_stream()->set_orientation_change_threshold_degrees(rate_limit.orientation_change_threshold_degrees);
+		}
+
 		m_request_manager->send_request(request);
 
 		requestID= request->request_id();
@@ -1032,6 +1336,46 @@ void PSMoveClient::close_video_stream(PSMTrackerID tracker_id)
 	}
 }
 
+const unsigned char *PSMoveClient::get_video_frame_buffer_no_copy(PSMTrackerID tracker_id, int &out_frame_index) const
+{
+	const unsigned char *buffer= nullptr;
+
+	if (IS_VALID_TRACKER_INDEX(tracker_id))
+	{
+		const PSMTracker *tracker= &m_trackers[tracker_id];
+
+		if (tracker->opaque_shared_memory_accesor != nullptr)
+		{
+			SharedVideoFrameReadOnlyAccessor *shared_memory_accesor = 
+				reinterpret_cast<SharedVideoFrameReadOnlyAccessor *>(tracker->opaque_shared_memory_accesor);
+
+			buffer= shared_memory_accesor->getLatestVideoFrameNoCopy(out_frame_index);
+		}
+	}
+
+	return buffer;
+}
+
+bool PSMoveClient::get_is_video_frame_intact(PSMTrackerID tracker_id, int frame_index) const
+{
+	bool bIntact= false;
+
+	if (IS_VALID_TRACKER_INDEX(tracker_id))
+	{
+		const PSMTracker *tracker= &m_trackers[tracker_id];
+
+		if (tracker->opaque_shared_memory_accesor != nullptr)
+		{
+			SharedVideoFrameReadOnlyAccessor *shared_memory_accesor = 
+				reinterpret_cast<SharedVideoFrameReadOnlyAccessor *>(tracker->opaque_shared_memory_accesor);
+
+			bIntact= shared_memory_accesor->getIsVideoFrameIntact(frame_index);
+		}
+	}
+
+	return bIntact;
+}
+
 const unsigned char *PSMoveClient::get_video_frame_buffer(PSMTrackerID tracker_id) const
 {
 	const unsigned char *buffer= nullptr;
@@ -1092,6 +1436,30 @@ void PSMoveClient::free_hmd_listener(PSMHmdID hmd_id)
     }
 }
 
+bool PSMoveClient::get_hmd_pose_snapshot(PSMHmdID hmd_id, SharedPoseData &out_pose_data) const
+{
+    // Safe to call from any thread
+    return
+        (m_connection_options & PSMConnectionOptions_networkThread) != 0 &&
+        IS_VALID_HMD_INDEX(hmd_id) &&
+        m_hmd_pose_snapshots[hmd_id].read(out_pose_data) &&
+        out_pose_data.device_type != -1;
+}
+
+bool PSMoveClient::get_latest_hmd_pose(PSMHmdID hmd_id, SharedPoseData &out_pose_data) const
+{
+    if (get_hmd_pose_snapshot(hmd_id, out_pose_data))
+    {
+        return true;
+    }
+
+    return
+        (m_connection_options & PSMConnectionOptions_networkThread) == 0 &&
+        IS_VALID_HMD_INDEX(hmd_id) &&
+        m_HMDs[hmd_id].bValid &&
+        getHmdPoseSnapshot(&m_HMDs[hmd_id], out_pose_data);
+}
+
 PSMHeadMountedDisplay* PSMoveClient::get_hmd_view(PSMHmdID hmd_id)
 {
 	return IS_VALID_HMD_INDEX(hmd_id) ? &m_HMDs[hmd_id] : nullptr;
@@ -1111,6 +1479,19 @@ PSMRequestID PSMoveClient::get_hmd_list()
 }    
 
     
+bool PSMoveClient::set_hmd_data_stream_rate_limit(PSMHmdID hmd_id, const PSMDataStreamRateLimit &rate_limit)
+{
+	bool bSuccess= false;
+
+	if (IS_VALID_HMD_INDEX(hmd_id))
+	{
+		m_hmd_stream_rate_limits[hmd_id]= rate_limit;
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
 PSMRequestID PSMoveClient::start_hmd_data_stream(
     PSMHmdID hmd_id,
     unsigned int flags)
@@ -1152,6 +1533,25 @@ PSMRequestID PSMoveClient::start_hmd_data_stream(
 		request->mutable_request_start_hmd_data_stream()->set_disable_roi(true);
 	}
 
+	if ((flags & PSMStreamFlags_coalesceDataFrames) > 0)
+	{
+		request->mutable_request_start_hmd_data_stream()->set_coalesce_data_frames(true);
+	}
+
+	if ((flags & PSMStreamFlags_rawDataFrameFormat) > 0)
+	{
+		request->mutable_request_start_hmd_data_stream()->set_raw_data_frame_format(true);
+	}
+
+	if (IS_VALID_HMD_INDEX(hmd_id))
+	{
+		const PSMDataStreamRateLimit &rate_limit= m_hmd_stream_rate_limits[hmd_id];
+
+		request->mutable_request_start_hmd_data_stream()->set_max_data_frame_rate(rate_limit.max_data_frame_rate);
+		request->mutable_request_start_hmd_data_stream()->set_position_change_threshold_cm(rate_limit.position_change_threshold_cm);
+		request->mutable_request_start_hmd_data_stream()->set_orientation_change_threshold_degrees(rate_limit.orientation_change_threshold_degrees);
+	}
+
     m_request_manager->send_request(request);
 
     return request->request_id();
@@ -1196,6 +1596,27 @@ PSMRequestID PSMoveClient::send_opaque_request(
     return request->request_id();
 }    
     
+double PSMoveClient::to_client_time_seconds(double service_time_seconds) const
+{
+    // Safe to call from any thread
+    double service_to_client_offset;
+
+    return
+        (service_time_seconds > 0.0 && m_network_manager->get_service_to_client_clock_offset(service_to_client_offset))
+        ? service_time_seconds + service_to_client_offset
+        : -1.0;
+}
+
+ClientDataFrameTimes PSMoveClient::get_data_frame_times(double service_sample_time_seconds, double service_pose_time_seconds) const
+{
+    ClientDataFrameTimes times;
+
+    times.sample_time_seconds= to_client_time_seconds(service_sample_time_seconds);
+    times.pose_time_seconds= to_client_time_seconds(service_pose_time_seconds);
+
+    return times;
+}
+
 // IDataFrameListener
 void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
@@ -1214,7 +1635,7 @@ void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame
 			{
 				PSMController *controller= get_controller_view(controller_id);
 
-				applyControllerDataFrame(controller_packet, controller);
+				applyControllerDataFrame(controller_packet, get_data_frame_times(controller_packet.sample_time_seconds(), controller_packet.pose_time_seconds()), controller);
 			}
         } break;
     case PSMoveProtocol::DeviceOutputDataFrame::TRACKER:
@@ -1247,27 +1668,230 @@ void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame
 			{
 				PSMHeadMountedDisplay *hmd= get_hmd_view(hmd_id);
 
-				applyHmdDataFrame(hmd_packet, hmd);
+				applyHmdDataFrame(hmd_packet, get_data_frame_times(hmd_packet.sample_time_seconds(), hmd_packet.pose_time_seconds()), hmd);
 			}
         } break;            
     }
 }
 
-static void applyControllerDataFrame(
-	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, 
-	PSMController *controller)
-{    
-	// Ignore old packets
-	if (controller_packet.sequence_num() <= controller->OutputSequenceNum)
-		return;
+void PSMoveClient::handle_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size)
+{
+    RawDataFrameHeader header;
 
-    // Set the generic items
-    controller->bValid = controller_packet.controller_id() != -1;
-    controller->ControllerType = static_cast<PSMControllerType>(controller_packet.controller_type());
-    controller->OutputSequenceNum = controller_packet.sequence_num();
-    controller->IsConnected = controller_packet.isconnected();
+    if (apply_raw_data_frame(data_frame, data_frame_size, m_controllers, m_HMDs, header))
+    {
+        CLIENT_LOG_TRACE("handle_raw_data_frame") 
+            << "received raw data frame for device category " << static_cast<int>(header.device_category)
+            << " ID: " << header.device_id << std::endl;
+    }
+    else
+    {
+        CLIENT_LOG_TRACE("handle_raw_data_frame")
+            << "received raw data frame for unsupported device category " << static_cast<int>(header.device_category)
+            << " type " << static_cast<int>(header.device_type) << ". Ignoring." << std::endl;
+    }
+}
 
-    // Compute the data frame receive window statistics if we have received enough samples
+bool PSMoveClient::apply_raw_data_frame(
+    const uint8_t *data_frame, 
+    size_t data_frame_size,
+    PSMController *controllers, 
+    PSMHeadMountedDisplay *hmds,
+    RawDataFrameHeader &out_header) const
+{
+    // The network layer already checked the header is all there
+    memcpy(&out_header, data_frame, sizeof(RawDataFrameHeader));
+
+    if (out_header.device_category == PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER &&
+        IS_VALID_CONTROLLER_INDEX(out_header.device_id))
+    {
+        PSMController *controller= &controllers[out_header.device_id];
+
+        switch (out_header.device_type)
+        {
+        case PSMoveProtocol::PSMOVE:
+            {
+                RawPSMoveDataFrame raw_frame;
+
+                if (getRawDataFrame(data_frame, data_frame_size, raw_frame))
+                {
+                    applyRawControllerDataFrame(raw_frame, get_data_frame_times(raw_frame.sample_time_seconds, raw_frame.pose_time_seconds), controller);
+                    return true;
+                }
+            } break;
+        case PSMoveProtocol::PSDUALSHOCK4:
+            {
+                RawDualShock4DataFrame raw_frame;
+
+                if (getRawDataFrame(data_frame, data_frame_size, raw_frame))
+                {
+                    applyRawControllerDataFrame(raw_frame, get_data_frame_times(raw_frame.sample_time_seconds, raw_frame.pose_time_seconds), controller);
+                    return true;
+                }
+            } break;
+        default:
+            break;
+        }
+    }
+    else if (out_header.device_category == PSMoveProtocol::DeviceOutputDataFrame::HMD &&
+             IS_VALID_HMD_INDEX(out_header.device_id))
+    {
+        RawHMDDataFrame raw_frame;
+
+        if (getRawDataFrame(data_frame, data_frame_size, raw_frame))
+        {
+            applyRawHmdDataFrame(raw_frame, get_data_frame_times(raw_frame.sample_time_seconds, raw_frame.pose_time_seconds), &hmds[out_header.device_id]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PSMoveClient::snapshot_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+{
+    // Called on the network thread: only touch the snapshot views and slots
+    SharedPoseData pose_data;
+
+    switch (data_frame->device_category())
+    {
+    case PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet= data_frame->controller_data_packet();
+			const PSMControllerID controller_id= controller_packet.controller_id();
+
+			if (IS_VALID_CONTROLLER_INDEX(controller_id))
+			{
+				PSMController *controller= &m_snapshot_controllers[controller_id];
+
+				applyControllerDataFrame(controller_packet, get_data_frame_times(controller_packet.sample_time_seconds(), controller_packet.pose_time_seconds()), controller);
+
+				if (getControllerPoseSnapshot(controller, pose_data))
+				{
+					m_controller_pose_snapshots[controller_id].write(pose_data);
+				}
+			}
+        } break;
+    case PSMoveProtocol::DeviceOutputDataFrame::HMD:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet = data_frame->hmd_data_packet();
+			const PSMHmdID hmd_id= hmd_packet.hmd_id();
+
+			if (IS_VALID_HMD_INDEX(hmd_id))
+			{
+				PSMHeadMountedDisplay *hmd= &m_snapshot_HMDs[hmd_id];
+
+				applyHmdDataFrame(hmd_packet, get_data_frame_times(hmd_packet.sample_time_seconds(), hmd_packet.pose_time_seconds()), hmd);
+
+				if (getHmdPoseSnapshot(hmd, pose_data))
+				{
+					m_hmd_pose_snapshots[hmd_id].write(pose_data);
+				}
+			}
+        } break;
+    default:
+        // Trackers don't have a pose that changes
+        break;
+    }
+}
+
+void PSMoveClient::snapshot_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size)
+{
+    // Called on the network thread: only touch the snapshot views and slots
+    RawDataFrameHeader header;
+    SharedPoseData pose_data;
+
+    if (apply_raw_data_frame(data_frame, data_frame_size, m_snapshot_controllers, m_snapshot_HMDs, header))
+    {
+        const int device_id= header.device_id;
+
+        if (header.device_category == PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER)
+        {
+            if (getControllerPoseSnapshot(&m_snapshot_controllers[device_id], pose_data))
+            {
+                m_controller_pose_snapshots[device_id].write(pose_data);
+            }
+        }
+        else if (getHmdPoseSnapshot(&m_snapshot_HMDs[device_id], pose_data))
+        {
+            m_hmd_pose_snapshots[device_id].write(pose_data);
+        }
+    }
+}
+
+// Copies a raw data frame of the given layout out of the datagram.
+// Returns false if the datagram is too short for it.
+template <typename t_raw_data_frame>
+static bool getRawDataFrame(
+    const uint8_t *data_frame,
+    size_t data_frame_size,
+    t_raw_data_frame &out_raw_frame)
+{
+    // The datagram buffer has no alignment guarantees, so copy the whole frame out
+    if (data_frame_size < sizeof(t_raw_data_frame))
+    {
+        return false;
+    }
+
+    memcpy(&out_raw_frame, data_frame, sizeof(t_raw_data_frame));
+
+    return true;
+}
+
+static void applyRawControllerDataFrame(
+    const RawPSMoveDataFrame &raw_frame,
+    const ClientDataFrameTimes &times,
+    PSMController *controller)
+{
+    if (applyControllerDataFrameHeader(
+            raw_frame.header.device_id, 
+            PSMController_Move, 
+            raw_frame.header.sequence_num, 
+            (raw_frame.status_flags & RAW_DEVICE_STATUS_CONNECTED) != 0,
+            controller))
+    {
+        applyRawPSMoveDataFrame(raw_frame, &controller->ControllerState.PSMoveState);
+        applyControllerDataFrameTimes(times, controller);
+    }
+}
+
+static void applyRawControllerDataFrame(
+    const RawDualShock4DataFrame &raw_frame,
+    const ClientDataFrameTimes &times,
+    PSMController *controller)
+{
+    if (applyControllerDataFrameHeader(
+            raw_frame.header.device_id, 
+            PSMController_DualShock4, 
+            raw_frame.header.sequence_num, 
+            (raw_frame.status_flags & RAW_DEVICE_STATUS_CONNECTED) != 0,
+            controller))
+    {
+        applyRawDualShock4DataFrame(raw_frame, &controller->ControllerState.PSDS4State);
+        applyControllerDataFrameTimes(times, controller);
+    }
+}
+
+// Applies the fields common to every controller data frame format.
+// Returns false if the rest of the data frame should be ignored.
+static bool applyControllerDataFrameHeader(
+    int controller_id,
+    PSMControllerType controller_type,
+    int sequence_num,
+    bool is_connected,
+    PSMController *controller)
+{
+	// Ignore old packets
+	if (sequence_num <= controller->OutputSequenceNum)
+		return false;
+
+    // Set the generic items
+    controller->bValid = controller_id != -1;
+    controller->ControllerType = controller_type;
+    controller->OutputSequenceNum = sequence_num;
+    controller->IsConnected = is_connected;
+
+    // Compute the data frame receive window statistics if we have received enough samples
     {
         long long now = 
             std::chrono::duration_cast< std::chrono::milliseconds >(
@@ -1286,8 +1910,23 @@ static void applyControllerDataFrame(
     }
    
 	// Don't bother updating the rest of the controller state if it's not connected
-	if (!controller->IsConnected)
-		return;
+	return controller->IsConnected;
+}
+
+static void applyControllerDataFrame(
+	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, 
+	const ClientDataFrameTimes &times,
+	PSMController *controller)
+{    
+    if (!applyControllerDataFrameHeader(
+            controller_packet.controller_id(),
+            static_cast<PSMControllerType>(controller_packet.controller_type()),
+            controller_packet.sequence_num(),
+            controller_packet.isconnected(),
+            controller))
+    {
+        return;
+    }
 
     switch (controller->ControllerType) 
 	{
@@ -1309,173 +1948,40 @@ static void applyControllerDataFrame(
         default:
             break;
     }
+
+    applyControllerDataFrameTimes(times, controller);
 }
 
-static void applyPSMoveDataFrame(
-	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet,
-	PSMPSMove *psmove)
+static void applyControllerDataFrameTimes(
+    const ClientDataFrameTimes &times,
+    PSMController *controller)
 {
-	const auto &psmove_packet= controller_packet.psmove_state();
-
-    psmove->bHasValidHardwareCalibration = psmove_packet.validhardwarecalibration();
-    psmove->bIsTrackingEnabled = psmove_packet.istrackingenabled();
-    psmove->bIsCurrentlyTracking = psmove_packet.iscurrentlytracking();
-	psmove->bIsOrientationValid = psmove_packet.isorientationvalid();
-	psmove->bIsPositionValid = psmove_packet.ispositionvalid();
-            
-    psmove->Pose.Orientation.w= psmove_packet.orientation().w();
-    psmove->Pose.Orientation.x= psmove_packet.orientation().x();
-    psmove->Pose.Orientation.y= psmove_packet.orientation().y();
-    psmove->Pose.Orientation.z= psmove_packet.orientation().z();
-
-    psmove->Pose.Position.x= psmove_packet.position_cm().x();
-    psmove->Pose.Position.y= psmove_packet.position_cm().y();
-    psmove->Pose.Position.z= psmove_packet.position_cm().z();
-            
-    if (psmove_packet.has_physics_data())
-    {
-        const auto &raw_physics_data = psmove_packet.physics_data();
-
-        psmove->PhysicsData.LinearVelocityCmPerSec.x = raw_physics_data.velocity_cm_per_sec().i();
-        psmove->PhysicsData.LinearVelocityCmPerSec.y = raw_physics_data.velocity_cm_per_sec().j();
-        psmove->PhysicsData.LinearVelocityCmPerSec.z = raw_physics_data.velocity_cm_per_sec().k();
-
-        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.x = raw_physics_data.acceleration_cm_per_sec_sqr().i();
-        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.y = raw_physics_data.acceleration_cm_per_sec_sqr().j();
-        psmove->PhysicsData.LinearAccelerationCmPerSecSqr.z = raw_physics_data.acceleration_cm_per_sec_sqr().k();
-
-        psmove->PhysicsData.AngularVelocityRadPerSec.x = raw_physics_data.angular_velocity_rad_per_sec().i();
-        psmove->PhysicsData.AngularVelocityRadPerSec.y = raw_physics_data.angular_velocity_rad_per_sec().j();
-        psmove->PhysicsData.AngularVelocityRadPerSec.z = raw_physics_data.angular_velocity_rad_per_sec().k();
-
-        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.x = raw_physics_data.angular_acceleration_rad_per_sec_sqr().i();
-        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.y = raw_physics_data.angular_acceleration_rad_per_sec_sqr().j();
-        psmove->PhysicsData.AngularAccelerationRadPerSecSqr.z = raw_physics_data.angular_acceleration_rad_per_sec_sqr().k();
-
-		//###HipsterSloth $TODO - pass down the physics data timestamp
-		psmove->PhysicsData.TimeInSeconds= -1.0;
-    }
-    else
-    {
-        memset(&psmove->PhysicsData, 0, sizeof(PSMPhysicsData));
-    }
-            
-    if (psmove_packet.has_raw_sensor_data())
+    switch (controller->ControllerType)
     {
-        const auto &raw_sensor_data = psmove_packet.raw_sensor_data();
-
-        psmove->RawSensorData.Magnetometer.x= raw_sensor_data.magnetometer().i();
-        psmove->RawSensorData.Magnetometer.y= raw_sensor_data.magnetometer().j();
-        psmove->RawSensorData.Magnetometer.z= raw_sensor_data.magnetometer().k();
-
-        psmove->RawSensorData.Accelerometer.x= raw_sensor_data.accelerometer().i();
-        psmove->RawSensorData.Accelerometer.y= raw_sensor_data.accelerometer().j();
-        psmove->RawSensorData.Accelerometer.z= raw_sensor_data.accelerometer().k();
+    case PSMController_Move:
+        {
+            PSMPSMove *psmove= &controller->ControllerState.PSMoveState;
 
-        psmove->RawSensorData.Gyroscope.x= raw_sensor_data.gyroscope().i();
-        psmove->RawSensorData.Gyroscope.y= raw_sensor_data.gyroscope().j();
-        psmove->RawSensorData.Gyroscope.z= raw_sensor_data.gyroscope().k();
+            psmove->PhysicsData.TimeInSeconds= times.pose_time_seconds;
+            psmove->RawSensorData.TimeInSeconds= times.sample_time_seconds;
+            psmove->CalibratedSensorData.TimeInSeconds= times.sample_time_seconds;
+        } break;
+    case PSMController_DualShock4:
+        {
+            PSMDualShock4 *ds4= &controller->ControllerState.PSDS4State;
 
-		//###HipsterSloth $TODO - pass down the raw sensor data timestamp
-		psmove->RawSensorData.TimeInSeconds= -1.0;
+            ds4->PhysicsData.TimeInSeconds= times.pose_time_seconds;
+            ds4->RawSensorData.TimeInSeconds= times.sample_time_seconds;
+            ds4->CalibratedSensorData.TimeInSeconds= times.sample_time_seconds;
+        } break;
+    case PSMController_Virtual:
+        {
+            controller->ControllerState.VirtualController.PhysicsData.TimeInSeconds= times.pose_time_seconds;
+        } break;
+    default:
+        // No pose or IMU (i.e. the navi controller)
+        break;
     }
-    else
-    {
-		memset(&psmove->RawSensorData, 0, sizeof(PSMPSMoveRawSensorData));
-	}
-
-	if (psmove_packet.has_calibrated_sensor_data())
-	{
-		const auto &calibrated_sensor_data = psmove_packet.calibrated_sensor_data();
-
-		psmove->CalibratedSensorData.Magnetometer.x = calibrated_sensor_data.magnetometer().i();
-		psmove->CalibratedSensorData.Magnetometer.y = calibrated_sensor_data.magnetometer().j();
-		psmove->CalibratedSensorData.Magnetometer.z = calibrated_sensor_data.magnetometer().k();
-
-		psmove->CalibratedSensorData.Accelerometer.x = calibrated_sensor_data.accelerometer().i();
-		psmove->CalibratedSensorData.Accelerometer.y = calibrated_sensor_data.accelerometer().j();
-		psmove->CalibratedSensorData.Accelerometer.z = calibrated_sensor_data.accelerometer().k();
-
-		psmove->CalibratedSensorData.Gyroscope.x = calibrated_sensor_data.gyroscope().i();
-		psmove->CalibratedSensorData.Gyroscope.y = calibrated_sensor_data.gyroscope().j();
-		psmove->CalibratedSensorData.Gyroscope.z = calibrated_sensor_data.gyroscope().k();
-
-		//###HipsterSloth $TODO - pass down the raw sensor data timestamp
-		psmove->CalibratedSensorData.TimeInSeconds = -1.0;
-	}
-	else
-	{
-		memset(&psmove->RawSensorData, 0, sizeof(PSMPSMoveCalibratedSensorData));
-	}
-
-	if (psmove_packet.has_raw_tracker_data())
-	{
-		const auto &raw_tracker_data = psmove_packet.raw_tracker_data();
-
-		const PSMoveProtocol::Pixel &locationOnTracker = raw_tracker_data.screen_location();
-		const PSMoveProtocol::Position &positionOnTracker = raw_tracker_data.relative_position_cm();
-
-		psmove->RawTrackerData.TrackerID = raw_tracker_data.tracker_id();
-		psmove->RawTrackerData.ScreenLocation = { locationOnTracker.x(), locationOnTracker.y() };
-		psmove->RawTrackerData.RelativePositionCm = { positionOnTracker.x(), positionOnTracker.y(), positionOnTracker.z() };
-		psmove->RawTrackerData.RelativeOrientation = *k_psm_quaternion_identity;
-		psmove->RawTrackerData.ValidTrackerBitmask = raw_tracker_data.valid_tracker_bitmask();
-
-        if (raw_tracker_data.has_projected_sphere())
-		{
-			const PSMoveProtocol::Ellipse &protocolEllipse = raw_tracker_data.projected_sphere();
-			PSMTrackingProjection &projection = psmove->RawTrackerData.TrackingProjection;
-
-			projection.shape.ellipse.center.x = protocolEllipse.center().x();
-			projection.shape.ellipse.center.y = protocolEllipse.center().y();
-			projection.shape.ellipse.half_x_extent = protocolEllipse.half_x_extent();
-			projection.shape.ellipse.half_y_extent = protocolEllipse.half_y_extent();
-			projection.shape.ellipse.angle = protocolEllipse.angle();
-			projection.shape_type = PSMTrackingProjection::PSMShape_Ellipse;
-		}
-        else
-		{
-			PSMTrackingProjection &projection = psmove->RawTrackerData.TrackingProjection;
-
-			projection.shape_type = PSMTrackingProjection::PSMShape_INVALID_PROJECTION;
-		}
-
-
-		if (raw_tracker_data.has_multicam_position_cm())
-		{
-			const PSMoveProtocol::Position &multicam_position = raw_tracker_data.multicam_position_cm();
-
-			psmove->RawTrackerData.MulticamPositionCm.x = multicam_position.x();
-			psmove->RawTrackerData.MulticamPositionCm.y = multicam_position.y();
-			psmove->RawTrackerData.MulticamPositionCm.z = multicam_position.z();
-			psmove->RawTrackerData.bMulticamPositionValid = true;
-		}
-
-		// No optical orientation from sphere projection
-		psmove->RawTrackerData.bMulticamOrientationValid = false;
-		psmove->RawTrackerData.MulticamOrientation = *k_psm_quaternion_identity;
-	}
-	else
-	{
-		memset(&psmove->RawTrackerData, 0, sizeof(PSMRawTrackerData));
-	}
-
-	unsigned int button_bitmask = controller_packet.button_down_bitmask();
-	applyPSMButtonState(psmove->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
-	applyPSMButtonState(psmove->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
-	applyPSMButtonState(psmove->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
-	applyPSMButtonState(psmove->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
-	applyPSMButtonState(psmove->SelectButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SELECT);
-	applyPSMButtonState(psmove->StartButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_START);
-	applyPSMButtonState(psmove->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
-	applyPSMButtonState(psmove->MoveButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_MOVE);
-	applyPSMButtonState(psmove->TriggerButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIGGER);
-
-	// Trigger value in range [0,255]
-	psmove->TriggerValue = static_cast<unsigned char>(psmove_packet.trigger_value());
-
-	// Battery level range [0, 5] - EE charging & EF full
-	psmove->BatteryValue = static_cast<PSMBatteryState>(psmove_packet.battery_value());
 }
 
 static void applyPSNaviDataFrame(
@@ -1542,9 +2048,6 @@ static void applyDualShock4DataFrame(
         ds4->PhysicsData.AngularAccelerationRadPerSecSqr.x = raw_physics_data.angular_acceleration_rad_per_sec_sqr().i();
         ds4->PhysicsData.AngularAccelerationRadPerSecSqr.y = raw_physics_data.angular_acceleration_rad_per_sec_sqr().j();
         ds4->PhysicsData.AngularAccelerationRadPerSecSqr.z = raw_physics_data.angular_acceleration_rad_per_sec_sqr().k();
-
-		//###HipsterSloth $TODO - pass down the physics data timestamp
-		ds4->PhysicsData.TimeInSeconds= -1.0;
     }
     else
     {
@@ -1562,9 +2065,6 @@ static void applyDualShock4DataFrame(
         ds4->RawSensorData.Gyroscope.x= raw_sensor_data.gyroscope().i();
         ds4->RawSensorData.Gyroscope.y= raw_sensor_data.gyroscope().j();
         ds4->RawSensorData.Gyroscope.z= raw_sensor_data.gyroscope().k();
-
-		//###HipsterSloth $TODO - pass down the raw sensor data timestamp
-		ds4->RawSensorData.TimeInSeconds= -1.0;
     }
     else
     {
@@ -1582,9 +2082,6 @@ static void applyDualShock4DataFrame(
 		ds4->CalibratedSensorData.Gyroscope.x = calibrated_sensor_data.gyroscope().i();
 		ds4->CalibratedSensorData.Gyroscope.y = calibrated_sensor_data.gyroscope().j();
 		ds4->CalibratedSensorData.Gyroscope.z = calibrated_sensor_data.gyroscope().k();
-
-		//###HipsterSloth $TODO - pass down the raw sensor data timestamp
-		ds4->CalibratedSensorData.TimeInSeconds = -1.0;
 	}
 	else
 	{
@@ -1695,6 +2192,164 @@ static void applyDualShock4DataFrame(
     ds4->RightTriggerValue = ds4_packet.right_trigger_value();
 }
 
+static_assert(offsetof(PSMDS4RawSensorData, TimeInSeconds) >= sizeof(RawIMURawSensorSection),
+    "RawIMURawSensorSection must match the start of PSMDS4RawSensorData");
+static_assert(offsetof(PSMDS4CalibratedSensorData, TimeInSeconds) >= sizeof(RawIMUCalibratedSensorSection),
+    "RawIMUCalibratedSensorSection must match the start of PSMDS4CalibratedSensorData");
+
+static void applyRawDualShock4DataFrame(
+	const RawDualShock4DataFrame &raw_frame,
+	PSMDualShock4 *ds4)
+{
+    const unsigned int section_flags= raw_frame.header.section_flags;
+
+    ds4->bHasValidHardwareCalibration = (raw_frame.status_flags & RAW_DEVICE_STATUS_VALID_HARDWARE_CALIBRATION) != 0;
+    ds4->bIsTrackingEnabled = (raw_frame.status_flags & RAW_DEVICE_STATUS_TRACKING_ENABLED) != 0;
+    ds4->bIsCurrentlyTracking = (raw_frame.status_flags & RAW_DEVICE_STATUS_CURRENTLY_TRACKING) != 0;
+	ds4->bIsOrientationValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_ORIENTATION_VALID) != 0;
+	ds4->bIsPositionValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_POSITION_VALID) != 0;
+
+    memcpy(&ds4->Pose, &raw_frame.pose, sizeof(RawPosef));
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_PHYSICS) != 0)
+    {
+        memcpy(&ds4->PhysicsData, &raw_frame.physics_data, sizeof(RawPhysicsDataSection));
+    }
+    else
+    {
+        memset(&ds4->PhysicsData, 0, sizeof(PSMPhysicsData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_SENSOR) != 0)
+    {
+        memcpy(&ds4->RawSensorData, &raw_frame.raw_sensor_data, sizeof(RawIMURawSensorSection));
+    }
+    else
+    {
+		memset(&ds4->RawSensorData, 0, sizeof(PSMDS4RawSensorData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR) != 0)
+    {
+        memcpy(&ds4->CalibratedSensorData, &raw_frame.calibrated_sensor_data, sizeof(RawIMUCalibratedSensorSection));
+    }
+    else
+    {
+		memset(&ds4->CalibratedSensorData, 0, sizeof(PSMDS4CalibratedSensorData));
+    }
+
+    if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_TRACKER) != 0)
+    {
+        applyRawTrackerPointsData(
+            raw_frame.raw_tracker_data, raw_frame.raw_tracker_points, PSMTrackingProjection::PSMShape_LightBar, &ds4->RawTrackerData);
+    }
+    else
+    {
+		memset(&ds4->RawTrackerData, 0, sizeof(PSMRawTrackerData));
+    }
+
+	unsigned int button_bitmask = raw_frame.button_down_bitmask;
+	applyPSMButtonState(ds4->DPadUpButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_UP);
+	applyPSMButtonState(ds4->DPadDownButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_DOWN);
+	applyPSMButtonState(ds4->DPadLeftButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_LEFT);
+	applyPSMButtonState(ds4->DPadRightButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_RIGHT);
+	applyPSMButtonState(ds4->L1Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L1);
+	applyPSMButtonState(ds4->L2Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L2);
+	applyPSMButtonState(ds4->L3Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_L3);
+	applyPSMButtonState(ds4->R1Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R1);
+	applyPSMButtonState(ds4->R2Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R2);
+	applyPSMButtonState(ds4->R3Button, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_R3);
+	applyPSMButtonState(ds4->TriangleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRIANGLE);
+	applyPSMButtonState(ds4->CircleButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CIRCLE);
+	applyPSMButtonState(ds4->CrossButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_CROSS);
+	applyPSMButtonState(ds4->SquareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SQUARE);
+	applyPSMButtonState(ds4->ShareButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_SHARE);
+	applyPSMButtonState(ds4->OptionsButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_OPTIONS);
+	applyPSMButtonState(ds4->PSButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_PS);
+	applyPSMButtonState(ds4->TrackPadButton, button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_ButtonType_TRACKPAD);
+
+    ds4->LeftAnalogX = raw_frame.left_thumbstick_x;
+    ds4->LeftAnalogY = raw_frame.left_thumbstick_y;
+    ds4->RightAnalogX = raw_frame.right_thumbstick_x;
+    ds4->RightAnalogY = raw_frame.right_thumbstick_y;
+    ds4->LeftTriggerValue = raw_frame.left_trigger_value;
+    ds4->RightTriggerValue = raw_frame.right_trigger_value;
+}
+
+// Tracker data of the devices whose raw data frame has a RawTrackerPointsSection.
+// The projected points are either a DS4 light bar (triangle then quad) or a Morpheus point cloud.
+static void applyRawTrackerPointsData(
+    const RawTrackerDataSection &raw_tracker_data,
+    const RawTrackerPointsSection &raw_tracker_points,
+    PSMTrackingProjection::eShapeType points_shape_type,
+    PSMRawTrackerData *tracker_data)
+{
+    PSMTrackingProjection &projection = tracker_data->TrackingProjection;
+    const RawQuatf &relative_orientation = raw_tracker_points.relative_orientation;
+
+	tracker_data->TrackerID = raw_tracker_data.tracker_id;
+	tracker_data->ScreenLocation = { raw_tracker_data.screen_location_x, raw_tracker_data.screen_location_y };
+	tracker_data->RelativePositionCm = { 
+        raw_tracker_data.relative_position_cm.x, raw_tracker_data.relative_position_cm.y, raw_tracker_data.relative_position_cm.z };
+	tracker_data->RelativeOrientation = 
+        PSM_QuatfCreate(relative_orientation.w, relative_orientation.x, relative_orientation.y, relative_orientation.z);
+	tracker_data->ValidTrackerBitmask = raw_tracker_data.valid_tracker_bitmask;
+
+    if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_PROJECTED_POINTS_VALID) != 0 &&
+        points_shape_type == PSMTrackingProjection::PSMShape_LightBar)
+    {
+        for (int vert_index = 0; vert_index < 3; ++vert_index)
+        {
+            projection.shape.lightbar.triangle[vert_index] = { raw_tracker_points.points[vert_index].x, raw_tracker_points.points[vert_index].y };
+        }
+        for (int vert_index = 0; vert_index < 4; ++vert_index)
+        {
+            projection.shape.lightbar.quad[vert_index] = { raw_tracker_points.points[vert_index + 3].x, raw_tracker_points.points[vert_index + 3].y };
+        }
+        projection.shape_type = PSMTrackingProjection::PSMShape_LightBar;
+    }
+    else if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_PROJECTED_POINTS_VALID) != 0)
+    {
+        projection.shape.pointcloud.point_count = std::min(raw_tracker_points.point_count, RAW_TRACKER_MAX_PROJECTED_POINTS);
+        for (int point_index = 0; point_index < projection.shape.pointcloud.point_count; ++point_index)
+        {
+            projection.shape.pointcloud.points[point_index] = { raw_tracker_points.points[point_index].x, raw_tracker_points.points[point_index].y };
+        }
+        projection.shape_type = PSMTrackingProjection::PSMShape_PointCloud;
+    }
+    else if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_PROJECTED_SPHERE_VALID) != 0)
+    {
+		projection.shape.ellipse.center.x = raw_tracker_data.projected_sphere_center_x;
+		projection.shape.ellipse.center.y = raw_tracker_data.projected_sphere_center_y;
+		projection.shape.ellipse.half_x_extent = raw_tracker_data.projected_sphere_half_x_extent;
+		projection.shape.ellipse.half_y_extent = raw_tracker_data.projected_sphere_half_y_extent;
+		projection.shape.ellipse.angle = raw_tracker_data.projected_sphere_angle;
+		projection.shape_type = PSMTrackingProjection::PSMShape_Ellipse;
+    }
+    else
+    {
+		projection.shape_type = PSMTrackingProjection::PSMShape_INVALID_PROJECTION;
+    }
+
+    tracker_data->bMulticamPositionValid = (raw_tracker_data.valid_flags & RAW_TRACKER_DATA_MULTICAM_POSITION_VALID) != 0;
+    tracker_data->MulticamPositionCm = { 
+        raw_tracker_data.multicam_position_cm.x, raw_tracker_data.multicam_position_cm.y, raw_tracker_data.multicam_position_cm.z };
+
+    if ((raw_tracker_data.valid_flags & RAW_TRACKER_DATA_MULTICAM_ORIENTATION_VALID) != 0)
+    {
+        const RawQuatf &multicam_orientation = raw_tracker_points.multicam_orientation;
+
+        tracker_data->MulticamOrientation = 
+            PSM_QuatfCreate(multicam_orientation.w, multicam_orientation.x, multicam_orientation.y, multicam_orientation.z);
+        tracker_data->bMulticamOrientationValid = true;
+    }
+    else
+    {
+        tracker_data->MulticamOrientation = *k_psm_quaternion_identity;
+        tracker_data->bMulticamOrientationValid = false;
+    }
+}
+
 static void applyVirtualControllerDataFrame(
     const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet,
     PSMVirtualController *virtual_controller)
@@ -1752,9 +2407,6 @@ static void applyVirtualControllerDataFrame(
         virtual_controller->PhysicsData.AngularAccelerationRadPerSecSqr.x = 0.f;
         virtual_controller->PhysicsData.AngularAccelerationRadPerSecSqr.y = 0.f;
         virtual_controller->PhysicsData.AngularAccelerationRadPerSecSqr.z = 0.f;
-
-		//###HipsterSloth $TODO - pass down the physics data timestamp
-		virtual_controller->PhysicsData.TimeInSeconds= -1.0;
     }
     else
     {
@@ -1808,30 +2460,6 @@ static void applyVirtualControllerDataFrame(
 	}
 }
 
-static void applyPSMButtonState(
-    PSMButtonState &button,
-    unsigned int button_bitmask,
-    unsigned int button_bit)
-{
-    const bool is_down= (button_bitmask & (1 << button_bit)) > 0;
-
-    switch (button)
-    {
-    case PSMButtonState_UP:
-        button= is_down ? PSMButtonState_PRESSED : PSMButtonState_UP;
-        break;
-    case PSMButtonState_PRESSED:
-        button= is_down ? PSMButtonState_DOWN : PSMButtonState_RELEASED;
-        break;
-    case PSMButtonState_DOWN:
-        button= is_down ? PSMButtonState_DOWN : PSMButtonState_RELEASED;
-        break;
-    case PSMButtonState_RELEASED:
-        button= is_down ? PSMButtonState_PRESSED : PSMButtonState_UP;
-        break;
-    };
-}
-
 static void applyTrackerDataFrame(
 	const PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket& tracker_packet, 
 	PSMTracker *tracker)
@@ -1863,19 +2491,24 @@ static void applyTrackerDataFrame(
     }
 }
 
-static void applyHmdDataFrame(
-	const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, 
-	PSMHeadMountedDisplay *hmd)
+// Applies the fields common to every HMD data frame format.
+// Returns false if the rest of the data frame should be ignored.
+static bool applyHmdDataFrameHeader(
+    int hmd_id,
+    PSMHmdType hmd_type,
+    int sequence_num,
+    bool is_connected,
+    PSMHeadMountedDisplay *hmd)
 {
 	// Ignore old packets
-	if (hmd_packet.sequence_num() <= hmd->OutputSequenceNum)
-		return;
+	if (sequence_num <= hmd->OutputSequenceNum)
+		return false;
 
     // Set the generic items
-    hmd->bValid = hmd_packet.hmd_id() != -1;
-    hmd->HmdType = static_cast<PSMHmdType>(hmd_packet.hmd_type());
-    hmd->OutputSequenceNum = hmd_packet.sequence_num();
-    hmd->IsConnected = hmd_packet.isconnected();
+    hmd->bValid = hmd_id != -1;
+    hmd->HmdType = hmd_type;
+    hmd->OutputSequenceNum = sequence_num;
+    hmd->IsConnected = is_connected;
 
     // Compute the data frame receive window statistics if we have received enough samples
     {
@@ -1896,8 +2529,23 @@ static void applyHmdDataFrame(
     }
 
 	// Don't bother updating the rest of the hmd state if it's not connected
-	if (!hmd->IsConnected)
-		return;
+	return hmd->IsConnected;
+}
+
+static void applyHmdDataFrame(
+	const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, 
+	const ClientDataFrameTimes &times,
+	PSMHeadMountedDisplay *hmd)
+{
+    if (!applyHmdDataFrameHeader(
+            hmd_packet.hmd_id(),
+            static_cast<PSMHmdType>(hmd_packet.hmd_type()),
+            hmd_packet.sequence_num(),
+            hmd_packet.isconnected(),
+            hmd))
+    {
+        return;
+    }
 
     switch (hmd->HmdType) 
 	{
@@ -1910,6 +2558,112 @@ static void applyHmdDataFrame(
         default:
             break;
     }
+
+    applyHmdDataFrameTimes(times, hmd);
+}
+
+static_assert(offsetof(PSMMorpheusRawSensorData, TimeInSeconds) >= sizeof(RawIMURawSensorSection),
+    "RawIMURawSensorSection must match the start of PSMMorpheusRawSensorData");
+static_assert(offsetof(PSMMorpheusCalibratedSensorData, TimeInSeconds) >= sizeof(RawIMUCalibratedSensorSection),
+    "RawIMUCalibratedSensorSection must match the start of PSMMorpheusCalibratedSensorData");
+
+static void applyRawHmdDataFrame(
+	const RawHMDDataFrame &raw_frame, 
+	const ClientDataFrameTimes &times,
+	PSMHeadMountedDisplay *hmd)
+{
+    const unsigned int section_flags= raw_frame.header.section_flags;
+    const bool bIsMorpheus= raw_frame.header.device_type == PSMoveProtocol::Morpheus;
+
+    if (!applyHmdDataFrameHeader(
+            raw_frame.header.device_id,
+            bIsMorpheus ? PSMHmd_Morpheus : PSMHmd_Virtual,
+            raw_frame.header.sequence_num,
+            (raw_frame.status_flags & RAW_DEVICE_STATUS_CONNECTED) != 0,
+            hmd))
+    {
+        return;
+    }
+
+    if (bIsMorpheus)
+    {
+        PSMMorpheus *morpheus= &hmd->HmdState.MorpheusState;
+
+	    morpheus->bIsTrackingEnabled = (raw_frame.status_flags & RAW_DEVICE_STATUS_TRACKING_ENABLED) != 0;
+	    morpheus->bIsCurrentlyTracking = (raw_frame.status_flags & RAW_DEVICE_STATUS_CURRENTLY_TRACKING) != 0;
+	    morpheus->bIsOrientationValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_ORIENTATION_VALID) != 0;
+	    morpheus->bIsPositionValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_POSITION_VALID) != 0;
+
+        memcpy(&morpheus->Pose, &raw_frame.pose, sizeof(RawPosef));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_PHYSICS) != 0)
+            memcpy(&morpheus->PhysicsData, &raw_frame.physics_data, sizeof(RawPhysicsDataSection));
+        else
+            memset(&morpheus->PhysicsData, 0, sizeof(PSMPhysicsData));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_SENSOR) != 0)
+            memcpy(&morpheus->RawSensorData, &raw_frame.raw_sensor_data, sizeof(RawIMURawSensorSection));
+        else
+            memset(&morpheus->RawSensorData, 0, sizeof(PSMMorpheusRawSensorData));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR) != 0)
+            memcpy(&morpheus->CalibratedSensorData, &raw_frame.calibrated_sensor_data, sizeof(RawIMUCalibratedSensorSection));
+        else
+            memset(&morpheus->CalibratedSensorData, 0, sizeof(PSMMorpheusCalibratedSensorData));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_TRACKER) != 0)
+            applyRawTrackerPointsData(
+                raw_frame.raw_tracker_data, raw_frame.raw_tracker_points, PSMTrackingProjection::PSMShape_PointCloud, &morpheus->RawTrackerData);
+        else
+            memset(&morpheus->RawTrackerData, 0, sizeof(PSMRawTrackerData));
+    }
+    else
+    {
+        PSMVirtualHMD *virtualHMD= &hmd->HmdState.VirtualHMDState;
+
+	    virtualHMD->bIsTrackingEnabled = (raw_frame.status_flags & RAW_DEVICE_STATUS_TRACKING_ENABLED) != 0;
+	    virtualHMD->bIsCurrentlyTracking = (raw_frame.status_flags & RAW_DEVICE_STATUS_CURRENTLY_TRACKING) != 0;
+	    virtualHMD->bIsPositionValid = (raw_frame.status_flags & RAW_DEVICE_STATUS_POSITION_VALID) != 0;
+
+        // The service sends an identity orientation and no angular physics for virtual HMDs
+        memcpy(&virtualHMD->Pose, &raw_frame.pose, sizeof(RawPosef));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_PHYSICS) != 0)
+            memcpy(&virtualHMD->PhysicsData, &raw_frame.physics_data, sizeof(RawPhysicsDataSection));
+        else
+            memset(&virtualHMD->PhysicsData, 0, sizeof(PSMPhysicsData));
+
+        if ((section_flags & RAW_DATA_FRAME_SECTION_RAW_TRACKER) != 0)
+            applyRawTrackerPointsData(
+                raw_frame.raw_tracker_data, raw_frame.raw_tracker_points, PSMTrackingProjection::PSMShape_PointCloud, &virtualHMD->RawTrackerData);
+        else
+            memset(&virtualHMD->RawTrackerData, 0, sizeof(PSMRawTrackerData));
+    }
+
+    applyHmdDataFrameTimes(times, hmd);
+}
+
+static void applyHmdDataFrameTimes(
+    const ClientDataFrameTimes &times,
+    PSMHeadMountedDisplay *hmd)
+{
+    switch (hmd->HmdType)
+    {
+    case PSMHmd_Morpheus:
+        {
+            PSMMorpheus *morpheus= &hmd->HmdState.MorpheusState;
+
+            morpheus->PhysicsData.TimeInSeconds= times.pose_time_seconds;
+            morpheus->RawSensorData.TimeInSeconds= times.sample_time_seconds;
+            morpheus->CalibratedSensorData.TimeInSeconds= times.sample_time_seconds;
+        } break;
+    case PSMHmd_Virtual:
+        {
+            hmd->HmdState.VirtualHMDState.PhysicsData.TimeInSeconds= times.pose_time_seconds;
+        } break;
+    default:
+        break;
+    }
 }
 
 static void applyMorpheusDataFrame(
@@ -2114,6 +2868,216 @@ static void applyVirtualHMDDataFrame(
 	}
 }
 
+static void applySharedControllerPose(
+    const SharedPoseData &pose_data,
+    double pose_time_seconds,
+    PSMController *controller)
+{
+    const bool bIsTrackingEnabled= (pose_data.status_flags & SHARED_POSE_STATUS_TRACKING_ENABLED) != 0;
+    const bool bIsCurrentlyTracking= (pose_data.status_flags & SHARED_POSE_STATUS_CURRENTLY_TRACKING) != 0;
+    const bool bIsOrientationValid= (pose_data.status_flags & SHARED_POSE_STATUS_ORIENTATION_VALID) != 0;
+    const bool bIsPositionValid= (pose_data.status_flags & SHARED_POSE_STATUS_POSITION_VALID) != 0;
+
+    switch (controller->ControllerType)
+    {
+    case PSMController_Move:
+        {
+            PSMPSMove *psmove= &controller->ControllerState.PSMoveState;
+
+            psmove->bIsTrackingEnabled= bIsTrackingEnabled;
+            psmove->bIsCurrentlyTracking= bIsCurrentlyTracking;
+            psmove->bIsOrientationValid= bIsOrientationValid;
+            psmove->bIsPositionValid= bIsPositionValid;
+            memcpy(&psmove->Pose, &pose_data.pose, sizeof(RawPosef));
+            memcpy(&psmove->PhysicsData, &pose_data.physics_data, sizeof(RawPhysicsDataSection));
+            psmove->PhysicsData.TimeInSeconds= pose_time_seconds;
+        } break;
+    case PSMController_DualShock4:
+        {
+            PSMDualShock4 *ds4= &controller->ControllerState.PSDS4State;
+
+            ds4->bIsTrackingEnabled= bIsTrackingEnabled;
+            ds4->bIsCurrentlyTracking= bIsCurrentlyTracking;
+            ds4->bIsOrientationValid= bIsOrientationValid;
+            ds4->bIsPositionValid= bIsPositionValid;
+            memcpy(&ds4->Pose, &pose_data.pose, sizeof(RawPosef));
+            memcpy(&ds4->PhysicsData, &pose_data.physics_data, sizeof(RawPhysicsDataSection));
+            ds4->PhysicsData.TimeInSeconds= pose_time_seconds;
+        } break;
+    case PSMController_Virtual:
+        {
+            PSMVirtualController *virtual_controller= &controller->ControllerState.VirtualController;
+
+            // Virtual controllers only have a position (the data frames report an identity orientation)
+            virtual_controller->bIsTrackingEnabled= bIsTrackingEnabled;
+            virtual_controller->bIsCurrentlyTracking= bIsCurrentlyTracking;
+            virtual_controller->bIsPositionValid= bIsPositionValid;
+            memcpy(&virtual_controller->Pose.Position, &pose_data.pose.position_cm, sizeof(RawVector3f));
+            memcpy(&virtual_controller->PhysicsData.LinearVelocityCmPerSec, &pose_data.physics_data.velocity_cm_per_sec, sizeof(RawVector3f));
+            memcpy(&virtual_controller->PhysicsData.LinearAccelerationCmPerSecSqr, &pose_data.physics_data.acceleration_cm_per_sec_sqr, sizeof(RawVector3f));
+            virtual_controller->PhysicsData.TimeInSeconds= pose_time_seconds;
+        } break;
+    default:
+        // No pose (i.e. the navi controller)
+        break;
+    }
+}
+
+static void applySharedHmdPose(
+    const SharedPoseData &pose_data,
+    double pose_time_seconds,
+    PSMHeadMountedDisplay *hmd)
+{
+    const bool bIsTrackingEnabled= (pose_data.status_flags & SHARED_POSE_STATUS_TRACKING_ENABLED) != 0;
+    const bool bIsCurrentlyTracking= (pose_data.status_flags & SHARED_POSE_STATUS_CURRENTLY_TRACKING) != 0;
+    const bool bIsOrientationValid= (pose_data.status_flags & SHARED_POSE_STATUS_ORIENTATION_VALID) != 0;
+    const bool bIsPositionValid= (pose_data.status_flags & SHARED_POSE_STATUS_POSITION_VALID) != 0;
+
+    switch (hmd->HmdType)
+    {
+    case PSMHmd_Morpheus:
+        {
+            PSMMorpheus *morpheus= &hmd->HmdState.MorpheusState;
+
+            morpheus->bIsTrackingEnabled= bIsTrackingEnabled;
+            morpheus->bIsCurrentlyTracking= bIsCurrentlyTracking;
+            morpheus->bIsOrientationValid= bIsOrientationValid;
+            morpheus->bIsPositionValid= bIsPositionValid;
+            memcpy(&morpheus->Pose, &pose_data.pose, sizeof(RawPosef));
+            memcpy(&morpheus->PhysicsData, &pose_data.physics_data, sizeof(RawPhysicsDataSection));
+            morpheus->PhysicsData.TimeInSeconds= pose_time_seconds;
+        } break;
+    case PSMHmd_Virtual:
+        {
+            PSMVirtualHMD *virtualHMD= &hmd->HmdState.VirtualHMDState;
+
+            // Virtual HMDs only have a position (the data frames report an identity orientation)
+            virtualHMD->bIsTrackingEnabled= bIsTrackingEnabled;
+            virtualHMD->bIsCurrentlyTracking= bIsCurrentlyTracking;
+            virtualHMD->bIsPositionValid= bIsPositionValid;
+            memcpy(&virtualHMD->Pose.Position, &pose_data.pose.position_cm, sizeof(RawVector3f));
+            memcpy(&virtualHMD->PhysicsData.LinearVelocityCmPerSec, &pose_data.physics_data.velocity_cm_per_sec, sizeof(RawVector3f));
+            memcpy(&virtualHMD->PhysicsData.LinearAccelerationCmPerSecSqr, &pose_data.physics_data.acceleration_cm_per_sec_sqr, sizeof(RawVector3f));
+            virtualHMD->PhysicsData.TimeInSeconds= pose_time_seconds;
+        } break;
+    default:
+        break;
+    }
+}
+
+// The reverse of applySharedControllerPose().
+// Returns false if the controller has no pose (i.e. the navi controller).
+static bool getControllerPoseSnapshot(
+    const PSMController *controller,
+    SharedPoseData &out_pose_data)
+{
+    memset(&out_pose_data, 0, sizeof(SharedPoseData));
+    out_pose_data.device_type= static_cast<int32_t>(controller->ControllerType);
+    out_pose_data.sequence_num= controller->OutputSequenceNum;
+
+    switch (controller->ControllerType)
+    {
+    case PSMController_Move:
+        {
+            const PSMPSMove *psmove= &controller->ControllerState.PSMoveState;
+
+            out_pose_data.status_flags= makeSharedPoseStatusFlags(
+                controller->IsConnected, psmove->bIsTrackingEnabled, psmove->bIsCurrentlyTracking,
+                psmove->bIsOrientationValid, psmove->bIsPositionValid);
+            memcpy(&out_pose_data.pose, &psmove->Pose, sizeof(RawPosef));
+            memcpy(&out_pose_data.physics_data, &psmove->PhysicsData, sizeof(RawPhysicsDataSection));
+            out_pose_data.pose_time_seconds= psmove->PhysicsData.TimeInSeconds;
+        } return true;
+    case PSMController_DualShock4:
+        {
+            const PSMDualShock4 *ds4= &controller->ControllerState.PSDS4State;
+
+            out_pose_data.status_flags= makeSharedPoseStatusFlags(
+                controller->IsConnected, ds4->bIsTrackingEnabled, ds4->bIsCurrentlyTracking,
+                ds4->bIsOrientationValid, ds4->bIsPositionValid);
+            memcpy(&out_pose_data.pose, &ds4->Pose, sizeof(RawPosef));
+            memcpy(&out_pose_data.physics_data, &ds4->PhysicsData, sizeof(RawPhysicsDataSection));
+            out_pose_data.pose_time_seconds= ds4->PhysicsData.TimeInSeconds;
+        } return true;
+    case PSMController_Virtual:
+        {
+            const PSMVirtualController *virtual_controller= &controller->ControllerState.VirtualController;
+
+            out_pose_data.status_flags= makeSharedPoseStatusFlags(
+                controller->IsConnected, virtual_controller->bIsTrackingEnabled, virtual_controller->bIsCurrentlyTracking,
+                false, virtual_controller->bIsPositionValid);
+            memcpy(&out_pose_data.pose, &virtual_controller->Pose, sizeof(RawPosef));
+            memcpy(&out_pose_data.physics_data.velocity_cm_per_sec, &virtual_controller->PhysicsData.LinearVelocityCmPerSec, sizeof(RawVector3f));
+            memcpy(&out_pose_data.physics_data.acceleration_cm_per_sec_sqr, &virtual_controller->PhysicsData.LinearAccelerationCmPerSecSqr, sizeof(RawVector3f));
+            out_pose_data.pose_time_seconds= virtual_controller->PhysicsData.TimeInSeconds;
+        } return true;
+    default:
+        return false;
+    }
+}
+
+// The reverse of applySharedHmdPose()
+static bool getHmdPoseSnapshot(
+    const PSMHeadMountedDisplay *hmd,
+    SharedPoseData &out_pose_data)
+{
+    memset(&out_pose_data, 0, sizeof(SharedPoseData));
+    out_pose_data.device_type= static_cast<int32_t>(hmd->HmdType);
+    out_pose_data.sequence_num= hmd->OutputSequenceNum;
+
+    switch (hmd->HmdType)
+    {
+    case PSMHmd_Morpheus:
+        {
+            const PSMMorpheus *morpheus= &hmd->HmdState.MorpheusState;
+
+            out_pose_data.status_flags= makeSharedPoseStatusFlags(
+                hmd->IsConnected, morpheus->bIsTrackingEnabled, morpheus->bIsCurrentlyTracking,
+                morpheus->bIsOrientationValid, morpheus->bIsPositionValid);
+            memcpy(&out_pose_data.pose, &morpheus->Pose, sizeof(RawPosef));
+            memcpy(&out_pose_data.physics_data, &morpheus->PhysicsData, sizeof(RawPhysicsDataSection));
+            out_pose_data.pose_time_seconds= morpheus->PhysicsData.TimeInSeconds;
+        } return true;
+    case PSMHmd_Virtual:
+        {
+            const PSMVirtualHMD *virtualHMD= &hmd->HmdState.VirtualHMDState;
+
+            out_pose_data.status_flags= makeSharedPoseStatusFlags(
+                hmd->IsConnected, virtualHMD->bIsTrackingEnabled, virtualHMD->bIsCurrentlyTracking,
+                false, virtualHMD->bIsPositionValid);
+            memcpy(&out_pose_data.pose, &virtualHMD->Pose, sizeof(RawPosef));
+            memcpy(&out_pose_data.physics_data.velocity_cm_per_sec, &virtualHMD->PhysicsData.LinearVelocityCmPerSec, sizeof(RawVector3f));
+            memcpy(&out_pose_data.physics_data.acceleration_cm_per_sec_sqr, &virtualHMD->PhysicsData.LinearAccelerationCmPerSecSqr, sizeof(RawVector3f));
+            out_pose_data.pose_time_seconds= virtualHMD->PhysicsData.TimeInSeconds;
+        } return true;
+    default:
+        return false;
+    }
+}
+
+static uint32_t makeSharedPoseStatusFlags(
+    bool bIsConnected,
+    bool bIsTrackingEnabled,
+    bool bIsCurrentlyTracking,
+    bool bIsOrientationValid,
+    bool bIsPositionValid)
+{
+    return
+        (bIsConnected ? SHARED_POSE_STATUS_CONNECTED : 0) |
+        (bIsTrackingEnabled ? SHARED_POSE_STATUS_TRACKING_ENABLED : 0) |
+        (bIsCurrentlyTracking ? SHARED_POSE_STATUS_CURRENTLY_TRACKING : 0) |
+        (bIsOrientationValid ? SHARED_POSE_STATUS_ORIENTATION_VALID : 0) |
+        (bIsPositionValid ? SHARED_POSE_STATUS_POSITION_VALID : 0);
+}
+
+static bool isLoopbackHost(const std::string &host)
+{
+    boost::system::error_code ec;
+    const boost::asio::ip::address address= boost::asio::ip::address::from_string(host, ec);
+
+    return (!ec) ? address.is_loopback() : (host == "localhost");
+}
+
 // INotificationListener
 void PSMoveClient::handle_notification(ResponsePtr notification)
 {
@@ -2146,6 +3110,11 @@ void PSMoveClient::handle_server_connection_opened()
 {
     CLIENT_LOG_INFO("handle_server_connection_opened") << "Connected to service" << std::endl;
 
+    if ((m_connection_options & PSMConnectionOptions_sharedMemoryPoses) != 0)
+    {
+        open_shared_pose_table();
+    }
+
     enqueue_event_message(PSMEventMessage::PSMEvent_connectedToService, ResponsePtr());
 }
 
@@ -2160,6 +3129,8 @@ void PSMoveClient::handle_server_connection_closed()
 {
     CLIENT_LOG_INFO("handle_server_connection_closed") << "Disconnected from service" << std::endl;
 
+    close_shared_pose_table();
+
     enqueue_event_message(PSMEventMessage::PSMEvent_disconnectedFromService, ResponsePtr());
 }
 
@@ -6,6 +6,7 @@
 #include "PSMoveProtocolInterface.h"
 #include "ClientNetworkInterface.h"
 #include "ClientLog.h"
+#include "SharedPoseState.h"
 #include <deque>
 #include <map>
 #include <vector>
@@ -18,12 +19,14 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 class PSMoveClient : 
     public IDataFrameListener,
     public INotificationListener,
-    public IClientNetworkEventListener
+    public IClientNetworkEventListener,
+    public IDataFrameSnapshotListener
 {
 public:
     PSMoveClient(
         const std::string &host, 
-        const std::string &port);
+        const std::string &port,
+        unsigned int connection_options= PSMConnectionOptions_defaults);
     virtual ~PSMoveClient();
 
 	// -- State Queries ----
@@ -37,6 +40,7 @@ public:
     // -- ClientPSMoveAPI System -----
     bool startup(e_log_severity_level log_level);
     void update();
+    void wait_for_network_activity(int timeout_ms);
 	void process_messages();
     bool poll_next_message(PSMMessage *message, size_t message_size);
     void shutdown();
@@ -48,7 +52,11 @@ public:
     bool allocate_controller_listener(PSMControllerID controller_id);
     void free_controller_listener(PSMControllerID controller_id);   
     PSMController* get_controller_view(PSMControllerID controller_id);
+    bool get_controller_pose_snapshot(PSMControllerID controller_id, SharedPoseData &out_pose_data) const;
+    // The snapshot with the network thread, the controller view otherwise. pose_time_seconds is on the client clock.
+    bool get_latest_controller_pose(PSMControllerID controller_id, SharedPoseData &out_pose_data) const;
     PSMRequestID get_controller_list();
+    bool set_controller_data_stream_rate_limit(PSMControllerID controller_id, const PSMDataStreamRateLimit &rate_limit);
     PSMRequestID start_controller_data_stream(PSMControllerID controller_id, unsigned int flags);
     PSMRequestID stop_controller_data_stream(PSMControllerID controller_id);
     PSMRequestID set_led_tracking_color(PSMControllerID controller_id, PSMTrackingColorType tracking_color);
@@ -66,11 +74,17 @@ public:
 	bool poll_video_stream(PSMTrackerID tracker_id);
 	void close_video_stream(PSMTrackerID tracker_id);
 	const unsigned char *get_video_frame_buffer(PSMTrackerID tracker_id) const;
+	const unsigned char *get_video_frame_buffer_no_copy(PSMTrackerID tracker_id, int &out_frame_index) const;
+	bool get_is_video_frame_intact(PSMTrackerID tracker_id, int frame_index) const;
 
     bool allocate_hmd_listener(PSMHmdID HmdID);
     void free_hmd_listener(PSMHmdID HmdID);   
 	PSMHeadMountedDisplay* get_hmd_view(PSMHmdID tracker_id);
+    bool get_hmd_pose_snapshot(PSMHmdID hmd_id, SharedPoseData &out_pose_data) const;
+    // The snapshot with the network thread, the HMD view otherwise. pose_time_seconds is on the client clock.
+    bool get_latest_hmd_pose(PSMHmdID hmd_id, SharedPoseData &out_pose_data) const;
     PSMRequestID get_hmd_list();    
+    bool set_hmd_data_stream_rate_limit(PSMHmdID hmd_id, const PSMDataStreamRateLimit &rate_limit);
     PSMRequestID start_hmd_data_stream(PSMHmdID hmd_id, unsigned int flags);
     PSMRequestID stop_hmd_data_stream(PSMHmdID hmd_id);
     PSMRequestID set_hmd_data_stream_tracker_index(PSMHmdID hmd_id, PSMTrackerID tracker_id);
@@ -83,9 +97,24 @@ public:
     
 protected:
     void publish();
+    void open_shared_pose_table();
+    void close_shared_pose_table();
+    void update_shared_poses();
+
+    // Converts a service clock time stamp to the client clock (-1 if unknown yet)
+    double to_client_time_seconds(double service_time_seconds) const;
+    struct ClientDataFrameTimes get_data_frame_times(double service_sample_time_seconds, double service_pose_time_seconds) const;
+
+    // Applies a raw data frame to its device in the given controller and HMD pools.
+    // Returns false for raw data frames of device types without a raw layout.
+    bool apply_raw_data_frame(
+        const uint8_t *data_frame, size_t data_frame_size,
+        PSMController *controllers, PSMHeadMountedDisplay *hmds,
+        RawDataFrameHeader &out_header) const;
 
     // IDataFrameListener
     virtual void handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) override;
+    virtual void handle_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size) override;
 
     // INotificationListener
     virtual void handle_notification(ResponsePtr notification) override;
@@ -97,6 +126,10 @@ protected:
     virtual void handle_server_connection_close_failed(const boost::system::error_code& ec) override;
     virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) override;
 
+    // IDataFrameSnapshotListener
+    virtual void snapshot_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) override;
+    virtual void snapshot_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size) override;
+
     // Request Manager Callback
     static void handle_response_message(const PSMResponseMessage *response_message, void *userdata);
 
@@ -113,6 +146,11 @@ private:
     
     //-- Session Management -----
     class ClientNetworkManager *m_network_manager;
+    std::string m_host;
+    unsigned int m_connection_options; // PSMConnectionOptionFlags bitmask
+
+    //-- Same-host Pose Table (nullptr when unused) -----
+    class SharedPoseTableReadOnlyAccessor *m_shared_pose_table;
     
     //-- Controller Views -----
 	PSMController m_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
@@ -123,6 +161,18 @@ private:
     //-- HMD Views -----
 	PSMHeadMountedDisplay m_HMDs[PSMOVESERVICE_MAX_HMD_COUNT];
 
+    //-- Stream Rate Limits (sent along with the next stream start request) -----
+    PSMDataStreamRateLimit m_controller_stream_rate_limits[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    PSMDataStreamRateLimit m_hmd_stream_rate_limits[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    //-- Pose Snapshots (PSMConnectionOptions_networkThread) -----
+    // Device views only the network thread applies data frames to, to pull the poses out of
+    PSMController m_snapshot_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    PSMHeadMountedDisplay m_snapshot_HMDs[PSMOVESERVICE_MAX_HMD_COUNT];
+    // Newest poses, written by the network thread and read from any thread
+    SharedPoseSlot m_controller_pose_snapshots[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    SharedPoseSlot m_hmd_pose_snapshots[PSMOVESERVICE_MAX_HMD_COUNT];
+
 	bool m_bIsConnected;
 	bool m_bHasConnectionStatusChanged;
 	bool m_bHasControllerListChanged;
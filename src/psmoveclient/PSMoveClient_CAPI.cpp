@@ -1,6 +1,7 @@
 // -- includes -----
 #include "PSMoveClient_CAPI.h"
 #include "PSMoveClient.h"
+#include "ClientClockOffsetEstimator.h"
 #include "ClientLog.h"
 #include "ClientNetworkInterface.h"
 #include "MathUtility.h"
@@ -8,6 +9,9 @@
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <map>
 #include <assert.h>
 
@@ -23,6 +27,9 @@
 // -- constants ----
 const PSMVector3f k_identity_gravity_calibration_direction= {0.f, 1.f, 0.f};
 
+// Keeps PSM_Get*PoseAtTime() from flinging a stale pose far off
+const double k_max_pose_extrapolation_seconds= 0.1;
+
 // -- private data ---
 PSMoveClient *g_psm_client= nullptr;
 
@@ -44,6 +51,14 @@ public:
         return timeSinceStart > m_duration;
     }
 
+    int RemainingMilliseconds() const
+    {
+        std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+        std::chrono::duration<float, std::milli> timeSinceStart= now - m_startTime;
+
+        return static_cast<int>(std::ceil(std::max(m_duration.count() - timeSinceStart.count(), 0.f)));
+    }
+
 private:
     std::chrono::time_point<std::chrono::high_resolution_clock> m_startTime;
     std::chrono::duration<float, std::milli> m_duration;
@@ -82,13 +97,15 @@ public:
     
 			while (!m_bReceived && !timeout.HasElapsed())
 			{
-				_PAUSE(10);
+				// Sleep until the network layer handles something rather than for a fixed interval.
+				// The response callback runs as soon as the response is parsed, ending the loop.
+				g_psm_client->wait_for_network_activity(timeout.RemainingMilliseconds());
 
 				// Process responses, events and controller updates from the service
 				PSM_Update();
 			}
 
-			if (timeout.HasElapsed())
+			if (!m_bReceived)
 			{
 				g_psm_client->cancel_callback(m_request_id);
 				result= PSMResult_Timeout;
@@ -120,6 +137,83 @@ protected:
     PSMResponseMessage m_response;
 };
 
+// -- private methods -----
+// Pose getters for the poses published by the client network thread (PSMConnectionOptions_networkThread)
+static PSMResult getPoseSnapshotOrientation(const SharedPoseData &pose_snapshot, PSMQuatf *out_orientation)
+{
+    memcpy(out_orientation, &pose_snapshot.pose.orientation, sizeof(PSMQuatf));
+
+    return (pose_snapshot.status_flags & SHARED_POSE_STATUS_ORIENTATION_VALID) != 0 ? PSMResult_Success : PSMResult_Error;
+}
+
+static PSMResult getPoseSnapshotPosition(const SharedPoseData &pose_snapshot, PSMVector3f *out_position)
+{
+    memcpy(out_position, &pose_snapshot.pose.position_cm, sizeof(PSMVector3f));
+
+    return (pose_snapshot.status_flags & SHARED_POSE_STATUS_POSITION_VALID) != 0 ? PSMResult_Success : PSMResult_Error;
+}
+
+static PSMResult getPoseSnapshotPose(const SharedPoseData &pose_snapshot, bool bHasOrientation, PSMPosef *out_pose)
+{
+    const bool bIsOrientationValid= (pose_snapshot.status_flags & SHARED_POSE_STATUS_ORIENTATION_VALID) != 0;
+    const bool bIsPositionValid= (pose_snapshot.status_flags & SHARED_POSE_STATUS_POSITION_VALID) != 0;
+
+    memcpy(&out_pose->Position, &pose_snapshot.pose.position_cm, sizeof(PSMVector3f));
+    memcpy(&out_pose->Orientation, &pose_snapshot.pose.orientation, sizeof(PSMQuatf));
+
+    // Position only devices (virtual controllers and HMDs) just need a valid position
+    return (bIsPositionValid && (bIsOrientationValid || !bHasOrientation)) ? PSMResult_Success : PSMResult_Error;
+}
+
+// Extrapolates a pose (with its client clock time) to the target time.
+// Assumes constant acceleration and angular acceleration over the interval.
+static PSMResult getPoseSnapshotPoseAtTime(
+    const SharedPoseData &pose_snapshot, bool bHasOrientation, double target_time, PSMPosef *out_pose)
+{
+    PSMResult result= getPoseSnapshotPose(pose_snapshot, bHasOrientation, out_pose);
+
+    if (result == PSMResult_Success && pose_snapshot.pose_time_seconds <= 0.0)
+    {
+        result= PSMResult_NoData;
+    }
+    else if (result == PSMResult_Success)
+    {
+        const double unclamped_dt= target_time - pose_snapshot.pose_time_seconds;
+        const float dt= static_cast<float>(
+            std::max(-k_max_pose_extrapolation_seconds, std::min(unclamped_dt, k_max_pose_extrapolation_seconds)));
+        PSMVector3f velocity, acceleration, angular_velocity, angular_acceleration;
+
+        memcpy(&velocity, &pose_snapshot.physics_data.velocity_cm_per_sec, sizeof(PSMVector3f));
+        memcpy(&acceleration, &pose_snapshot.physics_data.acceleration_cm_per_sec_sqr, sizeof(PSMVector3f));
+        memcpy(&angular_velocity, &pose_snapshot.physics_data.angular_velocity_rad_per_sec, sizeof(PSMVector3f));
+        memcpy(&angular_acceleration, &pose_snapshot.physics_data.angular_acceleration_rad_per_sec_sqr, sizeof(PSMVector3f));
+
+        // p(t) = p + v*t + a*t^2/2
+        const PSMVector3f average_velocity= PSM_Vector3fScaleAndAdd(&acceleration, 0.5f*dt, &velocity);
+        out_pose->Position= PSM_Vector3fScaleAndAdd(&average_velocity, dt, &out_pose->Position);
+
+        if (bHasOrientation)
+        {
+            // Rotate by the average angular velocity over the interval.
+            // Same (body frame) convention as the service's orientation prediction: q' = q*w/2
+            const PSMVector3f average_angular_velocity= 
+                PSM_Vector3fScaleAndAdd(&angular_acceleration, 0.5f*dt, &angular_velocity);
+            float angular_speed;
+            const PSMVector3f axis= 
+                PSM_Vector3fNormalizeWithDefaultGetLength(&average_angular_velocity, k_psm_float_vector3_zero, &angular_speed);
+            const float half_angle= 0.5f*angular_speed*dt;
+            const float sin_half_angle= sinf(half_angle);
+            const PSMQuatf delta_rotation= 
+                PSM_QuatfCreate(cosf(half_angle), axis.x*sin_half_angle, axis.y*sin_half_angle, axis.z*sin_half_angle);
+            const PSMQuatf unnormalized_orientation= PSM_QuatfMultiply(&out_pose->Orientation, &delta_rotation);
+
+            out_pose->Orientation= PSM_QuatfNormalizeWithDefault(&unnormalized_orientation, &out_pose->Orientation);
+        }
+    }
+
+    return result;
+}
+
 // -- public interface -----
 const char* PSM_GetClientVersionString()
 {
@@ -163,17 +257,28 @@ bool PSM_WasSystemButtonPressed()
 	return g_psm_client != nullptr && g_psm_client->pollWasSystemButtonPressed();
 }
 
+double PSM_GetClientTimeInSeconds()
+{
+    return ClientClockOffsetEstimator::get_client_time_seconds();
+}
+
 PSMResult PSM_Initialize(const char* host, const char* port, int timeout_ms)
+{
+    return PSM_InitializeWithOptions(host, port, timeout_ms, PSMConnectionOptions_defaults);
+}
+
+PSMResult PSM_InitializeWithOptions(const char* host, const char* port, int timeout_ms, unsigned int connection_options)
 {
     PSMResult result = PSMResult_Error;
 
-    if (PSM_InitializeAsync(host, port) != PSMResult_Error)
+    if (PSM_InitializeWithOptionsAsync(host, port, connection_options) != PSMResult_Error)
     {
         PSMCallbackTimeout timeout(timeout_ms);
 
         while (!g_psm_client->pollHasConnectionStatusChanged() && !timeout.HasElapsed())
         {
-            _PAUSE(10);
+            // Wakes up as soon as the connection attempt completes (or fails)
+            g_psm_client->wait_for_network_activity(timeout.RemainingMilliseconds());
 			g_psm_client->update();
 			g_psm_client->process_messages();
         }
@@ -192,6 +297,11 @@ PSMResult PSM_Initialize(const char* host, const char* port, int timeout_ms)
 }
 
 PSMResult PSM_InitializeAsync(const char* host, const char* port)
+{
+    return PSM_InitializeWithOptionsAsync(host, port, PSMConnectionOptions_defaults);
+}
+
+PSMResult PSM_InitializeWithOptionsAsync(const char* host, const char* port, unsigned int connection_options)
 {
 	PSMResult result= PSMResult_Error;
 
@@ -202,7 +312,7 @@ PSMResult PSM_InitializeAsync(const char* host, const char* port)
 			std::string s_host(host);
 			std::string s_port(port);
 
-			g_psm_client= new PSMoveClient(s_host, s_port);
+			g_psm_client= new PSMoveClient(s_host, s_port, connection_options);
 		}
 
 		if (g_psm_client->startup(_log_severity_level_info))
@@ -411,6 +521,24 @@ PSMResult PSM_StartControllerDataStream(PSMControllerID controller_id, unsigned
     return result_code;
 }
 
+PSMResult PSM_SetControllerDataStreamRateLimit(PSMControllerID controller_id, const PSMDataStreamRateLimit *rate_limit)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+        PSMDataStreamRateLimit no_rate_limit;
+        memset(&no_rate_limit, 0, sizeof(PSMDataStreamRateLimit));
+
+        if (g_psm_client->set_controller_data_stream_rate_limit(controller_id, (rate_limit != nullptr) ? *rate_limit : no_rate_limit))
+        {
+            result_code= PSMResult_Success;
+        }
+    }
+
+    return result_code;
+}
+
 PSMResult PSM_StopControllerDataStreamAsync(PSMControllerID controller_id, PSMRequestID *out_request_id)
 {
     PSMResult result_code= PSMResult_Error;
@@ -620,7 +748,13 @@ PSMResult PSM_GetControllerOrientation(PSMControllerID controller_id, PSMQuatf *
     PSMResult result= PSMResult_Error;
 	assert(out_orientation);
 
-    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_controller_pose_snapshot(controller_id, pose_snapshot))
+    {
+        result= getPoseSnapshotOrientation(pose_snapshot, out_orientation);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
     {
         PSMController *controller= g_psm_client->get_controller_view(controller_id);
         
@@ -655,7 +789,13 @@ PSMResult PSM_GetControllerPosition(PSMControllerID controller_id, PSMVector3f *
     PSMResult result= PSMResult_Error;
 	assert(out_position);
 
-    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_controller_pose_snapshot(controller_id, pose_snapshot))
+    {
+        result= getPoseSnapshotPosition(pose_snapshot, out_position);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
     {
         PSMController *controller= g_psm_client->get_controller_view(controller_id);
         
@@ -695,7 +835,13 @@ PSMResult PSM_GetControllerPose(PSMControllerID controller_id, PSMPosef *out_pos
     PSMResult result= PSMResult_Error;
 	assert(out_pose);
 
-    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_controller_pose_snapshot(controller_id, pose_snapshot))
+    {
+        result= getPoseSnapshotPose(pose_snapshot, pose_snapshot.device_type != PSMController_Virtual, out_pose);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
     {
         PSMController *controller= g_psm_client->get_controller_view(controller_id);
         
@@ -730,6 +876,21 @@ PSMResult PSM_GetControllerPose(PSMControllerID controller_id, PSMPosef *out_pos
     return result;
 }
 
+PSMResult PSM_GetControllerPoseAtTime(PSMControllerID controller_id, double target_time, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    SharedPoseData pose_data;
+
+    if (g_psm_client != nullptr && g_psm_client->get_latest_controller_pose(controller_id, pose_data))
+    {
+        result= getPoseSnapshotPoseAtTime(pose_data, pose_data.device_type != PSMController_Virtual, target_time, out_pose);
+    }
+
+    return result;
+}
+
 PSMResult PSM_GetIsControllerStable(PSMControllerID controller_id, bool *out_is_stable)
 {
     PSMResult result= PSMResult_Error;
@@ -1195,6 +1356,43 @@ PSMResult PSM_GetTrackerVideoFrameBuffer(PSMTrackerID tracker_id, const unsigned
     return result;
 }
 
+PSMResult PSM_GetTrackerVideoFrameBufferNoCopy(PSMTrackerID tracker_id, const unsigned char **out_buffer, int *out_frame_index)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_buffer != nullptr);
+	assert(out_frame_index != nullptr);
+
+    if (g_psm_client != nullptr && IS_VALID_TRACKER_INDEX(tracker_id))
+    {
+		int frame_index= 0;
+        const unsigned char *buffer= g_psm_client->get_video_frame_buffer_no_copy(tracker_id, frame_index);
+		if (buffer != nullptr)
+		{
+			*out_buffer= buffer;
+			*out_frame_index= frame_index;
+			result= PSMResult_Success;
+		}
+		else
+		{
+			result= PSMResult_NoData;
+		}
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetTrackerVideoFrameBufferIsIntact(PSMTrackerID tracker_id, int frame_index)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && IS_VALID_TRACKER_INDEX(tracker_id))
+    {
+		result= g_psm_client->get_is_video_frame_intact(tracker_id, frame_index) ? PSMResult_Success : PSMResult_NoData;
+    }
+
+    return result;
+}
+
 PSMResult PSM_GetTrackerFrustum(PSMTrackerID tracker_id, PSMFrustum *out_frustum)
 {
     PSMResult result= PSMResult_Error;
@@ -1329,7 +1527,13 @@ PSMResult PSM_GetHmdOrientation(PSMHmdID hmd_id, PSMQuatf *out_orientation)
     PSMResult result= PSMResult_Error;
 	assert(out_orientation);
 
-    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_hmd_pose_snapshot(hmd_id, pose_snapshot))
+    {
+        result= getPoseSnapshotOrientation(pose_snapshot, out_orientation);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
     {		
         PSMHeadMountedDisplay *hmd= g_psm_client->get_hmd_view(hmd_id);
         
@@ -1357,7 +1561,13 @@ PSMResult PSM_GetHmdPosition(PSMHmdID hmd_id, PSMVector3f *out_position)
     PSMResult result= PSMResult_Error;
 	assert(out_position);
 
-    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_hmd_pose_snapshot(hmd_id, pose_snapshot))
+    {
+        result= getPoseSnapshotPosition(pose_snapshot, out_position);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
     {
         PSMHeadMountedDisplay *hmd= g_psm_client->get_hmd_view(hmd_id);
         
@@ -1388,7 +1598,13 @@ PSMResult PSM_GetHmdPose(PSMHmdID hmd_id, PSMPosef *out_pose)
     PSMResult result= PSMResult_Error;
 	assert(out_pose);
 
-    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    SharedPoseData pose_snapshot;
+
+    if (g_psm_client != nullptr && g_psm_client->get_hmd_pose_snapshot(hmd_id, pose_snapshot))
+    {
+        result= getPoseSnapshotPose(pose_snapshot, pose_snapshot.device_type != PSMHmd_Virtual, out_pose);
+    }
+    else if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
     {
         PSMHeadMountedDisplay *hmd= g_psm_client->get_hmd_view(hmd_id);
         
@@ -1414,6 +1630,21 @@ PSMResult PSM_GetHmdPose(PSMHmdID hmd_id, PSMPosef *out_pose)
     return result;
 }
 
+PSMResult PSM_GetHmdPoseAtTime(PSMHmdID hmd_id, double target_time, PSMPosef *out_pose)
+{
+    PSMResult result= PSMResult_Error;
+	assert(out_pose);
+
+    SharedPoseData pose_data;
+
+    if (g_psm_client != nullptr && g_psm_client->get_latest_hmd_pose(hmd_id, pose_data))
+    {
+        result= getPoseSnapshotPoseAtTime(pose_data, pose_data.device_type != PSMHmd_Virtual, target_time, out_pose);
+    }
+
+    return result;
+}
+
 PSMResult PSM_GetIsHmdStable(PSMHmdID hmd_id, bool *out_is_stable)
 {
     PSMResult result= PSMResult_Error;
@@ -1649,6 +1880,24 @@ PSMResult PSM_StartHmdDataStream(PSMHmdID hmd_id, unsigned int data_stream_flags
     return result;
 }
 
+PSMResult PSM_SetHmdDataStreamRateLimit(PSMHmdID hmd_id, const PSMDataStreamRateLimit *rate_limit)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+        PSMDataStreamRateLimit no_rate_limit;
+        memset(&no_rate_limit, 0, sizeof(PSMDataStreamRateLimit));
+
+        if (g_psm_client->set_hmd_data_stream_rate_limit(hmd_id, (rate_limit != nullptr) ? *rate_limit : no_rate_limit))
+        {
+            result= PSMResult_Success;
+        }
+    }
+
+    return result;
+}
+
 PSMResult PSM_StopHmdDataStream(PSMHmdID hmd_id, int timeout_ms)
 {
     PSMResult result= PSMResult_Error;
@@ -66,6 +66,14 @@ typedef enum
     
 } PSMConnectionType;
 
+/// Options for \ref PSM_InitializeWithOptions()
+typedef enum
+{
+    PSMConnectionOptions_defaults = 0x00,			///< Receive all device state over the network
+    PSMConnectionOptions_sharedMemoryPoses = 0x01,	///< Read controller/HMD poses from the service's shared memory pose table (local service only)
+    PSMConnectionOptions_networkThread = 0x02,		///< Receive data frames on a client library thread, see \ref PSM_InitializeWithOptions()
+} PSMConnectionOptionFlags;
+
 /// De-bounced state of a button
 typedef enum 
 {
@@ -111,8 +119,18 @@ typedef enum
 	PSMStreamFlags_includeCalibratedSensorData = 0x08,	///< Add calibrated IMU sensor state
     PSMStreamFlags_includeRawTrackerData = 0x10,		///< Add raw optical tracking projection info
 	PSMStreamFlags_disableROI = 0x20,					///< Disable Region-of-Interest tracking optimization
+	PSMStreamFlags_coalesceDataFrames = 0x40,			///< Only keep the newest unsent data frame per device
+	PSMStreamFlags_rawDataFrameFormat = 0x80,			///< Send fixed-layout binary data frames instead of protobuf (PSMove, DualShock4 and HMDs)
 } PSMControllerDataStreamFlags;
 
+/// Throttling PSMoveService applies to a controller or HMD data stream (all zero = send every update)
+typedef struct
+{
+    float max_data_frame_rate;                  ///< Most data frames per second, 0 for no limit
+    float position_change_threshold_cm;         ///< Only send once the position moved farther than this (0 = off)
+    float orientation_change_threshold_degrees; ///< Only send once the orientation turned farther than this (0 = off)
+} PSMDataStreamRateLimit;
+
 /// The possible rumble channels available to the comtrollers
 typedef enum
 {
@@ -165,7 +183,7 @@ typedef struct
     PSMVector3f LinearAccelerationCmPerSecSqr;
     PSMVector3f AngularVelocityRadPerSec;
     PSMVector3f AngularAccelerationRadPerSecSqr;
-    double       TimeInSeconds;
+    double       TimeInSeconds;  ///< Client clock time (see \ref PSM_GetClientTimeInSeconds()) the pose and physics describe, -1 if unknown
 } PSMPhysicsData;
 
 /// Raw Sensor data from the PSMove IMU
@@ -174,7 +192,7 @@ typedef struct
     PSMVector3i Magnetometer;
     PSMVector3i Accelerometer;
     PSMVector3i Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMPSMoveRawSensorData;
 
 /// Calibrated Sensor
@@ -183,7 +201,7 @@ typedef struct
     PSMVector3f Magnetometer;
     PSMVector3f Accelerometer;
     PSMVector3f Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMPSMoveCalibratedSensorData;
 
 /// Device projection geometry as seen by each tracker
@@ -280,7 +298,7 @@ typedef struct
 {
     PSMVector3i Accelerometer;
     PSMVector3i Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMDS4RawSensorData;
 
 /// DualShock4 calibrated IMU sensor data
@@ -288,7 +306,7 @@ typedef struct
 {
     PSMVector3f Accelerometer;
     PSMVector3f Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMDS4CalibratedSensorData;
 
 /// DualShock4 Controller State in Controller Pool Entry
@@ -459,7 +477,7 @@ typedef struct
 {
     PSMVector3i Accelerometer;
     PSMVector3i Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMMorpheusRawSensorData;
 
 /// Morpheus Calibrated IMU sensor data
@@ -467,7 +485,7 @@ typedef struct
 {
     PSMVector3f Accelerometer;
     PSMVector3f Gyroscope;
-    double      TimeInSeconds;
+    double      TimeInSeconds;  ///< Client clock time of the IMU sample, -1 if unknown
 } PSMMorpheusCalibratedSensorData;
 
 /// Morpheus HMD State in HMD Pool Entry
@@ -691,6 +709,38 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_Shutdown();
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_InitializeAsync(const char* host, const char* port);
 
+/** \brief Initializes a connection to PSMoveService with the given connection options.
+ Same as \ref PSM_Initialize() otherwise.
+ With PSMConnectionOptions_sharedMemoryPoses set and a service running on this machine (loopback host),
+ \ref PSM_Update() refreshes the pose, physics and tracking status of every streaming controller and HMD
+ from the service's shared memory pose table, so they are as fresh as the last service update
+ rather than the last data frame received. 
+ Everything else still comes in over the data stream, which is also what's used
+ when the host isn't local or the pose table can't be opened.
+
+ With PSMConnectionOptions_networkThread set, the client library receives and decodes data frames
+ on a thread of its own as soon as they arrive. The controller and HMD pose getters
+ (\ref PSM_GetControllerPose(), \ref PSM_GetHmdPose(), ...) then return the newest pose received,
+ don't block and can be called from any thread. Responses, events and the rest of the device state
+ are still only applied by \ref PSM_Update(), which must keep being called from a single thread.
+
+ \remark Blocking - Returns after either a connection is successfully established OR the timeout period is reached. 
+ \param host The address that PSMoveService is running at, usually PSMOVESERVICE_DEFAULT_ADDRESS
+ \param port The port that PSMoveSerive is running at, usually PSMOVESERVICE_DEFAULT_PORT
+ \param timeout The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+ \param connection_options Bitmask of \ref PSMConnectionOptionFlags
+ \returns PSMResult_Success on success, PSMResult_Timeout, or PSMResult_Error on a general connection error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_InitializeWithOptions(const char* host, const char* port, int timeout_ms, unsigned int connection_options);
+
+/** \brief Async version of \ref PSM_InitializeWithOptions(). See \ref PSM_InitializeAsync().
+ \param host The address that PSMoveService is running at, usually PSMOVESERVICE_DEFAULT_ADDRESS
+ \param port The port that PSMoveSerive is running at, usually PSMOVESERVICE_DEFAULT_PORT
+ \param connection_options Bitmask of \ref PSMConnectionOptionFlags
+ \returns PSMResult_RequestSent on success, PSMResult_Timeout, or PSMResult_Error on a general connection error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_InitializeWithOptionsAsync(const char* host, const char* port, unsigned int connection_options);
+
 // Update
 /** \brief Poll the connection and process messages.
 	This function will poll the connection for new messages from PSMoveService.
@@ -779,6 +829,16 @@ PSM_PUBLIC_FUNCTION(bool) PSM_HasHMDListChanged();
  */
 PSM_PUBLIC_FUNCTION(bool) PSM_WasSystemButtonPressed();
 
+/** \brief Get the client clock
+	A monotonic clock local to this process. The TimeInSeconds fields of the controller and HMD state
+	(converted from the service's data frame time stamps) and the target times of
+	\ref PSM_GetControllerPoseAtTime() and \ref PSM_GetHmdPoseAtTime() are on this clock.
+	The offset to the service clock is estimated in the background from request round trips once connected.
+	
+	\return The current client clock time in seconds
+ */
+PSM_PUBLIC_FUNCTION(double) PSM_GetClientTimeInSeconds();
+
 // System Blocking Queries
 /** \brief Get the client API version string from PSMoveService
 	Sends a request to PSMoveService to get the protocol version.
@@ -823,6 +883,8 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_PollNextMessage(PSMMessage *out_message, size
 	definition file, PSMoveProtocol.proto. Typically clients won't need or want to send private messages since many of
 	the lower level protocol messages are intended for calibration and other service setting options used by the 
 	PSMoveConfigTool.
+	Like every async request, the request is held until the next update (or blocking request) and then sent
+	along with all other requests made since the last one, in a single batch message.
 	\param request_handle The pointer to the protocol message
 	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
 	\return PSMResult_RequestSent upon successfully sending request or PSMResult_Error if connection is invalid.
@@ -898,6 +960,18 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_FreeControllerListener(PSMControllerID contro
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerList(PSMControllerList *out_controller_list, int timeout_ms);
 
+/** \brief Sets how PSMoveService should throttle the next data stream started for a given controller
+	Low rate consumers (i.e. a UI refresh) can ask for fewer data frames than the service publishes,
+	which saves the service serializing and sending them.
+	With a position or orientation threshold set, a data frame is only sent once the controller moved or turned
+	past it (or its buttons or tracking state changed) since the last data frame sent on the stream.
+	Takes effect on the next call to \ref PSM_StartControllerDataStream or \ref PSM_StartControllerDataStreamAsync.
+	\param controller_id The id of the controller
+	\param rate_limit The throttling to ask for, or NULL to get every update again
+	\return PSMResult_Success if the controller id is valid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetControllerDataStreamRateLimit(PSMControllerID controller_id, const PSMDataStreamRateLimit *rate_limit);
+
 /** \brief Requests start of an unreliable(udp) data stream for a given controller
 	Asks PSMoveService to start stream data for the given controller with the given set of stream properties.
 	The data in the associated \ref PSMController state will get updated automatically in calls to \ref PSM_Update or 
@@ -913,6 +987,8 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerList(PSMControllerList *out_cont
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb
+		- PSMStreamFlags_coalesceDataFrames = a newer data frame replaces an older one that hasn't been sent yet, so the stream never falls behind
+		- PSMStreamFlags_rawDataFrameFormat = PSMove and DualShock4 controllers stream a fixed-layout binary data frame that is cheaper to encode and decode than protobuf (the request fails for other controller types)
 	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
 	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
  */
@@ -985,6 +1061,18 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPosition(PSMControllerID control
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPose(PSMControllerID controller_id, PSMPosef *out_pose);
 
+/** \brief Get the pose of a controller predicted for the given time (i.e. when the next frame is displayed)
+	Extrapolates the latest pose from the time it describes using the velocity and acceleration
+	in its physics data, so the controller stream needs PSMStreamFlags_includePhysicsData.
+	Extrapolation is limited to 100ms either way.
+	\param controller_id The id of the controller
+	\param target_time Client clock time (see \ref PSM_GetClientTimeInSeconds()) to predict the pose for
+	\param[out] out_pose The predicted pose of the controller
+	\return PSMResult_Success if controller has a valid pose, 
+	  PSMResult_NoData if the time of the pose isn't known yet (out_pose is then the latest pose as is)
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerPoseAtTime(PSMControllerID controller_id, double target_time, PSMPosef *out_pose);
+
 /** \brief Get the current rumble fraction of a controller
 	\param controller_id The id of the controller
 	\param channel The channel to get the rumble for. The PSMove has one channel. The DualShock4 has two.
@@ -1102,6 +1190,8 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerListAsync(PSMRequestID *out_requ
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb
+		- PSMStreamFlags_coalesceDataFrames = a newer data frame replaces an older one that hasn't been sent yet, so the stream never falls behind
+		- PSMStreamFlags_rawDataFrameFormat = PSMove and DualShock4 controllers stream a fixed-layout binary data frame that is cheaper to encode and decode than protobuf (the request fails for other controller types)
 	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
 	\return PSMResult_RequestSent on success or PSMResult_Error if there was no valid connection
  */
@@ -1276,6 +1366,25 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_CloseTrackerVideoStream(PSMTrackerID tracker_
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetTrackerVideoFrameBuffer(PSMTrackerID tracker_id, const unsigned char **out_buffer); 
 
+/** \brief Get a pointer straight into the shared memory of an opened tracker video stream (no copy)
+	Points at the newest complete frame without calling \ref PSM_PollTrackerVideoStream.
+	The server never waits on readers: it reuses the frame's slot a couple of frames later.
+	Use the pixels right away, then call \ref PSM_GetTrackerVideoFrameBufferIsIntact to check
+	that they weren't overwritten while you were reading them.
+	\param tracker_id The tracker to get the video frame from
+	\param[out] out_buffer Set to the frame pixels (tracker dimension x 3 bytes, BGR)
+	\param[out] out_frame_index Set to the index of the frame (increases by one per published frame)
+	\return PSMResult_Success if a frame was available, PSMResult_NoData if the server hasn't published one yet
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetTrackerVideoFrameBufferNoCopy(PSMTrackerID tracker_id, const unsigned char **out_buffer, int *out_frame_index);
+
+/** \brief Check that a frame returned by \ref PSM_GetTrackerVideoFrameBufferNoCopy is still intact
+	\param tracker_id The tracker the frame came from
+	\param frame_index The frame index returned by \ref PSM_GetTrackerVideoFrameBufferNoCopy
+	\return PSMResult_Success if the frame hasn't been overwritten, PSMResult_NoData if it has (or is being)
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetTrackerVideoFrameBufferIsIntact(PSMTrackerID tracker_id, int frame_index);
+
 /** \brief Helper function to fetch tracking frustum properties from a tracker
 	\param The id of the tracker we wish to get the tracking frustum properties for
 	\param out_frustum The tracking frustum properties to write the result into
@@ -1383,6 +1492,16 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPosition(PSMHmdID hmd_id, PSMVector3f *
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPose(PSMHmdID hmd_id, PSMPosef *out_pose);
 
+/** \brief Get the pose of an HMD predicted for the given time (i.e. when the next frame is displayed)
+	Same as \ref PSM_GetControllerPoseAtTime() for an HMD.
+	\param hmd_id The id of the HMD
+	\param target_time Client clock time (see \ref PSM_GetClientTimeInSeconds()) to predict the pose for
+	\param[out] out_pose The predicted pose of the HMD
+	\return PSMResult_Success if HMD has a valid pose,
+	  PSMResult_NoData if the time of the pose isn't known yet (out_pose is then the latest pose as is)
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdPoseAtTime(PSMHmdID hmd_id, double target_time, PSMPosef *out_pose);
+
 /** \brief Helper used to tell if the HMD is upright on a level surface.
 	This method is used as a calibration helper when you want to get a number of HMD samples. 
 	Often in this instance you want to make sure the HMD is sitting upright on a table.
@@ -1464,11 +1583,22 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdList(PSMHmdList *out_hmd_list, int time
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb(s)
+		- PSMStreamFlags_coalesceDataFrames = a newer data frame replaces an older one that hasn't been sent yet, so the stream never falls behind
+		- PSMStreamFlags_rawDataFrameFormat = stream a fixed-layout binary data frame that is cheaper to encode and decode than protobuf
 	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
 	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartHmdDataStream(PSMHmdID hmd_id, unsigned int data_stream_flags, int timeout_ms);
 
+/** \brief Sets how PSMoveService should throttle the next data stream started for a given HMD
+	See \ref PSM_SetControllerDataStreamRateLimit().
+	Takes effect on the next call to \ref PSM_StartHmdDataStream or \ref PSM_StartHmdDataStreamAsync.
+	\param hmd_id The id of the HMD
+	\param rate_limit The throttling to ask for, or NULL to get every update again
+	\return PSMResult_Success if the HMD id is valid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetHmdDataStreamRateLimit(PSMHmdID hmd_id, const PSMDataStreamRateLimit *rate_limit);
+
 /** \brief Requests stop of an unreliable(udp) data stream for a given HMD
 	Asks PSMoveService to stop stream data for the given HMD.
 	\remark Blocking - Returns after either stream stop response comes back OR the timeout period is reached. 
@@ -1520,6 +1650,8 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetHmdListAsync(PSMRequestID *out_request_id)
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb(s)
+		- PSMStreamFlags_coalesceDataFrames = a newer data frame replaces an older one that hasn't been sent yet, so the stream never falls behind
+		- PSMStreamFlags_rawDataFrameFormat = stream a fixed-layout binary data frame that is cheaper to encode and decode than protobuf
 	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
 	\return PSMResult_RequestSent if request successfully sent or PSMResult_Error if connection is invalid.
  */
@@ -3,6 +3,8 @@
 
 //-- includes -----
 #include <memory>
+#include <stddef.h>
+#include <stdint.h>
 #include "SharedConstants.h"
 
 //-- constants -----
@@ -43,6 +45,9 @@ class IDataFrameListener
 {
 public:
     virtual void handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) = 0;
+
+    // Called with a datagram that starts with a valid RawDataFrameHeader (see RawDataFrame.h)
+    virtual void handle_raw_data_frame(const uint8_t *data_frame, size_t data_frame_size) = 0;
 };
 
 class IResponseListener
@@ -163,6 +163,30 @@ public:
         }
     }
 
+    /**
+     \brief Pack the given message into a buffer sized to exactly fit it.
+
+     Works on any message, including ones that aren't owned by a \ref MessagePointer.
+     \param msg The message to pack.
+     \param buf Pointer to a buffer of HEADER_SIZE + msg_size bytes.
+     \param msg_size The message size, as returned by the message's ByteSize().
+     \return false in case of an error, true if successful.
+     */
+    static bool pack_exact(const MessageType &msg, boost::uint8_t *buf, int msg_size)
+    {
+        encode_header(buf, HEADER_SIZE + msg_size, msg_size);
+
+        if (msg_size > 0)
+        {
+            return msg.SerializeToArray(&buf[HEADER_SIZE], msg_size);
+        }
+        else
+        {
+            // no body to encode (i.e. just using message defaults)
+            return true;
+        }
+    }
+
     /**
      \brief X
      
@@ -247,7 +271,7 @@ private:
      \param buf A buffer containing a protocol buffer Message without header
      \param value
      */
-    void encode_header(data_buffer& buf, unsigned value) const
+    static void encode_header(data_buffer& buf, unsigned value)
     {
         assert(buf.size() >= HEADER_SIZE);
         buf[0] = static_cast<boost::uint8_t>((value >> 24) & 0xFF);
@@ -259,7 +283,7 @@ private:
     /**
      \overload
      */
-    void encode_header(boost::uint8_t *buf, unsigned buf_size, unsigned value) const
+    static void encode_header(boost::uint8_t *buf, unsigned buf_size, unsigned value)
     {
         assert(buf_size >= HEADER_SIZE);
         buf[0] = static_cast<boost::uint8_t>((value >> 24) & 0xFF);
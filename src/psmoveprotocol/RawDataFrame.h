@@ -0,0 +1,311 @@
+#ifndef RAW_DATA_FRAME_H
+#define RAW_DATA_FRAME_H
+
+//-- includes -----
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+/*
+Raw data frame datagram layout:
+
+    [RawDataFrameHeader][device specific fields and sections]
+
+An alternative to the protobuf DeviceOutputDataFrame for streams that ask for it
+(see RequestStartPSMoveDataStream.raw_data_frame_format and RequestStartHmdDataStream.raw_data_frame_format).
+Every device type has a fixed size struct that is sent as is, so encoding is a struct fill
+and decoding is a memcpy. Sections that weren't requested for the stream are left zeroed
+and have their bit cleared in section_flags.
+
+All fields are little-endian with natural alignment and explicit padding.
+The layouts are checked at compile time below. Bump RAW_DATA_FRAME_VERSION when any of them changes.
+
+Protobuf data frames start with a big-endian message length that is never larger than
+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE, so the magic number in the first four bytes
+tells the two formats apart.
+*/
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Raw data frames are sent in native byte order, which is assumed to be little-endian"
+#endif
+#endif
+
+//-- constants -----
+#define RAW_DATA_FRAME_MAGIC    0x524D5350 // "PSMR" in memory
+#define RAW_DATA_FRAME_VERSION  3
+
+// Bits of RawDataFrameHeader::section_flags
+#define RAW_DATA_FRAME_SECTION_POSITION             0x01
+#define RAW_DATA_FRAME_SECTION_PHYSICS              0x02
+#define RAW_DATA_FRAME_SECTION_RAW_SENSOR           0x04
+#define RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR    0x08
+#define RAW_DATA_FRAME_SECTION_RAW_TRACKER          0x10
+
+// Bits of the status_flags of every device data frame
+#define RAW_DEVICE_STATUS_CONNECTED                 0x01
+#define RAW_DEVICE_STATUS_VALID_HARDWARE_CALIBRATION 0x02
+#define RAW_DEVICE_STATUS_TRACKING_ENABLED          0x04
+#define RAW_DEVICE_STATUS_CURRENTLY_TRACKING        0x08
+#define RAW_DEVICE_STATUS_ORIENTATION_VALID         0x10
+#define RAW_DEVICE_STATUS_POSITION_VALID            0x20
+
+// Bits of RawTrackerDataSection::valid_flags
+#define RAW_TRACKER_DATA_PROJECTED_SPHERE_VALID     0x01
+#define RAW_TRACKER_DATA_MULTICAM_POSITION_VALID    0x02
+#define RAW_TRACKER_DATA_MULTICAM_ORIENTATION_VALID 0x04
+#define RAW_TRACKER_DATA_PROJECTED_POINTS_VALID     0x08
+
+// Most points in a RawTrackerPointsSection (same as PSMTrackingProjection)
+#define RAW_TRACKER_MAX_PROJECTED_POINTS            7
+
+//-- definitions -----
+struct RawVector2f
+{
+    float x, y;
+};
+
+struct RawVector3f
+{
+    float x, y, z;
+};
+
+struct RawVector3i
+{
+    int32_t x, y, z;
+};
+
+struct RawQuatf
+{
+    float w, x, y, z;
+};
+
+// Same layout as PSMPosef
+struct RawPosef
+{
+    RawVector3f position_cm;
+    RawQuatf orientation;
+};
+
+// Same layout as the vectors at the start of PSMPhysicsData
+struct RawPhysicsDataSection
+{
+    RawVector3f velocity_cm_per_sec;
+    RawVector3f acceleration_cm_per_sec_sqr;
+    RawVector3f angular_velocity_rad_per_sec;
+    RawVector3f angular_acceleration_rad_per_sec_sqr;
+};
+
+// Same layout as the vectors at the start of PSMPSMoveRawSensorData
+struct RawPSMoveRawSensorSection
+{
+    RawVector3i magnetometer;
+    RawVector3i accelerometer;
+    RawVector3i gyroscope;
+};
+
+// Same layout as the vectors at the start of PSMPSMoveCalibratedSensorData
+struct RawPSMoveCalibratedSensorSection
+{
+    RawVector3f magnetometer;
+    RawVector3f accelerometer;
+    RawVector3f gyroscope;
+};
+
+// Same layout as the vectors at the start of PSMDS4RawSensorData and PSMMorpheusRawSensorData
+struct RawIMURawSensorSection
+{
+    RawVector3i accelerometer;
+    RawVector3i gyroscope;
+};
+
+// Same layout as the vectors at the start of PSMDS4CalibratedSensorData and PSMMorpheusCalibratedSensorData
+struct RawIMUCalibratedSensorSection
+{
+    RawVector3f accelerometer;
+    RawVector3f gyroscope;
+};
+
+struct RawTrackerDataSection
+{
+    int32_t tracker_id;
+    uint32_t valid_tracker_bitmask;
+    float screen_location_x;
+    float screen_location_y;
+    RawVector3f relative_position_cm;
+    float projected_sphere_center_x;
+    float projected_sphere_center_y;
+    float projected_sphere_half_x_extent;
+    float projected_sphere_half_y_extent;
+    float projected_sphere_angle;
+    RawVector3f multicam_position_cm;
+    uint32_t valid_flags;
+};
+
+// Tracker data that only devices tracked by more than a sphere have,
+// sent along with a RawTrackerDataSection when RAW_DATA_FRAME_SECTION_RAW_TRACKER is set
+struct RawTrackerPointsSection
+{
+    RawQuatf relative_orientation;
+    RawQuatf multicam_orientation;  // Valid with RAW_TRACKER_DATA_MULTICAM_ORIENTATION_VALID
+    int32_t point_count;            // DS4: the light bar triangle then quad, Morpheus: the tracking lights
+    RawVector2f points[RAW_TRACKER_MAX_PROJECTED_POINTS];
+};
+
+struct RawDataFrameHeader
+{
+    uint32_t magic;             // RAW_DATA_FRAME_MAGIC
+    uint16_t version;           // RAW_DATA_FRAME_VERSION
+    uint16_t frame_size;        // Size of the whole data frame, header included
+    uint8_t device_category;    // PSMoveProtocol::DeviceOutputDataFrame::DeviceCategory
+    uint8_t device_type;        // PSMoveProtocol::ControllerType or PSMoveProtocol::HmdType
+    uint16_t section_flags;     // RAW_DATA_FRAME_SECTION_* bits of the sections filled in
+    int32_t device_id;
+    int32_t sequence_num;
+};
+
+struct RawPSMoveDataFrame
+{
+    RawDataFrameHeader header;
+    uint32_t button_down_bitmask; // Indexed by DeviceOutputDataFrame_ControllerDataPacket::ButtonType
+    uint8_t status_flags;       // RAW_DEVICE_STATUS_* bits
+    uint8_t trigger_value;      // [0,255]
+    uint8_t battery_value;      // [0,5;EE,EF]
+    uint8_t padding;
+    RawPosef pose;              // Position is zero without RAW_DATA_FRAME_SECTION_POSITION
+    RawPhysicsDataSection physics_data;
+    RawPSMoveRawSensorSection raw_sensor_data;
+    RawPSMoveCalibratedSensorSection calibrated_sensor_data;
+    RawTrackerDataSection raw_tracker_data;
+    double sample_time_seconds; // Service monotonic time of the sensor sample behind this frame
+    double pose_time_seconds;   // Service monotonic time the pose describes (filter update + prediction)
+};
+
+struct RawDualShock4DataFrame
+{
+    RawDataFrameHeader header;
+    uint32_t button_down_bitmask; // Indexed by DeviceOutputDataFrame_ControllerDataPacket::ButtonType
+    uint8_t status_flags;       // RAW_DEVICE_STATUS_* bits
+    uint8_t padding[3];
+    float left_thumbstick_x;    // [-1,1]
+    float left_thumbstick_y;
+    float right_thumbstick_x;
+    float right_thumbstick_y;
+    float left_trigger_value;   // [0,1]
+    float right_trigger_value;
+    RawPosef pose;              // Position is zero without RAW_DATA_FRAME_SECTION_POSITION
+    RawPhysicsDataSection physics_data;
+    RawIMURawSensorSection raw_sensor_data;
+    RawIMUCalibratedSensorSection calibrated_sensor_data;
+    RawTrackerDataSection raw_tracker_data;
+    RawTrackerPointsSection raw_tracker_points;
+    uint32_t padding2;
+    double sample_time_seconds;
+    double pose_time_seconds;
+};
+
+// Morpheus and virtual HMDs (header.device_type). Virtual HMDs leave the sensor sections zeroed.
+struct RawHMDDataFrame
+{
+    RawDataFrameHeader header;
+    uint8_t status_flags;       // RAW_DEVICE_STATUS_* bits
+    uint8_t padding[3];
+    RawPosef pose;              // Position is zero without RAW_DATA_FRAME_SECTION_POSITION
+    RawPhysicsDataSection physics_data;
+    RawIMURawSensorSection raw_sensor_data;
+    RawIMUCalibratedSensorSection calibrated_sensor_data;
+    RawTrackerDataSection raw_tracker_data;
+    RawTrackerPointsSection raw_tracker_points;
+    double sample_time_seconds;
+    double pose_time_seconds;
+};
+
+//-- layout checks -----
+static_assert(sizeof(RawVector2f) == 8 && sizeof(RawVector3f) == 12 && sizeof(RawVector3i) == 12 && sizeof(RawQuatf) == 16, "Raw vector layout changed");
+static_assert(sizeof(RawPosef) == 28, "RawPosef layout changed");
+static_assert(sizeof(RawPhysicsDataSection) == 48, "RawPhysicsDataSection layout changed");
+static_assert(sizeof(RawPSMoveRawSensorSection) == 36, "RawPSMoveRawSensorSection layout changed");
+static_assert(sizeof(RawPSMoveCalibratedSensorSection) == 36, "RawPSMoveCalibratedSensorSection layout changed");
+static_assert(sizeof(RawIMURawSensorSection) == 24, "RawIMURawSensorSection layout changed");
+static_assert(sizeof(RawIMUCalibratedSensorSection) == 24, "RawIMUCalibratedSensorSection layout changed");
+static_assert(sizeof(RawTrackerDataSection) == 64, "RawTrackerDataSection layout changed");
+static_assert(sizeof(RawTrackerPointsSection) == 92, "RawTrackerPointsSection layout changed");
+static_assert(sizeof(RawDataFrameHeader) == 20, "RawDataFrameHeader layout changed");
+static_assert(offsetof(RawDataFrameHeader, device_category) == 8, "RawDataFrameHeader layout changed");
+static_assert(offsetof(RawDataFrameHeader, device_id) == 12, "RawDataFrameHeader layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, button_down_bitmask) == 20, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, pose) == 28, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, physics_data) == 56, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, raw_sensor_data) == 104, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, calibrated_sensor_data) == 140, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, raw_tracker_data) == 176, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, sample_time_seconds) == 240, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawPSMoveDataFrame, pose_time_seconds) == 248, "RawPSMoveDataFrame layout changed");
+static_assert(sizeof(RawPSMoveDataFrame) == 256, "RawPSMoveDataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, left_thumbstick_x) == 28, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, pose) == 52, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, physics_data) == 80, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, raw_sensor_data) == 128, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, calibrated_sensor_data) == 152, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, raw_tracker_data) == 176, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, raw_tracker_points) == 240, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawDualShock4DataFrame, sample_time_seconds) == 336, "RawDualShock4DataFrame layout changed");
+static_assert(sizeof(RawDualShock4DataFrame) == 352, "RawDualShock4DataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, pose) == 24, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, physics_data) == 52, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, raw_sensor_data) == 100, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, calibrated_sensor_data) == 124, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, raw_tracker_data) == 148, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, raw_tracker_points) == 212, "RawHMDDataFrame layout changed");
+static_assert(offsetof(RawHMDDataFrame, sample_time_seconds) == 304, "RawHMDDataFrame layout changed");
+static_assert(sizeof(RawHMDDataFrame) == 320, "RawHMDDataFrame layout changed");
+
+//-- functions -----
+inline void init_raw_data_frame_header(
+    RawDataFrameHeader &header,
+    size_t frame_size,
+    int device_category,
+    int device_type,
+    int device_id,
+    int sequence_num)
+{
+    header.magic = RAW_DATA_FRAME_MAGIC;
+    header.version = RAW_DATA_FRAME_VERSION;
+    header.frame_size = static_cast<uint16_t>(frame_size);
+    header.device_category = static_cast<uint8_t>(device_category);
+    header.device_type = static_cast<uint8_t>(device_type);
+    header.section_flags = 0;
+    header.device_id = device_id;
+    header.sequence_num = sequence_num;
+}
+
+/// True if the datagram starts with the raw data frame magic number (rather than a protobuf length header).
+inline bool is_raw_data_frame(const uint8_t *buffer, size_t buffer_size)
+{
+    uint32_t magic = 0;
+
+    if (buffer_size < sizeof(magic))
+        return false;
+
+    memcpy(&magic, buffer, sizeof(magic));
+
+    return magic == RAW_DATA_FRAME_MAGIC;
+}
+
+/// Copies out the header of a raw data frame datagram.
+/// Fails if the datagram was cut short or was written with a different layout version.
+inline bool decode_raw_data_frame_header(const uint8_t *buffer, size_t buffer_size, RawDataFrameHeader &out_header)
+{
+    if (buffer_size < sizeof(RawDataFrameHeader))
+        return false;
+
+    memcpy(&out_header, buffer, sizeof(RawDataFrameHeader));
+
+    return
+        out_header.magic == RAW_DATA_FRAME_MAGIC &&
+        out_header.version == RAW_DATA_FRAME_VERSION &&
+        out_header.frame_size >= sizeof(RawDataFrameHeader) &&
+        out_header.frame_size <= buffer_size;
+}
+
+#endif  // RAW_DATA_FRAME_H
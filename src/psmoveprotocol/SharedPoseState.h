@@ -0,0 +1,201 @@
+#ifndef SHARED_POSE_STATE_H
+#define SHARED_POSE_STATE_H
+
+#ifdef WIN32
+#define BOOST_INTERPROCESS_SHARED_DIR_PATH "shared_mem"
+#endif // WIN32
+
+#include "RawDataFrame.h"
+#include "SharedConstants.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+/*
+Shared memory pose table layout:
+
+    [SharedPoseTableHeader][controller slot 0]...[controller slot N-1][hmd slot 0]...[hmd slot M-1]
+
+The server owns the table and rewrites the slot of a controller or HMD every time it publishes
+new state for it, whether or not any client is streaming from that device.
+Each slot is guarded by its own seqlock (odd sequence while being written) so that clients
+on the same host can read the latest pose at any time without a datagram round trip,
+and the server never waits on them.
+
+The client library also uses plain (process local) slots to hand poses decoded on its
+network thread to the application's threads (PSMConnectionOptions_networkThread).
+*/
+
+#define PSMOVESERVICE_POSE_TABLE_SHARED_MEMORY_NAME "psmoveservice_pose_table"
+
+// Bits of SharedPoseData::status_flags
+#define SHARED_POSE_STATUS_CONNECTED            0x01
+#define SHARED_POSE_STATUS_TRACKING_ENABLED     0x02
+#define SHARED_POSE_STATUS_CURRENTLY_TRACKING   0x04
+#define SHARED_POSE_STATUS_ORIENTATION_VALID    0x08
+#define SHARED_POSE_STATUS_POSITION_VALID       0x10
+
+// Plain copy of a device pose, copied in and out of a slot as a whole
+struct SharedPoseData
+{
+    int32_t device_type;        // PSMoveProtocol::ControllerType or HMDType, -1 when the slot has no device
+    int32_t sequence_num;       // Sequence number of the data frame published with this pose
+    uint32_t status_flags;      // SHARED_POSE_STATUS_* bits
+    uint32_t padding;
+    double pose_time_seconds;   // Time the pose describes on the writer's monotonic clock, <= 0 if unknown
+    RawPosef pose;
+    RawPhysicsDataSection physics_data;
+};
+
+class SharedPoseSlot
+{
+public:
+    SharedPoseSlot()
+        : sequence(0)
+    {
+        std::memset(&data, 0, sizeof(SharedPoseData));
+        data.device_type = -1;
+    }
+
+    std::atomic<unsigned int> sequence; // odd while the server is writing the slot
+    SharedPoseData data;
+
+    static const size_t k_slot_size = 128; // keeps two slots from sharing a cache line
+    static const int k_max_read_attempt_count = 4;
+
+    // -- Writer --
+    // Only one thread may write a given slot
+    void write(const SharedPoseData &pose_data)
+    {
+        const unsigned int current_sequence = sequence.load(std::memory_order_relaxed);
+
+        // Odd sequence: readers of this slot will retry
+        sequence.store(current_sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&data, &pose_data, sizeof(SharedPoseData));
+
+        sequence.store(current_sequence + 2, std::memory_order_release);
+    }
+
+    // Marks the slot as having no device
+    void clear()
+    {
+        SharedPoseData empty_pose_data;
+
+        std::memset(&empty_pose_data, 0, sizeof(SharedPoseData));
+        empty_pose_data.device_type = -1;
+        write(empty_pose_data);
+    }
+
+    // -- Readers --
+    // Copy out a consistent snapshot of the slot.
+    // Returns false if the writer kept lapping us.
+    bool read(SharedPoseData &out_pose_data) const
+    {
+        for (int attempt = 0; attempt < k_max_read_attempt_count; ++attempt)
+        {
+            const unsigned int current_sequence = sequence.load(std::memory_order_acquire);
+
+            if ((current_sequence & 1) == 0)
+            {
+                std::memcpy(&out_pose_data, &data, sizeof(SharedPoseData));
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (sequence.load(std::memory_order_relaxed) == current_sequence)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+};
+
+class SharedPoseTableHeader
+{
+public:
+    // Bump when the layout changes so that clients built against another layout refuse to read it
+    static const int k_layout_version = 2;
+    static const size_t k_header_size = 64; // keeps the slots cache line aligned
+
+    SharedPoseTableHeader()
+        : layout_version(k_layout_version)
+        , controller_slot_count(PSMOVESERVICE_MAX_CONTROLLER_COUNT)
+        , hmd_slot_count(PSMOVESERVICE_MAX_HMD_COUNT)
+    {
+    }
+
+    int layout_version; // always the first field of the header
+    int controller_slot_count;
+    int hmd_slot_count;
+    // Slots stored past the end of the (padded) header
+
+    static size_t computeTotalSize()
+    {
+        return k_header_size + (PSMOVESERVICE_MAX_CONTROLLER_COUNT + PSMOVESERVICE_MAX_HMD_COUNT)*SharedPoseSlot::k_slot_size;
+    }
+
+    const SharedPoseSlot *getControllerSlot(int controller_id) const
+    {
+        return getSlot(controller_id);
+    }
+
+    const SharedPoseSlot *getHMDSlot(int hmd_id) const
+    {
+        return getSlot(controller_slot_count + hmd_id);
+    }
+
+    // -- Writer (server) --
+    // Placement-constructs every slot. Call once after mapping the table.
+    void initializeSlots()
+    {
+        for (int slot_index = 0; slot_index < controller_slot_count + hmd_slot_count; ++slot_index)
+        {
+            new (getSlotMutable(slot_index)) SharedPoseSlot();
+        }
+    }
+
+    void writeControllerPose(int controller_id, const SharedPoseData &pose_data)
+    {
+        getSlotMutable(controller_id)->write(pose_data);
+    }
+
+    void writeHMDPose(int hmd_id, const SharedPoseData &pose_data)
+    {
+        getSlotMutable(controller_slot_count + hmd_id)->write(pose_data);
+    }
+
+    // -- Readers (clients) --
+    // Copy out a consistent snapshot of the slot.
+    // Returns false if the writer kept lapping us.
+    static bool readSlot(const SharedPoseSlot *slot, SharedPoseData &out_pose_data)
+    {
+        return slot->read(out_pose_data);
+    }
+
+private:
+    const SharedPoseSlot *getSlot(int slot_index) const
+    {
+        return reinterpret_cast<const SharedPoseSlot *>(
+            reinterpret_cast<const unsigned char *>(this) + k_header_size + slot_index*SharedPoseSlot::k_slot_size);
+    }
+
+    SharedPoseSlot *getSlotMutable(int slot_index)
+    {
+        return const_cast<SharedPoseSlot *>(getSlot(slot_index));
+    }
+};
+
+static_assert(offsetof(SharedPoseData, pose) == 24, "SharedPoseData layout changed");
+static_assert(sizeof(SharedPoseData) == 104, "SharedPoseData layout changed");
+static_assert(sizeof(SharedPoseSlot) <= SharedPoseSlot::k_slot_size, "pose slot outgrew its padding");
+static_assert(sizeof(SharedPoseTableHeader) <= SharedPoseTableHeader::k_header_size, "pose table header outgrew its padding");
+
+// The atomics are shared between processes, so they can't fall back to a (process local) lock
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory pose table needs lock-free atomic ints");
+
+#endif // SHARED_POSE_STATE_H
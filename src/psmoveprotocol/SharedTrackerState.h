@@ -5,48 +5,213 @@
 #define BOOST_INTERPROCESS_SHARED_DIR_PATH "shared_mem"
 #endif // WIN32
 
-#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+/*
+Shared memory video stream layout:
+
+    [SharedVideoFrameHeader][slot 0]...[slot N-1]
+
+where each slot is a SharedVideoFrameSlot header followed by one video frame.
+The server writes the frames round robin into the slots and never waits on the readers.
+Each slot has a sequence counter that is odd while the slot is being written (a seqlock),
+so a reader can tell if the frame it copied (or is pointing at) got overwritten under it.
+*/
+
+class SharedVideoFrameSlot
+{
+public:
+    SharedVideoFrameSlot()
+        : sequence(0)
+        , frame_index(0)
+    {
+    }
+
+    std::atomic<unsigned int> sequence; // odd while the server is writing the slot
+    std::atomic<int> frame_index; // frame held by the slot
+    // Buffer stored past the end of the (padded) slot header
+
+    const unsigned char *getBuffer() const
+    {
+        return reinterpret_cast<const unsigned char *>(this) + k_slot_header_size;
+    }
+
+    unsigned char *getBufferMutable()
+    {
+        return const_cast<unsigned char *>(getBuffer());
+    }
+
+    static const size_t k_slot_header_size = 64; // keeps the frame data cache line aligned
+};
 
 class SharedVideoFrameHeader
 {
 public:
+    // Bump when the layout changes so that clients built against another layout refuse to read it
+    static const int k_layout_version = 2;
+    static const int k_default_slot_count = 3;
+    static const int k_max_read_attempt_count = 4;
+    static const size_t k_header_size = 64; // keeps the slots cache line aligned
+
     SharedVideoFrameHeader()
-        : mutex()
+        : layout_version(k_layout_version)
         , width(0)
         , height(0)
         , stride(0)
-        , frame_index(0)
+        , slot_count(0)
+        , latest_frame_index(0)
     {
     }
-    
-    //Mutex to protect access to the shared memory
-    boost::interprocess::interprocess_mutex mutex;
 
+    int layout_version; // always the first field of the header
     int width;
     int height;
     int stride;
-    int frame_index;
-    // Buffer stored past the end of the header
+    int slot_count;
+    std::atomic<int> latest_frame_index; // newest complete frame (0 = no frame written yet)
+    // Slots stored past the end of the (padded) header
 
-    const unsigned char *getBuffer() const
+    static size_t computeVideoBufferSize(int stride, int height)
     {
-        return reinterpret_cast<const unsigned char *>(this) + sizeof(SharedVideoFrameHeader);
+        return stride*height;
     }
 
-    unsigned char *getBufferMutable()
+    static size_t computeSlotSize(int stride, int height)
     {
-        return const_cast<unsigned char *>(getBuffer());
+        return SharedVideoFrameSlot::k_slot_header_size + alignSize(computeVideoBufferSize(stride, height));
     }
 
-    static size_t computeVideoBufferSize(int stride, int height)
+    static size_t computeTotalSize(int stride, int height, int slot_count)
     {
-        return stride*height;
+        return k_header_size + slot_count*computeSlotSize(stride, height);
+    }
+
+    size_t computeTotalSize() const
+    {
+        return computeTotalSize(stride, height, slot_count);
+    }
+
+    const SharedVideoFrameSlot *getSlot(int slot_index) const
+    {
+        return reinterpret_cast<const SharedVideoFrameSlot *>(
+            reinterpret_cast<const unsigned char *>(this) + k_header_size + slot_index*computeSlotSize(stride, height));
     }
 
-    static size_t computeTotalSize(int stride, int height)
+    SharedVideoFrameSlot *getSlotMutable(int slot_index)
     {
-        return sizeof(SharedVideoFrameHeader) + computeVideoBufferSize(stride, height);
+        return const_cast<SharedVideoFrameSlot *>(getSlot(slot_index));
+    }
+
+    const SharedVideoFrameSlot *getSlotForFrame(int frame_index) const
+    {
+        return getSlot(frame_index % slot_count);
+    }
+
+    // -- Writer (server) --
+    // Placement-constructs every slot. Call once after setting the frame properties.
+    void initializeSlots()
+    {
+        for (int slot_index = 0; slot_index < slot_count; ++slot_index)
+        {
+            SharedVideoFrameSlot *slot = new (getSlotMutable(slot_index)) SharedVideoFrameSlot();
+
+            std::memset(slot->getBufferMutable(), 0, computeVideoBufferSize(stride, height));
+        }
+    }
+
+    void writeVideoFrame(const unsigned char *buffer)
+    {
+        const int frame_index = latest_frame_index.load(std::memory_order_relaxed) + 1;
+        SharedVideoFrameSlot *slot = getSlotMutable(frame_index % slot_count);
+        const unsigned int sequence = slot->sequence.load(std::memory_order_relaxed);
+
+        // Odd sequence: readers of this slot will retry or drop what they read
+        slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->frame_index.store(frame_index, std::memory_order_relaxed);
+        std::memcpy(slot->getBufferMutable(), buffer, computeVideoBufferSize(stride, height));
+
+        slot->sequence.store(sequence + 2, std::memory_order_release);
+        latest_frame_index.store(frame_index, std::memory_order_release);
+    }
+
+    // -- Readers (clients) --
+    // Copy the newest complete frame into out_buffer.
+    // Returns false if there is no frame yet or the writer kept lapping us.
+    bool readLatestVideoFrame(unsigned char *out_buffer, int &out_frame_index) const
+    {
+        for (int attempt = 0; attempt < k_max_read_attempt_count; ++attempt)
+        {
+            const int frame_index = latest_frame_index.load(std::memory_order_acquire);
+
+            if (frame_index == 0)
+            {
+                break;
+            }
+
+            const SharedVideoFrameSlot *slot = getSlotForFrame(frame_index);
+            const unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+
+            // The writer may have wrapped around the ring since we loaded latest_frame_index,
+            // in which case the slot holds a newer frame than the one we'd label it with
+            if ((sequence & 1) == 0 && slot->frame_index.load(std::memory_order_relaxed) == frame_index)
+            {
+                std::memcpy(out_buffer, slot->getBuffer(), computeVideoBufferSize(stride, height));
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (slot->sequence.load(std::memory_order_relaxed) == sequence)
+                {
+                    out_frame_index = frame_index;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Point at the newest complete frame in place.
+    // The slot gets reused slot_count-1 frames later; check getIsVideoFrameIntact() after using the pixels.
+    const unsigned char *getLatestVideoFrame(int &out_frame_index) const
+    {
+        const int frame_index = latest_frame_index.load(std::memory_order_acquire);
+
+        if (frame_index != 0)
+        {
+            out_frame_index = frame_index;
+            return getSlotForFrame(frame_index)->getBuffer();
+        }
+
+        return nullptr;
+    }
+
+    // True if the frame returned by getLatestVideoFrame() hasn't been (and isn't being) overwritten
+    bool getIsVideoFrameIntact(int frame_index) const
+    {
+        const SharedVideoFrameSlot *slot = getSlotForFrame(frame_index);
+
+        // Keep the caller's reads of the pixels ahead of the sequence check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const unsigned int sequence = slot->sequence.load(std::memory_order_relaxed);
+
+        return (sequence & 1) == 0 && slot->frame_index.load(std::memory_order_relaxed) == frame_index;
+    }
+
+private:
+    static size_t alignSize(size_t size)
+    {
+        return (size + SharedVideoFrameSlot::k_slot_header_size - 1) & ~(SharedVideoFrameSlot::k_slot_header_size - 1);
     }
 };
 
-#endif // SHARED_TRACKER_STATE_H
\ No newline at end of file
+static_assert(sizeof(SharedVideoFrameSlot) <= SharedVideoFrameSlot::k_slot_header_size, "slot header outgrew its padding");
+static_assert(sizeof(SharedVideoFrameHeader) <= SharedVideoFrameHeader::k_header_size, "frame header outgrew its padding");
+
+// The atomics are shared between processes, so they can't fall back to a (process local) lock
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory video stream needs lock-free atomic ints");
+
+#endif // SHARED_TRACKER_STATE_H
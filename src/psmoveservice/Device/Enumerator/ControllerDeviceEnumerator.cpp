@@ -4,6 +4,7 @@
 #include "ControllerUSBDeviceEnumerator.h"
 #include "ControllerGamepadEnumerator.h"
 #include "VirtualControllerEnumerator.h"
+#include "ReplayDeviceEnumerator.h"
 #include "assert.h"
 #include "string.h"
 
@@ -35,6 +36,11 @@ ControllerDeviceEnumerator::ControllerDeviceEnumerator(
 		enumerators[0] = new ControllerGamepadEnumerator;
 		enumerator_count = 1;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new ReplayDeviceEnumerator(CommonDeviceState::Controller);
+		enumerator_count = 1;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		enumerators = new DeviceEnumerator *[4];
 		enumerators[0] = new ControllerHidDeviceEnumerator;
@@ -86,6 +92,11 @@ ControllerDeviceEnumerator::ControllerDeviceEnumerator(
 		enumerators[0] = new VirtualControllerEnumerator;
 		enumerator_count = 1;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new ReplayDeviceEnumerator(CommonDeviceState::Controller, deviceTypeFilter);
+		enumerator_count = 1;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		enumerators = new DeviceEnumerator *[4];
 		enumerators[0] = new ControllerHidDeviceEnumerator(deviceTypeFilter);
@@ -163,6 +174,9 @@ ControllerDeviceEnumerator::eAPIType ControllerDeviceEnumerator::get_api_type()
 	case eAPIType::CommunicationType_VIRTUAL:
 		result = (enumerator_index < enumerator_count) ? ControllerDeviceEnumerator::CommunicationType_VIRTUAL : ControllerDeviceEnumerator::CommunicationType_INVALID;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		result = (enumerator_index < enumerator_count) ? ControllerDeviceEnumerator::CommunicationType_REPLAY : ControllerDeviceEnumerator::CommunicationType_INVALID;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -213,6 +227,9 @@ const ControllerHidDeviceEnumerator *ControllerDeviceEnumerator::get_hid_control
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -246,6 +263,9 @@ const ControllerUSBDeviceEnumerator *ControllerDeviceEnumerator::get_usb_control
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -279,6 +299,9 @@ const ControllerGamepadEnumerator *ControllerDeviceEnumerator::get_gamepad_contr
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -312,6 +335,9 @@ const VirtualControllerEnumerator *ControllerDeviceEnumerator::get_virtual_contr
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = (enumerator_index < enumerator_count) ? static_cast<VirtualControllerEnumerator *>(enumerators[0]) : nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -327,6 +353,19 @@ const VirtualControllerEnumerator *ControllerDeviceEnumerator::get_virtual_contr
 	return enumerator;
 }
 
+const ReplayDeviceEnumerator *ControllerDeviceEnumerator::get_replay_controller_enumerator() const
+{
+	ReplayDeviceEnumerator *enumerator = nullptr;
+
+	// Replayed controllers are never mixed in with the live ones
+	if (api_type == eAPIType::CommunicationType_REPLAY && enumerator_index < enumerator_count)
+	{
+		enumerator = static_cast<ReplayDeviceEnumerator *>(enumerators[0]);
+	}
+
+	return enumerator;
+}
+
 bool ControllerDeviceEnumerator::is_valid() const
 {
     bool bIsValid = false;
@@ -14,6 +14,7 @@ public:
 		CommunicationType_USB,
 		CommunicationType_GAMEPAD,
         CommunicationType_VIRTUAL,
+        CommunicationType_REPLAY,
 		CommunicationType_ALL
 	};
 
@@ -33,6 +34,7 @@ public:
 	const class ControllerUSBDeviceEnumerator *get_usb_controller_enumerator() const;
 	const class ControllerGamepadEnumerator *get_gamepad_controller_enumerator() const;
     const class VirtualControllerEnumerator *get_virtual_controller_enumerator() const;
+    const class ReplayDeviceEnumerator *get_replay_controller_enumerator() const;
 
 private:
 	eAPIType api_type;
@@ -2,6 +2,7 @@
 #include "HMDDeviceEnumerator.h"
 #include "HidHMDDeviceEnumerator.h"
 #include "VirtualHMDDeviceEnumerator.h"
+#include "ReplayDeviceEnumerator.h"
 #include "assert.h"
 #include "string.h"
 
@@ -28,6 +29,11 @@ HMDDeviceEnumerator::HMDDeviceEnumerator(
 		enumerators[0] = new VirtualHMDDeviceEnumerator;
 		enumerator_count = 1;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerators = new DeviceEnumerator *[1];
+		enumerators[0] = new ReplayDeviceEnumerator(CommonDeviceState::HeadMountedDisplay);
+		enumerator_count = 1;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		enumerators = new DeviceEnumerator *[2];
 		enumerators[0] = new HidHMDDeviceEnumerator;
@@ -82,6 +88,9 @@ HMDDeviceEnumerator::eAPIType HMDDeviceEnumerator::get_api_type() const
 	case eAPIType::CommunicationType_VIRTUAL:
 		result = (enumerator_index < enumerator_count) ? HMDDeviceEnumerator::CommunicationType_VIRTUAL : HMDDeviceEnumerator::CommunicationType_INVALID;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		result = (enumerator_index < enumerator_count) ? HMDDeviceEnumerator::CommunicationType_REPLAY : HMDDeviceEnumerator::CommunicationType_INVALID;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -120,6 +129,9 @@ const HidHMDDeviceEnumerator *HMDDeviceEnumerator::get_hid_hmd_enumerator() cons
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -147,6 +159,9 @@ const VirtualHMDDeviceEnumerator *HMDDeviceEnumerator::get_virtual_hmd_enumerato
 	case eAPIType::CommunicationType_VIRTUAL:
 		enumerator = (enumerator_index < enumerator_count) ? static_cast<VirtualHMDDeviceEnumerator *>(enumerators[0]) : nullptr;
 		break;
+	case eAPIType::CommunicationType_REPLAY:
+		enumerator = nullptr;
+		break;
 	case eAPIType::CommunicationType_ALL:
 		if (enumerator_index < enumerator_count)
 		{
@@ -162,6 +177,19 @@ const VirtualHMDDeviceEnumerator *HMDDeviceEnumerator::get_virtual_hmd_enumerato
 	return enumerator;
 }
 
+const ReplayDeviceEnumerator *HMDDeviceEnumerator::get_replay_hmd_enumerator() const
+{
+	ReplayDeviceEnumerator *enumerator = nullptr;
+
+	// Replayed HMDs are never mixed in with the live ones
+	if (api_type == eAPIType::CommunicationType_REPLAY && enumerator_index < enumerator_count)
+	{
+		enumerator = static_cast<ReplayDeviceEnumerator *>(enumerators[0]);
+	}
+
+	return enumerator;
+}
+
 bool HMDDeviceEnumerator::is_valid() const
 {
     bool bIsValid = false;
@@ -0,0 +1,89 @@
+// -- includes -----
+#include "ReplayDeviceEnumerator.h"
+#include "DeviceInputReplayer.h"
+#include "ServerUtility.h"
+
+// -- ReplayDeviceEnumerator -----
+ReplayDeviceEnumerator::ReplayDeviceEnumerator(CommonDeviceState::eDeviceClass deviceClass)
+    : DeviceEnumerator()
+    , m_deviceClass(deviceClass)
+    , m_stream_id(-1)
+{
+    next();
+}
+
+ReplayDeviceEnumerator::ReplayDeviceEnumerator(
+    CommonDeviceState::eDeviceClass deviceClass,
+    CommonDeviceState::eDeviceType deviceTypeFilter)
+    : DeviceEnumerator(deviceTypeFilter)
+    , m_deviceClass(deviceClass)
+    , m_stream_id(-1)
+{
+    next();
+}
+
+const char *ReplayDeviceEnumerator::get_path() const
+{
+	return is_valid() ? m_current_device_identifier.c_str() : nullptr;
+}
+
+int ReplayDeviceEnumerator::get_vendor_id() const
+{
+	return is_valid() ? 0x0000 : -1;
+}
+
+int ReplayDeviceEnumerator::get_product_id() const
+{
+	return is_valid() ? 0x0000 : -1;
+}
+
+bool ReplayDeviceEnumerator::is_valid() const
+{
+    const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+
+	return replayer != nullptr && m_stream_id >= 0 && m_stream_id < replayer->getStreamCount();
+}
+
+bool ReplayDeviceEnumerator::next()
+{
+	bool foundValid = false;
+
+    do
+    {
+        ++m_stream_id;
+        foundValid = testStream();
+    } while (is_valid() && !foundValid);
+
+    if (foundValid)
+    {
+        char device_path[32];
+        ServerUtility::format_string(device_path, sizeof(device_path), "Replay_%d", m_stream_id);
+
+        m_current_device_identifier = device_path;
+        m_deviceType = DeviceInputReplayer::getInstance()->getStreamDeviceType(m_stream_id);
+    }
+    else
+    {
+        m_current_device_identifier.clear();
+        m_deviceType = CommonDeviceState::INVALID_DEVICE_TYPE;
+    }
+
+	return foundValid;
+}
+
+bool ReplayDeviceEnumerator::testStream() const
+{
+    bool foundValid = false;
+
+    if (is_valid())
+    {
+        const CommonDeviceState::eDeviceType deviceType = DeviceInputReplayer::getInstance()->getStreamDeviceType(m_stream_id);
+
+        foundValid =
+            deviceType != CommonDeviceState::INVALID_DEVICE_TYPE &&
+            (deviceType & 0xf0) == m_deviceClass &&
+            (m_deviceTypeFilter == CommonDeviceState::INVALID_DEVICE_TYPE || deviceType == m_deviceTypeFilter);
+    }
+
+    return foundValid;
+}
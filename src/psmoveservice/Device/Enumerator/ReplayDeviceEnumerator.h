@@ -0,0 +1,35 @@
+#ifndef REPLAY_DEVICE_ENUMERATOR_H
+#define REPLAY_DEVICE_ENUMERATOR_H
+
+// -- includes -----
+#include "DeviceEnumerator.h"
+#include <string>
+
+// -- definitions -----
+/// Enumerates the devices of one class found in the device input recording being replayed (if any).
+/// Each recorded stream is a device, even when the same device got recorded more than once.
+class ReplayDeviceEnumerator : public DeviceEnumerator
+{
+public:
+    ReplayDeviceEnumerator(CommonDeviceState::eDeviceClass deviceClass);
+    ReplayDeviceEnumerator(CommonDeviceState::eDeviceClass deviceClass, CommonDeviceState::eDeviceType deviceTypeFilter);
+
+    bool is_valid() const override;
+    bool next() override;
+	int get_vendor_id() const override;
+	int get_product_id() const override;
+    const char *get_path() const override;
+
+    /// The recorded stream the current device gets replayed from
+    inline int get_stream_id() const { return m_stream_id; }
+
+protected:
+    bool testStream() const;
+
+private:
+    CommonDeviceState::eDeviceClass m_deviceClass;
+	std::string m_current_device_identifier;
+    int m_stream_id;
+};
+
+#endif // REPLAY_DEVICE_ENUMERATOR_H
@@ -2,6 +2,7 @@
 #define DEVICE_INTERFACE_H
 
 // -- includes -----
+#include <chrono>
 #include <string>
 #include <tuple>
 
@@ -215,6 +216,8 @@ struct CommonDeviceState
     
     eDeviceType DeviceType;
     int PollSequenceNumber;
+    // Host time the input report for this state arrived (default constructed = unknown)
+    std::chrono::time_point<std::chrono::high_resolution_clock> ArrivalTimestamp;
     
     inline CommonDeviceState()
     {
@@ -225,6 +228,7 @@ struct CommonDeviceState
     {
         DeviceType= SUPPORTED_CONTROLLER_TYPE_COUNT; // invalid
         PollSequenceNumber= 0;
+        ArrivalTimestamp= std::chrono::time_point<std::chrono::high_resolution_clock>();
     }
 
     static const char *getDeviceTypeString(eDeviceType device_type)
@@ -291,8 +295,6 @@ struct CommonControllerState : CommonDeviceState
 
     enum BatteryLevel Battery;
     unsigned int AllButtons;                    // all-buttons, used to detect changes
-
-    //TODO: high-precision timestamp. Need to do in hidapi?
     
     inline CommonControllerState()
     {
@@ -527,8 +529,17 @@ public:
     virtual bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const = 0;
 
     // Returns a pointer to the last video frame buffer captured
+    // (nullptr when the last frame was captured as a raw Bayer frame)
     virtual const unsigned char *getVideoFrameBuffer() const = 0;
 
+    // Returns a pointer to the last raw Bayer frame captured (one byte per pixel, GBRG pattern)
+    // or nullptr when the last frame was captured as a BGR frame
+    virtual const unsigned char *getVideoFrameBayerBuffer() const = 0;
+
+    // Ask for raw Bayer frames instead of debayered video frames.
+    // Returns false if the camera driver can't provide them (frames stay BGR).
+    virtual bool setCaptureRawBayerFrames(bool bCaptureRawBayer) = 0;
+
     static const char *getDriverTypeString(eDriverType device_type)
     {
         const char *result = nullptr;
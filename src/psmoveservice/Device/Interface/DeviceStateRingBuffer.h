@@ -0,0 +1,73 @@
+#ifndef DEVICE_STATE_RING_BUFFER_H
+#define DEVICE_STATE_RING_BUFFER_H
+
+// -- includes -----
+#include <array>
+#include <assert.h>
+
+// -- definitions -----
+/// Fixed size history of the most recent device states.
+/// Pushing a state into a full buffer overwrites the oldest state.
+/// All of the storage is allocated up front in one contiguous block.
+template <typename t_state, int t_capacity>
+class DeviceStateRingBuffer
+{
+public:
+    static_assert(t_capacity > 0, "DeviceStateRingBuffer needs room for at least one state");
+
+    DeviceStateRingBuffer()
+        : m_next_index(0)
+        , m_size(0)
+    {
+    }
+
+    static int capacity()
+    { return t_capacity; }
+
+    inline int size() const
+    { return m_size; }
+
+    inline bool empty() const
+    { return m_size == 0; }
+
+    inline void clear()
+    {
+        m_next_index = 0;
+        m_size = 0;
+    }
+
+    /// Append a new state, dropping the oldest state if the buffer is full
+    inline void push_back(const t_state &state)
+    {
+        m_states[m_next_index] = state;
+        m_next_index = (m_next_index + 1) % t_capacity;
+
+        if (m_size < t_capacity)
+        {
+            ++m_size;
+        }
+    }
+
+    /// The most recently pushed state. The buffer must not be empty.
+    inline const t_state &back() const
+    {
+        assert(m_size > 0);
+        return m_states[(m_next_index + t_capacity - 1) % t_capacity];
+    }
+
+    /// The state pushed lookBack states before the most recent one (0 = most recent),
+    /// or nullptr if that state isn't in the buffer
+    inline const t_state *getLookBack(int lookBack) const
+    {
+        return (lookBack >= 0 && lookBack < m_size)
+            ? &m_states[(m_next_index + t_capacity - 1 - lookBack) % t_capacity]
+            : nullptr;
+    }
+
+private:
+    std::array<t_state, t_capacity> m_states;
+    int m_next_index; // slot the next pushed state gets written to
+    int m_size;
+};
+
+#endif // DEVICE_STATE_RING_BUFFER_H
@@ -3,6 +3,7 @@
 #include "BluetoothQueries.h"
 #include "ControllerDeviceEnumerator.h"
 #include "ControllerGamepadEnumerator.h"
+#include "DeviceInputReplayer.h"
 #include "OrientationFilter.h"
 #include "PSMoveProtocol.pb.h"
 #include "ServerLog.h"
@@ -179,7 +180,11 @@ ControllerManager::poll_devices()
 DeviceEnumerator *
 ControllerManager::allocate_device_enumerator()
 {
-	return new ControllerDeviceEnumerator(ControllerDeviceEnumerator::CommunicationType_ALL);
+	// A replay stands in for all of the live controllers
+	return new ControllerDeviceEnumerator(
+		(DeviceInputReplayer::getInstance() != nullptr)
+		? ControllerDeviceEnumerator::CommunicationType_REPLAY
+		: ControllerDeviceEnumerator::CommunicationType_ALL);
 }
 
 void
@@ -3,6 +3,7 @@
 
 #include "ControllerManager.h"
 #include "DeviceEnumerator.h"
+#include "DeviceInputReplayer.h"
 #include "HMDManager.h"
 #include "OrientationFilter.h"
 #ifdef WIN32
@@ -18,9 +19,15 @@
 #include "ServerUtility.h"
 #include "PSMoveProtocol.pb.h"
 #include "PSMoveConfig.h"
+#include "SharedPoseState.h"
 #include "TrackerManager.h"
 
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 
 //-- constants -----
 static const int k_default_controller_reconnect_interval= 1000; // ms
@@ -45,6 +52,7 @@ public:
         , hmd_poll_interval(k_default_hmd_poll_interval)
 		, gamepad_api_enabled(true)
 		, platform_api_enabled(true)
+		, shared_pose_table_enabled(true)
     {};
 
     const boost::property_tree::ptree
@@ -61,6 +69,7 @@ public:
         pt.put("hmd_poll_interval", hmd_poll_interval); 
 		pt.put("gamepad_api_enabled", gamepad_api_enabled);
 		pt.put("platform_api_enabled", platform_api_enabled);
+		pt.put("shared_pose_table_enabled", shared_pose_table_enabled);
 
         return pt;
     }
@@ -80,6 +89,7 @@ public:
             hmd_poll_interval = pt.get<int>("hmd_poll_interval", k_default_hmd_poll_interval);
 		    gamepad_api_enabled = pt.get<bool>("gamepad_api_enabled", gamepad_api_enabled);
 		    platform_api_enabled = pt.get<bool>("platform_api_enabled", platform_api_enabled);
+		    shared_pose_table_enabled = pt.get<bool>("shared_pose_table_enabled", shared_pose_table_enabled);
         }
         else
         {
@@ -98,6 +108,113 @@ public:
     int hmd_poll_interval;    
 	bool gamepad_api_enabled;
 	bool platform_api_enabled;
+	bool shared_pose_table_enabled;
+};
+
+class SharedPoseTableReadWriteAccessor
+{
+public:
+    SharedPoseTableReadWriteAccessor()
+        : m_shared_memory_object(nullptr)
+        , m_region(nullptr)
+    {}
+
+    ~SharedPoseTableReadWriteAccessor()
+    {
+        dispose();
+    }
+
+    bool initialize(const char *shared_memory_name)
+    {
+        bool bSuccess = false;
+
+        try
+        {
+            SERVER_LOG_INFO("SharedMemory::initialize()") << "Allocating shared memory: " << shared_memory_name;
+
+            // Remember the name of the shared memory
+            m_shared_memory_name = shared_memory_name;
+
+            // Make sure the shared memory block has been removed first
+            boost::interprocess::shared_memory_object::remove(shared_memory_name);
+
+            // Allow non admin-level processed to access the shared memory
+            boost::interprocess::permissions permissions;
+            permissions.set_unrestricted();
+
+            // Create the shared memory object
+            m_shared_memory_object =
+                new boost::interprocess::shared_memory_object(
+                    boost::interprocess::create_only,
+                    shared_memory_name,
+                    boost::interprocess::read_write,
+                    permissions);
+
+            // Resize the shared memory to hold the header and one slot per controller and HMD
+            m_shared_memory_object->truncate(SharedPoseTableHeader::computeTotalSize());
+
+            // Map all of the shared memory for read/write access
+            m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
+
+            // Initialize the shared memory (call constructor using placement new)
+            // This make sure the slot sequence counters have the constructor called on them.
+            SharedPoseTableHeader *poseTable = new (getPoseTable()) SharedPoseTableHeader();
+
+            poseTable->initializeSlots();
+
+            bSuccess = true;
+        }
+        catch (boost::interprocess::interprocess_exception &ex)
+        {
+            dispose();
+            SERVER_LOG_ERROR("SharedMemory::initialize()") << "Failed to allocated shared memory: " << m_shared_memory_name
+                << ", reason: " << ex.what();
+        }
+
+        return bSuccess;
+    }
+
+    void dispose()
+    {
+        if (m_region != nullptr)
+        {
+            delete m_region;
+            m_region = nullptr;
+        }
+
+        if (m_shared_memory_object != nullptr)
+        {
+            delete m_shared_memory_object;
+            m_shared_memory_object = nullptr;
+
+            if (!boost::interprocess::shared_memory_object::remove(m_shared_memory_name))
+            {
+                SERVER_LOG_ERROR("SharedMemory::dispose") << "Failed to free shared memory: " << m_shared_memory_name;
+            }
+        }
+    }
+
+    void writeControllerPose(int controller_id, const SharedPoseData &pose_data)
+    {
+        // Never blocks on the clients: readers detect a torn slot through its sequence counter
+        getPoseTable()->writeControllerPose(controller_id, pose_data);
+    }
+
+    void writeHMDPose(int hmd_id, const SharedPoseData &pose_data)
+    {
+        getPoseTable()->writeHMDPose(hmd_id, pose_data);
+    }
+
+protected:
+    SharedPoseTableHeader *getPoseTable()
+    {
+        return reinterpret_cast<SharedPoseTableHeader *>(m_region->get_address());
+    }
+
+private:
+    const char *m_shared_memory_name;
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
 };
 
 // DeviceManager - This is the interface used by PSMoveService
@@ -107,6 +224,7 @@ DeviceManager::DeviceManager()
     : m_config() // NULL config until startup
 	, m_platform_api_type(_eDevicePlatformApiType_None)
 	, m_platform_api(nullptr)
+	, m_shared_pose_table(nullptr)
     , m_controller_manager(new ControllerManager())
     , m_tracker_manager(new TrackerManager())
     , m_hmd_manager(new HMDManager())
@@ -123,6 +241,11 @@ DeviceManager::~DeviceManager()
 	{
 		delete m_platform_api;
 	}
+
+	if (m_shared_pose_table != nullptr)
+	{
+		delete m_shared_pose_table;
+	}
 }
 
 bool
@@ -157,6 +280,19 @@ DeviceManager::startup()
 		success &= m_platform_api->startup(this);
 	}
 
+	// Optionally share the latest device poses with clients on this machine.
+	// Clients fall back to the UDP data frames when this is off or fails.
+	if (m_config->shared_pose_table_enabled)
+	{
+		m_shared_pose_table = new SharedPoseTableReadWriteAccessor;
+
+		if (!m_shared_pose_table->initialize(PSMOVESERVICE_POSE_TABLE_SHARED_MEMORY_NAME))
+		{
+			delete m_shared_pose_table;
+			m_shared_pose_table = nullptr;
+		}
+	}
+
 	// Register for hotplug events if this platform supports them
 	int controller_reconnect_interval = m_config->controller_reconnect_interval;
 	int tracker_reconnect_interval = m_config->tracker_reconnect_interval;
@@ -173,17 +309,22 @@ DeviceManager::startup()
 		hmd_reconnect_interval = -1;
 	}
 
+	// A fast replay steps the replay clock once per update,
+	// so every update has to poll the devices to keep up with it
+	const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+	const bool bIsFastReplay = replayer != nullptr && replayer->getIsFastReplay();
+
     m_controller_manager->reconnect_interval = controller_reconnect_interval;
-    m_controller_manager->poll_interval = m_config->controller_poll_interval;
+    m_controller_manager->poll_interval = bIsFastReplay ? 0 : m_config->controller_poll_interval;
 	m_controller_manager->gamepad_api_enabled= m_config->gamepad_api_enabled;
     success &= m_controller_manager->startup();
     
     m_tracker_manager->reconnect_interval = tracker_reconnect_interval;
-    m_tracker_manager->poll_interval = m_config->tracker_poll_interval;
+    m_tracker_manager->poll_interval = bIsFastReplay ? 0 : m_config->tracker_poll_interval;
     success &= m_tracker_manager->startup();
 
     m_hmd_manager->reconnect_interval = hmd_reconnect_interval;
-    m_hmd_manager->poll_interval = m_config->hmd_poll_interval;
+    m_hmd_manager->poll_interval = bIsFastReplay ? 0 : m_config->hmd_poll_interval;
     success &= m_hmd_manager->startup();    
     
     m_instance= this;
@@ -211,6 +352,22 @@ DeviceManager::update()
     m_hmd_manager->publish(); // publish hmd state to any listening clients (common case)
 }
 
+std::chrono::microseconds
+DeviceManager::getTimeUntilNextUpdate() const
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double, std::micro> time_until_update =
+        std::min(
+            std::min(
+                m_controller_manager->getTimeUntilNextUpdate(now), 
+                m_tracker_manager->getTimeUntilNextUpdate(now)),
+            m_hmd_manager->getTimeUntilNextUpdate(now));
+
+    // Round up so that we don't wake up a hair before the poll interval has elapsed
+    return std::chrono::microseconds(
+        static_cast<std::chrono::microseconds::rep>(std::ceil(std::min(time_until_update.count(), 1e9))));
+}
+
 void
 DeviceManager::shutdown()
 {
@@ -239,9 +396,35 @@ DeviceManager::shutdown()
 		m_platform_api->shutdown();
 	}
 
+	// Freed after the device managers since closing a device clears its slot
+	if (m_shared_pose_table != nullptr)
+	{
+		delete m_shared_pose_table;
+		m_shared_pose_table = nullptr;
+	}
+
     m_instance= nullptr;
 }
 
+// -- Shared Pose Table ---
+void
+DeviceManager::publishControllerPose(int controller_id, const SharedPoseData &pose_data)
+{
+	if (m_shared_pose_table != nullptr)
+	{
+		m_shared_pose_table->writeControllerPose(controller_id, pose_data);
+	}
+}
+
+void
+DeviceManager::publishHMDPose(int hmd_id, const SharedPoseData &pose_data)
+{
+	if (m_shared_pose_table != nullptr)
+	{
+		m_shared_pose_table->writeHMDPose(hmd_id, pose_data);
+	}
+}
+
 // -- Queries ---
 bool 
 DeviceManager::get_device_property(
@@ -49,6 +49,9 @@ public:
     void update();  /**< Poll all connected devices for each specific manager. */
     void shutdown();/**< Shutdown the interfaces for each specific manager. */
 
+    /// How long the main loop can sleep before a device manager needs to poll or reconnect again
+    std::chrono::microseconds getTimeUntilNextUpdate() const;
+
     static inline DeviceManager *getInstance()
     { return m_instance; }
 
@@ -75,6 +78,11 @@ public:
 	void registerHotplugListener(const CommonDeviceState::eDeviceClass deviceClass, IDeviceHotplugListener *listener);
 	void handle_device_connected(enum DeviceClass device_class, const std::string &device_path) override;
 	void handle_device_disconnected(enum DeviceClass device_class, const std::string &device_path) override;
+
+	// -- Shared Pose Table --
+	/// Writes the latest pose of a device into the same-host shared memory pose table (if enabled)
+	void publishControllerPose(int controller_id, const struct SharedPoseData &pose_data);
+	void publishHMDPose(int hmd_id, const struct SharedPoseData &pose_data);
     
 private:
 	/// Singleton instance of the class
@@ -90,6 +98,9 @@ private:
 	// List of registered hot-plug listeners
 	std::vector<DeviceHotplugListener> m_listeners;
 
+	// Same-host shared memory copy of the latest controller/HMD poses (nullptr when disabled)
+	class SharedPoseTableReadWriteAccessor *m_shared_pose_table;
+
 public:
     class ControllerManager *m_controller_manager;
     class TrackerManager *m_tracker_manager;
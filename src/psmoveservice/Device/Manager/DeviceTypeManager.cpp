@@ -8,6 +8,8 @@
 #include "ServerUtility.h"
 #include "ServerRequestHandler.h"
 
+#include <algorithm>
+
 //-- methods -----
 /// Constructor and set intervals (ms) for reconnect and polling
 DeviceTypeManager::DeviceTypeManager(const int recon_int, const int poll_int)
@@ -107,6 +109,38 @@ DeviceTypeManager::poll()
     }
 }
 
+std::chrono::duration<double, std::milli>
+DeviceTypeManager::getTimeUntilNextUpdate(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const
+{
+    return std::min(get_time_until_next_poll(now), get_time_until_next_reconnect(now));
+}
+
+std::chrono::duration<double, std::milli>
+DeviceTypeManager::get_time_until_next_poll(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const
+{
+    std::chrono::duration<double, std::milli> update_diff = now - m_last_poll_time;
+
+    return std::chrono::duration<double, std::milli>(std::max(poll_interval - update_diff.count(), 0.0));
+}
+
+std::chrono::duration<double, std::milli>
+DeviceTypeManager::get_time_until_next_reconnect(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const
+{
+    // A dirty device list is retried by every poll() call anyway,
+    // so only the next reconnect interval is a reason to wake up
+    if (reconnect_interval <= 0 || m_bIsDeviceListDirty)
+    {
+        return std::chrono::duration<double, std::milli>::max();
+    }
+
+    std::chrono::duration<double, std::milli> reconnect_diff = now - m_last_reconnect_time;
+
+    return std::chrono::duration<double, std::milli>(std::max(reconnect_interval - reconnect_diff.count(), 0.0));
+}
+
 bool
 DeviceTypeManager::update_connected_devices()
 {
@@ -26,6 +26,11 @@ public:
     void poll();
     virtual void publish();
 
+    /// Time left until poll() has work to do (polling the devices or refreshing the device list).
+    /// Used by the event driven main loop to decide how long it can sleep.
+    virtual std::chrono::duration<double, std::milli> getTimeUntilNextUpdate(
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const;
+
     virtual int getMaxDevices() const = 0;
 
     /**
@@ -47,6 +52,11 @@ public:
 protected:
     virtual void poll_devices();
 
+    std::chrono::duration<double, std::milli> get_time_until_next_poll(
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const;
+    std::chrono::duration<double, std::milli> get_time_until_next_reconnect(
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const;
+
     /** This method tries make the list of open devices in m_devices match
     the list of connected devices in the device enumerator.
     No device objects are created or destroyed.
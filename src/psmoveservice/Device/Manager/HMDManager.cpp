@@ -1,6 +1,7 @@
 //-- includes -----
 #include "HMDManager.h"
 #include "HMDDeviceEnumerator.h"
+#include "DeviceInputReplayer.h"
 #include "ServerLog.h"
 #include "ServerHMDView.h"
 #include "ServerDeviceView.h"
@@ -114,7 +115,11 @@ HMDManager::can_update_connected_devices()
 DeviceEnumerator *
 HMDManager::allocate_device_enumerator()
 {
-    return new HMDDeviceEnumerator(HMDDeviceEnumerator::CommunicationType_ALL);
+    // A replay stands in for all of the live HMDs
+    return new HMDDeviceEnumerator(
+        (DeviceInputReplayer::getInstance() != nullptr)
+        ? HMDDeviceEnumerator::CommunicationType_REPLAY
+        : HMDDeviceEnumerator::CommunicationType_ALL);
 }
 
 void
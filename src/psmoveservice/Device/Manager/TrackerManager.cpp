@@ -1,6 +1,8 @@
 //-- includes -----
 #include "TrackerManager.h"
 #include "TrackerDeviceEnumerator.h"
+#include "ReplayDeviceEnumerator.h"
+#include "DeviceInputReplayer.h"
 #include "ControllerManager.h"
 #include "DeviceManager.h"
 #include "HMDManager.h"
@@ -25,10 +27,18 @@ TrackerManagerConfig::TrackerManagerConfig(const std::string &fnamebase)
 	ignore_pose_from_one_tracker = false;
     optical_tracking_timeout= 100;
 	tracker_sleep_ms = 1;
-	use_bgr_to_hsv_lookup_table = true;
+	event_driven_main_loop = true;
+	bgr_to_hsv_converter = "lookup_table";
 	exclude_opposed_cameras = false;
 	min_valid_projection_area= 16;
 	disable_roi = false;
+	use_tracker_worker_threads = false;
+	tracker_worker_thread_affinity = -1; // Let the OS schedule the tracker worker threads
+	segment_raw_bayer_frames = false;
+	// Off until optical_capture_latency_ms has been measured for the camera,
+	// without it the frame arrival time stands in for the capture time and no latency gets compensated
+	delayed_optical_fusion = false;
+	optical_capture_latency_ms = 0.f;
 	default_tracker_profile.frame_width = 640;
 	//default_tracker_profile.frame_height = 480;
 	default_tracker_profile.frame_rate = 40;
@@ -52,8 +62,9 @@ TrackerManagerConfig::config2ptree()
 	pt.put("controller_position_smoothing", controller_position_smoothing);
 	pt.put("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
     pt.put("optical_tracking_timeout", optical_tracking_timeout);
-	pt.put("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+	pt.put("bgr_to_hsv_converter", bgr_to_hsv_converter);
 	pt.put("tracker_sleep_ms", tracker_sleep_ms);
+	pt.put("event_driven_main_loop", event_driven_main_loop);
 
 	pt.put("excluded_opposed_cameras", exclude_opposed_cameras);	
 
@@ -61,6 +72,12 @@ TrackerManagerConfig::config2ptree()
 
 	pt.put("disable_roi", disable_roi);
 
+	pt.put("use_tracker_worker_threads", use_tracker_worker_threads);
+	pt.put("tracker_worker_thread_affinity", tracker_worker_thread_affinity);
+	pt.put("segment_raw_bayer_frames", segment_raw_bayer_frames);
+	pt.put("delayed_optical_fusion", delayed_optical_fusion);
+	pt.put("optical_capture_latency_ms", optical_capture_latency_ms);
+
 	pt.put("default_tracker_profile.frame_width", default_tracker_profile.frame_width);
 	//pt.put("default_tracker_profile.frame_height", default_tracker_profile.frame_height);
 	pt.put("default_tracker_profile.frame_rate", default_tracker_profile.frame_rate);
@@ -84,11 +101,20 @@ TrackerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
 		controller_position_smoothing = pt.get<float>("controller_position_smoothing", controller_position_smoothing);
 		ignore_pose_from_one_tracker = pt.get<bool>("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
         optical_tracking_timeout= pt.get<int>("optical_tracking_timeout", optical_tracking_timeout);
-		use_bgr_to_hsv_lookup_table = pt.get<bool>("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+		// Configs that predate "bgr_to_hsv_converter" keep whichever converter "use_bgr_to_hsv_lookup_table" picked
+		bgr_to_hsv_converter = pt.get<std::string>(
+			"bgr_to_hsv_converter", 
+			pt.get<bool>("use_bgr_to_hsv_lookup_table", true) ? "lookup_table" : "opencv");
 		tracker_sleep_ms = pt.get<int>("tracker_sleep_ms", tracker_sleep_ms);
+		event_driven_main_loop = pt.get<bool>("event_driven_main_loop", event_driven_main_loop);
 		exclude_opposed_cameras = pt.get<bool>("excluded_opposed_cameras", exclude_opposed_cameras);
 		min_valid_projection_area = pt.get<float>("min_valid_projection_area", min_valid_projection_area);	
 		disable_roi = pt.get<bool>("disable_roi", disable_roi);
+		use_tracker_worker_threads = pt.get<bool>("use_tracker_worker_threads", use_tracker_worker_threads);
+		tracker_worker_thread_affinity = pt.get<int>("tracker_worker_thread_affinity", tracker_worker_thread_affinity);
+		segment_raw_bayer_frames = pt.get<bool>("segment_raw_bayer_frames", segment_raw_bayer_frames);
+		delayed_optical_fusion = pt.get<bool>("delayed_optical_fusion", delayed_optical_fusion);
+		optical_capture_latency_ms = pt.get<float>("optical_capture_latency_ms", optical_capture_latency_ms);
 		default_tracker_profile.frame_width = pt.get<float>("default_tracker_profile.frame_width", 640);
 		//default_tracker_profile.frame_height = pt.get<float>("default_tracker_profile.frame_height", 480);
 		default_tracker_profile.frame_rate = pt.get<float>("default_tracker_profile.frame_rate", 40);
@@ -163,6 +189,15 @@ TrackerManager::startup()
         // Save back out the config in case there were updated defaults
         cfg.save();
 
+        // When each tracker captures and segments frames on its own worker thread,
+        // polling a tracker view only consumes finished results and never blocks.
+        // Check for new results every update so they are used as soon as they arrive.
+        if (getUseWorkerThreads())
+        {
+            SERVER_LOG_INFO("TrackerManager::startup") << "Tracker worker threads are ENABLED";
+            poll_interval = 0;
+        }
+
         // Refresh the tracker list
         mark_tracker_list_dirty();
 
@@ -176,6 +211,26 @@ TrackerManager::startup()
     return bSuccess;
 }
 
+std::chrono::duration<double, std::milli>
+TrackerManager::getTimeUntilNextUpdate(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const
+{
+    // The worker threads signal the event scheduler when a frame result is ready,
+    // so there is no poll deadline to wake up for
+    if (getUseWorkerThreads())
+    {
+        return get_time_until_next_reconnect(now);
+    }
+
+    return DeviceTypeManager::getTimeUntilNextUpdate(now);
+}
+
+bool
+TrackerManager::getUseWorkerThreads() const
+{
+    return cfg.use_tracker_worker_threads && DeviceInputReplayer::getInstance() == nullptr;
+}
+
 void
 TrackerManager::closeAllTrackers()
 {
@@ -211,13 +266,19 @@ TrackerManager::mark_tracker_list_dirty()
 DeviceEnumerator *
 TrackerManager::allocate_device_enumerator()
 {
+    // A replay stands in for all of the live trackers
+    if (DeviceInputReplayer::getInstance() != nullptr)
+    {
+        return new ReplayDeviceEnumerator(CommonDeviceState::TrackingCamera);
+    }
+
     return new TrackerDeviceEnumerator;
 }
 
 void
 TrackerManager::free_device_enumerator(DeviceEnumerator *enumerator)
 {
-    delete static_cast<TrackerDeviceEnumerator *>(enumerator);
+    delete enumerator;
 
     // Tracker list is no longer dirty after we have iterated through the list of cameras
     m_tracker_list_dirty = false;
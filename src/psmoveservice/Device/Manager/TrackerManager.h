@@ -54,10 +54,16 @@ public:
     long version;
     int optical_tracking_timeout;
 	int tracker_sleep_ms;
-	bool use_bgr_to_hsv_lookup_table;
+	bool event_driven_main_loop; // Sleep until device/socket events or poll deadlines instead of tracker_sleep_ms
+	std::string bgr_to_hsv_converter; // "lookup_table" (default), "simd" or "opencv"
 	bool exclude_opposed_cameras;
 	float min_valid_projection_area;
 	bool disable_roi;
+	bool use_tracker_worker_threads;
+	int tracker_worker_thread_affinity;
+	bool segment_raw_bayer_frames; // Debayer only the tracked regions (full frame only while a video stream is open)
+	bool delayed_optical_fusion; // Fuse optical poses at their camera frame time, re-applying the controller IMU samples since (set optical_capture_latency_ms too)
+	float optical_capture_latency_ms; // Exposure to frame arrival time not already accounted for by the frame timestamps
     TrackerProfile default_tracker_profile;
 	float global_forward_degrees;
 
@@ -76,6 +82,9 @@ public:
 
     bool startup() override;
 
+    std::chrono::duration<double, std::milli> getTimeUntilNextUpdate(
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const override;
+
     void closeAllTrackers();
 
     static const int k_max_devices = PSMOVESERVICE_MAX_TRACKER_COUNT;
@@ -102,6 +111,10 @@ public:
         return cfg;
     }
 
+    // True if each tracker captures and segments its frames on a worker thread.
+    // Always false while replaying a device input recording, which only the main thread reads.
+    bool getUseWorkerThreads() const;
+
     eCommonTrackingColorID allocateTrackingColorID();
     bool claimTrackingColorID(const class ServerControllerView *controller_view, eCommonTrackingColorID color_id);
     bool claimTrackingColorID(const class ServerHMDView *hmd_view, eCommonTrackingColorID color_id);
@@ -5,6 +5,7 @@
 #include "LibUSBBulkTransferBundle.h"
 #include "LibUSBApi.h"
 #include "NullUSBApi.h"
+#include "ServerEventScheduler.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 
@@ -383,6 +384,13 @@ public:
 		}
 
 		result_queue.push(state);
+
+		// Have the main thread pick up the result right away
+		ServerEventScheduler *event_scheduler = ServerEventScheduler::getInstance();
+		if (event_scheduler != nullptr)
+		{
+			event_scheduler->signalEvent();
+		}
 	}
 
 protected:
@@ -0,0 +1,174 @@
+//-- includes -----
+#include "DeviceInputRecorder.h"
+#include "ServerLog.h"
+
+#include <string.h>
+
+//-- statics -----
+DeviceInputRecorder *DeviceInputRecorder::m_instance = nullptr;
+
+//-- DeviceInputRecorder -----
+DeviceInputRecorder::DeviceInputRecorder()
+    : m_writer()
+    , m_recording_path()
+    , m_start_time()
+    , m_stream_count(0)
+{
+}
+
+DeviceInputRecorder::~DeviceInputRecorder()
+{
+    shutdown();
+}
+
+bool DeviceInputRecorder::startup(const std::string &recording_path)
+{
+    std::lock_guard<std::mutex> writer_lock(m_writer_mutex);
+    bool bSuccess = m_writer.open(recording_path);
+
+    if (bSuccess)
+    {
+        SERVER_LOG_INFO("DeviceInputRecorder::startup") << "Recording device input to: " << recording_path;
+
+        m_recording_path = recording_path;
+        m_start_time = std::chrono::high_resolution_clock::now();
+        m_stream_count = 0;
+        m_instance = this;
+    }
+    else
+    {
+        SERVER_LOG_ERROR("DeviceInputRecorder::startup") << "Failed to create device input recording: " << recording_path;
+    }
+
+    return bSuccess;
+}
+
+void DeviceInputRecorder::shutdown()
+{
+    std::lock_guard<std::mutex> writer_lock(m_writer_mutex);
+
+    if (m_writer.getIsOpen())
+    {
+        SERVER_LOG_INFO("DeviceInputRecorder::shutdown") << "Finished recording " << m_stream_count << " device input streams to: " << m_recording_path;
+        m_writer.close();
+    }
+
+    if (m_instance == this)
+    {
+        m_instance = nullptr;
+    }
+}
+
+int DeviceInputRecorder::addStream(
+    CommonDeviceState::eDeviceType device_type,
+    const std::string &device_path,
+    const std::string &device_serial,
+    const std::string &config_json)
+{
+    std::lock_guard<std::mutex> writer_lock(m_writer_mutex);
+
+    if (!m_writer.getIsOpen())
+    {
+        return -1;
+    }
+
+    DeviceInputStreamInfo stream_info;
+    const int stream_id = m_stream_count;
+
+    memset(&stream_info, 0, sizeof(DeviceInputStreamInfo));
+    stream_info.device_type = static_cast<int32_t>(device_type);
+    stream_info.config_size = static_cast<uint32_t>(config_json.size());
+    strncpy(stream_info.device_path, device_path.c_str(), DeviceInputStreamInfo::k_max_path_length - 1);
+    strncpy(stream_info.device_serial, device_serial.c_str(), DeviceInputStreamInfo::k_max_serial_length - 1);
+
+    const bool bSuccess =
+        m_writer.writeRecord(
+            stream_id,
+            _deviceInputRecordType_StreamInfo,
+            getTimestampNanoseconds(std::chrono::high_resolution_clock::now()),
+            &stream_info, sizeof(DeviceInputStreamInfo),
+            config_json.data(), config_json.size());
+    handleWriteResult(bSuccess);
+
+    if (!bSuccess)
+    {
+        return -1;
+    }
+
+    SERVER_LOG_INFO("DeviceInputRecorder::addStream") << "Recording " << CommonDeviceState::getDeviceTypeString(device_type)
+        << "(" << device_path << ") input as stream " << stream_id;
+    ++m_stream_count;
+
+    return stream_id;
+}
+
+void DeviceInputRecorder::recordHidReport(
+    int stream_id,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+    const void *report,
+    int report_size)
+{
+    std::lock_guard<std::mutex> writer_lock(m_writer_mutex);
+
+    if (m_writer.getIsOpen() && stream_id >= 0 && report_size > 0)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> timestamp =
+            (arrival_timestamp.time_since_epoch().count() != 0) ? arrival_timestamp : std::chrono::high_resolution_clock::now();
+
+        handleWriteResult(
+            m_writer.writeRecord(
+                stream_id,
+                _deviceInputRecordType_HidReport,
+                getTimestampNanoseconds(timestamp),
+                report, static_cast<size_t>(report_size)));
+    }
+}
+
+void DeviceInputRecorder::recordVideoFrame(
+    int stream_id,
+    eDeviceInputPixelFormat pixel_format,
+    int width,
+    int height,
+    int stride,
+    const unsigned char *pixels)
+{
+    std::lock_guard<std::mutex> writer_lock(m_writer_mutex);
+
+    if (m_writer.getIsOpen() && stream_id >= 0 && pixels != nullptr)
+    {
+        DeviceInputVideoFrameInfo frame_info;
+
+        frame_info.width = width;
+        frame_info.height = height;
+        frame_info.pixel_format = static_cast<int32_t>(pixel_format);
+        frame_info.stride = stride;
+
+        handleWriteResult(
+            m_writer.writeRecord(
+                stream_id,
+                _deviceInputRecordType_VideoFrame,
+                getTimestampNanoseconds(std::chrono::high_resolution_clock::now()),
+                &frame_info, sizeof(DeviceInputVideoFrameInfo),
+                pixels, static_cast<size_t>(stride)*static_cast<size_t>(height)));
+    }
+}
+
+uint64_t DeviceInputRecorder::getTimestampNanoseconds(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &timestamp) const
+{
+    const std::chrono::nanoseconds time_since_start =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp - m_start_time);
+
+    // Reports read by a reader thread before the recording started
+    return (time_since_start.count() > 0) ? static_cast<uint64_t>(time_since_start.count()) : 0;
+}
+
+void DeviceInputRecorder::handleWriteResult(bool bSuccess)
+{
+    if (!bSuccess)
+    {
+        // Most likely out of disk space: keep what got written so far and stop recording
+        SERVER_LOG_ERROR("DeviceInputRecorder") << "Failed to write to device input recording: " << m_recording_path << ". Recording stopped.";
+        m_writer.close();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef DEVICE_INPUT_RECORDER_H
+#define DEVICE_INPUT_RECORDER_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "DeviceInputRecording.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+//-- definitions -----
+/// Records the raw input of every device the service opens into a device input recording
+/// (see DeviceInputRecording.h), so that the session can be replayed later without the devices.
+/// Devices add a stream when they get opened and then record every input report they read.
+/// Started and shut down on the main thread. Streams get added and recorded from the main thread
+/// and from the tracker worker threads (which poll the cameras), so the writer is behind a lock.
+class DeviceInputRecorder
+{
+public:
+    DeviceInputRecorder();
+    ~DeviceInputRecorder();
+
+    bool startup(const std::string &recording_path);
+    void shutdown();
+
+    /// nullptr unless the service was started with a recording path
+    static inline DeviceInputRecorder *getInstance()
+    { return m_instance; }
+
+    /// Starts a stream for a device that just got opened.
+    /// The config is stored with the stream so that a replay doesn't depend on the local config files.
+    /// Returns the id to record the device input with, or -1 on failure.
+    int addStream(
+        CommonDeviceState::eDeviceType device_type,
+        const std::string &device_path,
+        const std::string &device_serial,
+        const std::string &config_json);
+
+    /// Records a HID input report.
+    /// An unknown (zero) arrival time gets replaced with the current time.
+    void recordHidReport(
+        int stream_id,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+        const void *report,
+        int report_size);
+
+    /// Records a tightly packed video frame
+    void recordVideoFrame(
+        int stream_id,
+        eDeviceInputPixelFormat pixel_format,
+        int width,
+        int height,
+        int stride,
+        const unsigned char *pixels);
+
+private:
+    uint64_t getTimestampNanoseconds(const std::chrono::time_point<std::chrono::high_resolution_clock> &timestamp) const;
+    void handleWriteResult(bool bSuccess); // expects m_writer_mutex to be held
+
+    /// Singleton instance of the class
+    /// Assigned in startup, cleared in shutdown
+    static DeviceInputRecorder *m_instance;
+
+    std::mutex m_writer_mutex; // guards m_writer and m_stream_count
+    DeviceInputRecordingWriter m_writer;
+    std::string m_recording_path;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
+    int m_stream_count;
+};
+
+#endif // DEVICE_INPUT_RECORDER_H
@@ -0,0 +1,336 @@
+//-- includes -----
+#include "DeviceInputRecording.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+//-- constants -----
+static const size_t k_record_alignment = 8;
+
+//-- private prototypes -----
+static size_t get_padded_record_size(size_t payload_size);
+
+//-- DeviceInputRecordingWriter -----
+DeviceInputRecordingWriter::DeviceInputRecordingWriter()
+    : m_file(nullptr)
+    , m_chunk_size(k_default_chunk_size)
+    , m_chunk_buffer()
+    , m_chunk_record_count(0)
+    , m_chunk_first_timestamp_ns(0)
+    , m_chunk_last_timestamp_ns(0)
+    , m_stream_last_timestamp_ns()
+{
+}
+
+DeviceInputRecordingWriter::~DeviceInputRecordingWriter()
+{
+    close();
+}
+
+bool DeviceInputRecordingWriter::open(const std::string &path, size_t chunk_size)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "wb");
+
+    if (m_file != nullptr)
+    {
+        DeviceInputFileHeader file_header;
+
+        memset(&file_header, 0, sizeof(DeviceInputFileHeader));
+        file_header.magic = DEVICE_INPUT_FILE_MAGIC;
+        file_header.version = DEVICE_INPUT_FILE_VERSION;
+
+        if (fwrite(&file_header, sizeof(DeviceInputFileHeader), 1, m_file) == 1)
+        {
+            m_chunk_size = chunk_size;
+            m_chunk_buffer.clear();
+            m_chunk_buffer.reserve(chunk_size);
+            m_chunk_record_count = 0;
+            m_stream_last_timestamp_ns.clear();
+        }
+        else
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    return m_file != nullptr;
+}
+
+void DeviceInputRecordingWriter::close()
+{
+    if (m_file != nullptr)
+    {
+        flush();
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool DeviceInputRecordingWriter::writeRecord(
+    int stream_id,
+    eDeviceInputRecordType record_type,
+    uint64_t timestamp_ns,
+    const void *payload,
+    size_t payload_size,
+    const void *payload_extra,
+    size_t payload_extra_size)
+{
+    if (m_file == nullptr || stream_id < 0 || stream_id > UINT16_MAX)
+    {
+        return false;
+    }
+
+    const size_t total_payload_size = payload_size + payload_extra_size;
+    const size_t record_size = get_padded_record_size(total_payload_size);
+    bool bSuccess = true;
+
+    // Start a new chunk rather than let this record overflow the current one.
+    // A record bigger than a chunk (i.e. a video frame) gets a chunk to itself.
+    if (m_chunk_record_count > 0 && m_chunk_buffer.size() + record_size > m_chunk_size)
+    {
+        bSuccess = flush();
+    }
+
+    // Keep the timestamps of each stream monotonic
+    if (static_cast<size_t>(stream_id) >= m_stream_last_timestamp_ns.size())
+    {
+        m_stream_last_timestamp_ns.resize(stream_id + 1, 0);
+    }
+    timestamp_ns = std::max(timestamp_ns, m_stream_last_timestamp_ns[stream_id]);
+    m_stream_last_timestamp_ns[stream_id] = timestamp_ns;
+
+    DeviceInputRecordHeader record_header;
+    record_header.timestamp_ns = timestamp_ns;
+    record_header.stream_id = static_cast<uint16_t>(stream_id);
+    record_header.record_type = static_cast<uint16_t>(record_type);
+    record_header.payload_size = static_cast<uint32_t>(total_payload_size);
+
+    // Append the header, the payload parts and zeroed padding
+    const size_t record_offset = m_chunk_buffer.size();
+    m_chunk_buffer.resize(record_offset + record_size, 0);
+
+    unsigned char *record_data = m_chunk_buffer.data() + record_offset;
+    memcpy(record_data, &record_header, sizeof(DeviceInputRecordHeader));
+    if (payload_size > 0)
+    {
+        memcpy(record_data + sizeof(DeviceInputRecordHeader), payload, payload_size);
+    }
+    if (payload_extra_size > 0)
+    {
+        memcpy(record_data + sizeof(DeviceInputRecordHeader) + payload_size, payload_extra, payload_extra_size);
+    }
+
+    if (m_chunk_record_count == 0)
+    {
+        m_chunk_first_timestamp_ns = timestamp_ns;
+        m_chunk_last_timestamp_ns = timestamp_ns;
+    }
+    else
+    {
+        m_chunk_first_timestamp_ns = std::min(m_chunk_first_timestamp_ns, timestamp_ns);
+        m_chunk_last_timestamp_ns = std::max(m_chunk_last_timestamp_ns, timestamp_ns);
+    }
+    ++m_chunk_record_count;
+
+    if (m_chunk_buffer.size() >= m_chunk_size)
+    {
+        bSuccess &= flush();
+    }
+
+    return bSuccess;
+}
+
+bool DeviceInputRecordingWriter::flush()
+{
+    bool bSuccess = true;
+
+    if (m_file != nullptr && m_chunk_record_count > 0)
+    {
+        DeviceInputChunkHeader chunk_header;
+
+        chunk_header.magic = DEVICE_INPUT_CHUNK_MAGIC;
+        chunk_header.record_count = static_cast<uint32_t>(m_chunk_record_count);
+        chunk_header.chunk_size = m_chunk_buffer.size();
+        chunk_header.first_timestamp_ns = m_chunk_first_timestamp_ns;
+        chunk_header.last_timestamp_ns = m_chunk_last_timestamp_ns;
+
+        bSuccess =
+            fwrite(&chunk_header, sizeof(DeviceInputChunkHeader), 1, m_file) == 1 &&
+            fwrite(m_chunk_buffer.data(), m_chunk_buffer.size(), 1, m_file) == 1 &&
+            fflush(m_file) == 0;
+
+        m_chunk_buffer.clear();
+        m_chunk_record_count = 0;
+    }
+
+    return bSuccess;
+}
+
+//-- DeviceInputRecordingReader -----
+DeviceInputRecordingReader::DeviceInputRecordingReader()
+    : m_file_mapping(nullptr)
+    , m_mapped_region(nullptr)
+    , m_data(nullptr)
+    , m_data_size(0)
+    , m_chunk_offset(0)
+    , m_chunk_end_offset(0)
+    , m_record_offset(0)
+{
+}
+
+DeviceInputRecordingReader::~DeviceInputRecordingReader()
+{
+    close();
+}
+
+bool DeviceInputRecordingReader::open(const std::string &path)
+{
+    close();
+
+    try
+    {
+        m_file_mapping = new boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+        m_mapped_region = new boost::interprocess::mapped_region(*m_file_mapping, boost::interprocess::read_only);
+        m_data = static_cast<const unsigned char *>(m_mapped_region->get_address());
+        m_data_size = m_mapped_region->get_size();
+    }
+    catch (boost::interprocess::interprocess_exception &)
+    {
+        // i.e. missing or empty file
+        close();
+    }
+
+    if (getIsOpen())
+    {
+        const DeviceInputFileHeader *file_header = reinterpret_cast<const DeviceInputFileHeader *>(m_data);
+
+        if (m_data_size >= sizeof(DeviceInputFileHeader) &&
+            file_header->magic == DEVICE_INPUT_FILE_MAGIC &&
+            file_header->version == DEVICE_INPUT_FILE_VERSION)
+        {
+            rewind();
+        }
+        else
+        {
+            close();
+        }
+    }
+
+    return getIsOpen();
+}
+
+void DeviceInputRecordingReader::close()
+{
+    if (m_mapped_region != nullptr)
+    {
+        delete m_mapped_region;
+        m_mapped_region = nullptr;
+    }
+
+    if (m_file_mapping != nullptr)
+    {
+        delete m_file_mapping;
+        m_file_mapping = nullptr;
+    }
+
+    m_data = nullptr;
+    m_data_size = 0;
+    m_chunk_offset = 0;
+    m_chunk_end_offset = 0;
+    m_record_offset = 0;
+}
+
+void DeviceInputRecordingReader::rewind()
+{
+    // No current chunk: the first read starts on the chunk after the file header
+    m_chunk_offset = sizeof(DeviceInputFileHeader);
+    m_chunk_end_offset = sizeof(DeviceInputFileHeader);
+    m_record_offset = sizeof(DeviceInputFileHeader);
+}
+
+bool DeviceInputRecordingReader::readNextRecord(Record &out_record)
+{
+    if (!seekNextRecord())
+    {
+        return false;
+    }
+
+    const DeviceInputRecordHeader *record_header = reinterpret_cast<const DeviceInputRecordHeader *>(m_data + m_record_offset);
+
+    out_record.timestamp_ns = record_header->timestamp_ns;
+    out_record.stream_id = record_header->stream_id;
+    out_record.record_type = static_cast<eDeviceInputRecordType>(record_header->record_type);
+    out_record.payload = m_data + m_record_offset + sizeof(DeviceInputRecordHeader);
+    out_record.payload_size = record_header->payload_size;
+
+    m_record_offset += get_padded_record_size(record_header->payload_size);
+
+    return true;
+}
+
+bool DeviceInputRecordingReader::peekNextTimestamp(uint64_t &out_timestamp_ns)
+{
+    if (!seekNextRecord())
+    {
+        return false;
+    }
+
+    out_timestamp_ns = reinterpret_cast<const DeviceInputRecordHeader *>(m_data + m_record_offset)->timestamp_ns;
+
+    return true;
+}
+
+bool DeviceInputRecordingReader::seekNextRecord()
+{
+    if (!getIsOpen())
+    {
+        return false;
+    }
+
+    // Move on to the next chunk once the current one is used up
+    while (m_record_offset >= m_chunk_end_offset)
+    {
+        const size_t next_chunk_offset = m_chunk_end_offset;
+
+        if (next_chunk_offset + sizeof(DeviceInputChunkHeader) > m_data_size)
+        {
+            return false;
+        }
+
+        const DeviceInputChunkHeader *chunk_header = reinterpret_cast<const DeviceInputChunkHeader *>(m_data + next_chunk_offset);
+        const size_t records_offset = next_chunk_offset + sizeof(DeviceInputChunkHeader);
+
+        // Stop at a chunk the writer didn't get to finish
+        if (chunk_header->magic != DEVICE_INPUT_CHUNK_MAGIC ||
+            chunk_header->chunk_size > m_data_size - records_offset)
+        {
+            return false;
+        }
+
+        m_chunk_offset = next_chunk_offset;
+        m_chunk_end_offset = records_offset + static_cast<size_t>(chunk_header->chunk_size);
+        m_record_offset = records_offset;
+    }
+
+    // Make sure the whole record is inside of the chunk
+    if (m_record_offset + sizeof(DeviceInputRecordHeader) > m_chunk_end_offset)
+    {
+        return false;
+    }
+
+    const DeviceInputRecordHeader *record_header = reinterpret_cast<const DeviceInputRecordHeader *>(m_data + m_record_offset);
+
+    return m_record_offset + get_padded_record_size(record_header->payload_size) <= m_chunk_end_offset;
+}
+
+//-- private methods -----
+static size_t get_padded_record_size(size_t payload_size)
+{
+    return (sizeof(DeviceInputRecordHeader) + payload_size + k_record_alignment - 1) & ~(k_record_alignment - 1);
+}
@@ -0,0 +1,184 @@
+#ifndef DEVICE_INPUT_RECORDING_H
+#define DEVICE_INPUT_RECORDING_H
+
+//-- includes -----
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace boost { namespace interprocess {
+    class file_mapping;
+    class mapped_region;
+} }
+
+/*
+Device input recording file layout:
+
+    [DeviceInputFileHeader]
+    [DeviceInputChunkHeader][record]...[record]
+    [DeviceInputChunkHeader][record]...[record]
+    ...
+
+Every record is a DeviceInputRecordHeader followed by its payload, padded out to a multiple of
+8 bytes so that a reader can use the records in place from a memory mapped file.
+The writer appends whole chunks, so a recording cut short by a crash only loses its last chunk.
+
+Record timestamps are nanoseconds since the recording started and never go backwards within a stream.
+Records of different streams are stored in the order the service read them.
+*/
+
+//-- constants -----
+#define DEVICE_INPUT_FILE_MAGIC     0x524D5350 // "PSMR"
+#define DEVICE_INPUT_CHUNK_MAGIC    0x4B4E4843 // "CHNK"
+#define DEVICE_INPUT_FILE_VERSION   1
+
+enum eDeviceInputRecordType
+{
+    _deviceInputRecordType_StreamInfo,  // DeviceInputStreamInfo followed by the device config (json)
+    _deviceInputRecordType_HidReport,   // One raw HID input report, as read off the device
+    _deviceInputRecordType_VideoFrame,  // DeviceInputVideoFrameInfo followed by the frame pixels
+};
+
+enum eDeviceInputPixelFormat
+{
+    _deviceInputPixelFormat_BGR8,
+    _deviceInputPixelFormat_Bayer8,
+};
+
+//-- definitions -----
+struct DeviceInputFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t reserved;
+};
+
+struct DeviceInputChunkHeader
+{
+    uint32_t magic;
+    uint32_t record_count;
+    uint64_t chunk_size;            // Bytes of records following this header
+    uint64_t first_timestamp_ns;
+    uint64_t last_timestamp_ns;
+};
+
+struct DeviceInputRecordHeader
+{
+    uint64_t timestamp_ns;
+    uint16_t stream_id;
+    uint16_t record_type;           // eDeviceInputRecordType
+    uint32_t payload_size;          // Not counting the padding
+};
+
+/// Describes the device behind a stream. Written once, before any other record of the stream.
+struct DeviceInputStreamInfo
+{
+    static const int k_max_path_length = 256;
+    static const int k_max_serial_length = 64;
+
+    int32_t device_type;            // CommonDeviceState::eDeviceType
+    uint32_t config_size;           // Bytes of config json following this struct
+    char device_path[k_max_path_length];
+    char device_serial[k_max_serial_length];
+};
+
+struct DeviceInputVideoFrameInfo
+{
+    int32_t width;
+    int32_t height;
+    int32_t pixel_format;           // eDeviceInputPixelFormat
+    int32_t stride;                 // Bytes per row of pixels following this struct
+};
+
+/// Appends records to a new recording file, one chunk at a time.
+class DeviceInputRecordingWriter
+{
+public:
+    static const size_t k_default_chunk_size = 256 * 1024;
+
+    DeviceInputRecordingWriter();
+    ~DeviceInputRecordingWriter();
+
+    /// Creates (or truncates) the recording file and writes its header
+    bool open(const std::string &path, size_t chunk_size = k_default_chunk_size);
+
+    /// Writes out the last (partial) chunk and closes the file
+    void close();
+
+    inline bool getIsOpen() const
+    { return m_file != nullptr; }
+
+    /// Buffers a record in the current chunk, writing the chunk out first if the record doesn't fit.
+    /// Timestamps older than the last one written to the same stream are clamped to it.
+    /// The payload may be given in two parts (i.e. a fixed size header and variable size data).
+    /// Returns false if the file couldn't be written.
+    bool writeRecord(
+        int stream_id,
+        eDeviceInputRecordType record_type,
+        uint64_t timestamp_ns,
+        const void *payload,
+        size_t payload_size,
+        const void *payload_extra = nullptr,
+        size_t payload_extra_size = 0);
+
+    /// Writes out the records buffered so far as a chunk
+    bool flush();
+
+private:
+    FILE *m_file;
+    size_t m_chunk_size;
+    std::vector<unsigned char> m_chunk_buffer;
+    int m_chunk_record_count;
+    uint64_t m_chunk_first_timestamp_ns;
+    uint64_t m_chunk_last_timestamp_ns;
+    std::vector<uint64_t> m_stream_last_timestamp_ns;
+};
+
+/// Walks the records of a memory mapped recording file, in the order they were written.
+class DeviceInputRecordingReader
+{
+public:
+    struct Record
+    {
+        uint64_t timestamp_ns;
+        int stream_id;
+        eDeviceInputRecordType record_type;
+        const unsigned char *payload; // Points into the mapped file
+        size_t payload_size;
+    };
+
+    DeviceInputRecordingReader();
+    ~DeviceInputRecordingReader();
+
+    /// Maps the recording file and checks its header
+    bool open(const std::string &path);
+    void close();
+
+    inline bool getIsOpen() const
+    { return m_mapped_region != nullptr; }
+
+    /// Goes back to the first record
+    void rewind();
+
+    /// Reads the next record.
+    /// Returns false at the end of the recording or at the first truncated or corrupt chunk.
+    bool readNextRecord(Record &out_record);
+
+    /// Peeks at the timestamp of the next record without reading it
+    bool peekNextTimestamp(uint64_t &out_timestamp_ns);
+
+private:
+    bool seekNextRecord();
+
+    boost::interprocess::file_mapping *m_file_mapping;
+    boost::interprocess::mapped_region *m_mapped_region;
+    const unsigned char *m_data;
+    size_t m_data_size;
+
+    size_t m_chunk_offset;          // Offset of the current chunk header
+    size_t m_chunk_end_offset;      // Offset just past the records of the current chunk
+    size_t m_record_offset;         // Offset of the next record in the current chunk
+};
+
+#endif // DEVICE_INPUT_RECORDING_H
@@ -0,0 +1,321 @@
+//-- includes -----
+#include "DeviceInputReplayer.h"
+#include "ServerLog.h"
+
+#include <algorithm>
+#include <string.h>
+
+//-- statics -----
+DeviceInputReplayer *DeviceInputReplayer::m_instance = nullptr;
+
+//-- DeviceInputReplayer -----
+DeviceInputReplayer::DeviceInputReplayer()
+    : m_reader()
+    , m_streams()
+    , m_replay_speed(1.f)
+    , m_start_time()
+    , m_replay_time_ns(0)
+    , m_is_finished(false)
+{
+}
+
+DeviceInputReplayer::~DeviceInputReplayer()
+{
+    shutdown();
+}
+
+bool DeviceInputReplayer::startup(const std::string &recording_path, float replay_speed)
+{
+    if (!m_reader.open(recording_path))
+    {
+        SERVER_LOG_ERROR("DeviceInputReplayer::startup") << "Failed to open device input recording: " << recording_path;
+        return false;
+    }
+
+    // Find every stream up front so that the devices can all be enumerated on the first update
+    DeviceInputRecordingReader::Record record;
+    int record_count = 0;
+    uint64_t duration_ns = 0;
+
+    m_streams.clear();
+    while (m_reader.readNextRecord(record))
+    {
+        if (record.stream_id >= static_cast<int>(m_streams.size()))
+        {
+            ReplayStream empty_stream;
+
+            empty_stream.info = nullptr;
+            empty_stream.first_report = nullptr;
+            empty_stream.first_report_size = 0;
+            empty_stream.dropped_report_count = 0;
+            empty_stream.first_video_frame = nullptr;
+            empty_stream.has_queued_video_frame = false;
+            m_streams.resize(record.stream_id + 1, empty_stream);
+        }
+
+        if (record.record_type == _deviceInputRecordType_StreamInfo &&
+            record.payload_size >= sizeof(DeviceInputStreamInfo))
+        {
+            ReplayStream &stream = m_streams[record.stream_id];
+            const DeviceInputStreamInfo *stream_info = reinterpret_cast<const DeviceInputStreamInfo *>(record.payload);
+            const size_t config_size = std::min(
+                static_cast<size_t>(stream_info->config_size),
+                record.payload_size - sizeof(DeviceInputStreamInfo));
+
+            stream.info = stream_info;
+            stream.config_json.assign(reinterpret_cast<const char *>(record.payload + sizeof(DeviceInputStreamInfo)), config_size);
+
+            SERVER_LOG_INFO("DeviceInputReplayer::startup") << "Found "
+                << CommonDeviceState::getDeviceTypeString(static_cast<CommonDeviceState::eDeviceType>(stream_info->device_type))
+                << "(" << getStreamDevicePath(record.stream_id) << ") input as stream " << record.stream_id;
+        }
+        else if (record.record_type == _deviceInputRecordType_HidReport &&
+                 m_streams[record.stream_id].first_report == nullptr)
+        {
+            m_streams[record.stream_id].first_report = record.payload;
+            m_streams[record.stream_id].first_report_size = record.payload_size;
+        }
+        else if (record.record_type == _deviceInputRecordType_VideoFrame &&
+                 record.payload_size >= sizeof(DeviceInputVideoFrameInfo) &&
+                 m_streams[record.stream_id].first_video_frame == nullptr)
+        {
+            m_streams[record.stream_id].first_video_frame = record.payload;
+        }
+
+        duration_ns = std::max(duration_ns, record.timestamp_ns);
+        ++record_count;
+    }
+    m_reader.rewind();
+
+    if (replay_speed > 0.f)
+    {
+        SERVER_LOG_INFO("DeviceInputReplayer::startup") << "Replaying " << record_count << " records ("
+            << static_cast<double>(duration_ns) / 1e9 << "s) from: " << recording_path << " at " << replay_speed << "x speed";
+    }
+    else
+    {
+        SERVER_LOG_INFO("DeviceInputReplayer::startup") << "Replaying " << record_count << " records ("
+            << static_cast<double>(duration_ns) / 1e9 << "s) from: " << recording_path << " as fast as possible";
+    }
+
+    m_replay_speed = replay_speed;
+    m_start_time = std::chrono::high_resolution_clock::now();
+    m_replay_time_ns = 0;
+    m_is_finished = false;
+    m_instance = this;
+
+    return true;
+}
+
+void DeviceInputReplayer::shutdown()
+{
+    if (m_reader.getIsOpen())
+    {
+        for (size_t stream_id = 0; stream_id < m_streams.size(); ++stream_id)
+        {
+            if (m_streams[stream_id].dropped_report_count > 0)
+            {
+                SERVER_LOG_WARNING("DeviceInputReplayer::shutdown") << "Dropped " << m_streams[stream_id].dropped_report_count
+                    << " unread reports of stream " << stream_id;
+            }
+        }
+
+        // The stream infos point into the mapped recording
+        m_streams.clear();
+        m_reader.close();
+    }
+
+    if (m_instance == this)
+    {
+        m_instance = nullptr;
+    }
+}
+
+void DeviceInputReplayer::update()
+{
+    if (!m_reader.getIsOpen())
+    {
+        return;
+    }
+
+    if (getIsFastReplay())
+    {
+        m_replay_time_ns += k_fast_replay_step_ns;
+    }
+    else
+    {
+        const std::chrono::duration<double, std::nano> time_since_start = std::chrono::high_resolution_clock::now() - m_start_time;
+
+        m_replay_time_ns = static_cast<uint64_t>(time_since_start.count() * static_cast<double>(m_replay_speed));
+    }
+
+    // Hand out every report the replay clock has passed.
+    // Records only come out in timestamp order within a stream, which is all a device needs.
+    uint64_t next_timestamp_ns;
+    while (m_reader.peekNextTimestamp(next_timestamp_ns) && next_timestamp_ns <= m_replay_time_ns)
+    {
+        DeviceInputRecordingReader::Record record;
+
+        m_reader.readNextRecord(record);
+
+        if (record.record_type == _deviceInputRecordType_HidReport &&
+            record.stream_id < static_cast<int>(m_streams.size()))
+        {
+            ReplayStream &stream = m_streams[record.stream_id];
+
+            if (stream.queued_reports.size() >= k_max_queued_report_count)
+            {
+                stream.queued_reports.pop_front();
+                ++stream.dropped_report_count;
+            }
+
+            stream.queued_reports.push_back(record);
+        }
+        else if (record.record_type == _deviceInputRecordType_VideoFrame &&
+                 record.stream_id < static_cast<int>(m_streams.size()))
+        {
+            ReplayStream &stream = m_streams[record.stream_id];
+
+            stream.queued_video_frame = record;
+            stream.has_queued_video_frame = true;
+        }
+    }
+
+    if (!m_is_finished && !m_reader.peekNextTimestamp(next_timestamp_ns))
+    {
+        SERVER_LOG_INFO("DeviceInputReplayer::update") << "Reached the end of the device input recording";
+        m_is_finished = true;
+    }
+}
+
+CommonDeviceState::eDeviceType DeviceInputReplayer::getStreamDeviceType(int stream_id) const
+{
+    const DeviceInputStreamInfo *stream_info =
+        (stream_id >= 0 && stream_id < getStreamCount()) ? m_streams[stream_id].info : nullptr;
+
+    return (stream_info != nullptr)
+        ? static_cast<CommonDeviceState::eDeviceType>(stream_info->device_type)
+        : CommonDeviceState::INVALID_DEVICE_TYPE;
+}
+
+std::string DeviceInputReplayer::getStreamDevicePath(int stream_id) const
+{
+    const DeviceInputStreamInfo *stream_info =
+        (stream_id >= 0 && stream_id < getStreamCount()) ? m_streams[stream_id].info : nullptr;
+
+    return (stream_info != nullptr)
+        ? std::string(stream_info->device_path, strnlen(stream_info->device_path, DeviceInputStreamInfo::k_max_path_length))
+        : std::string();
+}
+
+std::string DeviceInputReplayer::getStreamDeviceSerial(int stream_id) const
+{
+    const DeviceInputStreamInfo *stream_info =
+        (stream_id >= 0 && stream_id < getStreamCount()) ? m_streams[stream_id].info : nullptr;
+
+    return (stream_info != nullptr)
+        ? std::string(stream_info->device_serial, strnlen(stream_info->device_serial, DeviceInputStreamInfo::k_max_serial_length))
+        : std::string();
+}
+
+std::string DeviceInputReplayer::getStreamConfig(int stream_id) const
+{
+    return (stream_id >= 0 && stream_id < getStreamCount()) ? m_streams[stream_id].config_json : std::string();
+}
+
+int DeviceInputReplayer::readHidReport(
+    int stream_id,
+    void *out_report,
+    int max_report_size,
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp)
+{
+    if (stream_id < 0 || stream_id >= getStreamCount() || m_streams[stream_id].queued_reports.empty())
+    {
+        return 0;
+    }
+
+    ReplayStream &stream = m_streams[stream_id];
+    const DeviceInputRecordingReader::Record &record = stream.queued_reports.front();
+    const int report_size = std::min(static_cast<int>(record.payload_size), max_report_size);
+
+    memcpy(out_report, record.payload, report_size);
+    out_arrival_timestamp = getReplayTimestamp(record.timestamp_ns);
+    stream.queued_reports.pop_front();
+
+    return report_size;
+}
+
+int DeviceInputReplayer::peekFirstHidReport(int stream_id, void *out_report, int max_report_size) const
+{
+    if (stream_id < 0 || stream_id >= getStreamCount() || m_streams[stream_id].first_report == nullptr)
+    {
+        return 0;
+    }
+
+    const ReplayStream &stream = m_streams[stream_id];
+    const int report_size = std::min(static_cast<int>(stream.first_report_size), max_report_size);
+
+    memcpy(out_report, stream.first_report, report_size);
+
+    return report_size;
+}
+
+bool DeviceInputReplayer::readVideoFrame(
+    int stream_id,
+    DeviceInputVideoFrameInfo &out_frame_info,
+    const unsigned char *&out_pixels,
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp)
+{
+    if (stream_id < 0 || stream_id >= getStreamCount() || !m_streams[stream_id].has_queued_video_frame)
+    {
+        return false;
+    }
+
+    ReplayStream &stream = m_streams[stream_id];
+    const DeviceInputRecordingReader::Record &record = stream.queued_video_frame;
+    stream.has_queued_video_frame = false;
+
+    if (record.payload_size < sizeof(DeviceInputVideoFrameInfo))
+    {
+        return false;
+    }
+
+    memcpy(&out_frame_info, record.payload, sizeof(DeviceInputVideoFrameInfo));
+
+    // Drop frames cut short in the recording
+    const size_t pixel_size = static_cast<size_t>(out_frame_info.stride) * static_cast<size_t>(out_frame_info.height);
+    if (out_frame_info.stride <= 0 || out_frame_info.height <= 0 ||
+        record.payload_size - sizeof(DeviceInputVideoFrameInfo) < pixel_size)
+    {
+        return false;
+    }
+
+    out_pixels = record.payload + sizeof(DeviceInputVideoFrameInfo);
+    out_arrival_timestamp = getReplayTimestamp(record.timestamp_ns);
+
+    return true;
+}
+
+bool DeviceInputReplayer::peekFirstVideoFrameInfo(int stream_id, DeviceInputVideoFrameInfo &out_frame_info) const
+{
+    if (stream_id < 0 || stream_id >= getStreamCount() || m_streams[stream_id].first_video_frame == nullptr)
+    {
+        return false;
+    }
+
+    memcpy(&out_frame_info, m_streams[stream_id].first_video_frame, sizeof(DeviceInputVideoFrameInfo));
+
+    return true;
+}
+
+std::chrono::time_point<std::chrono::high_resolution_clock> DeviceInputReplayer::getReplayTimestamp(uint64_t timestamp_ns) const
+{
+    // Fast replays keep the recorded spacing of the reports, so the filters see the same time steps
+    const double replay_seconds =
+        getIsFastReplay()
+        ? static_cast<double>(timestamp_ns) / 1e9
+        : static_cast<double>(timestamp_ns) / (1e9 * static_cast<double>(m_replay_speed));
+
+    return m_start_time +
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(replay_seconds));
+}
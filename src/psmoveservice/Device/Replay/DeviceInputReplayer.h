@@ -0,0 +1,120 @@
+#ifndef DEVICE_INPUT_REPLAYER_H
+#define DEVICE_INPUT_REPLAYER_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "DeviceInputRecording.h"
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+//-- definitions -----
+/// Plays a device input recording back in place of the real devices.
+/// The replay enumerators list the recorded controllers, HMDs and trackers. The device classes
+/// read their input reports from here instead of from HID, and ReplayTracker serves the recorded
+/// video frames in place of a camera, so the rest of the DeviceManager::update() pipeline
+/// runs exactly like it does with live devices.
+///
+/// At a positive replay speed the replay clock follows the wall clock (scaled by the speed).
+/// At replay speed 0 it advances by a fixed step every update instead, so that the same recording
+/// always gets handed to the devices in the same batches, as fast as the service can process them.
+/// Only used from the main thread.
+class DeviceInputReplayer
+{
+public:
+    /// Replay clock step per update when replaying as fast as possible
+    static const uint64_t k_fast_replay_step_ns = 2000000; // 2ms, the default controller poll interval
+
+    /// Reports of a stream that no device reads get dropped past this count
+    /// (like a HidReaderThread queue the main thread doesn't drain)
+    static const size_t k_max_queued_report_count = 64;
+
+    DeviceInputReplayer();
+    ~DeviceInputReplayer();
+
+    bool startup(const std::string &recording_path, float replay_speed);
+    void shutdown();
+
+    /// Advances the replay clock and queues up the reports it passed.
+    /// Call before the devices get polled.
+    void update();
+
+    /// nullptr unless the service was started with a recording to replay
+    static inline DeviceInputReplayer *getInstance()
+    { return m_instance; }
+
+    inline bool getIsFastReplay() const
+    { return m_replay_speed <= 0.f; }
+
+    /// True once every record of the recording has been handed out
+    inline bool getIsFinished() const
+    { return m_is_finished; }
+
+    // -- Streams --
+    inline int getStreamCount() const
+    { return static_cast<int>(m_streams.size()); }
+    CommonDeviceState::eDeviceType getStreamDeviceType(int stream_id) const;
+    std::string getStreamDevicePath(int stream_id) const;
+    std::string getStreamDeviceSerial(int stream_id) const;
+    std::string getStreamConfig(int stream_id) const;
+
+    /// Pops the oldest input report of the stream the replay clock has passed.
+    /// The arrival time is the recorded one, on the replay clock.
+    /// Returns the size of the report, or 0 if there is none.
+    int readHidReport(
+        int stream_id,
+        void *out_report,
+        int max_report_size,
+        std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp);
+
+    /// Copies the first input report of the stream without consuming it,
+    /// for devices that need to look at their input before the replay starts.
+    /// Returns the size of the report, or 0 if the stream has none.
+    int peekFirstHidReport(int stream_id, void *out_report, int max_report_size) const;
+
+    /// Takes the newest video frame of the stream the replay clock has passed.
+    /// Older frames the replay clock passed since the last call get skipped, like a camera
+    /// that isn't polled fast enough. The pixels point into the mapped recording.
+    /// Returns false if there is no new frame.
+    bool readVideoFrame(
+        int stream_id,
+        DeviceInputVideoFrameInfo &out_frame_info,
+        const unsigned char *&out_pixels,
+        std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp);
+
+    /// Describes the first video frame of the stream,
+    /// for trackers that need the frame size before the replay starts.
+    /// Returns false if the stream has no video frames.
+    bool peekFirstVideoFrameInfo(int stream_id, DeviceInputVideoFrameInfo &out_frame_info) const;
+
+private:
+    struct ReplayStream
+    {
+        const DeviceInputStreamInfo *info; // nullptr if the recording never described the stream
+        std::string config_json;
+        const unsigned char *first_report; // nullptr if the stream has no input reports
+        size_t first_report_size;
+        std::deque<DeviceInputRecordingReader::Record> queued_reports;
+        int dropped_report_count;
+        const unsigned char *first_video_frame; // nullptr if the stream has no video frames
+        DeviceInputRecordingReader::Record queued_video_frame;
+        bool has_queued_video_frame;
+    };
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> getReplayTimestamp(uint64_t timestamp_ns) const;
+
+    /// Singleton instance of the class
+    /// Assigned in startup, cleared in shutdown
+    static DeviceInputReplayer *m_instance;
+
+    DeviceInputRecordingReader m_reader;
+    std::vector<ReplayStream> m_streams;
+    float m_replay_speed;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
+    uint64_t m_replay_time_ns;
+    bool m_is_finished;
+};
+
+#endif // DEVICE_INPUT_REPLAYER_H
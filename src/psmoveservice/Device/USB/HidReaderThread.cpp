@@ -0,0 +1,118 @@
+//-- includes -----
+#include "HidReaderThread.h"
+#include "ServerEventScheduler.h"
+#include "ServerLog.h"
+#include "ServerUtility.h"
+
+#include <assert.h>
+
+//-- constants -----
+// How long a single blocking read waits before checking if the thread should exit
+static const int k_read_timeout_ms = 100;
+
+//-- public methods -----
+HidReaderThread::HidReaderThread(const std::string &device_name)
+    : m_device_name(device_name)
+    , m_device_handle(nullptr)
+    , m_report_size(0)
+    , m_exit_signaled(false)
+    , m_device_failed(false)
+    , m_dropped_report_count(0)
+    , m_report_queue()
+    , m_thread_started(false)
+{
+}
+
+HidReaderThread::~HidReaderThread()
+{
+    stop();
+}
+
+void HidReaderThread::start(hid_device *device_handle, int report_size)
+{
+    assert(report_size <= HidInputReport::k_max_report_size);
+
+    if (!m_thread_started)
+    {
+        SERVER_LOG_INFO("HidReaderThread::start") << "Starting HID reader thread for " << m_device_name;
+
+        m_device_handle = device_handle;
+        m_report_size = report_size;
+        m_exit_signaled = false;
+        m_device_failed = false;
+        m_dropped_report_count = 0;
+        m_worker_thread = std::thread(&HidReaderThread::workerThreadFunc, this);
+        m_thread_started = true;
+    }
+}
+
+void HidReaderThread::stop()
+{
+    if (m_thread_started)
+    {
+        SERVER_LOG_INFO("HidReaderThread::stop") << "Stopping HID reader thread for " << m_device_name;
+
+        m_exit_signaled = true;
+        m_worker_thread.join();
+        m_thread_started = false;
+
+        // Throw away anything the main thread didn't get to
+        HidInputReport report;
+        while (m_report_queue.pop(report))
+        {
+        }
+
+        m_device_handle = nullptr;
+    }
+}
+
+bool HidReaderThread::fetchInputReport(HidInputReport &out_report)
+{
+    return m_report_queue.pop(out_report);
+}
+
+//-- protected methods -----
+void HidReaderThread::workerThreadFunc()
+{
+    ServerUtility::set_current_thread_name("HID Reader Thread");
+
+    HidInputReport report;
+
+    while (!m_exit_signaled)
+    {
+        const int res = hid_read_timeout(m_device_handle, report.report, m_report_size, k_read_timeout_ms);
+
+        if (res > 0)
+        {
+            report.arrival_timestamp = std::chrono::high_resolution_clock::now();
+            report.report_size = res;
+
+            if (!m_report_queue.push(report))
+            {
+                ++m_dropped_report_count;
+            }
+
+            // Have the main thread process the report right away
+            ServerEventScheduler *event_scheduler = ServerEventScheduler::getInstance();
+            if (event_scheduler != nullptr)
+            {
+                event_scheduler->signalEvent();
+            }
+        }
+        else if (res < 0)
+        {
+            // hid_error() shares its state with the main thread's writes,
+            // so the main thread fetches the error once it sees the failure and closes the device
+            SERVER_LOG_ERROR("HidReaderThread") << m_device_name << " HID read failed";
+            m_device_failed = true;
+
+            ServerEventScheduler *event_scheduler = ServerEventScheduler::getInstance();
+            if (event_scheduler != nullptr)
+            {
+                event_scheduler->signalEvent();
+            }
+            break;
+        }
+        // res == 0: timed out, check if we should exit
+    }
+}
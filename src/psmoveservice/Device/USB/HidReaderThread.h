@@ -0,0 +1,91 @@
+#ifndef HID_READER_THREAD_H
+#define HID_READER_THREAD_H
+
+//-- includes -----
+#include "hidapi.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+//-- definitions -----
+/// One input report read off a HID device, stamped with its host arrival time
+struct HidInputReport
+{
+    static const int k_max_report_size = 128;
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> arrival_timestamp;
+    int report_size;
+    unsigned char report[k_max_report_size];
+};
+
+/// Blocks on hid_read() on a thread dedicated to a single HID device, so that every
+/// input report is timestamped the moment it arrives instead of when the main thread
+/// gets around to polling the device. The main thread drains the reports from a
+/// lock-free single producer/single consumer queue in the device's poll().
+///
+/// hidapi doesn't promise that a handle can be used from two threads at once, while the main
+/// thread keeps writing output and feature reports to the same handle this one reads from.
+/// The reader thread only ever calls hid_read_timeout(), which relies on each backend keeping
+/// reads apart from everything else done with the handle:
+///  - windows: reads use their own OVERLAPPED and buffer, writes and feature reports don't touch them
+///  - linux (hidraw): read() and write()/ioctl() on the file descriptor are independent syscalls
+///  - mac: reports get queued by hidapi's own run loop thread and popped under the device mutex
+/// The last error string is shared between all calls on a handle, so hid_error() is only called on
+/// the main thread, after the reader has failed and stopped using the handle.
+/// Since none of this is guaranteed by hidapi the devices leave the thread off by default.
+class HidReaderThread
+{
+public:
+    HidReaderThread(const std::string &device_name);
+    ~HidReaderThread();
+
+    /// Start reading reports of (at most) report_size bytes from the given open device.
+    /// The device must stay open until stop() is called.
+    void start(hid_device *device_handle, int report_size);
+
+    /// Stop reading. Must be called before the device handle gets closed.
+    void stop();
+
+    // -- Main thread --
+    inline bool getIsStarted() const
+    { return m_thread_started; }
+
+    /// True once a read failed (i.e. the device got disconnected).
+    /// The thread no longer touches the device after that, so hid_error() is safe to call.
+    /// Any reports read before the failure can still be fetched.
+    inline bool getHasDeviceFailed() const
+    { return m_device_failed; }
+
+    /// Pops the oldest queued report. Returns false if the queue is empty.
+    bool fetchInputReport(HidInputReport &out_report);
+
+    /// Reports dropped because the main thread fell behind
+    inline int getDroppedReportCount() const
+    { return m_dropped_report_count; }
+
+protected:
+    void workerThreadFunc();
+
+private:
+    static const int k_report_queue_capacity = 64;
+
+    std::string m_device_name;
+    hid_device *m_device_handle;
+    int m_report_size;
+
+    // Multithreaded state
+    std::atomic_bool m_exit_signaled;
+    std::atomic_bool m_device_failed;
+    std::atomic_int m_dropped_report_count;
+    boost::lockfree::spsc_queue<HidInputReport, boost::lockfree::capacity<k_report_queue_capacity> > m_report_queue;
+
+    // Main thread state
+    bool m_thread_started;
+    std::thread m_worker_thread;
+};
+
+#endif // HID_READER_THREAD_H
@@ -1,6 +1,7 @@
 //-- includes -----
 #include "LibUSBBulkTransferBundle.h"
 #include "LibUSBApi.h"
+#include "ServerEventScheduler.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "USBDeviceRequest.h"
@@ -197,6 +198,13 @@ static void LIBUSB_CALL transfer_callback_function(struct libusb_transfer *bulk_
             bulk_transfer->buffer,
             bulk_transfer->actual_length,
             request.transfer_callback_userdata);
+
+        // Wake up the main thread to consume the new data
+        ServerEventScheduler *event_scheduler = ServerEventScheduler::getInstance();
+        if (event_scheduler != nullptr)
+        {
+            event_scheduler->signalEvent();
+        }
     }
 
     // See if the request wants to resubmitted the moment it completes.
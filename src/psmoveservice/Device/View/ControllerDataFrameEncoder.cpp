@@ -0,0 +1,299 @@
+//-- includes -----
+#include "ControllerDataFrameEncoder.h"
+#include "ServerRequestHandler.h"
+#include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
+
+#include <assert.h>
+
+//-- public methods -----
+void encode_psmove_data_frame(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo *stream_info,
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+{
+    auto *controller_data_frame= data_frame->mutable_controller_data_packet();
+    auto *psmove_data_frame = controller_data_frame->mutable_psmove_state();
+
+    if (source.bHasControllerState)
+    {
+        psmove_data_frame->set_validhardwarecalibration(source.bHasValidHardwareCalibration);
+        psmove_data_frame->set_iscurrentlytracking(source.bIsCurrentlyTracking);
+        psmove_data_frame->set_istrackingenabled(source.bIsTrackingEnabled);
+        psmove_data_frame->set_isorientationvalid(source.bIsOrientationValid);
+        psmove_data_frame->set_ispositionvalid(source.bIsPositionValid);
+
+        psmove_data_frame->mutable_orientation()->set_w(source.pose.Orientation.w);
+        psmove_data_frame->mutable_orientation()->set_x(source.pose.Orientation.x);
+        psmove_data_frame->mutable_orientation()->set_y(source.pose.Orientation.y);
+        psmove_data_frame->mutable_orientation()->set_z(source.pose.Orientation.z);
+
+        if (stream_info->include_position_data)
+        {
+            psmove_data_frame->mutable_position_cm()->set_x(source.pose.PositionCm.x);
+            psmove_data_frame->mutable_position_cm()->set_y(source.pose.PositionCm.y);
+            psmove_data_frame->mutable_position_cm()->set_z(source.pose.PositionCm.z);
+        }
+        else
+        {
+            psmove_data_frame->mutable_position_cm()->set_x(0);
+            psmove_data_frame->mutable_position_cm()->set_y(0);
+            psmove_data_frame->mutable_position_cm()->set_z(0);
+        }
+
+        psmove_data_frame->set_trigger_value(source.trigger_value);
+        psmove_data_frame->set_battery_value(source.battery_value);
+        controller_data_frame->set_button_down_bitmask(source.button_bitmask);
+
+        // If requested, get the raw sensor data for the controller
+        if (stream_info->include_raw_sensor_data)
+        {
+            auto *raw_sensor_data= psmove_data_frame->mutable_raw_sensor_data();
+
+            raw_sensor_data->mutable_magnetometer()->set_i(source.raw_magnetometer[0]);
+            raw_sensor_data->mutable_magnetometer()->set_j(source.raw_magnetometer[1]);
+            raw_sensor_data->mutable_magnetometer()->set_k(source.raw_magnetometer[2]);
+
+            raw_sensor_data->mutable_accelerometer()->set_i(source.raw_accelerometer[0]);
+            raw_sensor_data->mutable_accelerometer()->set_j(source.raw_accelerometer[1]);
+            raw_sensor_data->mutable_accelerometer()->set_k(source.raw_accelerometer[2]);
+
+            raw_sensor_data->mutable_gyroscope()->set_i(source.raw_gyroscope[0]);
+            raw_sensor_data->mutable_gyroscope()->set_j(source.raw_gyroscope[1]);
+            raw_sensor_data->mutable_gyroscope()->set_k(source.raw_gyroscope[2]);
+        }
+
+        // If requested, get the calibrated sensor data for the controller
+        if (stream_info->include_calibrated_sensor_data)
+        {
+            auto *calibrated_sensor_data = psmove_data_frame->mutable_calibrated_sensor_data();
+
+            calibrated_sensor_data->mutable_magnetometer()->set_i(source.calibrated_magnetometer[0]);
+            calibrated_sensor_data->mutable_magnetometer()->set_j(source.calibrated_magnetometer[1]);
+            calibrated_sensor_data->mutable_magnetometer()->set_k(source.calibrated_magnetometer[2]);
+
+            calibrated_sensor_data->mutable_accelerometer()->set_i(source.calibrated_accelerometer[0]);
+            calibrated_sensor_data->mutable_accelerometer()->set_j(source.calibrated_accelerometer[1]);
+            calibrated_sensor_data->mutable_accelerometer()->set_k(source.calibrated_accelerometer[2]);
+
+            calibrated_sensor_data->mutable_gyroscope()->set_i(source.calibrated_gyroscope[0]);
+            calibrated_sensor_data->mutable_gyroscope()->set_j(source.calibrated_gyroscope[1]);
+            calibrated_sensor_data->mutable_gyroscope()->set_k(source.calibrated_gyroscope[2]);
+        }
+
+        // If requested, get the raw tracker data for the controller
+        if (stream_info->include_raw_tracker_data)
+        {
+            auto *raw_tracker_data = psmove_data_frame->mutable_raw_tracker_data();
+
+            if (source.bHasSelectedTrackerProjection)
+            {
+                // The 3d camera position projected back onto the tracker screen
+                {
+                    PSMoveProtocol::Pixel *pixel = raw_tracker_data->mutable_screen_location();
+
+                    pixel->set_x(source.selected_tracker_screen_location.x);
+                    pixel->set_y(source.selected_tracker_screen_location.y);
+                }
+
+                // Add the tracker relative 3d position
+                {
+                    PSMoveProtocol::Position *position_cm= raw_tracker_data->mutable_relative_position_cm();
+
+                    position_cm->set_x(source.selected_tracker_relative_position_cm.x);
+                    position_cm->set_y(source.selected_tracker_relative_position_cm.y);
+                    position_cm->set_z(source.selected_tracker_relative_position_cm.z);
+                }
+
+                // Add the tracker relative projection shapes
+                {
+                    const CommonDeviceTrackingProjection &trackerRelativeProjection =
+                        source.selected_tracker_projection;
+
+                    assert(trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_Ellipse);
+                    PSMoveProtocol::Ellipse *ellipse= raw_tracker_data->mutable_projected_sphere();
+
+                    ellipse->mutable_center()->set_x(trackerRelativeProjection.shape.ellipse.center.x);
+                    ellipse->mutable_center()->set_y(trackerRelativeProjection.shape.ellipse.center.y);
+                    ellipse->set_half_x_extent(trackerRelativeProjection.shape.ellipse.half_x_extent);
+                    ellipse->set_half_y_extent(trackerRelativeProjection.shape.ellipse.half_y_extent);
+                    ellipse->set_angle(trackerRelativeProjection.shape.ellipse.angle);
+                }
+
+                raw_tracker_data->set_tracker_id(source.selected_tracker_id);
+            }
+            raw_tracker_data->set_valid_tracker_bitmask(source.valid_tracker_bitmask);
+
+            if (source.bHasMulticamPosition)
+            {
+                PSMoveProtocol::Position *position_cm = raw_tracker_data->mutable_multicam_position_cm();
+                position_cm->set_x(source.multicam_position_cm.x);
+                position_cm->set_y(source.multicam_position_cm.y);
+                position_cm->set_z(source.multicam_position_cm.z);
+            }
+        }
+
+        // if requested, get the physics data for the controller
+        if (stream_info->include_physics_data)
+        {
+            const CommonDevicePhysics &controller_physics = source.physics;
+            auto *physics_data = psmove_data_frame->mutable_physics_data();
+
+            physics_data->mutable_velocity_cm_per_sec()->set_i(controller_physics.VelocityCmPerSec.i);
+            physics_data->mutable_velocity_cm_per_sec()->set_j(controller_physics.VelocityCmPerSec.j);
+            physics_data->mutable_velocity_cm_per_sec()->set_k(controller_physics.VelocityCmPerSec.k);
+
+            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_i(controller_physics.AccelerationCmPerSecSqr.i);
+            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_j(controller_physics.AccelerationCmPerSecSqr.j);
+            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_k(controller_physics.AccelerationCmPerSecSqr.k);
+
+            physics_data->mutable_angular_velocity_rad_per_sec()->set_i(controller_physics.AngularVelocityRadPerSec.i);
+            physics_data->mutable_angular_velocity_rad_per_sec()->set_j(controller_physics.AngularVelocityRadPerSec.j);
+            physics_data->mutable_angular_velocity_rad_per_sec()->set_k(controller_physics.AngularVelocityRadPerSec.k);
+
+            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_i(controller_physics.AngularAccelerationRadPerSecSqr.i);
+            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_j(controller_physics.AngularAccelerationRadPerSecSqr.j);
+            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_k(controller_physics.AngularAccelerationRadPerSecSqr.k);
+        }
+    }
+
+    controller_data_frame->set_controller_type(PSMoveProtocol::PSMOVE);
+}
+
+void encode_psmove_raw_data_frame(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo *stream_info,
+    RawPSMoveDataFrame *raw_frame)
+{
+    if (source.bIsConnected)
+    {
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_CONNECTED;
+    }
+
+    if (!source.bHasControllerState)
+    {
+        return;
+    }
+
+    uint16_t section_flags= 0;
+
+    if (source.bHasValidHardwareCalibration)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_VALID_HARDWARE_CALIBRATION;
+    if (source.bIsTrackingEnabled)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_TRACKING_ENABLED;
+    if (source.bIsCurrentlyTracking)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_CURRENTLY_TRACKING;
+    if (source.bIsOrientationValid)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_ORIENTATION_VALID;
+    if (source.bIsPositionValid)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_POSITION_VALID;
+
+    raw_frame->pose.orientation.w= source.pose.Orientation.w;
+    raw_frame->pose.orientation.x= source.pose.Orientation.x;
+    raw_frame->pose.orientation.y= source.pose.Orientation.y;
+    raw_frame->pose.orientation.z= source.pose.Orientation.z;
+
+    // The position stays zeroed when it wasn't asked for
+    if (stream_info->include_position_data)
+    {
+        raw_frame->pose.position_cm.x= source.pose.PositionCm.x;
+        raw_frame->pose.position_cm.y= source.pose.PositionCm.y;
+        raw_frame->pose.position_cm.z= source.pose.PositionCm.z;
+        section_flags|= RAW_DATA_FRAME_SECTION_POSITION;
+    }
+
+    raw_frame->trigger_value= source.trigger_value;
+    raw_frame->battery_value= source.battery_value;
+    raw_frame->button_down_bitmask= source.button_bitmask;
+
+    if (stream_info->include_raw_sensor_data)
+    {
+        RawPSMoveRawSensorSection &raw_sensor_data= raw_frame->raw_sensor_data;
+
+        raw_sensor_data.magnetometer.x= source.raw_magnetometer[0];
+        raw_sensor_data.magnetometer.y= source.raw_magnetometer[1];
+        raw_sensor_data.magnetometer.z= source.raw_magnetometer[2];
+        raw_sensor_data.accelerometer.x= source.raw_accelerometer[0];
+        raw_sensor_data.accelerometer.y= source.raw_accelerometer[1];
+        raw_sensor_data.accelerometer.z= source.raw_accelerometer[2];
+        raw_sensor_data.gyroscope.x= source.raw_gyroscope[0];
+        raw_sensor_data.gyroscope.y= source.raw_gyroscope[1];
+        raw_sensor_data.gyroscope.z= source.raw_gyroscope[2];
+        section_flags|= RAW_DATA_FRAME_SECTION_RAW_SENSOR;
+    }
+
+    if (stream_info->include_calibrated_sensor_data)
+    {
+        RawPSMoveCalibratedSensorSection &calibrated_sensor_data= raw_frame->calibrated_sensor_data;
+
+        calibrated_sensor_data.magnetometer.x= source.calibrated_magnetometer[0];
+        calibrated_sensor_data.magnetometer.y= source.calibrated_magnetometer[1];
+        calibrated_sensor_data.magnetometer.z= source.calibrated_magnetometer[2];
+        calibrated_sensor_data.accelerometer.x= source.calibrated_accelerometer[0];
+        calibrated_sensor_data.accelerometer.y= source.calibrated_accelerometer[1];
+        calibrated_sensor_data.accelerometer.z= source.calibrated_accelerometer[2];
+        calibrated_sensor_data.gyroscope.x= source.calibrated_gyroscope[0];
+        calibrated_sensor_data.gyroscope.y= source.calibrated_gyroscope[1];
+        calibrated_sensor_data.gyroscope.z= source.calibrated_gyroscope[2];
+        section_flags|= RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR;
+    }
+
+    if (stream_info->include_raw_tracker_data)
+    {
+        RawTrackerDataSection &raw_tracker_data= raw_frame->raw_tracker_data;
+
+        raw_tracker_data.valid_tracker_bitmask= source.valid_tracker_bitmask;
+
+        if (source.bHasSelectedTrackerProjection)
+        {
+            const CommonDeviceTrackingProjection &trackerRelativeProjection = source.selected_tracker_projection;
+
+            raw_tracker_data.tracker_id= source.selected_tracker_id;
+            raw_tracker_data.screen_location_x= source.selected_tracker_screen_location.x;
+            raw_tracker_data.screen_location_y= source.selected_tracker_screen_location.y;
+            raw_tracker_data.relative_position_cm.x= source.selected_tracker_relative_position_cm.x;
+            raw_tracker_data.relative_position_cm.y= source.selected_tracker_relative_position_cm.y;
+            raw_tracker_data.relative_position_cm.z= source.selected_tracker_relative_position_cm.z;
+
+            assert(trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_Ellipse);
+            raw_tracker_data.projected_sphere_center_x= trackerRelativeProjection.shape.ellipse.center.x;
+            raw_tracker_data.projected_sphere_center_y= trackerRelativeProjection.shape.ellipse.center.y;
+            raw_tracker_data.projected_sphere_half_x_extent= trackerRelativeProjection.shape.ellipse.half_x_extent;
+            raw_tracker_data.projected_sphere_half_y_extent= trackerRelativeProjection.shape.ellipse.half_y_extent;
+            raw_tracker_data.projected_sphere_angle= trackerRelativeProjection.shape.ellipse.angle;
+            raw_tracker_data.valid_flags|= RAW_TRACKER_DATA_PROJECTED_SPHERE_VALID;
+        }
+
+        if (source.bHasMulticamPosition)
+        {
+            raw_tracker_data.multicam_position_cm.x= source.multicam_position_cm.x;
+            raw_tracker_data.multicam_position_cm.y= source.multicam_position_cm.y;
+            raw_tracker_data.multicam_position_cm.z= source.multicam_position_cm.z;
+            raw_tracker_data.valid_flags|= RAW_TRACKER_DATA_MULTICAM_POSITION_VALID;
+        }
+
+        section_flags|= RAW_DATA_FRAME_SECTION_RAW_TRACKER;
+    }
+
+    if (stream_info->include_physics_data)
+    {
+        const CommonDevicePhysics &controller_physics = source.physics;
+        RawPhysicsDataSection &physics_data= raw_frame->physics_data;
+
+        physics_data.velocity_cm_per_sec.x= controller_physics.VelocityCmPerSec.i;
+        physics_data.velocity_cm_per_sec.y= controller_physics.VelocityCmPerSec.j;
+        physics_data.velocity_cm_per_sec.z= controller_physics.VelocityCmPerSec.k;
+        physics_data.acceleration_cm_per_sec_sqr.x= controller_physics.AccelerationCmPerSecSqr.i;
+        physics_data.acceleration_cm_per_sec_sqr.y= controller_physics.AccelerationCmPerSecSqr.j;
+        physics_data.acceleration_cm_per_sec_sqr.z= controller_physics.AccelerationCmPerSecSqr.k;
+        physics_data.angular_velocity_rad_per_sec.x= controller_physics.AngularVelocityRadPerSec.i;
+        physics_data.angular_velocity_rad_per_sec.y= controller_physics.AngularVelocityRadPerSec.j;
+        physics_data.angular_velocity_rad_per_sec.z= controller_physics.AngularVelocityRadPerSec.k;
+        physics_data.angular_acceleration_rad_per_sec_sqr.x= controller_physics.AngularAccelerationRadPerSecSqr.i;
+        physics_data.angular_acceleration_rad_per_sec_sqr.y= controller_physics.AngularAccelerationRadPerSecSqr.j;
+        physics_data.angular_acceleration_rad_per_sec_sqr.z= controller_physics.AngularAccelerationRadPerSecSqr.k;
+        section_flags|= RAW_DATA_FRAME_SECTION_PHYSICS;
+    }
+
+    raw_frame->header.section_flags= section_flags;
+}
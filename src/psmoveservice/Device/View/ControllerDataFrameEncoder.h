@@ -0,0 +1,68 @@
+#ifndef CONTROLLER_DATA_FRAME_ENCODER_H
+#define CONTROLLER_DATA_FRAME_ENCODER_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+
+//-- pre-declarations -----
+struct ControllerStreamInfo;
+struct RawPSMoveDataFrame;
+namespace PSMoveProtocol
+{
+    class DeviceOutputDataFrame;
+};
+
+//-- definitions -----
+/// Everything a PSMove data frame gets built from.
+/// ServerControllerView reads it out of the controller, its pose filter and the trackers,
+/// only filling in the optional parts the stream asked for.
+struct PSMoveDataFrameSource
+{
+    bool bIsConnected;
+    bool bHasControllerState; // false until the first input report, only bIsConnected gets sent before that
+    bool bHasValidHardwareCalibration;
+    bool bIsTrackingEnabled;
+    bool bIsCurrentlyTracking;
+    bool bIsOrientationValid;
+    bool bIsPositionValid;
+
+    CommonDevicePose pose;
+    CommonDevicePhysics physics;
+
+    unsigned int button_bitmask; // PSMoveProtocol ButtonType bits
+    unsigned char trigger_value;
+    unsigned char battery_value;
+
+    // The most recent of the two accelerometer/gyroscope frames in an input report
+    int raw_magnetometer[3];
+    int raw_accelerometer[3];
+    int raw_gyroscope[3];
+    float calibrated_magnetometer[3];
+    float calibrated_accelerometer[3];
+    float calibrated_gyroscope[3];
+
+    unsigned int valid_tracker_bitmask;
+    bool bHasSelectedTrackerProjection;
+    int selected_tracker_id;
+    CommonDeviceScreenLocation selected_tracker_screen_location;
+    CommonDevicePosition selected_tracker_relative_position_cm;
+    CommonDeviceTrackingProjection selected_tracker_projection;
+    bool bHasMulticamPosition;
+    CommonDevicePosition multicam_position_cm;
+};
+
+/// Writes the PSMove state of a protobuf controller data frame.
+/// The caller sets the fields shared by every controller type (id, sequence number, times, ...).
+void encode_psmove_data_frame(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo *stream_info,
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+
+/// Writes the status flags, sections and section flags of a raw PSMove data frame.
+/// The caller zeroes the frame and initializes its header first.
+void encode_psmove_raw_data_frame(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo *stream_info,
+    RawPSMoveDataFrame *raw_frame);
+
+#endif // CONTROLLER_DATA_FRAME_ENCODER_H
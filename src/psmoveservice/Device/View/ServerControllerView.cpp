@@ -2,13 +2,16 @@
 #include "ServerControllerView.h"
 
 #include "BluetoothRequests.h"
+#include "ControllerDataFrameEncoder.h"
 #include "ControllerManager.h"
 #include "DeviceManager.h"
 #include "MathAlignment.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "CompoundPoseFilter.h"
+#include "DeviceClockModel.h"
 #include "KalmanPoseFilter.h"
+#include "PoseFilterHistory.h"
 #include "PoseFilterInterface.h"
 #include "PSDualShock4Controller.h"
 #include "PSMoveController.h"
@@ -16,20 +19,36 @@
 #include "VirtualController.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
+#include "ServerNetworkManager.h"
+#include "SharedPoseState.h"
 #include "ServerUtility.h"
 #include "ServerTrackerView.h"
 
+#include <algorithm>
 #include <glm/glm.hpp>
 
 //-- constants -----
 static const float k_min_time_delta_seconds = 1 / 120.f;
 static const float k_max_time_delta_seconds = 1 / 30.f;
 
+// IMU samples kept around for re-applying after a late optical pose (a few hundred ms worth)
+static const int k_pose_filter_history_sample_count = 64;
+
+// Both the PSMove and the DualShock4 stamp their input reports with a 16-bit IMU timestamp
+static const int k_imu_timestamp_bits = 16;
+
 //-- macros -----
 #define SET_BUTTON_BIT(bitmask, bit_index, button_state) \
     bitmask|= (button_state == CommonControllerState::Button_DOWN || button_state == CommonControllerState::Button_PRESSED) ? (0x1 << (bit_index)) : 0x0;
 
 //-- private methods -----
+static float compute_state_time_delta_seconds(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &last_arrival_timestamp,
+    const float fallback_time_delta_seconds);
+static DeviceClockModel *create_imu_clock_model(const IControllerInterface *device);
+static unsigned int get_imu_raw_timestamp(const CommonControllerState *controllerState);
 static IPoseFilter *pose_filter_factory(
     const CommonDeviceState::eDeviceType deviceType,
     const std::string &position_filter_type,
@@ -42,9 +61,11 @@ static void init_filters_for_psmove(
     IPoseFilter **out_pose_filter);
 static void update_filters_for_psmove(
     const PSMoveController *psmoveController, const PSMoveControllerState *psmoveState, const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *positionEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *pose_filter);
+    IPoseFilter *pose_filter,
+    PoseFilterHistory *pose_filter_history);
 
 static void init_filters_for_psdualshock4(
     const PSDualShock4Controller *psdualshock4Controller,
@@ -52,9 +73,11 @@ static void init_filters_for_psdualshock4(
     IPoseFilter **out_pose_filter);
 static void update_filters_for_psdualshock4(
     const PSDualShock4Controller *psdualshock4Controller, const PSDualShock4ControllerState *psmoveState, const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *positionEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *pose_filter);
+    IPoseFilter *pose_filter,
+    PoseFilterHistory *pose_filter_history);
 
 static void init_filters_for_virtual_controller(
     const VirtualController *psmoveController, 
@@ -62,16 +85,29 @@ static void init_filters_for_virtual_controller(
     IPoseFilter **out_pose_filter);
 static void update_filters_for_virtual_controller(
     const VirtualController *psmoveController, const VirtualControllerState *psmoveState, const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *positionEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *pose_filter);
+    IPoseFilter *pose_filter,
+    PoseFilterHistory *pose_filter_history);
+static void fill_optical_sensor_packet(
+    const ControllerOpticalPoseEstimation *poseEstimation,
+    const bool bUseOpticalOrientation,
+    const float min_screen_projection_area,
+    PoseSensorPacket *out_sensor_packet);
 
+static void get_psmove_data_frame_source(
+    const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveDataFrameSource *out_source);
 static void generate_psmove_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+static void generate_psmove_raw_data_frame_for_stream(
+    const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, RawPSMoveDataFrame *raw_frame);
 static void generate_psnavi_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 static void generate_psdualshock4_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+static void generate_psdualshock4_raw_data_frame_for_stream(
+    const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, RawDualShock4DataFrame *raw_frame);
 static void generate_virtual_controller_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 
@@ -112,9 +148,13 @@ ServerControllerView::ServerControllerView(const int device_id)
     , m_multicam_pose_estimation(nullptr)
     , m_pose_filter(nullptr)
     , m_pose_filter_space(nullptr)
+    , m_pose_filter_history(nullptr)
+    , m_imu_clock_model(nullptr)
+    , m_last_fused_capture_timestamp()
     , m_lastPollSeqNumProcessed(-1)
     , m_last_filter_update_timestamp()
     , m_last_filter_update_timestamp_valid(false)
+    , m_last_state_arrival_timestamp()
 {
     m_tracking_color = std::make_tuple(0x00, 0x00, 0x00);
     m_LED_override_color = std::make_tuple(0x00, 0x00, 0x00);
@@ -198,6 +238,18 @@ void ServerControllerView::free_device_interface()
         m_tracker_pose_estimations = nullptr;
     }
 
+    if (m_pose_filter_history != nullptr)
+    {
+        delete m_pose_filter_history;
+        m_pose_filter_history= nullptr;
+    }
+
+    if (m_imu_clock_model != nullptr)
+    {
+        delete m_imu_clock_model;
+        m_imu_clock_model= nullptr;
+    }
+
     if (m_pose_filter != nullptr)
     {
         delete m_pose_filter;
@@ -275,6 +327,18 @@ bool ServerControllerView::open(const class DeviceEnumerator *enumerator)
             break;
         }
 
+        // Integrate the IMU samples at the times the controller took them
+        if (m_imu_clock_model != nullptr)
+        {
+            delete m_imu_clock_model;
+            m_imu_clock_model= nullptr;
+        }
+
+        if (m_pose_filter != nullptr)
+        {
+            m_imu_clock_model= create_imu_clock_model(m_device);
+        }
+
         // Reset the poll sequence number high water mark
         m_lastPollSeqNumProcessed= -1;
     }
@@ -308,6 +372,7 @@ bool ServerControllerView::open(const class DeviceEnumerator *enumerator)
     // Clear the filter update timestamp
     m_last_filter_update_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
     m_last_filter_update_timestamp_valid= false;
+    m_last_state_arrival_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
 
     return bSuccess;
 }
@@ -326,6 +391,9 @@ void ServerControllerView::close()
     }
 
     ServerDeviceView::close();
+
+    // Let same-host clients know the controller is gone
+    publish_shared_pose();
 }
 
 bool ServerControllerView::recenterOrientation(const CommonDeviceQuaternion& q_pose_relative_to_identity_pose)
@@ -370,6 +438,13 @@ bool ServerControllerView::recenterOrientation(const CommonDeviceQuaternion& q_p
         // Tell the pose filter that the orientation state should now be relative to controller_pose_relative_to_global_forward
         filter->recenterOrientation(controller_pose_relative_to_global_forward);
         bSuccess = true;
+
+        // Rewinding past the recenter would undo it, so start the history over
+        if (m_pose_filter_history != nullptr)
+        {
+            m_pose_filter_history->clear();
+            m_last_fused_capture_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        }
     }
 
     return bSuccess;
@@ -379,6 +454,12 @@ void ServerControllerView::resetPoseFilter()
 {
     assert(m_device != nullptr);
 
+    if (m_pose_filter_history != nullptr)
+    {
+        delete m_pose_filter_history;
+        m_pose_filter_history = nullptr;
+    }
+
     if (m_pose_filter != nullptr)
     {
         delete m_pose_filter;
@@ -412,6 +493,20 @@ void ServerControllerView::resetPoseFilter()
                 &m_pose_filter_space, &m_pose_filter);
         } break;
     }
+
+    // Keep snapshots of the filter state around so that optical poses
+    // can be fused at the time their video frame was captured
+    if (m_pose_filter != nullptr &&
+        DeviceManager::getInstance()->m_tracker_manager->getConfig().delayed_optical_fusion)
+    {
+        m_pose_filter_history = new PoseFilterHistory();
+        if (!m_pose_filter_history->init(m_pose_filter, k_pose_filter_history_sample_count))
+        {
+            delete m_pose_filter_history;
+            m_pose_filter_history = nullptr;
+        }
+    }
+    m_last_fused_capture_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
 }
 
 void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_manager)
@@ -426,6 +521,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
     {
         int valid_projection_tracker_ids[TrackerManager::k_max_devices];
         int projections_found = 0;
+        std::chrono::time_point<std::chrono::high_resolution_clock> newest_frame_timestamp;
 
         CommonDeviceTrackingShape trackingShape;
         m_device->getTrackingShape(trackingShape);
@@ -445,6 +541,8 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 
             if (tracker->getIsOpen())
             {
+                newest_frame_timestamp = std::max(newest_frame_timestamp, tracker->getLastNewDataTimestamp());
+
                 // See how long it's been since we got a new video frame
                 const std::chrono::time_point<std::chrono::high_resolution_clock> now= 
                     std::chrono::high_resolution_clock::now();
@@ -478,6 +576,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
                             // Actually apply the pose estimate state
                             trackerPoseEstimateRef= newTrackerPoseEstimate;
                             trackerPoseEstimateRef.last_visible_timestamp = now;
+                            trackerPoseEstimateRef.capture_timestamp = tracker->getLastNewDataTimestamp();
                         }
                     }
 
@@ -576,6 +675,22 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
         if (m_multicam_pose_estimation->bCurrentlyTracking)
         {
             m_multicam_pose_estimation->last_visible_timestamp = now;
+
+            // The pose is as old as the newest video frame it was computed from
+            m_multicam_pose_estimation->capture_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+            for (int list_index = 0; list_index < projections_found; ++list_index)
+            {
+                m_multicam_pose_estimation->capture_timestamp =
+                    std::max(
+                        m_multicam_pose_estimation->capture_timestamp,
+                        m_tracker_pose_estimations[valid_projection_tracker_ids[list_index]].capture_timestamp);
+            }
+        }
+        else
+        {
+            // Not tracked as of the newest video frame
+            m_multicam_pose_estimation->capture_timestamp =
+                (newest_frame_timestamp.time_since_epoch().count() != 0) ? newest_frame_timestamp : now;
         }
         m_multicam_pose_estimation->last_update_timestamp = now;
         m_multicam_pose_estimation->bValidTimestamps = true;
@@ -620,14 +735,47 @@ void ServerControllerView::updateStateAndPredict()
     m_last_filter_update_timestamp = now;
     m_last_filter_update_timestamp_valid = true;
 
-    // Evenly apply the list of controller state updates over the time since last filter update
+    // Evenly apply the list of controller state updates over the time since last filter update,
+    // unless the states were timestamped when their input reports arrived
     float per_state_time_delta_seconds = time_delta_seconds / static_cast<float>(firstLookBackIndex + 1);
 
+    // The pose filter history and the IMU clock model need the time each state was sampled at
+    // on the service monotonic clock, the same clock the optical pose capture times get converted to
+    const std::chrono::time_point<std::chrono::high_resolution_clock> unknown_timestamp;
+    const bool bUseStateTimes = m_pose_filter_history != nullptr || m_imu_clock_model != nullptr;
+    const double now_seconds = bUseStateTimes ? ServerUtility::to_monotonic_time_seconds(now) : 0.0;
+
     // Process the polled controller states forward in time
     // computing the new orientation along the way.
     for (int lookBackIndex= firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
     {
         const CommonControllerState *controllerState= getState(lookBackIndex);
+        float state_time_delta_seconds=
+            compute_state_time_delta_seconds(
+                controllerState->ArrivalTimestamp, m_last_state_arrival_timestamp, per_state_time_delta_seconds);
+        double state_time_seconds = 0.0;
+
+        if (bUseStateTimes)
+        {
+            state_time_seconds =
+                (controllerState->ArrivalTimestamp != unknown_timestamp)
+                ? ServerUtility::to_monotonic_time_seconds(controllerState->ArrivalTimestamp)
+                : now_seconds - static_cast<double>(lookBackIndex * per_state_time_delta_seconds);
+        }
+
+        // Once the controller clock has been measured, integrate with the spacing of the samples on it
+        // rather than the jittery arrival times of the input reports
+        if (m_imu_clock_model != nullptr)
+        {
+            m_imu_clock_model->addSample(get_imu_raw_timestamp(controllerState), state_time_seconds);
+
+            if (m_imu_clock_model->getIsValid())
+            {
+                state_time_delta_seconds=
+                    clampf(static_cast<float>(m_imu_clock_model->getSampleTimeDeltaSeconds()), 0.f, k_max_time_delta_seconds);
+                state_time_seconds= m_imu_clock_model->getSampleTimeSeconds();
+            }
+        }
 
         switch (controllerState->DeviceType)
         {
@@ -639,10 +787,12 @@ void ServerControllerView::updateStateAndPredict()
                 // Only update the position filter when tracking is enabled
                 update_filters_for_psmove(
                     psmoveController, psmoveState, 
-                    per_state_time_delta_seconds,
+                    state_time_delta_seconds,
+                    state_time_seconds,
                     m_multicam_pose_estimation, 
                     m_pose_filter_space,
-                    m_pose_filter);
+                    m_pose_filter,
+                    m_pose_filter_history);
             } break;
         case CommonControllerState::PSNavi:
             {
@@ -658,10 +808,12 @@ void ServerControllerView::updateStateAndPredict()
                 // Only update the position filter when tracking is enabled
                 update_filters_for_psdualshock4(
                     psdualshock4Controller, psdualshock4State,
-                    per_state_time_delta_seconds,
+                    state_time_delta_seconds,
+                    state_time_seconds,
                     m_multicam_pose_estimation,
                     m_pose_filter_space,
-                    m_pose_filter);
+                    m_pose_filter,
+                    m_pose_filter_history);
             } break;
         case CommonControllerState::VirtualController:
             {
@@ -672,10 +824,12 @@ void ServerControllerView::updateStateAndPredict()
                 // Only update the position filter when tracking is enabled
                 update_filters_for_virtual_controller(
                     virtualController, virtualControllerState,
-                    per_state_time_delta_seconds,
+                    state_time_delta_seconds,
+                    state_time_seconds,
                     m_multicam_pose_estimation,
                     m_pose_filter_space,
-                    m_pose_filter);
+                    m_pose_filter,
+                    m_pose_filter_history);
             } break;
         default:
             assert(0 && "Unhandled controller type");
@@ -683,6 +837,39 @@ void ServerControllerView::updateStateAndPredict()
 
         // Consider this controller state sequence num processed
         m_lastPollSeqNumProcessed= controllerState->PollSequenceNumber;
+        m_last_state_arrival_timestamp= controllerState->ArrivalTimestamp;
+    }
+
+    // Fuse the newest optical pose at the time its video frame was captured,
+    // re-applying the IMU samples that arrived since
+    if (m_pose_filter_history != nullptr &&
+        m_multicam_pose_estimation != nullptr &&
+        m_multicam_pose_estimation->bValidTimestamps &&
+        m_multicam_pose_estimation->capture_timestamp != m_last_fused_capture_timestamp)
+    {
+        const float capture_latency_seconds =
+            DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_capture_latency_ms / 1000.f;
+        const double capture_time_seconds =
+            ServerUtility::to_monotonic_time_seconds(m_multicam_pose_estimation->capture_timestamp)
+            - static_cast<double>(capture_latency_seconds);
+        PoseSensorPacket opticalPacket;
+
+        switch (m_device->getDeviceType())
+        {
+        case CommonDeviceState::PSDualShock4:
+            fill_optical_sensor_packet(
+                m_multicam_pose_estimation, true,
+                this->castCheckedConst<PSDualShock4Controller>()->getConfig()->min_screen_projection_area,
+                &opticalPacket);
+            break;
+        default:
+            fill_optical_sensor_packet(m_multicam_pose_estimation, false, 0.f, &opticalPacket);
+            break;
+        }
+
+        m_pose_filter_history->applyOpticalMeasurement(
+            capture_time_seconds, opticalPacket, m_pose_filter_space, m_pose_filter);
+        m_last_fused_capture_timestamp = m_multicam_pose_estimation->capture_timestamp;
     }
 }
 
@@ -749,6 +936,36 @@ ServerControllerView::getFilteredPhysics() const
     return physics;
 }
 
+double
+ServerControllerView::getFilteredSampleTimeSeconds() const
+{
+    double sample_time= 0.0;
+
+    if (m_pose_filter_history != nullptr && m_pose_filter->getStateTimeSeconds() > 0.0)
+    {
+        // Timed filter updates know exactly which sample they got to
+        sample_time= m_pose_filter->getStateTimeSeconds();
+    }
+    else if (m_last_filter_update_timestamp_valid)
+    {
+        // The filter was last advanced to the arrival time of the newest state when it had one,
+        // otherwise to the time of the filter update
+        const bool bHasArrivalTimestamp= m_last_state_arrival_timestamp.time_since_epoch().count() != 0;
+
+        sample_time=
+            ServerUtility::to_monotonic_time_seconds(
+                bHasArrivalTimestamp ? m_last_state_arrival_timestamp : m_last_filter_update_timestamp);
+    }
+
+    return sample_time;
+}
+
+double
+ServerControllerView::getFilteredPoseTimeSeconds(float time) const
+{
+    return m_last_filter_update_timestamp_valid ? getFilteredSampleTimeSeconds() + static_cast<double>(time) : 0.0;
+}
+
 bool 
 ServerControllerView::getIsBluetooth() const
 {
@@ -780,6 +997,19 @@ ServerControllerView::getIsStreamable() const
     return bIsStreamableController;
 }
 
+bool
+ServerControllerView::getHasRawDataFrameLayout() const
+{
+    switch (getControllerDeviceType())
+    {
+    case CommonDeviceState::PSMove:
+    case CommonDeviceState::PSDualShock4:
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool 
 ServerControllerView::getIsVirtualController() const
 {
@@ -1107,10 +1337,77 @@ bool ServerControllerView::setControllerRumble(
 
 void ServerControllerView::publish_device_data_frame()
 {
+    // Update the shared memory pose table first so that it's never older than the data frames
+    publish_shared_pose();
+
     // Tell the server request handler we want to send out controller updates.
     // This will call generate_controller_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_controller_data_frame(
-        this, &ServerControllerView::generate_controller_data_frame_for_stream);
+        this, 
+        &ServerControllerView::generate_controller_data_frame_for_stream,
+        &ServerControllerView::generate_controller_raw_data_frame_for_stream);
+}
+
+void ServerControllerView::publish_shared_pose()
+{
+    SharedPoseData pose_data;
+    memset(&pose_data, 0, sizeof(SharedPoseData));
+    pose_data.device_type= -1;
+    pose_data.sequence_num= m_sequence_number;
+
+    if (getIsOpen())
+    {
+        // Same pose the data frames carry: predicted ahead by the controller config's prediction time
+        const CommonDevicePose controller_pose= getFilteredPose(m_device->getPredictionTime());
+
+        pose_data.device_type= static_cast<int32_t>(getControllerDeviceType() - CommonDeviceState::Controller);
+        pose_data.pose_time_seconds= getFilteredPoseTimeSeconds(m_device->getPredictionTime());
+
+        if (m_device->getIsOpen())
+            pose_data.status_flags|= SHARED_POSE_STATUS_CONNECTED;
+        if (getIsTrackingEnabled())
+            pose_data.status_flags|= SHARED_POSE_STATUS_TRACKING_ENABLED;
+        if (getIsCurrentlyTracking())
+            pose_data.status_flags|= SHARED_POSE_STATUS_CURRENTLY_TRACKING;
+
+        if (m_pose_filter != nullptr)
+        {
+            const CommonDevicePhysics controller_physics= getFilteredPhysics();
+
+            if (m_pose_filter->getIsOrientationStateValid())
+                pose_data.status_flags|= SHARED_POSE_STATUS_ORIENTATION_VALID;
+            if (m_pose_filter->getIsPositionStateValid())
+                pose_data.status_flags|= SHARED_POSE_STATUS_POSITION_VALID;
+
+            pose_data.physics_data.velocity_cm_per_sec.x= controller_physics.VelocityCmPerSec.i;
+            pose_data.physics_data.velocity_cm_per_sec.y= controller_physics.VelocityCmPerSec.j;
+            pose_data.physics_data.velocity_cm_per_sec.z= controller_physics.VelocityCmPerSec.k;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.x= controller_physics.AccelerationCmPerSecSqr.i;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.y= controller_physics.AccelerationCmPerSecSqr.j;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.z= controller_physics.AccelerationCmPerSecSqr.k;
+            pose_data.physics_data.angular_velocity_rad_per_sec.x= controller_physics.AngularVelocityRadPerSec.i;
+            pose_data.physics_data.angular_velocity_rad_per_sec.y= controller_physics.AngularVelocityRadPerSec.j;
+            pose_data.physics_data.angular_velocity_rad_per_sec.z= controller_physics.AngularVelocityRadPerSec.k;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.x= controller_physics.AngularAccelerationRadPerSecSqr.i;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.y= controller_physics.AngularAccelerationRadPerSecSqr.j;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.z= controller_physics.AngularAccelerationRadPerSecSqr.k;
+        }
+
+        pose_data.pose.position_cm.x= controller_pose.PositionCm.x;
+        pose_data.pose.position_cm.y= controller_pose.PositionCm.y;
+        pose_data.pose.position_cm.z= controller_pose.PositionCm.z;
+        pose_data.pose.orientation.w= controller_pose.Orientation.w;
+        pose_data.pose.orientation.x= controller_pose.Orientation.x;
+        pose_data.pose.orientation.y= controller_pose.Orientation.y;
+        pose_data.pose.orientation.z= controller_pose.Orientation.z;
+    }
+
+    // Devices can get closed before the device manager finishes starting up
+    DeviceManager *device_manager= DeviceManager::getInstance();
+    if (device_manager != nullptr)
+    {
+        device_manager->publishControllerPose(getDeviceID(), pose_data);
+    }
 }
 
 void ServerControllerView::generate_controller_data_frame_for_stream(
@@ -1124,6 +1421,9 @@ void ServerControllerView::generate_controller_data_frame_for_stream(
     controller_data_frame->set_controller_id(controller_view->getDeviceID());
     controller_data_frame->set_sequence_num(controller_view->m_sequence_number);
     controller_data_frame->set_isconnected(controller_view->getDevice()->getIsOpen());
+    controller_data_frame->set_sample_time_seconds(controller_view->getFilteredSampleTimeSeconds());
+    controller_data_frame->set_pose_time_seconds(
+        controller_view->getFilteredPoseTimeSeconds(controller_view->m_device->getPredictionTime()));
 
     switch (controller_view->getControllerDeviceType())
     {
@@ -1150,212 +1450,198 @@ void ServerControllerView::generate_controller_data_frame_for_stream(
     data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER);
 }
 
-static void generate_psmove_data_frame_for_stream(
+bool ServerControllerView::generate_controller_raw_data_frame_for_stream(
     const ServerControllerView *controller_view,
     const ControllerStreamInfo *stream_info,
-    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+    PackedDeviceDataFrame *out_packed_data_frame)
 {
-    const PSMoveController *psmove_controller= controller_view->castCheckedConst<PSMoveController>();
-    const IPoseFilter *pose_filter= controller_view->getPoseFilter();
-    const PSMoveControllerConfig *psmove_config= psmove_controller->getConfig();
-    const CommonControllerState *controller_state= controller_view->getState();
-    const CommonDevicePose controller_pose = controller_view->getFilteredPose(psmove_config->prediction_time);
-
-    auto *controller_data_frame= data_frame->mutable_controller_data_packet();
-    auto *psmove_data_frame = controller_data_frame->mutable_psmove_state();
-   
-    if (controller_state != nullptr)
-    {        
-        assert(controller_state->DeviceType == CommonDeviceState::PSMove);
-        const PSMoveControllerState * psmove_state= static_cast<const PSMoveControllerState *>(controller_state);
-
-        psmove_data_frame->set_validhardwarecalibration(psmove_config->is_valid);
-        psmove_data_frame->set_iscurrentlytracking(controller_view->getIsCurrentlyTracking());
-        psmove_data_frame->set_istrackingenabled(controller_view->getIsTrackingEnabled());
-        psmove_data_frame->set_isorientationvalid(pose_filter->getIsOrientationStateValid());
-        psmove_data_frame->set_ispositionvalid(pose_filter->getIsPositionStateValid());
-
-        psmove_data_frame->mutable_orientation()->set_w(controller_pose.Orientation.w);
-        psmove_data_frame->mutable_orientation()->set_x(controller_pose.Orientation.x);
-        psmove_data_frame->mutable_orientation()->set_y(controller_pose.Orientation.y);
-        psmove_data_frame->mutable_orientation()->set_z(controller_pose.Orientation.z);
+    bool bSuccess= false;
 
-        if (stream_info->include_position_data)
+    switch (controller_view->getControllerDeviceType())
+    {
+    case CommonControllerState::PSMove:
         {
-            psmove_data_frame->mutable_position_cm()->set_x(controller_pose.PositionCm.x);
-            psmove_data_frame->mutable_position_cm()->set_y(controller_pose.PositionCm.y);
-            psmove_data_frame->mutable_position_cm()->set_z(controller_pose.PositionCm.z);
-        }
-        else
+            RawPSMoveDataFrame raw_frame;
+            memset(&raw_frame, 0, sizeof(RawPSMoveDataFrame));
+
+            init_raw_data_frame_header(
+                raw_frame.header,
+                sizeof(RawPSMoveDataFrame),
+                PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER,
+                PSMoveProtocol::PSMOVE,
+                controller_view->getDeviceID(),
+                controller_view->m_sequence_number);
+            raw_frame.sample_time_seconds= controller_view->getFilteredSampleTimeSeconds();
+            raw_frame.pose_time_seconds=
+                controller_view->getFilteredPoseTimeSeconds(controller_view->m_device->getPredictionTime());
+            generate_psmove_raw_data_frame_for_stream(controller_view, stream_info, &raw_frame);
+
+            const uint8_t *raw_frame_bytes= reinterpret_cast<const uint8_t *>(&raw_frame);
+            out_packed_data_frame->bytes.assign(raw_frame_bytes, raw_frame_bytes + sizeof(RawPSMoveDataFrame));
+            bSuccess= true;
+        } break;
+    case CommonControllerState::PSDualShock4:
         {
-            psmove_data_frame->mutable_position_cm()->set_x(0);
-            psmove_data_frame->mutable_position_cm()->set_y(0);
-            psmove_data_frame->mutable_position_cm()->set_z(0);
-        }
-
-        psmove_data_frame->set_trigger_value(psmove_state->TriggerValue);
-        psmove_data_frame->set_battery_value(psmove_state->BatteryValue);
+            RawDualShock4DataFrame raw_frame;
+            memset(&raw_frame, 0, sizeof(RawDualShock4DataFrame));
+
+            init_raw_data_frame_header(
+                raw_frame.header,
+                sizeof(RawDualShock4DataFrame),
+                PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER,
+                PSMoveProtocol::PSDUALSHOCK4,
+                controller_view->getDeviceID(),
+                controller_view->m_sequence_number);
+            raw_frame.sample_time_seconds= controller_view->getFilteredSampleTimeSeconds();
+            raw_frame.pose_time_seconds=
+                controller_view->getFilteredPoseTimeSeconds(controller_view->m_device->getPredictionTime());
+            generate_psdualshock4_raw_data_frame_for_stream(controller_view, stream_info, &raw_frame);
+
+            const uint8_t *raw_frame_bytes= reinterpret_cast<const uint8_t *>(&raw_frame);
+            out_packed_data_frame->bytes.assign(raw_frame_bytes, raw_frame_bytes + sizeof(RawDualShock4DataFrame));
+            bSuccess= true;
+        } break;
+    default:
+        // No raw layout for this controller type (see getHasRawDataFrameLayout)
+        break;
+    }
 
-        unsigned int button_bitmask= 0;
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psmove_state->Triangle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psmove_state->Circle);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psmove_state->Cross);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psmove_state->Square);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SELECT, psmove_state->Select);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::START, psmove_state->Start);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psmove_state->PS);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::MOVE, psmove_state->Move);
-        SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psmove_state->Trigger);
-        controller_data_frame->set_button_down_bitmask(button_bitmask);
+    if (bSuccess)
+    {
+        out_packed_data_frame->device_category= PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER;
+        out_packed_data_frame->device_id= controller_view->getDeviceID();
+    }
 
-        // If requested, get the raw sensor data for the controller
-        if (stream_info->include_raw_sensor_data)
-        {
-            auto *raw_sensor_data= psmove_data_frame->mutable_raw_sensor_data();
+    return bSuccess;
+}
 
-            // One frame: [mx, my, mz] 
-            raw_sensor_data->mutable_magnetometer()->set_i(psmove_state->RawMag[0]);
-            raw_sensor_data->mutable_magnetometer()->set_j(psmove_state->RawMag[1]);
-            raw_sensor_data->mutable_magnetometer()->set_k(psmove_state->RawMag[2]);
+static void get_psmove_data_frame_source(
+    const ServerControllerView *controller_view,
+    const ControllerStreamInfo *stream_info,
+    PSMoveDataFrameSource *out_source)
+{
+    const PSMoveController *psmove_controller= controller_view->castCheckedConst<PSMoveController>();
+    const IPoseFilter *pose_filter= controller_view->getPoseFilter();
+    const PSMoveControllerConfig *psmove_config= psmove_controller->getConfig();
+    const CommonControllerState *controller_state= controller_view->getState();
 
-            // Two frames: [[ax0, ay0, az0], [ax1, ay1, az1]] 
-            // Take the most recent frame: [ax1, ay1, az1]
-            raw_sensor_data->mutable_accelerometer()->set_i(psmove_state->RawAccel[1][0]);
-            raw_sensor_data->mutable_accelerometer()->set_j(psmove_state->RawAccel[1][1]);
-            raw_sensor_data->mutable_accelerometer()->set_k(psmove_state->RawAccel[1][2]);
+    memset(out_source, 0, sizeof(PSMoveDataFrameSource));
+    out_source->bIsConnected= controller_view->getDevice()->getIsOpen();
+    out_source->bHasControllerState= controller_state != nullptr;
 
-            // Two frames: [[wx0, wy0, wz0], [wx1, wy1, wz1]] 
-            // Take the most recent frame: [wx1, wy1, wz1]
-            raw_sensor_data->mutable_gyroscope()->set_i(psmove_state->RawGyro[1][0]);
-            raw_sensor_data->mutable_gyroscope()->set_j(psmove_state->RawGyro[1][1]);
-            raw_sensor_data->mutable_gyroscope()->set_k(psmove_state->RawGyro[1][2]);
-        }
+    if (controller_state == nullptr)
+    {
+        return;
+    }
 
-        // If requested, get the calibrated sensor data for the controller
-        if (stream_info->include_calibrated_sensor_data)
+    assert(controller_state->DeviceType == CommonDeviceState::PSMove);
+    const PSMoveControllerState * psmove_state= static_cast<const PSMoveControllerState *>(controller_state);
+
+    out_source->bHasValidHardwareCalibration= psmove_config->is_valid;
+    out_source->bIsTrackingEnabled= controller_view->getIsTrackingEnabled();
+    out_source->bIsCurrentlyTracking= controller_view->getIsCurrentlyTracking();
+    out_source->bIsOrientationValid= pose_filter->getIsOrientationStateValid();
+    out_source->bIsPositionValid= pose_filter->getIsPositionStateValid();
+    out_source->pose= controller_view->getFilteredPose(psmove_config->prediction_time);
+
+    out_source->trigger_value= psmove_state->TriggerValue;
+    out_source->battery_value= static_cast<unsigned char>(psmove_state->BatteryValue);
+
+    unsigned int button_bitmask= 0;
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psmove_state->Triangle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psmove_state->Circle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psmove_state->Cross);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psmove_state->Square);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SELECT, psmove_state->Select);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::START, psmove_state->Start);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psmove_state->PS);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::MOVE, psmove_state->Move);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIGGER, psmove_state->Trigger);
+    out_source->button_bitmask= button_bitmask;
+
+    if (stream_info->include_raw_sensor_data)
+    {
+        // One magnetometer frame, two accelerometer/gyroscope frames of which we take the most recent one
+        for (int axis = 0; axis < 3; ++axis)
         {
-            auto *calibrated_sensor_data = psmove_data_frame->mutable_calibrated_sensor_data();
-
-            // One frame: [mx, my, mz] 
-            calibrated_sensor_data->mutable_magnetometer()->set_i(psmove_state->CalibratedMag[0]);
-            calibrated_sensor_data->mutable_magnetometer()->set_j(psmove_state->CalibratedMag[1]);
-            calibrated_sensor_data->mutable_magnetometer()->set_k(psmove_state->CalibratedMag[2]);
-
-            // Two frames: [[ax0, ay0, az0], [ax1, ay1, az1]] 
-            // Take the most recent frame: [ax1, ay1, az1]
-            calibrated_sensor_data->mutable_accelerometer()->set_i(psmove_state->CalibratedAccel[1][0]);
-            calibrated_sensor_data->mutable_accelerometer()->set_j(psmove_state->CalibratedAccel[1][1]);
-            calibrated_sensor_data->mutable_accelerometer()->set_k(psmove_state->CalibratedAccel[1][2]);
-
-            // Two frames: [[wx0, wy0, wz0], [wx1, wy1, wz1]] 
-            // Take the most recent frame: [wx1, wy1, wz1]
-            calibrated_sensor_data->mutable_gyroscope()->set_i(psmove_state->CalibratedGyro[1][0]);
-            calibrated_sensor_data->mutable_gyroscope()->set_j(psmove_state->CalibratedGyro[1][1]);
-            calibrated_sensor_data->mutable_gyroscope()->set_k(psmove_state->CalibratedGyro[1][2]);
+            out_source->raw_magnetometer[axis]= psmove_state->RawMag[axis];
+            out_source->raw_accelerometer[axis]= psmove_state->RawAccel[1][axis];
+            out_source->raw_gyroscope[axis]= psmove_state->RawGyro[1][axis];
         }
+    }
 
-        // If requested, get the raw tracker data for the controller
-        if (stream_info->include_raw_tracker_data)
+    if (stream_info->include_calibrated_sensor_data)
+    {
+        for (int axis = 0; axis < 3; ++axis)
         {
-            auto *raw_tracker_data = psmove_data_frame->mutable_raw_tracker_data();
-            int selectedTrackerId= stream_info->selected_tracker_index;
-            unsigned int validTrackerBitmask= 0;
-
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
-            {
-                const ControllerOpticalPoseEstimation *positionEstimate= 
-                    controller_view->getTrackerPoseEstimate(trackerId);
-
-                if (positionEstimate != nullptr && positionEstimate->bCurrentlyTracking)
-                {
-                    validTrackerBitmask&= (1 << trackerId);
-
-                    if (trackerId == selectedTrackerId)
-                    {
-                        if (positionEstimate != nullptr && positionEstimate->bCurrentlyTracking)
-                        {
-                            const CommonDevicePosition &trackerRelativePosition = positionEstimate->position_cm;
-                            const ServerTrackerViewPtr tracker_view = DeviceManager::getInstance()->getTrackerViewPtr(selectedTrackerId);
-
-                            // Project the 3d camera position back onto the tracker screen
-                            {
-                                const CommonDeviceScreenLocation trackerScreenLocation =
-                                    tracker_view->projectTrackerRelativePosition(&trackerRelativePosition);
-                                PSMoveProtocol::Pixel *pixel = raw_tracker_data->mutable_screen_location();
-
-                                pixel->set_x(trackerScreenLocation.x);
-                                pixel->set_y(trackerScreenLocation.y);
-                            }
-
-                            // Add the tracker relative 3d position
-                            {
-                                PSMoveProtocol::Position *position_cm= raw_tracker_data->mutable_relative_position_cm();
-                        
-                                position_cm->set_x(trackerRelativePosition.x);
-                                position_cm->set_y(trackerRelativePosition.y);
-                                position_cm->set_z(trackerRelativePosition.z);
-                            }
-
-                            // Add the tracker relative projection shapes
-                            {
-                                const CommonDeviceTrackingProjection &trackerRelativeProjection = 
-                                    positionEstimate->projection;
+            out_source->calibrated_magnetometer[axis]= psmove_state->CalibratedMag[axis];
+            out_source->calibrated_accelerometer[axis]= psmove_state->CalibratedAccel[1][axis];
+            out_source->calibrated_gyroscope[axis]= psmove_state->CalibratedGyro[1][axis];
+        }
+    }
 
-                                assert(trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_Ellipse);
-                                PSMoveProtocol::Ellipse *ellipse= raw_tracker_data->mutable_projected_sphere();
-                                
-                                ellipse->mutable_center()->set_x(trackerRelativeProjection.shape.ellipse.center.x);
-                                ellipse->mutable_center()->set_y(trackerRelativeProjection.shape.ellipse.center.y);
-                                ellipse->set_half_x_extent(trackerRelativeProjection.shape.ellipse.half_x_extent);
-                                ellipse->set_half_y_extent(trackerRelativeProjection.shape.ellipse.half_y_extent);
-                                ellipse->set_angle(trackerRelativeProjection.shape.ellipse.angle);
-                            }
+    if (stream_info->include_raw_tracker_data)
+    {
+        const int selectedTrackerId= stream_info->selected_tracker_index;
 
-                            raw_tracker_data->set_tracker_id(selectedTrackerId);
-                        }
-                    }
-                }
-            }
-            raw_tracker_data->set_valid_tracker_bitmask(validTrackerBitmask);
+        for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+        {
+            const ControllerOpticalPoseEstimation *positionEstimate= 
+                controller_view->getTrackerPoseEstimate(trackerId);
 
+            if (positionEstimate != nullptr && positionEstimate->bCurrentlyTracking)
             {
-                const ControllerOpticalPoseEstimation *poseEstimate = controller_view->getMulticamPoseEstimate();
+                out_source->valid_tracker_bitmask|= (1 << trackerId);
 
-                if (poseEstimate->bCurrentlyTracking)
+                if (trackerId == selectedTrackerId)
                 {
-                    PSMoveProtocol::Position *position_cm = raw_tracker_data->mutable_multicam_position_cm();
-                    position_cm->set_x(poseEstimate->position_cm.x);
-                    position_cm->set_y(poseEstimate->position_cm.y);
-                    position_cm->set_z(poseEstimate->position_cm.z);
+                    const ServerTrackerViewPtr tracker_view = DeviceManager::getInstance()->getTrackerViewPtr(selectedTrackerId);
+
+                    // Project the 3d camera position back onto the tracker screen
+                    out_source->selected_tracker_screen_location=
+                        tracker_view->projectTrackerRelativePosition(&positionEstimate->position_cm);
+                    out_source->selected_tracker_relative_position_cm= positionEstimate->position_cm;
+                    out_source->selected_tracker_projection= positionEstimate->projection;
+                    out_source->selected_tracker_id= selectedTrackerId;
+                    out_source->bHasSelectedTrackerProjection= true;
                 }
             }
         }
 
-        // if requested, get the physics data for the controller
-        if (stream_info->include_physics_data)
+        const ControllerOpticalPoseEstimation *poseEstimate = controller_view->getMulticamPoseEstimate();
+        if (poseEstimate->bCurrentlyTracking)
         {
-            const CommonDevicePhysics controller_physics = controller_view->getFilteredPhysics();
-            auto *physics_data = psmove_data_frame->mutable_physics_data();
+            out_source->multicam_position_cm= poseEstimate->position_cm;
+            out_source->bHasMulticamPosition= true;
+        }
+    }
 
-            physics_data->mutable_velocity_cm_per_sec()->set_i(controller_physics.VelocityCmPerSec.i);
-            physics_data->mutable_velocity_cm_per_sec()->set_j(controller_physics.VelocityCmPerSec.j);
-            physics_data->mutable_velocity_cm_per_sec()->set_k(controller_physics.VelocityCmPerSec.k);
+    if (stream_info->include_physics_data)
+    {
+        out_source->physics= controller_view->getFilteredPhysics();
+    }
+}
 
-            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_i(controller_physics.AccelerationCmPerSecSqr.i);
-            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_j(controller_physics.AccelerationCmPerSecSqr.j);
-            physics_data->mutable_acceleration_cm_per_sec_sqr()->set_k(controller_physics.AccelerationCmPerSecSqr.k);
+static void generate_psmove_data_frame_for_stream(
+    const ServerControllerView *controller_view,
+    const ControllerStreamInfo *stream_info,
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+{
+    PSMoveDataFrameSource source;
 
-            physics_data->mutable_angular_velocity_rad_per_sec()->set_i(controller_physics.AngularVelocityRadPerSec.i);
-            physics_data->mutable_angular_velocity_rad_per_sec()->set_j(controller_physics.AngularVelocityRadPerSec.j);
-            physics_data->mutable_angular_velocity_rad_per_sec()->set_k(controller_physics.AngularVelocityRadPerSec.k);
+    get_psmove_data_frame_source(controller_view, stream_info, &source);
+    encode_psmove_data_frame(source, stream_info, data_frame);
+}
 
-            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_i(controller_physics.AngularAccelerationRadPerSecSqr.i);
-            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_j(controller_physics.AngularAccelerationRadPerSecSqr.j);
-            physics_data->mutable_angular_acceleration_rad_per_sec_sqr()->set_k(controller_physics.AngularAccelerationRadPerSecSqr.k);
-        }
-    }   
+static void generate_psmove_raw_data_frame_for_stream(
+    const ServerControllerView *controller_view,
+    const ControllerStreamInfo *stream_info,
+    RawPSMoveDataFrame *raw_frame)
+{
+    PSMoveDataFrameSource source;
 
-    controller_data_frame->set_controller_type(PSMoveProtocol::PSMOVE);
+    get_psmove_data_frame_source(controller_view, stream_info, &source);
+    encode_psmove_raw_data_frame(source, stream_info, raw_frame);
 }
 
 static void generate_psnavi_data_frame_for_stream(
@@ -1640,6 +1926,208 @@ static void generate_psdualshock4_data_frame_for_stream(
     controller_data_frame->set_controller_type(PSMoveProtocol::PSDUALSHOCK4);
 }
 
+static void generate_psdualshock4_raw_data_frame_for_stream(
+    const ServerControllerView *controller_view,
+    const ControllerStreamInfo *stream_info,
+    RawDualShock4DataFrame *raw_frame)
+{
+    const PSDualShock4Controller *ds4_controller= controller_view->castCheckedConst<PSDualShock4Controller>();
+    const IPoseFilter *pose_filter= controller_view->getPoseFilter();
+    const PSDualShock4ControllerConfig *ds4_config= ds4_controller->getConfig();
+    const CommonControllerState *controller_state= controller_view->getState();
+
+    if (controller_view->getDevice()->getIsOpen())
+    {
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_CONNECTED;
+    }
+
+    if (controller_state == nullptr)
+    {
+        return;
+    }
+
+    assert(controller_state->DeviceType == CommonDeviceState::PSDualShock4);
+    const PSDualShock4ControllerState * psds4_state= static_cast<const PSDualShock4ControllerState *>(controller_state);
+    const CommonDevicePose controller_pose = controller_view->getFilteredPose(ds4_config->prediction_time);
+    uint16_t section_flags= 0;
+
+    if (ds4_config->is_valid)
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_VALID_HARDWARE_CALIBRATION;
+    if (controller_view->getIsTrackingEnabled())
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_TRACKING_ENABLED;
+    if (controller_view->getIsCurrentlyTracking())
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_CURRENTLY_TRACKING;
+    if (pose_filter->getIsOrientationStateValid())
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_ORIENTATION_VALID;
+    if (pose_filter->getIsPositionStateValid())
+        raw_frame->status_flags|= RAW_DEVICE_STATUS_POSITION_VALID;
+
+    raw_frame->pose.orientation.w= controller_pose.Orientation.w;
+    raw_frame->pose.orientation.x= controller_pose.Orientation.x;
+    raw_frame->pose.orientation.y= controller_pose.Orientation.y;
+    raw_frame->pose.orientation.z= controller_pose.Orientation.z;
+
+    // The position stays zeroed when it wasn't asked for
+    if (stream_info->include_position_data)
+    {
+        raw_frame->pose.position_cm.x= controller_pose.PositionCm.x;
+        raw_frame->pose.position_cm.y= controller_pose.PositionCm.y;
+        raw_frame->pose.position_cm.z= controller_pose.PositionCm.z;
+        section_flags|= RAW_DATA_FRAME_SECTION_POSITION;
+    }
+
+    raw_frame->left_thumbstick_x= psds4_state->LeftAnalogX;
+    raw_frame->left_thumbstick_y= psds4_state->LeftAnalogY;
+    raw_frame->right_thumbstick_x= psds4_state->RightAnalogX;
+    raw_frame->right_thumbstick_y= psds4_state->RightAnalogY;
+    raw_frame->left_trigger_value= psds4_state->LeftTrigger;
+    raw_frame->right_trigger_value= psds4_state->RightTrigger;
+
+    unsigned int button_bitmask= 0;
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::UP, psds4_state->DPad_Up);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::DOWN, psds4_state->DPad_Down);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::LEFT, psds4_state->DPad_Left);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::RIGHT, psds4_state->DPad_Right);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L1, psds4_state->L1);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R1, psds4_state->R1);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L2, psds4_state->L2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R2, psds4_state->R2);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::L3, psds4_state->L3);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::R3, psds4_state->R3);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRIANGLE, psds4_state->Triangle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CIRCLE, psds4_state->Circle);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::CROSS, psds4_state->Cross);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SQUARE, psds4_state->Square);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::SHARE, psds4_state->Share);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::OPTIONS, psds4_state->Options);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::PS, psds4_state->PS);
+    SET_BUTTON_BIT(button_bitmask, PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket::TRACKPAD, psds4_state->TrackPadButton);
+    raw_frame->button_down_bitmask= button_bitmask;
+
+    if (stream_info->include_raw_sensor_data)
+    {
+        RawIMURawSensorSection &raw_sensor_data= raw_frame->raw_sensor_data;
+
+        raw_sensor_data.accelerometer.x= psds4_state->RawAccelerometer[0];
+        raw_sensor_data.accelerometer.y= psds4_state->RawAccelerometer[1];
+        raw_sensor_data.accelerometer.z= psds4_state->RawAccelerometer[2];
+        raw_sensor_data.gyroscope.x= psds4_state->RawGyro[0];
+        raw_sensor_data.gyroscope.y= psds4_state->RawGyro[1];
+        raw_sensor_data.gyroscope.z= psds4_state->RawGyro[2];
+        section_flags|= RAW_DATA_FRAME_SECTION_RAW_SENSOR;
+    }
+
+    if (stream_info->include_calibrated_sensor_data)
+    {
+        RawIMUCalibratedSensorSection &calibrated_sensor_data= raw_frame->calibrated_sensor_data;
+
+        calibrated_sensor_data.accelerometer.x= psds4_state->CalibratedAccelerometer.i;
+        calibrated_sensor_data.accelerometer.y= psds4_state->CalibratedAccelerometer.j;
+        calibrated_sensor_data.accelerometer.z= psds4_state->CalibratedAccelerometer.k;
+        calibrated_sensor_data.gyroscope.x= psds4_state->CalibratedGyro.i;
+        calibrated_sensor_data.gyroscope.y= psds4_state->CalibratedGyro.j;
+        calibrated_sensor_data.gyroscope.z= psds4_state->CalibratedGyro.k;
+        section_flags|= RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR;
+    }
+
+    if (stream_info->include_raw_tracker_data)
+    {
+        RawTrackerDataSection &raw_tracker_data= raw_frame->raw_tracker_data;
+        RawTrackerPointsSection &raw_tracker_points= raw_frame->raw_tracker_points;
+        const int selectedTrackerId= stream_info->selected_tracker_index;
+
+        raw_tracker_points.relative_orientation.w= 1.f;
+
+        for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+        {
+            const ControllerOpticalPoseEstimation *positionEstimate= 
+                controller_view->getTrackerPoseEstimate(trackerId);
+
+            if (positionEstimate != nullptr && positionEstimate->bCurrentlyTracking)
+            {
+                raw_tracker_data.valid_tracker_bitmask|= (1 << trackerId);
+
+                if (trackerId == selectedTrackerId)
+                {
+                    const CommonDevicePosition &trackerRelativePosition = positionEstimate->position_cm;
+                    const CommonDeviceQuaternion &trackerRelativeOrientation = positionEstimate->orientation;
+                    const CommonDeviceTrackingProjection &trackerRelativeProjection = positionEstimate->projection;
+
+                    raw_tracker_data.tracker_id= selectedTrackerId;
+                    raw_tracker_data.relative_position_cm.x= trackerRelativePosition.x;
+                    raw_tracker_data.relative_position_cm.y= trackerRelativePosition.y;
+                    raw_tracker_data.relative_position_cm.z= trackerRelativePosition.z;
+                    raw_tracker_points.relative_orientation.w= trackerRelativeOrientation.w;
+                    raw_tracker_points.relative_orientation.x= trackerRelativeOrientation.x;
+                    raw_tracker_points.relative_orientation.y= trackerRelativeOrientation.y;
+                    raw_tracker_points.relative_orientation.z= trackerRelativeOrientation.z;
+
+                    // Same as the protobuf data frame: the light bar triangle then quad, centered on the quad
+                    assert(trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_LightBar);
+                    for (int vert_index = 0; vert_index < 3; ++vert_index)
+                    {
+                        raw_tracker_points.points[vert_index].x= trackerRelativeProjection.shape.lightbar.triangle[vert_index].x;
+                        raw_tracker_points.points[vert_index].y= trackerRelativeProjection.shape.lightbar.triangle[vert_index].y;
+                    }
+                    for (int vert_index = 0; vert_index < 4; ++vert_index)
+                    {
+                        const CommonDeviceScreenLocation &screenLocation= trackerRelativeProjection.shape.lightbar.quad[vert_index];
+
+                        raw_tracker_points.points[vert_index + 3].x= screenLocation.x;
+                        raw_tracker_points.points[vert_index + 3].y= screenLocation.y;
+                        raw_tracker_data.screen_location_x+= screenLocation.x / 4.f;
+                        raw_tracker_data.screen_location_y+= screenLocation.y / 4.f;
+                    }
+                    raw_tracker_points.point_count= 7;
+                    raw_tracker_data.valid_flags|= RAW_TRACKER_DATA_PROJECTED_POINTS_VALID;
+                }
+            }
+        }
+
+        const ControllerOpticalPoseEstimation *poseEstimate = controller_view->getMulticamPoseEstimate();
+        if (poseEstimate->bCurrentlyTracking)
+        {
+            raw_tracker_data.multicam_position_cm.x= poseEstimate->position_cm.x;
+            raw_tracker_data.multicam_position_cm.y= poseEstimate->position_cm.y;
+            raw_tracker_data.multicam_position_cm.z= poseEstimate->position_cm.z;
+            raw_tracker_data.valid_flags|= RAW_TRACKER_DATA_MULTICAM_POSITION_VALID;
+
+            if (poseEstimate->bOrientationValid)
+            {
+                raw_tracker_points.multicam_orientation.w= poseEstimate->orientation.w;
+                raw_tracker_points.multicam_orientation.x= poseEstimate->orientation.x;
+                raw_tracker_points.multicam_orientation.y= poseEstimate->orientation.y;
+                raw_tracker_points.multicam_orientation.z= poseEstimate->orientation.z;
+                raw_tracker_data.valid_flags|= RAW_TRACKER_DATA_MULTICAM_ORIENTATION_VALID;
+            }
+        }
+
+        section_flags|= RAW_DATA_FRAME_SECTION_RAW_TRACKER;
+    }
+
+    if (stream_info->include_physics_data)
+    {
+        const CommonDevicePhysics controller_physics = controller_view->getFilteredPhysics();
+        RawPhysicsDataSection &physics_data= raw_frame->physics_data;
+
+        physics_data.velocity_cm_per_sec.x= controller_physics.VelocityCmPerSec.i;
+        physics_data.velocity_cm_per_sec.y= controller_physics.VelocityCmPerSec.j;
+        physics_data.velocity_cm_per_sec.z= controller_physics.VelocityCmPerSec.k;
+        physics_data.acceleration_cm_per_sec_sqr.x= controller_physics.AccelerationCmPerSecSqr.i;
+        physics_data.acceleration_cm_per_sec_sqr.y= controller_physics.AccelerationCmPerSecSqr.j;
+        physics_data.acceleration_cm_per_sec_sqr.z= controller_physics.AccelerationCmPerSecSqr.k;
+        physics_data.angular_velocity_rad_per_sec.x= controller_physics.AngularVelocityRadPerSec.i;
+        physics_data.angular_velocity_rad_per_sec.y= controller_physics.AngularVelocityRadPerSec.j;
+        physics_data.angular_velocity_rad_per_sec.z= controller_physics.AngularVelocityRadPerSec.k;
+        physics_data.angular_acceleration_rad_per_sec_sqr.x= controller_physics.AngularAccelerationRadPerSecSqr.i;
+        physics_data.angular_acceleration_rad_per_sec_sqr.y= controller_physics.AngularAccelerationRadPerSecSqr.j;
+        physics_data.angular_acceleration_rad_per_sec_sqr.z= controller_physics.AngularAccelerationRadPerSecSqr.k;
+        section_flags|= RAW_DATA_FRAME_SECTION_PHYSICS;
+    }
+
+    raw_frame->header.section_flags= section_flags;
+}
+
 static void generate_virtual_controller_data_frame_for_stream(
     const ServerControllerView *controller_view, const ControllerStreamInfo *stream_info, PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
@@ -1779,6 +2267,78 @@ static void generate_virtual_controller_data_frame_for_stream(
     controller_data_frame->set_controller_type(PSMoveProtocol::VIRTUALCONTROLLER);
 }
 
+static float
+compute_state_time_delta_seconds(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &last_arrival_timestamp,
+    const float fallback_time_delta_seconds)
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> unknown_timestamp;
+    float time_delta_seconds = fallback_time_delta_seconds;
+
+    // Use the actual spacing of the input reports when both were timestamped on arrival
+    if (arrival_timestamp != unknown_timestamp && last_arrival_timestamp != unknown_timestamp)
+    {
+        const std::chrono::duration<float> time_delta = arrival_timestamp - last_arrival_timestamp;
+
+        if (time_delta.count() > 0.f)
+        {
+            time_delta_seconds = clampf(time_delta.count(), 0.f, k_max_time_delta_seconds);
+        }
+    }
+
+    return time_delta_seconds;
+}
+
+static DeviceClockModel *
+create_imu_clock_model(const IControllerInterface *device)
+{
+    bool bUseImuTimestamps = false;
+
+    switch (device->getDeviceType())
+    {
+    case CommonDeviceState::PSMove:
+        bUseImuTimestamps = static_cast<const PSMoveController *>(device)->getConfig()->use_imu_timestamps;
+        break;
+    case CommonDeviceState::PSDualShock4:
+        bUseImuTimestamps = static_cast<const PSDualShock4Controller *>(device)->getConfig()->use_imu_timestamps;
+        break;
+    default:
+        // No IMU timestamps on the other controllers
+        break;
+    }
+
+    DeviceClockModel *clock_model = nullptr;
+
+    if (bUseImuTimestamps)
+    {
+        clock_model = new DeviceClockModel();
+        clock_model->init(k_imu_timestamp_bits);
+    }
+
+    return clock_model;
+}
+
+static unsigned int
+get_imu_raw_timestamp(const CommonControllerState *controllerState)
+{
+    unsigned int raw_timestamp = 0;
+
+    switch (controllerState->DeviceType)
+    {
+    case CommonControllerState::PSMove:
+        raw_timestamp = static_cast<const PSMoveControllerState *>(controllerState)->RawTimeStamp;
+        break;
+    case CommonControllerState::PSDualShock4:
+        raw_timestamp = static_cast<const PSDualShock4ControllerState *>(controllerState)->RawTimeStamp;
+        break;
+    default:
+        assert(0 && "Controller has no IMU timestamp");
+    }
+
+    return raw_timestamp;
+}
+
 static IPoseFilter *
 pose_filter_factory(
     const CommonDeviceState::eDeviceType deviceType,
@@ -1987,9 +2547,11 @@ update_filters_for_psmove(
     const PSMoveController *psmoveController, 
     const PSMoveControllerState *psmoveState,
     const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *poseEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *poseFilter)
+    IPoseFilter *poseFilter,
+    PoseFilterHistory *poseFilterHistory)
 {
     const PSMoveControllerConfig *config = psmoveController->getConfig();
     Eigen::Quaternionf orientationFrames[2] = {Eigen::Quaternionf::Identity(), Eigen::Quaternionf::Identity()};
@@ -1999,24 +2561,8 @@ update_filters_for_psmove(
     {
         PoseSensorPacket sensorPacket;
 
-        // PSMove cant do optical orientation
-        sensorPacket.optical_orientation = Eigen::Quaternionf::Identity();
-
-        // PSMove does have an optical position
-        if (poseEstimation->bCurrentlyTracking)
-        {
-            sensorPacket.optical_position_cm =
-            Eigen::Vector3f(
-                    poseEstimation->position_cm.x,
-                    poseEstimation->position_cm.y,
-                    poseEstimation->position_cm.z);
-            sensorPacket.tracking_projection_area_px_sqr = poseEstimation->projection.screen_area;
-        }
-        else
-        {
-            sensorPacket.optical_position_cm = Eigen::Vector3f::Zero();
-            sensorPacket.tracking_projection_area_px_sqr= 0.f;
-        }
+        // PSMove cant do optical orientation, but it does have an optical position
+        fill_optical_sensor_packet(poseEstimation, false, 0.f, &sensorPacket);
 
         // One magnetometer update for every two accel/gryo readings
         sensorPacket.imu_magnetometer_unit =
@@ -2041,14 +2587,25 @@ update_filters_for_psmove(
                     psmoveState->CalibratedGyro[frame][1], 
                     psmoveState->CalibratedGyro[frame][2]);
 
-            // Create a filter input packet from the sensor data 
-            // and the filter's previous orientation and position
-            poseFilterSpace->createFilterPacket(
-                sensorPacket, 
-                poseFilter,
-                filterPacket);
+            if (poseFilterHistory != nullptr)
+            {
+                // The earlier reading was taken half way between the previous state and this one
+                const double frame_time_seconds =
+                    (frame == 0) ? sample_time_seconds - static_cast<double>(delta_time / 2.f) : sample_time_seconds;
 
-            poseFilter->update(delta_time / 2.f, filterPacket);
+                poseFilterHistory->applySample(frame_time_seconds, sensorPacket, poseFilterSpace, poseFilter);
+            }
+            else
+            {
+                // Create a filter input packet from the sensor data 
+                // and the filter's previous orientation and position
+                poseFilterSpace->createFilterPacket(
+                    sensorPacket, 
+                    poseFilter,
+                    filterPacket);
+
+                poseFilter->update(delta_time / 2.f, filterPacket);
+            }
         }
         }
                 }
@@ -2118,9 +2675,11 @@ update_filters_for_psdualshock4(
     const PSDualShock4Controller *psmoveController,
     const PSDualShock4ControllerState *psdualShock4State,
     const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *poseEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *poseFilter)
+    IPoseFilter *poseFilter,
+    PoseFilterHistory *poseFilterHistory)
 {
     const PSDualShock4ControllerConfig *config = psmoveController->getConfig();
 
@@ -2128,38 +2687,7 @@ update_filters_for_psdualshock4(
     {
         PoseSensorPacket sensorPacket;
 
-        if (poseEstimation->bOrientationValid)
-        {
-            sensorPacket.optical_orientation = 
-                Eigen::Quaternionf(
-                    poseEstimation->orientation.w, 
-                    poseEstimation->orientation.x,
-                    poseEstimation->orientation.y,
-                    poseEstimation->orientation.z);
-        }
-        else
-        {
-            sensorPacket.optical_orientation = Eigen::Quaternionf::Identity();
-        }
-
-        if (poseEstimation->bCurrentlyTracking)
-        {
-            const float screen_area =
-                (poseEstimation->projection.screen_area > config->min_screen_projection_area)
-                ? poseEstimation->projection.screen_area : 0.f;
-
-            sensorPacket.optical_position_cm =
-            Eigen::Vector3f(
-                    poseEstimation->position_cm.x,
-                    poseEstimation->position_cm.y,
-                    poseEstimation->position_cm.z);
-            sensorPacket.tracking_projection_area_px_sqr= screen_area;
-        }
-        else
-        {
-            sensorPacket.optical_position_cm = Eigen::Vector3f::Zero();
-            sensorPacket.tracking_projection_area_px_sqr = 0.f;
-        }
+        fill_optical_sensor_packet(poseEstimation, true, config->min_screen_projection_area, &sensorPacket);
 
         sensorPacket.imu_accelerometer_g_units =
             Eigen::Vector3f(
@@ -2173,6 +2701,11 @@ update_filters_for_psdualshock4(
                 psdualShock4State->CalibratedGyro.k);
         sensorPacket.imu_magnetometer_unit = Eigen::Vector3f::Zero();
 
+        if (poseFilterHistory != nullptr)
+        {
+            poseFilterHistory->applySample(sample_time_seconds, sensorPacket, poseFilterSpace, poseFilter);
+        }
+        else
         {
             PoseFilterPacket filterPacket;
 
@@ -2239,9 +2772,11 @@ static void init_filters_for_virtual_controller(
 
 static void update_filters_for_virtual_controller(
     const VirtualController *virtualController, const VirtualControllerState *controllerState, const float delta_time,
+    const double sample_time_seconds,
     const ControllerOpticalPoseEstimation *poseEstimation,
     const PoseFilterSpace *poseFilterSpace,
-    IPoseFilter *poseFilter)
+    IPoseFilter *poseFilter,
+    PoseFilterHistory *poseFilterHistory)
 {
     const VirtualControllerConfig *config = virtualController->getConfig();
 
@@ -2250,28 +2785,17 @@ static void update_filters_for_virtual_controller(
 	{
 		PoseSensorPacket sensorPacket;
 
-		sensorPacket.imu_magnetometer_unit = Eigen::Vector3f::Zero();
-		sensorPacket.optical_orientation = Eigen::Quaternionf::Identity();
-
-		if (poseEstimation->bCurrentlyTracking)
-		{
-			sensorPacket.optical_position_cm =
-				Eigen::Vector3f(
-					poseEstimation->position_cm.x,
-					poseEstimation->position_cm.y,
-					poseEstimation->position_cm.z);
-			sensorPacket.tracking_projection_area_px_sqr = poseEstimation->projection.screen_area;
-		}
-		else
-		{
-			sensorPacket.optical_position_cm = Eigen::Vector3f::Zero();
-			sensorPacket.tracking_projection_area_px_sqr = 0.f;
-		}
+		fill_optical_sensor_packet(poseEstimation, false, 0.f, &sensorPacket);
 
 		sensorPacket.imu_accelerometer_g_units = Eigen::Vector3f::Zero();
 		sensorPacket.imu_gyroscope_rad_per_sec = Eigen::Vector3f::Zero();
 		sensorPacket.imu_magnetometer_unit = Eigen::Vector3f::Zero();
 
+		if (poseFilterHistory != nullptr)
+		{
+			poseFilterHistory->applySample(sample_time_seconds, sensorPacket, poseFilterSpace, poseFilter);
+		}
+		else
 		{
 			PoseFilterPacket filterPacket;
 
@@ -2284,6 +2808,46 @@ static void update_filters_for_virtual_controller(
 	}
 }
 
+static void fill_optical_sensor_packet(
+    const ControllerOpticalPoseEstimation *poseEstimation,
+    const bool bUseOpticalOrientation,
+    const float min_screen_projection_area,
+    PoseSensorPacket *out_sensor_packet)
+{
+    if (bUseOpticalOrientation && poseEstimation->bOrientationValid)
+    {
+        out_sensor_packet->optical_orientation = 
+            Eigen::Quaternionf(
+                poseEstimation->orientation.w, 
+                poseEstimation->orientation.x,
+                poseEstimation->orientation.y,
+                poseEstimation->orientation.z);
+    }
+    else
+    {
+        out_sensor_packet->optical_orientation = Eigen::Quaternionf::Identity();
+    }
+
+    if (poseEstimation->bCurrentlyTracking)
+    {
+        const float screen_area =
+            (poseEstimation->projection.screen_area > min_screen_projection_area)
+            ? poseEstimation->projection.screen_area : 0.f;
+
+        out_sensor_packet->optical_position_cm =
+            Eigen::Vector3f(
+                poseEstimation->position_cm.x,
+                poseEstimation->position_cm.y,
+                poseEstimation->position_cm.z);
+        out_sensor_packet->tracking_projection_area_px_sqr = screen_area;
+    }
+    else
+    {
+        out_sensor_packet->optical_position_cm = Eigen::Vector3f::Zero();
+        out_sensor_packet->tracking_projection_area_px_sqr = 0.f;
+    }
+}
+
 static void computeSpherePoseForControllerFromSingleTracker(
     const ServerControllerView *controllerView,
     const ServerTrackerViewPtr tracker,
@@ -14,6 +14,7 @@ struct ControllerOpticalPoseEstimation
 {
     std::chrono::time_point<std::chrono::high_resolution_clock> last_update_timestamp;
     std::chrono::time_point<std::chrono::high_resolution_clock> last_visible_timestamp;
+    std::chrono::time_point<std::chrono::high_resolution_clock> capture_timestamp; // arrival of the newest video frame the estimate is based on
     bool bValidTimestamps;
 
     CommonDevicePosition position_cm; // centimeters
@@ -27,6 +28,7 @@ struct ControllerOpticalPoseEstimation
     {
         last_update_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
         last_visible_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        capture_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
         bValidTimestamps= false;
 
         position_cm.clear();
@@ -74,12 +76,22 @@ public:
     // Get the current physics from the filter position and orientation
     CommonDevicePhysics getFilteredPhysics() const;
 
+    // Service monotonic time (see ServerUtility::get_monotonic_time_seconds) of the newest
+    // controller state applied to the filter. Zero before the first filter update.
+    double getFilteredSampleTimeSeconds() const;
+
+    // Service monotonic time described by getFilteredPose(time)
+    double getFilteredPoseTimeSeconds(float time= 0.f) const;
+
     // Returns true if the device is connected via Bluetooth, false if by USB
     bool getIsBluetooth() const;
 
 	// Returns true if the device can stream controller data over it's current connection type (Bluetooth/USB)
 	bool getIsStreamable() const;
 
+    // Returns true if the controller type has a fixed-layout raw data frame (see RawDataFrame.h)
+    bool getHasRawDataFrameLayout() const;
+
     // Returns true if this device is a virtual controller
     bool getIsVirtualController() const;
 
@@ -178,12 +190,20 @@ public:
         const struct ControllerStreamInfo *stream_info,
         PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 
+    // Helper used to publish the current controller state as a fixed-layout raw data frame (see RawDataFrame.h).
+    // Returns false for controller types without a raw layout.
+    static bool generate_controller_raw_data_frame_for_stream(
+        const ServerControllerView *controller_view,
+        const struct ControllerStreamInfo *stream_info,
+        struct PackedDeviceDataFrame *out_packed_data_frame);
+
 protected:
     void set_tracking_enabled_internal(bool bEnabled);
     void update_LED_color_internal();
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void publish_shared_pose();
 
 private:
     // Tracking color state
@@ -206,9 +226,13 @@ private:
     ControllerOpticalPoseEstimation *m_multicam_pose_estimation;
     class IPoseFilter *m_pose_filter;
     class PoseFilterSpace *m_pose_filter_space;
+    class PoseFilterHistory *m_pose_filter_history; // nullptr unless optical poses get fused at their capture time
+    class DeviceClockModel *m_imu_clock_model; // nullptr unless the IMU samples get integrated on the controller clock
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_fused_capture_timestamp;
     int m_lastPollSeqNumProcessed;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_filter_update_timestamp;
     bool m_last_filter_update_timestamp_valid;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_state_arrival_timestamp;
 };
 
 #endif // SERVER_CONTROLLER_VIEW_H
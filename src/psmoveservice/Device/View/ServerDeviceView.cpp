@@ -58,51 +58,60 @@ bool ServerDeviceView::poll()
     // Only poll data from open, bluetooth controllers
     if (device != nullptr && device->getIsReadyToPoll())
     {
-        switch (device->poll())
-        {
-        case IDeviceInterface::_PollResultSuccessNoData:
-            {
-                long max_failure= device->getMaxPollFailureCount();
-                
-                ++m_pollNoDataCount;
-
-                if (m_pollNoDataCount > max_failure)
-                {
-                    SERVER_LOG_INFO("ServerDeviceView::poll") <<
-                        "Device id " << getDeviceID() << 
-                        " closing due to no data (" << max_failure << 
-                        " failed poll attempts)";
-                    close();
-                    
-                    bSuccessfullyUpdated= false;
-                }
-            }
-            break;
-                
-        case IDeviceInterface::_PollResultSuccessNewData:
-            {
-                m_pollNoDataCount= 0;
-                m_lastNewDataTimestamp= std::chrono::high_resolution_clock::now();
+        bSuccessfullyUpdated= handle_poll_result(device->poll());
+    }
+    
+    return bSuccessfullyUpdated;
+}
 
-                // If we got new sensor data, then we have new state to publish
-                markStateAsUnpublished();
+bool ServerDeviceView::handle_poll_result(IDeviceInterface::ePollResult poll_result)
+{
+    bool bSuccessfullyUpdated= true;
 
-                bSuccessfullyUpdated= true;
-            }
-            break;
-                
-        case IDeviceInterface::_PollResultFailure:
+    switch (poll_result)
+    {
+    case IDeviceInterface::_PollResultSuccessNoData:
+        {
+            long max_failure= getDevice()->getMaxPollFailureCount();
+            
+            ++m_pollNoDataCount;
+
+            if (m_pollNoDataCount > max_failure)
             {
                 SERVER_LOG_INFO("ServerDeviceView::poll") <<
-                    "Device id " << getDeviceID() << " closing due to failed read";
+                    "Device id " << getDeviceID() << 
+                    " closing due to no data (" << max_failure << 
+                    " failed poll attempts)";
                 close();
                 
                 bSuccessfullyUpdated= false;
             }
-            break;
         }
+        break;
+            
+    case IDeviceInterface::_PollResultSuccessNewData:
+        {
+            m_pollNoDataCount= 0;
+            m_lastNewDataTimestamp= std::chrono::high_resolution_clock::now();
+
+            // If we got new sensor data, then we have new state to publish
+            markStateAsUnpublished();
+
+            bSuccessfullyUpdated= true;
+        }
+        break;
+            
+    case IDeviceInterface::_PollResultFailure:
+        {
+            SERVER_LOG_INFO("ServerDeviceView::poll") <<
+                "Device id " << getDeviceID() << " closing due to failed read";
+            close();
+            
+            bSuccessfullyUpdated= false;
+        }
+        break;
     }
-    
+
     return bSuccessfullyUpdated;
 }
 
@@ -65,6 +65,10 @@ protected:
     virtual void free_device_interface() = 0;
     virtual void publish_device_data_frame() = 0;
 
+    // Updates the no-data/failure bookkeeping for the result of a device poll.
+    // Returns false if the device had to be closed.
+    bool handle_poll_result(IDeviceInterface::ePollResult poll_result);
+
     bool m_bHasUnpublishedState;
     int m_pollNoDataCount;
     int m_sequence_number;
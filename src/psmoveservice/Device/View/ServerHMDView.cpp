@@ -7,9 +7,13 @@
 #include "CompoundPoseFilter.h"
 #include "PoseFilterInterface.h"
 #include "PSMoveProtocol.pb.h"
+#include "RawDataFrame.h"
 #include "ServerLog.h"
+#include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "ServerTrackerView.h"
+#include "ServerUtility.h"
+#include "SharedPoseState.h"
 #include "TrackerManager.h"
 
 //-- constants -----
@@ -17,6 +21,10 @@ static const float k_min_time_delta_seconds = 1 / 120.f;
 static const float k_max_time_delta_seconds = 1 / 30.f;
 
 //-- private methods -----
+static float compute_state_time_delta_seconds(
+	const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+	const std::chrono::time_point<std::chrono::high_resolution_clock> &last_arrival_timestamp,
+	const float fallback_time_delta_seconds);
 static void init_filters_for_morpheus_hmd(
 	const MorpheusHMD *morpheusHMD, PoseFilterSpace **out_pose_filter_space, IPoseFilter **out_pose_filter);
 static void init_filters_for_virtual_hmd(
@@ -35,10 +43,10 @@ static void update_filters_for_virtual_hmd(
 	const HMDOpticalPoseEstimation *poseEstimation, const PoseFilterSpace *poseFilterSpace, IPoseFilter *poseFilter);
 static void generate_morpheus_hmd_data_frame_for_stream(
     const ServerHMDView *hmd_view, const HMDStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame);
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 static void generate_virtual_hmd_data_frame_for_stream(
     const ServerHMDView *hmd_view, const HMDStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame);
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame);
 
 static Eigen::Vector3f CommonDevicePosition_to_EigenVector3f(const CommonDevicePosition &p);
 static Eigen::Vector3f CommonDeviceVector_to_EigenVector3f(const CommonDeviceVector &v);
@@ -86,6 +94,7 @@ ServerHMDView::ServerHMDView(const int device_id)
 	, m_lastPollSeqNumProcessed(-1)
 	, m_last_filter_update_timestamp()
 	, m_last_filter_update_timestamp_valid(false)
+	, m_last_state_arrival_timestamp()
 {
 }
 
@@ -237,6 +246,9 @@ void ServerHMDView::close()
     }
 
     ServerDeviceView::close();
+
+    // Let same-host clients know the HMD is gone
+    publish_shared_pose();
 }
 
 void ServerHMDView::resetPoseFilter()
@@ -480,7 +492,8 @@ void ServerHMDView::updateStateAndPredict()
 	m_last_filter_update_timestamp = now;
 	m_last_filter_update_timestamp_valid = true;
 
-	// Evenly apply the list of hmd state updates over the time since last filter update
+	// Evenly apply the list of hmd state updates over the time since last filter update,
+	// unless the states were timestamped when their sensor reports arrived
 	float per_state_time_delta_seconds = time_delta_seconds / static_cast<float>(firstLookBackIndex + 1);
 
 	// Process the polled hmd states forward in time
@@ -488,6 +501,9 @@ void ServerHMDView::updateStateAndPredict()
 	for (int lookBackIndex = firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
 	{
 		const CommonHMDState *hmdState = getState(lookBackIndex);
+		const float state_time_delta_seconds =
+			compute_state_time_delta_seconds(
+				hmdState->ArrivalTimestamp, m_last_state_arrival_timestamp, per_state_time_delta_seconds);
 
 		switch (hmdState->DeviceType)
 		{
@@ -499,7 +515,7 @@ void ServerHMDView::updateStateAndPredict()
 			    // Only update the position filter when tracking is enabled
 			    update_filters_for_morpheus_hmd(
 				    morpheusHMD, morpheusHMDState,
-				    per_state_time_delta_seconds,
+				    state_time_delta_seconds,
 				    m_multicam_pose_estimation,
 				    m_pose_filter_space,
 				    m_pose_filter);
@@ -512,7 +528,7 @@ void ServerHMDView::updateStateAndPredict()
 			    // Only update the position filter when tracking is enabled
 			    update_filters_for_virtual_hmd(
 				    virtualHMD, virtualHMDState,
-				    per_state_time_delta_seconds,
+				    state_time_delta_seconds,
 				    m_multicam_pose_estimation,
 				    m_pose_filter_space,
 				    m_pose_filter);
@@ -523,6 +539,7 @@ void ServerHMDView::updateStateAndPredict()
 
 		// Consider this hmd state sequence num processed
 		m_lastPollSeqNumProcessed = hmdState->PollSequenceNumber;
+		m_last_state_arrival_timestamp = hmdState->ArrivalTimestamp;
 	}
 }
 
@@ -583,6 +600,31 @@ ServerHMDView::getFilteredPhysics() const
 	return physics;
 }
 
+double
+ServerHMDView::getFilteredSampleTimeSeconds() const
+{
+	double sample_time = 0.0;
+
+	if (m_last_filter_update_timestamp_valid)
+	{
+		// The filter was last advanced to the arrival time of the newest state when it had one,
+		// otherwise to the time of the filter update
+		const bool bHasArrivalTimestamp = m_last_state_arrival_timestamp.time_since_epoch().count() != 0;
+
+		sample_time =
+			ServerUtility::to_monotonic_time_seconds(
+				bHasArrivalTimestamp ? m_last_state_arrival_timestamp : m_last_filter_update_timestamp);
+	}
+
+	return sample_time;
+}
+
+double
+ServerHMDView::getFilteredPoseTimeSeconds(float time) const
+{
+	return m_last_filter_update_timestamp_valid ? getFilteredSampleTimeSeconds() + static_cast<double>(time) : 0.0;
+}
+
 // Returns the full usb device path for the controller
 std::string
 ServerHMDView::getUSBDevicePath() const
@@ -728,16 +770,83 @@ float ServerHMDView::getROIPredictionTime() const
 
 void ServerHMDView::publish_device_data_frame()
 {
+    // Update the shared memory pose table first so that it's never older than the data frames
+    publish_shared_pose();
+
     // Tell the server request handler we want to send out HMD updates.
     // This will call generate_hmd_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_hmd_data_frame(
-        this, &ServerHMDView::generate_hmd_data_frame_for_stream);
+        this, 
+        &ServerHMDView::generate_hmd_data_frame_for_stream,
+        &ServerHMDView::generate_hmd_raw_data_frame_for_stream);
+}
+
+void ServerHMDView::publish_shared_pose()
+{
+    SharedPoseData pose_data;
+    memset(&pose_data, 0, sizeof(SharedPoseData));
+    pose_data.device_type= -1;
+    pose_data.sequence_num= m_sequence_number;
+
+    if (getIsOpen())
+    {
+        // Same (unpredicted) pose the data frames carry
+        const CommonDevicePose hmd_pose= getFilteredPose();
+
+        pose_data.device_type= static_cast<int32_t>(getHMDDeviceType() - CommonDeviceState::HeadMountedDisplay);
+        pose_data.pose_time_seconds= getFilteredPoseTimeSeconds();
+
+        if (m_device->getIsOpen())
+            pose_data.status_flags|= SHARED_POSE_STATUS_CONNECTED;
+        if (getIsTrackingEnabled())
+            pose_data.status_flags|= SHARED_POSE_STATUS_TRACKING_ENABLED;
+        if (getIsCurrentlyTracking())
+            pose_data.status_flags|= SHARED_POSE_STATUS_CURRENTLY_TRACKING;
+
+        if (m_pose_filter != nullptr)
+        {
+            const CommonDevicePhysics hmd_physics= getFilteredPhysics();
+
+            if (m_pose_filter->getIsOrientationStateValid())
+                pose_data.status_flags|= SHARED_POSE_STATUS_ORIENTATION_VALID;
+            if (m_pose_filter->getIsPositionStateValid())
+                pose_data.status_flags|= SHARED_POSE_STATUS_POSITION_VALID;
+
+            pose_data.physics_data.velocity_cm_per_sec.x= hmd_physics.VelocityCmPerSec.i;
+            pose_data.physics_data.velocity_cm_per_sec.y= hmd_physics.VelocityCmPerSec.j;
+            pose_data.physics_data.velocity_cm_per_sec.z= hmd_physics.VelocityCmPerSec.k;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.x= hmd_physics.AccelerationCmPerSecSqr.i;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.y= hmd_physics.AccelerationCmPerSecSqr.j;
+            pose_data.physics_data.acceleration_cm_per_sec_sqr.z= hmd_physics.AccelerationCmPerSecSqr.k;
+            pose_data.physics_data.angular_velocity_rad_per_sec.x= hmd_physics.AngularVelocityRadPerSec.i;
+            pose_data.physics_data.angular_velocity_rad_per_sec.y= hmd_physics.AngularVelocityRadPerSec.j;
+            pose_data.physics_data.angular_velocity_rad_per_sec.z= hmd_physics.AngularVelocityRadPerSec.k;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.x= hmd_physics.AngularAccelerationRadPerSecSqr.i;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.y= hmd_physics.AngularAccelerationRadPerSecSqr.j;
+            pose_data.physics_data.angular_acceleration_rad_per_sec_sqr.z= hmd_physics.AngularAccelerationRadPerSecSqr.k;
+        }
+
+        pose_data.pose.position_cm.x= hmd_pose.PositionCm.x;
+        pose_data.pose.position_cm.y= hmd_pose.PositionCm.y;
+        pose_data.pose.position_cm.z= hmd_pose.PositionCm.z;
+        pose_data.pose.orientation.w= hmd_pose.Orientation.w;
+        pose_data.pose.orientation.x= hmd_pose.Orientation.x;
+        pose_data.pose.orientation.y= hmd_pose.Orientation.y;
+        pose_data.pose.orientation.z= hmd_pose.Orientation.z;
+    }
+
+    // Devices can get closed before the device manager finishes starting up
+    DeviceManager *device_manager= DeviceManager::getInstance();
+    if (device_manager != nullptr)
+    {
+        device_manager->publishHMDPose(getDeviceID(), pose_data);
+    }
 }
 
 void ServerHMDView::generate_hmd_data_frame_for_stream(
     const ServerHMDView *hmd_view,
     const struct HMDStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame)
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
     PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket *hmd_data_frame =
         data_frame->mutable_hmd_data_packet();
@@ -745,6 +854,8 @@ void ServerHMDView::generate_hmd_data_frame_for_stream(
     hmd_data_frame->set_hmd_id(hmd_view->getDeviceID());
     hmd_data_frame->set_sequence_num(hmd_view->m_sequence_number);
     hmd_data_frame->set_isconnected(hmd_view->getDevice()->getIsOpen());
+    hmd_data_frame->set_sample_time_seconds(hmd_view->getFilteredSampleTimeSeconds());
+    hmd_data_frame->set_pose_time_seconds(hmd_view->getFilteredPoseTimeSeconds());
 
     switch (hmd_view->getHMDDeviceType())
     {
@@ -763,6 +874,194 @@ void ServerHMDView::generate_hmd_data_frame_for_stream(
     data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::HMD);
 }
 
+void ServerHMDView::generate_hmd_raw_data_frame_for_stream(
+    const ServerHMDView *hmd_view,
+    const struct HMDStreamInfo *stream_info,
+    PackedDeviceDataFrame *out_packed_data_frame)
+{
+    const IPoseFilter *pose_filter = hmd_view->getPoseFilter();
+    const CommonHMDState *hmd_state = hmd_view->getState();
+    RawHMDDataFrame raw_frame;
+    uint16_t section_flags = 0;
+
+    memset(&raw_frame, 0, sizeof(RawHMDDataFrame));
+    init_raw_data_frame_header(
+        raw_frame.header,
+        sizeof(RawHMDDataFrame),
+        PSMoveProtocol::DeviceOutputDataFrame::HMD,
+        (hmd_view->getHMDDeviceType() == CommonHMDState::Morpheus) ? PSMoveProtocol::Morpheus : PSMoveProtocol::VirtualHMD,
+        hmd_view->getDeviceID(),
+        hmd_view->m_sequence_number);
+    raw_frame.sample_time_seconds = hmd_view->getFilteredSampleTimeSeconds();
+    raw_frame.pose_time_seconds = hmd_view->getFilteredPoseTimeSeconds();
+
+    if (hmd_view->getDevice()->getIsOpen())
+    {
+        raw_frame.status_flags |= RAW_DEVICE_STATUS_CONNECTED;
+    }
+
+    if (hmd_state != nullptr)
+    {
+        const CommonDevicePose hmd_pose = hmd_view->getFilteredPose();
+        const bool bIsMorpheus = hmd_state->DeviceType == CommonDeviceState::Morpheus;
+
+        // Same flags as the protobuf data frame
+        if (hmd_view->getIsTrackingEnabled())
+            raw_frame.status_flags |= RAW_DEVICE_STATUS_TRACKING_ENABLED;
+        if (hmd_view->getIsCurrentlyTracking())
+            raw_frame.status_flags |= RAW_DEVICE_STATUS_CURRENTLY_TRACKING;
+        if (pose_filter->getIsStateValid())
+            raw_frame.status_flags |= bIsMorpheus ? (RAW_DEVICE_STATUS_ORIENTATION_VALID | RAW_DEVICE_STATUS_POSITION_VALID) : RAW_DEVICE_STATUS_POSITION_VALID;
+
+        // Virtual HMDs have no orientation
+        if (bIsMorpheus)
+        {
+            raw_frame.pose.orientation.w = hmd_pose.Orientation.w;
+            raw_frame.pose.orientation.x = hmd_pose.Orientation.x;
+            raw_frame.pose.orientation.y = hmd_pose.Orientation.y;
+            raw_frame.pose.orientation.z = hmd_pose.Orientation.z;
+        }
+        else
+        {
+            raw_frame.pose.orientation.w = 1.f;
+        }
+
+        // The position stays zeroed when it wasn't asked for
+        if (stream_info->include_position_data)
+        {
+            raw_frame.pose.position_cm.x = hmd_pose.PositionCm.x;
+            raw_frame.pose.position_cm.y = hmd_pose.PositionCm.y;
+            raw_frame.pose.position_cm.z = hmd_pose.PositionCm.z;
+            section_flags |= RAW_DATA_FRAME_SECTION_POSITION;
+        }
+
+        if (stream_info->include_physics_data)
+        {
+            const CommonDevicePhysics hmd_physics = hmd_view->getFilteredPhysics();
+            RawPhysicsDataSection &physics_data = raw_frame.physics_data;
+
+            physics_data.velocity_cm_per_sec.x = hmd_physics.VelocityCmPerSec.i;
+            physics_data.velocity_cm_per_sec.y = hmd_physics.VelocityCmPerSec.j;
+            physics_data.velocity_cm_per_sec.z = hmd_physics.VelocityCmPerSec.k;
+            physics_data.acceleration_cm_per_sec_sqr.x = hmd_physics.AccelerationCmPerSecSqr.i;
+            physics_data.acceleration_cm_per_sec_sqr.y = hmd_physics.AccelerationCmPerSecSqr.j;
+            physics_data.acceleration_cm_per_sec_sqr.z = hmd_physics.AccelerationCmPerSecSqr.k;
+
+            if (bIsMorpheus)
+            {
+                physics_data.angular_velocity_rad_per_sec.x = hmd_physics.AngularVelocityRadPerSec.i;
+                physics_data.angular_velocity_rad_per_sec.y = hmd_physics.AngularVelocityRadPerSec.j;
+                physics_data.angular_velocity_rad_per_sec.z = hmd_physics.AngularVelocityRadPerSec.k;
+                physics_data.angular_acceleration_rad_per_sec_sqr.x = hmd_physics.AngularAccelerationRadPerSecSqr.i;
+                physics_data.angular_acceleration_rad_per_sec_sqr.y = hmd_physics.AngularAccelerationRadPerSecSqr.j;
+                physics_data.angular_acceleration_rad_per_sec_sqr.z = hmd_physics.AngularAccelerationRadPerSecSqr.k;
+            }
+            section_flags |= RAW_DATA_FRAME_SECTION_PHYSICS;
+        }
+
+        if (bIsMorpheus)
+        {
+            const MorpheusHMDState * morpheus_hmd_state = static_cast<const MorpheusHMDState *>(hmd_state);
+
+            // Same as the protobuf data frame: the most recent of the two sensor frames
+            if (stream_info->include_raw_sensor_data)
+            {
+                RawIMURawSensorSection &raw_sensor_data = raw_frame.raw_sensor_data;
+
+                raw_sensor_data.accelerometer.x = morpheus_hmd_state->SensorFrames[1].RawAccel.i;
+                raw_sensor_data.accelerometer.y = morpheus_hmd_state->SensorFrames[1].RawAccel.j;
+                raw_sensor_data.accelerometer.z = morpheus_hmd_state->SensorFrames[1].RawAccel.k;
+                raw_sensor_data.gyroscope.x = morpheus_hmd_state->SensorFrames[1].RawGyro.i;
+                raw_sensor_data.gyroscope.y = morpheus_hmd_state->SensorFrames[1].RawGyro.j;
+                raw_sensor_data.gyroscope.z = morpheus_hmd_state->SensorFrames[1].RawGyro.k;
+                section_flags |= RAW_DATA_FRAME_SECTION_RAW_SENSOR;
+            }
+
+            if (stream_info->include_calibrated_sensor_data)
+            {
+                RawIMUCalibratedSensorSection &calibrated_sensor_data = raw_frame.calibrated_sensor_data;
+
+                calibrated_sensor_data.accelerometer.x = morpheus_hmd_state->SensorFrames[1].CalibratedAccel.i;
+                calibrated_sensor_data.accelerometer.y = morpheus_hmd_state->SensorFrames[1].CalibratedAccel.j;
+                calibrated_sensor_data.accelerometer.z = morpheus_hmd_state->SensorFrames[1].CalibratedAccel.k;
+                calibrated_sensor_data.gyroscope.x = morpheus_hmd_state->SensorFrames[1].CalibratedGyro.i;
+                calibrated_sensor_data.gyroscope.y = morpheus_hmd_state->SensorFrames[1].CalibratedGyro.j;
+                calibrated_sensor_data.gyroscope.z = morpheus_hmd_state->SensorFrames[1].CalibratedGyro.k;
+                section_flags |= RAW_DATA_FRAME_SECTION_CALIBRATED_SENSOR;
+            }
+        }
+
+        if (stream_info->include_raw_tracker_data)
+        {
+            RawTrackerDataSection &raw_tracker_data = raw_frame.raw_tracker_data;
+            RawTrackerPointsSection &raw_tracker_points = raw_frame.raw_tracker_points;
+            const int selectedTrackerId = stream_info->selected_tracker_index;
+
+            raw_tracker_points.relative_orientation.w = 1.f;
+
+            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            {
+                const HMDOpticalPoseEstimation *positionEstimate = hmd_view->getTrackerPoseEstimate(trackerId);
+
+                if (positionEstimate != nullptr && positionEstimate->bCurrentlyTracking)
+                {
+                    raw_tracker_data.valid_tracker_bitmask |= (1 << trackerId);
+
+                    if (trackerId == selectedTrackerId)
+                    {
+                        const CommonDevicePosition &trackerRelativePosition = positionEstimate->position_cm;
+                        const CommonDeviceTrackingProjection &trackerRelativeProjection = positionEstimate->projection;
+                        const ServerTrackerViewPtr tracker_view = DeviceManager::getInstance()->getTrackerViewPtr(selectedTrackerId);
+
+                        // Project the 3d camera position back onto the tracker screen
+                        const CommonDeviceScreenLocation trackerScreenLocation =
+                            tracker_view->projectTrackerRelativePosition(&trackerRelativePosition);
+
+                        raw_tracker_data.tracker_id = selectedTrackerId;
+                        raw_tracker_data.screen_location_x = trackerScreenLocation.x;
+                        raw_tracker_data.screen_location_y = trackerScreenLocation.y;
+                        raw_tracker_data.relative_position_cm.x = trackerRelativePosition.x;
+                        raw_tracker_data.relative_position_cm.y = trackerRelativePosition.y;
+                        raw_tracker_data.relative_position_cm.z = trackerRelativePosition.z;
+
+                        if (trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_Points)
+                        {
+                            const int point_count = 
+                                std::min(trackerRelativeProjection.shape.points.point_count, RAW_TRACKER_MAX_PROJECTED_POINTS);
+
+                            for (int point_index = 0; point_index < point_count; ++point_index)
+                            {
+                                raw_tracker_points.points[point_index].x = trackerRelativeProjection.shape.points.point[point_index].x;
+                                raw_tracker_points.points[point_index].y = trackerRelativeProjection.shape.points.point[point_index].y;
+                            }
+                            raw_tracker_points.point_count = point_count;
+                            raw_tracker_data.valid_flags |= RAW_TRACKER_DATA_PROJECTED_POINTS_VALID;
+                        }
+                        else if (trackerRelativeProjection.shape_type == eCommonTrackingProjectionType::ProjectionType_Ellipse)
+                        {
+                            raw_tracker_data.projected_sphere_center_x = trackerRelativeProjection.shape.ellipse.center.x;
+                            raw_tracker_data.projected_sphere_center_y = trackerRelativeProjection.shape.ellipse.center.y;
+                            raw_tracker_data.projected_sphere_half_x_extent = trackerRelativeProjection.shape.ellipse.half_x_extent;
+                            raw_tracker_data.projected_sphere_half_y_extent = trackerRelativeProjection.shape.ellipse.half_y_extent;
+                            raw_tracker_data.projected_sphere_angle = trackerRelativeProjection.shape.ellipse.angle;
+                            raw_tracker_data.valid_flags |= RAW_TRACKER_DATA_PROJECTED_SPHERE_VALID;
+                        }
+                    }
+                }
+            }
+
+            section_flags |= RAW_DATA_FRAME_SECTION_RAW_TRACKER;
+        }
+    }
+
+    raw_frame.header.section_flags = section_flags;
+
+    const uint8_t *raw_frame_bytes = reinterpret_cast<const uint8_t *>(&raw_frame);
+    out_packed_data_frame->bytes.assign(raw_frame_bytes, raw_frame_bytes + sizeof(RawHMDDataFrame));
+    out_packed_data_frame->device_category = PSMoveProtocol::DeviceOutputDataFrame::HMD;
+    out_packed_data_frame->device_id = hmd_view->getDeviceID();
+}
+
 static void
 init_filters_for_morpheus_hmd(
     const MorpheusHMD *morpheusHMD,
@@ -864,6 +1163,29 @@ static void init_filters_for_virtual_hmd(
 		constants);
 }
 
+static float
+compute_state_time_delta_seconds(
+	const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_timestamp,
+	const std::chrono::time_point<std::chrono::high_resolution_clock> &last_arrival_timestamp,
+	const float fallback_time_delta_seconds)
+{
+	const std::chrono::time_point<std::chrono::high_resolution_clock> unknown_timestamp;
+	float time_delta_seconds = fallback_time_delta_seconds;
+
+	// Use the actual spacing of the input reports when both were timestamped on arrival
+	if (arrival_timestamp != unknown_timestamp && last_arrival_timestamp != unknown_timestamp)
+	{
+		const std::chrono::duration<float> time_delta = arrival_timestamp - last_arrival_timestamp;
+
+		if (time_delta.count() > 0.f)
+		{
+			time_delta_seconds = clampf(time_delta.count(), 0.f, k_max_time_delta_seconds);
+		}
+	}
+
+	return time_delta_seconds;
+}
+
 static IPoseFilter *
 pose_filter_factory(
 	const CommonDeviceState::eDeviceType deviceType,
@@ -1099,7 +1421,7 @@ update_filters_for_virtual_hmd(
 static void generate_morpheus_hmd_data_frame_for_stream(
     const ServerHMDView *hmd_view,
     const HMDStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame)
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
     const MorpheusHMD *morpheus_hmd = hmd_view->castCheckedConst<MorpheusHMD>();
     const MorpheusHMDConfig *morpheus_config = morpheus_hmd->getConfig();
@@ -1271,7 +1593,7 @@ static void generate_morpheus_hmd_data_frame_for_stream(
 static void generate_virtual_hmd_data_frame_for_stream(
     const ServerHMDView *hmd_view,
     const HMDStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame)
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
     const VirtualHMD *virtual_hmd = hmd_view->castCheckedConst<VirtualHMD>();
     const VirtualHMDConfig *virtual_hmd_config = virtual_hmd->getConfig();
@@ -66,6 +66,13 @@ public:
 	// Get the current physics from the filter position and orientation
 	CommonDevicePhysics getFilteredPhysics() const;
 
+	// Service monotonic time (see ServerUtility::get_monotonic_time_seconds) of the newest
+	// HMD state applied to the filter. Zero before the first filter update.
+	double getFilteredSampleTimeSeconds() const;
+
+	// Service monotonic time described by getFilteredPose(time)
+	double getFilteredPoseTimeSeconds(float time = 0.f) const;
+
     // Returns the full usb device path for the controller
     std::string getUSBDevicePath() const;
 
@@ -131,10 +138,17 @@ protected:
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void publish_shared_pose();
     static void generate_hmd_data_frame_for_stream(
         const ServerHMDView *hmd_view,
         const struct HMDStreamInfo *stream_info,
-        DeviceOutputDataFramePtr &data_frame);
+        PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+
+    // Same as generate_hmd_data_frame_for_stream for streams that asked for the raw data frame format (see RawDataFrame.h)
+    static void generate_hmd_raw_data_frame_for_stream(
+        const ServerHMDView *hmd_view,
+        const struct HMDStreamInfo *stream_info,
+        struct PackedDeviceDataFrame *out_packed_data_frame);
 
 private:
 	// Tracking color state
@@ -155,6 +169,7 @@ private:
     int m_lastPollSeqNumProcessed;
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_last_filter_update_timestamp;
 	bool m_last_filter_update_timestamp_valid;
+	std::chrono::time_point<std::chrono::high_resolution_clock> m_last_state_arrival_timestamp;
 };
 
 #endif // SERVER_HMD_VIEW_H
\ No newline at end of file
@@ -9,18 +9,24 @@
 #include "MathGLM.h"
 #include "MathAlignment.h"
 #include "PS3EyeTracker.h"
+#include "ReplayTracker.h"
+#include "DeviceInputReplayer.h"
 #include "PSMoveProtocol.pb.h"
+#include "ServerEventScheduler.h"
 #include "ServerUtility.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "SharedTrackerState.h"
 #include "TrackerManager.h"
 #include "PoseFilterInterface.h"
+#include "TrackerFrameProcessing.h"
 
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "opencv2/opencv.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
@@ -32,17 +38,6 @@
 //-- constants ----
 static const int k_min_roi_size= 32;
 
-//-- typedefs ----
-typedef std::vector<cv::Point> t_opencv_int_contour;
-typedef std::vector<t_opencv_int_contour> t_opencv_int_contour_list;
-
-typedef std::vector<cv::Point2f> t_opencv_float_contour;
-typedef std::vector<t_opencv_float_contour> t_opencv_float_contour_list;
-
-//-- template utility methods
-template<typename t_opencv_contour_type>
-cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour);
-
 //-- private methods -----
 class SharedVideoFrameReadWriteAccessor
 {
@@ -83,24 +78,22 @@ public:
                     boost::interprocess::read_write,
                     permissions);
 
-            // Resize the shared memory
-            m_shared_memory_object->truncate(SharedVideoFrameHeader::computeTotalSize(stride, width));
+            // Resize the shared memory to hold the header and a ring of frame slots
+            m_shared_memory_object->truncate(
+                SharedVideoFrameHeader::computeTotalSize(stride, height, SharedVideoFrameHeader::k_default_slot_count));
 
             // Map all of the shared memory for read/write access
             m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
 
             // Initialize the shared memory (call constructor using placement new)
-            // This make sure the mutex has the constructor called on it.
+            // This make sure the slot sequence counters have the constructor called on them.
             SharedVideoFrameHeader *frameState = new (getFrameHeader()) SharedVideoFrameHeader();
             
             frameState->width = width;
             frameState->height = height;
             frameState->stride = stride;
-            frameState->frame_index = 0;
-            std::memset(
-                frameState->getBufferMutable(),
-                0,
-                SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
+            frameState->slot_count = SharedVideoFrameHeader::k_default_slot_count;
+            frameState->initializeSlots();
 
             bSuccess = true;
         }
@@ -118,10 +111,6 @@ public:
     {
         if (m_region != nullptr)
         {
-            // Call the destructor manually on the frame header since it was constructed via placement new
-            // This will make sure the mutex has the destructor called on it.
-            getFrameHeader()->~SharedVideoFrameHeader();
-            
             delete m_region;
             m_region = nullptr;
         }
@@ -141,16 +130,10 @@ public:
     void writeVideoFrame(const unsigned char *buffer)
     {
         SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
-        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
+        assert(m_region->get_size() >= sharedFrameState->computeTotalSize());
 
-        size_t buffer_size = 
-            SharedVideoFrameHeader::computeVideoBufferSize(sharedFrameState->stride, sharedFrameState->height);
-        size_t total_shared_mem_size =
-            SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
-        assert(m_region->get_size() >= total_shared_mem_size);
-
-        ++sharedFrameState->frame_index;
-        std::memcpy(sharedFrameState->getBufferMutable(), buffer, buffer_size);
+        // Never blocks on the clients: readers detect an overwritten slot through its sequence counter
+        sharedFrameState->writeVideoFrame(buffer);
     }
 
 protected:
@@ -248,467 +231,355 @@ struct OpenCVPlane2D
     }
 };
 
-class OpenCVBGRToHSVMapper
+/// Single producer/single consumer handoff of the most recent value.
+/// The producer and consumer each own one of three slots and swap with the "ready" slot,
+/// so neither side ever waits on the other and the consumer always sees the newest value.
+template <typename t_buffer_type>
+class LockFreeTripleBuffer
 {
 public:
-    typedef cv::Point3_<uint8_t> ColorTuple;
+    LockFreeTripleBuffer()
+        : m_ready_state(0)
+        , m_write_index(1)
+        , m_read_index(2)
+    {
+    }
+
+    // -- Producer --
+    inline t_buffer_type &getWriteBuffer() 
+    { 
+        return m_buffers[m_write_index]; 
+    }
 
-    static OpenCVBGRToHSVMapper *allocate()
+    void publishWriteBuffer()
     {
-        if (m_refCount == 0)
-        {
-            assert(m_instance == nullptr);
-            m_instance = new OpenCVBGRToHSVMapper();
-        }
-        assert(m_instance != nullptr);
+        const int old_ready_state = m_ready_state.exchange(m_write_index | k_fresh_flag);
 
-        ++m_refCount;
-        return m_instance;
+        m_write_index = old_ready_state & k_index_mask;
     }
 
-    static void dispose(OpenCVBGRToHSVMapper *instance)
+    // -- Consumer --
+    // Returns true if a newer buffer was published since the last fetch
+    bool fetchReadBuffer()
     {
-        assert(m_instance != nullptr);
-        assert(m_instance == instance);
-        assert(m_refCount > 0);
+        bool bHasNewBuffer = false;
 
-        --m_refCount;
-        if (m_refCount <= 0)
+        if ((m_ready_state.load() & k_fresh_flag) != 0)
         {
-            delete m_instance;
-            m_instance = nullptr;
+            const int old_ready_state = m_ready_state.exchange(m_read_index);
+
+            m_read_index = old_ready_state & k_index_mask;
+            bHasNewBuffer = true;
         }
-    }
 
-    void cvtColor(const cv::Mat &bgrBuffer, cv::Mat &hsvBuffer)
-    {
-        hsvBuffer.forEach<ColorTuple>([&bgrBuffer, this](ColorTuple &hsvColor, const int position[]) -> void {
-            const ColorTuple &bgrColor = bgrBuffer.at<ColorTuple>(position[0], position[1]);
-            const int b = bgrColor.x;
-            const int g = bgrColor.y;
-            const int r = bgrColor.z;
-            const int LUTIndex = OpenCVBGRToHSVMapper::getLUTIndex(r, g, b);
+        return bHasNewBuffer;
+    }
 
-            hsvColor = bgr2hsv->at<ColorTuple>(LUTIndex, 0);
-        });
+    inline const t_buffer_type &getReadBuffer() const 
+    { 
+        return m_buffers[m_read_index]; 
     }
 
 private:
-    static OpenCVBGRToHSVMapper *m_instance;
-    static int m_refCount;
+    static const int k_index_mask = 0x3;
+    static const int k_fresh_flag = 0x4;
 
-    OpenCVBGRToHSVMapper()
-    {
-        bgr2hsv = new cv::Mat(256*256*256, 1, CV_8UC3);
+    t_buffer_type m_buffers[3];
+    std::atomic_int m_ready_state; // index of the ready buffer | fresh flag
+    int m_write_index; // only touched by the producer
+    int m_read_index; // only touched by the consumer
+};
 
-        int LUTIndex = 0;
-        for (int r = 0; r < 256; ++r)
-        {
-            for (int g = 0; g < 256; ++g)
-            {
-                for (int b = 0; b < 256; ++b)
-                {
-                    bgr2hsv->at<ColorTuple>(LUTIndex, 0) = ColorTuple(b, g, r);
-                    ++LUTIndex;
-                }
-            }
-        }
+static inline int getControllerColorJobIndex(int controller_id)
+{
+    return controller_id;
+}
 
-        cv::cvtColor(*bgr2hsv, *bgr2hsv, cv::COLOR_BGR2HSV);
-    }
+static inline int getHMDColorJobIndex(int hmd_id)
+{
+    return PSMOVESERVICE_MAX_CONTROLLER_COUNT + hmd_id;
+}
+
+// Buffers sized for the device's current video frame, converting to HSV the configured way
+static OpenCVBufferState *allocateOpenCVBufferState(const ITrackerInterface *device)
+{
+    const TrackerManagerConfig &cfg= DeviceManager::getInstance()->m_tracker_manager->getConfig();
+    int frame_width, frame_height;
 
-    ~OpenCVBGRToHSVMapper()
+    device->getVideoFrameDimensions(&frame_width, &frame_height, nullptr);
+
+    return new OpenCVBufferState(frame_width, frame_height, cfg.bgr_to_hsv_converter);
+}
+
+/// Grabs, debayers, converts to HSV and extracts contours for every tracked color 
+/// on a thread dedicated to a single tracker. 
+/// The main thread hands over the list of colors to look for and picks up the finished 
+/// per-frame contours, both through lock-free triple buffers.
+/// Camera settings changed by the main thread get applied in between polls (see TrackerDeviceLock).
+class TrackerWorkerThread
+{
+public:
+    TrackerWorkerThread(ITrackerInterface *device, int tracker_id, int cpu_affinity)
+        : m_device(device)
+        , m_tracker_id(tracker_id)
+        , m_cpu_affinity(cpu_affinity)
+        , m_buffer_state(nullptr)
+        , m_exit_signaled(false)
+        , m_device_failed(false)
+        , m_video_frame_requested(false)
+        , m_thread_started(false)
     {
-        delete bgr2hsv;
     }
 
-    static int getLUTIndex(int r, int g, int b)
+    ~TrackerWorkerThread()
     {
-        return (256 * 256)*r + 256*g + b;
+        stop();
     }
 
-    cv::Mat *bgr2hsv;
-};
-OpenCVBGRToHSVMapper *OpenCVBGRToHSVMapper::m_instance = nullptr;
-int OpenCVBGRToHSVMapper::m_refCount= 0;
-
-class OpenCVBufferState
-{
-public:
-    OpenCVBufferState(ITrackerInterface *device)
-        : bgrBuffer(nullptr)
-        , bgrShmemBuffer(nullptr)
-        , hsvBuffer(nullptr)
-        , gsLowerBuffer(nullptr)
-        , gsUpperBuffer(nullptr)
-        , maskedBuffer(nullptr)
-    {
-        device->getVideoFrameDimensions(&frameWidth, &frameHeight, nullptr);
-
-        bgrBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
-        bgrShmemBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
-        hsvBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
-        gsLowerBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
-        gsUpperBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
-        maskedBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
-        
-        const TrackerManagerConfig &cfg= DeviceManager::getInstance()->m_tracker_manager->getConfig();
-        if (cfg.use_bgr_to_hsv_lookup_table)
-        {
-            bgr2hsv = OpenCVBGRToHSVMapper::allocate();
-        }
-        else
+    void start()
+    {
+        if (!m_thread_started)
         {
-            bgr2hsv = nullptr;
+            // Allocated on the main thread since it reads the tracker manager config
+            m_buffer_state = allocateOpenCVBufferState(m_device);
+
+            SERVER_LOG_INFO("TrackerWorkerThread::start") << "Starting worker thread for tracker " << m_tracker_id;
+            m_exit_signaled = false;
+            m_device_failed = false;
+            m_worker_thread = std::thread(&TrackerWorkerThread::workerThreadFunc, this);
+            m_thread_started = true;
         }
-        
-        //Apply default ROI (full frame).
-        applyROI(cv::Rect2i(cv::Point(0,0), cv::Size(frameWidth, frameHeight)));
     }
 
-    virtual ~OpenCVBufferState()
+    void stop()
     {
-        if (maskedBuffer != nullptr)
-        {
-            delete maskedBuffer;
-        }
-        
-        if (gsLowerBuffer != nullptr)
-        {
-            delete gsLowerBuffer;
-        }
-        
-        if (gsUpperBuffer != nullptr)
-        {
-            delete gsUpperBuffer;
-        }
-        
-        if (hsvBuffer != nullptr)
-        {
-            delete hsvBuffer;
-        }
-        
-        if (bgrShmemBuffer != nullptr)
-        {
-            delete bgrShmemBuffer;
-        }
-        
-        if (bgrBuffer != nullptr)
+        if (m_thread_started)
         {
-            delete bgrBuffer;
+            SERVER_LOG_INFO("TrackerWorkerThread::stop") << "Stopping worker thread for tracker " << m_tracker_id;
+            m_exit_signaled = true;
+            m_worker_thread.join();
+            m_thread_started = false;
         }
-        
-        if (bgr2hsv != nullptr)
+
+        if (m_buffer_state != nullptr)
         {
-            OpenCVBGRToHSVMapper::dispose(bgr2hsv);
+            delete m_buffer_state;
+            m_buffer_state = nullptr;
         }
     }
 
-    void writeVideoFrame(const unsigned char *video_buffer)
+    // -- Main thread --
+    inline bool getHasDeviceFailed() const
     {
-        const cv::Mat videoBufferMat(frameHeight, frameWidth, CV_8UC3, const_cast<unsigned char *>(video_buffer));
+        return m_device_failed;
+    }
 
-        videoBufferMat.copyTo(*bgrBuffer);
-        videoBufferMat.copyTo(*bgrShmemBuffer);
+    // Hand the captured frames to the main thread along with the contours
+    // (only needed for the shared memory video stream)
+    inline void setIsVideoFrameRequested(bool bIsRequested)
+    {
+        m_video_frame_requested = bIsRequested;
     }
-    
-    void updateHsvBuffer()
+
+    inline TrackerColorJobList &getColorJobsMutable()
     {
-        // Convert the video buffer to the HSV color space
-        if (bgr2hsv != nullptr)
-        {
-            bgr2hsv->cvtColor(bgrROI, hsvROI);
-        }
-        else
-        {
-            cv::cvtColor(bgrROI, hsvROI, cv::COLOR_BGR2HSV);
-        }
+        return m_color_jobs.getWriteBuffer();
     }
-    
-    void applyROI(cv::Rect2i ROI)
-    {
-        // Make sure the ROI box is always clamped in bounds of the frame buffer
-        int x0= std::min(std::max(ROI.tl().x, 0), frameWidth-1);
-        int y0= std::min(std::max(ROI.tl().y, 0), frameHeight-1);
-        int x1= std::min(std::max(ROI.br().x, 0), frameWidth-1);
-        int y1= std::min(std::max(ROI.br().y, 0), frameHeight-1);
-        int clamped_width = std::max(x1-x0, 0);
-        int clamped_height = std::max(y1-y0, 0);
-
-        // If the clamped ROI ends up being zero-width or zero-height, 
-        // just make it full screen
-        if (clamped_width > 0 && clamped_height > 0)
-        {
-            ROI.x= x0;
-            ROI.y= y0;
-            ROI.width = clamped_width;
-            ROI.height = clamped_height;
-        }
-        else
+
+    inline void publishColorJobs()
+    {
+        m_color_jobs.publishWriteBuffer();
+    }
+
+    inline bool fetchFrameResult()
+    {
+        return m_frame_results.fetchReadBuffer();
+    }
+
+    inline const TrackerFrameResult &getFrameResult() const
+    {
+        return m_frame_results.getReadBuffer();
+    }
+
+    // Keeps the worker thread from polling the camera while the main thread talks to it
+    inline void lockDevice()
+    {
+        m_device_mutex.lock();
+    }
+
+    inline void unlockDevice()
+    {
+        m_device_mutex.unlock();
+    }
+
+protected:
+    void workerThreadFunc()
+    {
+        ServerUtility::set_current_thread_name("Tracker Worker Thread");
+
+        if (m_cpu_affinity >= 0 && !ServerUtility::set_current_thread_affinity(m_cpu_affinity))
         {
-            ROI.x= 0;
-            ROI.y= 0;
-            ROI.width = frameWidth;
-            ROI.height = frameHeight;
+            SERVER_LOG_WARNING("TrackerWorkerThread") << "Failed to set cpu affinity for tracker " << m_tracker_id;
         }
-       
-        //Create the ROI matrices.
-        //It's not a full copy, so this isn't too slow.
-        //adjustROI is probably slightly faster but I ran into trouble with it.
-        bgrROI = cv::Mat(*bgrBuffer, ROI);
-        hsvROI = cv::Mat(*hsvBuffer, ROI);
-        gsLowerROI = cv::Mat(*gsLowerBuffer, ROI);
-        gsUpperROI = cv::Mat(*gsUpperBuffer, ROI);
-        
-        updateHsvBuffer();
-        
-        //Draw ROI.
-        cv::rectangle(*bgrShmemBuffer, ROI, cv::Scalar(255, 0, 0));
-    }
-
-    // Return points in raw image space:
-    // i.e. [0, 0] at lower left  to [frameWidth-1, frameHeight-1] at lower right
-    bool computeBiggestNContours(
-        const CommonHSVColorRange &hsvColorRange,
-        t_opencv_int_contour_list &out_biggest_N_contours,
-        std::vector<double> &out_contour_areas,
-        const int max_contour_count,
-        const int min_points_in_contour = 6)
-    {
-        out_biggest_N_contours.clear();
-        out_contour_areas.clear();
-        
-        // Clamp the HSV image, taking into account wrapping the hue angle
+
+        const long max_poll_failure_count = m_device->getMaxPollFailureCount();
+        long poll_no_data_count = 0;
+
+        while (!m_exit_signaled)
         {
-            const float hue_min = hsvColorRange.hue_range.center - hsvColorRange.hue_range.range;
-            const float hue_max = hsvColorRange.hue_range.center + hsvColorRange.hue_range.range;
-            const float saturation_min = clampf(hsvColorRange.saturation_range.center - hsvColorRange.saturation_range.range, 0, 255);
-            const float saturation_max = clampf(hsvColorRange.saturation_range.center + hsvColorRange.saturation_range.range, 0, 255);
-            const float value_min = clampf(hsvColorRange.value_range.center - hsvColorRange.value_range.range, 0, 255);
-            const float value_max = clampf(hsvColorRange.value_range.center + hsvColorRange.value_range.range, 0, 255);
-
-            if (hue_min < 0)
+            // Pick up any change to the list of colors we are looking for
+            m_color_jobs.fetchReadBuffer();
+
+            IDeviceInterface::ePollResult poll_result;
             {
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max, 0, 180), saturation_max, value_max),
-                    gsLowerROI);
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(clampf(180 + hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
-                    gsUpperROI);
-                cv::bitwise_or(gsLowerROI, gsUpperROI, gsLowerROI);
+                std::lock_guard<std::mutex> device_lock(m_device_mutex);
+
+                poll_result = m_device->poll();
             }
-            else if (hue_max > 180)
+
+            switch (poll_result)
             {
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max - 180, 0, 180), saturation_max, value_max),
-                    gsLowerROI);
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(clampf(hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
-                    gsUpperROI);
-                cv::bitwise_or(gsLowerROI, gsUpperROI, gsLowerROI);
+            case IDeviceInterface::_PollResultSuccessNewData:
+                {
+                    m_frame_results.getWriteBuffer().arrivalTime = std::chrono::high_resolution_clock::now();
+
+                    const unsigned char *bayer_buffer = m_device->getVideoFrameBayerBuffer();
+                    const unsigned char *buffer = m_device->getVideoFrameBuffer();
+
+                    if (bayer_buffer != nullptr)
+                    {
+                        processBayerFrame(bayer_buffer, m_color_jobs.getReadBuffer());
+                    }
+                    else if (buffer != nullptr)
+                    {
+                        processVideoFrame(buffer, m_color_jobs.getReadBuffer());
+                    }
+
+                    poll_no_data_count = 0;
+                } break;
+            case IDeviceInterface::_PollResultSuccessNoData:
+                {
+                    ++poll_no_data_count;
+
+                    if (poll_no_data_count > max_poll_failure_count)
+                    {
+                        SERVER_LOG_INFO("TrackerWorkerThread") <<
+                            "Tracker id " << m_tracker_id << " no data (" << max_poll_failure_count << " failed poll attempts)";
+                        m_device_failed = true;
+                    }
+                    else
+                    {
+                        // Don't spin on a camera that isn't producing frames yet
+                        ServerUtility::sleep_ms(1);
+                    }
+                } break;
+            case IDeviceInterface::_PollResultFailure:
+                {
+                    m_device_failed = true;
+                } break;
             }
-            else
+
+            // The main thread will close the device once it sees the failure
+            if (m_device_failed)
             {
-                cv::inRange(
-                    hsvROI,
-                    cv::Scalar(hue_min, saturation_min, value_min),
-                    cv::Scalar(hue_max, saturation_max, value_max),
-                    gsLowerROI);
+                signal_main_thread();
+                break;
             }
         }
-        
-        //TODO: Why no blurring of the gsLowerBuffer?
+    }
 
-        // Find the largest convex blob in the filtered grayscale buffer
+    void processVideoFrame(const unsigned char *buffer, const TrackerColorJobList &color_jobs)
+    {
+        TrackerFrameResult &frame_result = m_frame_results.getWriteBuffer();
+
+        m_buffer_state->writeVideoFrame(buffer);
+        frame_result.bHasVideoFrame = m_video_frame_requested;
+        if (frame_result.bHasVideoFrame)
         {
-            struct ContourInfo
-            {
-                int contour_index;
-                double contour_area;
-            };
-            std::vector<ContourInfo> sorted_contour_list;
-
-            // Find all counters in the image buffer
-            cv::Size size; cv::Point ofs;
-            gsLowerROI.locateROI(size, ofs);
-            t_opencv_int_contour_list contours;
-            cv::findContours(gsLowerROI,
-                             contours,
-                             CV_RETR_EXTERNAL,
-                             CV_CHAIN_APPROX_SIMPLE,  //CV_CHAIN_APPROX_NONE?
-                             ofs);
-
-            // Compute the area of each contour
-            int contour_index = 0;
-            for (auto it = contours.begin(); it != contours.end(); ++it) 
-            {
-                const double contour_area = cv::contourArea(*it);
-                const ContourInfo contour_info = { contour_index, contour_area };
+            m_buffer_state->bgrBuffer->copyTo(frame_result.videoFrame);
+        }
 
-                sorted_contour_list.push_back(contour_info);
-                ++contour_index;
-            }
-            
-            // Sort the list of contours by area, largest to smallest
-            if (sorted_contour_list.size() > 1)
-            {
-                std::sort(
-                    sorted_contour_list.begin(), sorted_contour_list.end(), 
-                    [](const ContourInfo &a, const ContourInfo &b) {
-                        return b.contour_area < a.contour_area;
-                });
-            }
+        computeContoursForColorJobs(m_buffer_state, color_jobs, frame_result);
 
-            // Copy up to N valid contours
-            for (auto it = sorted_contour_list.begin(); 
-                it != sorted_contour_list.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
-                ++it)
-            {
-                const ContourInfo &contour_info = *it;
-                t_opencv_int_contour &contour = contours[contour_info.contour_index];
+        m_frame_results.publishWriteBuffer();
+        signal_main_thread();
+    }
 
-                if (contour.size() > min_points_in_contour)
-                {
-                    // Remove any points in contour on edge of camera/ROI
-                    // TODO: Contours touching image border will be clipped,
-                    // so this might not be necessary.
-                    t_opencv_int_contour::iterator it = contour.begin();
-                    while (it != contour.end()) 
-                    {
-                        if (it->x == 0 || it->x == (frameWidth - 1) || it->y == 0 || it->y == (frameHeight - 1))
-                        {
-                            it = contour.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
+    // Segments straight from the Bayer frame and hands the (3x smaller) raw frame
+    // to the main thread, which only debayers it if the video stream is open
+    void processBayerFrame(const unsigned char *bayer_buffer, const TrackerColorJobList &color_jobs)
+    {
+        TrackerFrameResult &frame_result = m_frame_results.getWriteBuffer();
 
-                    // Add cleaned up contour to the output list
-                    out_biggest_N_contours.push_back(contour);
-                    // Add its area to the output list too.
-                    out_contour_areas.push_back(contour_info.contour_area);
-                }
-            }
+        m_buffer_state->writeBayerFrame(bayer_buffer, false);
+        frame_result.bHasVideoFrame = m_video_frame_requested;
+        if (frame_result.bHasVideoFrame)
+        {
+            m_buffer_state->bayerBuffer->copyTo(frame_result.videoFrame);
         }
 
-        return (out_biggest_N_contours.size() > 0);
+        computeContoursForColorJobs(m_buffer_state, color_jobs, frame_result);
+
+        m_frame_results.publishWriteBuffer();
+        signal_main_thread();
     }
-    
-    void
-    draw_contour(const t_opencv_int_contour &contour)
-    {
-        // Draws the contour directly onto the shared mem buffer.
-        // This is useful for debugging
-        std::vector<t_opencv_int_contour> contours = {contour};
-        const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_int_contour>(contour);
-        cv::drawContours(*bgrShmemBuffer, contours, 0, cv::Scalar(255, 255, 255));
-        cv::rectangle(*bgrShmemBuffer, cv::boundingRect(contour), cv::Scalar(255, 255, 255));
-        cv::drawMarker(*bgrShmemBuffer, massCenter, cv::Scalar(255, 255, 255), 0,
-            (cv::boundingRect(contour).height < cv::boundingRect(contour).width) ?
-            cv::boundingRect(contour).height : cv::boundingRect(contour).width);
+
+    // Wakes up the main thread so it picks up the frame result (or device failure) right away
+    void signal_main_thread()
+    {
+        ServerEventScheduler *event_scheduler = ServerEventScheduler::getInstance();
+
+        if (event_scheduler != nullptr)
+        {
+            event_scheduler->signalEvent();
+        }
     }
-    
-    void
-    draw_pose_projection(const CommonDeviceTrackingProjection &pose_projection)
+
+private:
+    ITrackerInterface *m_device;
+    int m_tracker_id;
+    int m_cpu_affinity;
+
+    // Worker thread state
+    OpenCVBufferState *m_buffer_state;
+
+    // Multithreaded state
+    std::atomic_bool m_exit_signaled;
+    std::atomic_bool m_device_failed;
+    std::atomic_bool m_video_frame_requested;
+    LockFreeTripleBuffer<TrackerColorJobList> m_color_jobs;
+    std::mutex m_device_mutex; // held while polling the device or changing its settings
+    LockFreeTripleBuffer<TrackerFrameResult> m_frame_results;
+
+    // Main thread state
+    bool m_thread_started;
+    std::thread m_worker_thread;
+};
+
+/// Holds off the worker thread's camera polls (if there is a worker thread) while
+/// the main thread changes camera settings that the video capture reads during a poll.
+class TrackerDeviceLock
+{
+public:
+    TrackerDeviceLock(TrackerWorkerThread *worker_thread)
+        : m_worker_thread(worker_thread)
     {
-        // Draw the projection of the pose onto the shared mem buffer.
-        switch (pose_projection.shape_type)
+        if (m_worker_thread != nullptr)
         {
-        case eCommonTrackingProjectionType::ProjectionType_Ellipse:
-            {
-                // For the sphere, its ellipse projection parameters should already
-                // be calculated, so we can use those parameters to draw an ellipse.
-
-                //Create cv::ellipse from pose_estimate
-                cv::Point ell_center(
-                    static_cast<int>(pose_projection.shape.ellipse.center.x),
-                    static_cast<int>(pose_projection.shape.ellipse.center.y));
-                cv::Size ell_size(
-                    static_cast<int>(pose_projection.shape.ellipse.half_x_extent),
-                    static_cast<int>(pose_projection.shape.ellipse.half_y_extent));
-
-                //Draw ellipse on bgrShmemBuffer
-                cv::ellipse(*bgrShmemBuffer,
-                    ell_center,
-                    ell_size,
-                    pose_projection.shape.ellipse.angle,
-                    0, 360, cv::Scalar(0, 0, 255));
-                cv::drawMarker(*bgrShmemBuffer, ell_center, cv::Scalar(0, 0, 255), 0,
-                    (ell_size.height < ell_size.width) ? ell_size.height * 2 : ell_size.width * 2);
-            } break;
-        case eCommonTrackingProjectionType::ProjectionType_LightBar:
-            {
-                int prev_point_index;
+            m_worker_thread->lockDevice();
+        }
+    }
 
-                prev_point_index = CommonDeviceTrackingShape::QuadVertexCount - 1;
-                for (int point_index = 0; point_index < CommonDeviceTrackingShape::QuadVertexCount; ++point_index)
-                {
-                    cv::Point pt1(
-                        static_cast<int>(pose_projection.shape.lightbar.quad[prev_point_index].x),
-                        static_cast<int>(pose_projection.shape.lightbar.quad[prev_point_index].y));
-                    cv::Point pt2(
-                        static_cast<int>(pose_projection.shape.lightbar.quad[point_index].x),
-                        static_cast<int>(pose_projection.shape.lightbar.quad[point_index].y));
-                    cv::line(*bgrShmemBuffer, pt1, pt2, cv::Scalar(0, 0, 255));
-
-                    prev_point_index = point_index;
-                }
+    ~TrackerDeviceLock()
+    {
+        if (m_worker_thread != nullptr)
+        {
+            m_worker_thread->unlockDevice();
+        }
+    }
 
-                prev_point_index = CommonDeviceTrackingShape::TriVertexCount - 1;
-                for (int point_index = 0; point_index < CommonDeviceTrackingShape::TriVertexCount; ++point_index)
-                {
-                    cv::Point pt1(
-                        static_cast<int>(pose_projection.shape.lightbar.triangle[prev_point_index].x),
-                        static_cast<int>(pose_projection.shape.lightbar.triangle[prev_point_index].y));
-                    cv::Point pt2(
-                        static_cast<int>(pose_projection.shape.lightbar.triangle[point_index].x),
-                        static_cast<int>(pose_projection.shape.lightbar.triangle[point_index].y));
-                    cv::line(*bgrShmemBuffer, pt1, pt2, cv::Scalar(0, 0, 255));
-
-                    prev_point_index = point_index;
-                }
-                
-            } break;
-        case eCommonTrackingProjectionType::ProjectionType_Points:
-            {
-                for (int point_index = 0; point_index < pose_projection.shape.points.point_count; ++point_index)
-                {
-                    cv::Point pt(
-                        static_cast<int>(pose_projection.shape.points.point[point_index].x),
-                        static_cast<int>(pose_projection.shape.points.point[point_index].y));
-                    cv::drawMarker(*bgrShmemBuffer, pt, cv::Scalar(0, 0, 255));
-                }
-            } break;
-        default:
-            assert(false && "unreachable");
-            break;
-        }		
-    }
-
-    int frameWidth;
-    int frameHeight;
-
-    cv::Mat *bgrBuffer; // source video frame
-    cv::Mat *bgrShmemBuffer; //Frame onto which we draw debug lines, and transmit via shared mem.
-    cv::Mat bgrROI;
-    cv::Mat *hsvBuffer; // source frame converted to HSV color space
-    cv::Mat hsvROI;
-    cv::Mat *gsLowerBuffer; // HSV image clamped by HSV range into grayscale mask
-    cv::Mat gsLowerROI;
-    cv::Mat *gsUpperBuffer; // HSV image clamped by HSV range into grayscale mask
-    cv::Mat gsUpperROI;
-    cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
-    OpenCVBGRToHSVMapper *bgr2hsv; // Used to convert an rgb image to an hsv image
+private:
+    TrackerWorkerThread *m_worker_thread;
 };
 
 // -- Utility Methods -----
@@ -721,16 +592,6 @@ static void computeOpenCVCameraIntrinsicMatrix(const ITrackerInterface *tracker_
                                                cv::Matx33f &intrinsicOut,
                                                cv::Matx<float, 5, 1> &distortionOut);
 static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tracker_device);
-static bool computeTrackerRelativeLightBarProjection(
-    const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour &opencv_contour,
-    CommonDeviceTrackingProjection *out_projection);
-static bool computeTrackerRelativeLightBarPose(
-    const ITrackerInterface *tracker_device,
-    const CommonDeviceTrackingShape *tracking_shape,
-    const CommonDeviceTrackingProjection *projection,
-    const CommonDevicePose *tracker_relative_pose_guess,
-    ControllerOpticalPoseEstimation *out_pose_estimate);
 static bool computeTrackerRelativePointCloudContourPose(
     const ITrackerInterface *tracker_device,
     const CommonDeviceTrackingShape *tracking_shape,
@@ -743,31 +604,13 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
     const IPoseFilter* pose_filter,
     const CommonDeviceTrackingProjection *prior_tracking_projection,
     const CommonDeviceTrackingShape *tracking_shape);
-static bool computeBestFitTriangleForContour(
-    const t_opencv_float_contour &opencv_contour,
-    cv::Point2f &out_triangle_top,
-    cv::Point2f &out_triangle_bottom_left,
-    cv::Point2f &out_triangle_bottom_right);
-static bool computeBestFitQuadForContour(
-    const t_opencv_float_contour &opencv_contour,
-    const cv::Point2f &up_hint, 
-    const cv::Point2f &right_hint,
-    cv::Point2f &top_right,
-    cv::Point2f &top_left,
-    cv::Point2f &bottom_left,
-    cv::Point2f &bottom_right);
-static void commonDeviceOrientationToOpenCVRodrigues(
-    const CommonDeviceQuaternion &orientation,
-    cv::Mat &rvec);
-static void openCVRodriguesToAngleAxis(
-    const cv::Mat &rvec,
-    float &axis_x, float &axis_y, float &axis_z, float &radians);
-static void angleAxisVectorToEulerAngles(
-    const float axis_x, const float axis_y, const float axis_z, const float radians,
-    float &yaw, float &pitch, float &roll);
-static void angleAxisVectorToCommonDeviceOrientation(
-    const float axis_x, const float axis_y, const float axis_z, const float radians,
-    CommonDeviceQuaternion &orientation);
+static bool fetchFrameContours(
+    const TrackerFrameResult &frame_result,
+    OpenCVBufferState *opencv_buffer_state,
+    int job_index,
+    cv::Rect2i &out_ROI,
+    t_opencv_int_contour_list &out_contours,
+    std::vector<double> &out_contour_areas);
 
 //-- public implementation -----
 ServerTrackerView::ServerTrackerView(const int device_id)
@@ -775,6 +618,9 @@ ServerTrackerView::ServerTrackerView(const int device_id)
     , m_shared_memory_accesor(nullptr)
     , m_shared_memory_video_stream_count(0)
     , m_opencv_buffer_state(nullptr)
+    , m_worker_thread(nullptr)
+    , m_color_jobs(new TrackerColorJobList)
+    , m_frame_result(new TrackerFrameResult)
     , m_device(nullptr)
 {
     ServerUtility::format_string(m_shared_memory_name, sizeof(m_shared_memory_name), "tracker_view_%d", device_id);
@@ -782,6 +628,12 @@ ServerTrackerView::ServerTrackerView(const int device_id)
 
 ServerTrackerView::~ServerTrackerView()
 {
+    // Make sure the worker thread is done with the device before it gets deleted
+    stop_worker_thread();
+
+    delete m_color_jobs;
+    delete m_frame_result;
+
     if (m_shared_memory_accesor != nullptr)
     {
         delete m_shared_memory_accesor;
@@ -847,8 +699,18 @@ bool ServerTrackerView::open(const class DeviceEnumerator *enumerator)
                 SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to allocated shared memory: " << m_shared_memory_name;
             }
 
+            // Optionally segment the raw Bayer frames, debayering only what is needed
+            const TrackerManagerConfig &cfg = DeviceManager::getInstance()->m_tracker_manager->getConfig();
+            if (cfg.segment_raw_bayer_frames && !m_device->setCaptureRawBayerFrames(true))
+            {
+                SERVER_LOG_WARNING("ServerTrackerView::open()") << "Camera driver can't provide raw Bayer frames, using BGR frames";
+            }
+
             // Allocate the OpenCV scratch buffers used for finding tracking blobs
-            m_opencv_buffer_state = new OpenCVBufferState(m_device);
+            m_opencv_buffer_state = allocateOpenCVBufferState(m_device);
+
+            // Optionally move frame capture and segmentation to a worker thread
+            start_worker_thread();
         }
         else
         {
@@ -861,6 +723,9 @@ bool ServerTrackerView::open(const class DeviceEnumerator *enumerator)
 
 void ServerTrackerView::close()
 {
+    // The worker thread has to stop touching the device before it gets closed
+    stop_worker_thread();
+
     if (m_shared_memory_accesor != nullptr)
     {
         delete m_shared_memory_accesor;
@@ -873,42 +738,213 @@ void ServerTrackerView::close()
 void ServerTrackerView::startSharedMemoryVideoStream()
 {
     ++m_shared_memory_video_stream_count;
+
+    if (m_worker_thread != nullptr)
+    {
+        m_worker_thread->setIsVideoFrameRequested(true);
+    }
 }
 
 void ServerTrackerView::stopSharedMemoryVideoStream()
 {
     assert(m_shared_memory_video_stream_count > 0);
     --m_shared_memory_video_stream_count;
+
+    if (m_worker_thread != nullptr)
+    {
+        m_worker_thread->setIsVideoFrameRequested(m_shared_memory_video_stream_count > 0);
+    }
 }
 
 bool ServerTrackerView::poll()
 {
+    // Frames are captured on the worker thread, so just consume its results
+    if (m_worker_thread != nullptr)
+    {
+        return poll_worker_thread();
+    }
+
     bool bSuccess = ServerDeviceView::poll();
 
     if (bSuccess && m_device != nullptr)
     {
+        const unsigned char *bayer_buffer = m_device->getVideoFrameBayerBuffer();
         const unsigned char *buffer = m_device->getVideoFrameBuffer();
 
-        if (buffer != nullptr)
+        if ((bayer_buffer != nullptr || buffer != nullptr) && m_opencv_buffer_state != nullptr)
         {
             // Cache the raw video frame
-            if (m_opencv_buffer_state != nullptr)
+            if (bayer_buffer != nullptr)
+            {
+                // Only pay for a full debayer when a client is watching the video
+                m_opencv_buffer_state->writeBayerFrame(bayer_buffer, m_shared_memory_video_stream_count > 0);
+            }
+            else
             {
                 m_opencv_buffer_state->writeVideoFrame(buffer);
             }
+
+            // Find the contours of every tracked color in the new frame
+            build_color_jobs(*m_color_jobs);
+            computeContoursForColorJobs(m_opencv_buffer_state, *m_color_jobs, *m_frame_result);
         }
     }
 
     return bSuccess;
 }
 
+void ServerTrackerView::start_worker_thread()
+{
+    const TrackerManager *tracker_manager = DeviceManager::getInstance()->m_tracker_manager;
+    const TrackerManagerConfig &cfg = tracker_manager->getConfig();
+
+    if (tracker_manager->getUseWorkerThreads() && m_worker_thread == nullptr)
+    {
+        const int cpu_affinity = 
+            (cfg.tracker_worker_thread_affinity >= 0) 
+            ? cfg.tracker_worker_thread_affinity + getDeviceID()
+            : -1;
+
+        m_worker_thread = new TrackerWorkerThread(m_device, getDeviceID(), cpu_affinity);
+        m_worker_thread->setIsVideoFrameRequested(m_shared_memory_video_stream_count > 0);
+        build_color_jobs(m_worker_thread->getColorJobsMutable());
+        m_worker_thread->publishColorJobs();
+        m_worker_thread->start();
+    }
+}
+
+void ServerTrackerView::stop_worker_thread()
+{
+    if (m_worker_thread != nullptr)
+    {
+        m_worker_thread->stop();
+        delete m_worker_thread;
+        m_worker_thread = nullptr;
+    }
+}
+
+bool ServerTrackerView::poll_worker_thread()
+{
+    bool bSuccess = true;
+
+    if (m_worker_thread->getHasDeviceFailed())
+    {
+        // Closes the device (and stops the worker thread)
+        bSuccess = handle_poll_result(IDeviceInterface::_PollResultFailure);
+    }
+    else if (m_worker_thread->fetchFrameResult())
+    {
+        const TrackerFrameResult &frame_result = m_worker_thread->getFrameResult();
+
+        // Cache the raw video frame for the debug overlay and the shared memory stream.
+        // Without a video stream client there is no frame to cache.
+        if (!frame_result.bHasVideoFrame || m_shared_memory_video_stream_count == 0)
+        {
+            m_opencv_buffer_state->clearVideoFrame();
+        }
+        else if (frame_result.videoFrame.type() == CV_8UC1)
+        {
+            m_opencv_buffer_state->writeBayerFrame(frame_result.videoFrame.data, true);
+        }
+        else
+        {
+            m_opencv_buffer_state->writeVideoFrame(frame_result.videoFrame.data);
+        }
+
+        bSuccess = handle_poll_result(IDeviceInterface::_PollResultSuccessNewData);
+
+        // Date the frame from when the worker got it rather than when we picked it up
+        m_lastNewDataTimestamp = frame_result.arrivalTime;
+    }
+    // No new frame yet: the worker thread keeps track of the camera not producing data
+
+    // Tell the worker what to look for in the next frame
+    if (bSuccess && m_worker_thread != nullptr)
+    {
+        build_color_jobs(m_worker_thread->getColorJobsMutable());
+        m_worker_thread->publishColorJobs();
+    }
+
+    return bSuccess;
+}
+
+void ServerTrackerView::build_color_jobs(TrackerColorJobList &color_jobs)
+{
+    DeviceManager *device_manager = DeviceManager::getInstance();
+    const TrackerManagerConfig &trackerMgrConfig = device_manager->m_tracker_manager->getConfig();
+
+    color_jobs.clear();
+
+    for (int controller_id = 0; controller_id < device_manager->getControllerViewMaxCount(); ++controller_id)
+    {
+        ServerControllerViewPtr controller = device_manager->getControllerViewPtr(controller_id);
+        const eCommonTrackingColorID color_id = controller->getIsOpen() ? controller->getTrackingColorID() : eCommonTrackingColorID::INVALID_COLOR;
+        CommonDeviceTrackingShape tracking_shape;
+
+        if (controller->getIsTrackingEnabled() && 
+            color_id != eCommonTrackingColorID::INVALID_COLOR &&
+            controller->getTrackingShape(tracking_shape))
+        {
+            const ControllerOpticalPoseEstimation *priorPoseEst = controller->getTrackerPoseEstimate(getDeviceID());
+            const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
+            TrackerColorJob &job = color_jobs.jobs[getControllerColorJobIndex(controller_id)];
+
+            job.bIsActive = true;
+            job.color_id = color_id;
+            getControllerTrackingColorPreset(controller.get(), color_id, &job.hsv_color_range);
+            job.ROI = computeTrackerROIForPoseProjection(
+                controller->getIsROIDisabled() || trackerMgrConfig.disable_roi,
+                this,
+                bIsTracking ? controller->getPoseFilter() : nullptr,
+                bIsTracking ? &priorPoseEst->projection : nullptr,
+                &tracking_shape);
+            job.max_contour_count = 1;
+        }
+    }
+
+    for (int hmd_id = 0; hmd_id < device_manager->getHMDViewMaxCount(); ++hmd_id)
+    {
+        ServerHMDViewPtr hmd = device_manager->getHMDViewPtr(hmd_id);
+        const eCommonTrackingColorID color_id = hmd->getIsOpen() ? hmd->getTrackingColorID() : eCommonTrackingColorID::INVALID_COLOR;
+        CommonDeviceTrackingShape tracking_shape;
+
+        if (hmd->getIsTrackingEnabled() && 
+            color_id != eCommonTrackingColorID::INVALID_COLOR &&
+            hmd->getTrackingShape(tracking_shape))
+        {
+            const HMDOpticalPoseEstimation *priorPoseEst = hmd->getTrackerPoseEstimate(getDeviceID());
+            const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
+            TrackerColorJob &job = color_jobs.jobs[getHMDColorJobIndex(hmd_id)];
+
+            job.bIsActive = true;
+            job.color_id = color_id;
+            getHMDTrackingColorPreset(hmd.get(), color_id, &job.hsv_color_range);
+            job.ROI = computeTrackerROIForPoseProjection(
+                hmd->getIsROIDisabled() || trackerMgrConfig.disable_roi,
+                this,
+                bIsTracking ? hmd->getPoseFilter() : nullptr,
+                bIsTracking ? &priorPoseEst->projection : nullptr,
+                &tracking_shape);
+            job.max_contour_count = CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT;
+        }
+    }
+}
+
 bool ServerTrackerView::allocate_device_interface(const class DeviceEnumerator *enumerator)
 {
     switch (enumerator->get_device_type())
     {
     case CommonDeviceState::PS3EYE:
     {
-        m_device = new PS3EyeTracker();
+        // A replay serves the recorded frames instead of a live camera
+        if (DeviceInputReplayer::getInstance() != nullptr)
+        {
+            m_device = new ReplayTracker();
+        }
+        else
+        {
+            m_device = new PS3EyeTracker();
+        }
     } break;
     default:
         break;
@@ -932,7 +968,8 @@ void ServerTrackerView::free_device_interface()
 void ServerTrackerView::publish_device_data_frame()
 {
     // Copy the video frame to shared memory (if requested)
-    if (m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0)
+    if (m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0 &&
+        m_opencv_buffer_state->rasterizeDebugOverlay())
     {
         m_shared_memory_accesor->writeVideoFrame(m_opencv_buffer_state->bgrShmemBuffer->data);
     }
@@ -946,7 +983,7 @@ void ServerTrackerView::publish_device_data_frame()
 void ServerTrackerView::generate_tracker_data_frame_for_stream(
     const ServerTrackerView *tracker_view,
     const struct TrackerStreamInfo *stream_info,
-    DeviceOutputDataFramePtr &data_frame)
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
 {
     PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket *tracker_data_frame =
         data_frame->mutable_tracker_data_packet();
@@ -970,6 +1007,8 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
 
 void ServerTrackerView::loadSettings()
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     m_device->loadSettings();
 }
 
@@ -987,6 +1026,9 @@ void ServerTrackerView::setFrameWidth(double value, bool bUpdateConfig)
 {
     if (value == m_device->getFrameWidth()) return;
 
+    // The worker thread can't be capturing while the video mode changes
+    stop_worker_thread();
+
     // close buffer
     if (m_shared_memory_accesor != nullptr)
     {
@@ -1018,7 +1060,13 @@ void ServerTrackerView::setFrameWidth(double value, bool bUpdateConfig)
         }
 
         // Allocate the OpenCV scratch buffers used for finding tracking blobs
-        m_opencv_buffer_state = new OpenCVBufferState(m_device);
+        if (m_opencv_buffer_state != nullptr)
+        {
+            delete m_opencv_buffer_state;
+        }
+        m_opencv_buffer_state = allocateOpenCVBufferState(m_device);
+
+        start_worker_thread();
     }
     else
     {
@@ -1035,6 +1083,9 @@ void ServerTrackerView::setFrameHeight(double value, bool bUpdateConfig)
 {
     if (value == m_device->getFrameHeight()) return;
 
+    // The worker thread can't be capturing while the video mode changes
+    stop_worker_thread();
+
     // close buffer
     if (m_shared_memory_accesor != nullptr)
     {
@@ -1066,7 +1117,13 @@ void ServerTrackerView::setFrameHeight(double value, bool bUpdateConfig)
         }
 
         // Allocate the OpenCV scratch buffers used for finding tracking blobs
-        m_opencv_buffer_state = new OpenCVBufferState(m_device);
+        if (m_opencv_buffer_state != nullptr)
+        {
+            delete m_opencv_buffer_state;
+        }
+        m_opencv_buffer_state = allocateOpenCVBufferState(m_device);
+
+        start_worker_thread();
     }
     else
     {
@@ -1076,31 +1133,43 @@ void ServerTrackerView::setFrameHeight(double value, bool bUpdateConfig)
 
 double ServerTrackerView::getFrameRate() const
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     return m_device->getFrameRate();
 }
 
 void ServerTrackerView::setFrameRate(double value, bool bUpdateConfig)
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     m_device->setFrameRate(value, bUpdateConfig);
 }
 
 double ServerTrackerView::getExposure() const
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     return m_device->getExposure();
 }
 
 void ServerTrackerView::setExposure(double value, bool bUpdateConfig)
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     m_device->setExposure(value, bUpdateConfig);
 }
 
 double ServerTrackerView::getGain() const
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     return m_device->getGain();
 }
 
 void ServerTrackerView::setGain(double value, bool bUpdateConfig)
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     m_device->setGain(value, bUpdateConfig);
 }
 
@@ -1168,6 +1237,8 @@ void ServerTrackerView::gatherTrackerOptions(PSMoveProtocol::Response_ResultTrac
 
 bool ServerTrackerView::setOptionIndex(const std::string &option_name, int option_index)
 {
+    TrackerDeviceLock device_lock(m_worker_thread);
+
     return m_device->setOptionIndex(option_name, option_index);
 }
 
@@ -1240,48 +1311,20 @@ ServerTrackerView::computeProjectionForController(
     const CommonDeviceTrackingShape *tracking_shape,
     ControllerOpticalPoseEstimation *out_pose_estimate)
 {
-    bool bSuccess = true;
-
-    // Get the HSV filter used to find the tracking blob
-    CommonHSVColorRange hsvColorRange;
-    if (bSuccess)
-    {
-        eCommonTrackingColorID tracked_color_id = tracked_controller->getTrackingColorID();
-
-        if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
-        {
-            getControllerTrackingColorPreset(tracked_controller, tracked_color_id, &hsvColorRange);
-        }
-        else
-        {
-            bSuccess = false;
-        }
-    }
-
-    // Compute a region of interest in the tracker buffer around where we expect to find the tracking shape
     const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
     const bool bRoiDisabled = tracked_controller->getIsROIDisabled() || trackerMgrConfig.disable_roi;
 
-    const ControllerOpticalPoseEstimation *priorPoseEst= 
-        tracked_controller->getTrackerPoseEstimate(this->getDeviceID());
-    const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
-
-    cv::Rect2i ROI= computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this,		
-        bIsTracking ? tracked_controller->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
-
-    m_opencv_buffer_state->applyROI(ROI);
-
-    // Find the contour associated with the controller
+    // Find the contour associated with the controller.
+    // Every tracked color was already segmented when the video frame was polled.
+    const TrackerFrameResult &frame_result = 
+        (m_worker_thread != nullptr) ? m_worker_thread->getFrameResult() : *m_frame_result;
+    cv::Rect2i ROI;
     t_opencv_int_contour_list biggest_contours;
     std::vector<double> contour_areas;
-    if (bSuccess)
-    {
-        bSuccess = m_opencv_buffer_state->computeBiggestNContours(hsvColorRange, biggest_contours, contour_areas, 1);
-    }
+    bool bSuccess = 
+        fetchFrameContours(
+            frame_result, m_opencv_buffer_state, getControllerColorJobIndex(tracked_controller->getDeviceID()), 
+            ROI, biggest_contours, contour_areas);
     
     // Process the contour for its 2D and 3D pose.
     if (bSuccess)
@@ -1303,64 +1346,24 @@ ServerTrackerView::computeProjectionForController(
                 cv::convexHull(biggest_contours[0], convex_contour);
                 m_opencv_buffer_state->draw_contour(convex_contour);
 
-                // Convert integer to float
-                t_opencv_float_contour convex_contour_f;
-                cv::Mat(convex_contour).convertTo(convex_contour_f, cv::Mat(convex_contour_f).type());
-
-                // Undistort points
-                t_opencv_float_contour undistort_contour;  //destination for undistorted contour
-                cv::undistortPoints(convex_contour_f, undistort_contour,
-                                    camera_matrix,
-                                    distortions);//,
-                                    //cv::noArray(),
-                                    //camera_matrix);
-                // Note: if we omit the last two arguments, then
-                // undistort_contour points are in 'normalized' space.
-                // i.e., they are relative to their F_PX,F_PY
-                
+                // Undistort points into 'normalized' space,
+                // i.e., relative to their F_PX,F_PY
+                t_opencv_float_contour undistort_contour;
+                computeUndistortedContour(convex_contour, camera_matrix, distortions, true, undistort_contour);
+
                 // Compute the sphere center AND the projected ellipse
-                Eigen::Vector3f sphere_center;
-                EigenFitEllipse ellipse_projection;
-
-                std::vector<Eigen::Vector2f> eigen_contour;
-                std::for_each(undistort_contour.begin(),
-                              undistort_contour.end(),
-                              [&eigen_contour](cv::Point2f& p) {
-                                  eigen_contour.push_back(Eigen::Vector2f(p.x, p.y));
-                              });
-                eigen_alignment_fit_focal_cone_to_sphere(eigen_contour.data(),
-                                                         static_cast<int>(eigen_contour.size()),
-                                                         tracking_shape->shape.sphere.radius_cm,
-                                                         1, //I was expecting this to be -1. Is it +1 because we're using -F_PY?
-                                                         &sphere_center,
-                                                         &ellipse_projection);
-                
-                if (ellipse_projection.area > k_real_epsilon)
+                if (computeTrackerRelativeSphereProjection(
+                        tracking_shape,
+                        undistort_contour,
+                        camera_matrix,
+                        &out_pose_estimate->position_cm,
+                        &out_pose_estimate->projection))
                 {
-                    //Save the optically-estimate 3D pose.
-                    out_pose_estimate->position_cm.set(sphere_center.x(), sphere_center.y(), sphere_center.z());
                     out_pose_estimate->bCurrentlyTracking = true;
                     // Not possible to get an orientation off of a sphere
                     out_pose_estimate->orientation.clear();
                     out_pose_estimate->bOrientationValid = false;
 
-                    // Save off the projection of the sphere (an ellipse)
-                    out_pose_estimate->projection.shape.ellipse.angle = ellipse_projection.angle;
-                    out_pose_estimate->projection.screen_area= ellipse_projection.area;
-                    //The ellipse projection is still in normalized space.
-                    //i.e., it is a 2-dimensional ellipse floating somewhere.
-                    //We must reproject it onto the camera.
-                    //TODO: Use opencv's project points instead of manual way below
-                    //because it will account for distortion, at least for the center point.
-                    out_pose_estimate->projection.shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
-                    out_pose_estimate->projection.shape.ellipse.center.set(
-                        ellipse_projection.center.x()*camera_matrix.val[0] + camera_matrix.val[2],
-                        ellipse_projection.center.y()*camera_matrix.val[4] + camera_matrix.val[5]);
-                    out_pose_estimate->projection.shape.ellipse.half_x_extent = ellipse_projection.extents.x()*camera_matrix.val[0];
-                    out_pose_estimate->projection.shape.ellipse.half_y_extent = ellipse_projection.extents.y()*camera_matrix.val[0];
-                    out_pose_estimate->projection.screen_area=
-                        k_real_pi*out_pose_estimate->projection.shape.ellipse.half_x_extent*out_pose_estimate->projection.shape.ellipse.half_y_extent;
-                
                     //Draw results onto m_opencv_buffer_state
                     m_opencv_buffer_state->draw_pose_projection(out_pose_estimate->projection);
 
@@ -1374,17 +1377,9 @@ ServerTrackerView::computeProjectionForController(
                 // Draw the raw source contour
                 m_opencv_buffer_state->draw_contour(biggest_contours[0]);
 
-                // Convert integer contour to float
-                t_opencv_float_contour biggest_contour_f;
-                cv::Mat(biggest_contours[0]).convertTo(biggest_contour_f, cv::Mat(biggest_contour_f).type());
-
                 // Compute an undistorted version of the contour
                 t_opencv_float_contour undistort_contour;
-                cv::undistortPoints(biggest_contour_f, undistort_contour,
-                                    camera_matrix,
-                                    distortions,
-                                    cv::noArray(),
-                                    camera_matrix);
+                computeUndistortedContour(biggest_contours[0], camera_matrix, distortions, false, undistort_contour);
 
                 // Compute the lightbar tracking projection from the undistored contour
                 bSuccess=
@@ -1423,49 +1418,20 @@ bool ServerTrackerView::computeProjectionForHMD(
     const struct CommonDeviceTrackingShape *tracking_shape,
     struct HMDOpticalPoseEstimation *out_pose_estimate)
 {
-    bool bSuccess = true;
-
-    // Get the HSV filter used to find the tracking blob
-    CommonHSVColorRange hsvColorRange;
-    if (bSuccess)
-    {
-        eCommonTrackingColorID tracked_color_id = tracked_hmd->getTrackingColorID();
-
-        if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
-        {
-            getHMDTrackingColorPreset(tracked_hmd, tracked_color_id, &hsvColorRange);
-        }
-        else
-        {
-            bSuccess = false;
-        }
-    }
-    
-    // Compute a region of interest in the tracker buffer around where we expect to find the tracking shape
     const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
     const bool bRoiDisabled = tracked_hmd->getIsROIDisabled() || trackerMgrConfig.disable_roi;
 
-    const HMDOpticalPoseEstimation *priorPoseEst= 
-        tracked_hmd->getTrackerPoseEstimate(this->getDeviceID());
-    const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
-
-    cv::Rect2i ROI = computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this, 
-        bIsTracking ? tracked_hmd->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
-    m_opencv_buffer_state->applyROI(ROI);
-
-    // Find the N best contours associated with the HMD
+    // Find the contours associated with the HMD.
+    // Every tracked color was already segmented when the video frame was polled.
+    const TrackerFrameResult &frame_result = 
+        (m_worker_thread != nullptr) ? m_worker_thread->getFrameResult() : *m_frame_result;
+    cv::Rect2i ROI;
     t_opencv_int_contour_list biggest_contours;
     std::vector<double> contour_areas;
-    if (bSuccess)
-    {
-        bSuccess = 
-            m_opencv_buffer_state->computeBiggestNContours(
-                hsvColorRange, biggest_contours, contour_areas, CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT);
-    }
+    bool bSuccess = 
+        fetchFrameContours(
+            frame_result, m_opencv_buffer_state, getHMDColorJobIndex(tracked_hmd->getDeviceID()), 
+            ROI, biggest_contours, contour_areas);
 
     // Compute the tracker relative 3d position of the controller from the contour
     if (bSuccess)
@@ -1484,64 +1450,24 @@ bool ServerTrackerView::computeProjectionForHMD(
                 cv::convexHull(biggest_contours[0], convex_contour);
                 m_opencv_buffer_state->draw_contour(convex_contour);
 
-                // Convert integer to float
-                t_opencv_float_contour convex_contour_f;
-                cv::Mat(convex_contour).convertTo(convex_contour_f, cv::Mat(convex_contour_f).type());
-
-                // Undistort points
-                t_opencv_float_contour undistorted_contour;  //destination for undistorted contour
-                cv::undistortPoints(convex_contour_f, undistorted_contour,
-                                    camera_matrix,
-                                    distortions);//,
-                                    //cv::noArray(),
-                                    //camera_matrix);
-                // Note: if we omit the last two arguments, then
-                // undistort_contour points are in 'normalized' space.
-                // i.e., they are relative to their F_PX,F_PY
-                
+                // Undistort points into 'normalized' space,
+                // i.e., relative to their F_PX,F_PY
+                t_opencv_float_contour undistorted_contour;
+                computeUndistortedContour(convex_contour, camera_matrix, distortions, true, undistorted_contour);
+
                 // Compute the sphere center AND the projected ellipse
-                Eigen::Vector3f sphere_center;
-                EigenFitEllipse ellipse_projection;
-
-                std::vector<Eigen::Vector2f> eigen_contour;
-                std::for_each(undistorted_contour.begin(),
-                              undistorted_contour.end(),
-                              [&eigen_contour](const cv::Point2f& p) {
-                                  eigen_contour.push_back(Eigen::Vector2f(p.x, p.y));
-                              });
-                eigen_alignment_fit_focal_cone_to_sphere(eigen_contour.data(),
-                                                         static_cast<int>(eigen_contour.size()),
-                                                         tracking_shape->shape.sphere.radius_cm,
-                                                         1, //I was expecting this to be -1. Is it +1 because we're using -F_PY?
-                                                         &sphere_center,
-                                                         &ellipse_projection);
-                
-                if (ellipse_projection.area > k_real_epsilon)
+                if (computeTrackerRelativeSphereProjection(
+                        tracking_shape,
+                        undistorted_contour,
+                        camera_matrix,
+                        &out_pose_estimate->position_cm,
+                        &out_pose_estimate->projection))
                 {
-                    //Save the optically-estimate 3D pose.
-                    out_pose_estimate->position_cm.set(sphere_center.x(), sphere_center.y(), sphere_center.z());
                     out_pose_estimate->bCurrentlyTracking = true;
                     // Not possible to get an orientation off of a sphere
                     out_pose_estimate->orientation.clear();
                     out_pose_estimate->bOrientationValid = false;
 
-                    // Save off the projection of the sphere (an ellipse)
-                    out_pose_estimate->projection.shape.ellipse.angle = ellipse_projection.angle;
-                    out_pose_estimate->projection.screen_area= ellipse_projection.area;
-                    //The ellipse projection is still in normalized space.
-                    //i.e., it is a 2-dimensional ellipse floating somewhere.
-                    //We must reproject it onto the camera.
-                    //TODO: Use opencv's project points instead of manual way below
-                    //because it will account for distortion, at least for the center point.
-                    out_pose_estimate->projection.shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
-                    out_pose_estimate->projection.shape.ellipse.center.set(
-                        ellipse_projection.center.x()*camera_matrix.val[0] + camera_matrix.val[2],
-                        ellipse_projection.center.y()*camera_matrix.val[4] + camera_matrix.val[5]);
-                    out_pose_estimate->projection.shape.ellipse.half_x_extent = ellipse_projection.extents.x()*camera_matrix.val[0];
-                    out_pose_estimate->projection.shape.ellipse.half_y_extent = ellipse_projection.extents.y()*camera_matrix.val[0];
-                    out_pose_estimate->projection.screen_area=
-                        k_real_pi*out_pose_estimate->projection.shape.ellipse.half_x_extent*out_pose_estimate->projection.shape.ellipse.half_y_extent;
-                
                     //Draw results onto m_opencv_buffer_state
                     m_opencv_buffer_state->draw_pose_projection(out_pose_estimate->projection);
 
@@ -1613,13 +1539,21 @@ ServerTrackerView::computePoseForProjection(
         } break;
     case eCommonTrackingShapeType::LightBar:
         {
+            // Get the tracker "intrinsic" matrix that encodes the camera FOV
+            cv::Matx33f camera_matrix;
+            cv::Matx<float, 5, 1> distortions;
+            computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
+
             bSuccess =
                 computeTrackerRelativeLightBarPose(
-                    m_device,
+                    camera_matrix,
+                    distortions,
                     tracking_shape,
                     projection,
                     pose_guess,
-                    out_pose_estimate);
+                    &out_pose_estimate->position_cm,
+                    &out_pose_estimate->orientation,
+                    &out_pose_estimate->bOrientationValid);
         } break;
     default:
         assert(0 && "Unreachable");
@@ -2045,222 +1979,6 @@ static cv::Matx34f computeOpenCVCameraPinholeMatrix(const ITrackerInterface *tra
     return pinhole_matrix;
 }
 
-static bool computeTrackerRelativeLightBarProjection(
-    const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour &opencv_contour,
-    CommonDeviceTrackingProjection *out_projection)
-{
-    assert(tracking_shape->shape_type == eCommonTrackingShapeType::LightBar);
-
-    bool bValidTrackerProjection= true;
-    float projectionArea= 0.f;
-    std::vector<cv::Point2f> cvImagePoints;
-    {
-        cv::Point2f tri_top, tri_bottom_left, tri_bottom_right;
-        cv::Point2f quad_top_right, quad_top_left, quad_bottom_left, quad_bottom_right;
-
-        // Create a best fit triangle around the contour
-        bValidTrackerProjection= computeBestFitTriangleForContour(
-            opencv_contour, 
-            tri_top, tri_bottom_left, tri_bottom_right);
-
-        // Also create a best fit quad around the contour
-        // Use the best fit triangle to define the orientation
-        if (bValidTrackerProjection)
-        {
-            // Use the triangle to define an up and a right direction
-            const cv::Point2f up_hint= tri_top - 0.5f*(tri_bottom_left + tri_bottom_right);
-            const cv::Point2f right_hint= tri_bottom_right - tri_bottom_left;
-
-            bValidTrackerProjection= computeBestFitQuadForContour(
-                opencv_contour, 
-                up_hint, right_hint, 
-                quad_top_right, quad_top_left, quad_bottom_left, quad_bottom_right);
-        }
-
-        if (bValidTrackerProjection)
-        {
-            // In practice the best fit triangle top is a bit noisy.
-            // Since it should be at the midpoint of the top of the quad we use that instead.
-            tri_top= 0.5f*(quad_top_right + quad_top_left);
-
-            // Put the image points in corresponding order with cvObjectPoints
-            cvImagePoints.push_back(tri_bottom_right);
-            cvImagePoints.push_back(tri_bottom_left);
-            cvImagePoints.push_back(tri_top);
-            cvImagePoints.push_back(quad_top_right);
-            cvImagePoints.push_back(quad_top_left);
-            cvImagePoints.push_back(quad_bottom_left);
-            cvImagePoints.push_back(quad_bottom_right);
-
-            // The projection area is the size of the best fit quad
-            projectionArea= 
-                static_cast<float>(
-                    cv::norm(quad_bottom_right-quad_bottom_left)
-                    *cv::norm(quad_bottom_left-quad_top_left));                   
-        }
-    }
-
-    // Return the projection of the tracking shape
-    if (bValidTrackerProjection)
-    {
-        out_projection->shape_type = eCommonTrackingProjectionType::ProjectionType_LightBar;
-
-        for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
-        {
-            const cv::Point2f &cvPoint = cvImagePoints[vertex_index];
-
-            out_projection->shape.lightbar.triangle[vertex_index] = { cvPoint.x, cvPoint.y };
-        }
-
-        for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
-        {
-            const cv::Point2f &cvPoint = cvImagePoints[vertex_index + 3];
-
-            out_projection->shape.lightbar.quad[vertex_index] = { cvPoint.x, cvPoint.y };
-        }
-
-        out_projection->screen_area= projectionArea;
-    }
-
-    return bValidTrackerProjection;
-}
-
-static bool computeTrackerRelativeLightBarPose(
-    const ITrackerInterface *tracker_device,
-    const CommonDeviceTrackingShape *tracking_shape,
-    const CommonDeviceTrackingProjection *projection,
-    const CommonDevicePose *tracker_relative_pose_guess,
-    ControllerOpticalPoseEstimation *out_pose_estimate)
-{
-    assert(tracking_shape->shape_type == eCommonTrackingShapeType::LightBar);
-    assert(projection->shape_type == eCommonTrackingProjectionType::ProjectionType_LightBar);
-
-    bool bValidTrackerPose= true;
-    std::vector<cv::Point2f> cvImagePoints;
-
-    for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
-    {
-        const CommonDeviceScreenLocation &screenLocation= projection->shape.lightbar.triangle[vertex_index];
-
-        cvImagePoints.push_back(cv::Point2f(screenLocation.x, screenLocation.y));
-    }
-
-    for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
-    {
-        const CommonDeviceScreenLocation &screenLocation = projection->shape.lightbar.quad[vertex_index];
-
-        cvImagePoints.push_back(cv::Point2f(screenLocation.x, screenLocation.y));
-    }
-
-    // Solve the tracking position using solvePnP
-    if (bValidTrackerPose)
-    {
-        // Copy the object/image point mappings into OpenCV format
-        // Assumed vertex order is:
-        // triangle - right, left, bottom
-        // quad - top right, top left, bottom left, bottom right
-        std::vector<cv::Point3f> cvObjectPoints;
-
-        for (int corner_index= 0; corner_index < 3; ++corner_index)
-        {        
-            const CommonDevicePosition &corner = tracking_shape->shape.light_bar.triangle[corner_index];
-
-            cvObjectPoints.push_back(cv::Point3f(corner.x, corner.y, corner.z));
-        }
-
-        for (int corner_index= 0; corner_index < 4; ++corner_index)
-        {        
-            const CommonDevicePosition &corner = tracking_shape->shape.light_bar.quad[corner_index];
-
-            cvObjectPoints.push_back(cv::Point3f(corner.x, corner.y, corner.z));
-        }
-
-        // Get the tracker "intrinsic" matrix that encodes the camera FOV
-        cv::Matx33f cvCameraMatrix;
-        cv::Matx<float, 5, 1> cvDistCoeffs;
-        computeOpenCVCameraIntrinsicMatrix(tracker_device, cvCameraMatrix, cvDistCoeffs);
-
-        // Fill out the initial guess in OpenCV format for the contour pose
-        // if a guess pose was provided
-        cv::Mat rvec(3, 1, cv::DataType<double>::type);
-        cv::Mat tvec(3, 1, cv::DataType<double>::type);
-
-        bool bUseExtrinsicGuess= false;
-        if (tracker_relative_pose_guess != nullptr)
-        {
-            const float k_max_valid_guess_distance= 300.f; // cm
-            float guess_position_distance_sqrd= 
-                tracker_relative_pose_guess->PositionCm.x*tracker_relative_pose_guess->PositionCm.x
-                + tracker_relative_pose_guess->PositionCm.y*tracker_relative_pose_guess->PositionCm.y
-                + tracker_relative_pose_guess->PositionCm.z*tracker_relative_pose_guess->PositionCm.z;
-
-            if (guess_position_distance_sqrd < k_max_valid_guess_distance*k_max_valid_guess_distance)
-            {
-                // solvePnP expects a rotation as a Rodrigues (AngleAxis) vector
-                commonDeviceOrientationToOpenCVRodrigues(tracker_relative_pose_guess->Orientation, rvec);
-
-                tvec.at<double>(0)= tracker_relative_pose_guess->PositionCm.x;
-                tvec.at<double>(1)= tracker_relative_pose_guess->PositionCm.y;
-                tvec.at<double>(2)= tracker_relative_pose_guess->PositionCm.z;
-
-                bUseExtrinsicGuess= true;
-            }
-        }
-
-        // Solve the Perspective-N-Point problem:
-        // Given a set of 3D points and their corresponding 2D pixel projections,
-        // solve for the object position and orientation that would allow
-        // us to re-project the 3D points back onto the 2D pixel locations
-        if (cv::solvePnP(
-                cvObjectPoints, cvImagePoints, 
-                cvCameraMatrix, cvDistCoeffs, 
-                rvec, tvec, 
-                bUseExtrinsicGuess, cv::SOLVEPNP_ITERATIVE))
-        {
-            float axis_x, axis_y, axis_z, axis_theta;
-            float yaw, pitch, roll;
-
-            // Extract the angle-axis components from the solution OpenCV Rodrigues vector
-            openCVRodriguesToAngleAxis(rvec, axis_x, axis_y, axis_z, axis_theta);
-
-            // Convert the angle-axis rotation into Euler angles (yaw-pitch-roll)
-            angleAxisVectorToEulerAngles(axis_x, axis_y, axis_z, axis_theta, yaw, pitch, roll);
-           
-            //###HipsterSloth $TODO This should be a property of the lightbar tracking shape
-            static const float k_max_valid_tracking_pitch= 30.f*k_degrees_to_radians;
-            static const float k_max_valid_tracking_yaw= 30.f*k_degrees_to_radians;
-
-            // Due to ambiguity of the off the yaw and pitch solution from solvePnP (two possible solutions)
-            // we can't trust anything more than close to straightforward.
-            // Any roll angle is fine though.
-            if (fabsf(yaw) < k_max_valid_tracking_yaw && fabsf(pitch) < k_max_valid_tracking_pitch)
-            {           
-                // Convert the solution angle-axis into a CommonDeviceOrientation
-                angleAxisVectorToCommonDeviceOrientation(axis_x, axis_y, axis_z, axis_theta, out_pose_estimate->orientation);
-                out_pose_estimate->bOrientationValid= true;
-            }
-            else
-            {
-                out_pose_estimate->bOrientationValid= false;
-            }
-
-            // Return the position in the pose
-            {
-                CommonDevicePosition &position= out_pose_estimate->position_cm;
-
-                position.x = static_cast<float>(tvec.at<double>(0));
-                position.y = static_cast<float>(tvec.at<double>(1));
-                position.z = static_cast<float>(tvec.at<double>(2));
-            }
-
-            bValidTrackerPose= true;
-        }
-    }
-
-    return bValidTrackerPose;
-}
-
 static bool computeTrackerRelativePointCloudContourPose(
     const ITrackerInterface *tracker_device,
     const CommonDeviceTrackingShape *tracking_shape,
@@ -2471,302 +2189,26 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
     return ROI;
 }
 
-static bool computeBestFitTriangleForContour(
-    const t_opencv_float_contour &opencv_contour,
-    cv::Point2f &out_triangle_top,
-    cv::Point2f &out_triangle_bottom_left,
-    cv::Point2f &out_triangle_bottom_right)
-{
-    // Compute the tightest possible bounding triangle for the given contour
-    t_opencv_float_contour cv_min_triangle;
-
-    try
-    {
-        cv::minEnclosingTriangle(opencv_contour, cv_min_triangle);
-    }
-    catch( cv::Exception& e )
-    {
-        SERVER_LOG_INFO("computeBestFitTriangleForContour") << e.what();
-        return false;
-    }
-
-    if (cv_min_triangle.size() != 3)
-    {
-        return false;
-    }
-
-    cv::Point2f best_fit_origin_01 = (cv_min_triangle[0] + cv_min_triangle[1]) / 2.f;
-    cv::Point2f best_fit_origin_12 = (cv_min_triangle[1] + cv_min_triangle[2]) / 2.f;
-    cv::Point2f best_fit_origin_20 = (cv_min_triangle[2] + cv_min_triangle[0]) / 2.f;
-
-    t_opencv_float_contour cv_midpoint_triangle;
-    cv_midpoint_triangle.push_back(best_fit_origin_01);
-    cv_midpoint_triangle.push_back(best_fit_origin_12);
-    cv_midpoint_triangle.push_back(best_fit_origin_20);
-
-    // Find the corner closest to the center of mass.
-    // This is the bottom of the triangle.
-    int topCornerIndex = -1;
-    {
-        const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_float_contour>(opencv_contour);
-
-        double bestDistance = k_real_max;
-        for (int cornerIndex = 0; cornerIndex < 3; ++cornerIndex)
-        {
-            const double testDistance = cv::norm(cv_midpoint_triangle[cornerIndex] - massCenter);
-
-            if (testDistance < bestDistance)
-            {
-                topCornerIndex = cornerIndex;
-                bestDistance = testDistance;
-            }
-        }
-    }
-
-    // Assign the left and right corner indices
-    int leftCornerIndex = -1;
-    int rightCornerIndex = -1;
-    switch (topCornerIndex)
-    {
-    case 0:
-        leftCornerIndex = 1;
-        rightCornerIndex = 2;
-        break;
-    case 1:
-        leftCornerIndex = 0;
-        rightCornerIndex = 2;
-        break;
-    case 2:
-        leftCornerIndex = 0;
-        rightCornerIndex = 1;
-        break;
-    default:
-        assert(0 && "unreachable");
-    }
-
-    // Make sure the left and right corners are actually 
-    // on the left and right of the triangle
-    out_triangle_top = cv_midpoint_triangle[topCornerIndex];
-    out_triangle_bottom_left = cv_midpoint_triangle[leftCornerIndex];
-    out_triangle_bottom_right = cv_midpoint_triangle[rightCornerIndex];
-
-    const cv::Point2f topToLeft = out_triangle_bottom_left - out_triangle_top;
-    const cv::Point2f topToRight = out_triangle_bottom_right - out_triangle_top;
-
-    // Cross product should be positive if sides are correct
-    // If not, then swap them.
-    if (topToRight.cross(topToLeft) < 0)
-    {
-        std::swap(out_triangle_bottom_left, out_triangle_bottom_right);
-    }
-
-    return true;
-}
-
-static bool computeBestFitQuadForContour(
-    const t_opencv_float_contour &opencv_contour,
-    const cv::Point2f &up_hint, 
-    const cv::Point2f &right_hint,
-    cv::Point2f &top_right,
-    cv::Point2f &top_left,
-    cv::Point2f &bottom_left,
-    cv::Point2f &bottom_right)
+static bool fetchFrameContours(
+    const TrackerFrameResult &frame_result,
+    OpenCVBufferState *opencv_buffer_state,
+    int job_index,
+    cv::Rect2i &out_ROI,
+    t_opencv_int_contour_list &out_contours,
+    std::vector<double> &out_contour_areas)
 {
-    // Compute the tightest possible bounding triangle for the given contour
-    cv::RotatedRect cv_min_box= cv::minAreaRect(opencv_contour);
-
-    if (cv_min_box.size.width <= k_real_epsilon || cv_min_box.size.height <= k_real_epsilon)
-    {
-        return false;
-    }
-
-    float half_width, half_height;
-    float radians;
-    if (cv_min_box.size.width > cv_min_box.size.height)
-    {
-        half_width= cv_min_box.size.width / 2.f;
-        half_height= cv_min_box.size.height / 2.f;
-        radians= cv_min_box.angle*k_degrees_to_radians;
-    }
-    else
-    {
-        half_width= cv_min_box.size.height / 2.f;
-        half_height= cv_min_box.size.width / 2.f;
-        radians= (cv_min_box.angle + 90.f)*k_degrees_to_radians;
-    }
-
-    cv::Point2f quad_half_right, quad_half_up;
-    {
-        const float cos_angle= cosf(radians);
-        const float sin_angle= sinf(radians);
-
-        quad_half_right.x= half_width*cos_angle;
-        quad_half_right.y= half_width*sin_angle;
-
-        quad_half_up.x= -half_height*sin_angle;
-        quad_half_up.y= half_height*cos_angle;
-    }
-
-    if (quad_half_up.dot(up_hint) < 0)
-    {
-        // up axis is flipped
-        // flip the box vertically
-        quad_half_up= -quad_half_up;
-    }
-
-    if (quad_half_right.dot(right_hint) < 0)
-    {
-        // right axis is flipped
-        // flip the box horizontally
-        quad_half_right= -quad_half_right;
-    }
-
-    top_right= cv_min_box.center + quad_half_up + quad_half_right;
-    top_left= cv_min_box.center + quad_half_up - quad_half_right;
-    bottom_right= cv_min_box.center - quad_half_up + quad_half_right;
-    bottom_left= cv_min_box.center - quad_half_up - quad_half_right;
-
-    return true;
-}
-
-template<typename t_opencv_contour_type>
-cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour)
-{
-    cv::Moments mu(cv::moments(contour));
-    cv::Point2f massCenter;
-        
-    // mu.m00 is zero for contours of zero area.
-    // Fallback to standard centroid in this case.
+    const TrackerColorResult *color_result = frame_result.getColorResult(job_index);
+    bool bSuccess = false;
 
-    if (!is_double_nearly_zero(mu.m00))
-    {
-        massCenter= cv::Point2f(static_cast<float>(mu.m10 / mu.m00), static_cast<float>(mu.m01 / mu.m00));
-    }
-    else
+    if (color_result != nullptr)
     {
-        massCenter.x = 0.f;
-        massCenter.y = 0.f;
-
-        for (const cv::Point &int_point : contour)
-        {
-            massCenter.x += static_cast<float>(int_point.x);
-            massCenter.y += static_cast<float>(int_point.y);
-        }
+        out_ROI = color_result->ROI;
+        out_contours = color_result->contours;
+        out_contour_areas = color_result->contour_areas;
+        opencv_buffer_state->draw_roi(out_ROI);
 
-        if (contour.size() > 1)
-        {
-            const float N = static_cast<float>(contour.size());
-
-            massCenter.x /= N;
-            massCenter.y /= N;
-        }
+        bSuccess = out_contours.size() > 0;
     }
 
-    return massCenter;
-}
-
-// http://www.euclideanspace.com/maths/geometry/rotations/conversions/quaternionToAngle/index.htm
-static void commonDeviceOrientationToOpenCVRodrigues(
-    const CommonDeviceQuaternion &orientation,
-    cv::Mat &rvec)
-{
-    double qw= clampf(orientation.w, -1.0, 1.0);
-    double angle = 2.0 * acos(qw);
-    double axis_normalizer = sqrt(1.0 - qw*qw);
-
-    if (axis_normalizer > k_real_epsilon) 
-    {
-        rvec.at<double>(0) = angle * (orientation.x / axis_normalizer);
-        rvec.at<double>(1) = angle * (orientation.y / axis_normalizer);
-        rvec.at<double>(2) = angle * (orientation.z / axis_normalizer);
-    }
-    else
-    {
-        // Angle is either 0 or 360,
-        // which is a rotation no-op so we are free to pick any axis we want
-        rvec.at<double>(0) = angle; 
-        rvec.at<double>(1) = 0.0;
-        rvec.at<double>(2) = 0.0;
-    }
-}
-
-static void openCVRodriguesToAngleAxis(
-    const cv::Mat &rvec,
-    float &axis_x, float &axis_y, float &axis_z, float &radians)
-{
-    const float r_x = static_cast<float>(rvec.at<double>(0));
-    const float r_y = static_cast<float>(rvec.at<double>(1));
-    const float r_z = static_cast<float>(rvec.at<double>(2));
-    
-    radians = sqrtf(r_x*r_x + r_y*r_y + r_z*r_z);
-
-    axis_x= safe_divide_with_default(r_x, radians, 1.f);
-    axis_y= safe_divide_with_default(r_y, radians, 0.f);
-    axis_z= safe_divide_with_default(r_z, radians, 0.f);
-}
-
-// http://www.euclideanspace.com/maths/geometry/rotations/conversions/angleToEuler/index.htm
-// NOTE: This code has the X and Z axis flipped from the code in the link
-// because I consider rotation about the X-axis pitch and the Z-axis roll
-// whereas the original code had the opposite.
-// Also they refer to yaw as "heading", pitch as "attitude", and roll ""
-static void angleAxisVectorToEulerAngles(
-    const float axis_x, const float axis_y, const float axis_z, const float radians,
-    float &yaw, float &pitch, float &roll)
-{
-    float s= sinf(radians);
-    float c= cosf(radians);
-    float t= 1.f-c;
-
-    if ((axis_x*axis_y*t + axis_z*s) > 0.998) 
-    {
-        // north pole singularity detected
-        yaw = 2*atan2f(axis_z*sinf(radians/2), cosf(radians/2));
-        pitch = k_real_half_pi;
-        roll = 0;
-    }
-    else if ((axis_x*axis_y*t + axis_z*s) < -0.998) 
-    { 
-        // south pole singularity detected
-        yaw = -2*atan2(axis_z*sinf(radians/2), cosf(radians/2));
-        pitch = -k_real_half_pi;
-        roll = 0;
-    }
-    else
-    {
-        yaw = atan2f(axis_y*s - axis_x*axis_z*t, 1.f - (axis_y*axis_y + axis_z*axis_z)*t);
-        pitch = asinf(axis_z*axis_y*t + axis_x*s) ;
-        roll = atan2f(axis_z*s - axis_x*axis_y*t , 1.f - (axis_x*axis_x + axis_z*axis_z)*t);
-    }
-}
-
-static void angleAxisVectorToCommonDeviceOrientation(
-    const float axis_x, const float axis_y, const float axis_z, const float radians,
-    CommonDeviceQuaternion &orientation)
-{
-    if (!is_nearly_zero(radians))
-    {
-        const float sin_theta_over_two = sinf(radians * 0.5f);
-        const float w = cosf(radians * 0.5f);
-        const float x = axis_x * sin_theta_over_two;
-        const float y = axis_y * sin_theta_over_two;
-        const float z = axis_z * sin_theta_over_two;
-        const float length = sqrtf(w*w + x*x + y*y + z*z);
-
-        if (length > k_normal_epsilon)
-        {
-            orientation.w = w / length;
-            orientation.x = x / length;
-            orientation.y = y / length;
-            orientation.z = z / length;
-        }
-        else
-        {
-            orientation.clear();
-        }
-    }
-    else
-    {
-        orientation.clear();
-    }
+    return bSuccess;
 }
@@ -144,13 +144,24 @@ protected:
     void publish_device_data_frame() override;
     static void generate_tracker_data_frame_for_stream(
         const ServerTrackerView *tracker_view, const struct TrackerStreamInfo *stream_info,
-        DeviceOutputDataFramePtr &data_frame);
+        PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+
+    // Optional worker thread that captures and segments video frames off the main thread
+    void start_worker_thread();
+    void stop_worker_thread();
+    bool poll_worker_thread();
+
+    // The colors (and where) to look for in the next video frame, one job per tracked device
+    void build_color_jobs(struct TrackerColorJobList &color_jobs);
 
 private:
     char m_shared_memory_name[256];
     class SharedVideoFrameReadWriteAccessor *m_shared_memory_accesor;
     int m_shared_memory_video_stream_count;
     class OpenCVBufferState *m_opencv_buffer_state;
+    class TrackerWorkerThread *m_worker_thread;
+    struct TrackerColorJobList *m_color_jobs; // used when there is no worker thread
+    struct TrackerFrameResult *m_frame_result; // used when there is no worker thread
     ITrackerInterface *m_device;
 };
 
@@ -5,6 +5,9 @@
 #include "KalmanPositionFilter.h"
 #include "KalmanOrientationFilter.h"
 
+#include <algorithm>
+#include <assert.h>
+
 // -- public interface --
 bool CompoundPoseFilter::init(
 	const CommonDeviceState::eDeviceType deviceType,
@@ -62,6 +65,13 @@ void CompoundPoseFilter::allocate_filters(
 {
 	dispose_filters();
 
+	// Position only filters (i.e. virtual controllers) don't have an orientation update rate
+	m_mean_update_time_delta =
+		(constant.orientation_constants.mean_update_time_delta > 0.f)
+		? constant.orientation_constants.mean_update_time_delta
+		: constant.position_constants.mean_update_time_delta;
+	m_state_time_seconds = 0.0;
+
 	switch(orientationFilterType)
 	{
     case OrientationFilterTypeNone:
@@ -164,6 +174,8 @@ void CompoundPoseFilter::resetState()
 		m_orientation_filter->resetState();
 		m_position_filter->resetState();
 	}
+
+	m_state_time_seconds = 0.0;
 }
 
 void CompoundPoseFilter::recenterOrientation(const Eigen::Quaternionf& q_pose)
@@ -214,6 +226,51 @@ Eigen::Vector3f CompoundPoseFilter::getAccelerationCmPerSecSqr() const
 	return (m_position_filter != nullptr) ? m_position_filter->getAccelerationCmPerSecSqr() : Eigen::Vector3f::Zero();
 }
 
+void CompoundPoseFilter::updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet)
+{
+	const float delta_time =
+		compute_pose_filter_time_delta(m_state_time_seconds, sample_time_seconds, m_mean_update_time_delta);
+
+	update(delta_time, packet);
+	m_state_time_seconds = std::max(m_state_time_seconds, sample_time_seconds);
+}
+
+double CompoundPoseFilter::getStateTimeSeconds() const
+{
+	return m_state_time_seconds;
+}
+
+IPoseFilter *CompoundPoseFilter::clone() const
+{
+	CompoundPoseFilter *filter = new CompoundPoseFilter();
+
+	filter->m_orientation_filter = (m_orientation_filter != nullptr) ? m_orientation_filter->clone() : nullptr;
+	filter->m_position_filter = (m_position_filter != nullptr) ? m_position_filter->clone() : nullptr;
+	filter->m_mean_update_time_delta = m_mean_update_time_delta;
+	filter->m_state_time_seconds = m_state_time_seconds;
+
+	return filter;
+}
+
+void CompoundPoseFilter::copyState(const IPoseFilter *other)
+{
+	assert(dynamic_cast<const CompoundPoseFilter *>(other) != nullptr);
+	const CompoundPoseFilter *other_filter = static_cast<const CompoundPoseFilter *>(other);
+
+	if (m_orientation_filter != nullptr && other_filter->m_orientation_filter != nullptr)
+	{
+		m_orientation_filter->copyState(other_filter->m_orientation_filter);
+	}
+
+	if (m_position_filter != nullptr && other_filter->m_position_filter != nullptr)
+	{
+		m_position_filter->copyState(other_filter->m_position_filter);
+	}
+
+	m_mean_update_time_delta = other_filter->m_mean_update_time_delta;
+	m_state_time_seconds = other_filter->m_state_time_seconds;
+}
+
 void CompoundPoseFilter::dispose_filters()
 {
 	if (m_orientation_filter != nullptr)
@@ -33,6 +33,8 @@ public:
     CompoundPoseFilter() 
         : m_position_filter(nullptr)
         , m_orientation_filter(nullptr)
+        , m_mean_update_time_delta(0.f)
+        , m_state_time_seconds(0.0)
     {}
     virtual ~CompoundPoseFilter()
     { dispose_filters(); }
@@ -65,6 +67,10 @@ public:
     Eigen::Vector3f getPositionCm(float time = 0.f) const override;
     Eigen::Vector3f getVelocityCmPerSec() const override;
     Eigen::Vector3f getAccelerationCmPerSecSqr() const override;
+    void updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet) override;
+    double getStateTimeSeconds() const override;
+    IPoseFilter *clone() const override;
+    void copyState(const IPoseFilter *other) override;
 
 protected:
 	void allocate_filters(
@@ -76,6 +82,8 @@ protected:
 
     IPositionFilter *m_position_filter;
     IOrientationFilter *m_orientation_filter;
+    float m_mean_update_time_delta;
+    double m_state_time_seconds;
 };
 
 #endif // COMPOUND_POSE_FILTER_H
\ No newline at end of file
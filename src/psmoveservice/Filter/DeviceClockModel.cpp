@@ -0,0 +1,235 @@
+//-- includes -----
+#include "DeviceClockModel.h"
+#include <algorithm>
+#include <math.h>
+
+//-- constants -----
+// How long to measure the device clock tick against the arrival times before trusting it
+static const double k_calibration_seconds = 2.0;
+
+// Wrap arounds can't be counted before the tick duration is known, so calibration starts over after a longer gap
+static const double k_max_calibration_gap_seconds = 0.1;
+
+// Longer gaps between samples mean the device stopped streaming, so the samples after it start over
+static const double k_max_sample_gap_seconds = 1.0;
+
+// A timestamp that wraps around faster than this can't be unwrapped reliably between input reports
+static const double k_min_timestamp_range_seconds = 0.05;
+
+// How much device time each drift window covers
+static const double k_drift_window_seconds = 2.0;
+
+// How much of the tick duration measured over a drift window gets blended into the estimate
+static const double k_tick_estimate_gain = 0.25;
+
+// How far the tick duration may drift from the one first measured
+static const double k_max_tick_rate_error = 0.02;
+
+// Sample times get slewed toward the arrival times by at most this fraction of each interval
+static const double k_max_slew_rate = 0.005;
+
+// Sample times further than this from the arrival times get stepped instead of slewed
+static const double k_max_time_error_seconds = 0.05;
+
+//-- public interface -----
+DeviceClockModel::DeviceClockModel()
+    : m_timestamp_mask(0xFFFF)
+    , m_timestamp_range(65536.0)
+    , m_tick_seconds(0.0)
+    , m_reference_tick_seconds(0.0)
+    , m_bIsUsable(true)
+{
+    reset();
+}
+
+void DeviceClockModel::init(const int timestamp_bits)
+{
+    const int bits = std::max(std::min(timestamp_bits, 32), 1);
+
+    m_timestamp_mask = (bits >= 32) ? 0xFFFFFFFF : ((1u << bits) - 1u);
+    m_timestamp_range = static_cast<double>(m_timestamp_mask) + 1.0;
+    m_tick_seconds = 0.0;
+    m_reference_tick_seconds = 0.0;
+    m_bIsUsable = true;
+
+    reset();
+}
+
+void DeviceClockModel::reset()
+{
+    m_sample_count = 0;
+    m_last_raw_timestamp = 0;
+    m_last_arrival_time_seconds = 0.0;
+    m_ticks_since_restart = 0;
+    m_restart_arrival_time_seconds = 0.0;
+    m_sample_time_seconds = 0.0;
+    m_sample_time_delta_seconds = 0.0;
+    m_bHasSampleTimeDelta = false;
+    m_pending_correction_seconds = 0.0;
+
+    m_window_start_ticks = 0;
+    m_window_anchor_ticks = 0;
+    m_window_anchor_arrival_seconds = 0.0;
+    m_bHasWindowAnchor = false;
+    m_last_anchor_ticks = 0;
+    m_last_anchor_arrival_seconds = 0.0;
+    m_bHasLastAnchor = false;
+}
+
+void DeviceClockModel::addSample(const unsigned int raw_timestamp, const double arrival_time_seconds)
+{
+    if (!m_bIsUsable)
+    {
+        return;
+    }
+
+    const double arrival_delta_seconds = arrival_time_seconds - m_last_arrival_time_seconds;
+
+    if (m_sample_count == 0 ||
+        arrival_delta_seconds < 0.0 ||
+        arrival_delta_seconds > k_max_sample_gap_seconds ||
+        (m_tick_seconds <= 0.0 && arrival_delta_seconds > k_max_calibration_gap_seconds))
+    {
+        restart(raw_timestamp, arrival_time_seconds);
+        return;
+    }
+
+    int64_t tick_delta = static_cast<int64_t>((raw_timestamp - m_last_raw_timestamp) & m_timestamp_mask);
+
+    if (m_tick_seconds > 0.0)
+    {
+        // Count the wrap arounds hidden by a gap in the samples using the time between their arrivals
+        const double missing_ticks = arrival_delta_seconds / m_tick_seconds - static_cast<double>(tick_delta);
+        const int64_t wrap_count = static_cast<int64_t>(floor(missing_ticks / m_timestamp_range + 0.5));
+
+        if (wrap_count > 0)
+        {
+            tick_delta += wrap_count * static_cast<int64_t>(m_timestamp_range);
+        }
+    }
+
+    m_last_raw_timestamp = raw_timestamp;
+    m_last_arrival_time_seconds = arrival_time_seconds;
+    m_ticks_since_restart += tick_delta;
+    ++m_sample_count;
+
+    if (m_tick_seconds > 0.0)
+    {
+        advance(tick_delta, arrival_time_seconds);
+    }
+    else
+    {
+        calibrate(arrival_time_seconds);
+    }
+}
+
+//-- private methods -----
+void DeviceClockModel::restart(const unsigned int raw_timestamp, const double arrival_time_seconds)
+{
+    reset();
+
+    m_sample_count = 1;
+    m_last_raw_timestamp = raw_timestamp;
+    m_last_arrival_time_seconds = arrival_time_seconds;
+    m_restart_arrival_time_seconds = arrival_time_seconds;
+    m_sample_time_seconds = arrival_time_seconds;
+
+    m_window_anchor_arrival_seconds = arrival_time_seconds;
+    m_bHasWindowAnchor = true;
+}
+
+void DeviceClockModel::calibrate(const double arrival_time_seconds)
+{
+    const double calibration_seconds = arrival_time_seconds - m_restart_arrival_time_seconds;
+
+    // Until the tick is known the samples are just as good as their arrival times
+    m_sample_time_delta_seconds = arrival_time_seconds - m_sample_time_seconds;
+    m_sample_time_seconds = arrival_time_seconds;
+
+    if (calibration_seconds >= k_calibration_seconds && m_ticks_since_restart > 0)
+    {
+        const double tick_seconds = calibration_seconds / static_cast<double>(m_ticks_since_restart);
+
+        if (tick_seconds * m_timestamp_range < k_min_timestamp_range_seconds)
+        {
+            // Stick with the arrival times
+            m_bIsUsable = false;
+            return;
+        }
+
+        m_tick_seconds = tick_seconds;
+        m_reference_tick_seconds = tick_seconds;
+
+        // Follow the device clock from this sample on
+        m_window_start_ticks = m_ticks_since_restart;
+        m_window_anchor_ticks = m_ticks_since_restart;
+        m_window_anchor_arrival_seconds = arrival_time_seconds;
+        m_bHasWindowAnchor = true;
+    }
+}
+
+void DeviceClockModel::advance(const int64_t tick_delta, const double arrival_time_seconds)
+{
+    const double device_delta_seconds = static_cast<double>(tick_delta) * m_tick_seconds;
+    const double max_slew_seconds = device_delta_seconds * k_max_slew_rate;
+    const double slew_seconds =
+        std::max(std::min(m_pending_correction_seconds, max_slew_seconds), -max_slew_seconds);
+
+    m_pending_correction_seconds -= slew_seconds;
+    m_sample_time_delta_seconds = device_delta_seconds + slew_seconds;
+    m_sample_time_seconds += m_sample_time_delta_seconds;
+    m_bHasSampleTimeDelta = true;
+
+    // The least delayed arrival in the window is the best look at when the device took its samples
+    if (!m_bHasWindowAnchor ||
+        arrival_time_seconds - static_cast<double>(m_ticks_since_restart) * m_tick_seconds <
+        m_window_anchor_arrival_seconds - static_cast<double>(m_window_anchor_ticks) * m_tick_seconds)
+    {
+        m_window_anchor_ticks = m_ticks_since_restart;
+        m_window_anchor_arrival_seconds = arrival_time_seconds;
+        m_bHasWindowAnchor = true;
+    }
+
+    if (static_cast<double>(m_ticks_since_restart - m_window_start_ticks) * m_tick_seconds < k_drift_window_seconds)
+    {
+        return;
+    }
+
+    // The host time between the least delayed arrivals of consecutive windows measures the tick,
+    // which follows the drift between the device and host clocks
+    if (m_bHasLastAnchor && m_window_anchor_ticks > m_last_anchor_ticks)
+    {
+        const double measured_tick_seconds =
+            (m_window_anchor_arrival_seconds - m_last_anchor_arrival_seconds) /
+            static_cast<double>(m_window_anchor_ticks - m_last_anchor_ticks);
+
+        m_tick_seconds += k_tick_estimate_gain * (measured_tick_seconds - m_tick_seconds);
+        m_tick_seconds =
+            std::max(
+                std::min(m_tick_seconds, m_reference_tick_seconds * (1.0 + k_max_tick_rate_error)),
+                m_reference_tick_seconds * (1.0 - k_max_tick_rate_error));
+    }
+
+    // Slew the sample times toward the least delayed arrival
+    const double anchored_sample_time_seconds =
+        m_window_anchor_arrival_seconds +
+        static_cast<double>(m_ticks_since_restart - m_window_anchor_ticks) * m_tick_seconds;
+    const double time_error_seconds = anchored_sample_time_seconds - m_sample_time_seconds;
+
+    if (fabs(time_error_seconds) > k_max_time_error_seconds)
+    {
+        m_sample_time_seconds = anchored_sample_time_seconds;
+        m_pending_correction_seconds = 0.0;
+    }
+    else
+    {
+        m_pending_correction_seconds = time_error_seconds;
+    }
+
+    m_last_anchor_ticks = m_window_anchor_ticks;
+    m_last_anchor_arrival_seconds = m_window_anchor_arrival_seconds;
+    m_bHasLastAnchor = true;
+
+    m_window_start_ticks = m_ticks_since_restart;
+    m_bHasWindowAnchor = false;
+}
@@ -0,0 +1,83 @@
+#ifndef DEVICE_CLOCK_MODEL_H
+#define DEVICE_CLOCK_MODEL_H
+
+//-- includes -----
+#include <stdint.h>
+
+//-- definitions -----
+/// Maps the wrapping timestamp a device stamps on its IMU samples onto the host monotonic clock,
+/// so that the filters can integrate with the device's own sample intervals instead of the
+/// jittery host arrival times of the input reports.
+///
+/// The duration of a device clock tick is measured against the arrival times of the first few
+/// seconds of samples and then refined by comparing the least delayed arrival of consecutive
+/// windows of samples, which tracks the drift between the device and host clocks.
+/// Sample times follow the device clock and get slewed (never stepped) toward the least delayed
+/// arrival, so the intervals between them stay within a fraction of a percent of the device intervals.
+class DeviceClockModel
+{
+public:
+    DeviceClockModel();
+
+    /// Sets the number of bits in the device timestamp before it wraps around and forgets everything
+    void init(const int timestamp_bits);
+
+    /// Forget all samples, i.e. after the device reconnected. The measured tick duration is kept.
+    void reset();
+
+    /// Add the device timestamp of the next sample along with the time (seconds on the host monotonic clock)
+    /// it arrived at. Gaps in the samples longer than the timestamp wrap around are unwrapped using the arrival time.
+    void addSample(const unsigned int raw_timestamp, const double arrival_time_seconds);
+
+    /// True once the tick duration is known and the last sample has an interval on the device clock
+    inline bool getIsValid() const
+    { return m_tick_seconds > 0.0 && m_bHasSampleTimeDelta; }
+
+    /// When the last sample was taken, in seconds on the host monotonic clock
+    inline double getSampleTimeSeconds() const
+    { return m_sample_time_seconds; }
+
+    /// Time between the last two samples as measured by the device clock
+    inline double getSampleTimeDeltaSeconds() const
+    { return m_sample_time_delta_seconds; }
+
+    /// Measured duration of one device clock tick in seconds (0 until measured)
+    inline double getTickSeconds() const
+    { return m_tick_seconds; }
+
+private:
+    void restart(const unsigned int raw_timestamp, const double arrival_time_seconds);
+    void calibrate(const double arrival_time_seconds);
+    void advance(const int64_t tick_delta, const double arrival_time_seconds);
+
+    // Timestamp wrap around
+    uint32_t m_timestamp_mask;
+    double m_timestamp_range;
+
+    // Measured clock tick
+    double m_tick_seconds;
+    double m_reference_tick_seconds;
+    bool m_bIsUsable;
+
+    // Last sample
+    int m_sample_count;
+    unsigned int m_last_raw_timestamp;
+    double m_last_arrival_time_seconds;
+    int64_t m_ticks_since_restart;
+    double m_restart_arrival_time_seconds;
+    double m_sample_time_seconds;
+    double m_sample_time_delta_seconds;
+    bool m_bHasSampleTimeDelta;
+    double m_pending_correction_seconds;
+
+    // Least delayed sample of the current and previous drift window
+    int64_t m_window_start_ticks;
+    int64_t m_window_anchor_ticks;
+    double m_window_anchor_arrival_seconds;
+    bool m_bHasWindowAnchor;
+    int64_t m_last_anchor_ticks;
+    double m_last_anchor_arrival_seconds;
+    bool m_bHasLastAnchor;
+};
+
+#endif // DEVICE_CLOCK_MODEL_H
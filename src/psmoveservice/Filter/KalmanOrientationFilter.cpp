@@ -2,6 +2,8 @@
 #include "KalmanOrientationFilter.h"
 #include "MathAlignment.h"
 
+#include <assert.h>
+
 #include <kalman/MeasurementModel.hpp>
 #include <kalman/SystemModel.hpp>
 #include <kalman/SquareRootBase.hpp>
@@ -510,6 +512,21 @@ public:
     {
     }
 
+	virtual ~KalmanOrientationFilterImpl()
+	{
+	}
+
+	virtual KalmanOrientationFilterImpl *clone() const
+	{
+		return new KalmanOrientationFilterImpl(*this);
+	}
+
+	/// Copy the state of an impl of the same type
+	virtual void copy_state(const KalmanOrientationFilterImpl *other)
+	{
+		*this = *other;
+	}
+
     virtual void init(const OrientationFilterConstants &constants)
     {
 		bIsValid = false;
@@ -561,6 +578,16 @@ class DS4KalmanOrientationFilterImpl : public KalmanOrientationFilterImpl
 public:
 	DS4_OrientationMeasurementModel measurement_model;
 
+	KalmanOrientationFilterImpl *clone() const override
+	{
+		return new DS4KalmanOrientationFilterImpl(*this);
+	}
+
+	void copy_state(const KalmanOrientationFilterImpl *other) override
+	{
+		*this = *static_cast<const DS4KalmanOrientationFilterImpl *>(other);
+	}
+
 	void init(const OrientationFilterConstants &constants) override
 	{
 		KalmanOrientationFilterImpl::init(constants);
@@ -581,6 +608,16 @@ class PSMoveKalmanPoseFilterImpl : public KalmanOrientationFilterImpl
 public:
 	PSMove_OrientationMeasurementModel measurement_model;
 
+	KalmanOrientationFilterImpl *clone() const override
+	{
+		return new PSMoveKalmanPoseFilterImpl(*this);
+	}
+
+	void copy_state(const KalmanOrientationFilterImpl *other) override
+	{
+		*this = *static_cast<const PSMoveKalmanPoseFilterImpl *>(other);
+	}
+
 	void init(const OrientationFilterConstants &constants) override
 	{
 		KalmanOrientationFilterImpl::init(constants);
@@ -604,12 +641,18 @@ KalmanOrientationFilter::KalmanOrientationFilter()
     memset(&m_constants, 0, sizeof(OrientationFilterConstants));
 }
 
+KalmanOrientationFilter::KalmanOrientationFilter(const KalmanOrientationFilter &other)
+	: m_constants(other.m_constants)
+	, m_filter(other.m_filter != nullptr ? other.m_filter->clone() : nullptr)
+{
+}
+
 KalmanOrientationFilter::~KalmanOrientationFilter()
 {
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 }
 
@@ -621,7 +664,7 @@ bool KalmanOrientationFilter::init(const OrientationFilterConstants &constants)
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 
 	// Create and initialize the private filter implementation
@@ -642,7 +685,7 @@ bool KalmanOrientationFilter::init(
 	if (m_filter != nullptr)
 	{
 		delete m_filter;
-		m_filter;
+		m_filter = nullptr;
 	}
 
 	// Create and initialize the private filter implementation
@@ -653,6 +696,29 @@ bool KalmanOrientationFilter::init(
 	return true;
 }
 
+KalmanOrientationFilter &KalmanOrientationFilter::operator=(const KalmanOrientationFilter &other)
+{
+	m_constants = other.m_constants;
+
+	if (m_filter != nullptr && other.m_filter != nullptr)
+	{
+		m_filter->copy_state(other.m_filter);
+	}
+	else
+	{
+		delete m_filter;
+		m_filter = (other.m_filter != nullptr) ? other.m_filter->clone() : nullptr;
+	}
+
+	return *this;
+}
+
+void KalmanOrientationFilter::copyState(const IOrientationFilter *other)
+{
+	assert(dynamic_cast<const KalmanOrientationFilter *>(other) != nullptr);
+	*this = *static_cast<const KalmanOrientationFilter *>(other);
+}
+
 bool KalmanOrientationFilter::getIsStateValid() const
 {
 	return m_filter->bIsValid;
@@ -707,12 +773,18 @@ Eigen::Vector3f KalmanOrientationFilter::getAngularAccelerationRadPerSecSqr() co
 }
 
 //-- KalmanOrientationFilterDS4 --
+IOrientationFilter *KalmanOrientationFilterDS4::clone() const
+{
+	return new KalmanOrientationFilterDS4(*this);
+}
+
 bool KalmanOrientationFilterDS4::init(const OrientationFilterConstants &constants)
 {
 	KalmanOrientationFilter::init(constants);
 
 	DS4KalmanOrientationFilterImpl *filter = new DS4KalmanOrientationFilterImpl();
 	filter->init(constants);
+	delete m_filter;
 	m_filter = filter;
 
 	return true;
@@ -726,6 +798,7 @@ bool KalmanOrientationFilterDS4::init(
 
 	DS4KalmanOrientationFilterImpl *filter = new DS4KalmanOrientationFilterImpl();
 	filter->init(constants, orientation);
+	delete m_filter;
 	m_filter = filter;
 
 	return true;
@@ -808,12 +881,18 @@ void KalmanOrientationFilterDS4::update(const float delta_time, const PoseFilter
 }
 
 //-- KalmanOrientationFilterPSMove --
+IOrientationFilter *KalmanOrientationFilterPSMove::clone() const
+{
+	return new KalmanOrientationFilterPSMove(*this);
+}
+
 bool KalmanOrientationFilterPSMove::init(const OrientationFilterConstants &constants)
 {
 	KalmanOrientationFilter::init(constants);
 
 	PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
 	filter->init(constants);
+	delete m_filter;
 	m_filter = filter;
 
 	return true;
@@ -827,6 +906,7 @@ bool KalmanOrientationFilterPSMove::init(
 
 	PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
 	filter->init(constants, orientation);
+	delete m_filter;
 	m_filter = filter;
 
 	return true;
@@ -8,8 +8,11 @@ class KalmanOrientationFilter : public IOrientationFilter
 {
 public:
 	KalmanOrientationFilter();
+	KalmanOrientationFilter(const KalmanOrientationFilter &other);
 	virtual ~KalmanOrientationFilter();
 
+	KalmanOrientationFilter &operator=(const KalmanOrientationFilter &other);
+
 	bool init(const OrientationFilterConstants &constant) override;
 	bool init(const OrientationFilterConstants &constant, const Eigen::Quaternionf &initial_orientation) override;
 
@@ -22,6 +25,7 @@ public:
 	Eigen::Quaternionf getOrientation(float time = 0.f) const override;
 	Eigen::Vector3f getAngularVelocityRadPerSec() const override;
 	Eigen::Vector3f getAngularAccelerationRadPerSecSqr() const override;
+	void copyState(const IOrientationFilter *other) override;
 
 protected:
 	OrientationFilterConstants m_constants;
@@ -35,6 +39,7 @@ public:
 	bool init(const OrientationFilterConstants &constant) override;
 	bool init(const OrientationFilterConstants &constant, const Eigen::Quaternionf &orientation) override;
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
+	IOrientationFilter *clone() const override;
 };
 
 /// Kalman Orientation filter for Magnetometer + Angular Rate(Gyroscope) + Gravity(Accelerometer)
@@ -44,6 +49,7 @@ public:
 	bool init(const OrientationFilterConstants &constant) override;
 	bool init(const OrientationFilterConstants &constant, const Eigen::Quaternionf &orientation) override;
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
+	IOrientationFilter *clone() const override;
 };
 
 #endif // KALMAN_ORIENTATION_FILTER_H
\ No newline at end of file
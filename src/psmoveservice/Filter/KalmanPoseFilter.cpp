@@ -1,6 +1,10 @@
 //-- includes --
 #include "KalmanPoseFilter.h"
 #include "MathAlignment.h"
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <assert.h>
 #include <iostream>
 
 // The kalman filter runs way to slow in a fully unoptimized build.
@@ -104,91 +108,111 @@ enum DS4MeasurementEnum {
 #define k_ukf_kappa 3 - STATE_PARAMETER_COUNT
 
 //-- private methods ---
+template <typename T>
 void process_3rd_order_noise(
-	const double dT, const double var, const int state_index, 
-	Eigen::Matrix<double, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q);
+	const T dT, const T var, const int state_index,
+	Eigen::Matrix<T, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q);
 
+template <typename T>
 void process_2nd_order_noise(
-	const double dT, const double var, const int state_index, 
-	Eigen::Matrix<double, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q);
+	const T dT, const T var, const int state_index,
+	Eigen::Matrix<T, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q);
+
+template <typename T>
+T normalize_vector3_with_zero_default(Eigen::Matrix<T, 3, 1> &v);
+
+template <typename T>
+Eigen::Quaternion<T> angle_axis_vector_to_quaternion(const Eigen::Matrix<T, 3, 1> &angle_axis);
+
+template <typename T, int PointCount>
+void compute_weighted_quaternion_average(
+	const Eigen::Quaternion<T> *quaternions,
+	const T *weights,
+	Eigen::Quaternion<T> *out_result);
 
 //-- private definitions --
-class PoseNoiseVector : public Eigen::Matrix<double, NOISE_PARAMETER_COUNT, 1>
+template <typename T>
+class PoseNoiseVector : public Eigen::Matrix<T, NOISE_PARAMETER_COUNT, 1>
 {
 public:
-	PoseNoiseVector(void) : Eigen::Matrix<double, NOISE_PARAMETER_COUNT, 1>()
+	typedef Eigen::Matrix<T, NOISE_PARAMETER_COUNT, 1> MatrixType;
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+	typedef Eigen::AngleAxis<T> AngleAxis;
+
+	PoseNoiseVector(void) : MatrixType()
 	{ }
 
 	template<typename OtherDerived>
-	PoseNoiseVector(const Eigen::MatrixBase<OtherDerived>& other) : Eigen::Matrix<double, NOISE_PARAMETER_COUNT, 1>(other)
+	PoseNoiseVector(const Eigen::MatrixBase<OtherDerived>& other) : MatrixType(other)
 	{ }
 
 	template<typename OtherDerived>
 	PoseNoiseVector& operator= (const Eigen::MatrixBase<OtherDerived>& other)
 	{
-		this->Base::operator=(other);
+		this->MatrixType::operator=(other);
 		return *this;
 	}
 
 	// Accessors
-	Eigen::Vector3d get_position_noise() const {
-		return Eigen::Vector3d((*this)[NOISE_POSITION_X], (*this)[NOISE_POSITION_Y], (*this)[NOISE_POSITION_Z]);
+	Vector3 get_position_noise() const {
+		return Vector3((*this)[NOISE_POSITION_X], (*this)[NOISE_POSITION_Y], (*this)[NOISE_POSITION_Z]);
 	}
-	Eigen::Vector3d get_linear_velocity_noise() const {
-		return Eigen::Vector3d((*this)[NOISE_LINEAR_VELOCITY_X], (*this)[NOISE_LINEAR_VELOCITY_Y], (*this)[NOISE_LINEAR_VELOCITY_Z]);
+	Vector3 get_linear_velocity_noise() const {
+		return Vector3((*this)[NOISE_LINEAR_VELOCITY_X], (*this)[NOISE_LINEAR_VELOCITY_Y], (*this)[NOISE_LINEAR_VELOCITY_Z]);
 	}
-	Eigen::Vector3d get_linear_acceleration_noise() const {
-		return Eigen::Vector3d((*this)[NOISE_LINEAR_ACCELERATION_X], (*this)[NOISE_LINEAR_ACCELERATION_Y], (*this)[NOISE_LINEAR_ACCELERATION_Z]);
+	Vector3 get_linear_acceleration_noise() const {
+		return Vector3((*this)[NOISE_LINEAR_ACCELERATION_X], (*this)[NOISE_LINEAR_ACCELERATION_Y], (*this)[NOISE_LINEAR_ACCELERATION_Z]);
 	}
 	template <int RowsAtCompileTime>
-	static Eigen::AngleAxisd extract_angle_axis_noise(const Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
-		Eigen::Vector3d axis = Eigen::Vector3d(M[NOISE_ANGLE_AXIS_X], M[NOISE_ANGLE_AXIS_Y], M[NOISE_ANGLE_AXIS_Z]);
-		const double angle = eigen_vector3d_normalize_with_default(axis, Eigen::Vector3d::Zero());
-		return Eigen::AngleAxisd(angle, axis);
+	static AngleAxis extract_angle_axis_noise(const Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
+		Vector3 axis = Vector3(M[NOISE_ANGLE_AXIS_X], M[NOISE_ANGLE_AXIS_Y], M[NOISE_ANGLE_AXIS_Z]);
+		const T angle = normalize_vector3_with_zero_default<T>(axis);
+		return AngleAxis(angle, axis);
 	}
-	Eigen::AngleAxisd get_angle_axis_noise() const {
+	AngleAxis get_angle_axis_noise() const {
 		return extract_angle_axis_noise<NOISE_PARAMETER_COUNT>(*this);
 	}
 	template <int RowsAtCompileTime>
-	static Eigen::Quaterniond extract_quaternion_noise(const Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
-		return Eigen::Quaterniond(extract_angle_axis_noise<RowsAtCompileTime>(M));
+	static Quaternion extract_quaternion_noise(const Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
+		return Quaternion(extract_angle_axis_noise<RowsAtCompileTime>(M));
 	}
-	Eigen::Quaterniond get_quaternion_noise() const {
+	Quaternion get_quaternion_noise() const {
 		return extract_quaternion_noise<NOISE_PARAMETER_COUNT>(*this);
 	}
-	Eigen::Vector3d get_angular_velocity_noise() const {
-		return Eigen::Vector3d((*this)[NOISE_ANGULAR_VELOCITY_X], (*this)[NOISE_ANGULAR_VELOCITY_Y], (*this)[NOISE_ANGULAR_VELOCITY_Z]);
+	Vector3 get_angular_velocity_noise() const {
+		return Vector3((*this)[NOISE_ANGULAR_VELOCITY_X], (*this)[NOISE_ANGULAR_VELOCITY_Y], (*this)[NOISE_ANGULAR_VELOCITY_Z]);
 	}
 
 	// Mutators
-	void set_position_noise(const Eigen::Vector3d &p) {
+	void set_position_noise(const Vector3 &p) {
 		(*this)[NOISE_POSITION_X] = p.x(); (*this)[NOISE_POSITION_Y] = p.y(); (*this)[NOISE_POSITION_Z] = p.z();
 	}
-	void set_linear_velocity_noise(const Eigen::Vector3d &v) {
+	void set_linear_velocity_noise(const Vector3 &v) {
 		(*this)[NOISE_LINEAR_VELOCITY_X] = v.x(); (*this)[NOISE_LINEAR_VELOCITY_Y] = v.y(); (*this)[NOISE_LINEAR_VELOCITY_Z] = v.z();
 	}
-	void set_linear_acceleration_noise(const Eigen::Vector3d &a) {
+	void set_linear_acceleration_noise(const Vector3 &a) {
 		(*this)[NOISE_LINEAR_ACCELERATION_X] = a.x(); (*this)[NOISE_LINEAR_ACCELERATION_Y] = a.y(); (*this)[NOISE_LINEAR_ACCELERATION_Z] = a.z();
 	}
 	template <int RowsAtCompileTime>
-	static void apply_angle_axis_noise(const Eigen::AngleAxisd &a, Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
-		const double angle = a.angle();
+	static void apply_angle_axis_noise(const AngleAxis &a, Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
+		const T angle = a.angle();
 		M[NOISE_ANGLE_AXIS_X] = a.axis().x() * angle;
 		M[NOISE_ANGLE_AXIS_Y] = a.axis().y() * angle;
 		M[NOISE_ANGLE_AXIS_Z] = a.axis().z() * angle;
 	}
-	void set_angle_axis_noise(const Eigen::AngleAxisd &a) {
+	void set_angle_axis_noise(const AngleAxis &a) {
 		apply_angle_axis_noise<NOISE_PARAMETER_COUNT>(a, *this);
 	}
 	template <int RowsAtCompileTime>
-	static void apply_quaternion_noise(const Eigen::Quaterniond &q, Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
-		const Eigen::AngleAxisd angle_axis(q);
+	static void apply_quaternion_noise(const Quaternion &q, Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
+		const AngleAxis angle_axis(q);
 		apply_angle_axis_noise<RowsAtCompileTime>(angle_axis, M);
 	}
-	void set_quaternion_noise(const Eigen::Quaterniond &q) {
+	void set_quaternion_noise(const Quaternion &q) {
 		apply_quaternion_noise<NOISE_PARAMETER_COUNT>(q, *this);
 	}
-	void set_angular_velocity_noise(const Eigen::Vector3d &v) {
+	void set_angular_velocity_noise(const Vector3 &v) {
 		(*this)[NOISE_ANGULAR_VELOCITY_X] = v.x(); (*this)[NOISE_ANGULAR_VELOCITY_Y] = v.y(); (*this)[NOISE_ANGULAR_VELOCITY_Z] = v.z();
 	}
 
@@ -202,62 +226,67 @@ public:
 	}
 };
 
-class PoseStateVector : public Eigen::Matrix<double, STATE_PARAMETER_COUNT, 1>
+template <typename T>
+class PoseStateVector : public Eigen::Matrix<T, STATE_PARAMETER_COUNT, 1>
 {
 public:
-	PoseStateVector(void) : Eigen::Matrix<double, STATE_PARAMETER_COUNT, 1>()
+	typedef Eigen::Matrix<T, STATE_PARAMETER_COUNT, 1> MatrixType;
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+
+	PoseStateVector(void) : MatrixType()
 	{ }
 
 	template<typename OtherDerived>
-	PoseStateVector(const Eigen::MatrixBase<OtherDerived>& other) : Eigen::Matrix<double, STATE_PARAMETER_COUNT, 1>(other)
+	PoseStateVector(const Eigen::MatrixBase<OtherDerived>& other) : MatrixType(other)
 	{ }
 
 	template<typename OtherDerived>
 	PoseStateVector& operator= (const Eigen::MatrixBase<OtherDerived>& other)
 	{
-		this->Base::operator=(other);
+		this->MatrixType::operator=(other);
 		return *this;
 	}
 
     // Accessors
-    Eigen::Vector3d get_position_meters() const { 
-        return Eigen::Vector3d((*this)[POSITION_X], (*this)[POSITION_Y], (*this)[POSITION_Z]); 
+    Vector3 get_position_meters() const {
+        return Vector3((*this)[POSITION_X], (*this)[POSITION_Y], (*this)[POSITION_Z]);
     }
-    Eigen::Vector3d get_linear_velocity_m_per_sec() const {
-        return Eigen::Vector3d((*this)[LINEAR_VELOCITY_X], (*this)[LINEAR_VELOCITY_Y], (*this)[LINEAR_VELOCITY_Z]);
+    Vector3 get_linear_velocity_m_per_sec() const {
+        return Vector3((*this)[LINEAR_VELOCITY_X], (*this)[LINEAR_VELOCITY_Y], (*this)[LINEAR_VELOCITY_Z]);
     }
-    Eigen::Vector3d get_linear_acceleration_m_per_sec_sqr() const {
-        return Eigen::Vector3d((*this)[LINEAR_ACCELERATION_X], (*this)[LINEAR_ACCELERATION_Y], (*this)[LINEAR_ACCELERATION_Z]);
+    Vector3 get_linear_acceleration_m_per_sec_sqr() const {
+        return Vector3((*this)[LINEAR_ACCELERATION_X], (*this)[LINEAR_ACCELERATION_Y], (*this)[LINEAR_ACCELERATION_Z]);
     }
 	template <int RowsAtCompileTime>
-	static Eigen::Quaterniond extract_quaternion(const Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
-		return Eigen::Quaterniond(M[ORIENTATION_W], M[ORIENTATION_X], M[ORIENTATION_Y], M[ORIENTATION_Z]);
+	static Quaternion extract_quaternion(const Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
+		return Quaternion(M[ORIENTATION_W], M[ORIENTATION_X], M[ORIENTATION_Y], M[ORIENTATION_Z]);
 	}
-    Eigen::Quaterniond get_quaternion() const {
+    Quaternion get_quaternion() const {
         return extract_quaternion<STATE_PARAMETER_COUNT>(*this);
     }
-    Eigen::Vector3d get_angular_velocity_rad_per_sec() const {
-        return Eigen::Vector3d((*this)[ANGULAR_VELOCITY_X], (*this)[ANGULAR_VELOCITY_Y], (*this)[ANGULAR_VELOCITY_Z]);
+    Vector3 get_angular_velocity_rad_per_sec() const {
+        return Vector3((*this)[ANGULAR_VELOCITY_X], (*this)[ANGULAR_VELOCITY_Y], (*this)[ANGULAR_VELOCITY_Z]);
     }
 
     // Mutators
-    void set_position_meters(const Eigen::Vector3d &p) {
+    void set_position_meters(const Vector3 &p) {
         (*this)[POSITION_X] = p.x(); (*this)[POSITION_Y] = p.y(); (*this)[POSITION_Z] = p.z();
     }
-    void set_linear_velocity_m_per_sec(const Eigen::Vector3d &v) {
+    void set_linear_velocity_m_per_sec(const Vector3 &v) {
         (*this)[LINEAR_VELOCITY_X] = v.x(); (*this)[LINEAR_VELOCITY_Y] = v.y(); (*this)[LINEAR_VELOCITY_Z] = v.z();
     }
-    void set_linear_acceleration_m_per_sec_sqr(const Eigen::Vector3d &a) {
+    void set_linear_acceleration_m_per_sec_sqr(const Vector3 &a) {
         (*this)[LINEAR_ACCELERATION_X] = a.x(); (*this)[LINEAR_ACCELERATION_Y] = a.y(); (*this)[LINEAR_ACCELERATION_Z] = a.z();
     }
 	template <int RowsAtCompileTime>
-	static void apply_quaternion(const Eigen::Quaterniond &q, Eigen::Matrix<double, RowsAtCompileTime, 1> &M) {
+	static void apply_quaternion(const Quaternion &q, Eigen::Matrix<T, RowsAtCompileTime, 1> &M) {
 		M[ORIENTATION_W] = q.w(); M[ORIENTATION_X] = q.x(); M[ORIENTATION_Y] = q.y(); M[ORIENTATION_Z] = q.z();
 	}
-    void set_quaternion(const Eigen::Quaterniond &q) {
+    void set_quaternion(const Quaternion &q) {
 		apply_quaternion<STATE_PARAMETER_COUNT>(q, *this);
     }
-    void set_angular_velocity_rad_per_sec(const Eigen::Vector3d &v) {
+    void set_angular_velocity_rad_per_sec(const Vector3 &v) {
         (*this)[ANGULAR_VELOCITY_X] = v.x(); (*this)[ANGULAR_VELOCITY_Y] = v.y(); (*this)[ANGULAR_VELOCITY_Z] = v.z();
     }
 
@@ -267,40 +296,40 @@ public:
 		PoseStateVector result;
 
 		// Add the first 9 rows (position, velocity, and acceleration) the usual way
-		result.head<9>() = this->head<9>() + other.head<9>();
+		result.template head<9>() = this->template head<9>() + other.template head<9>();
 		// Add the last 3 rows (angular velocity) the usual was
-		result.tail<3>() = this->tail<3>() + other.head<3>();
+		result.template tail<3>() = this->template tail<3>() + other.template tail<3>();
 
 		// Extract the orientation quaternion from A (which is stored as an angle axis vector)
-		const Eigen::Quaterniond orientation = this->get_quaternion();
+		const Quaternion orientation = this->get_quaternion();
 
 		// Extract the delta quaternion from B (which is also stored as an angle axis vector)
-		const Eigen::Quaterniond delta = other.get_quaternion();
+		const Quaternion delta = other.get_quaternion();
 
 		// Apply the delta to the orientation
-		const Eigen::Quaterniond new_rotation = (orientation*delta).normalized();
+		const Quaternion new_rotation = (orientation*delta).normalized();
 
 		// Save the net rotation rotation back in result
 		result.set_quaternion(new_rotation);
 
 		return result;
-	}	
+	}
 
-	PoseStateVector operator + (const PoseNoiseVector &other) const
+	PoseStateVector operator + (const PoseNoiseVector<T> &other) const
 	{
 		PoseStateVector result;
 
 		// Add the first 9 rows (position, velocity, and acceleration) the usual way
-		result.head<9>() = this->head<9>() + other.head<9>();
+		result.template head<9>() = this->template head<9>() + other.template head<9>();
 
 		// Extract the orientation quaternion from A (which is stored as an angle axis vector)
-		const Eigen::Quaterniond orientation = this->get_quaternion();
+		const Quaternion orientation = this->get_quaternion();
 
 		// Extract the delta noise quaternion from B (which is also stored as an angle axis vector)
-		const Eigen::Quaterniond delta = other.get_quaternion_noise();
+		const Quaternion delta = other.get_quaternion_noise();
 
 		// Apply the noise delta to the orientation
-		const Eigen::Quaterniond new_rotation = (orientation*delta).normalized();
+		const Quaternion new_rotation = (orientation*delta).normalized();
 
 		// Save the net rotation rotation back in result
 		result.set_quaternion(new_rotation);
@@ -316,35 +345,35 @@ public:
 		PoseStateVector result;
 
 		// Subtract the first 9 rows (position, velocity, and acceleration) the usual way
-		result.head<9>() = this->head<9>() - other.head<9>();
+		result.template head<9>() = this->template head<9>() - other.template head<9>();
 		// Subtract the last 3 rows (angular velocity) the usual was
-		result.tail<3>() = this->tail<3>() - other.head<3>();
+		result.template tail<3>() = this->template tail<3>() - other.template tail<3>();
 
 		// Extract the orientation quaternion from both states (which is stored as an angle axis vector)
-		const Eigen::Quaterniond q1= this->get_quaternion();
-		const Eigen::Quaterniond q2= other.get_quaternion();
+		const Quaternion q1= this->get_quaternion();
+		const Quaternion q2= other.get_quaternion();
 
 		// Compute the "quaternion difference" i.e. rotation from q1 to q2
-		const Eigen::Quaterniond q_diff= (q1*q2.conjugate()).normalized();
+		const Quaternion q_diff= (q1*q2.conjugate()).normalized();
 
 		result.set_quaternion(q_diff);
 
 		return result;
 	}
 
-	PoseStateVector operator - (const PoseNoiseVector &other) const
+	PoseStateVector operator - (const PoseNoiseVector<T> &other) const
 	{
 		PoseStateVector result;
 
 		// Subtract the first 9 rows (position, velocity, and acceleration) the usual way
-		result.head<9>() = this->head<9>() - other.head<9>();
+		result.template head<9>() = this->template head<9>() - other.template head<9>();
 
 		// Extract the orientation quaternion from both states (which is stored as an angle axis vector)
-		const Eigen::Quaterniond q1 = this->get_quaternion();
-		const Eigen::Quaterniond q2 = other.get_quaternion_noise();
+		const Quaternion q1 = this->get_quaternion();
+		const Quaternion q2 = other.get_quaternion_noise();
 
 		// Compute the "quaternion difference" i.e. rotation from q1 to q2
-		const Eigen::Quaterniond q_diff = (q1*q2.conjugate()).normalized();
+		const Quaternion q_diff = (q1*q2.conjugate()).normalized();
 
 		result.set_quaternion(q_diff);
 
@@ -357,41 +386,40 @@ public:
 
 	template <int PointCount>
 	static void special_state_mean(
-		const Eigen::Matrix<double, STATE_PARAMETER_COUNT, PointCount>& state_matrix,
-		const Eigen::Matrix<double, PointCount, 1> weight_vector,
+		const Eigen::Matrix<T, STATE_PARAMETER_COUNT, PointCount>& state_matrix,
+		const Eigen::Matrix<T, PointCount, 1> &weight_vector,
 		PoseStateVector &result)
 	{
-		Eigen::Quaterniond quat_0_inv = extract_quaternion<RowsAtCompileTime>(state_matrix.col(0)).conjugate();
-
 		// Extract the orientations from the states
-		Eigen::Quaterniond orientations[PointCount];
-		double weights[PointCount];
+		Quaternion orientations[PointCount];
+		T weights[PointCount];
 		for (int col_index = 0; col_index < PointCount; ++col_index)
 		{
-			Eigen::Quaterniond orientation = extract_quaternion<RowsAtCompileTime>(state_matrix.col(col_index));
+			Quaternion orientation = extract_quaternion<STATE_PARAMETER_COUNT>(state_matrix.col(col_index));
 
 			orientations[col_index]= orientation;
 			weights[col_index]= weight_vector[col_index];
 		}
 
 		// Compute the average of the quaternions
-		Eigen::Quaterniond average_quat;
-		eigen_quaternion_compute_weighted_average(orientations, weights, PointCount, &average_quat);
+		Quaternion average_quat;
+		compute_weighted_quaternion_average<T, PointCount>(orientations, weights, &average_quat);
 
 		// Stomp the incorrect orientation average
-		apply_quaternion<RowsAtCompileTime>(average_quat, result);
+		apply_quaternion<STATE_PARAMETER_COUNT>(average_quat, result);
 	}
 };
 
-PoseNoiseVector convert_state_to_noise_vector(const PoseStateVector &state_vector)
+template <typename T>
+PoseNoiseVector<T> convert_state_to_noise_vector(const PoseStateVector<T> &state_vector)
 {
-	PoseNoiseVector result;
+	PoseNoiseVector<T> result;
 
 	// Copy the linear portions straight over (position, velocity, acceleration)
-	result.head<9>() = state_vector.head<9>();
+	result.template head<9>() = state_vector.template head<9>();
 
 	// Convert the quaternion in the state vector to an angle-axis vector
-	result.set_angle_axis_noise(Eigen::AngleAxisd(state_vector.get_quaternion()));
+	result.set_angle_axis_noise(Eigen::AngleAxis<T>(state_vector.get_quaternion()));
 
 	// Copy over the angular velocity vector
 	result.set_angular_velocity_noise(state_vector.get_angular_velocity_rad_per_sec());
@@ -399,15 +427,16 @@ PoseNoiseVector convert_state_to_noise_vector(const PoseStateVector &state_vecto
 	return result;
 }
 
-PoseStateVector convert_noise_to_state_vector(const PoseNoiseVector &noise_vector)
+template <typename T>
+PoseStateVector<T> convert_noise_to_state_vector(const PoseNoiseVector<T> &noise_vector)
 {
-	PoseStateVector result;
+	PoseStateVector<T> result;
 
 	// Copy the linear portions straight over (position, velocity, acceleration)
-	result.head<9>() = noise_vector.head<9>();
+	result.template head<9>() = noise_vector.template head<9>();
 
 	// Copy the angle-axis vector
-	result.set_quaternion(Eigen::Quaterniond(noise_vector.get_angle_axis_noise()));
+	result.set_quaternion(Eigen::Quaternion<T>(noise_vector.get_angle_axis_noise()));
 
 	// Copy over the angular velocity vector
 	result.set_angular_velocity_rad_per_sec(noise_vector.get_angular_velocity_noise());
@@ -415,62 +444,66 @@ PoseStateVector convert_noise_to_state_vector(const PoseNoiseVector &noise_vecto
 	return result;
 }
 
-class PSMove_MeasurementVector : public Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1>
+template <typename T>
+class PSMove_MeasurementVector : public Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1>
 {
 public:
-	PSMove_MeasurementVector(void) : Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1>()
+	typedef Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1> MatrixType;
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+
+	PSMove_MeasurementVector(void) : MatrixType()
 	{ }
 
 	template<typename OtherDerived>
-	PSMove_MeasurementVector(const Eigen::MatrixBase<OtherDerived>& other) : Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1>(other)
+	PSMove_MeasurementVector(const Eigen::MatrixBase<OtherDerived>& other) : MatrixType(other)
 	{ }
 
 	template<typename OtherDerived>
 	PSMove_MeasurementVector& operator= (const Eigen::MatrixBase<OtherDerived>& other)
 	{
-		this->Base::operator=(other);
+		this->MatrixType::operator=(other);
 		return *this;
 	}
 
     // Accessors
-    Eigen::Vector3d get_accelerometer() const {
-        return Eigen::Vector3d((*this)[PSMOVE_ACCELEROMETER_X], (*this)[PSMOVE_ACCELEROMETER_Y], (*this)[PSMOVE_ACCELEROMETER_Z]);
+    Vector3 get_accelerometer() const {
+        return Vector3((*this)[PSMOVE_ACCELEROMETER_X], (*this)[PSMOVE_ACCELEROMETER_Y], (*this)[PSMOVE_ACCELEROMETER_Z]);
     }
-    Eigen::Vector3d get_gyroscope() const {
-        return Eigen::Vector3d((*this)[PSMOVE_GYROSCOPE_X], (*this)[PSMOVE_GYROSCOPE_Y], (*this)[PSMOVE_GYROSCOPE_Z]);
+    Vector3 get_gyroscope() const {
+        return Vector3((*this)[PSMOVE_GYROSCOPE_X], (*this)[PSMOVE_GYROSCOPE_Y], (*this)[PSMOVE_GYROSCOPE_Z]);
     }
-    Eigen::Vector3d get_magnetometer() const {
-        return Eigen::Vector3d((*this)[PSMOVE_MAGNETOMETER_X], (*this)[PSMOVE_MAGNETOMETER_Y], (*this)[PSMOVE_MAGNETOMETER_Z]);
+    Vector3 get_magnetometer() const {
+        return Vector3((*this)[PSMOVE_MAGNETOMETER_X], (*this)[PSMOVE_MAGNETOMETER_Y], (*this)[PSMOVE_MAGNETOMETER_Z]);
     }
-    Eigen::Vector3d get_optical_position() const {
-        return Eigen::Vector3d((*this)[PSMOVE_OPTICAL_POSITION_X], (*this)[PSMOVE_OPTICAL_POSITION_Y], (*this)[PSMOVE_OPTICAL_POSITION_Z]);
+    Vector3 get_optical_position() const {
+        return Vector3((*this)[PSMOVE_OPTICAL_POSITION_X], (*this)[PSMOVE_OPTICAL_POSITION_Y], (*this)[PSMOVE_OPTICAL_POSITION_Z]);
     }
 
     // Mutators
-    void set_accelerometer(const Eigen::Vector3d &a) {
+    void set_accelerometer(const Vector3 &a) {
         (*this)[PSMOVE_ACCELEROMETER_X] = a.x(); (*this)[PSMOVE_ACCELEROMETER_Y] = a.y(); (*this)[PSMOVE_ACCELEROMETER_Z] = a.z();
     }
-    void set_gyroscope(const Eigen::Vector3d &g) {
+    void set_gyroscope(const Vector3 &g) {
         (*this)[PSMOVE_GYROSCOPE_X] = g.x(); (*this)[PSMOVE_GYROSCOPE_Y] = g.y(); (*this)[PSMOVE_GYROSCOPE_Z] = g.z();
     }
-    void set_optical_position(const Eigen::Vector3d &p) {
+    void set_optical_position(const Vector3 &p) {
         (*this)[PSMOVE_OPTICAL_POSITION_X] = p.x(); (*this)[PSMOVE_OPTICAL_POSITION_Y] = p.y(); (*this)[PSMOVE_OPTICAL_POSITION_Z] = p.z();
     }
-    void set_magnetometer(const Eigen::Vector3d &m) {
+    void set_magnetometer(const Vector3 &m) {
         (*this)[PSMOVE_MAGNETOMETER_X] = m.x(); (*this)[PSMOVE_MAGNETOMETER_Y] = m.y(); (*this)[PSMOVE_MAGNETOMETER_Z] = m.z();
     }
 
 	PSMove_MeasurementVector negate() const
 	{
-		// for the PSMove measurement the negation can be computed 
+		// for the PSMove measurement the negation can be computed
 		// with simple vector negation
-		return (*this) * -1.0;
+		return (*this) * static_cast<T>(-1);
 	}
 
 	template <int SIGMA_POINT_COUNT>
 	static PSMove_MeasurementVector computeWeightedMeasurementAverage(
-		const Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, SIGMA_POINT_COUNT>& measurement_matrix,
-		const Eigen::Matrix<double, SIGMA_POINT_COUNT, 1> &weight_vector)
+		const Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, SIGMA_POINT_COUNT>& measurement_matrix,
+		const Eigen::Matrix<T, SIGMA_POINT_COUNT, 1> &weight_vector)
 	{
 		// Use efficient matrix x vector computation to compute a weighted average of the sigma point samples
 		// (No orientation stored in measurement means this can be simple)
@@ -480,60 +513,66 @@ public:
 	}
 };
 
-class DS4_MeasurementVector : public Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, 1>
+template <typename T>
+class DS4_MeasurementVector : public Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, 1>
 {
 public:
-	DS4_MeasurementVector(void) : Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, 1>()
+	typedef Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, 1> MatrixType;
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+	typedef Eigen::AngleAxis<T> AngleAxis;
+
+	DS4_MeasurementVector(void) : MatrixType()
 	{ }
 
 	template<typename OtherDerived>
-	DS4_MeasurementVector(const Eigen::MatrixBase<OtherDerived>& other) : Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, 1>(other)
+	DS4_MeasurementVector(const Eigen::MatrixBase<OtherDerived>& other) : MatrixType(other)
 	{ }
 
 	template<typename OtherDerived>
 	DS4_MeasurementVector& operator= (const Eigen::MatrixBase<OtherDerived>& other)
 	{
-		this->Base::operator=(other);
+		this->MatrixType::operator=(other);
 		return *this;
 	}
 
     // Accessors
-    Eigen::Vector3d get_accelerometer() const {
-        return Eigen::Vector3d((*this)[DS4_ACCELEROMETER_X], (*this)[DS4_ACCELEROMETER_Y], (*this)[DS4_ACCELEROMETER_Z]);
+    Vector3 get_accelerometer() const {
+        return Vector3((*this)[DS4_ACCELEROMETER_X], (*this)[DS4_ACCELEROMETER_Y], (*this)[DS4_ACCELEROMETER_Z]);
     }
-    Eigen::Vector3d get_gyroscope() const {
-        return Eigen::Vector3d((*this)[DS4_GYROSCOPE_X], (*this)[DS4_GYROSCOPE_Y], (*this)[DS4_GYROSCOPE_Z]);
+    Vector3 get_gyroscope() const {
+        return Vector3((*this)[DS4_GYROSCOPE_X], (*this)[DS4_GYROSCOPE_Y], (*this)[DS4_GYROSCOPE_Z]);
     }
-    Eigen::Vector3d get_optical_position() const {
-        return Eigen::Vector3d((*this)[DS4_OPTICAL_POSITION_X], (*this)[DS4_OPTICAL_POSITION_Y], (*this)[DS4_OPTICAL_POSITION_Z]);
+    Vector3 get_optical_position() const {
+        return Vector3((*this)[DS4_OPTICAL_POSITION_X], (*this)[DS4_OPTICAL_POSITION_Y], (*this)[DS4_OPTICAL_POSITION_Z]);
     }
-    Eigen::AngleAxisd get_optical_angle_axis() const {
-        Eigen::Vector3d axis= Eigen::Vector3d((*this)[DS4_OPTICAL_ANGLE_AXIS_X], (*this)[DS4_OPTICAL_ANGLE_AXIS_Y], (*this)[DS4_OPTICAL_ANGLE_AXIS_Z]);
-        const double angle= eigen_vector3d_normalize_with_default(axis, Eigen::Vector3d::Zero());
-        return Eigen::AngleAxisd(angle, axis);
+    AngleAxis get_optical_angle_axis() const {
+        Vector3 axis= Vector3((*this)[DS4_OPTICAL_ANGLE_AXIS_X], (*this)[DS4_OPTICAL_ANGLE_AXIS_Y], (*this)[DS4_OPTICAL_ANGLE_AXIS_Z]);
+        const T angle= normalize_vector3_with_zero_default<T>(axis);
+        return AngleAxis(angle, axis);
     }
-    Eigen::Quaterniond get_optical_quaternion() const {
-        return Eigen::Quaterniond(get_optical_angle_axis());
+    Quaternion get_optical_quaternion() const {
+        return Quaternion(get_optical_angle_axis());
     }
 
     // Mutators
-    void set_accelerometer(const Eigen::Vector3d &a) {
+    void set_accelerometer(const Vector3 &a) {
         (*this)[DS4_ACCELEROMETER_X] = a.x(); (*this)[DS4_ACCELEROMETER_Y] = a.y(); (*this)[DS4_ACCELEROMETER_Z] = a.z();
     }
-    void set_gyroscope(const Eigen::Vector3d &g) {
+    void set_gyroscope(const Vector3 &g) {
         (*this)[DS4_GYROSCOPE_X] = g.x(); (*this)[DS4_GYROSCOPE_Y] = g.y(); (*this)[DS4_GYROSCOPE_Z] = g.z();
     }
-    void set_optical_position(const Eigen::Vector3d &p) {
+    void set_optical_position(const Vector3 &p) {
         (*this)[DS4_OPTICAL_POSITION_X] = p.x(); (*this)[DS4_OPTICAL_POSITION_Y] = p.y(); (*this)[DS4_OPTICAL_POSITION_Z] = p.z();
     }
-    void set_angle_axis(const Eigen::AngleAxisd &a) {        
-        const double angle= a.angle();
-        (*this)[DS4_OPTICAL_ANGLE_AXIS_X] = a.axis().x() * angle; 
+    void set_angle_axis(const AngleAxis &a) {
+        const T angle= a.angle();
+        (*this)[DS4_OPTICAL_ANGLE_AXIS_X] = a.axis().x() * angle;
         (*this)[DS4_OPTICAL_ANGLE_AXIS_Y] = a.axis().y() * angle;
         (*this)[DS4_OPTICAL_ANGLE_AXIS_Z] = a.axis().z() * angle;
     }
-    void set_optical_quaternion(const Eigen::Quaterniond &q) {
-        const Eigen::AngleAxisd angle_axis(q);
+    void set_optical_quaternion(const Quaternion &q) {
+        const AngleAxis angle_axis(q);
         set_angle_axis(angle_axis);
     }
 
@@ -541,11 +580,11 @@ public:
 	{
 		DS4_MeasurementVector measurement_diff;
 
-		measurement_diff.head<9>() = this->head<9>() - other.head<9>();
-		
-		const Eigen::Quaterniond q1= this->get_optical_quaternion();
-		const Eigen::Quaterniond q2= other.get_optical_quaternion();
-		const Eigen::Quaterniond q_diff= q2*q1.conjugate();
+		measurement_diff.template head<9>() = this->template head<9>() - other.template head<9>();
+
+		const Quaternion q1= this->get_optical_quaternion();
+		const Quaternion q2= other.get_optical_quaternion();
+		const Quaternion q_diff= q2*q1.conjugate();
 
 		// Stomp the incorrect orientation difference computed by the vector subtraction
 		measurement_diff.set_optical_quaternion(q_diff);
@@ -555,36 +594,36 @@ public:
 
 	DS4_MeasurementVector negate() const
 	{
-		// for the DS4 measurement the negation can be computed 
+		// for the DS4 measurement the negation can be computed
 		// with simple vector negation
 		// (Safe to negate the optical angle axis)
-		return (*this) * -1.0;
+		return (*this) * static_cast<T>(-1);
 	}
 
 	template <int SIGMA_POINT_COUNT>
 	static DS4_MeasurementVector computeWeightedMeasurementAverage(
-		const Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, SIGMA_POINT_COUNT>& measurement_matrix,
-		Eigen::Matrix<double, SIGMA_POINT_COUNT, 1> weight_vector)
+		const Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, SIGMA_POINT_COUNT>& measurement_matrix,
+		const Eigen::Matrix<T, SIGMA_POINT_COUNT, 1> &weight_vector)
 	{
 		// Use efficient matrix x vector computation to compute a weighted average of the measurements
 		// (the orientation portion will be wrong)
 		DS4_MeasurementVector result= measurement_matrix * weight_vector;
 
 		// Extract the orientations from the measurements
-		Eigen::Quaterniond orientations[SIGMA_POINT_COUNT];
-		double weights[SIGMA_POINT_COUNT];
+		Quaternion orientations[SIGMA_POINT_COUNT];
+		T weights[SIGMA_POINT_COUNT];
 		for (int col_index = 0; col_index < SIGMA_POINT_COUNT; ++col_index)
 		{
 			const DS4_MeasurementVector measurement = measurement_matrix.col(col_index);
-			Eigen::Quaterniond orientation = measurement.get_optical_quaternion();
+			Quaternion orientation = measurement.get_optical_quaternion();
 
 			orientations[col_index]= orientation;
 			weights[col_index]= weight_vector[col_index];
 		}
 
 		// Compute the average of the quaternions
-		Eigen::Quaterniond average_quat;
-		eigen_quaternion_compute_weighted_average(orientations, weights, SIGMA_POINT_COUNT, &average_quat);
+		Quaternion average_quat;
+		compute_weighted_quaternion_average<T, SIGMA_POINT_COUNT>(orientations, weights, &average_quat);
 
 		// Stomp the incorrect orientation average
 		result.set_optical_quaternion(average_quat);
@@ -599,15 +638,19 @@ public:
 * This is the measurement model for measuring the position and magnetometer of the PSMove controller.
 * The measurement is given by the optical trackers.
 */
+template <typename T>
 class PSMove_MeasurementModel
 {
 public:
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+
     void init(const PoseFilterConstants &constants)
     {
 		update_measurement_statistics(constants, 0.f);
-        
-		identity_gravity_direction= constants.orientation_constants.gravity_calibration_direction.cast<double>();
-		identity_magnetometer_direction= constants.orientation_constants.magnetometer_calibration_direction.cast<double>();
+
+		identity_gravity_direction= constants.orientation_constants.gravity_calibration_direction.cast<T>();
+		identity_magnetometer_direction= constants.orientation_constants.magnetometer_calibration_direction.cast<T>();
     }
 
 	void update_measurement_statistics(
@@ -622,39 +665,39 @@ public:
 		const double position_variance_m_sqr = k_centimeters_to_meters*k_centimeters_to_meters*position_variance_cm_sqr;
 
 		// Update the biases
-		Eigen::Vector3d acc_drift = constants.position_constants.accelerometer_drift.cast<double>();
-		Eigen::Vector3d gyro_drift = constants.orientation_constants.gyro_drift.cast<double>();
-		Eigen::Vector3d mag_drift = constants.orientation_constants.magnetometer_drift.cast<double>();
-		R_mu(PSMOVE_ACCELEROMETER_X, 1) = acc_drift.x();
-		R_mu(PSMOVE_ACCELEROMETER_Y, 1) = acc_drift.y();
-		R_mu(PSMOVE_ACCELEROMETER_Z, 1) = acc_drift.z();
-		R_mu(PSMOVE_GYROSCOPE_X, 1) = gyro_drift.x();
-		R_mu(PSMOVE_GYROSCOPE_Y, 1) = gyro_drift.y();
-		R_mu(PSMOVE_GYROSCOPE_Z, 1) = gyro_drift.z();
-		R_mu(PSMOVE_MAGNETOMETER_X, 1) = mag_drift.x();
-		R_mu(PSMOVE_MAGNETOMETER_Y, 1) = mag_drift.y();
-		R_mu(PSMOVE_MAGNETOMETER_Z, 1) = mag_drift.z();
-		R_mu(PSMOVE_OPTICAL_POSITION_X, 1) = 0.0;
-		R_mu(PSMOVE_OPTICAL_POSITION_Y, 1) = 0.0;
-		R_mu(PSMOVE_OPTICAL_POSITION_Z, 1) = 0.0;
+		Vector3 acc_drift = constants.position_constants.accelerometer_drift.cast<T>();
+		Vector3 gyro_drift = constants.orientation_constants.gyro_drift.cast<T>();
+		Vector3 mag_drift = constants.orientation_constants.magnetometer_drift.cast<T>();
+		R_mu(PSMOVE_ACCELEROMETER_X) = acc_drift.x();
+		R_mu(PSMOVE_ACCELEROMETER_Y) = acc_drift.y();
+		R_mu(PSMOVE_ACCELEROMETER_Z) = acc_drift.z();
+		R_mu(PSMOVE_GYROSCOPE_X) = gyro_drift.x();
+		R_mu(PSMOVE_GYROSCOPE_Y) = gyro_drift.y();
+		R_mu(PSMOVE_GYROSCOPE_Z) = gyro_drift.z();
+		R_mu(PSMOVE_MAGNETOMETER_X) = mag_drift.x();
+		R_mu(PSMOVE_MAGNETOMETER_Y) = mag_drift.y();
+		R_mu(PSMOVE_MAGNETOMETER_Z) = mag_drift.z();
+		R_mu(PSMOVE_OPTICAL_POSITION_X) = 0;
+		R_mu(PSMOVE_OPTICAL_POSITION_Y) = 0;
+		R_mu(PSMOVE_OPTICAL_POSITION_Z) = 0;
 
 
         // Update the measurement covariance R
-        R_cov = Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, PSMOVE_MEASUREMENT_PARAMETER_COUNT>::Zero();
+        R_cov = Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, PSMOVE_MEASUREMENT_PARAMETER_COUNT>::Zero();
 
 		// Only diagonals used so no need to compute Cholesky
-		R_cov(PSMOVE_ACCELEROMETER_X, PSMOVE_ACCELEROMETER_X) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.x());
-		R_cov(PSMOVE_ACCELEROMETER_Y, PSMOVE_ACCELEROMETER_Y) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.y());
-		R_cov(PSMOVE_ACCELEROMETER_Z, PSMOVE_ACCELEROMETER_Z) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.z());
-		R_cov(PSMOVE_GYROSCOPE_X, PSMOVE_GYROSCOPE_X)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.x());
-		R_cov(PSMOVE_GYROSCOPE_Y, PSMOVE_GYROSCOPE_Y)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.y());
-		R_cov(PSMOVE_GYROSCOPE_Z, PSMOVE_GYROSCOPE_Z)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.z());
-		R_cov(PSMOVE_MAGNETOMETER_X, PSMOVE_MAGNETOMETER_X) = sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.x());
-		R_cov(PSMOVE_MAGNETOMETER_Y, PSMOVE_MAGNETOMETER_Y) = sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.y());
-		R_cov(PSMOVE_MAGNETOMETER_Z, PSMOVE_MAGNETOMETER_Z) = sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.z());
-		R_cov(PSMOVE_OPTICAL_POSITION_X, PSMOVE_OPTICAL_POSITION_X) = sqrt(R_SCALE*position_variance_m_sqr);
-		R_cov(PSMOVE_OPTICAL_POSITION_Y, PSMOVE_OPTICAL_POSITION_Y) = sqrt(R_SCALE*position_variance_m_sqr);
-		R_cov(PSMOVE_OPTICAL_POSITION_Z, PSMOVE_OPTICAL_POSITION_Z) = sqrt(R_SCALE*position_variance_m_sqr);
+		R_cov(PSMOVE_ACCELEROMETER_X, PSMOVE_ACCELEROMETER_X) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.x()));
+		R_cov(PSMOVE_ACCELEROMETER_Y, PSMOVE_ACCELEROMETER_Y) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.y()));
+		R_cov(PSMOVE_ACCELEROMETER_Z, PSMOVE_ACCELEROMETER_Z) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.z()));
+		R_cov(PSMOVE_GYROSCOPE_X, PSMOVE_GYROSCOPE_X)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.x()));
+		R_cov(PSMOVE_GYROSCOPE_Y, PSMOVE_GYROSCOPE_Y)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.y()));
+		R_cov(PSMOVE_GYROSCOPE_Z, PSMOVE_GYROSCOPE_Z)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.z()));
+		R_cov(PSMOVE_MAGNETOMETER_X, PSMOVE_MAGNETOMETER_X) = static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.x()));
+		R_cov(PSMOVE_MAGNETOMETER_Y, PSMOVE_MAGNETOMETER_Y) = static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.y()));
+		R_cov(PSMOVE_MAGNETOMETER_Z, PSMOVE_MAGNETOMETER_Z) = static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.magnetometer_variance.z()));
+		R_cov(PSMOVE_OPTICAL_POSITION_X, PSMOVE_OPTICAL_POSITION_X) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
+		R_cov(PSMOVE_OPTICAL_POSITION_Y, PSMOVE_OPTICAL_POSITION_Y) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
+		R_cov(PSMOVE_OPTICAL_POSITION_Z, PSMOVE_OPTICAL_POSITION_Z) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
 	}
 
     /**
@@ -667,45 +710,45 @@ public:
     * @param [in] x The system state in current time-step
     * @returns The (predicted) sensor measurement for the system state
     */
-    PSMove_MeasurementVector observation_function(const PoseStateVector& state, const PSMove_MeasurementVector &observation_noise) const
+    PSMove_MeasurementVector<T> observation_function(const PoseStateVector<T>& state, const PSMove_MeasurementVector<T> &observation_noise) const
     {
-        PSMove_MeasurementVector predicted_measurement;
+        PSMove_MeasurementVector<T> predicted_measurement;
 
 		// Extract the observation bias
-		const PSMove_MeasurementVector &observation_bias = R_mu;
-		const Eigen::Vector3d accel_bias = observation_bias.get_accelerometer();
-		const Eigen::Vector3d mag_bias = observation_bias.get_magnetometer();
-		const Eigen::Vector3d gyro_bias = observation_bias.get_gyroscope();
-		const Eigen::Vector3d position_bias = observation_bias.get_optical_position();
+		const PSMove_MeasurementVector<T> observation_bias = R_mu;
+		const Vector3 accel_bias = observation_bias.get_accelerometer();
+		const Vector3 mag_bias = observation_bias.get_magnetometer();
+		const Vector3 gyro_bias = observation_bias.get_gyroscope();
+		const Vector3 position_bias = observation_bias.get_optical_position();
 
 		// Extract the observation noise
-		const Eigen::Vector3d accel_noise = observation_noise.get_accelerometer();
-		const Eigen::Vector3d mag_noise = observation_noise.get_magnetometer();
-		const Eigen::Vector3d gyro_noise = observation_noise.get_gyroscope();
-		const Eigen::Vector3d position_noise = observation_noise.get_optical_position();
+		const Vector3 accel_noise = observation_noise.get_accelerometer();
+		const Vector3 mag_noise = observation_noise.get_magnetometer();
+		const Vector3 gyro_noise = observation_noise.get_gyroscope();
+		const Vector3 position_noise = observation_noise.get_optical_position();
 
         // Use the position and orientation from the state for predictions
-        const Eigen::Vector3d position= state.get_position_meters();
-        const Eigen::Quaterniond orientation= state.get_quaternion();
+        const Vector3 position= state.get_position_meters();
+        const Quaternion orientation= state.get_quaternion();
 
         // Use the current linear acceleration from the state to predict
         // what the accelerometer reading will be (in world space)
-        const Eigen::Vector3d gravity_accel_g_units= identity_gravity_direction;
-        const Eigen::Vector3d linear_accel_g_units= state.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
-        const Eigen::Vector3d accel_world= linear_accel_g_units + gravity_accel_g_units;
+        const Vector3 gravity_accel_g_units= identity_gravity_direction;
+        const Vector3 linear_accel_g_units= state.get_linear_acceleration_m_per_sec_sqr() * static_cast<T>(k_ms2_to_g_units);
+        const Vector3 accel_world= linear_accel_g_units + gravity_accel_g_units;
 
         // Put the accelerometer prediction into the local space of the controller
-		const Eigen::Quaterniond accel_world_quat(0.f, accel_world.x(), accel_world.y(), accel_world.z());
-		const Eigen::Vector3d accel_local = orientation*(accel_world_quat*orientation.conjugate()).vec();
+		const Quaternion accel_world_quat(0, accel_world.x(), accel_world.y(), accel_world.z());
+		const Vector3 accel_local = orientation*(accel_world_quat*orientation.conjugate()).vec();
 
         // Use the angular velocity from the state to predict what the gyro reading will be
-        const Eigen::Vector3d gyro_local= state.get_angular_velocity_rad_per_sec(); 
+        const Vector3 gyro_local= state.get_angular_velocity_rad_per_sec();
 
         // Use the orientation from the state to predict
         // what the magnetometer reading should be
-        const Eigen::Vector3d &mag_world= identity_magnetometer_direction;
-		const Eigen::Quaterniond mag_world_quat(0.f, mag_world.x(), mag_world.y(), mag_world.z());
-        const Eigen::Vector3d mag_local= orientation*(mag_world_quat*orientation.conjugate()).vec();
+        const Vector3 &mag_world= identity_magnetometer_direction;
+		const Quaternion mag_world_quat(0, mag_world.x(), mag_world.y(), mag_world.z());
+        const Vector3 mag_local= orientation*(mag_world_quat*orientation.conjugate()).vec();
 
         // Save the predictions into the measurement vector
         predicted_measurement.set_accelerometer(accel_local + accel_bias + accel_noise);
@@ -717,14 +760,14 @@ public:
     }
 
 public:
-    Eigen::Vector3d identity_gravity_direction;
-    Eigen::Vector3d identity_magnetometer_direction;
+    Vector3 identity_gravity_direction;
+    Vector3 identity_magnetometer_direction;
 
 	//! Measurement noise mean
-	Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1> R_mu;
+	Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, 1> R_mu;
 
 	//! Measurement noise covariance
-	Eigen::Matrix<double, PSMOVE_MEASUREMENT_PARAMETER_COUNT, PSMOVE_MEASUREMENT_PARAMETER_COUNT> R_cov;
+	Eigen::Matrix<T, PSMOVE_MEASUREMENT_PARAMETER_COUNT, PSMOVE_MEASUREMENT_PARAMETER_COUNT> R_cov;
 };
 
 /**
@@ -733,14 +776,18 @@ public:
 * This is the measurement model for measuring the position and orientation of the DS4 controller.
 * The measurement is given by the optical trackers.
 */
+template <typename T>
 class DS4_MeasurementModel
 {
 public:
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+
     void init(const PoseFilterConstants &constants)
     {
 		update_measurement_statistics(constants, 0.f);
 
-		identity_gravity_direction= constants.orientation_constants.gravity_calibration_direction.cast<double>();
+		identity_gravity_direction= constants.orientation_constants.gravity_calibration_direction.cast<T>();
     }
 
 	void update_measurement_statistics(
@@ -755,39 +802,39 @@ public:
 		const double orientation_variance =
 			constants.orientation_constants.orientation_variance_curve.evaluate(tracking_projection_area_px_sqr);
 
-		const float position_drift = 0.f;
+		const T position_drift = 0;
 
-		const double angle_axis_std_dev= sqrt(R_SCALE*orientation_variance);
-		const double angle_axis_drift = 0.f;
+		const T angle_axis_std_dev= static_cast<T>(sqrt(R_SCALE*orientation_variance));
+		const T angle_axis_drift = 0;
 
 		// Update the biases
-		const Eigen::Vector3d acc_drift = constants.position_constants.accelerometer_drift.cast<double>();
-		const Eigen::Vector3d gyro_drift = constants.orientation_constants.gyro_drift.cast<double>();
-		R_mu(DS4_ACCELEROMETER_X, 1) = acc_drift.x();
-		R_mu(DS4_ACCELEROMETER_Y, 1) = acc_drift.y();
-		R_mu(DS4_ACCELEROMETER_Z, 1) = acc_drift.z();
-		R_mu(DS4_GYROSCOPE_X, 1) = gyro_drift.x();
-		R_mu(DS4_GYROSCOPE_Y, 1) = gyro_drift.y();
-		R_mu(DS4_GYROSCOPE_Z, 1) = gyro_drift.z();
-		R_mu(DS4_OPTICAL_POSITION_X, 1) = position_drift;
-		R_mu(DS4_OPTICAL_POSITION_Y, 1) = position_drift;
-		R_mu(DS4_OPTICAL_POSITION_Z, 1) = position_drift;
-		R_mu(DS4_OPTICAL_ANGLE_AXIS_X, 1) = angle_axis_drift;
-		R_mu(DS4_OPTICAL_ANGLE_AXIS_Y, 1) = angle_axis_drift;
-		R_mu(DS4_OPTICAL_ANGLE_AXIS_Z, 1) = angle_axis_drift;
+		const Vector3 acc_drift = constants.position_constants.accelerometer_drift.cast<T>();
+		const Vector3 gyro_drift = constants.orientation_constants.gyro_drift.cast<T>();
+		R_mu(DS4_ACCELEROMETER_X) = acc_drift.x();
+		R_mu(DS4_ACCELEROMETER_Y) = acc_drift.y();
+		R_mu(DS4_ACCELEROMETER_Z) = acc_drift.z();
+		R_mu(DS4_GYROSCOPE_X) = gyro_drift.x();
+		R_mu(DS4_GYROSCOPE_Y) = gyro_drift.y();
+		R_mu(DS4_GYROSCOPE_Z) = gyro_drift.z();
+		R_mu(DS4_OPTICAL_POSITION_X) = position_drift;
+		R_mu(DS4_OPTICAL_POSITION_Y) = position_drift;
+		R_mu(DS4_OPTICAL_POSITION_Z) = position_drift;
+		R_mu(DS4_OPTICAL_ANGLE_AXIS_X) = angle_axis_drift;
+		R_mu(DS4_OPTICAL_ANGLE_AXIS_Y) = angle_axis_drift;
+		R_mu(DS4_OPTICAL_ANGLE_AXIS_Z) = angle_axis_drift;
 
         // Update the measurement covariance R
-        R_cov = Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, DS4_MEASUREMENT_PARAMETER_COUNT>::Zero();
-		R_cov(DS4_ACCELEROMETER_X, DS4_ACCELEROMETER_X) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.x());
-		R_cov(DS4_ACCELEROMETER_Y, DS4_ACCELEROMETER_Y) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.y());
-		R_cov(DS4_ACCELEROMETER_Z, DS4_ACCELEROMETER_Z) = sqrt(R_SCALE*constants.position_constants.accelerometer_variance.z());
-		R_cov(DS4_GYROSCOPE_X, DS4_GYROSCOPE_X)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.x());
-		R_cov(DS4_GYROSCOPE_Y, DS4_GYROSCOPE_Y)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.y());
-		R_cov(DS4_GYROSCOPE_Z, DS4_GYROSCOPE_Z)= sqrt(R_SCALE*constants.orientation_constants.gyro_variance.z());
-		R_cov(DS4_OPTICAL_POSITION_X, DS4_OPTICAL_POSITION_X) = sqrt(R_SCALE*position_variance_m_sqr);
-		R_cov(DS4_OPTICAL_POSITION_Y, DS4_OPTICAL_POSITION_Y) = sqrt(R_SCALE*position_variance_m_sqr);
-		R_cov(DS4_OPTICAL_POSITION_Z, DS4_OPTICAL_POSITION_Z) = sqrt(R_SCALE*position_variance_m_sqr);
-        R_cov(DS4_OPTICAL_ANGLE_AXIS_X, DS4_OPTICAL_ANGLE_AXIS_X) = angle_axis_std_dev; 
+        R_cov = Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, DS4_MEASUREMENT_PARAMETER_COUNT>::Zero();
+		R_cov(DS4_ACCELEROMETER_X, DS4_ACCELEROMETER_X) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.x()));
+		R_cov(DS4_ACCELEROMETER_Y, DS4_ACCELEROMETER_Y) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.y()));
+		R_cov(DS4_ACCELEROMETER_Z, DS4_ACCELEROMETER_Z) = static_cast<T>(sqrt(R_SCALE*constants.position_constants.accelerometer_variance.z()));
+		R_cov(DS4_GYROSCOPE_X, DS4_GYROSCOPE_X)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.x()));
+		R_cov(DS4_GYROSCOPE_Y, DS4_GYROSCOPE_Y)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.y()));
+		R_cov(DS4_GYROSCOPE_Z, DS4_GYROSCOPE_Z)= static_cast<T>(sqrt(R_SCALE*constants.orientation_constants.gyro_variance.z()));
+		R_cov(DS4_OPTICAL_POSITION_X, DS4_OPTICAL_POSITION_X) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
+		R_cov(DS4_OPTICAL_POSITION_Y, DS4_OPTICAL_POSITION_Y) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
+		R_cov(DS4_OPTICAL_POSITION_Z, DS4_OPTICAL_POSITION_Z) = static_cast<T>(sqrt(R_SCALE*position_variance_m_sqr));
+        R_cov(DS4_OPTICAL_ANGLE_AXIS_X, DS4_OPTICAL_ANGLE_AXIS_X) = angle_axis_std_dev;
         R_cov(DS4_OPTICAL_ANGLE_AXIS_Y, DS4_OPTICAL_ANGLE_AXIS_Y) = angle_axis_std_dev;
         R_cov(DS4_OPTICAL_ANGLE_AXIS_Z, DS4_OPTICAL_ANGLE_AXIS_Z) = angle_axis_std_dev;
 	}
@@ -802,42 +849,42 @@ public:
     * @param [in] x The system state in current time-step
     * @returns The (predicted) sensor measurement for the system state
     */
-    DS4_MeasurementVector observation_function(const PoseStateVector& state, const DS4_MeasurementVector &observation_noise) const
+    DS4_MeasurementVector<T> observation_function(const PoseStateVector<T>& state, const DS4_MeasurementVector<T> &observation_noise) const
     {
-        DS4_MeasurementVector predicted_measurement;
+        DS4_MeasurementVector<T> predicted_measurement;
 
 		// Extract the observation bias
-		const DS4_MeasurementVector &observation_bias = R_mu;
-		const Eigen::Vector3d accel_bias = observation_bias.get_accelerometer();
-		const Eigen::Vector3d gyro_bias = observation_bias.get_gyroscope();
-		const Eigen::Vector3d position_bias = observation_bias.get_optical_position();
-		const Eigen::Quaterniond orientation_bias = observation_bias.get_optical_quaternion();
+		const DS4_MeasurementVector<T> observation_bias = R_mu;
+		const Vector3 accel_bias = observation_bias.get_accelerometer();
+		const Vector3 gyro_bias = observation_bias.get_gyroscope();
+		const Vector3 position_bias = observation_bias.get_optical_position();
+		const Quaternion orientation_bias = observation_bias.get_optical_quaternion();
 
 		// Extract the observations noise
-		const Eigen::Vector3d accel_noise= observation_noise.get_accelerometer();
-		const Eigen::Vector3d gyro_noise= observation_noise.get_gyroscope();
-		const Eigen::Vector3d position_noise= observation_noise.get_optical_position();
-		const Eigen::Quaterniond orientation_noise= observation_noise.get_optical_quaternion();
+		const Vector3 accel_noise= observation_noise.get_accelerometer();
+		const Vector3 gyro_noise= observation_noise.get_gyroscope();
+		const Vector3 position_noise= observation_noise.get_optical_position();
+		const Quaternion orientation_noise= observation_noise.get_optical_quaternion();
 
         // Use the position and orientation from the state for predictions
-        const Eigen::Vector3d position= state.get_position_meters();
-        const Eigen::Quaterniond orientation= state.get_quaternion();
+        const Vector3 position= state.get_position_meters();
+        const Quaternion orientation= state.get_quaternion();
 
 		// Accelerometer = (linear acceleration + gravity) transformed to controller frame.
-        const Eigen::Vector3d gravity_accel_g_units= -identity_gravity_direction;
-        const Eigen::Vector3d linear_accel_g_units= state.get_linear_acceleration_m_per_sec_sqr() * k_ms2_to_g_units;
-        const Eigen::Vector3d accel_world= linear_accel_g_units + gravity_accel_g_units;
-        const Eigen::Quaterniond accel_world_quat(0.f, accel_world.x(), accel_world.y(), accel_world.z());
+        const Vector3 gravity_accel_g_units= -identity_gravity_direction;
+        const Vector3 linear_accel_g_units= state.get_linear_acceleration_m_per_sec_sqr() * static_cast<T>(k_ms2_to_g_units);
+        const Vector3 accel_world= linear_accel_g_units + gravity_accel_g_units;
+        const Quaternion accel_world_quat(0, accel_world.x(), accel_world.y(), accel_world.z());
 
         // Put the accelerometer prediction into the local space of the controller
-        const Eigen::Vector3d accel_local= orientation*(accel_world_quat*orientation.conjugate()).vec();
+        const Vector3 accel_local= orientation*(accel_world_quat*orientation.conjugate()).vec();
 
         // Gyroscope = angular velocity (both rad/sec)
-        const Eigen::Vector3d gyro_local= state.get_angular_velocity_rad_per_sec(); 
+        const Vector3 gyro_local= state.get_angular_velocity_rad_per_sec();
 
         // Save the predictions into the measurement vector
         predicted_measurement.set_accelerometer(accel_local + accel_bias + accel_noise);
-        predicted_measurement.set_gyroscope(gyro_local + gyro_noise + gyro_noise);
+        predicted_measurement.set_gyroscope(gyro_local + gyro_bias + gyro_noise);
         predicted_measurement.set_optical_position(position + position_bias + position_noise);
         predicted_measurement.set_optical_quaternion(
 			(orientation_bias*orientation_noise*orientation).normalized());
@@ -846,40 +893,40 @@ public:
     }
 
 public:
-    Eigen::Vector3d identity_gravity_direction;
+    Vector3 identity_gravity_direction;
 
 	//! Measurement noise mean
-	Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, 1> R_mu;
+	Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, 1> R_mu;
 
 	//! Measurement noise covariance
-	Eigen::Matrix<double, DS4_MEASUREMENT_PARAMETER_COUNT, DS4_MEASUREMENT_PARAMETER_COUNT> R_cov;
+	Eigen::Matrix<T, DS4_MEASUREMENT_PARAMETER_COUNT, DS4_MEASUREMENT_PARAMETER_COUNT> R_cov;
 };
 
-template <int S_DIM, int Q_DIM, int R_DIM>
+template <typename T, int S_DIM, int Q_DIM, int R_DIM>
 class SigmaPointWeights
 {
 public:
 	static const int L_DIM = 1 + 2*S_DIM + 2*Q_DIM + 2*R_DIM;
 
 	/// Scaling factor for the sigma points
-	double zeta;
+	T zeta;
 
 	/// Sigma weights (m)
-	Eigen::Matrix<double, L_DIM, 1> wm;
+	Eigen::Matrix<T, L_DIM, 1> wm;
 
 	/// Sigma weights (c)
-	Eigen::Matrix<double, L_DIM, 1> wc;
+	Eigen::Matrix<T, L_DIM, 1> wc;
 
-	double w_qr;
-	double w_cholup;
+	T w_qr;
+	T w_cholup;
 
 	SigmaPointWeights()
 	{
-		zeta = 0.0;
-		wm = Eigen::Matrix<double, L_DIM, 1>::Zero();
-		wc = Eigen::Matrix<double, L_DIM, 1>::Zero();
-		w_qr = 0.0;
-		w_cholup = 0.0;
+		zeta = 0;
+		wm = Eigen::Matrix<T, L_DIM, 1>::Zero();
+		wc = Eigen::Matrix<T, L_DIM, 1>::Zero();
+		w_qr = 0;
+		w_cholup = 0;
 	}
 
 	/**
@@ -888,7 +935,10 @@ public:
 	* @param [in] kappa Secondary scaling parameter (usually 0)
 	*/
 	void init(double alpha, double beta, double kappa)
-	{	
+	{
+		// The weights get computed in double whatever the filter precision,
+		// so a float filter only differs from a double one by how it accumulates them.
+
 		// Compute the augmented state size
 		// TODO: this isn't the state size
 		const double L = static_cast<double>(S_DIM + Q_DIM + R_DIM);
@@ -899,7 +949,7 @@ public:
 		double lambda = alpha * alpha * (L + kappa) - L;
 
 		// Scaling factor for sigma points.
-		zeta = sqrt(L + lambda);
+		zeta = static_cast<T>(sqrt(L + lambda));
 
 		// Make sure L != -lambda to avoid division by zero
 		assert(fabs(L + lambda) > 1e-6);
@@ -910,15 +960,15 @@ public:
 		// Fill in the mean-weights
 		double wm_0 = lambda / (L + lambda);
 		double wm_rest = 0.5 / (L + lambda);
-			
+
 		// Make sure wm_rest > 0 to avoid square-root of negative number
 		assert(wm_rest > 0.0);
 
 		// wm = weights for calculating mean(both process and observation)
-		wm[0] = wm_0;
+		wm[0] = static_cast<T>(wm_0);
 		for (int point_index = 1; point_index < L_DIM; ++point_index)
 		{
-			wm[point_index] = wm_rest;
+			wm[point_index] = static_cast<T>(wm_rest);
 		}
 
 		// Fill in the covariance-weights
@@ -926,23 +976,27 @@ public:
 		double wc_rest = wm_rest;
 
 		// wc = weights for calculating covariance(proc., obs., proc - obs)
-		wc[0] = wc_0;
+		wc[0] = static_cast<T>(wc_0);
 		for (int point_index = 1; point_index < L_DIM; ++point_index)
 		{
-			wc[point_index] = wc_rest;
+			wc[point_index] = static_cast<T>(wc_rest);
 		}
 
 		// For SRUKF, we also need sqrt of wc_rest for chol update.
-		w_qr = sqrt(wc[1]);
-		w_cholup = sqrt(fabs(wc(0)));
+		w_qr = static_cast<T>(sqrt(wc_rest));
+		w_cholup = static_cast<T>(sqrt(fabs(wc_0)));
 	}
 };
 
 // Specialized Square Root Unscented Kalman Filter (SR-UKF)
-template<class MeasurementModelType, class Measurement>
+// Every matrix is fixed size, so nothing gets allocated once the filter is constructed.
+// The scalar type is float for the controllers, double is only kept around as a numerical reference.
+template<typename T, class MeasurementModelType, class Measurement>
 class PoseSRUFK
 {
 public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
 	// State vector: posx, velx, accx, posy, vely, accy, posz, velz, accz, qw, qx, qy, qz, avelx, avely, avelz
 	// Units: pos: m, vel: m/s, acc: m/s^2, orient. in quat, avel: rad/s
 	static const int X_DIM = STATE_PARAMETER_COUNT;
@@ -959,39 +1013,53 @@ public:
 	static const int L_DIM = SIGMA_POINT_COUNT + 2*Q_DIM + 2*R_DIM;
 
 	//! Type of the state vector
-	typedef PoseStateVector State;
-        
+	typedef PoseStateVector<T> State;
+	typedef PoseNoiseVector<T> Noise;
+	typedef Eigen::Matrix<T, 3, 1> Vector3;
+	typedef Eigen::Quaternion<T> Quaternion;
+
 	//! Estimated state
 	State x;
 
 	//! Lower-triangular Cholesky factor of state covariance
-	Eigen::Matrix<double, S_DIM, S_DIM> S;
+	Eigen::Matrix<T, S_DIM, S_DIM> S;
 
 	//! Process noise mean
-	PoseNoiseVector Q_mu;
+	Noise Q_mu;
 
 	//! The "square root" of the process noise covariance a.k.a. the lower part of the Choleskly
-	Eigen::Matrix<double, Q_DIM, Q_DIM> Q_cov;
+	Eigen::Matrix<T, Q_DIM, Q_DIM> Q_cov;
 
 	MeasurementModelType measurement_model;
 
-	SigmaPointWeights<S_DIM, Q_DIM, R_DIM> W;
+	SigmaPointWeights<T, S_DIM, Q_DIM, R_DIM> W;
+
+	// Cholesky workspace for the process noise covariance, kept so re-initializing doesn't allocate
+	Eigen::LLT<Eigen::Matrix<T, Q_DIM, Q_DIM> > Q_cov_llt;
+
+	// Cached sigma point spread: the zeta scaled columns of S.
+	// Only changes along with S (see refresh_sigma_point_spread()), not every predict().
+	Eigen::Matrix<T, S_DIM, S_DIM> zS;
+
+	// Cached process noise sigma offsets: [zeta*Q_cov | negated zeta*Q_cov].
+	// Q_cov is fixed after init(), so these get computed once there.
+	Eigen::Matrix<T, Q_DIM, 2*Q_DIM> zQ;
 
 	// Sigma points at time t = k - 1
-	Eigen::Matrix<double, X_DIM, SIGMA_POINT_COUNT> X_t;
+	Eigen::Matrix<T, X_DIM, SIGMA_POINT_COUNT> X_t;
 
 	// Augmented Sigma points propagated through process function to time k
-	Eigen::Matrix<double, X_DIM, L_DIM> X_k;
+	Eigen::Matrix<T, X_DIM, L_DIM> X_k;
 
 	// State estimate = weighted sum of sigma points
-	PoseStateVector x_k;
+	State x_k;
 
 	// Propagated sigma point residuals = (sp - x_k)
-	Eigen::Matrix<double, S_DIM, L_DIM> X_k_r;
+	Eigen::Matrix<T, S_DIM, L_DIM> X_k_r;
 
 	// Upper - triangular of propagated sp covariance
-	Eigen::Matrix<double, S_DIM, S_DIM > Sx_k;
-                    
+	Eigen::Matrix<T, S_DIM, S_DIM > Sx_k;
+
 public:
 	PoseSRUFK()
 	{
@@ -1000,15 +1068,17 @@ public:
 		S.setIdentity();
 		Q_mu.setZero();
 		Q_cov.setIdentity();
+		zS.setZero();
+		zQ.setZero();
 	}
 
 	void init(
-		const PoseFilterConstants &constants, 
-		const Eigen::Vector3f &position, 
+		const PoseFilterConstants &constants,
+		const Eigen::Vector3f &position,
 		const Eigen::Quaternionf &orientation)
 	{
-		const double mean_position_dT = constants.position_constants.mean_update_time_delta;
-		//const double mean_orientation_dT = constants.position_constants.mean_update_time_delta;
+		const T mean_position_dT = static_cast<T>(constants.position_constants.mean_update_time_delta);
+		//const T mean_orientation_dT = constants.position_constants.mean_update_time_delta;
 
 		// Start off using the maximum variance values
 		//const Eigen::Vector3f position_variance =
@@ -1019,36 +1089,57 @@ public:
 			//	constants.orientation_constants.max_orientation_variance) * 0.5f* Q_SCALE;
 
 		// TODO: Initial guess at state covariance square root from filter constants?
-		S = Eigen::Matrix<double, S_DIM, S_DIM>::Identity() * 0.01;
+		S = Eigen::Matrix<T, S_DIM, S_DIM>::Identity() * static_cast<T>(0.01);
 
 		// Process noise should be mean-zero, I think.
-		Q_mu = Eigen::Matrix<double, Q_DIM, 1>::Zero();
+		Q_mu = Eigen::Matrix<T, Q_DIM, 1>::Zero();
 
 		// Initialize the process covariance matrix Q
-		Eigen::Matrix<double, Q_DIM, Q_DIM> Q_cov_init=
-			Eigen::Matrix<double, Q_DIM, Q_DIM>::Zero();
-		process_3rd_order_noise(mean_position_dT, Q_SCALE, POSITION_X, Q_cov_init);
-		process_3rd_order_noise(mean_position_dT, Q_SCALE, POSITION_Y, Q_cov_init);
-		process_3rd_order_noise(mean_position_dT, Q_SCALE, POSITION_Z, Q_cov_init);
-		//process_2nd_order_noise(mean_orientation_dT, Q_SCALE, ANGLE_AXIS_X, Q_cov_init);
-		//process_2nd_order_noise(mean_orientation_dT, Q_SCALE, ANGLE_AXIS_Y, Q_cov_init);
-		//process_2nd_order_noise(mean_orientation_dT, Q_SCALE, ANGLE_AXIS_Z, Q_cov_init);
+		Eigen::Matrix<T, Q_DIM, Q_DIM> Q_cov_init=
+			Eigen::Matrix<T, Q_DIM, Q_DIM>::Zero();
+		process_3rd_order_noise<T>(mean_position_dT, static_cast<T>(Q_SCALE), POSITION_X, Q_cov_init);
+		process_3rd_order_noise<T>(mean_position_dT, static_cast<T>(Q_SCALE), POSITION_Y, Q_cov_init);
+		process_3rd_order_noise<T>(mean_position_dT, static_cast<T>(Q_SCALE), POSITION_Z, Q_cov_init);
+		//process_2nd_order_noise<T>(mean_orientation_dT, static_cast<T>(Q_SCALE), ANGLE_AXIS_X, Q_cov_init);
+		//process_2nd_order_noise<T>(mean_orientation_dT, static_cast<T>(Q_SCALE), ANGLE_AXIS_Y, Q_cov_init);
+		//process_2nd_order_noise<T>(mean_orientation_dT, static_cast<T>(Q_SCALE), ANGLE_AXIS_Z, Q_cov_init);
 		//HACK: Overwrite orientation/angvel process noise.
-//		Q_cov_init.block<6, 6>(9, 9) = Eigen::Matrix<double, 6, 6>::Identity()*0.1;
+//		Q_cov_init.template block<6, 6>(9, 9) = Eigen::Matrix<T, 6, 6>::Identity()*0.1;
 
 		// Compute the std-deviation Q matrix a.k.a. the sqrt of Q_cov_init a.k.a the Cholesky
-		Q_cov= Q_cov_init.llt().matrixL();
+		Q_cov_llt.compute(Q_cov_init);
+		Q_cov= Q_cov_llt.matrixL();
 
 		// Initialize the measurement noise
 		measurement_model.init(constants);
 
 		// Set the initial state
 		x.setZero();
-		x.set_position_meters(position.cast<double>());
-		x.set_quaternion(orientation.cast<double>());
+		x.set_position_meters(position.cast<T>());
+		x.set_quaternion(orientation.cast<T>());
 
 		//%% 1. Initialize the sigma point weights
 		W.init(k_ukf_alpha, k_ukf_beta, k_ukf_kappa);
+
+		// The process noise sigma offsets only depend on Q_cov and the weights
+		for (int Q_col = 0; Q_col < Q_DIM; ++Q_col)
+		{
+			const Noise zQ_col = Q_cov.col(Q_col) * W.zeta;
+
+			zQ.col(Q_col) = zQ_col;
+			zQ.col(Q_DIM + Q_col) = zQ_col.negate();
+		}
+
+		refresh_sigma_point_spread();
+	}
+
+	/**
+	* @brief Recomputes the cached zeta scaled state covariance square root.
+	* Needs to be called whenever S changes.
+	*/
+	void refresh_sigma_point_spread()
+	{
+		zS = S * W.zeta;
 	}
 
 	/**
@@ -1063,61 +1154,61 @@ public:
 	* @param [in] process_noise The control vector input
 	* @returns The (predicted) system state in the next time-step
 	*/
-	PoseStateVector process_function(
-		const PoseStateVector& old_state,  
-		const PoseNoiseVector& zQ_cov,
-		const float deltaTime) const
+	State process_function(
+		const State& old_state,
+		const Noise& zQ_cov,
+		const T deltaTime) const
 	{
 		//! Predicted state vector after transition
-		PoseStateVector new_state;
+		State new_state;
 
 		// Extract parameters from the old state
-		const Eigen::Vector3d old_position = old_state.get_position_meters();
-		const Eigen::Vector3d old_linear_velocity = old_state.get_linear_velocity_m_per_sec();
-		const Eigen::Vector3d old_linear_acceleration = old_state.get_linear_acceleration_m_per_sec_sqr();
-		const Eigen::Quaterniond old_orientation = old_state.get_quaternion();
-		const Eigen::Vector3d old_angular_velocity = old_state.get_angular_velocity_rad_per_sec();
+		const Vector3 old_position = old_state.get_position_meters();
+		const Vector3 old_linear_velocity = old_state.get_linear_velocity_m_per_sec();
+		const Vector3 old_linear_acceleration = old_state.get_linear_acceleration_m_per_sec_sqr();
+		const Quaternion old_orientation = old_state.get_quaternion();
+		const Vector3 old_angular_velocity = old_state.get_angular_velocity_rad_per_sec();
 
 		// Extract parameters from process noise mean
-		const Eigen::Vector3d position_bias = Q_mu.get_position_noise();
-		const Eigen::Vector3d linear_velocity_bias = Q_mu.get_linear_velocity_noise();
-		const Eigen::Vector3d linear_acceleration_bias = Q_mu.get_linear_acceleration_noise();
-		const Eigen::Quaterniond orientation_bias = Q_mu.get_quaternion_noise();
-		const Eigen::Vector3d angular_velocity_bias = Q_mu.get_angular_velocity_noise();
+		const Vector3 position_bias = Q_mu.get_position_noise();
+		const Vector3 linear_velocity_bias = Q_mu.get_linear_velocity_noise();
+		const Vector3 linear_acceleration_bias = Q_mu.get_linear_acceleration_noise();
+		const Quaternion orientation_bias = Q_mu.get_quaternion_noise();
+		const Vector3 angular_velocity_bias = Q_mu.get_angular_velocity_noise();
 
 		// Extract parameters from process noise variance
-		const Eigen::Vector3d position_noise = zQ_cov.get_position_noise();
-		const Eigen::Vector3d linear_velocity_noise = zQ_cov.get_linear_velocity_noise();
-		const Eigen::Vector3d linear_acceleration_noise = zQ_cov.get_linear_acceleration_noise();
-		const Eigen::Quaterniond orientation_noise = zQ_cov.get_quaternion_noise();
-		const Eigen::Vector3d angular_velocity_noise = zQ_cov.get_angular_velocity_noise();
+		const Vector3 position_noise = zQ_cov.get_position_noise();
+		const Vector3 linear_velocity_noise = zQ_cov.get_linear_velocity_noise();
+		const Vector3 linear_acceleration_noise = zQ_cov.get_linear_acceleration_noise();
+		const Quaternion orientation_noise = zQ_cov.get_quaternion_noise();
+		const Vector3 angular_velocity_noise = zQ_cov.get_angular_velocity_noise();
 
 		// Compute the position state update
-		const Eigen::Vector3d new_position =
+		const Vector3 new_position =
 			old_position
 			+ old_linear_velocity*deltaTime
-			+ old_linear_acceleration*deltaTime*deltaTime*0.5f
+			+ old_linear_acceleration*deltaTime*deltaTime*static_cast<T>(0.5)
 			+ position_bias
 			+ position_noise;
-		const Eigen::Vector3d new_linear_velocity = 
-			old_linear_velocity 
+		const Vector3 new_linear_velocity =
+			old_linear_velocity
 			+ old_linear_acceleration*deltaTime
 			+ linear_velocity_bias
 			+ linear_velocity_noise;
-		const Eigen::Vector3d new_linear_acceleration = 
+		const Vector3 new_linear_acceleration =
 			old_linear_acceleration
 			+ linear_acceleration_bias
 			+ linear_acceleration_noise;
-		const Eigen::Vector3d new_angular_velocity =
+		const Vector3 new_angular_velocity =
 			old_angular_velocity
 			+ angular_velocity_bias
 			+ angular_velocity_noise;
 
 		// Compute the orientation update
 		// From Kraft or Enayati:
-		const Eigen::Quaterniond q_delta = eigen_angle_axis_to_quaterniond(old_angular_velocity * deltaTime);
-		const Eigen::Quaterniond new_orientation = 
-			(old_orientation 
+		const Quaternion q_delta = angle_axis_vector_to_quaternion<T>(old_angular_velocity * deltaTime);
+		const Quaternion new_orientation =
+			(old_orientation
 			* q_delta
 			* orientation_bias
 			* orientation_noise).normalized();
@@ -1135,11 +1226,12 @@ public:
 	/**
 	* @brief Perform filter prediction step using control input \f$u\f$ and corresponding system model
 	*
-	* @param [in] deltaTime Seconds since the last update
+	* @param [in] delta_time Seconds since the last update
 	*/
-	void predict(const float deltaTime)
+	void predict(const float delta_time)
 	{
 		const int nsp = SIGMA_POINT_COUNT;
+		const T deltaTime = static_cast<T>(delta_time);
 
 		// In the below variables, the subscripts are as follows
 		// k is the next / predicted time point
@@ -1171,17 +1263,16 @@ public:
 
 		// The 1st sigma - point is just the state vector.
 		// Each remaining sigma - point is the state + / -the scaled sqrt covariance.
-/*
-		X_t.leftCols<1>() = x;
+		// (zS is the cached scaled sqrt cov)
+		X_t.col(0) = x;
 		for (int col_offset = 0; col_offset < S_DIM; ++col_offset)
 		{
-			// zS is scaled sqrt cov.
-			const PoseNoiseVector zS = S.block<S_DIM, 1>(0, col_offset) * W.zeta;
+			const Noise zS_col = zS.col(col_offset);
 
-			X_t.block<X_DIM, 1>(0, 1 + col_offset) = x + zS;
-			X_t.block<X_DIM, 1>(0, 1 + S_DIM + col_offset) = x - zS;
+			X_t.col(1 + col_offset) = x + zS_col;
+			X_t.col(1 + S_DIM + col_offset) = x - zS_col;
 		}
-*/
+
 		// We now have our minimal sigma points : [x x + zS x - zS]
 		// Note : We could add Q(not sqrt) to P(= SS^T) before calculating S, and
 		// before calculating the sigma points.This would eliminate the need to add
@@ -1190,53 +1281,49 @@ public:
 		// 3. Propagate sigma points through process function
 		// Note that X_k is larger than X_t because the process noise added more state vectors.
 		// [p(x_t) + Q_mu | p(x_t + zS) + Q_mu | p(x_t - zS) + Q_mu | p(x_t) + Q_mu + z*Q.cov | p(x_t) + Q_mu - z*Q_cov]
+		const Noise zero_noise = Noise::Zero();
 		for (int point_index = 0; point_index < nsp; ++point_index)
 		{
-			X_k.col(point_index) = 
+			X_k.col(point_index) =
 				process_function(
-					X_t.col(point_index), 
-					PoseNoiseVector::Zero(),
+					X_t.col(point_index),
+					zero_noise,
 					deltaTime);
 		}
-		for (int Q_col = 0; Q_col < Q_DIM; ++Q_col)
+		for (int Q_col = 0; Q_col < 2*Q_DIM; ++Q_col)
 		{
-			const PoseNoiseVector zQ = Q_cov.col(Q_col) * W.zeta;
-
 			X_k.col(nsp + Q_col) =
 				process_function(
 					x,
-					zQ,
-					deltaTime);
-			X_k.col(nsp + Q_DIM + Q_col) =
-				process_function(
-					x,
-					zQ.negate(),
+					zQ.col(Q_col),
 					deltaTime);
 		}
 
 		// Extend X_k with 2 * filt_struct.R.dim repeats of the first column
 		// This emulates the rest of the augmented matrix. It's necessary to extend
 		// it here because the weights only work with the correct number of columns.
-		PoseStateVector X_k_0 = X_k.col(0);
-//		X_k.rightCols<2 * R_DIM>() = X_k_0.replicate<1, 2*R_DIM>();
+		for (int R_col = 0; R_col < 2*R_DIM; ++R_col)
+		{
+			X_k.col(nsp + 2*Q_DIM + R_col) = X_k.col(0);
+		}
 
 		// 4. Estimate mean state from weighted sum of propagated sigma points
 		x_k = X_k * W.wm;
-		PoseStateVector::special_state_mean<L_DIM>(X_k, W.wm, x_k);
+		State::template special_state_mean<L_DIM>(X_k, W.wm, x_k);
 
 		// 5. Get residuals in S - format
 		for (int col_offset = 0; col_offset < L_DIM; ++col_offset)
 		{
-			// Subtract the states (with quaternion orientation) 
+			// Subtract the states (with quaternion orientation)
 			// and then convert to a noise vector (with an angle axis orientation)
-			X_k_r.col(col_offset) = convert_state_to_noise_vector(X_k.col(col_offset) - x_k);
+			X_k_r.col(col_offset) = convert_state_to_noise_vector<T>(X_k.col(col_offset) - x_k);
 		}
 
 		// 6. Estimate state covariance(sqrt)
 		// w_qr is scalar
 		// QR update of state Cholesky factor.
 		// w_qr and w_cholup cannot be negative
-//		Eigen::Matrix<double, L_DIM - 1, S_DIM > qr_input = (W.w_qr*X_k_r.rightCols<L_DIM - 1>()).transpose();
+//		Eigen::Matrix<T, L_DIM - 1, S_DIM > qr_input = (W.w_qr*X_k_r.template rightCols<L_DIM - 1>()).transpose();
 
 		// TODO: Use ColPivHouseholderQR
 //		Eigen::HouseholderQR<decltype(qr_input)> qr(qr_input);
@@ -1244,11 +1331,11 @@ public:
 		// Set R matrix as upper triangular square root
 		// NOTE: R matrix is stored in upper triangular half
 		// See: http://math.stackexchange.com/questions/1396308/qr-decomposition-results-in-eigen-library-differs-from-matlab
-//		Sx_k = qr.matrixQR().topLeftCorner<S_DIM, S_DIM>().triangularView<Eigen::Upper>();
+//		Sx_k = qr.matrixQR().template topLeftCorner<S_DIM, S_DIM>().template triangularView<Eigen::Upper>();
 
 		// Perform additional rank 1 update
-		float wc0_sign = static_cast<float>(sgn(W.wc(0)));
-//		Sx_k.selfadjointView<Eigen::Upper>().rankUpdate(X_k_r.leftCols<1>(), W.w_cholup*wc0_sign);
+//		T wc0_sign = static_cast<T>(sgn(W.wc(0)));
+//		Sx_k.template selfadjointView<Eigen::Upper>().rankUpdate(X_k_r.template leftCols<1>(), W.w_cholup*wc0_sign);
 	}
 
 	/**
@@ -1262,7 +1349,7 @@ public:
 		// 1. Propagate sigma points through observation function.
 		const int nsp = SIGMA_POINT_COUNT;
 		const int R_inds = (nsp - 2 * R_DIM);
-		Eigen::Matrix<double, O_DIM, L_DIM> Y_k;
+		Eigen::Matrix<T, O_DIM, L_DIM> Y_k;
 
 		// Pass the first 5 blocks of the sigma points through the observation function
 		// with zero measurement covariance applied
@@ -1293,22 +1380,22 @@ public:
 		}
 
 		// 2. Calculate observation mean.
-		Measurement y_k = Measurement::computeWeightedMeasurementAverage<L_DIM>(Y_k, W.wm);
+		Measurement y_k = Measurement::template computeWeightedMeasurementAverage<L_DIM>(Y_k, W.wm);
 
 		// 3. Calculate y - residuals.
 		// Used in observation covariance and state - observation cross - covariance for Kalman gain.
 
-		Eigen::Matrix<double, O_DIM, L_DIM>  Y_k_r;
+		Eigen::Matrix<T, O_DIM, L_DIM>  Y_k_r;
 		for (int col_offset = 0; col_offset < L_DIM; ++col_offset)
 		{
 			Y_k_r.col(col_offset)= Measurement(Y_k.col(col_offset)) - y_k;
 		}
-        
+
 		// 4. Calculate observation sqrt covariance
 		// w_qr is scalar
 		// QR update of state Cholesky factor.
 		// w_qr and w_cholup cannot be negative
-		Eigen::Matrix<double, L_DIM - 1, O_DIM> qr_input = (W.w_qr*Y_k_r.rightCols<L_DIM - 1>()).transpose();
+		Eigen::Matrix<T, L_DIM - 1, O_DIM> qr_input = (W.w_qr*Y_k_r.template rightCols<L_DIM - 1>()).transpose();
 
 		// TODO: Use ColPivHouseholderQR
 		Eigen::HouseholderQR<decltype(qr_input)> qr(qr_input);
@@ -1316,46 +1403,47 @@ public:
 		// Set R matrix as upper triangular square root
 		// NOTE: R matrix is stored in upper triangular half
 		// See: http://math.stackexchange.com/questions/1396308/qr-decomposition-results-in-eigen-library-differs-from-matlab
-		Eigen::Matrix<double, O_DIM, O_DIM > Sy_k = qr.matrixQR().topLeftCorner<O_DIM, O_DIM>().triangularView<Eigen::Upper>();
+		Eigen::Matrix<T, O_DIM, O_DIM > Sy_k = qr.matrixQR().template topLeftCorner<O_DIM, O_DIM>().template triangularView<Eigen::Upper>();
 
 		// Perform additional rank 1 update
-		float wc0_sign = (W.wc(0) > 0.f) ? 1.f : -1.f;
-		Sy_k.selfadjointView<Eigen::Upper>().rankUpdate(Y_k_r.leftCols<1>(), W.w_cholup*wc0_sign);
+		T wc0_sign = (W.wc(0) > 0) ? 1 : -1;
+		Sy_k.template selfadjointView<Eigen::Upper>().rankUpdate(Y_k_r.template leftCols<1>(), W.w_cholup*wc0_sign);
 
 		// 5. Calculate Kalman Gain
 		//First calculate state - observation cross(sqrt) covariance
-		const Eigen::Matrix<double, 1, L_DIM> wc = W.wc.transpose();
-		const Eigen::Matrix<double, S_DIM, L_DIM> wc_repl = wc.replicate<S_DIM, 1>();
-		const Eigen::Matrix<double, S_DIM, O_DIM> Pxy=
+		const Eigen::Matrix<T, 1, L_DIM> wc = W.wc.transpose();
+		const Eigen::Matrix<T, S_DIM, L_DIM> wc_repl = wc.template replicate<S_DIM, 1>();
+		const Eigen::Matrix<T, S_DIM, O_DIM> Pxy=
 			X_k_r.cwiseProduct(wc_repl).eval() * Y_k_r.transpose();
 
 		// In the Matlab code: KG = (Pxy / Sy_k')/Sy_k
-		// where "/" is the "mrdivide" operator, 
-		// x = B/A solves the system of linear equations A*x = B for x. 
+		// where "/" is the "mrdivide" operator,
+		// x = B/A solves the system of linear equations A*x = B for x.
 		// I arrived at the following through trial and error
-		Eigen::Matrix<double, O_DIM, S_DIM> numerator = Sy_k.transpose().colPivHouseholderQr().solve(Pxy.transpose());
-		Eigen::Matrix<double, S_DIM, O_DIM> KG = Sy_k.colPivHouseholderQr().solve(numerator).transpose();
+		Eigen::Matrix<T, O_DIM, S_DIM> numerator = Sy_k.transpose().colPivHouseholderQr().solve(Pxy.transpose());
+		Eigen::Matrix<T, S_DIM, O_DIM> KG = Sy_k.colPivHouseholderQr().solve(numerator).transpose();
 
-		//Eigen::Matrix<double, X_DIM, O_DIM> KG = Pxy * Sy_k.inverse();
+		//Eigen::Matrix<T, X_DIM, O_DIM> KG = Pxy * Sy_k.inverse();
 
 		// 6. Calculate innovation
 		Measurement innov = observation - y_k;
 
 		// 7. State update / correct
 		// ReBeL srukf doesn't do anything special for angles to get upd.
-		PoseStateVector upd= convert_noise_to_state_vector(KG*innov);
+		State upd= convert_noise_to_state_vector<T>(KG*innov);
 		x = x_k + upd;
 
 		// 8. Covariance update / correct
 		// This is equivalent to : Px = Px_ - KG*Py*KG';
-		Eigen::Matrix<double, S_DIM, O_DIM> cov_update_vectors = KG * Sy_k;
+		Eigen::Matrix<T, S_DIM, O_DIM> cov_update_vectors = KG * Sy_k;
 		for (int j = 0; j < O_DIM; ++j)
 		{
 			// Still UPPER
-			Sx_k.selfadjointView<Eigen::Upper>().rankUpdate(cov_update_vectors.col(j), -1.0);
+			Sx_k.template selfadjointView<Eigen::Upper>().rankUpdate(cov_update_vectors.col(j), -1);
 		}
 
 		S = Sx_k.transpose(); // LOWER sqrt-covariance saved for next predict.
+		refresh_sigma_point_spread();
 */
 	}
 };
@@ -1363,6 +1451,8 @@ public:
 class KalmanPoseFilterImpl
 {
 public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     /// Is the current fusion state valid
     bool bIsValid;
 
@@ -1372,19 +1462,28 @@ public:
 	/// True if we have seen a valid orientation measurement (>0 orientation quality)
 	bool bSeenOrientationMeasurement;
 
-    /// Quaternion measured when controller points towards camera 
+    /// Quaternion measured when controller points towards camera
     Eigen::Quaternionf reset_orientation;
 
-    /// Position that's considered the origin position 
+    /// Position that's considered the origin position
     Eigen::Vector3f origin_position; // meters
 
     /// The last published state from the filter
-	PoseStateVector state;
+	PoseStateVector<float> state;
 
 	KalmanPoseFilterImpl()
     {
     }
 
+	virtual ~KalmanPoseFilterImpl()
+	{
+	}
+
+	virtual KalmanPoseFilterImpl *clone() const = 0;
+
+	/// Copy the state of an impl of the same type and precision
+	virtual void copy_state(const KalmanPoseFilterImpl *other) = 0;
+
 	virtual void init(
 		const PoseFilterConstants &constants)
 	{
@@ -1394,7 +1493,7 @@ public:
 
 		reset_orientation = Eigen::Quaternionf::Identity();
 		origin_position = Eigen::Vector3f::Zero();
-		state = PoseStateVector::Zero();
+		state = PoseStateVector<float>::Zero();
 	}
 
 	virtual void init(
@@ -1408,16 +1507,34 @@ public:
 
         reset_orientation = Eigen::Quaternionf::Identity();
         origin_position = Eigen::Vector3f::Zero();
-		state = PoseStateVector::Zero();
-		state.set_position_meters(position.cast<double>());
-		state.set_quaternion(orientation.cast<double>());
+		state = PoseStateVector<float>::Zero();
+		state.set_position_meters(position);
+		state.set_quaternion(orientation);
     }
+
+	virtual void update(
+		const float delta_time,
+		const PoseFilterPacket &packet,
+		const PoseFilterConstants &constants) = 0;
 };
 
+template <typename T>
 class DS4KalmanPoseFilterImpl : public KalmanPoseFilterImpl
 {
 public:
-	PoseSRUFK<DS4_MeasurementModel, DS4_MeasurementVector> srukf;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	PoseSRUFK<T, DS4_MeasurementModel<T>, DS4_MeasurementVector<T> > srukf;
+
+	KalmanPoseFilterImpl *clone() const override
+	{
+		return new DS4KalmanPoseFilterImpl<T>(*this);
+	}
+
+	void copy_state(const KalmanPoseFilterImpl *other) override
+	{
+		*this = *static_cast<const DS4KalmanPoseFilterImpl<T> *>(other);
+	}
 
 	void init(
 		const PoseFilterConstants &constants) override
@@ -1434,12 +1551,107 @@ public:
 		KalmanPoseFilterImpl::init(constants, position, orientation);
 		srukf.init(constants, position, orientation);
 	}
+
+	void update(
+		const float delta_time,
+		const PoseFilterPacket &packet,
+		const PoseFilterConstants &constants) override
+	{
+		// Get the DS4 implementation specific sigma point weights and measurement model
+		DS4_MeasurementModel<T> &measurement_model = srukf.measurement_model;
+
+		if (bIsValid)
+		{
+			// Predict state for current time-step using the filters
+			srukf.predict(delta_time);
+
+			// Project the current state onto a predicted measurement as a default
+			// in case no observation is available
+			DS4_MeasurementVector<T> measurement = measurement_model.observation_function(srukf.x, DS4_MeasurementVector<T>::Zero());
+
+			// Accelerometer and gyroscope measurements are always available
+			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<T>());
+			measurement.set_gyroscope(packet.imu_gyroscope_rad_per_sec.cast<T>());
+
+			// Adjust the amount we trust the optical measurements based on the quality parameters
+			measurement_model.update_measurement_statistics(
+				constants,
+				packet.tracking_projection_area_px_sqr);
+
+			if (packet.tracking_projection_area_px_sqr > 0.f)
+			{
+				Eigen::Vector3f optical_position_meters = packet.get_optical_position_in_meters();
+
+				// Use the optical orientation measurement
+				measurement.set_optical_quaternion(packet.optical_orientation.cast<T>());
+
+				// If this is the first time we have seen the orientation, snap the orientation state
+				if (!bSeenOrientationMeasurement)
+				{
+					srukf.x.set_quaternion(packet.optical_orientation.cast<T>());
+					bSeenOrientationMeasurement= true;
+				}
+
+				// Use the optical position
+				// State internally stores position in meters
+				measurement.set_optical_position(optical_position_meters.cast<T>());
+
+				// If this is the first time we have seen the position, snap the position state
+				if (!bSeenPositionMeasurement)
+				{
+					srukf.x.set_position_meters(optical_position_meters.cast<T>());
+					bSeenPositionMeasurement= true;
+				}
+			}
+
+			// Update UKF
+			srukf.update(measurement);
+		}
+		else
+		{
+			srukf.x.setZero();
+
+			if (packet.tracking_projection_area_px_sqr > 0.f)
+			{
+				Eigen::Vector3f optical_position_meters= packet.get_optical_position_in_meters();
+
+				srukf.x.set_position_meters(optical_position_meters.cast<T>());
+				bSeenPositionMeasurement= true;
+
+				srukf.x.set_quaternion(packet.optical_orientation.cast<T>());
+				bSeenOrientationMeasurement = true;
+			}
+			else
+			{
+				srukf.x.set_position_meters(Eigen::Matrix<T, 3, 1>::Zero());
+				srukf.x.set_quaternion(Eigen::Quaternion<T>::Identity());
+			}
+
+			bIsValid= true;
+		}
+
+		// Publish the state from the filter
+		state = srukf.x.template cast<float>();
+	}
 };
 
+template <typename T>
 class PSMoveKalmanPoseFilterImpl : public KalmanPoseFilterImpl
 {
 public:
-	PoseSRUFK<PSMove_MeasurementModel, PSMove_MeasurementVector> srukf;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	PoseSRUFK<T, PSMove_MeasurementModel<T>, PSMove_MeasurementVector<T> > srukf;
+
+	KalmanPoseFilterImpl *clone() const override
+	{
+		return new PSMoveKalmanPoseFilterImpl<T>(*this);
+	}
+
+	void copy_state(const KalmanPoseFilterImpl *other) override
+	{
+		*this = *static_cast<const PSMoveKalmanPoseFilterImpl<T> *>(other);
+	}
 
 	void init(
 		const PoseFilterConstants &constants) override
@@ -1449,33 +1661,151 @@ public:
 	}
 
 	void init(
-		const PoseFilterConstants &constants, 
+		const PoseFilterConstants &constants,
 		const Eigen::Vector3f &position,
 		const Eigen::Quaternionf &orientation) override
 	{
 		KalmanPoseFilterImpl::init(constants, position, orientation);
 		srukf.init(constants, position, orientation);
 	}
+
+	void update(
+		const float delta_time,
+		const PoseFilterPacket &packet,
+		const PoseFilterConstants &constants) override
+	{
+		PSMove_MeasurementModel<T> &measurement_model = srukf.measurement_model;
+
+		if (bIsValid)
+		{
+			// Predict state for current time-step using the filters
+			srukf.predict(delta_time);
+
+			// Project the current state onto a predicted measurement as a default
+			// in case no observation is available
+			PSMove_MeasurementVector<T> measurement = measurement_model.observation_function(srukf.x, PSMove_MeasurementVector<T>::Zero());
+
+			// Accelerometer, magnetometer and gyroscope measurements are always available
+			measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<T>());
+			measurement.set_gyroscope(packet.imu_gyroscope_rad_per_sec.cast<T>());
+			measurement.set_magnetometer(packet.imu_magnetometer_unit.cast<T>());
+
+			// If available, use the optical position
+			if (packet.tracking_projection_area_px_sqr > 0.f)
+			{
+				Eigen::Vector3f optical_position= packet.get_optical_position_in_meters();
+
+				//TODO: Update measurement statistics once we get the filter working
+				//// Adjust the amount we trust the optical measurements based on the quality parameters
+				//measurement_model.update_measurement_statistics(constants, packet.tracking_projection_area);
+
+				// Assign the latest optical measurement from the packet
+				measurement.set_optical_position(optical_position.cast<T>());
+
+				// If this is the first time we have seen the position, snap the position state
+				//if (!bSeenPositionMeasurement)
+				//{
+				//	srukf.x.set_position(optical_position.cast<T>());
+				//	bSeenPositionMeasurement= true;
+				//}
+			}
+
+			// Update UKF
+			srukf.update(measurement);
+		}
+		else
+		{
+			srukf.x.setZero();
+			srukf.x.set_quaternion(Eigen::Quaternion<T>::Identity());
+
+			// We always "see" the orientation measurements for the PSMove (MARG state)
+			bSeenOrientationMeasurement= true;
+
+			if (packet.tracking_projection_area_px_sqr > 0.f)
+			{
+				Eigen::Vector3f optical_position_meters= packet.get_optical_position_in_meters();
+
+				srukf.x.set_position_meters(optical_position_meters.cast<T>());
+				bSeenPositionMeasurement= true;
+			}
+			else
+			{
+				srukf.x.set_position_meters(Eigen::Matrix<T, 3, 1>::Zero());
+			}
+
+			bIsValid= true;
+		}
+
+		// Publish the state from the filter
+		state = srukf.x.template cast<float>();
+	}
 };
 
+template <template <typename> class FilterImplType>
+static KalmanPoseFilterImpl *allocate_filter_impl(const KalmanFilterPrecision precision)
+{
+	return (precision == KalmanFilterPrecisionDouble)
+		? static_cast<KalmanPoseFilterImpl *>(new FilterImplType<double>())
+		: static_cast<KalmanPoseFilterImpl *>(new FilterImplType<float>());
+}
+
 //-- public interface --
 //-- KalmanFilterOpticalPoseARG --
-KalmanPoseFilter::KalmanPoseFilter() 
+KalmanPoseFilter::KalmanPoseFilter(const KalmanFilterPrecision precision)
     : m_filter(nullptr)
+	, m_precision(precision)
+	, m_state_time_seconds(0.0)
 {
 	m_constants.clear();
 }
 
+KalmanPoseFilter::KalmanPoseFilter(const KalmanPoseFilter &other)
+	: m_constants(other.m_constants)
+	, m_filter(other.m_filter != nullptr ? other.m_filter->clone() : nullptr)
+	, m_precision(other.m_precision)
+	, m_state_time_seconds(other.m_state_time_seconds)
+{
+}
+
+KalmanPoseFilter::~KalmanPoseFilter()
+{
+	if (m_filter != nullptr)
+	{
+		delete m_filter;
+		m_filter = nullptr;
+	}
+}
+
+KalmanPoseFilter &KalmanPoseFilter::operator=(const KalmanPoseFilter &other)
+{
+	m_constants = other.m_constants;
+	m_state_time_seconds = other.m_state_time_seconds;
+
+	if (m_filter != nullptr && other.m_filter != nullptr && m_precision == other.m_precision)
+	{
+		m_filter->copy_state(other.m_filter);
+	}
+	else
+	{
+		delete m_filter;
+		m_filter = (other.m_filter != nullptr) ? other.m_filter->clone() : nullptr;
+		m_precision = other.m_precision;
+	}
+
+	return *this;
+}
+
 bool KalmanPoseFilter::init(
 	const PoseFilterConstants &constants)
 {
 	m_constants = constants;
+	m_state_time_seconds = 0.0;
 
 	// cleanup any existing filter
 	if (m_filter != nullptr)
 	{
 		delete m_filter;
-		m_filter;
+		m_filter = nullptr;
 	}
 
 	return true;
@@ -1483,16 +1813,17 @@ bool KalmanPoseFilter::init(
 
 bool KalmanPoseFilter::init(
 	const PoseFilterConstants &constants,
-	const Eigen::Vector3f &position, 
+	const Eigen::Vector3f &position,
 	const Eigen::Quaternionf &orientation)
 {
     m_constants = constants;
+    m_state_time_seconds = 0.0;
 
     // cleanup any existing filter
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 
     return true;
@@ -1506,6 +1837,7 @@ bool KalmanPoseFilter::getIsStateValid() const
 void KalmanPoseFilter::resetState()
 {
     m_filter->init(m_constants);
+    m_state_time_seconds = 0.0;
 }
 
 void KalmanPoseFilter::recenterOrientation(const Eigen::Quaternionf& q_pose)
@@ -1516,6 +1848,27 @@ void KalmanPoseFilter::recenterOrientation(const Eigen::Quaternionf& q_pose)
     m_filter->reset_orientation = q_pose*q_inverse;
 }
 
+void KalmanPoseFilter::updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet)
+{
+	const float delta_time =
+		compute_pose_filter_time_delta(
+			m_state_time_seconds, sample_time_seconds, m_constants.orientation_constants.mean_update_time_delta);
+
+	update(delta_time, packet);
+	m_state_time_seconds = std::max(m_state_time_seconds, sample_time_seconds);
+}
+
+double KalmanPoseFilter::getStateTimeSeconds() const
+{
+	return m_state_time_seconds;
+}
+
+void KalmanPoseFilter::copyState(const IPoseFilter *other)
+{
+	assert(dynamic_cast<const KalmanPoseFilter *>(other) != nullptr);
+	*this = *static_cast<const KalmanPoseFilter *>(other);
+}
+
 bool KalmanPoseFilter::getIsPositionStateValid() const
 {
     return m_filter->bIsValid;
@@ -1532,7 +1885,7 @@ Eigen::Quaternionf KalmanPoseFilter::getOrientation(float time) const
 
     if (m_filter->bIsValid)
     {
-        const Eigen::Quaternionf state_orientation = m_filter->state.get_quaternion().cast<float>();
+        const Eigen::Quaternionf state_orientation = m_filter->state.get_quaternion();
         Eigen::Quaternionf predicted_orientation = state_orientation;
 
         if (fabsf(time) > k_real_epsilon)
@@ -1553,9 +1906,7 @@ Eigen::Quaternionf KalmanPoseFilter::getOrientation(float time) const
 
 Eigen::Vector3f KalmanPoseFilter::getAngularVelocityRadPerSec() const
 {
-	Eigen::Vector3d ang_vel= m_filter->state.get_angular_velocity_rad_per_sec();
-	
-    return ang_vel.cast<float>();
+    return m_filter->state.get_angular_velocity_rad_per_sec();
 }
 
 Eigen::Vector3f KalmanPoseFilter::getAngularAccelerationRadPerSecSqr() const
@@ -1569,8 +1920,8 @@ Eigen::Vector3f KalmanPoseFilter::getPositionCm(float time) const
 
     if (m_filter->bIsValid)
     {
-        Eigen::Vector3f state_position_meters= m_filter->state.get_position_meters().cast<float>();
-		Eigen::Vector3f state_vel_m_per_sec = m_filter->state.get_linear_velocity_m_per_sec().cast<float>();
+        Eigen::Vector3f state_position_meters= m_filter->state.get_position_meters();
+		Eigen::Vector3f state_vel_m_per_sec = m_filter->state.get_linear_velocity_m_per_sec();
         Eigen::Vector3f predicted_position_meters =
             is_nearly_zero(time)
             ? state_position_meters
@@ -1584,135 +1935,67 @@ Eigen::Vector3f KalmanPoseFilter::getPositionCm(float time) const
 
 Eigen::Vector3f KalmanPoseFilter::getVelocityCmPerSec() const
 {
-	Eigen::Vector3d vel= m_filter->state.get_linear_velocity_m_per_sec() * k_meters_to_centimeters;
-
-    return vel.cast<float>();
+    return m_filter->state.get_linear_velocity_m_per_sec() * k_meters_to_centimeters;
 }
 
 Eigen::Vector3f KalmanPoseFilter::getAccelerationCmPerSecSqr() const
 {
-    Eigen::Vector3d accel= m_filter->state.get_linear_acceleration_m_per_sec_sqr() * k_meters_to_centimeters;
-
-	return accel.cast<float>();
+	return m_filter->state.get_linear_acceleration_m_per_sec_sqr() * k_meters_to_centimeters;
 }
 
 //-- KalmanPoseFilterDS4 --
+KalmanPoseFilterDS4::KalmanPoseFilterDS4(const KalmanFilterPrecision precision)
+	: KalmanPoseFilter(precision)
+{
+}
+
 bool KalmanPoseFilterDS4::init(
 	const PoseFilterConstants &constants)
 {
 	KalmanPoseFilter::init(constants);
 
-	DS4KalmanPoseFilterImpl *filter = new DS4KalmanPoseFilterImpl();
-	filter->init(constants);
-	m_filter = filter;
+	m_filter = allocate_filter_impl<DS4KalmanPoseFilterImpl>(m_precision);
+	m_filter->init(constants);
 
 	return true;
 }
 
 bool KalmanPoseFilterDS4::init(
 	const PoseFilterConstants &constants,
-	const Eigen::Vector3f &position, 
+	const Eigen::Vector3f &position,
 	const Eigen::Quaternionf &orientation)
 {
     KalmanPoseFilter::init(constants, position, orientation);
 
-    DS4KalmanPoseFilterImpl *filter = new DS4KalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
+    m_filter = allocate_filter_impl<DS4KalmanPoseFilterImpl>(m_precision);
+    m_filter->init(constants, position, orientation);
 
     return true;
 }
 
 void KalmanPoseFilterDS4::update(const float delta_time, const PoseFilterPacket &packet)
 {
-	// Get the DS4 implementation specific sigma point weights and measurement model
-	DS4KalmanPoseFilterImpl *ds4FilterImpl = static_cast<DS4KalmanPoseFilterImpl *>(m_filter);
-	PoseSRUFK<DS4_MeasurementModel, DS4_MeasurementVector> &srukf = ds4FilterImpl->srukf;
-	DS4_MeasurementModel &measurement_model = srukf.measurement_model;
-
-	if (m_filter->bIsValid)
-    {
-		// Predict state for current time-step using the filters
-        srukf.predict(delta_time);
-
-        // Project the current state onto a predicted measurement as a default
-        // in case no observation is available
-        DS4_MeasurementVector measurement = measurement_model.observation_function(srukf.x, DS4_MeasurementVector::Zero());
-
-        // Accelerometer and gyroscope measurements are always available
-        measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<double>());
-        measurement.set_gyroscope(packet.imu_gyroscope_rad_per_sec.cast<double>());
-
-		// Adjust the amount we trust the optical measurements based on the quality parameters
-		measurement_model.update_measurement_statistics(
-			m_constants,
-			packet.tracking_projection_area_px_sqr);
-
-        if (packet.tracking_projection_area_px_sqr > 0.f)
-        {
-			Eigen::Vector3f optical_position_meters = packet.get_optical_position_in_meters();
-
-            // Use the optical orientation measurement
-            measurement.set_optical_quaternion(packet.optical_orientation.cast<double>());
-
-			// If this is the first time we have seen the orientation, snap the orientation state
-			if (!m_filter->bSeenOrientationMeasurement)
-			{
-				srukf.x.set_quaternion(packet.optical_orientation.cast<double>());
-				m_filter->bSeenOrientationMeasurement= true;
-			}
-
-            // Use the optical position
-            // State internally stores position in meters
-            measurement.set_optical_position(optical_position_meters.cast<double>());
-
-			// If this is the first time we have seen the position, snap the position state
-			if (!m_filter->bSeenPositionMeasurement)
-			{
-				srukf.x.set_position_meters(optical_position_meters.cast<double>());
-				m_filter->bSeenPositionMeasurement= true;
-			}
-        }
-
-        // Update UKF
-        srukf.update(measurement);
-    }
-    else
-    {
-        srukf.x.setZero();
-
-		if (packet.tracking_projection_area_px_sqr > 0.f)
-		{
-			Eigen::Vector3f optical_position_meters= packet.get_optical_position_in_meters();
-
-			srukf.x.set_position_meters(optical_position_meters.cast<double>());
-			m_filter->bSeenPositionMeasurement= true;
-
-			srukf.x.set_quaternion(packet.optical_orientation.cast<double>());
-			m_filter->bSeenOrientationMeasurement = true;
-		}
-		else
-		{
-			srukf.x.set_position_meters(Eigen::Vector3d::Zero());
-			srukf.x.set_quaternion(Eigen::Quaterniond::Identity());
-		}
-
-        m_filter->bIsValid= true;
-    }
+	m_filter->update(delta_time, packet, m_constants);
+}
 
-	// Publish the state from the filter
-	m_filter->state = srukf.x;
+IPoseFilter *KalmanPoseFilterDS4::clone() const
+{
+	return new KalmanPoseFilterDS4(*this);
 }
 
 //-- PSMovePoseKalmanFilter --
+KalmanPoseFilterPSMove::KalmanPoseFilterPSMove(const KalmanFilterPrecision precision)
+	: KalmanPoseFilter(precision)
+{
+}
+
 bool KalmanPoseFilterPSMove::init(
 	const PoseFilterConstants &constants)
 {
 	KalmanPoseFilter::init(constants);
 
-	PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
-	filter->init(constants);
-	m_filter = filter;
+	m_filter = allocate_filter_impl<PSMoveKalmanPoseFilterImpl>(m_precision);
+	m_filter->init(constants);
 
 	return true;
 }
@@ -1724,126 +2007,139 @@ bool KalmanPoseFilterPSMove::init(
 {
     KalmanPoseFilter::init(constants, position, orientation);
 
-    PSMoveKalmanPoseFilterImpl *filter = new PSMoveKalmanPoseFilterImpl();
-    filter->init(constants, position, orientation);
-    m_filter = filter;
+    m_filter = allocate_filter_impl<PSMoveKalmanPoseFilterImpl>(m_precision);
+    m_filter->init(constants, position, orientation);
 
     return true;
 }
 
 void KalmanPoseFilterPSMove::update(const float delta_time, const PoseFilterPacket &packet)
 {
-	PSMoveKalmanPoseFilterImpl *psmoveFilterImpl = static_cast<PSMoveKalmanPoseFilterImpl *>(m_filter);
-	PoseSRUFK<PSMove_MeasurementModel, PSMove_MeasurementVector> &srukf = psmoveFilterImpl->srukf;
-	PSMove_MeasurementModel &measurement_model = srukf.measurement_model;
-
-    if (m_filter->bIsValid)
-    {
-		// Predict state for current time-step using the filters
-        srukf.predict(delta_time);
-
-        // Project the current state onto a predicted measurement as a default
-        // in case no observation is available
-        PSMove_MeasurementVector measurement = measurement_model.observation_function(srukf.x, PSMove_MeasurementVector::Zero());
-
-        // Accelerometer, magnetometer and gyroscope measurements are always available
-        measurement.set_accelerometer(packet.imu_accelerometer_g_units.cast<double>());
-        measurement.set_gyroscope(packet.imu_gyroscope_rad_per_sec.cast<double>());
-        measurement.set_magnetometer(packet.imu_magnetometer_unit.cast<double>());
-
-        // If available, use the optical position
-        if (packet.tracking_projection_area_px_sqr > 0.f)
-        {
-			Eigen::Vector3f optical_position= packet.get_optical_position_in_meters();
+	m_filter->update(delta_time, packet, m_constants);
+}
 
-			//TODO: Update measurement statistics once we get the filter working
-			//// Adjust the amount we trust the optical measurements based on the quality parameters
-			//measurement_model.update_measurement_statistics(m_constants, packet.tracking_projection_area);
+IPoseFilter *KalmanPoseFilterPSMove::clone() const
+{
+	return new KalmanPoseFilterPSMove(*this);
+}
 
-			// Assign the latest optical measurement from the packet
-            measurement.set_optical_position(optical_position.cast<double>());
+//-- Private functions --
+template <typename T>
+void process_3rd_order_noise(
+    const T dT,
+    const T var,
+    const int state_index,
+	Eigen::Matrix<T, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q)
+{
+    const T dT_2 = dT*dT;
+	const T dT_3 = dT_2*dT;
+	const T dT_4 = dT_2*dT_2;
+	const T dT_5 = dT_3*dT_2;
+	const T dT_6 = dT_3*dT_3;
+	const T dT_7 = dT_4*dT_3;
+
+    const T q7 = var * dT_7;
+    const T q6 = var * dT_6;
+    const T q5 = var * dT_5;
+    const T q4 = var * dT_4;
+    const T q3 = var * dT_3;
 
-			// If this is the first time we have seen the position, snap the position state
-			//if (!m_filter->bSeenPositionMeasurement)
-			//{
-			//	srukf.x.set_position(optical_position.cast<double>());
-			//	m_filter->bSeenPositionMeasurement= true;
-			//}
-        }
+    const int &i= state_index;
+    Q(i+0,i+0) = q7/252; Q(i+0,i+1) = q6/72; Q(i+0,i+2) = q5/30;
+    Q(i+1,i+0) = q6/72;  Q(i+1,i+1) = q5/20; Q(i+1,i+2) = q4/8;
+    Q(i+2,i+0) = q5/30;  Q(i+2,i+1) = q4/8;  Q(i+2,i+2) = q3/3;
+}
 
-        // Update UKF
-        srukf.update(measurement);
-    }
-    else
-    {
-        srukf.x.setZero();
-        srukf.x.set_quaternion(Eigen::Quaterniond::Identity());
+template <typename T>
+void process_2nd_order_noise(
+	const T dT,
+	const T var,
+	const int state_index,
+	Eigen::Matrix<T, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q)
+{
+    const T dT_2 = dT*dT;
+	const T dT_3 = dT_2*dT;
+	const T dT_4 = dT_2*dT_2;
+	const T dT_5 = dT_3*dT_2;
 
-		// We always "see" the orientation measurements for the PSMove (MARG state)
-		m_filter->bSeenOrientationMeasurement= true;
+    const T q5 = var * dT_5;
+    const T q4 = var * dT_4;
+    const T q3 = var * dT_3;
 
-		if (packet.tracking_projection_area_px_sqr > 0.f)
-		{
-			Eigen::Vector3f optical_position_meters= packet.get_optical_position_in_meters();
+    // Q = [.5dt^2, dt]*[.5dt^2, dt]^T * variance
+    const int &i= state_index;
+    Q(i+0,i+0) = q5/20; Q(i+0,i+1) = q4/8;
+    Q(i+1,i+0) = q4/8;  Q(i+1,i+1) = q3/3;
+}
 
-			srukf.x.set_position_meters(optical_position_meters.cast<double>());
-			m_filter->bSeenPositionMeasurement= true;
-		}
-		else
-		{
-			srukf.x.set_position_meters(Eigen::Vector3d::Zero());
-		}
+template <typename T>
+T normalize_vector3_with_zero_default(Eigen::Matrix<T, 3, 1> &v)
+{
+	const T length = v.norm();
 
-        m_filter->bIsValid= true;
-    }
+	// Same cutoff as eigen_vector3d_normalize_with_default(), whatever the precision
+	if (length > static_cast<T>(0.0001))
+	{
+		v /= length;
+	}
+	else
+	{
+		v.setZero();
+	}
 
-	// Publish the state from the filter
-	m_filter->state = srukf.x;
+	return length;
 }
 
-//-- Private functions --
-void process_3rd_order_noise(
-    const double dT,
-    const double var,
-    const int state_index,
-	Eigen::Matrix<double, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q)
+template <typename T>
+Eigen::Quaternion<T> angle_axis_vector_to_quaternion(const Eigen::Matrix<T, 3, 1> &angle_axis)
 {
-    const double dT_2 = dT*dT;
-	const double dT_3 = dT_2*dT;
-	const double dT_4 = dT_2*dT_2;
-	const double dT_5 = dT_3*dT_2;
-	const double dT_6 = dT_3*dT_3;
-	const double dT_7 = dT_4*dT_3;
-
-    const double q7 = var * dT_7;
-    const double q6 = var * dT_6;
-    const double q5 = var * dT_5;
-    const double q4 = var * dT_4;
-    const double q3 = var * dT_3;
+	Eigen::Matrix<T, 3, 1> unit_axis = angle_axis;
+	const T angle = normalize_vector3_with_zero_default<T>(unit_axis);
 
-    const int &i= state_index;
-    Q(i+0,i+0) = q7/252.0; Q(i+0,i+1) = q6/72.0; Q(i+0,i+2) = q5/30.0;
-    Q(i+1,i+0) = q6/72.0;  Q(i+1,i+1) = q5/20.0; Q(i+1,i+2) = q4/8.0;
-    Q(i+2,i+0) = q5/30.0;  Q(i+2,i+1) = q4/8.0;  Q(i+2,i+2) = q3/3.0;
+	return Eigen::Quaternion<T>(Eigen::AngleAxis<T>(angle, unit_axis));
 }
 
-void process_2nd_order_noise(
-	const double dT, 
-	const double var, 
-	const int state_index, 
-	Eigen::Matrix<double, NOISE_PARAMETER_COUNT, NOISE_PARAMETER_COUNT> &Q)
+// Same math as eigen_quaternion_compute_weighted_average(),
+// but with the 4x4 accumulated directly instead of through a dynamically sized 4xN matrix,
+// and a fixed size symmetric eigen solver, so nothing gets allocated per sigma point average.
+template <typename T, int PointCount>
+void compute_weighted_quaternion_average(
+	const Eigen::Quaternion<T> *quaternions,
+	const T *weights,
+	Eigen::Quaternion<T> *out_result)
 {
-    const double dT_2 = dT*dT;
-	const double dT_3 = dT_2*dT;
-	const double dT_4 = dT_2*dT_2;
-	const double dT_5 = dT_3*dT_2;
+	if (PointCount == 1)
+	{
+		*out_result= quaternions[0];
+		return;
+	}
 
-    const double q5 = var * dT_5;
-    const double q4 = var * dT_4;
-    const double q3 = var * dT_3;
+	// http://stackoverflow.com/questions/12374087/average-of-multiple-quaternions
+	Eigen::Matrix<T, 4, 4> M= Eigen::Matrix<T, 4, 4>::Zero();
+	for (int index = 0; index < PointCount; ++index)
+	{
+		const Eigen::Quaternion<T> &sample = quaternions[index];
+		const T signed_weight= weights[index];
+		const T unsigned_weight= fabs(signed_weight);
+
+		// For negative weights, use the conjugate of the quaternion
+		// (i.e. flip the rotation axis)
+		const Eigen::Matrix<T, 4, 1> q(
+			sample.w() * unsigned_weight,
+			sample.x() * signed_weight,
+			sample.y() * signed_weight,
+			sample.z() * signed_weight);
+
+		M.noalias() += q * q.transpose();
+	}
 
-    // Q = [.5dt^2, dt]*[.5dt^2, dt]^T * variance
-    const int &i= state_index;
-    Q(i+0,i+0) = q5/20.0; Q(i+0,i+1) = q4/8.0;
-    Q(i+1,i+0) = q4/8.0;  Q(i+1,i+1) = q3/3.0;
+	// M is symmetric: the eigenvalues come out sorted in increasing order
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix<T, 4, 4> > eigsolv(M);
+	if (eigsolv.info() == Eigen::Success)
+	{
+		const Eigen::Matrix<T, 4, 1> largest_eigenvector = eigsolv.eigenvectors().col(3);
+
+		*out_result= Eigen::Quaternion<T>(
+			largest_eigenvector(0), largest_eigenvector(1), largest_eigenvector(2), largest_eigenvector(3)).normalized();
+	}
 }
@@ -3,11 +3,23 @@
 
 #include "PoseFilterInterface.h"
 
+/// Scalar type the square root UKF runs its fixed size matrices in.
+/// Float is what the controllers use, double is kept as a reference to check float against.
+enum KalmanFilterPrecision
+{
+	KalmanFilterPrecisionFloat,
+	KalmanFilterPrecisionDouble
+};
+
 /// Abstract Kalman Pose filter for controllers
 class KalmanPoseFilter : public IPoseFilter
 {
 public:
-	KalmanPoseFilter();
+	KalmanPoseFilter(const KalmanFilterPrecision precision = KalmanFilterPrecisionFloat);
+	KalmanPoseFilter(const KalmanPoseFilter &other);
+	virtual ~KalmanPoseFilter();
+
+	KalmanPoseFilter &operator=(const KalmanPoseFilter &other);
 
 	virtual bool init(const PoseFilterConstants &constant);
 	virtual bool init(const PoseFilterConstants &constant, const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation);
@@ -26,28 +38,39 @@ public:
 	Eigen::Vector3f getPositionCm(float time = 0.f) const override;
 	Eigen::Vector3f getVelocityCmPerSec() const override;
 	Eigen::Vector3f getAccelerationCmPerSecSqr() const override;
+	void updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet) override;
+	double getStateTimeSeconds() const override;
+	void copyState(const IPoseFilter *other) override;
 
 protected:
 	PoseFilterConstants m_constants;
 	class KalmanPoseFilterImpl *m_filter;
+	KalmanFilterPrecision m_precision;
+	double m_state_time_seconds;
 };
 
 /// Kalman Pose filter for Optical Pose + Angular Rate(Gyroscope) + Gravity(Accelerometer)
 class KalmanPoseFilterDS4 : public KalmanPoseFilter
 {
 public:
+	KalmanPoseFilterDS4(const KalmanFilterPrecision precision = KalmanFilterPrecisionFloat);
+
 	bool init(const PoseFilterConstants &constant) override;
 	bool init(const PoseFilterConstants &constant, const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation) override;
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
+	IPoseFilter *clone() const override;
 };
 
 /// Kalman Pose filter for Optical Position + Magnetometer + Angular Rate(Gyroscope) + Gravity(Accelerometer)
 class KalmanPoseFilterPSMove : public KalmanPoseFilter
 {
 public:
+	KalmanPoseFilterPSMove(const KalmanFilterPrecision precision = KalmanFilterPrecisionFloat);
+
 	bool init(const PoseFilterConstants &constant) override;
 	bool init(const PoseFilterConstants &constant, const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation) override;
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
+	IPoseFilter *clone() const override;
 };
 
 #endif // DEVICE_INTERFACE_H
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "KalmanPositionFilter.h"
 #include "MathAlignment.h"
 
+#include <assert.h>
+
 #include <kalman/MeasurementModel.hpp>
 #include <kalman/SystemModel.hpp>
 #include <kalman/SquareRootBase.hpp>
@@ -396,12 +398,18 @@ KalmanPositionFilter::KalmanPositionFilter()
     memset(&m_constants, 0, sizeof(PositionFilterConstants));
 }
 
+KalmanPositionFilter::KalmanPositionFilter(const KalmanPositionFilter &other)
+	: m_constants(other.m_constants)
+	, m_filter(other.m_filter != nullptr ? new KalmanPositionFilterImpl(*other.m_filter) : nullptr)
+{
+}
+
 KalmanPositionFilter::~KalmanPositionFilter()
 {
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 }
 
@@ -413,7 +421,7 @@ bool KalmanPositionFilter::init(const PositionFilterConstants &constants)
     if (m_filter != nullptr)
     {
         delete m_filter;
-        m_filter;
+        m_filter = nullptr;
     }
 
 	// Create and initialize the private filter implementation
@@ -432,7 +440,7 @@ bool KalmanPositionFilter::init(const PositionFilterConstants &constants, const
 	if (m_filter != nullptr)
 	{
 		delete m_filter;
-		m_filter;
+		m_filter = nullptr;
 	}
 
 	// Create and initialize the private filter implementation
@@ -543,6 +551,34 @@ void KalmanPositionFilter::update(const float delta_time, const PoseFilterPacket
     }
 }
 
+KalmanPositionFilter &KalmanPositionFilter::operator=(const KalmanPositionFilter &other)
+{
+	m_constants = other.m_constants;
+
+	if (m_filter != nullptr && other.m_filter != nullptr)
+	{
+		*m_filter = *other.m_filter;
+	}
+	else
+	{
+		delete m_filter;
+		m_filter = (other.m_filter != nullptr) ? new KalmanPositionFilterImpl(*other.m_filter) : nullptr;
+	}
+
+	return *this;
+}
+
+IPositionFilter *KalmanPositionFilter::clone() const
+{
+	return new KalmanPositionFilter(*this);
+}
+
+void KalmanPositionFilter::copyState(const IPositionFilter *other)
+{
+	assert(dynamic_cast<const KalmanPositionFilter *>(other) != nullptr);
+	*this = *static_cast<const KalmanPositionFilter *>(other);
+}
+
 bool KalmanPositionFilter::getIsStateValid() const
 {
     return m_filter->bIsValid;
@@ -8,8 +8,11 @@ class KalmanPositionFilter : public IPositionFilter
 {
 public:
 	KalmanPositionFilter();
+	KalmanPositionFilter(const KalmanPositionFilter &other);
 	virtual ~KalmanPositionFilter();
 
+	KalmanPositionFilter &operator=(const KalmanPositionFilter &other);
+
 	bool init(const PositionFilterConstants &constant) override;
 	bool init(const PositionFilterConstants &constant, const Eigen::Vector3f &initial_position) override;
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
@@ -23,6 +26,8 @@ public:
 	Eigen::Vector3f getPositionCm(float time = 0.f) const override;
 	Eigen::Vector3f getVelocityCmPerSec() const override;
 	Eigen::Vector3f getAccelerationCmPerSecSqr() const override;
+	IPositionFilter *clone() const override;
+	void copyState(const IPositionFilter *other) override;
 
 protected:
 	PositionFilterConstants m_constants;
@@ -2,6 +2,7 @@
 #include "OrientationFilter.h"
 #include "MathAlignment.h"
 #include "ServerLog.h"
+#include <assert.h>
 #include <deque>
 
 //-- constants -----
@@ -85,11 +86,25 @@ OrientationFilter::OrientationFilter() :
     resetState();
 }
 
+OrientationFilter::OrientationFilter(const OrientationFilter &other) :
+    m_constants(other.m_constants),
+    m_state(new OrientationFilterState(*other.m_state))
+{
+}
+
 OrientationFilter::~OrientationFilter()
 {
     delete m_state;
 }
 
+OrientationFilter &OrientationFilter::operator=(const OrientationFilter &other)
+{
+    m_constants = other.m_constants;
+    *m_state = *other.m_state;
+
+    return *this;
+}
+
 bool OrientationFilter::getIsStateValid() const
 {
     return m_state->bIsValid;
@@ -161,6 +176,17 @@ Eigen::Vector3f OrientationFilter::getAngularAccelerationRadPerSecSqr() const
 }
 
 // -- OrientationFilterPassThru --
+IOrientationFilter *OrientationFilterPassThru::clone() const
+{
+    return new OrientationFilterPassThru(*this);
+}
+
+void OrientationFilterPassThru::copyState(const IOrientationFilter *other)
+{
+    assert(dynamic_cast<const OrientationFilterPassThru *>(other) != nullptr);
+    *this = *static_cast<const OrientationFilterPassThru *>(other);
+}
+
 void OrientationFilterPassThru::update(const float delta_time, const PoseFilterPacket &packet)
 {
 	// Use the current orientation if the optical orientation is unavailable
@@ -183,6 +209,17 @@ void OrientationFilterPassThru::update(const float delta_time, const PoseFilterP
 // This algorithm comes from Sebastian O.H. Madgwick's 2010 paper:
 // "An efficient orientation filter for inertial and inertial/magnetic sensor arrays"
 // https://www.samba.org/tridge/UAV/madgwick_internal_report.pdf
+IOrientationFilter *OrientationFilterMadgwickARG::clone() const
+{
+    return new OrientationFilterMadgwickARG(*this);
+}
+
+void OrientationFilterMadgwickARG::copyState(const IOrientationFilter *other)
+{
+    assert(dynamic_cast<const OrientationFilterMadgwickARG *>(other) != nullptr);
+    *this = *static_cast<const OrientationFilterMadgwickARG *>(other);
+}
+
 void OrientationFilterMadgwickARG::update(const float delta_time, const PoseFilterPacket &packet)
 {
     const Eigen::Vector3f &current_omega= packet.imu_gyroscope_rad_per_sec;
@@ -261,6 +298,17 @@ void OrientationFilterMadgwickMARG::resetState()
     m_omega_bias_x= m_omega_bias_y= m_omega_bias_z= 0.f;
 }
 
+IOrientationFilter *OrientationFilterMadgwickMARG::clone() const
+{
+    return new OrientationFilterMadgwickMARG(*this);
+}
+
+void OrientationFilterMadgwickMARG::copyState(const IOrientationFilter *other)
+{
+    assert(dynamic_cast<const OrientationFilterMadgwickMARG *>(other) != nullptr);
+    *this = *static_cast<const OrientationFilterMadgwickMARG *>(other);
+}
+
 void OrientationFilterMadgwickMARG::update(const float delta_time, const PoseFilterPacket &packet)
 {
     const Eigen::Vector3f &current_omega= packet.imu_gyroscope_rad_per_sec;
@@ -369,6 +417,17 @@ void OrientationFilterMadgwickMARG::update(const float delta_time, const PoseFil
 }
 
 // -- OrientationFilterComplementaryOpticalARG --
+IOrientationFilter *OrientationFilterComplementaryOpticalARG::clone() const
+{
+    return new OrientationFilterComplementaryOpticalARG(*this);
+}
+
+void OrientationFilterComplementaryOpticalARG::copyState(const IOrientationFilter *other)
+{
+    assert(dynamic_cast<const OrientationFilterComplementaryOpticalARG *>(other) != nullptr);
+    *this = *static_cast<const OrientationFilterComplementaryOpticalARG *>(other);
+}
+
 void OrientationFilterComplementaryOpticalARG::update(const float delta_time, const PoseFilterPacket &packet)
 {
     if (packet.tracking_projection_area_px_sqr <= k_real_epsilon)
@@ -486,6 +545,17 @@ void OrientationFilterComplementaryMARG::resetState()
     mg_weight= 1.f;
 }
 
+IOrientationFilter *OrientationFilterComplementaryMARG::clone() const
+{
+    return new OrientationFilterComplementaryMARG(*this);
+}
+
+void OrientationFilterComplementaryMARG::copyState(const IOrientationFilter *other)
+{
+    assert(dynamic_cast<const OrientationFilterComplementaryMARG *>(other) != nullptr);
+    *this = *static_cast<const OrientationFilterComplementaryMARG *>(other);
+}
+
 void OrientationFilterComplementaryMARG::update(const float delta_time, const PoseFilterPacket &packet)
 {
     const Eigen::Vector3f &current_omega= packet.imu_gyroscope_rad_per_sec;
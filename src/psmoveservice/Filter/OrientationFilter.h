@@ -10,8 +10,11 @@ class OrientationFilter : public IOrientationFilter
 {
 public:
     OrientationFilter();
+    OrientationFilter(const OrientationFilter &other);
     virtual ~OrientationFilter();
 
+    OrientationFilter &operator=(const OrientationFilter &other);
+
     //-- IStateFilter --
     bool getIsStateValid() const override;
     void resetState() override;
@@ -34,6 +37,8 @@ class OrientationFilterPassThru : public OrientationFilter
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IOrientationFilter *clone() const override;
+    void copyState(const IOrientationFilter *other) override;
 };
 
 /// Angular Rate and Gravity fusion algorithm from Madgwick
@@ -41,6 +46,8 @@ class OrientationFilterMadgwickARG : public OrientationFilter
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IOrientationFilter *clone() const override;
+    void copyState(const IOrientationFilter *other) override;
 };
 
 /// Magnetic, Angular Rate, and Gravity fusion algorithm from Madgwick
@@ -56,6 +63,8 @@ public:
 
     void resetState() override;
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IOrientationFilter *clone() const override;
+    void copyState(const IOrientationFilter *other) override;
 
 protected:
     float m_omega_bias_x;
@@ -69,6 +78,8 @@ class OrientationFilterComplementaryOpticalARG : public OrientationFilterMadgwic
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IOrientationFilter *clone() const override;
+    void copyState(const IOrientationFilter *other) override;
 };
 
 /// Magnetic, Angular Rate, Gravity and fusion algorithm (hybrid Madgwick)
@@ -83,6 +94,8 @@ public:
 
     void resetState() override;
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IOrientationFilter *clone() const override;
+    void copyState(const IOrientationFilter *other) override;
 
 protected:
     float mg_weight;
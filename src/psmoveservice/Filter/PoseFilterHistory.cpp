@@ -0,0 +1,183 @@
+//-- includes -----
+#include "PoseFilterHistory.h"
+#include <assert.h>
+
+//-- private methods -----
+static void copy_optical_measurement(const PoseSensorPacket &from, PoseSensorPacket &to);
+static bool is_same_optical_measurement(const PoseSensorPacket &a, const PoseSensorPacket &b);
+static void apply_sensor_packet(
+    const double sample_time_seconds,
+    const PoseSensorPacket &sensor_packet,
+    const PoseFilterSpace *filter_space,
+    IPoseFilter *filter);
+
+//-- public interface -----
+PoseFilterHistory::PoseFilterHistory()
+    : m_samples()
+    , m_first_sample_index(0)
+    , m_sample_count(0)
+    , m_optical_capture_time_seconds(0.0)
+    , m_bHasOpticalMeasurement(false)
+{
+}
+
+PoseFilterHistory::~PoseFilterHistory()
+{
+    dispose();
+}
+
+bool PoseFilterHistory::init(const IPoseFilter *filter, const int max_sample_count)
+{
+    dispose();
+
+    if (filter == nullptr || max_sample_count < 1)
+    {
+        return false;
+    }
+
+    m_samples.resize(max_sample_count);
+    for (PoseFilterSample &sample : m_samples)
+    {
+        sample.time_seconds = 0.0;
+        sample.state_before_sample = filter->clone();
+    }
+
+    clear();
+
+    return true;
+}
+
+void PoseFilterHistory::dispose()
+{
+    for (PoseFilterSample &sample : m_samples)
+    {
+        delete sample.state_before_sample;
+    }
+
+    m_samples.clear();
+    clear();
+}
+
+void PoseFilterHistory::clear()
+{
+    m_first_sample_index = 0;
+    m_sample_count = 0;
+
+    // Not tracked until the first optical measurement shows up
+    m_optical_packet.optical_position_cm = Eigen::Vector3f::Zero();
+    m_optical_packet.optical_orientation = Eigen::Quaternionf::Identity();
+    m_optical_packet.tracking_projection_area_px_sqr = 0.f;
+    m_optical_capture_time_seconds = 0.0;
+    m_bHasOpticalMeasurement = false;
+}
+
+void PoseFilterHistory::applySample(
+    const double sample_time_seconds,
+    const PoseSensorPacket &sensor_packet,
+    const PoseFilterSpace *filter_space,
+    IPoseFilter *filter)
+{
+    assert(!m_samples.empty());
+
+    // Drop the oldest sample once the history is full
+    if (m_sample_count >= static_cast<int>(m_samples.size()))
+    {
+        m_first_sample_index = (m_first_sample_index + 1) % m_samples.size();
+        --m_sample_count;
+    }
+
+    PoseFilterSample &sample = getSample(m_sample_count);
+    ++m_sample_count;
+
+    sample.time_seconds = sample_time_seconds;
+    sample.sensor_packet = sensor_packet;
+    copy_optical_measurement(m_optical_packet, sample.sensor_packet);
+    sample.state_before_sample->copyState(filter);
+
+    apply_sensor_packet(sample.time_seconds, sample.sensor_packet, filter_space, filter);
+}
+
+int PoseFilterHistory::applyOpticalMeasurement(
+    const double capture_time_seconds,
+    const PoseSensorPacket &optical_packet,
+    const PoseFilterSpace *filter_space,
+    IPoseFilter *filter)
+{
+    // Already fused something captured later than this
+    if (m_bHasOpticalMeasurement && capture_time_seconds < m_optical_capture_time_seconds)
+    {
+        return 0;
+    }
+
+    // Every sample since the current measurement already got applied with the same optical state
+    // (i.e. the controller still isn't tracked), so there is nothing to re-apply
+    if (m_bHasOpticalMeasurement && is_same_optical_measurement(optical_packet, m_optical_packet))
+    {
+        m_optical_capture_time_seconds = capture_time_seconds;
+        return 0;
+    }
+
+    copy_optical_measurement(optical_packet, m_optical_packet);
+    m_optical_capture_time_seconds = capture_time_seconds;
+    m_bHasOpticalMeasurement = true;
+
+    // Find the first sample the measurement should have been applied to
+    int first_sample_index = 0;
+    while (first_sample_index < m_sample_count &&
+           getSample(first_sample_index).time_seconds <= capture_time_seconds)
+    {
+        ++first_sample_index;
+    }
+
+    if (first_sample_index >= m_sample_count)
+    {
+        // Nothing newer than the capture time, the next sample picks it up
+        return 0;
+    }
+
+    // Rewind to the state before that sample and replay everything since with the new measurement
+    filter->copyState(getSample(first_sample_index).state_before_sample);
+
+    for (int sample_index = first_sample_index; sample_index < m_sample_count; ++sample_index)
+    {
+        PoseFilterSample &sample = getSample(sample_index);
+
+        if (sample_index > first_sample_index)
+        {
+            sample.state_before_sample->copyState(filter);
+        }
+
+        copy_optical_measurement(m_optical_packet, sample.sensor_packet);
+        apply_sensor_packet(sample.time_seconds, sample.sensor_packet, filter_space, filter);
+    }
+
+    return m_sample_count - first_sample_index;
+}
+
+//-- private methods -----
+static void copy_optical_measurement(const PoseSensorPacket &from, PoseSensorPacket &to)
+{
+    to.optical_position_cm = from.optical_position_cm;
+    to.optical_orientation = from.optical_orientation;
+    to.tracking_projection_area_px_sqr = from.tracking_projection_area_px_sqr;
+}
+
+static bool is_same_optical_measurement(const PoseSensorPacket &a, const PoseSensorPacket &b)
+{
+    return
+        a.optical_position_cm == b.optical_position_cm &&
+        a.optical_orientation.coeffs() == b.optical_orientation.coeffs() &&
+        a.tracking_projection_area_px_sqr == b.tracking_projection_area_px_sqr;
+}
+
+static void apply_sensor_packet(
+    const double sample_time_seconds,
+    const PoseSensorPacket &sensor_packet,
+    const PoseFilterSpace *filter_space,
+    IPoseFilter *filter)
+{
+    PoseFilterPacket filter_packet;
+
+    filter_space->createFilterPacket(sensor_packet, filter, filter_packet);
+    filter->updateAtTime(sample_time_seconds, filter_packet);
+}
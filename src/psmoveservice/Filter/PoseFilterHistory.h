@@ -0,0 +1,82 @@
+#ifndef POSE_FILTER_HISTORY_H
+#define POSE_FILTER_HISTORY_H
+
+//-- includes -----
+#include "PoseFilterInterface.h"
+#include <vector>
+
+//-- definitions -----
+/// Keeps the last few sensor samples fed into a pose filter, along with a snapshot of the filter
+/// state from before each of them, so that an optical measurement arriving after IMU samples that
+/// are newer than the camera frame it came from can still be fused at the time the frame was captured.
+///
+/// Every sample is applied with the latest optical measurement captured at or before it.
+/// When a later optical measurement shows up the filter gets rewound to the state it had before
+/// the first sample newer than the capture time and the samples since get re-applied with it.
+/// All of the snapshot filters are allocated up front, nothing gets allocated per sample.
+class PoseFilterHistory
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    PoseFilterHistory();
+    ~PoseFilterHistory();
+
+    /// Allocates room for the given number of samples, using clones of the given filter as snapshots.
+    /// The filter must already be initialized.
+    bool init(const IPoseFilter *filter, const int max_sample_count);
+    void dispose();
+
+    /// Forget all samples and the current optical measurement, i.e. after the filter got reset
+    void clear();
+
+    /// Update the filter with a sensor packet sampled at the given time (seconds on the monotonic clock).
+    /// The optical part of the packet is ignored in favor of the current optical measurement.
+    void applySample(
+        const double sample_time_seconds,
+        const PoseSensorPacket &sensor_packet,
+        const PoseFilterSpace *filter_space,
+        IPoseFilter *filter);
+
+    /// Fuse the optical part of the given packet as captured at the given time.
+    /// Measurements captured before the current optical measurement are dropped.
+    /// Measurements captured before all of the samples in the history are fused from the oldest sample.
+    /// Returns the number of samples that were re-applied.
+    int applyOpticalMeasurement(
+        const double capture_time_seconds,
+        const PoseSensorPacket &optical_packet,
+        const PoseFilterSpace *filter_space,
+        IPoseFilter *filter);
+
+    inline int getSampleCount() const
+    { return m_sample_count; }
+
+    inline bool getHasOpticalMeasurement() const
+    { return m_bHasOpticalMeasurement; }
+
+    inline double getOpticalCaptureTimeSeconds() const
+    { return m_optical_capture_time_seconds; }
+
+private:
+    struct PoseFilterSample
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        double time_seconds;
+        PoseSensorPacket sensor_packet;
+        IPoseFilter *state_before_sample;
+    };
+
+    inline PoseFilterSample &getSample(const int sample_index)
+    { return m_samples[(m_first_sample_index + sample_index) % m_samples.size()]; }
+
+    std::vector<PoseFilterSample, Eigen::aligned_allocator<PoseFilterSample> > m_samples;
+    int m_first_sample_index;
+    int m_sample_count;
+
+    PoseSensorPacket m_optical_packet;
+    double m_optical_capture_time_seconds;
+    bool m_bHasOpticalMeasurement;
+};
+
+#endif // POSE_FILTER_HISTORY_H
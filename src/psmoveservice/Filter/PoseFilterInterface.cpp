@@ -1,6 +1,8 @@
 // -- includes --
 #include "PoseFilterInterface.h"
 
+#include <algorithm>
+
 // -- constants --
 // Calibration Pose transform
 const Eigen::Matrix3f g_eigen_identity_pose_upright = Eigen::Matrix3f::Identity();
@@ -16,6 +18,9 @@ const Eigen::Matrix3f *k_eigen_sensor_transform_identity = &g_eigen_sensor_trans
 const Eigen::Matrix3f g_eigen_sensor_transform_opengl((Eigen::Matrix3f() << 1,0,0, 0,0,1, 0,-1,0).finished());
 const Eigen::Matrix3f *k_eigen_sensor_transform_opengl= &g_eigen_sensor_transform_opengl;
 
+// Longest time step a timed update integrates over (i.e. across a gap of dropped input reports)
+static const double k_max_timed_update_time_delta = 1.0 / 30.0;
+
 // -- public interface -----
 //-- Orientation Filter Space -----
 PoseFilterSpace::PoseFilterSpace()
@@ -76,4 +81,20 @@ void PoseFilterSpace::createFilterPacket(
         
 	outFilterPacket.world_accelerometer=
 		eigen_vector3f_clockwise_rotate(outFilterPacket.current_orientation, outFilterPacket.imu_accelerometer_g_units);
-}
\ No newline at end of file
+}
+//-- Timed updates -----
+float compute_pose_filter_time_delta(
+    const double last_sample_time_seconds,
+    const double sample_time_seconds,
+    const float default_time_delta)
+{
+    // No timed update yet (or the filter was reset)
+    if (last_sample_time_seconds <= 0.0)
+    {
+        return default_time_delta;
+    }
+
+    const double time_delta = sample_time_seconds - last_sample_time_seconds;
+
+    return static_cast<float>(std::min(std::max(time_delta, 0.0), k_max_timed_update_time_delta));
+}
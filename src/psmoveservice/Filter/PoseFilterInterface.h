@@ -234,6 +234,8 @@ struct PoseFilterConstants
 class IStateFilter
 {
 public:
+    virtual ~IStateFilter() {}
+
     /// Not true until the filter has updated at least once
     virtual bool getIsStateValid() const = 0;
 
@@ -262,6 +264,13 @@ public:
 
     /// Get the current world space angular acceleration of the filter state (rad/s^2)
     virtual Eigen::Vector3f getAngularAccelerationRadPerSecSqr() const = 0;
+
+    /// Allocate a copy of the filter (constants and current state included)
+    virtual IOrientationFilter *clone() const = 0;
+
+    /// Overwrite the state of this filter with the state of a filter of the same type and constants,
+    /// i.e. one cloned from this filter or the filter this one was cloned from
+    virtual void copyState(const IOrientationFilter *other) = 0;
 };
 
 /// Common interface to all position filters
@@ -279,6 +288,13 @@ public:
 
     /// Get the current velocity of the filter state (cm/s^2)
     virtual Eigen::Vector3f getAccelerationCmPerSecSqr() const = 0;
+
+    /// Allocate a copy of the filter (constants and current state included)
+    virtual IPositionFilter *clone() const = 0;
+
+    /// Overwrite the state of this filter with the state of a filter of the same type and constants,
+    /// i.e. one cloned from this filter or the filter this one was cloned from
+    virtual void copyState(const IPositionFilter *other) = 0;
 };
 
 /// Common interface to all pose filters (filter orientation and position simultaneously)
@@ -308,6 +324,30 @@ public:
 
     /// Get the current velocity of the filter state (cm/s^2)
     virtual Eigen::Vector3f getAccelerationCmPerSecSqr() const = 0;
+
+    /// Update the state in the filter given a filter packet sampled at the given time
+    /// (seconds on the service monotonic clock).
+    /// The time step is the time since the sample of the previous timed update,
+    /// or the mean update time delta from the filter constants for the first one.
+    virtual void updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet) = 0;
+
+    /// Sample time of the last timed update (zero before the first one or after a reset)
+    virtual double getStateTimeSeconds() const = 0;
+
+    /// Allocate a copy of the filter (constants and current state included).
+    /// Used to keep snapshots of the filter state that can be rewound to.
+    virtual IPoseFilter *clone() const = 0;
+
+    /// Overwrite the state of this filter with the state of a filter of the same type and constants,
+    /// i.e. one cloned from this filter or the filter this one was cloned from
+    virtual void copyState(const IPoseFilter *other) = 0;
 };
 
+/// Time step to use for a timed update given the sample time of the previous one.
+/// Samples older than the filter state get a zero time step, long gaps get clamped.
+float compute_pose_filter_time_delta(
+    const double last_sample_time_seconds,
+    const double sample_time_seconds,
+    const float default_time_delta);
+
 #endif // POSE_FILTER_INTERFACE_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "MathEigen.h"
 #include "ServerLog.h"
 
+#include <assert.h>
 #include <chrono>
 #include <numeric>
 
@@ -148,11 +149,25 @@ PositionFilter::PositionFilter()
     resetState();
 }
 
+PositionFilter::PositionFilter(const PositionFilter &other)
+    : m_constants(other.m_constants)
+    , m_state(new PositionFilterState(*other.m_state))
+{
+}
+
 PositionFilter::~PositionFilter()
 {
     delete m_state;
 }
 
+PositionFilter &PositionFilter::operator=(const PositionFilter &other)
+{
+    m_constants = other.m_constants;
+    *m_state = *other.m_state;
+
+    return *this;
+}
+
 bool PositionFilter::getIsStateValid() const
 {
     return m_state->bIsValid;
@@ -219,6 +234,17 @@ Eigen::Vector3f PositionFilter::getAccelerationCmPerSecSqr() const
 
 // -- Position Filters ----
 // -- PositionFilterPassThru --
+IPositionFilter *PositionFilterPassThru::clone() const
+{
+    return new PositionFilterPassThru(*this);
+}
+
+void PositionFilterPassThru::copyState(const IPositionFilter *other)
+{
+    assert(dynamic_cast<const PositionFilterPassThru *>(other) != nullptr);
+    *this = *static_cast<const PositionFilterPassThru *>(other);
+}
+
 void PositionFilterPassThru::update(
 	const float delta_time, 
 	const PoseFilterPacket &packet)
@@ -240,6 +266,17 @@ void PositionFilterPassThru::update(
 }
 
 // -- PositionFilterLowPassOptical --
+IPositionFilter *PositionFilterLowPassOptical::clone() const
+{
+    return new PositionFilterLowPassOptical(*this);
+}
+
+void PositionFilterLowPassOptical::copyState(const IPositionFilter *other)
+{
+    assert(dynamic_cast<const PositionFilterLowPassOptical *>(other) != nullptr);
+    *this = *static_cast<const PositionFilterLowPassOptical *>(other);
+}
+
 void PositionFilterLowPassOptical::update(
 	const float delta_time, 
 	const PoseFilterPacket &packet)
@@ -281,6 +318,17 @@ void PositionFilterLowPassOptical::update(
 }
 
 // -- PositionFilterLowPassIMU --
+IPositionFilter *PositionFilterLowPassIMU::clone() const
+{
+    return new PositionFilterLowPassIMU(*this);
+}
+
+void PositionFilterLowPassIMU::copyState(const IPositionFilter *other)
+{
+    assert(dynamic_cast<const PositionFilterLowPassIMU *>(other) != nullptr);
+    *this = *static_cast<const PositionFilterLowPassIMU *>(other);
+}
+
 void PositionFilterLowPassIMU::update(
 	const float delta_time,
 	const PoseFilterPacket &packet)
@@ -324,6 +372,17 @@ void PositionFilterComplimentaryOpticalIMU::resetState()
     bLast_visible_position_timestamp_valid= false;
 }
 
+IPositionFilter *PositionFilterComplimentaryOpticalIMU::clone() const
+{
+    return new PositionFilterComplimentaryOpticalIMU(*this);
+}
+
+void PositionFilterComplimentaryOpticalIMU::copyState(const IPositionFilter *other)
+{
+    assert(dynamic_cast<const PositionFilterComplimentaryOpticalIMU *>(other) != nullptr);
+    *this = *static_cast<const PositionFilterComplimentaryOpticalIMU *>(other);
+}
+
 void PositionFilterComplimentaryOpticalIMU::update(const float delta_time, const PoseFilterPacket &packet)
 {
     if (packet.tracking_projection_area_px_sqr > 0)
@@ -413,6 +472,17 @@ void PositionFilterComplimentaryOpticalIMU::update(const float delta_time, const
 }
 
 // -- PositionFilterComplimentaryOpticalIMU --
+IPositionFilter *PositionFilterLowPassExponential::clone() const
+{
+    return new PositionFilterLowPassExponential(*this);
+}
+
+void PositionFilterLowPassExponential::copyState(const IPositionFilter *other)
+{
+    assert(dynamic_cast<const PositionFilterLowPassExponential *>(other) != nullptr);
+    *this = *static_cast<const PositionFilterLowPassExponential *>(other);
+}
+
 void PositionFilterLowPassExponential::update(const float delta_time, const PoseFilterPacket &packet)
 {
 	if (packet.tracking_projection_area_px_sqr > 0.f && eigen_vector3f_is_valid(packet.optical_position_cm))
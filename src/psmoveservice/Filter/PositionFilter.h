@@ -12,8 +12,11 @@ class PositionFilter : public IPositionFilter
 {
 public:
     PositionFilter();
+    PositionFilter(const PositionFilter &other);
     virtual ~PositionFilter();
 
+    PositionFilter &operator=(const PositionFilter &other);
+
     //-- IStateFilter --
     bool getIsStateValid() const override;
     void resetState() override;
@@ -36,24 +39,32 @@ class PositionFilterPassThru : public PositionFilter
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IPositionFilter *clone() const override;
+    void copyState(const IPositionFilter *other) override;
 };
 
 class PositionFilterLowPassOptical : public PositionFilter
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IPositionFilter *clone() const override;
+    void copyState(const IPositionFilter *other) override;
 };
 
 class PositionFilterLowPassIMU : public PositionFilter
 {
 public:
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IPositionFilter *clone() const override;
+    void copyState(const IPositionFilter *other) override;
 };
 
 class PositionFilterLowPassExponential : public PositionFilter
 {
 public:
 	void update(const float delta_time, const PoseFilterPacket &packet) override;
+	IPositionFilter *clone() const override;
+	void copyState(const IPositionFilter *other) override;
 	std::list<float> timeList;
 	std::list<Eigen::Vector3f> positionList;
 	Eigen::Vector3f prevVelocity;
@@ -69,6 +80,8 @@ public:
 
 	void resetState() override;
     void update(const float delta_time, const PoseFilterPacket &packet) override;
+    IPositionFilter *clone() const override;
+    void copyState(const IPositionFilter *other) override;
 
 private:
     std::chrono::time_point<std::chrono::high_resolution_clock> last_visible_position_timestamp;
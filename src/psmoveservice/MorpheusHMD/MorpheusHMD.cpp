@@ -4,6 +4,10 @@
 #include "DeviceManager.h"
 #include "HMDDeviceEnumerator.h"
 #include "HidHMDDeviceEnumerator.h"
+#include "HidReaderThread.h"
+#include "ReplayDeviceEnumerator.h"
+#include "DeviceInputRecorder.h"
+#include "DeviceInputReplayer.h"
 #include "MathUtility.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
@@ -33,7 +37,6 @@
 #define MORPHEUS_COMMAND_MAGIC 0xAA
 #define MORPHEUS_COMMAND_MAX_PAYLOAD_LEN 60
 
-#define MORPHEUS_HMD_STATE_BUFFER_MAX 4
 #define METERS_TO_CENTIMETERS 100
 
 enum eMorpheusRequestType
@@ -162,6 +165,7 @@ struct MorpheusSensorData
         memset(this, 0, sizeof(MorpheusSensorData));
     }
 };
+static_assert(sizeof(MorpheusSensorData) <= HidInputReport::k_max_report_size, "MorpheusSensorData doesn't fit in a HidInputReport");
 
 struct MorpheusCommandHeader
 {
@@ -238,6 +242,7 @@ MorpheusHMDConfig::config2ptree()
 
 	pt.put("prediction_time", prediction_time);
 	pt.put("max_poll_failure_count", max_poll_failure_count);
+	pt.put("use_hid_reader_thread", use_hid_reader_thread);
 
 	writeTrackingColor(pt, tracking_color_id);
 
@@ -257,6 +262,7 @@ MorpheusHMDConfig::ptree2config(const boost::property_tree::ptree &pt)
 
 		prediction_time = pt.get<float>("prediction_time", 0.f);
 		max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+		use_hid_reader_thread = pt.get<bool>("use_hid_reader_thread", use_hid_reader_thread);
 
 		// Use the current accelerometer values (constructor defaults) as the default values
 		accelerometer_gain.i = pt.get<float>("Calibration.Accel.X.k", accelerometer_gain.i);
@@ -365,11 +371,15 @@ MorpheusHMD::MorpheusHMD()
     , USBContext(nullptr)
     , NextPollSequenceNumber(0)
     , InData(nullptr)
+    , InputReader(nullptr)
     , HMDStates()
 	, bIsTracking(false)
+    , ReplayStreamID(-1)
+    , RecordStreamID(-1)
 {
     USBContext = new MorpheusUSBContext;
     InData = new MorpheusSensorData;
+    InputReader = new HidReaderThread("MorpheusHMD");
 
     HMDStates.clear();
 }
@@ -381,6 +391,7 @@ MorpheusHMD::~MorpheusHMD()
         SERVER_LOG_ERROR("~MorpheusHMD") << "HMD deleted without calling close() first!";
     }
 
+    delete InputReader;
     delete InData;
     delete USBContext;
 }
@@ -411,6 +422,10 @@ bool MorpheusHMD::open(
         SERVER_LOG_WARNING("MorpheusHMD::open") << "MorpheusHMD(" << cur_dev_path << ") already open. Ignoring request.";
         success = true;
     }
+    else if (pEnum->get_api_type() == HMDDeviceEnumerator::CommunicationType_REPLAY)
+    {
+        success = openReplay(pEnum);
+    }
     else
     {
 		SERVER_LOG_INFO("MorpheusHMD::open") << "Opening MorpheusHMD(" << cur_dev_path << ").";
@@ -458,6 +473,19 @@ bool MorpheusHMD::open(
 			// Always save the config back out in case some defaults changed
 			cfg.save();
 
+			if (DeviceInputRecorder::getInstance() != nullptr)
+			{
+				RecordStreamID =
+					DeviceInputRecorder::getInstance()->addStream(
+						CommonDeviceState::Morpheus, USBContext->device_identifier, "", cfg.saveToString());
+			}
+
+			// Hand the sensor reports off to the reader thread
+			if (cfg.use_hid_reader_thread)
+			{
+				InputReader->start(USBContext->sensor_device_handle, sizeof(MorpheusSensorData));
+			}
+
             // Reset the polling sequence counter
             NextPollSequenceNumber = 0;
 
@@ -473,13 +501,58 @@ bool MorpheusHMD::open(
     return success;
 }
 
+bool MorpheusHMD::openReplay(const HMDDeviceEnumerator *pEnum)
+{
+    const ReplayDeviceEnumerator *replay_enum = pEnum->get_replay_hmd_enumerator();
+    const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+    bool success = false;
+
+    if (replay_enum != nullptr && replayer != nullptr)
+    {
+        const int stream_id = replay_enum->get_stream_id();
+
+        SERVER_LOG_INFO("MorpheusHMD::open") << "Replaying MorpheusHMD(" << replayer->getStreamDevicePath(stream_id)
+            << ") from stream " << stream_id;
+
+        USBContext->device_identifier = pEnum->get_path();
+        USBContext->sensor_device_path = replayer->getStreamDevicePath(stream_id);
+
+        // Use the config the HMD was recorded with.
+        // Never saved: the recording shouldn't change the local config of the HMD.
+        cfg = MorpheusHMDConfig();
+        if (!cfg.loadFromString(replayer->getStreamConfig(stream_id)))
+        {
+            SERVER_LOG_WARNING("MorpheusHMD::open") << "Recording has no valid config for MorpheusHMD(" << USBContext->device_identifier << "). Using defaults.";
+        }
+
+        ReplayStreamID = stream_id;
+        NextPollSequenceNumber = 0;
+        success = true;
+    }
+
+    return success;
+}
+
 void MorpheusHMD::close()
 {
-    if (USBContext->sensor_device_handle != nullptr || USBContext->usb_device_handle != nullptr)
+    if (ReplayStreamID >= 0)
     {
+        SERVER_LOG_INFO("MorpheusHMD::close") << "Closing replayed MorpheusHMD(" << USBContext->device_identifier << ")";
+
+        ReplayStreamID = -1;
+        USBContext->Reset();
+        InData->Reset();
+    }
+    else if (USBContext->sensor_device_handle != nullptr || USBContext->usb_device_handle != nullptr)
+    {
+        RecordStreamID = -1;
+
 		if (USBContext->sensor_device_handle != nullptr)
 		{
 			SERVER_LOG_INFO("MorpheusHMD::close") << "Closing MorpheusHMD sensor interface(" << USBContext->sensor_device_path << ")";
+
+			// Stop reading before the handle goes away
+			InputReader->stop();
 			hid_close(USBContext->sensor_device_handle);
 		}
 
@@ -538,7 +611,77 @@ MorpheusHMD::getUSBDevicePath() const
 bool
 MorpheusHMD::getIsOpen() const
 {
-    return USBContext->sensor_device_handle != nullptr && USBContext->usb_device_handle != nullptr;
+    return
+        (USBContext->sensor_device_handle != nullptr && USBContext->usb_device_handle != nullptr) ||
+        ReplayStreamID >= 0;
+}
+
+int
+MorpheusHMD::readDataIn(
+	std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp)
+{
+	int res;
+
+	if (ReplayStreamID >= 0)
+	{
+		res = DeviceInputReplayer::getInstance()->readHidReport(ReplayStreamID, InData, sizeof(MorpheusSensorData), out_arrival_timestamp);
+	}
+	else if (InputReader->getIsStarted())
+	{
+		HidInputReport report;
+
+		if (InputReader->fetchInputReport(report))
+		{
+			memcpy(InData, report.report, report.report_size);
+			out_arrival_timestamp = report.arrival_timestamp;
+			res = report.report_size;
+		}
+		else if (InputReader->getHasDeviceFailed())
+		{
+			// The reader thread stops touching the device once a read fails,
+			// so the HID error can only be fetched safely from here
+			char hidapi_err_mbs[256];
+			bool valid_error_mesg =
+				ServerUtility::convert_wcs_to_mbs(hid_error(USBContext->sensor_device_handle), hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+			if (valid_error_mesg)
+			{
+				SERVER_LOG_ERROR("MorpheusHMD::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+			}
+
+			res = -1;
+		}
+		else
+		{
+			res = 0;
+		}
+	}
+	else
+	{
+		res = hid_read(USBContext->sensor_device_handle, (unsigned char*)InData, sizeof(MorpheusSensorData));
+		// Reports that piled up since the last poll all look like they arrived now,
+		// so leave the arrival time unknown and let the filter spread them out evenly
+		out_arrival_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+
+		if (res < 0)
+		{
+			char hidapi_err_mbs[256];
+			bool valid_error_mesg =
+				ServerUtility::convert_wcs_to_mbs(hid_error(USBContext->sensor_device_handle), hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+			if (valid_error_mesg)
+			{
+				SERVER_LOG_ERROR("MorpheusHMD::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+			}
+		}
+	}
+
+	if (RecordStreamID >= 0 && res > 0)
+	{
+		DeviceInputRecorder::getInstance()->recordHidReport(RecordStreamID, out_arrival_timestamp, InData, res);
+	}
+
+	return res;
 }
 
 IControllerInterface::ePollResult
@@ -553,7 +696,8 @@ MorpheusHMD::poll()
 		for (int iteration = 0; iteration < k_max_iterations; ++iteration)
 		{
 			// Attempt to read the next update packet from the controller
-			int res = hid_read(USBContext->sensor_device_handle, (unsigned char*)InData, sizeof(MorpheusSensorData));
+			std::chrono::time_point<std::chrono::high_resolution_clock> arrival_timestamp;
+			int res = readDataIn(arrival_timestamp);
 
 			if (res == 0)
 			{
@@ -567,15 +711,7 @@ MorpheusHMD::poll()
 			}
 			else if (res < 0)
 			{
-				char hidapi_err_mbs[256];
-				bool valid_error_mesg = 
-					ServerUtility::convert_wcs_to_mbs(hid_error(USBContext->sensor_device_handle), hidapi_err_mbs, sizeof(hidapi_err_mbs));
-
 				// Device no longer in valid state.
-				if (valid_error_mesg)
-				{
-					SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
-				}
 				result = IHMDInterface::_PollResultFailure;
 
 				// No more data available. Stop iterating.
@@ -593,16 +729,12 @@ MorpheusHMD::poll()
 			// Increment the sequence for every new polling packet
 			newState.PollSequenceNumber = NextPollSequenceNumber;
 			++NextPollSequenceNumber;
+			newState.ArrivalTimestamp = arrival_timestamp;
 
 			// Processes the IMU data
 			newState.parse_data_input(&cfg, InData);
 
-			// Make room for new entry if at the max queue size
-			if (HMDStates.size() >= MORPHEUS_HMD_STATE_BUFFER_MAX)
-			{
-				HMDStates.erase(HMDStates.begin(), HMDStates.begin() + HMDStates.size() - MORPHEUS_HMD_STATE_BUFFER_MAX);
-			}
-
+			// Pushing into a full history drops the oldest state
 			HMDStates.push_back(newState);
 		}
 	}
@@ -651,9 +783,7 @@ const CommonDeviceState *
 MorpheusHMD::getState(
     int lookBack) const
 {
-    const int queueSize = static_cast<int>(HMDStates.size());
-    const CommonDeviceState * result =
-        (lookBack < queueSize) ? &HMDStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= HMDStates.getLookBack(lookBack);
 
     return result;
 }
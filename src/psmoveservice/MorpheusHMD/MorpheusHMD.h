@@ -4,12 +4,15 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
 #include "MathUtility.h"
 #include <string>
 #include <vector>
-#include <deque>
 #include <array>
 
+// Number of most recent states kept around for getState()
+#define MORPHEUS_HMD_STATE_BUFFER_MAX 4
+
 // The angle the accelerometer reading will be pitched by
 // if the Morpheus is held such that the face plate is perpendicular to the ground
 // i.e. where what we consider the "identity" pose
@@ -36,6 +39,7 @@ public:
 		, position_variance_exp_fit_b(-0.000567041978f)
 		, orientation_variance(0.005f)
         , max_poll_failure_count(100)
+        , use_hid_reader_thread(false)
         , prediction_time(0.f)
 		, tracking_color_id(eCommonTrackingColorID::Blue)
     {
@@ -157,6 +161,9 @@ public:
 	}
 
     long max_poll_failure_count;
+	// Read sensor reports on a dedicated thread so that each one gets an accurate arrival time.
+	// Off by default, the thread shares the hidapi handle with the main thread (see HidReaderThread.h)
+	bool use_hid_reader_thread;
 	float prediction_time;
 
 	eCommonTrackingColorID tracking_color_id;
@@ -253,6 +260,9 @@ public:
 	void setTrackingEnabled(bool bEnableTracking);
 
 private:
+    bool openReplay(const class HMDDeviceEnumerator *pEnum);
+    int readDataIn(std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp);
+
     // Constant while the HMD is open
     MorpheusHMDConfig cfg;
     class MorpheusUSBContext *USBContext;                    // Buffer that holds static MorpheusAPI HMD description
@@ -260,9 +270,14 @@ private:
     // Read HMD State
     int NextPollSequenceNumber;
     struct MorpheusSensorData *InData;                        // Buffer to hold most recent MorpheusAPI tracking state
-    std::deque<MorpheusHMDState> HMDStates;
+    class HidReaderThread *InputReader;                       // Blocking reads of sensor reports, if enabled
+    DeviceStateRingBuffer<MorpheusHMDState, MORPHEUS_HMD_STATE_BUFFER_MAX> HMDStates;
 
 	bool bIsTracking;
+
+    // Device input recording
+    int ReplayStreamID;                                       // >= 0 if replaying the HMD from a recording
+    int RecordStreamID;                                       // >= 0 if recording the input of the HMD
 };
 
 #endif // MORPHEUS_HMD_H
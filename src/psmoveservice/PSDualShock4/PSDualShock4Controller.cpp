@@ -1,10 +1,14 @@
 //-- includes -----
 #include "PSDualShock4Controller.h"
 #include "ControllerDeviceEnumerator.h"
+#include "ReplayDeviceEnumerator.h"
+#include "DeviceInputRecorder.h"
+#include "DeviceInputReplayer.h"
 #include "MathUtility.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "BluetoothQueries.h"
+#include "HidReaderThread.h"
 #include <algorithm>
 #include <vector>
 #include <cstdlib>
@@ -29,7 +33,6 @@
 #define PSDS4_BTADDR_GET_SIZE 16
 #define PSDS4_BTADDR_SET_SIZE 23
 #define PSDS4_BTADDR_SIZE 6
-#define PSDS4_STATE_BUFFER_MAX 16
 
 #define PSDS4_TRACKING_TRIANGLE_WIDTH  .9386f // The width of a triangle enclosed in the DS4 tracking bar in cm
 #define PSDS4_TRACKING_TRIANGLE_HEIGHT  .6548f // The height of a triangle enclosed in the DS4 tracking bar in cm
@@ -220,6 +223,7 @@ struct PSDualShock4DataInput
     unsigned char _unknown3[2];         // byte 73-74, Unknown 0x00 0x00 or 0x00 0x01
     unsigned char crc32[4];             // byte 75-78, CRC-32 of the first 75 bytes
 };
+static_assert(sizeof(PSDualShock4DataInput) <= HidInputReport::k_max_report_size, "PSDualShock4DataInput doesn't fit in a HidInputReport");
 
 // 78 bytes
 struct PSDualShock4DataOutput 
@@ -299,6 +303,8 @@ PSDualShock4ControllerConfig::config2ptree()
 
     pt.put("prediction_time", prediction_time);
     pt.put("max_poll_failure_count", max_poll_failure_count);
+    pt.put("use_hid_reader_thread", use_hid_reader_thread);
+    pt.put("use_imu_timestamps", use_imu_timestamps);
 
 	writeTrackingColor(pt, tracking_color_id);
 
@@ -315,6 +321,8 @@ PSDualShock4ControllerConfig::ptree2config(const boost::property_tree::ptree &pt
         is_valid = pt.get<bool>("is_valid", false);
         prediction_time = pt.get<float>("prediction_time", 0.f);
         max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+        use_hid_reader_thread = pt.get<bool>("use_hid_reader_thread", use_hid_reader_thread);
+        use_imu_timestamps = pt.get<bool>("use_imu_timestamps", use_imu_timestamps);
 
         // Use the current accelerometer values (constructor defaults) as the default values
         accelerometer_gain.i = pt.get<float>("Calibration.Accel.X.k", accelerometer_gain.i);
@@ -373,6 +381,8 @@ PSDualShock4Controller::PSDualShock4Controller()
     , RumbleLeft(0)
     , bWriteStateDirty(false)
     , NextPollSequenceNumber(0)
+    , ReplayStreamID(-1)
+    , RecordStreamID(-1)
 {
 	HIDDetails.vendor_id = -1;
 	HIDDetails.product_id = -1;
@@ -388,6 +398,8 @@ PSDualShock4Controller::PSDualShock4Controller()
     OutData->_unknown1[1] = 0x00;
     OutData->rumbleFlags = PSDS4_RUMBLE_ENABLED;
 
+    InputReader = new HidReaderThread("PSDualShock4Controller");
+
     // Make sure there is an initial empty state in the tracker queue
     {
         PSDualShock4ControllerState empty_state;
@@ -404,6 +416,7 @@ PSDualShock4Controller::~PSDualShock4Controller()
         SERVER_LOG_ERROR("~PSDualShock4Controller") << "Controller deleted without calling close() first!";
     }
 
+    delete InputReader;
     delete InData;
 }
 
@@ -433,6 +446,10 @@ bool PSDualShock4Controller::open(
         SERVER_LOG_WARNING("PSDualShock4Controller::open") << "PSDualShock4Controller(" << cur_dev_path << ") already open. Ignoring request.";
         success = true;
     }
+    else if (pEnum->get_api_type() == ControllerDeviceEnumerator::CommunicationType_REPLAY)
+    {
+        success = openReplay(pEnum);
+    }
     else
     {
         char cur_dev_serial_number[256];
@@ -534,6 +551,13 @@ bool PSDualShock4Controller::open(
 				cfg.save();
             }
 
+            if (success && IsBluetooth && DeviceInputRecorder::getInstance() != nullptr)
+            {
+                RecordStreamID =
+                    DeviceInputRecorder::getInstance()->addStream(
+                        CommonDeviceState::PSDualShock4, HIDDetails.Device_path, HIDDetails.Bt_addr, cfg.saveToString());
+            }
+
             // Reset the polling sequence counter
             NextPollSequenceNumber = 0;
 
@@ -543,6 +567,12 @@ bool PSDualShock4Controller::open(
                 bWriteStateDirty= true;
                 writeDataOut();
             }
+
+            // Hand the input reports off to the reader thread
+            if (success && IsBluetooth && cfg.use_hid_reader_thread)
+            {
+                InputReader->start(HIDDetails.Handle, sizeof(PSDualShock4DataInput));
+            }
         }
         else
         {
@@ -554,12 +584,62 @@ bool PSDualShock4Controller::open(
     return success;
 }
 
+bool PSDualShock4Controller::openReplay(const ControllerDeviceEnumerator *pEnum)
+{
+    const ReplayDeviceEnumerator *replay_enum = pEnum->get_replay_controller_enumerator();
+    const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+    bool success = false;
+
+    if (replay_enum != nullptr && replayer != nullptr)
+    {
+        const int stream_id = replay_enum->get_stream_id();
+
+        SERVER_LOG_INFO("PSDualShock4Controller::open") << "Replaying PSDualShock4Controller(" << replayer->getStreamDevicePath(stream_id)
+            << ") from stream " << stream_id;
+
+        HIDDetails.vendor_id = pEnum->get_vendor_id();
+        HIDDetails.product_id = pEnum->get_product_id();
+        HIDDetails.Device_path = pEnum->get_path();
+        HIDDetails.Bt_addr = replayer->getStreamDeviceSerial(stream_id);
+        HIDDetails.Host_bt_addr = "00:00:00:00:00:00";
+        IsBluetooth = true;
+
+        // Use the config the controller was recorded with.
+        // Never saved: the recording shouldn't change the local config of the controller.
+        char szConfigSuffix[18];
+        ServerUtility::bluetooth_cstr_address_normalize(
+            HIDDetails.Bt_addr.c_str(), true, '_',
+            szConfigSuffix, sizeof(szConfigSuffix));
+
+        std::string config_name("dualshock4_");
+        config_name += szConfigSuffix;
+
+        cfg = PSDualShock4ControllerConfig(config_name);
+        if (!cfg.loadFromString(replayer->getStreamConfig(stream_id)))
+        {
+            SERVER_LOG_WARNING("PSDualShock4Controller::open") << "Recording has no valid config for PSDualShock4Controller(" << HIDDetails.Device_path << "). Using defaults.";
+        }
+
+        ReplayStreamID = stream_id;
+        NextPollSequenceNumber = 0;
+        success = true;
+    }
+
+    return success;
+}
+
 void PSDualShock4Controller::close()
 {
     if (getIsOpen())
     {
         SERVER_LOG_INFO("PSDualShock4Controller::close") << "Closing PSDualShock4Controller(" << HIDDetails.Device_path << ")";
 
+        ReplayStreamID = -1;
+        RecordStreamID = -1;
+
+        // Stop reading before the handle goes away
+        InputReader->stop();
+
         if (HIDDetails.Handle != nullptr)
         {
             if (IsBluetooth)
@@ -636,7 +716,10 @@ PSDualShock4Controller::setTrackingColorID(const eCommonTrackingColorID tracking
 	if (getIsOpen() && getIsBluetooth())
 	{
 		cfg.tracking_color_id = tracking_color_id;
-		cfg.save();
+		if (ReplayStreamID < 0)
+		{
+			cfg.save();
+		}
 		bSuccess = true;
 	}
 
@@ -712,7 +795,7 @@ PSDualShock4Controller::getAssignedHostBluetoothAddress() const
 bool
 PSDualShock4Controller::getIsOpen() const
 {
-    return (HIDDetails.Handle != nullptr);
+    return (HIDDetails.Handle != nullptr || ReplayStreamID >= 0);
 }
 
 CommonDeviceState::eDeviceType
@@ -762,6 +845,72 @@ PSDualShock4Controller::getBTAddressesViaUSB(std::string& host, std::string& con
 }
 
 
+int
+PSDualShock4Controller::readDataIn(
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp)
+{
+    int res;
+
+    if (ReplayStreamID >= 0)
+    {
+        res = DeviceInputReplayer::getInstance()->readHidReport(ReplayStreamID, InData, sizeof(PSDualShock4DataInput), out_arrival_timestamp);
+    }
+    else if (InputReader->getIsStarted())
+    {
+        HidInputReport report;
+
+        if (InputReader->fetchInputReport(report))
+        {
+            memcpy(InData, report.report, report.report_size);
+            out_arrival_timestamp = report.arrival_timestamp;
+            res = report.report_size;
+        }
+        else if (InputReader->getHasDeviceFailed())
+        {
+            // The reader thread stops touching the device once a read fails,
+            // so the HID error can only be fetched safely from here
+            char hidapi_err_mbs[256];
+            bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+            if (valid_error_mesg)
+            {
+                SERVER_LOG_ERROR("PSDualShock4Controller::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+            }
+
+            res = -1;
+        }
+        else
+        {
+            res = 0;
+        }
+    }
+    else
+    {
+        res = hid_read(HIDDetails.Handle, (unsigned char*)InData, sizeof(PSDualShock4DataInput));
+        // Reports that piled up since the last poll all look like they arrived now,
+        // so leave the arrival time unknown and let the filter spread them out evenly
+        out_arrival_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+
+        if (res < 0)
+        {
+            char hidapi_err_mbs[256];
+            bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+            if (valid_error_mesg)
+            {
+                SERVER_LOG_ERROR("PSDualShock4Controller::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+            }
+        }
+    }
+
+    if (RecordStreamID >= 0 && res > 0)
+    {
+        DeviceInputRecorder::getInstance()->recordHidReport(RecordStreamID, out_arrival_timestamp, InData, res);
+    }
+
+    return res;
+}
+
 IControllerInterface::ePollResult
 PSDualShock4Controller::poll()
 {
@@ -779,7 +928,8 @@ PSDualShock4Controller::poll()
         for (int iteration = 0; iteration < k_max_iterations; ++iteration)
         {
             // Attempt to read the next update packet from the controller
-            int res = hid_read(HIDDetails.Handle, (unsigned char*)InData, sizeof(PSDualShock4DataInput));
+            std::chrono::time_point<std::chrono::high_resolution_clock> arrival_timestamp;
+            int res = readDataIn(arrival_timestamp);
 
             if (res == 0)
             {
@@ -795,14 +945,7 @@ PSDualShock4Controller::poll()
             }
             else if (res < 0)
             {
-                char hidapi_err_mbs[256];
-                bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
-
                 // Device no longer in valid state.
-                if (valid_error_mesg)
-                {
-                    SERVER_LOG_ERROR("PSDualShock4Controller::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
-                }
                 result = IControllerInterface::_PollResultFailure;
 
                 // No more data available. Stop iterating.
@@ -822,6 +965,7 @@ PSDualShock4Controller::poll()
             // Increment the sequence for every new polling packet
             newState.PollSequenceNumber = NextPollSequenceNumber;
             ++NextPollSequenceNumber;
+            newState.ArrivalTimestamp = arrival_timestamp;
 
             // Smush the button state into one unsigned 32-bit variable
             newState.AllButtons = 
@@ -981,13 +1125,7 @@ PSDualShock4Controller::poll()
                 break;
             }            
 
-            // Make room for new entry if at the max queue size
-            if (ControllerStates.size() >= PSDS4_STATE_BUFFER_MAX)
-            {
-                ControllerStates.erase(ControllerStates.begin(),
-                    ControllerStates.begin() + ControllerStates.size() - PSDS4_STATE_BUFFER_MAX);
-            }
-
+            // Pushing into a full history drops the oldest state
             ControllerStates.push_back(newState);
         }
 
@@ -1012,9 +1150,7 @@ const CommonDeviceState *
 PSDualShock4Controller::getState(
 int lookBack) const
 {
-    const int queueSize = static_cast<int>(ControllerStates.size());
-    const CommonDeviceState * result =
-        (lookBack < queueSize) ? &ControllerStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= ControllerStates.getLookBack(lookBack);
 
     return result;
 }
@@ -1120,6 +1256,12 @@ PSDualShock4Controller::writeDataOut()
 {
     bool bSuccess= true;
 
+    // A replayed controller has nothing to write to
+    if (ReplayStreamID >= 0)
+    {
+        bWriteStateDirty= false;
+    }
+
     if (bWriteStateDirty)
     {
         const bool bLedIsOn = LedR != 0 || LedG != 0 || LedB != 0;
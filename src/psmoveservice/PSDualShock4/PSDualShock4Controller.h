@@ -4,13 +4,16 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
 #include "MathUtility.h"
 #include "hidapi.h"
 #include <string>
 #include <vector>
-#include <deque>
 #include <chrono>
 
+// Number of most recent states kept around for getState()
+#define PSDS4_STATE_BUFFER_MAX 16
+
 // The angle the accelerometer reading is pitched forward when the DS4 is on a flat surface
 // The value comes from the accelerometer calibration utility
 #define FLAT_SURFACE_ACCELEROMETER_PITCH_DEGREES 12.661f
@@ -34,6 +37,7 @@ struct PSDualShock4HIDDetails {
 
 struct PSDualShock4DataInput;   // See .cpp for declaration
 struct PSDualShock4DataOutput;  // See .cpp for declaration
+class HidReaderThread;
 
 class PSDualShock4ControllerConfig : public PSMoveConfig
 {
@@ -47,6 +51,8 @@ public:
 		, position_filter_type("ComplimentaryOpticalIMU")
 		, orientation_filter_type("ComplementaryOpticalARG")
         , max_poll_failure_count(100)
+        , use_hid_reader_thread(false)
+        , use_imu_timestamps(false)
         , prediction_time(0.f)
         , accelerometer_noise_radius(0.015f) // rounded value from config tool measurement (g-units)
 		, accelerometer_variance(1.45e-05f) // rounded value from config tool measurement (g-units^2)
@@ -118,6 +124,13 @@ public:
 
 	// The max number of polling failures before we consider the controller disconnected
     long max_poll_failure_count;
+	// Read input reports on a dedicated thread (bluetooth only) so that each one gets an accurate arrival time.
+	// Off by default, the thread shares the hidapi handle with the main thread (see HidReaderThread.h)
+	bool use_hid_reader_thread;
+
+	// Integrate the IMU samples using the timestamps the controller puts on them rather than their arrival times.
+	// Off by default, the device clock model needs the HID reader thread's arrival times to calibrate against
+	bool use_imu_timestamps;
 	// The amount of prediction to apply to the controller pose after filtering
     float prediction_time;
 
@@ -325,8 +338,10 @@ public:
 
 private:
     bool getBTAddressesViaUSB(std::string& host, std::string& controller);
+    bool openReplay(const class ControllerDeviceEnumerator *pEnum);
     void clearAndWriteDataOut();
     bool writeDataOut();                            // Setters will call this
+    int readDataIn(std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp);
 
     // Constant while a controller is open
     PSDualShock4ControllerConfig cfg;
@@ -342,8 +357,13 @@ private:
 
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PSDualShock4ControllerState> ControllerStates;
+    DeviceStateRingBuffer<PSDualShock4ControllerState, PSDS4_STATE_BUFFER_MAX> ControllerStates;
     PSDualShock4DataInput* InData;                        // Buffer to read hidapi reports into
     PSDualShock4DataOutput* OutData;                      // Buffer to write hidapi reports out from
+    HidReaderThread* InputReader;                         // Blocking reads of input reports, if enabled
+
+    // Device input recording
+    int ReplayStreamID;                                   // >= 0 if replaying the controller from a recording
+    int RecordStreamID;                                   // >= 0 if recording the input of the controller
 };
 #endif // PSDUALSHOCK4_CONTROLLER_H
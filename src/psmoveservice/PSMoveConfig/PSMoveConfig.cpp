@@ -6,6 +6,7 @@
 #include <boost/property_tree/json_parser.hpp>
 
 #include <iostream>
+#include <sstream>
 
 // Format: {hue center, hue range}, {sat center, sat range}, {val center, val range}
 // All hue angles are 60 degrees apart to maximize hue separation for 6 max tracked colors.
@@ -75,6 +76,37 @@ PSMoveConfig::load()
     return bLoadedOk;
 }
 
+std::string
+PSMoveConfig::saveToString()
+{
+    std::stringstream json_stream;
+
+    boost::property_tree::write_json(json_stream, config2ptree());
+
+    return json_stream.str();
+}
+
+bool
+PSMoveConfig::loadFromString(const std::string &json_text)
+{
+    bool bLoadedOk = false;
+    boost::property_tree::ptree pt;
+    std::stringstream json_stream(json_text);
+
+    try
+    {
+        boost::property_tree::read_json(json_stream, pt);
+        ptree2config(pt);
+        bLoadedOk = true;
+    }
+    catch (boost::property_tree::json_parser_error &)
+    {
+        bLoadedOk = false;
+    }
+
+    return bLoadedOk;
+}
+
 void
 PSMoveConfig::writeColorPropertyPresetTable(
 	const CommonHSVColorRangeTable *table,
@@ -14,6 +14,9 @@ public:
     PSMoveConfig(const std::string &fnamebase = std::string("PSMoveConfig"));
     void save();
     bool load();
+    /// The config as json text (i.e. stored alongside recorded device input)
+    std::string saveToString();
+    bool loadFromString(const std::string &json_text);
     
     std::string ConfigFileBase;
 
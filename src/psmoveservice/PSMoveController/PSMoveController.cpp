@@ -36,9 +36,13 @@ POSSIBILITY OF SUCH DAMAGE.
 //-- includes -----
 #include "PSMoveController.h"
 #include "ControllerDeviceEnumerator.h"
+#include "ReplayDeviceEnumerator.h"
+#include "DeviceInputRecorder.h"
+#include "DeviceInputReplayer.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "BluetoothQueries.h"
+#include "HidReaderThread.h"
 #include "MathAlignment.h"
 #include <iostream>
 #include <sstream>
@@ -62,7 +66,6 @@ POSSIBILITY OF SUCH DAMAGE.
 #define PSMOVE_FW_GET_SIZE 13
 #define PSMOVE_CALIBRATION_SIZE 49 /* Buffer size for calibration data */
 #define PSMOVE_CALIBRATION_BLOB_SIZE (PSMOVE_CALIBRATION_SIZE*3 - 2*2) /* Three blocks, minus header (2 bytes) for blocks 2,3 */
-#define PSMOVE_STATE_BUFFER_MAX 16
 
 #define PSMOVE_TRACKING_BULB_RADIUS  2.25f // The radius of the psmove tracking bulb in cm
 
@@ -176,6 +179,7 @@ struct PSMoveDataInput {
     unsigned char timelow; /* low byte of timestamp */
     unsigned char extdata[PSMOVE_EXT_DATA_BUF_SIZE]; /* external device data (EXT port) */
 };
+static_assert(sizeof(PSMoveDataInput) <= HidInputReport::k_max_report_size, "PSMoveDataInput doesn't fit in a HidInputReport");
 
 // -- private prototypes -----
 static std::string PSMoveBTAddrUcharToString(const unsigned char* addr_buff);
@@ -206,6 +210,8 @@ PSMoveControllerConfig::config2ptree()
 
     pt.put("prediction_time", prediction_time);
     pt.put("max_poll_failure_count", max_poll_failure_count);
+    pt.put("use_hid_reader_thread", use_hid_reader_thread);
+    pt.put("use_imu_timestamps", use_imu_timestamps);
     
     pt.put("Calibration.Accel.X.k", cal_ag_xyz_kb[0][0][0]);
     pt.put("Calibration.Accel.X.b", cal_ag_xyz_kb[0][0][1]);
@@ -284,6 +290,8 @@ PSMoveControllerConfig::ptree2config(const boost::property_tree::ptree &pt)
 
         prediction_time = pt.get<float>("prediction_time", 0.f);
         max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+        use_hid_reader_thread = pt.get<bool>("use_hid_reader_thread", use_hid_reader_thread);
+        use_imu_timestamps = pt.get<bool>("use_imu_timestamps", use_imu_timestamps);
 
         cal_ag_xyz_kb[0][0][0] = pt.get<float>("Calibration.Accel.X.k", 1.0f);
         cal_ag_xyz_kb[0][0][1] = pt.get<float>("Calibration.Accel.X.b", 0.0f);
@@ -379,6 +387,8 @@ PSMoveController::PSMoveController()
     , Rumble(0)
     , bWriteStateDirty(false)
     , NextPollSequenceNumber(0)
+    , ReplayStreamID(-1)
+    , RecordStreamID(-1)
 {
 	HIDDetails.vendor_id = -1;
 	HIDDetails.product_id = -1;
@@ -388,6 +398,8 @@ PSMoveController::PSMoveController()
     InData = new PSMoveDataInput;
     InData->type = PSMove_Req_GetInput;
 
+    InputReader = new HidReaderThread("PSMoveController");
+
     // Make sure there is an initial empty state in the tracker queue
     {     
         PSMoveControllerState empty_state;
@@ -404,6 +416,7 @@ PSMoveController::~PSMoveController()
         SERVER_LOG_ERROR("~PSMoveController") << "Controller deleted without calling close() first!";
     }
 
+    delete InputReader;
     delete InData;
 }
 
@@ -433,6 +446,10 @@ bool PSMoveController::open(
         SERVER_LOG_WARNING("PSMoveController::open") << "PSMoveController(" << cur_dev_path << ") already open. Ignoring request.";
         success= true;
     }
+    else if (pEnum->get_api_type() == ControllerDeviceEnumerator::CommunicationType_REPLAY)
+    {
+        success= openReplay(pEnum);
+    }
     else
     {
         char cur_dev_serial_number[256];
@@ -530,6 +547,14 @@ bool PSMoveController::open(
                 success= false;
             }
 
+			// Record the input from the start, including the initial state read below
+			if (success && IsBluetooth && DeviceInputRecorder::getInstance() != nullptr)
+			{
+				RecordStreamID =
+					DeviceInputRecorder::getInstance()->addStream(
+						CommonDeviceState::PSMove, HIDDetails.Device_path, HIDDetails.Bt_addr, cfg.saveToString());
+			}
+
 			// Poll the controller to see if it emits valid magnetometer data
 			// (Newer firmware doesn't support the magnetometer anymore)
 			if (success && IsBluetooth)
@@ -569,6 +594,13 @@ bool PSMoveController::open(
 				cfg.save();
 			}
 
+            // Hand the input reports off to the reader thread
+            // once we are done synchronously reading the initial state
+            if (success && IsBluetooth && cfg.use_hid_reader_thread)
+            {
+                InputReader->start(HIDDetails.Handle, sizeof(PSMoveDataInput));
+            }
+
             // Reset the polling sequence counter
             NextPollSequenceNumber= 0;
         }
@@ -582,12 +614,66 @@ bool PSMoveController::open(
     return success;
 }
 
+bool PSMoveController::openReplay(const ControllerDeviceEnumerator *pEnum)
+{
+    const ReplayDeviceEnumerator *replay_enum = pEnum->get_replay_controller_enumerator();
+    const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+    bool success= false;
+
+    if (replay_enum != nullptr && replayer != nullptr)
+    {
+        const int stream_id = replay_enum->get_stream_id();
+
+        SERVER_LOG_INFO("PSMoveController::open") << "Replaying PSMoveController(" << replayer->getStreamDevicePath(stream_id)
+            << ") from stream " << stream_id;
+
+        HIDDetails.vendor_id = pEnum->get_vendor_id();
+        HIDDetails.product_id = pEnum->get_product_id();
+        HIDDetails.Device_path = pEnum->get_path();
+        HIDDetails.Bt_addr = replayer->getStreamDeviceSerial(stream_id);
+        HIDDetails.Host_bt_addr = "00:00:00:00:00:00";
+        IsBluetooth = true;
+
+        // Use the config the controller was recorded with.
+        // Never saved: the recording shouldn't change the local config of the controller.
+        std::string btaddr = HIDDetails.Bt_addr;
+        std::replace(btaddr.begin(), btaddr.end(), ':', '_');
+        cfg = PSMoveControllerConfig(btaddr);
+        if (!cfg.loadFromString(replayer->getStreamConfig(stream_id)))
+        {
+            SERVER_LOG_WARNING("PSMoveController::open") << "Recording has no valid config for PSMoveController(" << HIDDetails.Device_path << "). Using defaults.";
+        }
+
+        // Check the first recorded report for valid magnetometer data, like a live open does
+        PSMoveDataInput first_report;
+        memset(&first_report, 0, sizeof(PSMoveDataInput));
+        if (replayer->peekFirstHidReport(stream_id, &first_report, sizeof(PSMoveDataInput)) > 0)
+        {
+            SupportsMagnetometer =
+                (first_report.templow_mXhigh & 0x0F) != 0 || first_report.mXlow != 0 ||
+                first_report.mYhigh != 0 || first_report.mYlow_mZhigh != 0 || first_report.mZlow != 0;
+        }
+
+        ReplayStreamID = stream_id;
+        NextPollSequenceNumber= 0;
+        success= true;
+    }
+
+    return success;
+}
+
 void PSMoveController::close()
 {
     if (getIsOpen())
     {
         SERVER_LOG_INFO("PSMoveController::close") << "Closing PSMoveController(" << HIDDetails.Device_path << ")";
 
+        ReplayStreamID= -1;
+        RecordStreamID= -1;
+
+        // Stop reading before the handle goes away
+        InputReader->stop();
+
         if (HIDDetails.Handle != nullptr)
         {
             hid_close(HIDDetails.Handle);
@@ -673,7 +759,10 @@ PSMoveController::setTrackingColorID(const eCommonTrackingColorID tracking_color
 	if (getIsOpen() && getIsBluetooth())
 	{
 		cfg.tracking_color_id = tracking_color_id;
-		cfg.save();
+		if (ReplayStreamID < 0)
+		{
+			cfg.save();
+		}
 		bSuccess = true;
 	}
 
@@ -749,7 +838,7 @@ PSMoveController::getAssignedHostBluetoothAddress() const
 bool
 PSMoveController::getIsOpen() const
 {
-    return (HIDDetails.Handle != nullptr);
+    return (HIDDetails.Handle != nullptr || ReplayStreamID >= 0);
 }
 
 CommonDeviceState::eDeviceType
@@ -1026,6 +1115,72 @@ PSMoveController::enableDFUMode()
 	return (res == sizeof(buf));
 }
 
+int
+PSMoveController::readDataIn(
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp)
+{
+    int res;
+
+    if (ReplayStreamID >= 0)
+    {
+        res= DeviceInputReplayer::getInstance()->readHidReport(ReplayStreamID, InData, sizeof(PSMoveDataInput), out_arrival_timestamp);
+    }
+    else if (InputReader->getIsStarted())
+    {
+        HidInputReport report;
+
+        if (InputReader->fetchInputReport(report))
+        {
+            memcpy(InData, report.report, report.report_size);
+            out_arrival_timestamp= report.arrival_timestamp;
+            res= report.report_size;
+        }
+        else if (InputReader->getHasDeviceFailed())
+        {
+            // The reader thread stops touching the device once a read fails,
+            // so the HID error can only be fetched safely from here
+            char hidapi_err_mbs[256];
+            bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+            if (valid_error_mesg)
+            {
+                SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+            }
+
+            res= -1;
+        }
+        else
+        {
+            res= 0;
+        }
+    }
+    else
+    {
+        res = hid_read(HIDDetails.Handle, (unsigned char*)InData, sizeof(PSMoveDataInput));
+        // Reports that piled up since the last poll all look like they arrived now,
+        // so leave the arrival time unknown and let the filter spread them out evenly
+        out_arrival_timestamp= std::chrono::time_point<std::chrono::high_resolution_clock>();
+
+        if (res < 0)
+        {
+            char hidapi_err_mbs[256];
+            bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+            if (valid_error_mesg)
+            {
+                SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
+            }
+        }
+    }
+
+    if (RecordStreamID >= 0 && res > 0)
+    {
+        DeviceInputRecorder::getInstance()->recordHidReport(RecordStreamID, out_arrival_timestamp, InData, res);
+    }
+
+    return res;
+}
+
 IControllerInterface::ePollResult
 PSMoveController::poll()
 {
@@ -1043,7 +1198,8 @@ PSMoveController::poll()
         for (int iteration= 0; iteration < k_max_iterations; ++iteration)
         {
             // Attempt to read the next update packet from the controller
-            int res = hid_read(HIDDetails.Handle, (unsigned char*)InData, sizeof(PSMoveDataInput));
+            std::chrono::time_point<std::chrono::high_resolution_clock> arrival_timestamp;
+            int res = readDataIn(arrival_timestamp);
 
             if (res == 0)
             {
@@ -1057,14 +1213,7 @@ PSMoveController::poll()
             }
             else if (res < 0)
             {
-                char hidapi_err_mbs[256];
-                bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
-
                 // Device no longer in valid state.
-                if (valid_error_mesg)
-                {
-                    SERVER_LOG_ERROR("PSMoveController::readDataIn") << "HID ERROR: " << hidapi_err_mbs;
-                }
                 result= IControllerInterface::_PollResultFailure;
 
                 // No more data available. Stop iterating.
@@ -1082,6 +1231,7 @@ PSMoveController::poll()
             // Increment the sequence for every new polling packet
             newState.PollSequenceNumber= NextPollSequenceNumber;
             ++NextPollSequenceNumber;
+            newState.ArrivalTimestamp= arrival_timestamp;
 
             // Buttons
             newState.AllButtons = (InData->buttons2) | (InData->buttons1 << 8) |
@@ -1190,13 +1340,7 @@ PSMoveController::poll()
             newState.RawTimeStamp = InData->timelow | (InData->timehigh << 8);
             newState.TempRaw = (InData->temphigh << 4) | ((InData->templow_mXhigh & 0xF0) >> 4);
 
-            // Make room for new entry if at the max queue size
-            if (ControllerStates.size() >= PSMOVE_STATE_BUFFER_MAX)
-            {
-                ControllerStates.erase(ControllerStates.begin(),
-                    ControllerStates.begin() + ControllerStates.size() - PSMOVE_STATE_BUFFER_MAX);
-            }
-
+            // Pushing into a full history drops the oldest state
             ControllerStates.push_back(newState);
         }
 
@@ -1221,9 +1365,7 @@ const CommonDeviceState *
 PSMoveController::getState(
     int lookBack) const
 {
-    const int queueSize= static_cast<int>(ControllerStates.size());
-    const CommonDeviceState * result=
-        (lookBack < queueSize) ? &ControllerStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= ControllerStates.getLookBack(lookBack);
 
     return result;
 }
@@ -1328,6 +1470,12 @@ PSMoveController::writeDataOut()
 {
     bool bSuccess= true;
 
+    // A replayed controller has nothing to write to
+    if (ReplayStreamID >= 0)
+    {
+        bWriteStateDirty= false;
+    }
+
     if (bWriteStateDirty)
     {
         PSMoveDataOutput data_out = PSMoveDataOutput();  // 0-initialized
@@ -4,13 +4,16 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
 #include "MathUtility.h"
 #include "hidapi.h"
 #include <string>
 #include <array>
-#include <deque>
 #include <chrono>
 
+// Number of most recent states kept around for getState()
+#define PSMOVE_STATE_BUFFER_MAX 16
+
 struct PSMoveHIDDetails {
 	int vendor_id;
 	int product_id;
@@ -23,6 +26,7 @@ struct PSMoveHIDDetails {
 };
 
 struct PSMoveDataInput;  // See .cpp for full declaration
+class HidReaderThread;
 
 class PSMoveControllerConfig : public PSMoveConfig
 {
@@ -37,6 +41,8 @@ public:
 		, bt_firmware_version(0)
 		, firmware_revision(0)
         , max_poll_failure_count(100) 
+        , use_hid_reader_thread(false)
+        , use_imu_timestamps(false)
         , prediction_time(0.f)
 		, position_filter_type("LowPassExponential")
 		, orientation_filter_type("ComplementaryMARG")
@@ -87,6 +93,14 @@ public:
 	// The max number of polling failures before we consider the controller disconnected
     long max_poll_failure_count;
 
+	// Read input reports on a dedicated thread (bluetooth only) so that each one gets an accurate arrival time.
+	// Off by default, the thread shares the hidapi handle with the main thread (see HidReaderThread.h)
+	bool use_hid_reader_thread;
+
+	// Integrate the IMU samples using the timestamps the controller puts on them rather than their arrival times.
+	// Off by default, the device clock model needs the HID reader thread's arrival times to calibrate against
+	bool use_imu_timestamps;
+
 	// The amount of prediction to apply to the controller pose after filtering
     float prediction_time;
 
@@ -282,8 +296,10 @@ private:
     bool getBTAddress(std::string& host, std::string& controller);
     void loadCalibration();                         // Use USB or file if on BT
 	bool loadFirmwareInfo();
+    bool openReplay(const class ControllerDeviceEnumerator *pEnum);
     
     bool writeDataOut();                            // Setters will call this
+    int readDataIn(std::chrono::time_point<std::chrono::high_resolution_clock> &out_arrival_timestamp);
     
     // Constant while a controller is open
     PSMoveControllerConfig cfg;
@@ -300,7 +316,12 @@ private:
 
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PSMoveControllerState> ControllerStates;
+    DeviceStateRingBuffer<PSMoveControllerState, PSMOVE_STATE_BUFFER_MAX> ControllerStates;
     PSMoveDataInput* InData;                        // Buffer to copy hidapi reports into
+    HidReaderThread* InputReader;                   // Blocking reads of input reports, if enabled
+
+    // Device input recording
+    int ReplayStreamID;                             // >= 0 if replaying the controller from a recording
+    int RecordStreamID;                             // >= 0 if recording the input of the controller
 };
 #endif // PSMOVE_CONTROLLER_H
\ No newline at end of file
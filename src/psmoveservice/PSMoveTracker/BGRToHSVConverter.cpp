@@ -0,0 +1,309 @@
+// -- includes -----
+#include "BGRToHSVConverter.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #define BGR_TO_HSV_KERNEL_AVX2
+    #include <immintrin.h>
+#elif defined(__SSE4_1__) || defined(PSM_TRACKER_SIMD_SSE41)
+    #define BGR_TO_HSV_KERNEL_SSE41
+    #include <smmintrin.h>
+#elif defined(PSM_TRACKER_SIMD_NEON) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    // Opt-in only (PSM_TRACKER_SIMD=NEON) until it has been built on ARM and checked with test_bgr_to_hsv
+    #define BGR_TO_HSV_KERNEL_NEON
+    #include <arm_neon.h>
+#endif
+
+// -- constants -----
+// Fixed point precision and rounding used by OpenCV's 8-bit RGB2HSV_b functor.
+// Every kernel below evaluates exactly the same integer expressions,
+// which is what makes them bit-exact with cv::cvtColor.
+static const int k_hsv_shift = 12;
+static const int k_hsv_round = 1 << (k_hsv_shift - 1);
+static const int k_hue_range = 180;
+
+// -- private definitions -----
+struct HSVDivisionTables
+{
+    int saturation_div[256]; // (255 << shift) / v
+    int hue_div[256]; // (180 << shift) / (6 * diff)
+
+    HSVDivisionTables()
+    {
+        saturation_div[0] = 0;
+        hue_div[0] = 0;
+
+        for (int i = 1; i < 256; ++i)
+        {
+            // Round to nearest, the same as cv::saturate_cast<int>(double)
+            saturation_div[i] = static_cast<int>(std::floor((255 << k_hsv_shift) / (1.0*i) + 0.5));
+            hue_div[i] = static_cast<int>(std::floor((k_hue_range << k_hsv_shift) / (6.0*i) + 0.5));
+        }
+    }
+};
+
+static const HSVDivisionTables &getDivisionTables()
+{
+    static const HSVDivisionTables k_tables;
+
+    return k_tables;
+}
+
+// -- private methods -----
+static inline void convertPixel(const unsigned char *bgr, unsigned char *hsv, const HSVDivisionTables &tables)
+{
+    const int b = bgr[0];
+    const int g = bgr[1];
+    const int r = bgr[2];
+    const int v = std::max(b, std::max(g, r));
+    const int vmin = std::min(b, std::min(g, r));
+    const int diff = v - vmin;
+    const int vr = (v == r) ? -1 : 0;
+    const int vg = (v == g) ? -1 : 0;
+
+    const int s = (diff * tables.saturation_div[v] + k_hsv_round) >> k_hsv_shift;
+    int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+    h = (h * tables.hue_div[diff] + k_hsv_round) >> k_hsv_shift;
+    h += (h < 0) ? k_hue_range : 0;
+
+    hsv[0] = static_cast<unsigned char>(h);
+    hsv[1] = static_cast<unsigned char>(s);
+    hsv[2] = static_cast<unsigned char>(v);
+}
+
+#if defined(BGR_TO_HSV_KERNEL_AVX2)
+// Returns the number of pixels converted
+static int convertRowSIMD(const unsigned char *bgr, unsigned char *hsv, int pixel_count, const HSVDivisionTables &tables)
+{
+    const __m256i pixel_offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256i byte_mask = _mm256_set1_epi32(0xff);
+    const __m256i round = _mm256_set1_epi32(k_hsv_round);
+    const __m256i hue_range = _mm256_set1_epi32(k_hue_range);
+    const __m256i zero = _mm256_setzero_si256();
+    // Packs the low three bytes of each 32-bit lane together (per 128-bit half)
+    const __m256i pack_shuffle = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int x = 0;
+
+    // The gather reads one byte past the 8th pixel and each half store writes 4 bytes
+    // past its 4 pixels, so stay 2 pixels away from the end of the row
+    for (; x + 10 <= pixel_count; x += 8)
+    {
+        // One gather pulls [b, g, r, (next b)] for 8 pixels
+        const __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int *>(bgr + 3*x), pixel_offsets, 1);
+        const __m256i b = _mm256_and_si256(pixels, byte_mask);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byte_mask);
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byte_mask);
+
+        const __m256i v = _mm256_max_epi32(b, _mm256_max_epi32(g, r));
+        const __m256i vmin = _mm256_min_epi32(b, _mm256_min_epi32(g, r));
+        const __m256i diff = _mm256_sub_epi32(v, vmin);
+        const __m256i vr = _mm256_cmpeq_epi32(v, r);
+        const __m256i vg = _mm256_cmpeq_epi32(v, g);
+
+        const __m256i saturation_div = _mm256_i32gather_epi32(tables.saturation_div, v, 4);
+        const __m256i s = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(diff, saturation_div), round), k_hsv_shift);
+
+        const __m256i diff2 = _mm256_add_epi32(diff, diff);
+        const __m256i h_r = _mm256_sub_epi32(g, b);
+        const __m256i h_g = _mm256_add_epi32(_mm256_sub_epi32(b, r), diff2);
+        const __m256i h_b = _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_add_epi32(diff2, diff2));
+        __m256i h = _mm256_blendv_epi8(_mm256_blendv_epi8(h_b, h_g, vg), h_r, vr);
+
+        const __m256i hue_div = _mm256_i32gather_epi32(tables.hue_div, diff, 4);
+        h = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(h, hue_div), round), k_hsv_shift);
+        h = _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(zero, h), hue_range));
+
+        const __m256i hsv_pixels =
+            _mm256_shuffle_epi8(
+                _mm256_or_si256(h, _mm256_or_si256(_mm256_slli_epi32(s, 8), _mm256_slli_epi32(v, 16))),
+                pack_shuffle);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(hsv + 3*x), _mm256_castsi256_si128(hsv_pixels));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(hsv + 3*x + 12), _mm256_extracti128_si256(hsv_pixels, 1));
+    }
+
+    return x;
+}
+#elif defined(BGR_TO_HSV_KERNEL_SSE41)
+// Returns the number of pixels converted
+static int convertRowSIMD(const unsigned char *bgr, unsigned char *hsv, int pixel_count, const HSVDivisionTables &tables)
+{
+    const __m128i byte_mask = _mm_set1_epi32(0xff);
+    const __m128i round = _mm_set1_epi32(k_hsv_round);
+    const __m128i hue_range = _mm_set1_epi32(k_hue_range);
+    const __m128i zero = _mm_setzero_si128();
+    // Spreads 4 packed bgr pixels out to one 32-bit lane each
+    const __m128i unpack_shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    // ... and packs them back together
+    const __m128i pack_shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int x = 0;
+
+    // The 16 byte load and store cover 5 1/3 pixels, so stay 2 pixels away from the end of the row
+    for (; x + 6 <= pixel_count; x += 4)
+    {
+        const __m128i pixels = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bgr + 3*x)), unpack_shuffle);
+        const __m128i b = _mm_and_si128(pixels, byte_mask);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), byte_mask);
+        const __m128i r = _mm_srli_epi32(pixels, 16);
+
+        const __m128i v = _mm_max_epi32(b, _mm_max_epi32(g, r));
+        const __m128i vmin = _mm_min_epi32(b, _mm_min_epi32(g, r));
+        const __m128i diff = _mm_sub_epi32(v, vmin);
+        const __m128i vr = _mm_cmpeq_epi32(v, r);
+        const __m128i vg = _mm_cmpeq_epi32(v, g);
+
+        // No gather before AVX2
+        const __m128i saturation_div = _mm_setr_epi32(
+            tables.saturation_div[_mm_extract_epi32(v, 0)],
+            tables.saturation_div[_mm_extract_epi32(v, 1)],
+            tables.saturation_div[_mm_extract_epi32(v, 2)],
+            tables.saturation_div[_mm_extract_epi32(v, 3)]);
+        const __m128i hue_div = _mm_setr_epi32(
+            tables.hue_div[_mm_extract_epi32(diff, 0)],
+            tables.hue_div[_mm_extract_epi32(diff, 1)],
+            tables.hue_div[_mm_extract_epi32(diff, 2)],
+            tables.hue_div[_mm_extract_epi32(diff, 3)]);
+
+        const __m128i s = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(diff, saturation_div), round), k_hsv_shift);
+
+        const __m128i diff2 = _mm_add_epi32(diff, diff);
+        const __m128i h_r = _mm_sub_epi32(g, b);
+        const __m128i h_g = _mm_add_epi32(_mm_sub_epi32(b, r), diff2);
+        const __m128i h_b = _mm_add_epi32(_mm_sub_epi32(r, g), _mm_add_epi32(diff2, diff2));
+        __m128i h = _mm_blendv_epi8(_mm_blendv_epi8(h_b, h_g, vg), h_r, vr);
+
+        h = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(h, hue_div), round), k_hsv_shift);
+        h = _mm_add_epi32(h, _mm_and_si128(_mm_cmpgt_epi32(zero, h), hue_range));
+
+        const __m128i hsv_pixels =
+            _mm_shuffle_epi8(
+                _mm_or_si128(h, _mm_or_si128(_mm_slli_epi32(s, 8), _mm_slli_epi32(v, 16))),
+                pack_shuffle);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(hsv + 3*x), hsv_pixels);
+    }
+
+    return x;
+}
+#elif defined(BGR_TO_HSV_KERNEL_NEON)
+static inline int32x4_t computeHueSaturationNEON(
+    const int32x4_t b, const int32x4_t g, const int32x4_t r, const int32x4_t v, const int32x4_t diff,
+    const int32x4_t saturation_div, const int32x4_t hue_div,
+    int32x4_t &out_s)
+{
+    const int32x4_t round = vdupq_n_s32(k_hsv_round);
+    const uint32x4_t vr = vceqq_s32(v, r);
+    const uint32x4_t vg = vceqq_s32(v, g);
+    const int32x4_t diff2 = vaddq_s32(diff, diff);
+    const int32x4_t h_r = vsubq_s32(g, b);
+    const int32x4_t h_g = vaddq_s32(vsubq_s32(b, r), diff2);
+    const int32x4_t h_b = vaddq_s32(vsubq_s32(r, g), vaddq_s32(diff2, diff2));
+    int32x4_t h = vbslq_s32(vr, h_r, vbslq_s32(vg, h_g, h_b));
+
+    h = vshrq_n_s32(vaddq_s32(vmulq_s32(h, hue_div), round), k_hsv_shift);
+    h = vaddq_s32(h, vandq_s32(vreinterpretq_s32_u32(vcltq_s32(h, vdupq_n_s32(0))), vdupq_n_s32(k_hue_range)));
+
+    out_s = vshrq_n_s32(vaddq_s32(vmulq_s32(diff, saturation_div), round), k_hsv_shift);
+
+    return h;
+}
+
+// Returns the number of pixels converted
+static int convertRowSIMD(const unsigned char *bgr, unsigned char *hsv, int pixel_count, const HSVDivisionTables &tables)
+{
+    int x = 0;
+
+    for (; x + 8 <= pixel_count; x += 8)
+    {
+        // De-interleaving load of 8 pixels
+        const uint8x8x3_t bgr_pixels = vld3_u8(bgr + 3*x);
+        const uint16x8_t b16 = vmovl_u8(bgr_pixels.val[0]);
+        const uint16x8_t g16 = vmovl_u8(bgr_pixels.val[1]);
+        const uint16x8_t r16 = vmovl_u8(bgr_pixels.val[2]);
+        const uint16x8_t v16 = vmaxq_u16(b16, vmaxq_u16(g16, r16));
+        const uint16x8_t diff16 = vsubq_u16(v16, vminq_u16(b16, vminq_u16(g16, r16)));
+
+        // No gather on NEON, look the divisors up through the stack
+        uint16_t v_lanes[8], diff_lanes[8];
+        int32_t saturation_div_lanes[8], hue_div_lanes[8];
+        vst1q_u16(v_lanes, v16);
+        vst1q_u16(diff_lanes, diff16);
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            saturation_div_lanes[lane] = tables.saturation_div[v_lanes[lane]];
+            hue_div_lanes[lane] = tables.hue_div[diff_lanes[lane]];
+        }
+
+        int32x4_t s_lo, s_hi;
+        const int32x4_t h_lo = computeHueSaturationNEON(
+            vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(b16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(g16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(r16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(diff16))),
+            vld1q_s32(saturation_div_lanes), vld1q_s32(hue_div_lanes),
+            s_lo);
+        const int32x4_t h_hi = computeHueSaturationNEON(
+            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(b16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(g16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(r16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v16))),
+            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(diff16))),
+            vld1q_s32(saturation_div_lanes + 4), vld1q_s32(hue_div_lanes + 4),
+            s_hi);
+
+        uint8x8x3_t hsv_pixels;
+        hsv_pixels.val[0] = vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(h_lo)), vmovn_u32(vreinterpretq_u32_s32(h_hi))));
+        hsv_pixels.val[1] = vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(s_lo)), vmovn_u32(vreinterpretq_u32_s32(s_hi))));
+        hsv_pixels.val[2] = vmovn_u16(v16);
+        vst3_u8(hsv + 3*x, hsv_pixels);
+    }
+
+    return x;
+}
+#else
+// Returns the number of pixels converted
+static int convertRowSIMD(const unsigned char *, unsigned char *, int, const HSVDivisionTables &)
+{
+    return 0;
+}
+#endif
+
+// -- public interface -----
+const char *BGRToHSVConverter::getKernelName()
+{
+#if defined(BGR_TO_HSV_KERNEL_AVX2)
+    return "AVX2";
+#elif defined(BGR_TO_HSV_KERNEL_SSE41)
+    return "SSE4.1";
+#elif defined(BGR_TO_HSV_KERNEL_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+void BGRToHSVConverter::convertRow(const unsigned char *bgr, unsigned char *hsv, int pixel_count)
+{
+    const HSVDivisionTables &tables = getDivisionTables();
+
+    // Vectorized body, then whatever pixels are left over one at a time
+    for (int x = convertRowSIMD(bgr, hsv, pixel_count, tables); x < pixel_count; ++x)
+    {
+        convertPixel(bgr + 3*x, hsv + 3*x, tables);
+    }
+}
+
+void BGRToHSVConverter::convertImage(
+    const unsigned char *bgr, int bgr_stride,
+    unsigned char *hsv, int hsv_stride,
+    int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        convertRow(bgr + y*bgr_stride, hsv + y*hsv_stride, width);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef BGR_TO_HSV_CONVERTER_H
+#define BGR_TO_HSV_CONVERTER_H
+
+/// Converts 8-bit BGR pixels to 8-bit HSV (H in [0, 180), S and V in [0, 255]).
+/**
+The output is bit-exact with cv::cvtColor(..., cv::COLOR_BGR2HSV) on 8-bit images
+(and therefore with the old 256^3 entry lookup table built from it),
+so the tracking color presets keep selecting the same pixels.
+
+The kernel is picked at compile time from the instruction sets the file is built for:
+AVX2 (8 pixels per step), SSE4.1 (4 pixels), NEON (8 pixels) or plain C++.
+See PSM_TRACKER_SIMD in cmake/Environment.cmake.
+The NEON kernel is only compiled in when asked for, it hasn't been verified against cv::cvtColor yet.
+*/
+class BGRToHSVConverter
+{
+public:
+    /// Name of the kernel compiled in ("AVX2", "SSE4.1", "NEON" or "Scalar")
+    static const char *getKernelName();
+
+    /// Convert a run of packed BGR pixels (the buffers must not overlap)
+    static void convertRow(const unsigned char *bgr, unsigned char *hsv, int pixel_count);
+
+    /// Convert an image, one row at a time. Strides are in bytes.
+    static void convertImage(
+        const unsigned char *bgr, int bgr_stride,
+        unsigned char *hsv, int hsv_stride,
+        int width, int height);
+};
+
+#endif // BGR_TO_HSV_CONVERTER_H
@@ -1,5 +1,6 @@
 // -- includes -----
 #include "PS3EyeTracker.h"
+#include "DeviceInputRecorder.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
 #include "PSEyeVideoCapture.h"
@@ -9,8 +10,6 @@
 #include "opencv2/opencv.hpp"
 
 // -- constants -----
-#define PS3EYE_STATE_BUFFER_MAX 16
-
 static const char *OPTION_FOV_SETTING = "FOV Setting";
 static const char *OPTION_FOV_RED_DOT = "Red Dot";
 static const char *OPTION_FOV_BLUE_DOT = "Blue Dot";
@@ -21,11 +20,13 @@ class PSEyeCaptureData
 public:
     PSEyeCaptureData()
         : frame()
+        , bCaptureRawBayer(false)
     {
 
     }
 
-    cv::Mat frame;
+    cv::Mat frame; // BGR, or the raw Bayer sensor data (CV_8UC1) when bCaptureRawBayer is set
+    bool bCaptureRawBayer;
 };
 
 // -- public methods
@@ -217,7 +218,7 @@ PS3EyeTrackerConfig::getColorRangeTable(const std::string &table_name) const
 	return table;
 }
 
-inline CommonHSVColorRangeTable *
+CommonHSVColorRangeTable *
 PS3EyeTrackerConfig::getOrAddColorRangeTable(const std::string &table_name)
 {
 	CommonHSVColorRangeTable *table= nullptr;	
@@ -261,6 +262,7 @@ PS3EyeTracker::PS3EyeTracker()
     , VideoCapture(nullptr)
     , CaptureData(nullptr)
     , DriverType(PS3EyeTracker::Libusb)
+    , RecordStreamID(-1)
     , NextPollSequenceNumber(0)
     , TrackerStates()
 {
@@ -363,6 +365,13 @@ bool PS3EyeTracker::open(const DeviceEnumerator *enumerator)
 		VideoCapture->set(cv::CAP_PROP_EXPOSURE, cfg.exposure);
 		VideoCapture->set(cv::CAP_PROP_GAIN, cfg.gain);
 		VideoCapture->set(cv::CAP_PROP_FPS, cfg.frame_rate);
+
+        if (DeviceInputRecorder::getInstance() != nullptr)
+        {
+            RecordStreamID =
+                DeviceInputRecorder::getInstance()->addStream(
+                    CommonDeviceState::PS3EYE, USBDevicePath, identifier, cfg.saveToString());
+        }
     }
 
     return bSuccess;
@@ -385,7 +394,9 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
     if (getIsOpen())
     {
         if (!VideoCapture->grab() || 
-            !VideoCapture->retrieve(CaptureData->frame, cv::CAP_OPENNI_BGR_IMAGE))
+            !VideoCapture->retrieve(
+                CaptureData->frame, 
+                CaptureData->bCaptureRawBayer ? PSEyeVideoCapture::RETRIEVE_RAW_BAYER : cv::CAP_OPENNI_BGR_IMAGE))
         {
             // Device still in valid state
             result = IControllerInterface::_PollResultSuccessNoData;
@@ -394,6 +405,20 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
         {
             // New data available. Keep iterating.
             result = IControllerInterface::_PollResultSuccessNewData;
+
+            if (RecordStreamID >= 0)
+            {
+                // The recording stores tightly packed frames
+                const cv::Mat frame = CaptureData->frame.isContinuous() ? CaptureData->frame : CaptureData->frame.clone();
+
+                DeviceInputRecorder::getInstance()->recordVideoFrame(
+                    RecordStreamID,
+                    (frame.type() == CV_8UC1) ? _deviceInputPixelFormat_Bayer8 : _deviceInputPixelFormat_BGR8,
+                    frame.cols,
+                    frame.rows,
+                    frame.cols * static_cast<int>(frame.elemSize()),
+                    frame.data);
+            }
         }
 
         {
@@ -405,13 +430,7 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
             newState.PollSequenceNumber = NextPollSequenceNumber;
             ++NextPollSequenceNumber;
 
-            // Make room for new entry if at the max queue size
-            //###bwalker $TODO Make this a fixed size circular buffer
-            if (TrackerStates.size() >= PS3EYE_STATE_BUFFER_MAX)
-            {
-                TrackerStates.erase(TrackerStates.begin(), TrackerStates.begin() + TrackerStates.size() - PS3EYE_STATE_BUFFER_MAX);
-            }
-
+            // Pushing into a full history drops the oldest state
             TrackerStates.push_back(newState);
         }
     }
@@ -421,6 +440,8 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
 
 void PS3EyeTracker::close()
 {
+    RecordStreamID = -1;
+
     if (CaptureData != nullptr)
     {
         delete CaptureData;
@@ -446,9 +467,7 @@ CommonDeviceState::eDeviceType PS3EyeTracker::getDeviceType() const
 
 const CommonDeviceState *PS3EyeTracker::getState(int lookBack) const
 {
-    const int queueSize = static_cast<int>(TrackerStates.size());
-    const CommonDeviceState * result =
-        (lookBack < queueSize) ? &TrackerStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= TrackerStates.getLookBack(lookBack);
 
     return result;
 }
@@ -526,7 +545,19 @@ const unsigned char *PS3EyeTracker::getVideoFrameBuffer() const
 {
     const unsigned char *result = nullptr;
 
-    if (CaptureData != nullptr)
+    if (CaptureData != nullptr && CaptureData->frame.type() == CV_8UC3)
+    {
+        return static_cast<const unsigned char *>(CaptureData->frame.data);
+    }
+
+    return result;
+}
+
+const unsigned char *PS3EyeTracker::getVideoFrameBayerBuffer() const
+{
+    const unsigned char *result = nullptr;
+
+    if (CaptureData != nullptr && CaptureData->frame.type() == CV_8UC1)
     {
         return static_cast<const unsigned char *>(CaptureData->frame.data);
     }
@@ -534,6 +565,19 @@ const unsigned char *PS3EyeTracker::getVideoFrameBuffer() const
     return result;
 }
 
+bool PS3EyeTracker::setCaptureRawBayerFrames(bool bCaptureRawBayer)
+{
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        bSuccess = !bCaptureRawBayer || VideoCapture->getSupportsRawBayerRetrieve();
+        CaptureData->bCaptureRawBayer = bCaptureRawBayer && bSuccess;
+    }
+
+    return bSuccess;
+}
+
 void PS3EyeTracker::loadSettings()
 {
 	const double currentFrameWidth = VideoCapture->get(cv::CAP_PROP_FRAME_WIDTH);
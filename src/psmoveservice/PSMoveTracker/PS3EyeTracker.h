@@ -5,9 +5,12 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
 #include <string>
 #include <vector>
-#include <deque>
+
+// -- constants -----
+#define PS3EYE_STATE_BUFFER_MAX 16
 
 // -- pre-declarations -----
 namespace PSMoveProtocol
@@ -33,7 +36,7 @@ public:
     virtual void ptree2config(const boost::property_tree::ptree &pt);
 
 	const CommonHSVColorRangeTable *getColorRangeTable(const std::string &table_name) const;
-	inline CommonHSVColorRangeTable *getOrAddColorRangeTable(const std::string &table_name);
+	CommonHSVColorRangeTable *getOrAddColorRangeTable(const std::string &table_name);
     
     bool is_valid;
     long max_poll_failure_count;
@@ -105,6 +108,8 @@ public:
     std::string getUSBDevicePath() const override;
     bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
     const unsigned char *getVideoFrameBuffer() const override;
+    const unsigned char *getVideoFrameBayerBuffer() const override;
+    bool setCaptureRawBayerFrames(bool bCaptureRawBayer) override;
     void loadSettings() override;
     void saveSettings() override;
 	void setFrameWidth(double value, bool bUpdateConfig) override;
@@ -148,9 +153,10 @@ private:
     class PSEyeVideoCapture *VideoCapture;
     class PSEyeCaptureData *CaptureData;
     ITrackerInterface::eDriverType DriverType;    
+    int RecordStreamID;                           // >= 0 if recording the video frames of the tracker
     
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PS3EyeTrackerState> TrackerStates;
+    DeviceStateRingBuffer<PS3EyeTrackerState, PS3EYE_STATE_BUFFER_MAX> TrackerStates;
 };
 #endif // PS3EYE_TRACKER_H
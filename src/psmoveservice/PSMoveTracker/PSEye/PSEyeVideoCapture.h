@@ -26,6 +26,12 @@ but we use custom cv::VideoCapture::set() and \ref get() to change parameters vi
 */
 class PSEyeVideoCapture : public cv::VideoCapture {
 public:
+    enum eRetrieveFlag
+    {
+        /// Pass to retrieve() to get the raw sensor frame (CV_8UC1, GBRG Bayer pattern)
+        /// instead of a debayered BGR frame. Only honored when getSupportsRawBayerRetrieve() is true.
+        RETRIEVE_RAW_BAYER = 0x1000
+    };
 
     /**
     \param camindex The index of the camera (0-based). To specify an API
@@ -48,6 +54,9 @@ public:
 
     /// Get the unique identifier for the camera
     std::string getUniqueIndentifier() const;
+
+    /// True if retrieve() can hand back the raw Bayer frame (PS3EYEDriver only)
+    bool getSupportsRawBayerRetrieve() const;
     
 protected:
     int m_index; /**< Keep track of index. Necessary for PSEYE_CLEYE_DRIVER */
@@ -0,0 +1,438 @@
+// -- includes -----
+#include "ReplayTracker.h"
+#include "DeviceInputReplayer.h"
+#include "ReplayDeviceEnumerator.h"
+#include "ServerLog.h"
+#include "PSMoveProtocol.pb.h"
+
+// -- constants -----
+static const char *OPTION_FOV_SETTING = "FOV Setting";
+static const char *OPTION_FOV_RED_DOT = "Red Dot";
+static const char *OPTION_FOV_BLUE_DOT = "Blue Dot";
+
+// -- Replay Tracker
+ReplayTracker::ReplayTracker()
+    : cfg()
+    , USBDevicePath()
+    , DeviceType(CommonDeviceState::PS3EYE)
+    , ReplayStreamID(-1)
+    , FrameWidth(0)
+    , FrameHeight(0)
+    , FramePixelFormat(_deviceInputPixelFormat_BGR8)
+    , FramePixels(nullptr)
+    , NextPollSequenceNumber(0)
+    , TrackerStates()
+{
+}
+
+ReplayTracker::~ReplayTracker()
+{
+    if (getIsOpen())
+    {
+        SERVER_LOG_ERROR("~ReplayTracker") << "Tracker deleted without calling close() first!";
+    }
+}
+
+// -- IDeviceInterface
+bool ReplayTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
+{
+    const char *enumerator_path = enumerator->get_path();
+
+    return enumerator_path != nullptr && USBDevicePath == enumerator_path;
+}
+
+bool ReplayTracker::open(const DeviceEnumerator *enumerator)
+{
+    const ReplayDeviceEnumerator *replay_enum = static_cast<const ReplayDeviceEnumerator *>(enumerator);
+    const DeviceInputReplayer *replayer = DeviceInputReplayer::getInstance();
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        SERVER_LOG_WARNING("ReplayTracker::open") << "ReplayTracker(" << USBDevicePath << ") already open. Ignoring request.";
+        bSuccess = true;
+    }
+    else if (replayer != nullptr)
+    {
+        const int stream_id = replay_enum->get_stream_id();
+        DeviceInputVideoFrameInfo first_frame_info;
+
+        SERVER_LOG_INFO("ReplayTracker::open") << "Replaying tracker(" << replayer->getStreamDevicePath(stream_id)
+            << ") from stream " << stream_id;
+
+        if (replayer->peekFirstVideoFrameInfo(stream_id, first_frame_info) &&
+            first_frame_info.width > 0 && first_frame_info.height > 0)
+        {
+            // Use the config the tracker was recorded with.
+            // Never saved: the recording shouldn't change the local config of the tracker.
+            std::string config_name = "PS3EyeTrackerConfig_";
+            config_name.append(replayer->getStreamDeviceSerial(stream_id));
+
+            cfg = PS3EyeTrackerConfig(config_name);
+            if (!cfg.loadFromString(replayer->getStreamConfig(stream_id)))
+            {
+                SERVER_LOG_WARNING("ReplayTracker::open") << "Recording has no valid config for tracker(" << enumerator->get_path() << "). Using defaults.";
+            }
+
+            USBDevicePath = enumerator->get_path();
+            DeviceType = replayer->getStreamDeviceType(stream_id);
+            FrameWidth = first_frame_info.width;
+            FrameHeight = first_frame_info.height;
+            FramePixelFormat = first_frame_info.pixel_format;
+            FramePixels = nullptr;
+            ReplayStreamID = stream_id;
+            NextPollSequenceNumber = 0;
+            bSuccess = true;
+        }
+        else
+        {
+            SERVER_LOG_ERROR("ReplayTracker::open") << "Recording has no video frames for tracker(" << enumerator->get_path() << ")";
+        }
+    }
+
+    return bSuccess;
+}
+
+bool ReplayTracker::getIsOpen() const
+{
+    return ReplayStreamID >= 0;
+}
+
+bool ReplayTracker::getIsReadyToPoll() const
+{
+    return getIsOpen();
+}
+
+IDeviceInterface::ePollResult ReplayTracker::poll()
+{
+    IDeviceInterface::ePollResult result = IDeviceInterface::_PollResultFailure;
+
+    if (getIsOpen())
+    {
+        DeviceInputVideoFrameInfo frame_info;
+        const unsigned char *frame_pixels = nullptr;
+        std::chrono::time_point<std::chrono::high_resolution_clock> arrival_timestamp;
+
+        // Frames with another size or format than the first one can't be handed to the tracker view
+        if (!DeviceInputReplayer::getInstance()->readVideoFrame(ReplayStreamID, frame_info, frame_pixels, arrival_timestamp) ||
+            frame_info.width != FrameWidth ||
+            frame_info.height != FrameHeight ||
+            frame_info.pixel_format != FramePixelFormat)
+        {
+            // Device still in valid state
+            result = IDeviceInterface::_PollResultSuccessNoData;
+        }
+        else
+        {
+            // New data available. Keep iterating.
+            result = IDeviceInterface::_PollResultSuccessNewData;
+
+            FramePixels = frame_pixels;
+
+            PS3EyeTrackerState newState;
+            newState.ArrivalTimestamp = arrival_timestamp;
+
+            // Increment the sequence for every new polling packet
+            newState.PollSequenceNumber = NextPollSequenceNumber;
+            ++NextPollSequenceNumber;
+
+            // Pushing into a full history drops the oldest state
+            TrackerStates.push_back(newState);
+        }
+    }
+
+    return result;
+}
+
+void ReplayTracker::close()
+{
+    ReplayStreamID = -1;
+    FramePixels = nullptr;
+}
+
+long ReplayTracker::getMaxPollFailureCount() const
+{
+    return cfg.max_poll_failure_count;
+}
+
+CommonDeviceState::eDeviceType ReplayTracker::getDeviceType() const
+{
+    return DeviceType;
+}
+
+const CommonDeviceState *ReplayTracker::getState(int lookBack) const
+{
+    const CommonDeviceState * result= TrackerStates.getLookBack(lookBack);
+
+    return result;
+}
+
+// -- ITrackerInterface
+ITrackerInterface::eDriverType ReplayTracker::getDriverType() const
+{
+    return ITrackerInterface::Libusb;
+}
+
+std::string ReplayTracker::getUSBDevicePath() const
+{
+    return USBDevicePath;
+}
+
+bool ReplayTracker::getVideoFrameDimensions(
+    int *out_width,
+    int *out_height,
+    int *out_stride) const
+{
+    if (out_width != nullptr)
+    {
+        *out_width = FrameWidth;
+    }
+
+    if (out_height != nullptr)
+    {
+        *out_height = FrameHeight;
+    }
+
+    // The tracker view always works on BGR frames, even when it debayers them itself
+    if (out_stride != nullptr)
+    {
+        *out_stride = 3 * FrameWidth;
+    }
+
+    return getIsOpen();
+}
+
+const unsigned char *ReplayTracker::getVideoFrameBuffer() const
+{
+    return (FramePixelFormat == _deviceInputPixelFormat_BGR8) ? FramePixels : nullptr;
+}
+
+const unsigned char *ReplayTracker::getVideoFrameBayerBuffer() const
+{
+    return (FramePixelFormat == _deviceInputPixelFormat_Bayer8) ? FramePixels : nullptr;
+}
+
+bool ReplayTracker::setCaptureRawBayerFrames(bool bCaptureRawBayer)
+{
+    // The frames come in the format they got recorded in
+    return getIsOpen() && bCaptureRawBayer == (FramePixelFormat == _deviceInputPixelFormat_Bayer8);
+}
+
+void ReplayTracker::loadSettings()
+{
+    // Keep the recorded config
+}
+
+void ReplayTracker::saveSettings()
+{
+    // Never save the recorded config over the local one
+}
+
+void ReplayTracker::setFrameWidth(double value, bool bUpdateConfig)
+{
+    // The recorded frames can't be resized
+	if (bUpdateConfig)
+	{
+		cfg.frame_width = value;
+	}
+}
+
+double ReplayTracker::getFrameWidth() const
+{
+	return static_cast<double>(FrameWidth);
+}
+
+void ReplayTracker::setFrameHeight(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.frame_height = value;
+	}
+}
+
+double ReplayTracker::getFrameHeight() const
+{
+	return static_cast<double>(FrameHeight);
+}
+
+void ReplayTracker::setFrameRate(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.frame_rate = value;
+	}
+}
+
+double ReplayTracker::getFrameRate() const
+{
+	return cfg.frame_rate;
+}
+
+void ReplayTracker::setExposure(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.exposure = value;
+	}
+}
+
+double ReplayTracker::getExposure() const
+{
+    return cfg.exposure;
+}
+
+void ReplayTracker::setGain(double value, bool bUpdateConfig)
+{
+	if (bUpdateConfig)
+	{
+		cfg.gain = value;
+	}
+}
+
+double ReplayTracker::getGain() const
+{
+	return cfg.gain;
+}
+
+void ReplayTracker::getCameraIntrinsics(
+    float &outFocalLengthX, float &outFocalLengthY,
+    float &outPrincipalX, float &outPrincipalY,
+    float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+    float &outDistortionP1, float &outDistortionP2) const
+{
+    outFocalLengthX = static_cast<float>(cfg.focalLengthX);
+    outFocalLengthY = static_cast<float>(cfg.focalLengthY);
+    outPrincipalX = static_cast<float>(cfg.principalX);
+    outPrincipalY = static_cast<float>(cfg.principalY);
+    outDistortionK1 = static_cast<float>(cfg.distortionK1);
+    outDistortionK2 = static_cast<float>(cfg.distortionK2);
+    outDistortionK3 = static_cast<float>(cfg.distortionK3);
+    outDistortionP1 = static_cast<float>(cfg.distortionP1);
+    outDistortionP2 = static_cast<float>(cfg.distortionP2);
+}
+
+void ReplayTracker::setCameraIntrinsics(
+    float focalLengthX, float focalLengthY,
+    float principalX, float principalY,
+    float distortionK1, float distortionK2, float distortionK3,
+    float distortionP1, float distortionP2)
+{
+    cfg.focalLengthX = focalLengthX;
+    cfg.focalLengthY = focalLengthY;
+    cfg.principalX = principalX;
+    cfg.principalY = principalY;
+    cfg.distortionK1 = distortionK1;
+    cfg.distortionK2 = distortionK2;
+    cfg.distortionK3 = distortionK3;
+    cfg.distortionP1 = distortionP1;
+    cfg.distortionP2 = distortionP2;
+}
+
+CommonDevicePose ReplayTracker::getTrackerPose() const
+{
+    return cfg.pose;
+}
+
+void ReplayTracker::setTrackerPose(
+    const struct CommonDevicePose *pose)
+{
+    cfg.pose = *pose;
+}
+
+void ReplayTracker::getFOV(float &outHFOV, float &outVFOV) const
+{
+    outHFOV = static_cast<float>(cfg.hfov);
+    outVFOV = static_cast<float>(cfg.vfov);
+}
+
+void ReplayTracker::getZRange(float &outZNear, float &outZFar) const
+{
+    outZNear = static_cast<float>(cfg.zNear);
+    outZFar = static_cast<float>(cfg.zFar);
+}
+
+void ReplayTracker::gatherTrackerOptions(
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    PSMoveProtocol::OptionSet *optionSet = settings->add_option_sets();
+
+    optionSet->set_option_name(OPTION_FOV_SETTING);
+    optionSet->add_option_strings(OPTION_FOV_RED_DOT);
+    optionSet->add_option_strings(OPTION_FOV_BLUE_DOT);
+    optionSet->set_option_index(static_cast<int>(cfg.fovSetting));
+}
+
+bool ReplayTracker::setOptionIndex(
+    const std::string &option_name,
+    int option_index)
+{
+    bool bValidOption = false;
+
+    if (option_name == OPTION_FOV_SETTING &&
+        option_index >= 0 &&
+        option_index < PS3EyeTrackerConfig::eFOVSetting::MAX_FOV_SETTINGS)
+    {
+        cfg.fovSetting = static_cast<PS3EyeTrackerConfig::eFOVSetting>(option_index);
+
+        bValidOption = true;
+    }
+
+    return bValidOption;
+}
+
+bool ReplayTracker::getOptionIndex(
+    const std::string &option_name,
+    int &out_option_index) const
+{
+    bool bValidOption = false;
+
+    if (option_name == OPTION_FOV_SETTING)
+    {
+        out_option_index = static_cast<int>(cfg.fovSetting);
+        bValidOption = true;
+    }
+
+    return bValidOption;
+}
+
+void ReplayTracker::gatherTrackingColorPresets(
+	const std::string &controller_serial,
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+	const CommonHSVColorRangeTable *table= cfg.getColorRangeTable(controller_serial);
+
+    for (int list_index = 0; list_index < MAX_TRACKING_COLOR_TYPES; ++list_index)
+    {
+        const CommonHSVColorRange &hsvRange = table->color_presets[list_index];
+        const eCommonTrackingColorID colorType = static_cast<eCommonTrackingColorID>(list_index);
+
+        PSMoveProtocol::TrackingColorPreset *colorPreset= settings->add_color_presets();
+        colorPreset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(colorType));
+        colorPreset->set_hue_center(hsvRange.hue_range.center);
+        colorPreset->set_hue_range(hsvRange.hue_range.range);
+        colorPreset->set_saturation_center(hsvRange.saturation_range.center);
+        colorPreset->set_saturation_range(hsvRange.saturation_range.range);
+        colorPreset->set_value_center(hsvRange.value_range.center);
+        colorPreset->set_value_range(hsvRange.value_range.range);
+    }
+}
+
+void ReplayTracker::setTrackingColorPreset(
+	const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    const CommonHSVColorRange *preset)
+{
+	CommonHSVColorRangeTable *table= cfg.getOrAddColorRangeTable(controller_serial);
+
+    table->color_presets[color] = *preset;
+}
+
+void ReplayTracker::getTrackingColorPreset(
+	const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+	const CommonHSVColorRangeTable *table= cfg.getColorRangeTable(controller_serial);
+
+    *out_preset = table->color_presets[color];
+}
@@ -0,0 +1,90 @@
+#ifndef REPLAY_TRACKER_H
+#define REPLAY_TRACKER_H
+
+// -- includes -----
+#include "PS3EyeTracker.h"
+#include "DeviceEnumerator.h"
+#include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
+#include <string>
+
+// -- definitions -----
+/// Stands in for a tracker recorded by the DeviceInputRecorder.
+/// Serves the recorded video frames (BGR or raw Bayer, whichever got recorded) in place of a camera,
+/// so ServerTrackerView segments and projects them exactly like live frames.
+/// Uses the config the tracker was recorded with and never saves it.
+class ReplayTracker : public ITrackerInterface {
+public:
+    ReplayTracker();
+    virtual ~ReplayTracker();
+
+    // -- IDeviceInterface
+    bool matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const override;
+    bool open(const DeviceEnumerator *enumerator) override;
+    bool getIsOpen() const override;
+    bool getIsReadyToPoll() const override;
+    IDeviceInterface::ePollResult poll() override;
+    void close() override;
+    long getMaxPollFailureCount() const override;
+    CommonDeviceState::eDeviceType getDeviceType() const override;
+    const CommonDeviceState *getState(int lookBack = 0) const override;
+
+    // -- ITrackerInterface
+    ITrackerInterface::eDriverType getDriverType() const override;
+    std::string getUSBDevicePath() const override;
+    bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
+    const unsigned char *getVideoFrameBuffer() const override;
+    const unsigned char *getVideoFrameBayerBuffer() const override;
+    bool setCaptureRawBayerFrames(bool bCaptureRawBayer) override;
+    void loadSettings() override;
+    void saveSettings() override;
+	void setFrameWidth(double value, bool bUpdateConfig) override;
+	double getFrameWidth() const override;
+	void setFrameHeight(double value, bool bUpdateConfig) override;
+	double getFrameHeight() const override;
+	void setFrameRate(double value, bool bUpdateConfig) override;
+	double getFrameRate() const override;
+    void setExposure(double value, bool bUpdateConfig) override;
+    double getExposure() const override;
+	void setGain(double value, bool bUpdateConfig) override;
+	double getGain() const override;
+    void getCameraIntrinsics(
+        float &outFocalLengthX, float &outFocalLengthY,
+        float &outPrincipalX, float &outPrincipalY,
+        float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+        float &outDistortionP1, float &outDistortionP2) const override;
+    void setCameraIntrinsics(
+        float focalLengthX, float focalLengthY,
+        float principalX, float principalY,
+        float distortionK1, float distortionK2, float distortionK3,
+        float distortionP1, float distortionP2) override;
+    CommonDevicePose getTrackerPose() const override;
+    void setTrackerPose(const struct CommonDevicePose *pose) override;
+    void getFOV(float &outHFOV, float &outVFOV) const override;
+    void getZRange(float &outZNear, float &outZFar) const override;
+    void gatherTrackerOptions(PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    bool setOptionIndex(const std::string &option_name, int option_index) override;
+    bool getOptionIndex(const std::string &option_name, int &out_option_index) const override;
+    void gatherTrackingColorPresets(const std::string &controller_serial, PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    void setTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, const CommonHSVColorRange *preset) override;
+    void getTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const override;
+
+private:
+    PS3EyeTrackerConfig cfg;
+    std::string USBDevicePath;
+    CommonDeviceState::eDeviceType DeviceType;
+    int ReplayStreamID;                           // >= 0 while open
+
+    // The recorded frame size and format (can't change during a replay)
+    int FrameWidth;
+    int FrameHeight;
+    int FramePixelFormat;                         // eDeviceInputPixelFormat
+
+    // Last frame served, points into the recording
+    const unsigned char *FramePixels;
+
+    // Read Tracker State
+    int NextPollSequenceNumber;
+    DeviceStateRingBuffer<PS3EyeTrackerState, PS3EYE_STATE_BUFFER_MAX> TrackerStates;
+};
+#endif // REPLAY_TRACKER_H
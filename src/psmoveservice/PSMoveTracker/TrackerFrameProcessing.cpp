@@ -0,0 +1,1378 @@
+//-- includes -----
+#include "TrackerFrameProcessing.h"
+#include "BGRToHSVConverter.h"
+#include "MathAlignment.h"
+#include "MathUtility.h"
+#include "ServerLog.h"
+
+#include "opencv2/calib3d/calib3d.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//-- private methods -----
+static void commonDeviceOrientationToOpenCVRodrigues(
+    const CommonDeviceQuaternion &orientation,
+    cv::Mat &rvec);
+static void openCVRodriguesToAngleAxis(
+    const cv::Mat &rvec,
+    float &axis_x, float &axis_y, float &axis_z, float &radians);
+static void angleAxisVectorToEulerAngles(
+    const float axis_x, const float axis_y, const float axis_z, const float radians,
+    float &yaw, float &pitch, float &roll);
+static void angleAxisVectorToCommonDeviceOrientation(
+    const float axis_x, const float axis_y, const float axis_z, const float radians,
+    CommonDeviceQuaternion &orientation);
+
+
+class OpenCVBGRToHSVMapper
+{
+public:
+    typedef cv::Point3_<uint8_t> ColorTuple;
+
+    static OpenCVBGRToHSVMapper *allocate()
+    {
+        if (m_refCount == 0)
+        {
+            assert(m_instance == nullptr);
+            m_instance = new OpenCVBGRToHSVMapper();
+        }
+        assert(m_instance != nullptr);
+
+        ++m_refCount;
+        return m_instance;
+    }
+
+    static void dispose(OpenCVBGRToHSVMapper *instance)
+    {
+        assert(m_instance != nullptr);
+        assert(m_instance == instance);
+        assert(m_refCount > 0);
+
+        --m_refCount;
+        if (m_refCount <= 0)
+        {
+            delete m_instance;
+            m_instance = nullptr;
+        }
+    }
+
+    void cvtColor(const cv::Mat &bgrBuffer, cv::Mat &hsvBuffer)
+    {
+        hsvBuffer.forEach<ColorTuple>([&bgrBuffer, this](ColorTuple &hsvColor, const int position[]) -> void {
+            const ColorTuple &bgrColor = bgrBuffer.at<ColorTuple>(position[0], position[1]);
+            const int b = bgrColor.x;
+            const int g = bgrColor.y;
+            const int r = bgrColor.z;
+            const int LUTIndex = OpenCVBGRToHSVMapper::getLUTIndex(r, g, b);
+
+            hsvColor = bgr2hsv->at<ColorTuple>(LUTIndex, 0);
+        });
+    }
+
+private:
+    static OpenCVBGRToHSVMapper *m_instance;
+    static int m_refCount;
+
+    OpenCVBGRToHSVMapper()
+    {
+        bgr2hsv = new cv::Mat(256*256*256, 1, CV_8UC3);
+
+        int LUTIndex = 0;
+        for (int r = 0; r < 256; ++r)
+        {
+            for (int g = 0; g < 256; ++g)
+            {
+                for (int b = 0; b < 256; ++b)
+                {
+                    bgr2hsv->at<ColorTuple>(LUTIndex, 0) = ColorTuple(b, g, r);
+                    ++LUTIndex;
+                }
+            }
+        }
+
+        cv::cvtColor(*bgr2hsv, *bgr2hsv, cv::COLOR_BGR2HSV);
+    }
+
+    ~OpenCVBGRToHSVMapper()
+    {
+        delete bgr2hsv;
+    }
+
+    static int getLUTIndex(int r, int g, int b)
+    {
+        return (256 * 256)*r + 256*g + b;
+    }
+
+    cv::Mat *bgr2hsv;
+};
+OpenCVBGRToHSVMapper *OpenCVBGRToHSVMapper::m_instance = nullptr;
+int OpenCVBGRToHSVMapper::m_refCount= 0;
+
+//-- OpenCVBufferState -----
+OpenCVBufferState::OpenCVBufferState(int frame_width, int frame_height, const std::string &bgr_to_hsv_converter)
+    : frameWidth(frame_width)
+    , frameHeight(frame_height)
+    , bayerBuffer(nullptr)
+    , bDebayerPerTile(false)
+    , bgrBuffer(nullptr)
+    , bgrShmemBuffer(nullptr)
+    , overlayCommandCount(0)
+    , hsvBuffer(nullptr)
+    , gsLowerBuffer(nullptr)
+    , labelBuffer(nullptr)
+    , maskedBuffer(nullptr)
+{
+    bayerBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
+    bgrBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+    bgrShmemBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+    hsvBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+    gsLowerBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
+    labelBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
+    maskedBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
+
+    // One "converted" flag per tile of the hsv buffer
+    hsvTileColumnCount = (frameWidth + k_hsv_cache_tile_size - 1) / k_hsv_cache_tile_size;
+    hsvTileRowCount = (frameHeight + k_hsv_cache_tile_size - 1) / k_hsv_cache_tile_size;
+    hsvTileValid.resize(hsvTileColumnCount*hsvTileRowCount);
+    labelTileValid.resize(hsvTileColumnCount*hsvTileRowCount);
+    invalidateHsvBuffer();
+
+    std::memset(hueLabels, 0, sizeof(hueLabels));
+    std::memset(saturationLabels, 0, sizeof(saturationLabels));
+    std::memset(valueLabels, 0, sizeof(valueLabels));
+    
+    if (bgr_to_hsv_converter == "lookup_table")
+    {
+        bgr2hsv = OpenCVBGRToHSVMapper::allocate();
+        bUseSIMDConverter = false;
+    }
+    else
+    {
+        bgr2hsv = nullptr;
+        bUseSIMDConverter = bgr_to_hsv_converter != "opencv";
+    }
+    
+    //Apply default ROI (full frame).
+    applyROI(cv::Rect2i(cv::Point(0,0), cv::Size(frameWidth, frameHeight)));
+}
+
+OpenCVBufferState::~OpenCVBufferState()
+{
+    if (maskedBuffer != nullptr)
+    {
+        delete maskedBuffer;
+    }
+    
+    if (gsLowerBuffer != nullptr)
+    {
+        delete gsLowerBuffer;
+    }
+    
+    if (labelBuffer != nullptr)
+    {
+        delete labelBuffer;
+    }
+    
+    if (hsvBuffer != nullptr)
+    {
+        delete hsvBuffer;
+    }
+    
+    if (bgrShmemBuffer != nullptr)
+    {
+        delete bgrShmemBuffer;
+    }
+    
+    if (bgrBuffer != nullptr)
+    {
+        delete bgrBuffer;
+    }
+
+    if (bayerBuffer != nullptr)
+    {
+        delete bayerBuffer;
+    }
+    
+    if (bgr2hsv != nullptr)
+    {
+        OpenCVBGRToHSVMapper::dispose(bgr2hsv);
+    }
+}
+
+void OpenCVBufferState::writeVideoFrame(const unsigned char *video_buffer)
+{
+    const cv::Mat videoBufferMat(frameHeight, frameWidth, CV_8UC3, const_cast<unsigned char *>(video_buffer));
+
+    videoBufferMat.copyTo(*bgrBuffer);
+    bDebayerPerTile = false;
+    invalidateHsvBuffer();
+    overlayCommandCount = 0;
+}
+
+void OpenCVBufferState::writeBayerFrame(const unsigned char *bayer_buffer, bool bDebayerFullFrame)
+{
+    const cv::Mat bayerBufferMat(frameHeight, frameWidth, CV_8UC1, const_cast<unsigned char *>(bayer_buffer));
+
+    bayerBufferMat.copyTo(*bayerBuffer);
+    if (bDebayerFullFrame)
+    {
+        cv::cvtColor(*bayerBuffer, *bgrBuffer, cv::COLOR_BayerGB2BGR);
+    }
+    bDebayerPerTile = !bDebayerFullFrame;
+    invalidateHsvBuffer();
+    overlayCommandCount = 0;
+}
+
+void OpenCVBufferState::clearVideoFrame()
+{
+    bDebayerPerTile = true;
+    overlayCommandCount = 0;
+}
+
+void OpenCVBufferState::invalidateHsvBuffer()
+{
+    std::fill(hsvTileValid.begin(), hsvTileValid.end(), false);
+    std::fill(labelTileValid.begin(), labelTileValid.end(), false);
+}
+
+void OpenCVBufferState::updateHsvBuffer()
+{
+    const int tile_col_begin = currentROI.x / k_hsv_cache_tile_size;
+    const int tile_col_end = (currentROI.x + currentROI.width - 1) / k_hsv_cache_tile_size;
+    const int tile_row_begin = currentROI.y / k_hsv_cache_tile_size;
+    const int tile_row_end = (currentROI.y + currentROI.height - 1) / k_hsv_cache_tile_size;
+
+    for (int tile_row = tile_row_begin; tile_row <= tile_row_end; ++tile_row)
+    {
+        int tile_col = tile_col_begin;
+
+        while (tile_col <= tile_col_end)
+        {
+            // Skip over tiles converted by an earlier ROI
+            if (hsvTileValid[tile_row*hsvTileColumnCount + tile_col])
+            {
+                ++tile_col;
+                continue;
+            }
+
+            // Convert the whole run of adjacent stale tiles in one call
+            const int run_col_begin = tile_col;
+            while (tile_col <= tile_col_end && !hsvTileValid[tile_row*hsvTileColumnCount + tile_col])
+            {
+                hsvTileValid[tile_row*hsvTileColumnCount + tile_col] = true;
+                ++tile_col;
+            }
+
+            const int x0 = run_col_begin*k_hsv_cache_tile_size;
+            const int y0 = tile_row*k_hsv_cache_tile_size;
+            const int x1 = std::min(tile_col*k_hsv_cache_tile_size, frameWidth);
+            const int y1 = std::min((tile_row + 1)*k_hsv_cache_tile_size, frameHeight);
+            const cv::Rect2i tileRun(x0, y0, x1 - x0, y1 - y0);
+
+            if (bDebayerPerTile)
+            {
+                debayerRegion(tileRun);
+            }
+            convertBgrToHsv(cv::Mat(*bgrBuffer, tileRun), cv::Mat(*hsvBuffer, tileRun));
+        }
+    }
+}
+
+void OpenCVBufferState::debayerRegion(const cv::Rect2i &region)
+{
+    const int x0 = std::max((region.x - 2) & ~1, 0);
+    const int y0 = std::max((region.y - 2) & ~1, 0);
+    const int x1 = std::min(region.x + region.width + 2, frameWidth);
+    const int y1 = std::min(region.y + region.height + 2, frameHeight);
+    const cv::Rect2i window(x0, y0, x1 - x0, y1 - y0);
+
+    cv::cvtColor(cv::Mat(*bayerBuffer, window), debayerScratch, cv::COLOR_BayerGB2BGR);
+    cv::Mat(debayerScratch, region - window.tl()).copyTo(cv::Mat(*bgrBuffer, region));
+}
+
+void OpenCVBufferState::convertBgrToHsv(const cv::Mat &bgr, cv::Mat hsv)
+{
+    // Convert the video buffer to the HSV color space
+    if (bUseSIMDConverter)
+    {
+        BGRToHSVConverter::convertImage(
+            bgr.data, static_cast<int>(bgr.step),
+            hsv.data, static_cast<int>(hsv.step),
+            bgr.cols, bgr.rows);
+    }
+    else if (bgr2hsv != nullptr)
+    {
+        bgr2hsv->cvtColor(bgr, hsv);
+    }
+    else
+    {
+        cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+    }
+}
+
+cv::Rect2i OpenCVBufferState::clampROI(const cv::Rect2i &ROI) const
+{
+    int x0= std::min(std::max(ROI.tl().x, 0), frameWidth-1);
+    int y0= std::min(std::max(ROI.tl().y, 0), frameHeight-1);
+    int x1= std::min(std::max(ROI.br().x, 0), frameWidth-1);
+    int y1= std::min(std::max(ROI.br().y, 0), frameHeight-1);
+    int clamped_width = std::max(x1-x0, 0);
+    int clamped_height = std::max(y1-y0, 0);
+
+    // If the clamped ROI ends up being zero-width or zero-height, 
+    // just make it full screen
+    if (clamped_width > 0 && clamped_height > 0)
+    {
+        return cv::Rect2i(x0, y0, clamped_width, clamped_height);
+    }
+    else
+    {
+        return cv::Rect2i(0, 0, frameWidth, frameHeight);
+    }
+}
+
+void OpenCVBufferState::selectROI(const cv::Rect2i &ROI)
+{
+    currentROI = clampROI(ROI);
+   
+    //Create the ROI matrices.
+    //It's not a full copy, so this isn't too slow.
+    //adjustROI is probably slightly faster but I ran into trouble with it.
+    bgrROI = cv::Mat(*bgrBuffer, currentROI);
+    hsvROI = cv::Mat(*hsvBuffer, currentROI);
+    gsLowerROI = cv::Mat(*gsLowerBuffer, currentROI);
+    labelROI = cv::Mat(*labelBuffer, currentROI);
+    
+    updateHsvBuffer();
+}
+
+void OpenCVBufferState::applyROI(const cv::Rect2i &ROI)
+{
+    selectROI(ROI);
+    
+    //Draw ROI.
+    draw_roi(currentROI);
+}
+
+void OpenCVBufferState::setColorLabelRanges(
+    const CommonHSVColorRange * const label_ranges[k_max_color_labels],
+    const int label_count)
+{
+    unsigned char *hue_labels = hueLabels;
+    unsigned char *saturation_labels = saturationLabels;
+    unsigned char *value_labels = valueLabels;
+
+    std::memset(hue_labels, 0, sizeof(hueLabels));
+    std::memset(saturation_labels, 0, sizeof(saturationLabels));
+    std::memset(value_labels, 0, sizeof(valueLabels));
+    std::fill(labelTileValid.begin(), labelTileValid.end(), false);
+
+    for (int label_index = 0; label_index < label_count; ++label_index)
+    {
+        const CommonHSVColorRange *hsvColorRange = label_ranges[label_index];
+        const unsigned char label = static_cast<unsigned char>(1 << label_index);
+        const float hue_min = hsvColorRange->hue_range.center - hsvColorRange->hue_range.range;
+        const float hue_max = hsvColorRange->hue_range.center + hsvColorRange->hue_range.range;
+        const float saturation_min = clampf(hsvColorRange->saturation_range.center - hsvColorRange->saturation_range.range, 0, 255);
+        const float saturation_max = clampf(hsvColorRange->saturation_range.center + hsvColorRange->saturation_range.range, 0, 255);
+        const float value_min = clampf(hsvColorRange->value_range.center - hsvColorRange->value_range.range, 0, 255);
+        const float value_max = clampf(hsvColorRange->value_range.center + hsvColorRange->value_range.range, 0, 255);
+
+        // Same ranges the cv::inRange based segmentation used, taking into account wrapping the hue angle
+        if (hue_min < 0)
+        {
+            add_label_range(hue_labels, 0, clampf(hue_max, 0, 180), label);
+            add_label_range(hue_labels, clampf(180 + hue_min, 0, 180), 180, label);
+        }
+        else if (hue_max > 180)
+        {
+            add_label_range(hue_labels, 0, clampf(hue_max - 180, 0, 180), label);
+            add_label_range(hue_labels, clampf(hue_min, 0, 180), 180, label);
+        }
+        else
+        {
+            add_label_range(hue_labels, hue_min, hue_max, label);
+        }
+        add_label_range(saturation_labels, saturation_min, saturation_max, label);
+        add_label_range(value_labels, value_min, value_max, label);
+    }
+}
+
+void OpenCVBufferState::computeColorLabels(const cv::Rect2i &ROI)
+{
+    selectROI(ROI);
+
+    const int tile_col_begin = currentROI.x / k_hsv_cache_tile_size;
+    const int tile_col_end = (currentROI.x + currentROI.width - 1) / k_hsv_cache_tile_size;
+    const int tile_row_begin = currentROI.y / k_hsv_cache_tile_size;
+    const int tile_row_end = (currentROI.y + currentROI.height - 1) / k_hsv_cache_tile_size;
+
+    for (int tile_row = tile_row_begin; tile_row <= tile_row_end; ++tile_row)
+    {
+        int tile_col = tile_col_begin;
+
+        while (tile_col <= tile_col_end)
+        {
+            // Skip over tiles labeled for an earlier ROI
+            if (labelTileValid[tile_row*hsvTileColumnCount + tile_col])
+            {
+                ++tile_col;
+                continue;
+            }
+
+            // Label the whole run of adjacent stale tiles in one go
+            const int run_col_begin = tile_col;
+            while (tile_col <= tile_col_end && !labelTileValid[tile_row*hsvTileColumnCount + tile_col])
+            {
+                labelTileValid[tile_row*hsvTileColumnCount + tile_col] = true;
+                ++tile_col;
+            }
+
+            const int x0 = run_col_begin*k_hsv_cache_tile_size;
+            const int y0 = tile_row*k_hsv_cache_tile_size;
+            const int x1 = std::min(tile_col*k_hsv_cache_tile_size, frameWidth);
+            const int y1 = std::min((tile_row + 1)*k_hsv_cache_tile_size, frameHeight);
+
+            for (int row = y0; row < y1; ++row)
+            {
+                const unsigned char *hsv_pixel = hsvBuffer->ptr<unsigned char>(row) + 3*x0;
+                unsigned char *label_pixel = labelBuffer->ptr<unsigned char>(row);
+
+                for (int col = x0; col < x1; ++col)
+                {
+                    label_pixel[col] = hueLabels[hsv_pixel[0]] & saturationLabels[hsv_pixel[1]] & valueLabels[hsv_pixel[2]];
+                    hsv_pixel += 3;
+                }
+            }
+        }
+    }
+}
+
+bool OpenCVBufferState::computeBiggestNContoursForLabel(
+    const int label_index,
+    const cv::Rect2i &ROI,
+    t_opencv_int_contour_list &out_biggest_N_contours,
+    std::vector<double> &out_contour_areas,
+    const int max_contour_count,
+    const int min_points_in_contour)
+{
+    out_biggest_N_contours.clear();
+    out_contour_areas.clear();
+
+    selectROI(ROI);
+
+    // Pull this range's mask out of the label map
+    cv::bitwise_and(labelROI, cv::Scalar(1 << label_index), gsLowerROI);
+
+    return find_biggest_N_contours(out_biggest_N_contours, out_contour_areas, max_contour_count, min_points_in_contour);
+}
+
+void OpenCVBufferState::add_label_range(unsigned char *labels, float range_min, float range_max, unsigned char label)
+{
+    // Bounds get rounded to the nearest integer, the same as cv::inRange does for 8-bit images
+    const int index_min = std::max(cvRound(range_min), 0);
+    const int index_max = std::min(cvRound(range_max), 255);
+
+    for (int index = index_min; index <= index_max; ++index)
+    {
+        labels[index] |= label;
+    }
+}
+
+bool OpenCVBufferState::find_biggest_N_contours(
+    t_opencv_int_contour_list &out_biggest_N_contours,
+    std::vector<double> &out_contour_areas,
+    const int max_contour_count,
+    const int min_points_in_contour)
+{
+    //TODO: Why no blurring of the gsLowerBuffer?
+
+    // Find the largest convex blob in the filtered grayscale buffer
+    {
+        struct ContourInfo
+        {
+            int contour_index;
+            double contour_area;
+        };
+        std::vector<ContourInfo> sorted_contour_list;
+
+        // Find all counters in the image buffer
+        cv::Size size; cv::Point ofs;
+        gsLowerROI.locateROI(size, ofs);
+        t_opencv_int_contour_list contours;
+        cv::findContours(gsLowerROI,
+                         contours,
+                         CV_RETR_EXTERNAL,
+                         CV_CHAIN_APPROX_SIMPLE,  //CV_CHAIN_APPROX_NONE?
+                         ofs);
+
+        // Compute the area of each contour
+        int contour_index = 0;
+        for (auto it = contours.begin(); it != contours.end(); ++it) 
+        {
+            const double contour_area = cv::contourArea(*it);
+            const ContourInfo contour_info = { contour_index, contour_area };
+
+            sorted_contour_list.push_back(contour_info);
+            ++contour_index;
+        }
+        
+        // Sort the list of contours by area, largest to smallest
+        if (sorted_contour_list.size() > 1)
+        {
+            std::sort(
+                sorted_contour_list.begin(), sorted_contour_list.end(), 
+                [](const ContourInfo &a, const ContourInfo &b) {
+                    return b.contour_area < a.contour_area;
+            });
+        }
+
+        // Copy up to N valid contours
+        for (auto it = sorted_contour_list.begin(); 
+            it != sorted_contour_list.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
+            ++it)
+        {
+            const ContourInfo &contour_info = *it;
+            t_opencv_int_contour &contour = contours[contour_info.contour_index];
+
+            if (contour.size() > min_points_in_contour)
+            {
+                // Remove any points in contour on edge of camera/ROI
+                // TODO: Contours touching image border will be clipped,
+                // so this might not be necessary.
+                t_opencv_int_contour::iterator it = contour.begin();
+                while (it != contour.end()) 
+                {
+                    if (it->x == 0 || it->x == (frameWidth - 1) || it->y == 0 || it->y == (frameHeight - 1))
+                    {
+                        it = contour.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+
+                // Add cleaned up contour to the output list
+                out_biggest_N_contours.push_back(contour);
+                // Add its area to the output list too.
+                out_contour_areas.push_back(contour_info.contour_area);
+            }
+        }
+    }
+
+    return (out_biggest_N_contours.size() > 0);
+}
+
+void
+OpenCVBufferState::draw_roi(const cv::Rect2i &ROI)
+{
+    DebugOverlayCommand &command = addOverlayCommand(DebugOverlayCommand::DrawROI);
+    command.ROI = ROI;
+}
+
+void
+OpenCVBufferState::draw_contour(const t_opencv_int_contour &contour)
+{
+    DebugOverlayCommand &command = addOverlayCommand(DebugOverlayCommand::DrawContour);
+    command.contour = contour;
+}
+
+void
+OpenCVBufferState::draw_pose_projection(const CommonDeviceTrackingProjection &pose_projection)
+{
+    DebugOverlayCommand &command = addOverlayCommand(DebugOverlayCommand::DrawPoseProjection);
+    command.pose_projection = pose_projection;
+}
+
+bool OpenCVBufferState::rasterizeDebugOverlay()
+{
+    if (bDebayerPerTile)
+    {
+        return false;
+    }
+
+    bgrBuffer->copyTo(*bgrShmemBuffer);
+
+    for (size_t command_index = 0; command_index < overlayCommandCount; ++command_index)
+    {
+        const DebugOverlayCommand &command = overlayCommands[command_index];
+
+        switch (command.command_type)
+        {
+        case DebugOverlayCommand::DrawROI:
+            rasterize_roi(command.ROI);
+            break;
+        case DebugOverlayCommand::DrawContour:
+            rasterize_contour(command.contour);
+            break;
+        case DebugOverlayCommand::DrawPoseProjection:
+            rasterize_pose_projection(command.pose_projection);
+            break;
+        }
+    }
+
+    return true;
+}
+
+DebugOverlayCommand &OpenCVBufferState::addOverlayCommand(DebugOverlayCommand::eCommandType command_type)
+{
+    // Entries (and their contour storage) get reused from frame to frame
+    if (overlayCommandCount >= overlayCommands.size())
+    {
+        overlayCommands.resize(overlayCommandCount + 1);
+    }
+
+    DebugOverlayCommand &command = overlayCommands[overlayCommandCount];
+    command.command_type = command_type;
+    ++overlayCommandCount;
+
+    return command;
+}
+
+void
+OpenCVBufferState::rasterize_roi(const cv::Rect2i &ROI)
+{
+    cv::rectangle(*bgrShmemBuffer, ROI, cv::Scalar(255, 0, 0));
+}
+
+void
+OpenCVBufferState::rasterize_contour(const t_opencv_int_contour &contour)
+{
+    std::vector<t_opencv_int_contour> contours = {contour};
+    const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_int_contour>(contour);
+    cv::drawContours(*bgrShmemBuffer, contours, 0, cv::Scalar(255, 255, 255));
+    cv::rectangle(*bgrShmemBuffer, cv::boundingRect(contour), cv::Scalar(255, 255, 255));
+    cv::drawMarker(*bgrShmemBuffer, massCenter, cv::Scalar(255, 255, 255), 0,
+        (cv::boundingRect(contour).height < cv::boundingRect(contour).width) ?
+        cv::boundingRect(contour).height : cv::boundingRect(contour).width);
+}
+
+void
+OpenCVBufferState::rasterize_pose_projection(const CommonDeviceTrackingProjection &pose_projection)
+{
+    switch (pose_projection.shape_type)
+    {
+    case eCommonTrackingProjectionType::ProjectionType_Ellipse:
+        {
+            // For the sphere, its ellipse projection parameters should already
+            // be calculated, so we can use those parameters to draw an ellipse.
+
+            //Create cv::ellipse from pose_estimate
+            cv::Point ell_center(
+                static_cast<int>(pose_projection.shape.ellipse.center.x),
+                static_cast<int>(pose_projection.shape.ellipse.center.y));
+            cv::Size ell_size(
+                static_cast<int>(pose_projection.shape.ellipse.half_x_extent),
+                static_cast<int>(pose_projection.shape.ellipse.half_y_extent));
+
+            //Draw ellipse on bgrShmemBuffer
+            cv::ellipse(*bgrShmemBuffer,
+                ell_center,
+                ell_size,
+                pose_projection.shape.ellipse.angle,
+                0, 360, cv::Scalar(0, 0, 255));
+            cv::drawMarker(*bgrShmemBuffer, ell_center, cv::Scalar(0, 0, 255), 0,
+                (ell_size.height < ell_size.width) ? ell_size.height * 2 : ell_size.width * 2);
+        } break;
+    case eCommonTrackingProjectionType::ProjectionType_LightBar:
+        {
+            int prev_point_index;
+
+            prev_point_index = CommonDeviceTrackingShape::QuadVertexCount - 1;
+            for (int point_index = 0; point_index < CommonDeviceTrackingShape::QuadVertexCount; ++point_index)
+            {
+                cv::Point pt1(
+                    static_cast<int>(pose_projection.shape.lightbar.quad[prev_point_index].x),
+                    static_cast<int>(pose_projection.shape.lightbar.quad[prev_point_index].y));
+                cv::Point pt2(
+                    static_cast<int>(pose_projection.shape.lightbar.quad[point_index].x),
+                    static_cast<int>(pose_projection.shape.lightbar.quad[point_index].y));
+                cv::line(*bgrShmemBuffer, pt1, pt2, cv::Scalar(0, 0, 255));
+
+                prev_point_index = point_index;
+            }
+
+            prev_point_index = CommonDeviceTrackingShape::TriVertexCount - 1;
+            for (int point_index = 0; point_index < CommonDeviceTrackingShape::TriVertexCount; ++point_index)
+            {
+                cv::Point pt1(
+                    static_cast<int>(pose_projection.shape.lightbar.triangle[prev_point_index].x),
+                    static_cast<int>(pose_projection.shape.lightbar.triangle[prev_point_index].y));
+                cv::Point pt2(
+                    static_cast<int>(pose_projection.shape.lightbar.triangle[point_index].x),
+                    static_cast<int>(pose_projection.shape.lightbar.triangle[point_index].y));
+                cv::line(*bgrShmemBuffer, pt1, pt2, cv::Scalar(0, 0, 255));
+
+                prev_point_index = point_index;
+            }
+            
+        } break;
+    case eCommonTrackingProjectionType::ProjectionType_Points:
+        {
+            for (int point_index = 0; point_index < pose_projection.shape.points.point_count; ++point_index)
+            {
+                cv::Point pt(
+                    static_cast<int>(pose_projection.shape.points.point[point_index].x),
+                    static_cast<int>(pose_projection.shape.points.point[point_index].y));
+                cv::drawMarker(*bgrShmemBuffer, pt, cv::Scalar(0, 0, 255));
+            }
+        } break;
+    default:
+        assert(false && "unreachable");
+        break;
+    }		
+}
+
+static bool is_same_hsv_color_range(const CommonHSVColorRange &a, const CommonHSVColorRange &b)
+{
+    return 
+        a.hue_range.center == b.hue_range.center && a.hue_range.range == b.hue_range.range &&
+        a.saturation_range.center == b.saturation_range.center && a.saturation_range.range == b.saturation_range.range &&
+        a.value_range.center == b.value_range.center && a.value_range.range == b.value_range.range;
+}
+
+//-- public methods -----
+void computeContoursForColorJobs(
+    OpenCVBufferState *buffer_state,
+    const TrackerColorJobList &color_jobs,
+    TrackerFrameResult &frame_result)
+{
+    bool bIsJobPending[k_max_color_jobs];
+    int pending_job_count = 0;
+
+    for (int job_index = 0; job_index < k_max_color_jobs; ++job_index)
+    {
+        const TrackerColorJob &job = color_jobs.jobs[job_index];
+        TrackerColorResult &color_result = frame_result.color_results[job_index];
+
+        color_result.bIsActive = job.bIsActive;
+        color_result.ROI = job.ROI;
+        color_result.contours.clear();
+        color_result.contour_areas.clear();
+
+        bIsJobPending[job_index] = job.bIsActive;
+        if (job.bIsActive)
+        {
+            ++pending_job_count;
+        }
+    }
+
+    while (pending_job_count > 0)
+    {
+        const CommonHSVColorRange *label_ranges[k_max_color_labels];
+        int job_label_indices[k_max_color_jobs];
+        int label_count = 0;
+
+        // Hand out the label bits for this pass
+        for (int job_index = 0; job_index < k_max_color_jobs; ++job_index)
+        {
+            const TrackerColorJob &job = color_jobs.jobs[job_index];
+
+            job_label_indices[job_index] = -1;
+
+            if (!bIsJobPending[job_index])
+                continue;
+
+            for (int label_index = 0; label_index < label_count; ++label_index)
+            {
+                if (is_same_hsv_color_range(*label_ranges[label_index], job.hsv_color_range))
+                {
+                    job_label_indices[job_index] = label_index;
+                    break;
+                }
+            }
+
+            if (job_label_indices[job_index] == -1 && label_count < k_max_color_labels)
+            {
+                label_ranges[label_count] = &job.hsv_color_range;
+                job_label_indices[job_index] = label_count;
+                ++label_count;
+            }
+        }
+
+        buffer_state->setColorLabelRanges(label_ranges, label_count);
+
+        for (int job_index = 0; job_index < k_max_color_jobs; ++job_index)
+        {
+            const TrackerColorJob &job = color_jobs.jobs[job_index];
+            TrackerColorResult &color_result = frame_result.color_results[job_index];
+
+            if (job_label_indices[job_index] != -1)
+            {
+                buffer_state->computeColorLabels(job.ROI);
+                buffer_state->computeBiggestNContoursForLabel(
+                    job_label_indices[job_index],
+                    job.ROI,
+                    color_result.contours, 
+                    color_result.contour_areas, 
+                    job.max_contour_count);
+
+                bIsJobPending[job_index] = false;
+                --pending_job_count;
+            }
+        }
+    }
+}
+
+void computeUndistortedContour(
+    const t_opencv_int_contour &contour,
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const bool bNormalizedCoordinates,
+    t_opencv_float_contour &out_undistorted_contour)
+{
+    // Convert integer contour to float
+    t_opencv_float_contour contour_f;
+    cv::Mat(contour).convertTo(contour_f, cv::Mat(contour_f).type());
+
+    if (bNormalizedCoordinates)
+    {
+        // Omitting the rectification and new camera matrix arguments
+        // leaves the points relative to their F_PX,F_PY
+        cv::undistortPoints(contour_f, out_undistorted_contour,
+                            camera_matrix,
+                            distortions);
+    }
+    else
+    {
+        cv::undistortPoints(contour_f, out_undistorted_contour,
+                            camera_matrix,
+                            distortions,
+                            cv::noArray(),
+                            camera_matrix);
+    }
+}
+
+bool computeTrackerRelativeSphereProjection(
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour &normalized_contour,
+    const cv::Matx33f &camera_matrix,
+    CommonDevicePosition *out_position_cm,
+    CommonDeviceTrackingProjection *out_projection)
+{
+    assert(tracking_shape->shape_type == eCommonTrackingShapeType::Sphere);
+
+    // Compute the sphere center AND the projected ellipse
+    Eigen::Vector3f sphere_center;
+    EigenFitEllipse ellipse_projection;
+
+    std::vector<Eigen::Vector2f> eigen_contour;
+    std::for_each(normalized_contour.begin(),
+                  normalized_contour.end(),
+                  [&eigen_contour](const cv::Point2f& p) {
+                      eigen_contour.push_back(Eigen::Vector2f(p.x, p.y));
+                  });
+    eigen_alignment_fit_focal_cone_to_sphere(eigen_contour.data(),
+                                             static_cast<int>(eigen_contour.size()),
+                                             tracking_shape->shape.sphere.radius_cm,
+                                             1, //I was expecting this to be -1. Is it +1 because we're using -F_PY?
+                                             &sphere_center,
+                                             &ellipse_projection);
+
+    bool bValidTrackerProjection= false;
+    if (ellipse_projection.area > k_real_epsilon)
+    {
+        //Save the optically-estimate 3D position.
+        out_position_cm->set(sphere_center.x(), sphere_center.y(), sphere_center.z());
+
+        // Save off the projection of the sphere (an ellipse)
+        out_projection->shape.ellipse.angle = ellipse_projection.angle;
+        //The ellipse projection is still in normalized space.
+        //i.e., it is a 2-dimensional ellipse floating somewhere.
+        //We must reproject it onto the camera.
+        //TODO: Use opencv's project points instead of manual way below
+        //because it will account for distortion, at least for the center point.
+        out_projection->shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
+        out_projection->shape.ellipse.center.set(
+            ellipse_projection.center.x()*camera_matrix.val[0] + camera_matrix.val[2],
+            ellipse_projection.center.y()*camera_matrix.val[4] + camera_matrix.val[5]);
+        out_projection->shape.ellipse.half_x_extent = ellipse_projection.extents.x()*camera_matrix.val[0];
+        out_projection->shape.ellipse.half_y_extent = ellipse_projection.extents.y()*camera_matrix.val[0];
+        out_projection->screen_area=
+            k_real_pi*out_projection->shape.ellipse.half_x_extent*out_projection->shape.ellipse.half_y_extent;
+
+        bValidTrackerProjection= true;
+    }
+
+    return bValidTrackerProjection;
+}
+
+bool computeTrackerRelativeLightBarProjection(
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour &opencv_contour,
+    CommonDeviceTrackingProjection *out_projection)
+{
+    assert(tracking_shape->shape_type == eCommonTrackingShapeType::LightBar);
+
+    bool bValidTrackerProjection= true;
+    float projectionArea= 0.f;
+    std::vector<cv::Point2f> cvImagePoints;
+    {
+        cv::Point2f tri_top, tri_bottom_left, tri_bottom_right;
+        cv::Point2f quad_top_right, quad_top_left, quad_bottom_left, quad_bottom_right;
+
+        // Create a best fit triangle around the contour
+        bValidTrackerProjection= computeBestFitTriangleForContour(
+            opencv_contour, 
+            tri_top, tri_bottom_left, tri_bottom_right);
+
+        // Also create a best fit quad around the contour
+        // Use the best fit triangle to define the orientation
+        if (bValidTrackerProjection)
+        {
+            // Use the triangle to define an up and a right direction
+            const cv::Point2f up_hint= tri_top - 0.5f*(tri_bottom_left + tri_bottom_right);
+            const cv::Point2f right_hint= tri_bottom_right - tri_bottom_left;
+
+            bValidTrackerProjection= computeBestFitQuadForContour(
+                opencv_contour, 
+                up_hint, right_hint, 
+                quad_top_right, quad_top_left, quad_bottom_left, quad_bottom_right);
+        }
+
+        if (bValidTrackerProjection)
+        {
+            // In practice the best fit triangle top is a bit noisy.
+            // Since it should be at the midpoint of the top of the quad we use that instead.
+            tri_top= 0.5f*(quad_top_right + quad_top_left);
+
+            // Put the image points in corresponding order with cvObjectPoints
+            cvImagePoints.push_back(tri_bottom_right);
+            cvImagePoints.push_back(tri_bottom_left);
+            cvImagePoints.push_back(tri_top);
+            cvImagePoints.push_back(quad_top_right);
+            cvImagePoints.push_back(quad_top_left);
+            cvImagePoints.push_back(quad_bottom_left);
+            cvImagePoints.push_back(quad_bottom_right);
+
+            // The projection area is the size of the best fit quad
+            projectionArea= 
+                static_cast<float>(
+                    cv::norm(quad_bottom_right-quad_bottom_left)
+                    *cv::norm(quad_bottom_left-quad_top_left));                   
+        }
+    }
+
+    // Return the projection of the tracking shape
+    if (bValidTrackerProjection)
+    {
+        out_projection->shape_type = eCommonTrackingProjectionType::ProjectionType_LightBar;
+
+        for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
+        {
+            const cv::Point2f &cvPoint = cvImagePoints[vertex_index];
+
+            out_projection->shape.lightbar.triangle[vertex_index] = { cvPoint.x, cvPoint.y };
+        }
+
+        for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
+        {
+            const cv::Point2f &cvPoint = cvImagePoints[vertex_index + 3];
+
+            out_projection->shape.lightbar.quad[vertex_index] = { cvPoint.x, cvPoint.y };
+        }
+
+        out_projection->screen_area= projectionArea;
+    }
+
+    return bValidTrackerProjection;
+}
+
+bool computeTrackerRelativeLightBarPose(
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const CommonDeviceTrackingProjection *projection,
+    const CommonDevicePose *tracker_relative_pose_guess,
+    CommonDevicePosition *out_position_cm,
+    CommonDeviceQuaternion *out_orientation,
+    bool *out_orientation_valid)
+{
+    assert(tracking_shape->shape_type == eCommonTrackingShapeType::LightBar);
+    assert(projection->shape_type == eCommonTrackingProjectionType::ProjectionType_LightBar);
+
+    bool bValidTrackerPose= true;
+    std::vector<cv::Point2f> cvImagePoints;
+
+    for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
+    {
+        const CommonDeviceScreenLocation &screenLocation= projection->shape.lightbar.triangle[vertex_index];
+
+        cvImagePoints.push_back(cv::Point2f(screenLocation.x, screenLocation.y));
+    }
+
+    for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
+    {
+        const CommonDeviceScreenLocation &screenLocation = projection->shape.lightbar.quad[vertex_index];
+
+        cvImagePoints.push_back(cv::Point2f(screenLocation.x, screenLocation.y));
+    }
+
+    // Solve the tracking position using solvePnP
+    if (bValidTrackerPose)
+    {
+        // Copy the object/image point mappings into OpenCV format
+        // Assumed vertex order is:
+        // triangle - right, left, bottom
+        // quad - top right, top left, bottom left, bottom right
+        std::vector<cv::Point3f> cvObjectPoints;
+
+        for (int corner_index= 0; corner_index < 3; ++corner_index)
+        {        
+            const CommonDevicePosition &corner = tracking_shape->shape.light_bar.triangle[corner_index];
+
+            cvObjectPoints.push_back(cv::Point3f(corner.x, corner.y, corner.z));
+        }
+
+        for (int corner_index= 0; corner_index < 4; ++corner_index)
+        {        
+            const CommonDevicePosition &corner = tracking_shape->shape.light_bar.quad[corner_index];
+
+            cvObjectPoints.push_back(cv::Point3f(corner.x, corner.y, corner.z));
+        }
+
+        // Fill out the initial guess in OpenCV format for the contour pose
+        // if a guess pose was provided
+        cv::Mat rvec(3, 1, cv::DataType<double>::type);
+        cv::Mat tvec(3, 1, cv::DataType<double>::type);
+
+        bool bUseExtrinsicGuess= false;
+        if (tracker_relative_pose_guess != nullptr)
+        {
+            const float k_max_valid_guess_distance= 300.f; // cm
+            float guess_position_distance_sqrd= 
+                tracker_relative_pose_guess->PositionCm.x*tracker_relative_pose_guess->PositionCm.x
+                + tracker_relative_pose_guess->PositionCm.y*tracker_relative_pose_guess->PositionCm.y
+                + tracker_relative_pose_guess->PositionCm.z*tracker_relative_pose_guess->PositionCm.z;
+
+            if (guess_position_distance_sqrd < k_max_valid_guess_distance*k_max_valid_guess_distance)
+            {
+                // solvePnP expects a rotation as a Rodrigues (AngleAxis) vector
+                commonDeviceOrientationToOpenCVRodrigues(tracker_relative_pose_guess->Orientation, rvec);
+
+                tvec.at<double>(0)= tracker_relative_pose_guess->PositionCm.x;
+                tvec.at<double>(1)= tracker_relative_pose_guess->PositionCm.y;
+                tvec.at<double>(2)= tracker_relative_pose_guess->PositionCm.z;
+
+                bUseExtrinsicGuess= true;
+            }
+        }
+
+        // Solve the Perspective-N-Point problem:
+        // Given a set of 3D points and their corresponding 2D pixel projections,
+        // solve for the object position and orientation that would allow
+        // us to re-project the 3D points back onto the 2D pixel locations
+        if (cv::solvePnP(
+                cvObjectPoints, cvImagePoints, 
+                camera_matrix, distortions, 
+                rvec, tvec, 
+                bUseExtrinsicGuess, cv::SOLVEPNP_ITERATIVE))
+        {
+            float axis_x, axis_y, axis_z, axis_theta;
+            float yaw, pitch, roll;
+
+            // Extract the angle-axis components from the solution OpenCV Rodrigues vector
+            openCVRodriguesToAngleAxis(rvec, axis_x, axis_y, axis_z, axis_theta);
+
+            // Convert the angle-axis rotation into Euler angles (yaw-pitch-roll)
+            angleAxisVectorToEulerAngles(axis_x, axis_y, axis_z, axis_theta, yaw, pitch, roll);
+           
+            //###HipsterSloth $TODO This should be a property of the lightbar tracking shape
+            static const float k_max_valid_tracking_pitch= 30.f*k_degrees_to_radians;
+            static const float k_max_valid_tracking_yaw= 30.f*k_degrees_to_radians;
+
+            // Due to ambiguity of the off the yaw and pitch solution from solvePnP (two possible solutions)
+            // we can't trust anything more than close to straightforward.
+            // Any roll angle is fine though.
+            if (fabsf(yaw) < k_max_valid_tracking_yaw && fabsf(pitch) < k_max_valid_tracking_pitch)
+            {           
+                // Convert the solution angle-axis into a CommonDeviceOrientation
+                angleAxisVectorToCommonDeviceOrientation(axis_x, axis_y, axis_z, axis_theta, *out_orientation);
+                *out_orientation_valid= true;
+            }
+            else
+            {
+                *out_orientation_valid= false;
+            }
+
+            // Return the position in the pose
+            {
+                CommonDevicePosition &position= *out_position_cm;
+
+                position.x = static_cast<float>(tvec.at<double>(0));
+                position.y = static_cast<float>(tvec.at<double>(1));
+                position.z = static_cast<float>(tvec.at<double>(2));
+            }
+
+            bValidTrackerPose= true;
+        }
+    }
+
+    return bValidTrackerPose;
+}
+
+bool computeBestFitTriangleForContour(
+    const t_opencv_float_contour &opencv_contour,
+    cv::Point2f &out_triangle_top,
+    cv::Point2f &out_triangle_bottom_left,
+    cv::Point2f &out_triangle_bottom_right)
+{
+    // Compute the tightest possible bounding triangle for the given contour
+    t_opencv_float_contour cv_min_triangle;
+
+    try
+    {
+        cv::minEnclosingTriangle(opencv_contour, cv_min_triangle);
+    }
+    catch( cv::Exception& e )
+    {
+        SERVER_LOG_INFO("computeBestFitTriangleForContour") << e.what();
+        return false;
+    }
+
+    if (cv_min_triangle.size() != 3)
+    {
+        return false;
+    }
+
+    cv::Point2f best_fit_origin_01 = (cv_min_triangle[0] + cv_min_triangle[1]) / 2.f;
+    cv::Point2f best_fit_origin_12 = (cv_min_triangle[1] + cv_min_triangle[2]) / 2.f;
+    cv::Point2f best_fit_origin_20 = (cv_min_triangle[2] + cv_min_triangle[0]) / 2.f;
+
+    t_opencv_float_contour cv_midpoint_triangle;
+    cv_midpoint_triangle.push_back(best_fit_origin_01);
+    cv_midpoint_triangle.push_back(best_fit_origin_12);
+    cv_midpoint_triangle.push_back(best_fit_origin_20);
+
+    // Find the corner closest to the center of mass.
+    // This is the bottom of the triangle.
+    int topCornerIndex = -1;
+    {
+        const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_float_contour>(opencv_contour);
+
+        double bestDistance = k_real_max;
+        for (int cornerIndex = 0; cornerIndex < 3; ++cornerIndex)
+        {
+            const double testDistance = cv::norm(cv_midpoint_triangle[cornerIndex] - massCenter);
+
+            if (testDistance < bestDistance)
+            {
+                topCornerIndex = cornerIndex;
+                bestDistance = testDistance;
+            }
+        }
+    }
+
+    // Assign the left and right corner indices
+    int leftCornerIndex = -1;
+    int rightCornerIndex = -1;
+    switch (topCornerIndex)
+    {
+    case 0:
+        leftCornerIndex = 1;
+        rightCornerIndex = 2;
+        break;
+    case 1:
+        leftCornerIndex = 0;
+        rightCornerIndex = 2;
+        break;
+    case 2:
+        leftCornerIndex = 0;
+        rightCornerIndex = 1;
+        break;
+    default:
+        assert(0 && "unreachable");
+    }
+
+    // Make sure the left and right corners are actually 
+    // on the left and right of the triangle
+    out_triangle_top = cv_midpoint_triangle[topCornerIndex];
+    out_triangle_bottom_left = cv_midpoint_triangle[leftCornerIndex];
+    out_triangle_bottom_right = cv_midpoint_triangle[rightCornerIndex];
+
+    const cv::Point2f topToLeft = out_triangle_bottom_left - out_triangle_top;
+    const cv::Point2f topToRight = out_triangle_bottom_right - out_triangle_top;
+
+    // Cross product should be positive if sides are correct
+    // If not, then swap them.
+    if (topToRight.cross(topToLeft) < 0)
+    {
+        std::swap(out_triangle_bottom_left, out_triangle_bottom_right);
+    }
+
+    return true;
+}
+
+bool computeBestFitQuadForContour(
+    const t_opencv_float_contour &opencv_contour,
+    const cv::Point2f &up_hint, 
+    const cv::Point2f &right_hint,
+    cv::Point2f &top_right,
+    cv::Point2f &top_left,
+    cv::Point2f &bottom_left,
+    cv::Point2f &bottom_right)
+{
+    // Compute the tightest possible bounding triangle for the given contour
+    cv::RotatedRect cv_min_box= cv::minAreaRect(opencv_contour);
+
+    if (cv_min_box.size.width <= k_real_epsilon || cv_min_box.size.height <= k_real_epsilon)
+    {
+        return false;
+    }
+
+    float half_width, half_height;
+    float radians;
+    if (cv_min_box.size.width > cv_min_box.size.height)
+    {
+        half_width= cv_min_box.size.width / 2.f;
+        half_height= cv_min_box.size.height / 2.f;
+        radians= cv_min_box.angle*k_degrees_to_radians;
+    }
+    else
+    {
+        half_width= cv_min_box.size.height / 2.f;
+        half_height= cv_min_box.size.width / 2.f;
+        radians= (cv_min_box.angle + 90.f)*k_degrees_to_radians;
+    }
+
+    cv::Point2f quad_half_right, quad_half_up;
+    {
+        const float cos_angle= cosf(radians);
+        const float sin_angle= sinf(radians);
+
+        quad_half_right.x= half_width*cos_angle;
+        quad_half_right.y= half_width*sin_angle;
+
+        quad_half_up.x= -half_height*sin_angle;
+        quad_half_up.y= half_height*cos_angle;
+    }
+
+    if (quad_half_up.dot(up_hint) < 0)
+    {
+        // up axis is flipped
+        // flip the box vertically
+        quad_half_up= -quad_half_up;
+    }
+
+    if (quad_half_right.dot(right_hint) < 0)
+    {
+        // right axis is flipped
+        // flip the box horizontally
+        quad_half_right= -quad_half_right;
+    }
+
+    top_right= cv_min_box.center + quad_half_up + quad_half_right;
+    top_left= cv_min_box.center + quad_half_up - quad_half_right;
+    bottom_right= cv_min_box.center - quad_half_up + quad_half_right;
+    bottom_left= cv_min_box.center - quad_half_up - quad_half_right;
+
+    return true;
+}
+
+// http://www.euclideanspace.com/maths/geometry/rotations/conversions/quaternionToAngle/index.htm
+static void commonDeviceOrientationToOpenCVRodrigues(
+    const CommonDeviceQuaternion &orientation,
+    cv::Mat &rvec)
+{
+    double qw= clampf(orientation.w, -1.0, 1.0);
+    double angle = 2.0 * acos(qw);
+    double axis_normalizer = sqrt(1.0 - qw*qw);
+
+    if (axis_normalizer > k_real_epsilon) 
+    {
+        rvec.at<double>(0) = angle * (orientation.x / axis_normalizer);
+        rvec.at<double>(1) = angle * (orientation.y / axis_normalizer);
+        rvec.at<double>(2) = angle * (orientation.z / axis_normalizer);
+    }
+    else
+    {
+        // Angle is either 0 or 360,
+        // which is a rotation no-op so we are free to pick any axis we want
+        rvec.at<double>(0) = angle; 
+        rvec.at<double>(1) = 0.0;
+        rvec.at<double>(2) = 0.0;
+    }
+}
+
+static void openCVRodriguesToAngleAxis(
+    const cv::Mat &rvec,
+    float &axis_x, float &axis_y, float &axis_z, float &radians)
+{
+    const float r_x = static_cast<float>(rvec.at<double>(0));
+    const float r_y = static_cast<float>(rvec.at<double>(1));
+    const float r_z = static_cast<float>(rvec.at<double>(2));
+    
+    radians = sqrtf(r_x*r_x + r_y*r_y + r_z*r_z);
+
+    axis_x= safe_divide_with_default(r_x, radians, 1.f);
+    axis_y= safe_divide_with_default(r_y, radians, 0.f);
+    axis_z= safe_divide_with_default(r_z, radians, 0.f);
+}
+
+// http://www.euclideanspace.com/maths/geometry/rotations/conversions/angleToEuler/index.htm
+// NOTE: This code has the X and Z axis flipped from the code in the link
+// because I consider rotation about the X-axis pitch and the Z-axis roll
+// whereas the original code had the opposite.
+// Also they refer to yaw as "heading", pitch as "attitude", and roll ""
+static void angleAxisVectorToEulerAngles(
+    const float axis_x, const float axis_y, const float axis_z, const float radians,
+    float &yaw, float &pitch, float &roll)
+{
+    float s= sinf(radians);
+    float c= cosf(radians);
+    float t= 1.f-c;
+
+    if ((axis_x*axis_y*t + axis_z*s) > 0.998) 
+    {
+        // north pole singularity detected
+        yaw = 2*atan2f(axis_z*sinf(radians/2), cosf(radians/2));
+        pitch = k_real_half_pi;
+        roll = 0;
+    }
+    else if ((axis_x*axis_y*t + axis_z*s) < -0.998) 
+    { 
+        // south pole singularity detected
+        yaw = -2*atan2(axis_z*sinf(radians/2), cosf(radians/2));
+        pitch = -k_real_half_pi;
+        roll = 0;
+    }
+    else
+    {
+        yaw = atan2f(axis_y*s - axis_x*axis_z*t, 1.f - (axis_y*axis_y + axis_z*axis_z)*t);
+        pitch = asinf(axis_z*axis_y*t + axis_x*s) ;
+        roll = atan2f(axis_z*s - axis_x*axis_y*t , 1.f - (axis_x*axis_x + axis_z*axis_z)*t);
+    }
+}
+
+static void angleAxisVectorToCommonDeviceOrientation(
+    const float axis_x, const float axis_y, const float axis_z, const float radians,
+    CommonDeviceQuaternion &orientation)
+{
+    if (!is_nearly_zero(radians))
+    {
+        const float sin_theta_over_two = sinf(radians * 0.5f);
+        const float w = cosf(radians * 0.5f);
+        const float x = axis_x * sin_theta_over_two;
+        const float y = axis_y * sin_theta_over_two;
+        const float z = axis_z * sin_theta_over_two;
+        const float length = sqrtf(w*w + x*x + y*y + z*z);
+
+        if (length > k_normal_epsilon)
+        {
+            orientation.w = w / length;
+            orientation.x = x / length;
+            orientation.y = y / length;
+            orientation.z = z / length;
+        }
+        else
+        {
+            orientation.clear();
+        }
+    }
+    else
+    {
+        orientation.clear();
+    }
+}
@@ -0,0 +1,338 @@
+#ifndef TRACKER_FRAME_PROCESSING_H
+#define TRACKER_FRAME_PROCESSING_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "MathUtility.h"
+#include "PSMoveProtocolInterface.h"
+
+#include "opencv2/opencv.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//-- constants -----
+static const int k_hsv_cache_tile_size= 32; // pixel width and height of a tile in the per-frame HSV cache
+static const int k_max_color_jobs= PSMOVESERVICE_MAX_CONTROLLER_COUNT + PSMOVESERVICE_MAX_HMD_COUNT; // one per trackable device
+static const int k_max_color_labels= 8; // distinct HSV ranges the 8-bit label buffer can segment in one pass
+
+//-- typedefs ----
+typedef std::vector<cv::Point> t_opencv_int_contour;
+typedef std::vector<t_opencv_int_contour> t_opencv_int_contour_list;
+
+typedef std::vector<cv::Point2f> t_opencv_float_contour;
+typedef std::vector<t_opencv_float_contour> t_opencv_float_contour_list;
+
+//-- definitions -----
+/// A debug overlay primitive recorded during the frame.
+/// Only rasterized into the video frame when a client has the video stream open.
+struct DebugOverlayCommand
+{
+    enum eCommandType
+    {
+        DrawROI,
+        DrawContour,
+        DrawPoseProjection
+    };
+
+    eCommandType command_type;
+    cv::Rect2i ROI;
+    t_opencv_int_contour contour;
+    CommonDeviceTrackingProjection pose_projection;
+};
+
+/// The per-tracker frame buffers the tracking colors get segmented from.
+/// Used by ServerTrackerView on every polled video frame (and by the tracker pipeline benchmark).
+class OpenCVBufferState
+{
+public:
+    // bgr_to_hsv_converter is one of the TrackerManagerConfig::bgr_to_hsv_converter settings
+    OpenCVBufferState(int frame_width, int frame_height, const std::string &bgr_to_hsv_converter);
+    virtual ~OpenCVBufferState();
+
+    void writeVideoFrame(const unsigned char *video_buffer);
+
+    // Cache a raw Bayer sensor frame.
+    // The full BGR frame is only built when bDebayerFullFrame is set,
+    // i.e. when someone is watching the video stream. Otherwise updateHsvBuffer() debayers
+    // just the tiles the tracked ROIs touch.
+    void writeBayerFrame(const unsigned char *bayer_buffer, bool bDebayerFullFrame);
+
+
+    // Drop the last frame and its debug overlay when no video frame came along with the new contours.
+    // rasterizeDebugOverlay() has nothing to show until the next write*Frame().
+    void clearVideoFrame();
+
+    // Mark every tile of the hsv and label buffers as stale (call whenever bgrBuffer changes)
+    void invalidateHsvBuffer();
+
+    // Convert the tiles overlapped by the current ROI that haven't been converted yet this frame.
+    // Several tracked objects sharing a camera frame then only pay for the HSV conversion
+    // of the pixels they have in common once.
+    void updateHsvBuffer();
+
+    // Debayer one region of bayerBuffer into bgrBuffer.
+    // The Bayer window gets a 2 pixel margin starting on even coordinates, so the pattern phase
+    // and every interpolated pixel in the region match debayering the whole frame.
+    void debayerRegion(const cv::Rect2i &region);
+
+    void convertBgrToHsv(const cv::Mat &bgr, cv::Mat hsv);
+
+    // Make sure the ROI box is always clamped in bounds of the frame buffer
+    cv::Rect2i clampROI(const cv::Rect2i &ROI) const;
+
+    // Point the ROI matrices at the given region and make sure its HSV pixels are up to date
+    void selectROI(const cv::Rect2i &ROI);
+
+    void applyROI(const cv::Rect2i &ROI);
+
+    // Set the HSV ranges the label buffer gets segmented with (up to k_max_color_labels)
+    // and mark every tile of the label buffer as stale.
+    // The hue/saturation/value tests (including the hue wrap around) are baked into
+    // three 256 entry tables with bit N set for every range N that contains the index,
+    // so the per pixel cost of labeling doesn't depend on the range count.
+    void setColorLabelRanges(
+        const CommonHSVColorRange * const label_ranges[k_max_color_labels],
+        const int label_count);
+
+    // Fused segmentation pass over the tiles overlapped by the ROI that haven't been labeled
+    // since the last setColorLabelRanges(): reads every HSV pixel once and writes its label.
+    // Like the HSV cache, tracked objects sharing a frame only label the pixels they have in common once
+    // and pixels outside of every ROI never get touched.
+    void computeColorLabels(const cv::Rect2i &ROI);
+
+    // Return points in raw image space:
+    // i.e. [0, 0] at lower left  to [frameWidth-1, frameHeight-1] at lower right
+    // Expects computeColorLabels() to have been run on the ROI this frame.
+    bool computeBiggestNContoursForLabel(
+        const int label_index,
+        const cv::Rect2i &ROI,
+        t_opencv_int_contour_list &out_biggest_N_contours,
+        std::vector<double> &out_contour_areas,
+        const int max_contour_count,
+        const int min_points_in_contour = 6);
+
+    static void add_label_range(unsigned char *labels, float range_min, float range_max, unsigned char label);
+
+    bool find_biggest_N_contours(
+        t_opencv_int_contour_list &out_biggest_N_contours,
+        std::vector<double> &out_contour_areas,
+        const int max_contour_count,
+        const int min_points_in_contour);
+
+    // -- Debug overlay --
+    // The draw_* calls only record what to draw.
+    // rasterizeDebugOverlay() draws it onto a copy of the frame when someone is watching.
+    void draw_roi(const cv::Rect2i &ROI);
+    void draw_contour(const t_opencv_int_contour &contour);
+    void draw_pose_projection(const CommonDeviceTrackingProjection &pose_projection);
+
+    // Build bgrShmemBuffer: the current frame with this frame's draw commands on top.
+    // Returns false if there is no complete video frame to show
+    // (raw Bayer frames only debayered around the ROIs).
+    bool rasterizeDebugOverlay();
+
+    DebugOverlayCommand &addOverlayCommand(DebugOverlayCommand::eCommandType command_type);
+    void rasterize_roi(const cv::Rect2i &ROI);
+    void rasterize_contour(const t_opencv_int_contour &contour);
+    void rasterize_pose_projection(const CommonDeviceTrackingProjection &pose_projection);
+
+    int frameWidth;
+    int frameHeight;
+
+    cv::Mat *bayerBuffer; // raw sensor frame (when the tracker captures Bayer frames)
+    cv::Mat debayerScratch; // debayered window around a run of tiles
+    bool bDebayerPerTile; // bgrBuffer only holds the tiles updateHsvBuffer() debayered this frame (or none)
+    cv::Mat *bgrBuffer; // source video frame
+    cv::Mat *bgrShmemBuffer; //Frame onto which we draw debug lines, and transmit via shared mem.
+    std::vector<DebugOverlayCommand> overlayCommands; // debug lines drawn this frame
+    size_t overlayCommandCount; // entries of overlayCommands in use
+    cv::Mat bgrROI;
+    cv::Mat *hsvBuffer; // source frame converted to HSV color space
+    cv::Mat hsvROI;
+    cv::Rect2i currentROI; // clamped ROI the *ROI matrices were built from
+    std::vector<bool> hsvTileValid; // tiles of hsvBuffer already converted from the current bgrBuffer
+    int hsvTileColumnCount;
+    int hsvTileRowCount;
+    cv::Mat *gsLowerBuffer; // HSV image clamped by HSV range into grayscale mask
+    cv::Mat gsLowerROI;
+    cv::Mat *labelBuffer; // per pixel bitmask of the tracking colors whose HSV range contains the pixel
+    cv::Mat labelROI;
+    std::vector<bool> labelTileValid; // tiles of labelBuffer already labeled with the current ranges (same tiling as hsvTileValid)
+    unsigned char hueLabels[256]; // color bits whose hue range contains the index
+    unsigned char saturationLabels[256]; // color bits whose saturation range contains the index
+    unsigned char valueLabels[256]; // color bits whose value range contains the index
+    cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
+    class OpenCVBGRToHSVMapper *bgr2hsv; // Used to convert an rgb image to an hsv image
+    bool bUseSIMDConverter; // Use BGRToHSVConverter instead of the lookup table or cv::cvtColor
+};
+
+/// Contours to look for on behalf of one tracked device.
+/// Controllers and HMDs each get their own job (see getControllerColorJobIndex/getHMDColorJobIndex),
+/// so devices sharing a tracking color keep their own ROI, HSV range and contour count.
+struct TrackerColorJob
+{
+    bool bIsActive;
+    eCommonTrackingColorID color_id;
+    CommonHSVColorRange hsv_color_range;
+    cv::Rect2i ROI;
+    int max_contour_count;
+};
+
+struct TrackerColorJobList
+{
+    TrackerColorJob jobs[k_max_color_jobs];
+
+    TrackerColorJobList()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (int job_index = 0; job_index < k_max_color_jobs; ++job_index)
+        {
+            jobs[job_index].bIsActive = false;
+        }
+    }
+};
+
+struct TrackerColorResult
+{
+    bool bIsActive;
+    cv::Rect2i ROI; // ROI the contours were searched in (before clamping)
+    t_opencv_int_contour_list contours;
+    std::vector<double> contour_areas;
+
+    TrackerColorResult()
+        : bIsActive(false)
+    {
+    }
+};
+
+struct TrackerFrameResult
+{
+    cv::Mat videoFrame; // frame as captured: BGR, or raw Bayer (CV_8UC1)
+    bool bHasVideoFrame; // videoFrame only gets filled in while someone watches the video stream
+    std::chrono::time_point<std::chrono::high_resolution_clock> arrivalTime; // when the worker got the frame
+    TrackerColorResult color_results[k_max_color_jobs]; // indexed like TrackerColorJobList::jobs
+
+    TrackerFrameResult()
+        : bHasVideoFrame(false)
+    {
+    }
+
+    const TrackerColorResult *getColorResult(int job_index) const
+    {
+        const TrackerColorResult *result = nullptr;
+
+        if (job_index >= 0 && job_index < k_max_color_jobs)
+        {
+            result = color_results[job_index].bIsActive ? &color_results[job_index] : nullptr;
+        }
+
+        return result;
+    }
+};
+
+//-- interface -----
+/// Segments every active job of the current frame in one fused pass over the tiles
+/// their ROIs touch, then extracts the biggest contours of each job from its own ROI.
+/// Jobs with identical HSV ranges share a label bit. Should there be more distinct ranges
+/// than label bits, the rest get segmented in further passes with their own label tables.
+void computeContoursForColorJobs(
+    OpenCVBufferState *buffer_state,
+    const TrackerColorJobList &color_jobs,
+    TrackerFrameResult &frame_result);
+
+/// Converts an integer contour to float and removes the lens distortion from it.
+/// The points end up in pixels, or relative to the focal length when bNormalizedCoordinates is set.
+void computeUndistortedContour(
+    const t_opencv_int_contour &contour,
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const bool bNormalizedCoordinates,
+    t_opencv_float_contour &out_undistorted_contour);
+
+/// Fits the tracking sphere to a convex contour in normalized camera coordinates.
+/// Returns the tracker relative sphere center and the ellipse it projects to (in pixels),
+/// or false (leaving the outputs untouched) if the fit degenerated to a zero area ellipse.
+bool computeTrackerRelativeSphereProjection(
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour &normalized_contour,
+    const cv::Matx33f &camera_matrix,
+    CommonDevicePosition *out_position_cm,
+    CommonDeviceTrackingProjection *out_projection);
+
+/// Fits the light bar triangle and quad to an undistorted contour (in pixels).
+bool computeTrackerRelativeLightBarProjection(
+    const CommonDeviceTrackingShape *tracking_shape,
+    const t_opencv_float_contour &opencv_contour,
+    CommonDeviceTrackingProjection *out_projection);
+
+/// Solves the tracker relative light bar pose from its projection with solvePnP.
+/// The orientation is only flagged valid when the light bar faces the tracker.
+bool computeTrackerRelativeLightBarPose(
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const CommonDeviceTrackingProjection *projection,
+    const CommonDevicePose *tracker_relative_pose_guess,
+    CommonDevicePosition *out_position_cm,
+    CommonDeviceQuaternion *out_orientation,
+    bool *out_orientation_valid);
+
+bool computeBestFitTriangleForContour(
+    const t_opencv_float_contour &opencv_contour,
+    cv::Point2f &out_triangle_top,
+    cv::Point2f &out_triangle_bottom_left,
+    cv::Point2f &out_triangle_bottom_right);
+
+bool computeBestFitQuadForContour(
+    const t_opencv_float_contour &opencv_contour,
+    const cv::Point2f &up_hint,
+    const cv::Point2f &right_hint,
+    cv::Point2f &top_right,
+    cv::Point2f &top_left,
+    cv::Point2f &bottom_left,
+    cv::Point2f &bottom_right);
+
+//-- template utility methods -----
+template<typename t_opencv_contour_type>
+cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour)
+{
+    cv::Moments mu(cv::moments(contour));
+    cv::Point2f massCenter;
+
+    // mu.m00 is zero for contours of zero area.
+    // Fallback to standard centroid in this case.
+
+    if (!is_double_nearly_zero(mu.m00))
+    {
+        massCenter= cv::Point2f(static_cast<float>(mu.m10 / mu.m00), static_cast<float>(mu.m01 / mu.m00));
+    }
+    else
+    {
+        massCenter.x = 0.f;
+        massCenter.y = 0.f;
+
+        for (const cv::Point &int_point : contour)
+        {
+            massCenter.x += static_cast<float>(int_point.x);
+            massCenter.y += static_cast<float>(int_point.y);
+        }
+
+        if (contour.size() > 1)
+        {
+            const float N = static_cast<float>(contour.size());
+
+            massCenter.x /= N;
+            massCenter.y /= N;
+        }
+    }
+
+    return massCenter;
+}
+
+#endif // TRACKER_FRAME_PROCESSING_H
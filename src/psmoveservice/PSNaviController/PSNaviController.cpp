@@ -48,7 +48,6 @@
 #define PSNAVI_CNTLR_BTADDR_BUF_SIZE 17
 #define PSNAVI_HOST_BTADDR_BUF_SIZE 9
 #define PSNAVI_BTADDR_SIZE 6
-#define PSNAVI_STATE_BUFFER_MAX 16
 
 // https://github.com/nitsch/moveonpc/wiki/HID-reports
 enum PSNaviRequestType {
@@ -667,13 +666,7 @@ PSNaviController::pollGamepad()
 		// Can't report the true battery state
 		newState.Battery = CommonControllerState::Batt_MAX;
 
-		// Make room for new entry if at the max queue size
-		if (ControllerStates.size() >= PSNAVI_STATE_BUFFER_MAX)
-		{
-			ControllerStates.erase(ControllerStates.begin(),
-				ControllerStates.begin() + ControllerStates.size() - PSNAVI_STATE_BUFFER_MAX);
-		}
-
+		// Pushing into a full history drops the oldest state
 		ControllerStates.push_back(newState);
 	}
 	else
@@ -747,13 +740,7 @@ PSNaviController::parseInputData()
 	// Other
 	newState.Battery = static_cast<CommonControllerState::BatteryLevel>(InData->battery);
 
-	// Make room for new entry if at the max queue size
-	if (ControllerStates.size() >= PSNAVI_STATE_BUFFER_MAX)
-	{
-		ControllerStates.erase(ControllerStates.begin(),
-			ControllerStates.begin() + ControllerStates.size() - PSNAVI_STATE_BUFFER_MAX);
-	}
-
+	// Pushing into a full history drops the oldest state
 	ControllerStates.push_back(newState);
 }
 
@@ -761,9 +748,7 @@ const CommonDeviceState *
 PSNaviController::getState(
     int lookBack) const
 {
-    const int queueSize= static_cast<int>(ControllerStates.size());
-    const CommonDeviceState * result=
-        (lookBack < queueSize) ? &ControllerStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= ControllerStates.getLookBack(lookBack);
 
     return result;
 }
@@ -2,8 +2,11 @@
 #define BOOST_LIB_DIAGNOSTIC
 
 #include "PSMoveService.h"
+#include "ServerEventScheduler.h"
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
+#include "DeviceInputRecorder.h"
+#include "DeviceInputReplayer.h"
 #include "DeviceManager.h"
 #include "ProtocolVersion.h"
 #include "ServerLog.h"
@@ -39,8 +42,11 @@ public:
     PSMoveServiceImpl()
         : m_io_service()
         , m_signals(m_io_service)
+        , m_event_scheduler()
         , m_usb_device_manager()
         , m_device_manager()
+        , m_device_input_recorder()
+        , m_device_input_replayer()
         , m_request_handler(&m_device_manager)
         , m_network_manager()
         , m_status()
@@ -73,6 +79,27 @@ public:
                     if (m_status->state() != boost::application::status::paused)
                     {
                         update();
+
+                        if (m_device_input_replayer.getIsFinished())
+                        {
+                            SERVER_LOG_INFO("PSMoveService") << "Finished replaying the device input. Stopping Service.";
+                            m_status->state(boost::application::status::stoped);
+                            continue;
+                        }
+
+                        if (DeviceInputReplayer::getInstance() != nullptr && m_device_input_replayer.getIsFastReplay())
+                        {
+                            // Replay the next step right away
+                            continue;
+                        }
+
+                        if (cfg.event_driven_main_loop)
+                        {
+                            // Sleep until new device data or socket activity shows up,
+                            // or until the next device poll is due
+                            m_event_scheduler.waitForEvents(m_device_manager.getTimeUntilNextUpdate());
+                            continue;
+                        }
                     }
 
 					std::this_thread::sleep_for(std::chrono::milliseconds(cfg.tracker_sleep_ms));
@@ -154,6 +181,44 @@ private:
 		}
 		#endif // BOOST_INTERPROCESS_SHARED_DIR_PATH       
 
+        /** Setup the event scheduler before any device thread that can signal it gets started */
+        if (success)
+        {
+            if (!m_event_scheduler.startup(&m_io_service))
+            {
+                SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the event scheduler";
+                success = false;
+            }
+        }
+
+        /** Start recording or replaying the device input before any device gets opened */
+        if (success)
+        {
+            const PSMoveService::ProgramSettings *settings = PSMoveService::getInstance()->getProgramSettings();
+
+            if (!settings->replay_input.empty())
+            {
+                if (!settings->record_input.empty())
+                {
+                    SERVER_LOG_WARNING("PSMoveService") << "Can't record device input while replaying it. Ignoring record_input.";
+                }
+
+                if (!m_device_input_replayer.startup(settings->replay_input, settings->replay_speed))
+                {
+                    SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the device input replayer";
+                    success = false;
+                }
+            }
+            else if (!settings->record_input.empty())
+            {
+                if (!m_device_input_recorder.startup(settings->record_input))
+                {
+                    SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the device input recorder";
+                    success = false;
+                }
+            }
+        }
+
         /** Setup the usb async transfer thread before we attempt to initialize the trackers */
         if (success)
         {
@@ -208,6 +273,9 @@ private:
         /** Process any async results from the USB transfer thread */
         m_usb_device_manager.update();
 
+        /** Hand the replayed device input to the devices before they get polled */
+        m_device_input_replayer.update();
+
         /**
          Update the list of active tracked controllers
          Send controller updates to the client
@@ -233,6 +301,15 @@ private:
         // Shutdown the usb async request thread
         // Must be after device manager since devices can have an active usb connection
         m_usb_device_manager.shutdown();
+
+        // Finish the device input recording or replay
+        // Must be after device manager since open devices record to or replay from it
+        m_device_input_recorder.shutdown();
+        m_device_input_replayer.shutdown();
+
+        // Stop taking event signals
+        // Must be after the device managers since their threads signal the scheduler
+        m_event_scheduler.shutdown();
     }
 
     void handle_termination_signal()
@@ -249,12 +326,19 @@ private:
     // The signal_set is used to register for process termination notifications.
     boost::asio::signal_set m_signals;
 
+    // Wakes up the main loop when there is work to do
+    ServerEventScheduler m_event_scheduler;
+
     // Manages all control and bulk transfer requests in another thread
     USBDeviceManager m_usb_device_manager;
 
     // Keep track of currently connected devices (PSMove controllers, cameras, HMDs)
     DeviceManager m_device_manager;
 
+    // Records the device input to a file, or replays it from one, in place of the devices
+    DeviceInputRecorder m_device_input_recorder;
+    DeviceInputReplayer m_device_input_replayer;
+
     // Generates responses from incoming requests sent to the network manager
     ServerRequestHandler m_request_handler;
 
@@ -295,6 +379,26 @@ static void parse_program_settings(
 	{
 		settings.working_directory.clear();
 	}
+
+    if (options_map.count("record_input"))
+    {
+        settings.record_input= options_map["record_input"].as<std::string>();
+    }
+    else
+    {
+        settings.record_input.clear();
+    }
+
+    if (options_map.count("replay_input"))
+    {
+        settings.replay_input= options_map["replay_input"].as<std::string>();
+    }
+    else
+    {
+        settings.replay_input.clear();
+    }
+
+    settings.replay_speed= options_map["replay_speed"].as<float>();
 }
 
 #if defined(BOOST_WINDOWS_API) 
@@ -507,6 +611,9 @@ int PSMoveService::exec(int argc, char *argv[])
         ("log_level,l", boost::program_options::value<std::string>(), "The level of logging to use: trace, debug, info, warning, error, fatal")
         ("admin_password,p", boost::program_options::value<std::string>(), "Remember the admin password for this machine (optional)")
 		("working_directory", boost::program_options::value<std::string>(), "service working directory (optional)")
+        ("record_input", boost::program_options::value<std::string>(), "Record the raw input of every device to this file (optional)")
+        ("replay_input", boost::program_options::value<std::string>(), "Replay recorded device input from this file instead of using the devices (optional)")
+        ("replay_speed", boost::program_options::value<float>()->default_value(1.f), "Speed to replay the device input at, 0 = as fast as possible")
 #if defined(BOOST_WINDOWS_API)
         (",i", "install service")
         (",u", "uninstall service")
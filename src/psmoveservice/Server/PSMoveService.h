@@ -13,6 +13,9 @@ public:
         std::string log_level;
         std::string admin_password;
 		std::string working_directory;
+        std::string record_input;
+        std::string replay_input;
+        float replay_speed;
     };
 
     PSMoveService();
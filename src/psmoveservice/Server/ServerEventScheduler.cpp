@@ -0,0 +1,129 @@
+//-- includes -----
+#include "ServerEventScheduler.h"
+#include "ServerLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+//-- constants -----
+// Upper bound on a single wait so that a stop request coming from outside
+// the io_service (e.g. the windows service control manager) is noticed quickly
+static const std::chrono::microseconds k_max_event_wait(100000);
+
+//-- private implementation -----
+// -ServerEventSchedulerImpl-
+/// Internal implementation of the event scheduler.
+class ServerEventSchedulerImpl
+{
+public:
+    ServerEventSchedulerImpl(boost::asio::io_service &io_service)
+        : m_io_service(io_service)
+        , m_wait_timer(io_service)
+        , m_event_pending(false)
+    {
+    }
+
+    void signalEvent()
+    {
+        // Only one wake up handler needs to be queued at a time.
+        // Posting is what actually unblocks io_service::run_one() on the main thread.
+        if (!m_event_pending.exchange(true))
+        {
+            m_io_service.post(&ServerEventSchedulerImpl::handle_event_signaled);
+        }
+    }
+
+    void waitForEvents(const std::chrono::microseconds &max_wait)
+    {
+        // Something happened on another thread since the last wait
+        if (m_event_pending.exchange(false))
+        {
+            return;
+        }
+
+        if (max_wait.count() <= 0)
+        {
+            return;
+        }
+
+        m_wait_timer.expires_from_now(std::min(max_wait, k_max_event_wait));
+        m_wait_timer.async_wait(&ServerEventSchedulerImpl::handle_wait_timer);
+
+        // Returns after running the first ready completion handler:
+        // socket i/o, a termination signal, a signaled event or the timer
+        m_io_service.run_one();
+
+        // The canceled timer handler gets run (and ignored) by the next io_service poll
+        m_wait_timer.cancel();
+
+        // Everything signaled up to this point gets handled by the update that follows
+        m_event_pending = false;
+    }
+
+protected:
+    static void handle_event_signaled()
+    {
+    }
+
+    static void handle_wait_timer(const boost::system::error_code &)
+    {
+    }
+
+private:
+    boost::asio::io_service &m_io_service;
+    boost::asio::steady_timer m_wait_timer;
+    std::atomic_bool m_event_pending;
+};
+
+//-- public interface -----
+ServerEventScheduler *ServerEventScheduler::m_instance = nullptr;
+
+ServerEventScheduler::ServerEventScheduler()
+    : implementation_ptr(nullptr)
+{
+}
+
+ServerEventScheduler::~ServerEventScheduler()
+{
+    if (m_instance != nullptr)
+    {
+        SERVER_LOG_ERROR("~ServerEventScheduler()") << "Event Scheduler deleted without shutdown() getting called first";
+    }
+
+    if (implementation_ptr != nullptr)
+    {
+        delete implementation_ptr;
+        implementation_ptr = nullptr;
+    }
+}
+
+bool ServerEventScheduler::startup(boost::asio::io_service *io_service)
+{
+    implementation_ptr = new ServerEventSchedulerImpl(*io_service);
+    m_instance = this;
+
+    return true;
+}
+
+void ServerEventScheduler::shutdown()
+{
+    m_instance = nullptr;
+}
+
+void ServerEventScheduler::signalEvent()
+{
+    if (implementation_ptr != nullptr)
+    {
+        implementation_ptr->signalEvent();
+    }
+}
+
+void ServerEventScheduler::waitForEvents(const std::chrono::microseconds &max_wait)
+{
+    if (implementation_ptr != nullptr)
+    {
+        implementation_ptr->waitForEvents(max_wait);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef SERVER_EVENT_SCHEDULER_H
+#define SERVER_EVENT_SCHEDULER_H
+
+//-- includes -----
+#include <chrono>
+
+//-- pre-declarations -----
+namespace boost {
+    namespace asio {
+        class io_service;
+    }
+}
+
+//-- definitions -----
+// -Server Event Scheduler-
+/// Puts the service main loop to sleep until there is work to do:
+/// * socket activity (or any other completion handler) on the service io_service
+/// * an event signaled from another thread (USB transfer completion, new tracker frame)
+/// * the deadline passed in by the caller (next device poll or reconnect)
+class ServerEventScheduler
+{
+public:
+    ServerEventScheduler();
+    virtual ~ServerEventScheduler();
+
+    static ServerEventScheduler *getInstance() { return m_instance; }
+
+    /// Called first by PSMoveService::startup(), before any device threads are started
+    bool startup(boost::asio::io_service *io_service);
+
+    /// Called last by PSMoveService::shutdown(), after all device threads are stopped
+    void shutdown();
+
+    /// Wakes up the main loop if it is waiting. Safe to call from any thread.
+    void signalEvent();
+
+    /// Blocks until an event is signaled, an io_service handler runs or max_wait elapses.
+    /// Returns immediately if an event was signaled since the last wait.
+    void waitForEvents(const std::chrono::microseconds &max_wait);
+
+private:
+    /// private implementation - same lifetime as the ServerEventScheduler
+    class ServerEventSchedulerImpl *implementation_ptr;
+
+    /// Singleton instance of the class
+    /// Assigned in startup, cleared in shutdown
+    static ServerEventScheduler *m_instance;
+};
+
+#endif  // SERVER_EVENT_SCHEDULER_H
@@ -2,10 +2,13 @@
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "ServerLog.h"
+#include "ServerUdpBatchSender.h"
 #include "PackedMessage.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -31,16 +34,180 @@ typedef map<int, ClientConnectionPtr> t_client_connection_map;
 typedef map<int, ClientConnectionPtr>::iterator t_client_connection_map_iter;
 typedef std::pair<int, ClientConnectionPtr> t_id_client_connection_pair;
 
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_high_resolution_timepoint;
+
 //-- constants -----
 const int PSMOVE_SERVER_PORT = 9512;
 
+// How often the device data frame latency gets logged
+const int k_latency_report_interval_seconds = 10;
+
+// State republished without new device data (e.g. after an LED change) carries an old arrival time.
+// Those frames say nothing about the latency, so leave them out of the stats.
+const double k_max_latency_sample_ms = 1000.0;
+
 //-- private implementation -----
 class IServerNetworkEventListener
 {
 public:
 	virtual void handle_client_connection_stopped(int connection_id) = 0;
+	virtual void handle_device_data_frame_sent(const t_high_resolution_timepoint &data_arrival_time) = 0;
+};
+
+struct QueuedDeviceDataFrame
+{
+    PackedDeviceDataFramePtr packed_data_frame;
+    t_high_resolution_timepoint data_arrival_time;
+    t_high_resolution_timepoint queued_time;
+    bool coalesce;
+};
+
+/// A data frame added to the UDP batch, in the same order as the batch datagrams.
+/// Keeps the packed bytes the batch refers to alive until the batch is sent.
+struct BatchedDeviceDataFrame
+{
+    int connection_id;
+    PackedDeviceDataFramePtr packed_data_frame;
+    t_high_resolution_timepoint data_arrival_time;
+    t_high_resolution_timepoint queued_time;
+};
+
+// -DataFrameLatencyStats-
+/// Min/avg/max time from device data reaching the server to the data frame 
+/// carrying it being sent on the UDP socket.
+class DataFrameLatencyStats
+{
+public:
+    DataFrameLatencyStats()
+    {
+        reset(std::chrono::high_resolution_clock::now());
+    }
+
+    void add_sample(const t_high_resolution_timepoint &data_arrival_time, const t_high_resolution_timepoint &send_time)
+    {
+        const std::chrono::duration<double, std::milli> latency = send_time - data_arrival_time;
+
+        if (latency.count() >= 0.0 && latency.count() < k_max_latency_sample_ms)
+        {
+            m_min_latency_ms = (m_sample_count > 0) ? std::min(m_min_latency_ms, latency.count()) : latency.count();
+            m_max_latency_ms = (m_sample_count > 0) ? std::max(m_max_latency_ms, latency.count()) : latency.count();
+            m_total_latency_ms += latency.count();
+            ++m_sample_count;
+        }
+    }
+
+    void report_if_due(const t_high_resolution_timepoint &now)
+    {
+        if (now - m_report_start_time >= std::chrono::seconds(k_latency_report_interval_seconds))
+        {
+            if (m_sample_count > 0)
+            {
+                SERVER_LOG_INFO("ServerNetworkManager") 
+                    << "Device data frame latency (arrival -> UDP send) over " << m_sample_count << " frames: "
+                    << "min " << m_min_latency_ms << "ms, "
+                    << "avg " << m_total_latency_ms / static_cast<double>(m_sample_count) << "ms, "
+                    << "max " << m_max_latency_ms << "ms";
+            }
+
+            reset(now);
+        }
+    }
+
+private:
+    void reset(const t_high_resolution_timepoint &now)
+    {
+        m_report_start_time = now;
+        m_sample_count = 0;
+        m_min_latency_ms = 0.0;
+        m_max_latency_ms = 0.0;
+        m_total_latency_ms = 0.0;
+    }
+
+    t_high_resolution_timepoint m_report_start_time;
+    int m_sample_count;
+    double m_min_latency_ms;
+    double m_max_latency_ms;
+    double m_total_latency_ms;
 };
 
+// -DataFrameQueueStats-
+/// How far the per connection data frame queues back up:
+/// deepest queue, oldest frame at send time and frames replaced by a newer coalesced frame.
+class DataFrameQueueStats
+{
+public:
+    DataFrameQueueStats()
+    {
+        reset(std::chrono::high_resolution_clock::now());
+    }
+
+    void add_queue_depth_sample(int queue_depth)
+    {
+        m_max_queue_depth = std::max(m_max_queue_depth, queue_depth);
+    }
+
+    void add_queue_age_sample(const t_high_resolution_timepoint &queued_time, const t_high_resolution_timepoint &send_time)
+    {
+        const std::chrono::duration<double, std::milli> queue_age = send_time - queued_time;
+
+        m_max_queue_age_ms = std::max(m_max_queue_age_ms, queue_age.count());
+        ++m_sent_count;
+    }
+
+    void add_coalesced_drop()
+    {
+        ++m_coalesced_drop_count;
+    }
+
+    void report_if_due(const t_high_resolution_timepoint &now)
+    {
+        if (now - m_report_start_time >= std::chrono::seconds(k_latency_report_interval_seconds))
+        {
+            if (m_sent_count > 0 || m_coalesced_drop_count > 0)
+            {
+                SERVER_LOG_INFO("ServerNetworkManager") 
+                    << "Device data frame queues over " << m_sent_count << " sent frames: "
+                    << "max depth " << m_max_queue_depth << ", "
+                    << "max age " << m_max_queue_age_ms << "ms, "
+                    << m_coalesced_drop_count << " stale frames coalesced away";
+            }
+
+            reset(now);
+        }
+    }
+
+private:
+    void reset(const t_high_resolution_timepoint &now)
+    {
+        m_report_start_time = now;
+        m_sent_count = 0;
+        m_coalesced_drop_count = 0;
+        m_max_queue_depth = 0;
+        m_max_queue_age_ms = 0.0;
+    }
+
+    t_high_resolution_timepoint m_report_start_time;
+    int m_sent_count;
+    int m_coalesced_drop_count;
+    int m_max_queue_depth;
+    double m_max_queue_age_ms;
+};
+
+static int get_data_frame_device_id(const PSMoveProtocol::DeviceOutputDataFrame &data_frame)
+{
+    switch (data_frame.device_category())
+    {
+    case PSMoveProtocol::DeviceOutputDataFrame_DeviceCategory_CONTROLLER:
+        return data_frame.controller_data_packet().controller_id();
+    case PSMoveProtocol::DeviceOutputDataFrame_DeviceCategory_TRACKER:
+        return data_frame.tracker_data_packet().tracker_id();
+    case PSMoveProtocol::DeviceOutputDataFrame_DeviceCategory_HMD:
+        return data_frame.hmd_data_packet().hmd_id();
+    default:
+        return -1;
+    }
+}
+
 //-- Network Manager Config -----
 const int NetworkManagerConfig::CONFIG_VERSION = 1;
 
@@ -160,7 +327,6 @@ public:
             
             m_connection_stopped= true;
             m_has_pending_tcp_write= false;
-            m_has_pending_udp_write= false;
 
             // Notify the parent network manager that this connection is going away
             m_network_event_listener->handle_client_connection_stopped(m_connection_id);
@@ -192,16 +358,6 @@ public:
         return m_connection_started && !m_connection_stopped;
     }
 
-    bool has_pending_udp_write() const
-    {
-        return m_connection_started && m_has_pending_udp_write;
-    }
-
-    bool has_queued_controller_data_frames() const
-    {
-        return m_connection_started && m_pending_dataframes.size() > 0;
-    }
-
     void add_tcp_response_to_write_queue(ResponsePtr response)
     {
         m_pending_responses.push_back(response);
@@ -248,58 +404,84 @@ public:
         return write_in_progress;
     }
     
-    void add_device_data_frame_to_write_queue(DeviceOutputDataFramePtr data_frame)
+    int get_queued_device_data_frame_count() const
     {
-        m_pending_dataframes.push_back(data_frame);
+        return static_cast<int>(m_pending_dataframes.size());
     }
 
-    bool start_udp_write_queued_device_data_frame()
+    /// Returns true if a coalesced frame replaced an unsent older frame of the same device
+    bool add_device_data_frame_to_write_queue(
+        PackedDeviceDataFramePtr packed_data_frame, 
+        const t_high_resolution_timepoint &data_arrival_time,
+        bool coalesce)
     {
-        bool write_in_progress= false;
+        QueuedDeviceDataFrame queued_data_frame;
+        queued_data_frame.packed_data_frame = packed_data_frame;
+        queued_data_frame.data_arrival_time = data_arrival_time;
+        queued_data_frame.queued_time = std::chrono::high_resolution_clock::now();
+        queued_data_frame.coalesce = coalesce;
 
-        if (m_connection_started && !m_connection_stopped)
+        if (coalesce)
         {
-            if (!m_has_pending_udp_write)
+            // At most one coalesced frame per device is ever queued, so this stays short
+            for (QueuedDeviceDataFrame &pending_data_frame : m_pending_dataframes)
             {
-                if (m_pending_dataframes.size() > 0)
+                if (pending_data_frame.coalesce &&
+                    pending_data_frame.packed_data_frame->device_category == packed_data_frame->device_category &&
+                    pending_data_frame.packed_data_frame->device_id == packed_data_frame->device_id)
                 {
-                    DeviceOutputDataFramePtr dataframe= m_pending_dataframes.front();
-
-                    m_packed_output_dataframe.set_msg(dataframe);
-                    if (m_packed_output_dataframe.pack(m_output_dataframe_buffer, sizeof(m_output_dataframe_buffer)))
-                    {
-                        int msg_size= m_packed_output_dataframe.get_msg()->ByteSize();
-
-                        SERVER_LOG_DEBUG("ClientConnection::start_udp_write_queued_device_data_frame") << "Sending UDP DataFrame";
-                        SERVER_LOG_DEBUG("   ") << show_hex(m_output_dataframe_buffer, HEADER_SIZE+msg_size);
-                        SERVER_LOG_DEBUG("   ") << msg_size << " bytes";
-
-                        // The queue should prevent us from writing more than one data frame at once
-                        assert(!m_has_pending_udp_write);
-                        m_has_pending_udp_write= true;
-                        write_in_progress= true;
-
-                        // Start an asynchronous operation to send the data frame
-                        // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
-                        m_udp_socket_ref.async_send_to(
-                            boost::asio::buffer(m_output_dataframe_buffer, sizeof(m_output_dataframe_buffer)),
-                            m_udp_remote_endpoint,
-                            boost::bind(&ClientConnection::handle_udp_write_device_data_frame_complete, this, _1));
-                    }
-                    else
-                    {
-                        SERVER_LOG_ERROR("ClientConnection::start_udp_write_queued_device_data_frame") 
-                            << "DataFrame too big to fit in packet!";
-                    }
+                    // The mailbox keeps its place in the queue but only holds the newest state
+                    pending_data_frame = queued_data_frame;
+                    return true;
                 }
             }
-            else
-            {
-                write_in_progress= true;
-            }
         }
 
-        return write_in_progress;
+        m_pending_dataframes.push_back(queued_data_frame);
+
+        return false;
+    }
+
+    /// Adds every queued data frame to the UDP batch as its own exactly sized datagram
+    void add_queued_device_data_frames_to_batch(
+        ServerUdpBatchSender &batch_sender,
+        vector<BatchedDeviceDataFrame> &batched_data_frames)
+    {
+        if (!can_send_data_to_client())
+        {
+            return;
+        }
+
+        if (!m_is_udp_remote_endpoint_bound)
+        {
+            // Nowhere to send the frames until the client tells us its UDP endpoint
+            SERVER_LOG_TRACE("ClientConnection::add_queued_device_data_frames_to_batch") 
+                << "Dropping " << m_pending_dataframes.size() << " data frames on connection id " 
+                << m_connection_id << " with no UDP endpoint";
+            m_pending_dataframes.clear();
+            return;
+        }
+
+        for (const QueuedDeviceDataFrame &queued_data_frame : m_pending_dataframes)
+        {
+            const std::vector<unsigned char> &bytes= queued_data_frame.packed_data_frame->bytes;
+
+            // Sent straight out of the packed data frame shared with the other connections
+            batch_sender.addDatagramReference(m_udp_remote_endpoint, bytes.data(), bytes.size());
+
+            SERVER_LOG_DEBUG("ClientConnection::add_queued_device_data_frames_to_batch") << "Sending UDP DataFrame";
+            SERVER_LOG_DEBUG("   ") << show_hex(bytes.data(), static_cast<unsigned>(bytes.size()));
+            SERVER_LOG_DEBUG("   ") << bytes.size() - HEADER_SIZE << " bytes";
+
+            BatchedDeviceDataFrame batched_data_frame = { 
+                m_connection_id, 
+                queued_data_frame.packed_data_frame, 
+                queued_data_frame.data_arrival_time, 
+                queued_data_frame.queued_time };
+            batched_data_frames.push_back(batched_data_frame);
+        }
+
+        m_pending_dataframes.clear();
     }
 
 private:
@@ -321,16 +503,13 @@ private:
     vector<uint8_t> m_response_write_buffer;
     PackedMessage<PSMoveProtocol::Response> m_packed_response;
 
-    uint8_t m_output_dataframe_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
-    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_output_dataframe;
 
     deque<ResponsePtr> m_pending_responses;
-    deque<DeviceOutputDataFramePtr> m_pending_dataframes;
+    deque<QueuedDeviceDataFrame> m_pending_dataframes;
     
     bool m_connection_started;
     bool m_connection_stopped;
     bool m_has_pending_tcp_write;
-    bool m_has_pending_udp_write;
 
     ClientConnection(
         IServerNetworkEventListener *network_event_listener,
@@ -348,15 +527,12 @@ private:
         , m_packed_request(std::shared_ptr<PSMoveProtocol::Request>(new PSMoveProtocol::Request()))
         , m_response_write_buffer()
         , m_packed_response()
-        , m_packed_output_dataframe()
         , m_pending_responses()
         , m_pending_dataframes()
         , m_connection_started(false)
         , m_connection_stopped(false)
         , m_has_pending_tcp_write(false)
-        , m_has_pending_udp_write(false)
     {
-        memset(m_output_dataframe_buffer, 0, sizeof(m_output_dataframe_buffer));
         next_connection_id++;
     }
 
@@ -515,31 +691,6 @@ private:
             stop();
         }
     }
-
-    void handle_udp_write_device_data_frame_complete(const boost::system::error_code& ec)
-    {
-        if (m_connection_stopped)
-            return;
-
-        if (!ec)
-        {
-            SERVER_LOG_TRACE("ClientConnection::handle_udp_write_device_data_frame_complete") 
-                << "Sent UDP data frame on connection id " << m_connection_id;
-
-            // no longer is there a pending write
-            m_has_pending_udp_write= false;
-
-            // Remove the dataframe from the pending send queue now that it's sent
-            m_pending_dataframes.pop_front();
-        }
-        else
-        {
-            SERVER_LOG_ERROR("ClientConnection::handle_udp_write_device_data_frame_complete") 
-                << "Error sending data frame on connection " << m_connection_id << ": " << ec.message();
-
-            stop();
-        }
-    }
 };
 int ClientConnection::next_connection_id = 0;
 
@@ -558,6 +709,10 @@ public:
         , m_udp_connection_result_write_buffer(false)
         , m_has_pending_udp_read(false)
         , m_connections()
+        , m_data_frame_latency_stats()
+        , m_data_frame_queue_stats()
+        , m_udp_batch_sender(m_udp_socket)
+        , m_batched_data_frames()
     {
         memset(m_input_dataframe_buffer, 0, sizeof(m_input_dataframe_buffer));
     }
@@ -604,28 +759,18 @@ public:
 
     void poll()
     {
-        bool keep_polling= true;
-        int iteration_count= 0;
-        const static int k_max_iteration_count= 32;
-
-        while (keep_polling && iteration_count < k_max_iteration_count)
-        {
-            // Start any pending writes on the UDP socket that can be started
-            start_udp_queued_data_frame_write();
-
-            // This call can execute any of the following callbacks:
-            // * TCP request has finished reading
-            // * TCP response has finished writing
-            // * UDP data frame has finished writing
-            m_io_service.poll();
-
-            // In the event that a UDP data frame write completed immediately,
-            // we should start another UDP data frame write.
-            keep_polling= has_queued_controller_data_frames_ready_to_start();
-
-            // ... but don't re-run this too many times
-            ++iteration_count;
-        }
+        // This call can execute any of the following callbacks:
+        // * TCP request has finished reading
+        // * TCP response has finished writing
+        // * UDP input data frame has finished reading
+        m_io_service.poll();
+
+        // Send the data frames queued for every connection this update in one go
+        send_queued_data_frames();
+
+        const t_high_resolution_timepoint now= std::chrono::high_resolution_clock::now();
+        m_data_frame_latency_stats.report_if_due(now);
+        m_data_frame_queue_stats.report_if_due(now);
     }
 
     void close_all_connections()
@@ -710,7 +855,11 @@ public:
         }
     }
 
-    void send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame)
+    void send_device_data_frame(
+        int connection_id, 
+        PackedDeviceDataFramePtr packed_data_frame,
+        const t_high_resolution_timepoint &data_arrival_time,
+        bool coalesce)
     {
         t_client_connection_map_iter entry = m_connections.find(connection_id);
 
@@ -721,9 +870,11 @@ public:
             SERVER_LOG_TRACE("ServerNetworkManager::send_device_data_frame") 
                 << "Sending data_frame to connection " << connection_id;
 
-            connection->add_device_data_frame_to_write_queue(data_frame);
-
-            start_udp_queued_data_frame_write();
+            // Goes out with every other queued data frame at the end of the update in poll()
+            if (connection->add_device_data_frame_to_write_queue(packed_data_frame, data_arrival_time, coalesce))
+            {
+                m_data_frame_queue_stats.add_coalesced_drop();
+            }
         }
         else
         {
@@ -746,6 +897,11 @@ public:
         m_request_handler_ref.handle_client_connection_stopped(connection_id);
     }
 
+	virtual void handle_device_data_frame_sent(const t_high_resolution_timepoint &data_arrival_time) override
+    {
+        m_data_frame_latency_stats.add_sample(data_arrival_time, std::chrono::high_resolution_clock::now());
+    }
+
 private:
     // Process and responds to incoming PSMoveService request
     ServerRequestHandler &m_request_handler_ref;
@@ -775,6 +931,16 @@ private:
     // A mapping from connection_id -> ClientConnectionPtr
     t_client_connection_map m_connections;
 
+    // Arrival -> UDP send latency of the device data frames, logged periodically
+    DataFrameLatencyStats m_data_frame_latency_stats;
+
+    // Data frame queue depth and age, logged periodically
+    DataFrameQueueStats m_data_frame_queue_stats;
+
+    // Every data frame sent in an update, for all of the connections
+    ServerUdpBatchSender m_udp_batch_sender;
+    vector<BatchedDeviceDataFrame> m_batched_data_frames;
+
 protected:
     void handle_tcp_accept(ClientConnectionPtr connection, const boost::system::error_code& error)
     {        
@@ -918,47 +1084,58 @@ protected:
         start_udp_read_input_data_frame();
     }
 
-    void start_udp_queued_data_frame_write()
+    void send_queued_data_frames()
     {
         for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
         {
             ClientConnectionPtr connection= iter->second;
 
-            if (connection->start_udp_write_queued_device_data_frame())
-            {
-                SERVER_LOG_TRACE("ServerNetworkManager::start_udp_queued_data_frame_write") 
-                    << "Send queued UDP data on connection id: " << iter->first;
+            m_data_frame_queue_stats.add_queue_depth_sample(connection->get_queued_device_data_frame_count());
+            connection->add_queued_device_data_frames_to_batch(m_udp_batch_sender, m_batched_data_frames);
+        }
 
-                // Don't start a write on any other connection until this one is finished 
-                break;
-            }
-        }        
-    }
+        if (m_udp_batch_sender.getDatagramCount() > 0)
+        {
+            assert(m_udp_batch_sender.getDatagramCount() == static_cast<int>(m_batched_data_frames.size()));
 
-    bool has_queued_controller_data_frames_ready_to_start()
-    {
-        bool has_queued_write_ready_to_start= false;
-        bool udp_socket_available= true;
+            const int sent_count= m_udp_batch_sender.sendAll();
+            const t_high_resolution_timepoint send_time= std::chrono::high_resolution_clock::now();
 
-        for (t_client_connection_map_iter iter= m_connections.begin(); iter != m_connections.end(); ++iter)
-        {
-            ClientConnectionPtr connection= iter->second;
+            SERVER_LOG_TRACE("ServerNetworkManager::send_queued_data_frames") 
+                << "Sent " << sent_count << "/" << m_batched_data_frames.size() << " UDP data frames";
 
-            if (connection->has_pending_udp_write())
+            for (int datagram_index= 0; datagram_index < static_cast<int>(m_batched_data_frames.size()); ++datagram_index)
             {
-                // Can't start any new udp write until any current udp write is done
-                udp_socket_available= false;
-                break;
-            }
+                const BatchedDeviceDataFrame &batched_data_frame= m_batched_data_frames[datagram_index];
+                const boost::system::error_code &error= m_udp_batch_sender.getSendError(datagram_index);
 
-            if (connection->has_queued_controller_data_frames())
-            {
-                // Found a connection with a pending udp write ready to go
-                has_queued_write_ready_to_start= true;
+                if (!error)
+                {
+                    // Track how long the device data took to go out
+                    handle_device_data_frame_sent(batched_data_frame.data_arrival_time);
+                    m_data_frame_queue_stats.add_queue_age_sample(batched_data_frame.queued_time, send_time);
+                }
+                else
+                {
+                    // The connection may already have been stopped by an earlier frame in the batch
+                    t_client_connection_map_iter entry = m_connections.find(batched_data_frame.connection_id);
+
+                    if (entry != m_connections.end())
+                    {
+                        ClientConnectionPtr connection= entry->second;
+
+                        SERVER_LOG_ERROR("ServerNetworkManager::send_queued_data_frames") 
+                            << "Error sending data frame on connection " << batched_data_frame.connection_id 
+                            << ": " << error.message();
+
+                        connection->stop();
+                    }
+                }
             }
         }
 
-        return udp_socket_available && has_queued_write_ready_to_start;
+        m_udp_batch_sender.clear();
+        m_batched_data_frames.clear();
     }
 };
 
@@ -1035,10 +1212,40 @@ void ServerNetworkManager::send_notification_to_all_clients(ResponsePtr response
 	}
 }
 
-void ServerNetworkManager::send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame)
+PackedDeviceDataFramePtr ServerNetworkManager::pack_device_data_frame(
+    const PSMoveProtocol::DeviceOutputDataFrame &data_frame)
+{
+    // The client receives into a HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE buffer
+    const int msg_size= data_frame.ByteSize();
+    if (msg_size > MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE)
+    {
+        SERVER_LOG_ERROR("ServerNetworkManager::pack_device_data_frame") << "DataFrame too big to fit in packet!";
+        return PackedDeviceDataFramePtr();
+    }
+
+    std::shared_ptr<PackedDeviceDataFrame> packed_data_frame(new PackedDeviceDataFrame);
+    packed_data_frame->bytes.resize(HEADER_SIZE+msg_size);
+    packed_data_frame->device_category= data_frame.device_category();
+    packed_data_frame->device_id= get_data_frame_device_id(data_frame);
+
+    if (!PackedMessage<PSMoveProtocol::DeviceOutputDataFrame>::pack_exact(
+            data_frame, packed_data_frame->bytes.data(), msg_size))
+    {
+        SERVER_LOG_ERROR("ServerNetworkManager::pack_device_data_frame") << "Failed to serialize DataFrame!";
+        return PackedDeviceDataFramePtr();
+    }
+
+    return packed_data_frame;
+}
+
+void ServerNetworkManager::send_device_data_frame(
+    int connection_id, 
+    PackedDeviceDataFramePtr packed_data_frame,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &data_arrival_time,
+    bool coalesce)
 {
 	if (implementation_ptr != nullptr)
 	{    
-		implementation_ptr->send_device_data_frame(connection_id, data_frame);
+		implementation_ptr->send_device_data_frame(connection_id, packed_data_frame, data_arrival_time, coalesce);
 	}
 }
@@ -5,6 +5,9 @@
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveConfig.h"
 
+#include <chrono>
+#include <vector>
+
 //-- pre-declarations -----
 class ServerRequestHandler;
 
@@ -15,6 +18,16 @@ namespace boost {
 }
 
 //-- definitions -----
+/// A device data frame serialized (along with its packet header) once,
+/// then shared by every connection it gets sent to
+struct PackedDeviceDataFrame
+{
+    std::vector<unsigned char> bytes;
+    int device_category;
+    int device_id;
+};
+typedef std::shared_ptr<const PackedDeviceDataFrame> PackedDeviceDataFramePtr;
+
 class NetworkManagerConfig : public PSMoveConfig
 {
 public:
@@ -66,8 +79,20 @@ public:
     void send_notification(int connection_id, ResponsePtr response);
     
     void send_notification_to_all_clients(ResponsePtr response);
+
+    /// Serializes a data frame for send_device_data_frame().
+    /// Returns an empty pointer if the data frame doesn't fit in a packet.
+    static PackedDeviceDataFramePtr pack_device_data_frame(const PSMoveProtocol::DeviceOutputDataFrame &data_frame);
     
-    void send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame);
+    /// data_arrival_time is when the device data in the frame reached the server.
+    /// Used to measure the arrival -> UDP send latency.
+    /// When coalesce is set the frame replaces any unsent coalesced frame of the same device
+    /// on the connection, so a client that falls behind only ever gets the newest state.
+    void send_device_data_frame(
+        int connection_id, 
+        PackedDeviceDataFramePtr packed_data_frame,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &data_arrival_time,
+        bool coalesce= false);
 
 private:   
 	/// Configuration settings used by the network manager
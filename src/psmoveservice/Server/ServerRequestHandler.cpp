@@ -31,7 +31,9 @@
 #include <cassert>
 #include <bitset>
 #include <map>
+#include <vector>
 #include <boost/shared_ptr.hpp>
+#include <google/protobuf/arena.h>
 
 //-- pre-declarations -----
 class ServerRequestHandlerImpl;
@@ -84,6 +86,24 @@ struct RequestContext
     RequestPtr request;
 };
 
+/// A data frame packed while publishing a device update,
+/// shared by every stream with the same data frame signature
+struct PublishedDataFrame
+{
+    unsigned int data_frame_signature;
+    PackedDeviceDataFramePtr packed_data_frame;
+};
+
+/// The device state a rate limited stream's publish decision is based on,
+/// taken once per published update
+struct StreamRateLimitSample
+{
+    double time_seconds;
+    CommonDevicePose pose;
+    unsigned int button_bitmask;
+    bool is_tracking;
+};
+
 //-- private implementation -----
 class ServerRequestHandlerImpl
 {
@@ -91,6 +111,8 @@ public:
     ServerRequestHandlerImpl(DeviceManager &deviceManager)
         : m_device_manager(deviceManager)
         , m_connection_state_map()
+        , m_data_frame_arena()
+        , m_published_data_frames()
     {
     }
 
@@ -375,6 +397,14 @@ public:
                 response = new PSMoveProtocol::Response;
                 handle_request__get_service_version(context, response);
                 break;
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_TIME:
+                response = new PSMoveProtocol::Response;
+                handle_request__get_service_time(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_BATCH:
+                response = new PSMoveProtocol::Response;
+                handle_request__batch(context, response);
+                break;
 
             default:
                 assert(0 && "Whoops, bad request!");
@@ -496,9 +526,12 @@ public:
 
     void publish_controller_data_frame(
          ServerControllerView *controller_view, 
-         ServerRequestHandler::t_generate_controller_data_frame_for_stream callback)
+         ServerRequestHandler::t_generate_controller_data_frame_for_stream callback,
+         ServerRequestHandler::t_generate_controller_raw_data_frame_for_stream raw_callback)
     {
         int controller_id= controller_view->getDeviceID();
+        StreamRateLimitSample rate_limit_sample;
+        bool bHasRateLimitSample= false;
 
         // Notify any connections that care about the controller update
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -508,17 +541,72 @@ public:
 
             if (connection_state->active_controller_streams.test(controller_id))
             {
-                const ControllerStreamInfo &streamInfo=
+                ControllerStreamInfo &streamInfo=
                     connection_state->active_controller_stream_info[controller_id];
+                const unsigned int data_frame_signature= streamInfo.GetDataFrameSignature();
+
+                // Low rate and send-on-change streams skip updates before anything gets built for them
+                if (streamInfo.rate_limit.GetIsLimited())
+                {
+                    if (!bHasRateLimitSample)
+                    {
+                        const CommonControllerState *controller_state= controller_view->getState();
+
+                        rate_limit_sample.time_seconds= ServerUtility::get_monotonic_time_seconds();
+                        rate_limit_sample.pose= controller_view->getFilteredPose();
+                        rate_limit_sample.button_bitmask= (controller_state != nullptr) ? controller_state->AllButtons : 0;
+                        rate_limit_sample.is_tracking= controller_view->getIsCurrentlyTracking();
+                        bHasRateLimitSample= true;
+                    }
+
+                    if (!consume_stream_rate_limit(rate_limit_sample, streamInfo.rate_limit))
+                    {
+                        continue;
+                    }
+                }
+
+                // Build and pack the data frame only for the first stream with this signature
+                PackedDeviceDataFramePtr packed_data_frame;
+                if (!find_published_data_frame(data_frame_signature, packed_data_frame))
+                {
+                    std::shared_ptr<PackedDeviceDataFrame> raw_data_frame;
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(controller_view, &streamInfo, data_frame.get());
+                    if (streamInfo.raw_data_frame_format)
+                    {
+                        raw_data_frame= std::make_shared<PackedDeviceDataFrame>();
+
+                        if (!raw_callback(controller_view, &streamInfo, raw_data_frame.get()))
+                        {
+                            raw_data_frame.reset();
+                        }
+                    }
+
+                    if (raw_data_frame)
+                    {
+                        packed_data_frame= add_published_data_frame(data_frame_signature, raw_data_frame);
+                    }
+                    else
+                    {
+                        // Fill out a data frame specific to this stream using the given callback
+                        PSMoveProtocol::DeviceOutputDataFrame *data_frame= 
+                            google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(&m_data_frame_arena);
+                        callback(controller_view, &streamInfo, data_frame);
+
+                        packed_data_frame= add_published_data_frame(data_frame_signature, *data_frame);
+                    }
+                }
 
                 // Send the controller data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                if (packed_data_frame)
+                {
+                    ServerNetworkManager::get_instance()->send_device_data_frame(
+                        connection_id, packed_data_frame, controller_view->getLastNewDataTimestamp(),
+                        streamInfo.coalesce_data_frames);
+                }
             }
         }
+
+        end_publish();
     }
 
     void publish_tracker_data_frame(
@@ -538,21 +626,38 @@ public:
                 const TrackerStreamInfo &streamInfo =
                     connection_state->active_tracker_stream_info[tracker_id];
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(tracker_view, &streamInfo, data_frame);
+                // The tracker data frame is the same for every stream
+                PackedDeviceDataFramePtr packed_data_frame;
+                if (!find_published_data_frame(0, packed_data_frame))
+                {
+                    // Fill out the data frame using the given callback
+                    PSMoveProtocol::DeviceOutputDataFrame *data_frame = 
+                        google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(&m_data_frame_arena);
+                    callback(tracker_view, &streamInfo, data_frame);
+
+                    packed_data_frame = add_published_data_frame(0, *data_frame);
+                }
 
                 // Send the tracker data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                if (packed_data_frame)
+                {
+                    ServerNetworkManager::get_instance()->send_device_data_frame(
+                        connection_id, packed_data_frame, tracker_view->getLastNewDataTimestamp());
+                }
             }
         }
+
+        end_publish();
     }
 
     void publish_hmd_data_frame(
         class ServerHMDView *hmd_view,
-        ServerRequestHandler::t_generate_hmd_data_frame_for_stream callback)
+        ServerRequestHandler::t_generate_hmd_data_frame_for_stream callback,
+        ServerRequestHandler::t_generate_hmd_raw_data_frame_for_stream raw_callback)
     {
         int hmd_id = hmd_view->getDeviceID();
+        StreamRateLimitSample rate_limit_sample;
+        bool bHasRateLimitSample = false;
 
         // Notify any connections that care about the tracker update
         for (t_connection_state_iter iter = m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -562,20 +667,211 @@ public:
 
             if (connection_state->active_hmd_streams.test(hmd_id))
             {
-                const HMDStreamInfo &streamInfo =
+                HMDStreamInfo &streamInfo =
                     connection_state->active_hmd_stream_info[hmd_id];
+                const unsigned int data_frame_signature = streamInfo.GetDataFrameSignature();
+
+                // Low rate and send-on-change streams skip updates before anything gets built for them
+                if (streamInfo.rate_limit.GetIsLimited())
+                {
+                    if (!bHasRateLimitSample)
+                    {
+                        rate_limit_sample.time_seconds = ServerUtility::get_monotonic_time_seconds();
+                        rate_limit_sample.pose = hmd_view->getFilteredPose();
+                        rate_limit_sample.button_bitmask = 0;
+                        rate_limit_sample.is_tracking = hmd_view->getIsCurrentlyTracking();
+                        bHasRateLimitSample = true;
+                    }
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(hmd_view, &streamInfo, data_frame);
+                    if (!consume_stream_rate_limit(rate_limit_sample, streamInfo.rate_limit))
+                    {
+                        continue;
+                    }
+                }
+
+                // Build and pack the data frame only for the first stream with this signature
+                PackedDeviceDataFramePtr packed_data_frame;
+                if (!find_published_data_frame(data_frame_signature, packed_data_frame))
+                {
+                    if (streamInfo.raw_data_frame_format)
+                    {
+                        std::shared_ptr<PackedDeviceDataFrame> raw_data_frame = std::make_shared<PackedDeviceDataFrame>();
+                        raw_callback(hmd_view, &streamInfo, raw_data_frame.get());
+
+                        packed_data_frame = add_published_data_frame(data_frame_signature, raw_data_frame);
+                    }
+                    else
+                    {
+                        // Fill out a data frame specific to this stream using the given callback
+                        PSMoveProtocol::DeviceOutputDataFrame *data_frame = 
+                            google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(&m_data_frame_arena);
+                        callback(hmd_view, &streamInfo, data_frame);
+
+                        packed_data_frame = add_published_data_frame(data_frame_signature, *data_frame);
+                    }
+                }
 
                 // Send the hmd data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                if (packed_data_frame)
+                {
+                    ServerNetworkManager::get_instance()->send_device_data_frame(
+                        connection_id, packed_data_frame, hmd_view->getLastNewDataTimestamp(),
+                        streamInfo.coalesce_data_frames);
+                }
             }
         }
+
+        end_publish();
     }    
 
 protected:
+    // -- Stream Rate Limiting -----
+    static void set_stream_rate_limit(
+        float max_data_frame_rate,
+        float position_change_threshold_cm,
+        float orientation_change_threshold_degrees,
+        StreamRateLimitInfo &rate_limit)
+    {
+        rate_limit.Clear();
+        rate_limit.min_data_frame_interval_seconds= 
+            (max_data_frame_rate > 0.f) ? 1.0 / static_cast<double>(max_data_frame_rate) : 0.0;
+        rate_limit.position_change_threshold_cm= std::max(position_change_threshold_cm, 0.f);
+        rate_limit.orientation_change_threshold_radians= 
+            std::max(orientation_change_threshold_degrees, 0.f) * k_degrees_to_radians;
+    }
+
+    // Returns true if the stream should get the data frame for the given device state,
+    // in which case that state becomes the one later updates get compared against
+    static bool consume_stream_rate_limit(
+        const StreamRateLimitSample &sample,
+        StreamRateLimitInfo &rate_limit)
+    {
+        if (rate_limit.has_sent_data_frame)
+        {
+            if (sample.time_seconds < rate_limit.next_data_frame_time_seconds)
+            {
+                return false;
+            }
+
+            if (rate_limit.GetIsSendingOnChange() && !has_stream_state_changed(sample, rate_limit))
+            {
+                return false;
+            }
+        }
+
+        // Deadlines advance by whole intervals so that jitter in the publish ticks doesn't lower the rate
+        // (unless the stream fell behind, i.e. after it sat still for a while)
+        rate_limit.next_data_frame_time_seconds+= rate_limit.min_data_frame_interval_seconds;
+        if (rate_limit.next_data_frame_time_seconds < sample.time_seconds)
+        {
+            rate_limit.next_data_frame_time_seconds= sample.time_seconds + rate_limit.min_data_frame_interval_seconds;
+        }
+
+        rate_limit.has_sent_data_frame= true;
+        rate_limit.last_position_cm[0]= sample.pose.PositionCm.x;
+        rate_limit.last_position_cm[1]= sample.pose.PositionCm.y;
+        rate_limit.last_position_cm[2]= sample.pose.PositionCm.z;
+        rate_limit.last_orientation[0]= sample.pose.Orientation.w;
+        rate_limit.last_orientation[1]= sample.pose.Orientation.x;
+        rate_limit.last_orientation[2]= sample.pose.Orientation.y;
+        rate_limit.last_orientation[3]= sample.pose.Orientation.z;
+        rate_limit.last_button_bitmask= sample.button_bitmask;
+        rate_limit.last_is_tracking= sample.is_tracking;
+
+        return true;
+    }
+
+    static bool has_stream_state_changed(
+        const StreamRateLimitSample &sample,
+        const StreamRateLimitInfo &rate_limit)
+    {
+        // Button and tracking changes always go out, whatever the pose did
+        if (sample.button_bitmask != rate_limit.last_button_bitmask || sample.is_tracking != rate_limit.last_is_tracking)
+        {
+            return true;
+        }
+
+        if (rate_limit.position_change_threshold_cm > 0.f)
+        {
+            const float dx= sample.pose.PositionCm.x - rate_limit.last_position_cm[0];
+            const float dy= sample.pose.PositionCm.y - rate_limit.last_position_cm[1];
+            const float dz= sample.pose.PositionCm.z - rate_limit.last_position_cm[2];
+            const float threshold= rate_limit.position_change_threshold_cm;
+
+            if (dx*dx + dy*dy + dz*dz > threshold*threshold)
+            {
+                return true;
+            }
+        }
+
+        if (rate_limit.orientation_change_threshold_radians > 0.f)
+        {
+            // Angle of the rotation between the two orientations is 2*acos(|q0.q1|)
+            const float dot=
+                sample.pose.Orientation.w*rate_limit.last_orientation[0] +
+                sample.pose.Orientation.x*rate_limit.last_orientation[1] +
+                sample.pose.Orientation.y*rate_limit.last_orientation[2] +
+                sample.pose.Orientation.z*rate_limit.last_orientation[3];
+            const float angle= 2.f*acosf(std::min(fabsf(dot), 1.f));
+
+            if (angle > rate_limit.orientation_change_threshold_radians)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // -- Data Frame Publishing -----
+    bool find_published_data_frame(unsigned int data_frame_signature, PackedDeviceDataFramePtr &out_packed_data_frame) const
+    {
+        for (const PublishedDataFrame &published_data_frame : m_published_data_frames)
+        {
+            if (published_data_frame.data_frame_signature == data_frame_signature)
+            {
+                out_packed_data_frame= published_data_frame.packed_data_frame;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    PackedDeviceDataFramePtr add_published_data_frame(
+        unsigned int data_frame_signature, 
+        const PSMoveProtocol::DeviceOutputDataFrame &data_frame)
+    {
+        // Remembered even if packing failed, so a bad data frame only gets built once
+        PublishedDataFrame published_data_frame;
+        published_data_frame.data_frame_signature= data_frame_signature;
+        published_data_frame.packed_data_frame= ServerNetworkManager::pack_device_data_frame(data_frame);
+
+        m_published_data_frames.push_back(published_data_frame);
+
+        return published_data_frame.packed_data_frame;
+    }
+
+    PackedDeviceDataFramePtr add_published_data_frame(
+        unsigned int data_frame_signature, 
+        PackedDeviceDataFramePtr packed_data_frame)
+    {
+        PublishedDataFrame published_data_frame;
+        published_data_frame.data_frame_signature= data_frame_signature;
+        published_data_frame.packed_data_frame= packed_data_frame;
+
+        m_published_data_frames.push_back(published_data_frame);
+
+        return published_data_frame.packed_data_frame;
+    }
+
+    void end_publish()
+    {
+        // The packed data frames own their bytes, so the messages they were built from can go
+        m_published_data_frames.clear();
+        m_data_frame_arena.Reset();
+    }
+
     RequestConnectionStatePtr FindOrCreateConnectionState(int connection_id)
     {
         t_connection_state_iter iter= m_connection_state_map.find(connection_id);
@@ -777,7 +1073,21 @@ protected:
             ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
 
             // Some controllers can only be streamed when connected via bluetooth
-            if (controller_view->getIsStreamable())
+            if (!controller_view->getIsStreamable())
+            {
+                SERVER_LOG_INFO("ServerRequestHandler") << "Failed to start controller(" << controller_id << ") stream: Not on stream-able connection.";
+
+                response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+            }
+            // Rather than quietly falling back to protobuf data frames the client wouldn't expect
+            else if (request.raw_data_frame_format() && !controller_view->getHasRawDataFrameLayout())
+            {
+                SERVER_LOG_WARNING("ServerRequestHandler") << "Failed to start controller(" << controller_id << ") stream: "
+                    << "No raw data frame format for controller type " << CommonDeviceState::getDeviceTypeString(controller_view->getControllerDeviceType());
+
+                response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+            }
+            else
             {
                 ControllerStreamInfo &streamInfo =
                     context.connection_state->active_controller_stream_info[controller_id];
@@ -794,6 +1104,13 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.coalesce_data_frames = request.coalesce_data_frames();
+                streamInfo.raw_data_frame_format = request.raw_data_frame_format();
+                set_stream_rate_limit(
+                    request.max_data_frame_rate(),
+                    request.position_change_threshold_cm(),
+                    request.orientation_change_threshold_degrees(),
+                    streamInfo.rate_limit);
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start controller(" << controller_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -802,6 +1119,11 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",coalesce=" << streamInfo.coalesce_data_frames
+                    << ",raw_format=" << streamInfo.raw_data_frame_format
+                    << ",max_rate=" << request.max_data_frame_rate()
+                    << ",pos_threshold=" << request.position_change_threshold_cm()
+                    << ",ang_threshold=" << request.orientation_change_threshold_degrees()
                     << ")";
 
                 if (streamInfo.include_position_data)
@@ -824,12 +1146,6 @@ protected:
 
                 response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
             }
-            else
-            {
-                SERVER_LOG_INFO("ServerRequestHandler") << "Failed to start controller(" << controller_id << ") stream: Not on stream-able connection.";
-
-                response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
-            }
         }
         else
         {
@@ -2632,6 +2948,13 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.coalesce_data_frames = request.coalesce_data_frames();
+                streamInfo.raw_data_frame_format = request.raw_data_frame_format();
+                set_stream_rate_limit(
+                    request.max_data_frame_rate(),
+                    request.position_change_threshold_cm(),
+                    request.orientation_change_threshold_degrees(),
+                    streamInfo.rate_limit);
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start hmd(" << hmd_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -2640,6 +2963,11 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",coalesce=" << streamInfo.coalesce_data_frames
+                    << ",raw_format=" << streamInfo.raw_data_frame_format
+                    << ",max_rate=" << request.max_data_frame_rate()
+                    << ",pos_threshold=" << request.position_change_threshold_cm()
+                    << ",ang_threshold=" << request.orientation_change_threshold_degrees()
                     << ")";
 
                 if (streamInfo.disable_roi)
@@ -3016,6 +3344,63 @@ protected:
         response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
     }
 
+    void handle_request__get_service_time(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        PSMoveProtocol::Response_ResultServiceTime* time_info = response->mutable_result_service_time();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_SERVICE_TIME);
+
+        // Clients pair this with their own send/receive times to estimate the clock offset
+        // used to convert data frame time stamps (see ClientClockOffsetEstimator)
+        time_info->set_service_time_seconds(ServerUtility::get_monotonic_time_seconds());
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
+    void handle_request__batch(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        PSMoveProtocol::Request_RequestBatch *batch= context.request->mutable_request_batch();
+        PSMoveProtocol::Response_ResultBatch *batch_result= response->mutable_result_batch();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_BATCH_RESULT);
+
+        for (int request_index= 0; request_index < batch->requests_size(); ++request_index)
+        {
+            // Shares ownership of the batch rather than copying the sub-request out of it
+            RequestPtr sub_request(context.request, batch->mutable_requests(request_index));
+            PSMoveProtocol::Response *sub_response= batch_result->add_responses();
+            bool bHasSubResponse= false;
+
+            if (sub_request->type() != PSMoveProtocol::Request_RequestType_BATCH)
+            {
+                ResponsePtr handled_response= handle_request(context.connection_state->connection_id, sub_request);
+
+                if (handled_response)
+                {
+                    sub_response->Swap(handled_response.get());
+                    bHasSubResponse= true;
+                }
+            }
+            else
+            {
+                SERVER_LOG_ERROR("ServerRequestHandler") << "Nested batch requests aren't supported";
+            }
+
+            // Every sub-request gets an answer so that the client can retire it
+            if (!bHasSubResponse)
+            {
+                sub_response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+                sub_response->set_request_id(sub_request->request_id());
+                sub_response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+            }
+        }
+
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
     // -- Data Frame Updates -----
     void handle_data_frame__controller_packet(
         RequestConnectionStatePtr connection_state,
@@ -3127,6 +3512,10 @@ protected:
 private:
     DeviceManager &m_device_manager;
     t_connection_state_map m_connection_state_map;
+
+    // Scratch space for building the data frames of a single device publish
+    google::protobuf::Arena m_data_frame_arena;
+    std::vector<PublishedDataFrame> m_published_data_frames;
 };
 
 //-- public interface -----
@@ -3186,9 +3575,10 @@ void ServerRequestHandler::handle_client_connection_stopped(int connection_id)
 
 void ServerRequestHandler::publish_controller_data_frame(
     ServerControllerView *controller_view, 
-    t_generate_controller_data_frame_for_stream callback)
+    t_generate_controller_data_frame_for_stream callback,
+    t_generate_controller_raw_data_frame_for_stream raw_callback)
 {
-    return m_implementation_ptr->publish_controller_data_frame(controller_view, callback);
+    return m_implementation_ptr->publish_controller_data_frame(controller_view, callback, raw_callback);
 }
 
 void ServerRequestHandler::publish_tracker_data_frame(
@@ -3200,7 +3590,8 @@ void ServerRequestHandler::publish_tracker_data_frame(
 
 void ServerRequestHandler::publish_hmd_data_frame(
     class ServerHMDView *hmd_view,
-    t_generate_hmd_data_frame_for_stream callback)
+    t_generate_hmd_data_frame_for_stream callback,
+    t_generate_hmd_raw_data_frame_for_stream raw_callback)
 {
-    return m_implementation_ptr->publish_hmd_data_frame(hmd_view, callback);
+    return m_implementation_ptr->publish_hmd_data_frame(hmd_view, callback, raw_callback);
 }
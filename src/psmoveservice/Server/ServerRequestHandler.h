@@ -6,12 +6,54 @@
 
 // -- pre-declarations -----
 class DeviceManager;
+struct PackedDeviceDataFrame;
 namespace boost {
     namespace program_options {
         class variables_map;
 }};
 
 // -- definitions -----
+/// Publish throttling a client asked for when starting a controller or HMD stream.
+/// With no interval and no thresholds every published update gets sent.
+struct StreamRateLimitInfo
+{
+    double min_data_frame_interval_seconds;
+    float position_change_threshold_cm;
+    float orientation_change_threshold_radians;
+
+    // What the last data frame sent on the stream had
+    bool has_sent_data_frame;
+    double next_data_frame_time_seconds;
+    float last_position_cm[3];
+    float last_orientation[4]; // w, x, y, z
+    unsigned int last_button_bitmask;
+    bool last_is_tracking;
+
+    inline void Clear()
+    {
+        min_data_frame_interval_seconds = 0.0;
+        position_change_threshold_cm = 0.f;
+        orientation_change_threshold_radians = 0.f;
+        has_sent_data_frame = false;
+        next_data_frame_time_seconds = 0.0;
+        last_position_cm[0] = last_position_cm[1] = last_position_cm[2] = 0.f;
+        last_orientation[0] = 1.f;
+        last_orientation[1] = last_orientation[2] = last_orientation[3] = 0.f;
+        last_button_bitmask = 0;
+        last_is_tracking = false;
+    }
+
+    inline bool GetIsSendingOnChange() const
+    {
+        return position_change_threshold_cm > 0.f || orientation_change_threshold_radians > 0.f;
+    }
+
+    inline bool GetIsLimited() const
+    {
+        return min_data_frame_interval_seconds > 0.0 || GetIsSendingOnChange();
+    }
+};
+
 struct ControllerStreamInfo
 {
     bool include_position_data;
@@ -21,8 +63,11 @@ struct ControllerStreamInfo
     bool include_raw_tracker_data;
     bool led_override_active;
 	bool disable_roi;
+    bool coalesce_data_frames;
+    bool raw_data_frame_format;
     int last_data_input_sequence_number;
     int selected_tracker_index;
+    StreamRateLimitInfo rate_limit;
 
     inline void Clear()
     {
@@ -33,8 +78,24 @@ struct ControllerStreamInfo
         include_raw_tracker_data = false;
         led_override_active = false;
 		disable_roi = false;
+        coalesce_data_frames = false;
+        raw_data_frame_format = false;
 		last_data_input_sequence_number = -1;
         selected_tracker_index = 0;
+        rate_limit.Clear();
+    }
+
+    /// Streams with the same signature get identical data frames.
+    /// Covers every field ServerControllerView::generate_controller_data_frame_for_stream() reads.
+    inline unsigned int GetDataFrameSignature() const
+    {
+        return
+            (include_position_data ? 0x01 : 0) |
+            (include_physics_data ? 0x02 : 0) |
+            (include_raw_sensor_data ? 0x04 : 0) |
+            (include_calibrated_sensor_data ? 0x08 : 0) |
+            (include_raw_tracker_data ? (0x10 | (static_cast<unsigned int>(selected_tracker_index) << 8)) : 0) |
+            (raw_data_frame_format ? 0x20 : 0);
     }
 };
 
@@ -58,7 +119,10 @@ struct HMDStreamInfo
 	bool include_calibrated_sensor_data;
 	bool include_raw_tracker_data;
 	bool disable_roi;
+    bool coalesce_data_frames;
+    bool raw_data_frame_format;
     int selected_tracker_index;
+    StreamRateLimitInfo rate_limit;
 
     inline void Clear()
     {
@@ -68,7 +132,23 @@ struct HMDStreamInfo
 		include_calibrated_sensor_data = false;
 		include_raw_tracker_data = false;
 		disable_roi = false;
+        coalesce_data_frames = false;
+        raw_data_frame_format = false;
         selected_tracker_index = 0;
+        rate_limit.Clear();
+    }
+
+    /// Streams with the same signature get identical data frames.
+    /// Covers every field ServerHMDView::generate_hmd_data_frame_for_stream() reads.
+    inline unsigned int GetDataFrameSignature() const
+    {
+        return
+            (include_position_data ? 0x01 : 0) |
+            (include_physics_data ? 0x02 : 0) |
+            (include_raw_sensor_data ? 0x04 : 0) |
+            (include_calibrated_sensor_data ? 0x08 : 0) |
+            (include_raw_tracker_data ? (0x10 | (static_cast<unsigned int>(selected_tracker_index) << 8)) : 0) |
+            (raw_data_frame_format ? 0x20 : 0);
     }
 };
 
@@ -99,8 +179,17 @@ public:
             const class ServerControllerView *controller_view,
             const ControllerStreamInfo *stream_info,
             PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+    /// Streams that asked for the raw data frame format get their datagram from this callback instead.
+    /// It returns false if the controller has no raw layout, in which case the protobuf callback is used
+    /// (streams only get started in the raw format for controllers that have one, see ServerControllerView::getHasRawDataFrameLayout).
+    typedef bool (*t_generate_controller_raw_data_frame_for_stream)(
+            const class ServerControllerView *controller_view,
+            const ControllerStreamInfo *stream_info,
+            PackedDeviceDataFrame *out_packed_data_frame);
     void publish_controller_data_frame(
-        class ServerControllerView *controller_view, t_generate_controller_data_frame_for_stream callback);
+        class ServerControllerView *controller_view, 
+        t_generate_controller_data_frame_for_stream callback,
+        t_generate_controller_raw_data_frame_for_stream raw_callback);
 
     /// When publishing tracker data to all listening connections
     /// we need to provide a callback that will fill out a data frame given:
@@ -110,7 +199,7 @@ public:
     typedef void(*t_generate_tracker_data_frame_for_stream)(
         const class ServerTrackerView *tracker_view,
         const TrackerStreamInfo *stream_info,
-        DeviceOutputDataFramePtr &data_frame);
+        PSMoveProtocol::DeviceOutputDataFrame *data_frame);
     void publish_tracker_data_frame(
         class ServerTrackerView *tracker_view, t_generate_tracker_data_frame_for_stream callback);
         
@@ -122,9 +211,16 @@ public:
     typedef void(*t_generate_hmd_data_frame_for_stream)(
         const class ServerHMDView *hmd_view,
         const HMDStreamInfo *stream_info,
-        DeviceOutputDataFramePtr &data_frame);
+        PSMoveProtocol::DeviceOutputDataFrame *data_frame);
+    /// Streams that asked for the raw data frame format get their datagram from this callback instead.
+    typedef void(*t_generate_hmd_raw_data_frame_for_stream)(
+        const class ServerHMDView *hmd_view,
+        const HMDStreamInfo *stream_info,
+        PackedDeviceDataFrame *out_packed_data_frame);
     void publish_hmd_data_frame(
-        class ServerHMDView *hmd_view, t_generate_hmd_data_frame_for_stream callback);        
+        class ServerHMDView *hmd_view, 
+        t_generate_hmd_data_frame_for_stream callback,
+        t_generate_hmd_raw_data_frame_for_stream raw_callback);
 
 private:
     // private implementation - same lifetime as the ServerRequestHandler
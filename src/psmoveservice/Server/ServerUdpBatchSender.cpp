@@ -0,0 +1,172 @@
+//-- includes -----
+#include "ServerUdpBatchSender.h"
+
+#include <assert.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#endif
+
+//-- public methods -----
+ServerUdpBatchSender::ServerUdpBatchSender(boost::asio::ip::udp::socket &socket)
+    : m_socket(socket)
+    , m_payload_buffer()
+    , m_datagrams()
+{
+}
+
+uint8_t *ServerUdpBatchSender::addDatagram(const boost::asio::ip::udp::endpoint &endpoint, size_t datagram_size)
+{
+    Datagram datagram;
+    datagram.endpoint = endpoint;
+    datagram.external_data = nullptr;
+    datagram.buffer_offset = m_payload_buffer.size();
+    datagram.size = datagram_size;
+
+    m_datagrams.push_back(datagram);
+    m_payload_buffer.resize(datagram.buffer_offset + datagram_size);
+
+    return m_payload_buffer.data() + datagram.buffer_offset;
+}
+
+void ServerUdpBatchSender::addDatagramReference(
+    const boost::asio::ip::udp::endpoint &endpoint, 
+    const uint8_t *data, 
+    size_t datagram_size)
+{
+    Datagram datagram;
+    datagram.endpoint = endpoint;
+    datagram.external_data = data;
+    datagram.buffer_offset = 0;
+    datagram.size = datagram_size;
+
+    m_datagrams.push_back(datagram);
+}
+
+int ServerUdpBatchSender::sendAll()
+{
+    if (m_datagrams.empty())
+    {
+        return 0;
+    }
+
+#ifdef __linux__
+    send_mmsg();
+#else
+    send_individually(0);
+#endif
+
+    int sent_count = 0;
+    for (const Datagram &datagram : m_datagrams)
+    {
+        if (!datagram.send_error)
+        {
+            ++sent_count;
+        }
+    }
+
+    return sent_count;
+}
+
+const boost::system::error_code &ServerUdpBatchSender::getSendError(int datagram_index) const
+{
+    assert(datagram_index >= 0 && datagram_index < getDatagramCount());
+    return m_datagrams[datagram_index].send_error;
+}
+
+void ServerUdpBatchSender::clear()
+{
+    m_payload_buffer.clear();
+    m_datagrams.clear();
+}
+
+//-- protected methods -----
+const uint8_t *ServerUdpBatchSender::get_datagram_data(size_t datagram_index) const
+{
+    const Datagram &datagram = m_datagrams[datagram_index];
+
+    return (datagram.external_data != nullptr) 
+        ? datagram.external_data 
+        : m_payload_buffer.data() + datagram.buffer_offset;
+}
+
+void ServerUdpBatchSender::send_individually(size_t first_datagram_index)
+{
+    for (size_t datagram_index = first_datagram_index; datagram_index < m_datagrams.size(); ++datagram_index)
+    {
+        Datagram &datagram = m_datagrams[datagram_index];
+
+        // Blocks if the socket send buffer is full
+        m_socket.send_to(
+            boost::asio::buffer(get_datagram_data(datagram_index), datagram.size),
+            datagram.endpoint,
+            0,
+            datagram.send_error);
+    }
+}
+
+#ifdef __linux__
+void ServerUdpBatchSender::send_mmsg()
+{
+    const size_t datagram_count = m_datagrams.size();
+
+    // The payload buffer is done growing, so the datagram addresses are stable now
+    m_message_headers.resize(datagram_count);
+    m_message_iovecs.resize(datagram_count);
+    for (size_t datagram_index = 0; datagram_index < datagram_count; ++datagram_index)
+    {
+        Datagram &datagram = m_datagrams[datagram_index];
+        struct iovec &iov = m_message_iovecs[datagram_index];
+        struct mmsghdr &header = m_message_headers[datagram_index];
+
+        iov.iov_base = const_cast<uint8_t *>(get_datagram_data(datagram_index));
+        iov.iov_len = datagram.size;
+
+        memset(&header, 0, sizeof(header));
+        header.msg_hdr.msg_name = datagram.endpoint.data();
+        header.msg_hdr.msg_namelen = static_cast<socklen_t>(datagram.endpoint.size());
+        header.msg_hdr.msg_iov = &iov;
+        header.msg_hdr.msg_iovlen = 1;
+
+        datagram.send_error = boost::system::error_code();
+    }
+
+    const int socket_handle = m_socket.native_handle();
+    size_t next_datagram_index = 0;
+
+    while (next_datagram_index < datagram_count)
+    {
+        // Sends as many datagrams as it can (at most UIO_MAXIOV per call).
+        // An error is only returned when the very first datagram of the call fails.
+        const int result = sendmmsg(
+            socket_handle,
+            &m_message_headers[next_datagram_index],
+            static_cast<unsigned int>(datagram_count - next_datagram_index),
+            0);
+
+        if (result > 0)
+        {
+            next_datagram_index += static_cast<size_t>(result);
+        }
+        else if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (result == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            // asio keeps the socket in non-blocking mode for its async operations.
+            // Let the synchronous send_to() wait for room in the send buffer for the rest.
+            send_individually(next_datagram_index);
+            break;
+        }
+        else
+        {
+            // Only this datagram failed (i.e. unreachable endpoint), carry on with the rest
+            m_datagrams[next_datagram_index].send_error =
+                boost::system::error_code(errno, boost::system::system_category());
+            ++next_datagram_index;
+        }
+    }
+}
+#endif
@@ -0,0 +1,78 @@
+#ifndef SERVER_UDP_BATCH_SENDER_H
+#define SERVER_UDP_BATCH_SENDER_H
+
+//-- includes -----
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <boost/asio/ip/udp.hpp>
+#include <boost/system/error_code.hpp>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+//-- definitions -----
+// -Server UDP Batch Sender-
+/// Collects the datagrams bound for any number of UDP endpoints over the course of an update
+/// and then sends all of them in a single pass on one socket.
+/// On Linux the whole batch goes to the kernel with sendmmsg(),
+/// everywhere else each datagram gets a synchronous send_to().
+/// Every datagram goes out at exactly the size it was added with.
+class ServerUdpBatchSender
+{
+public:
+    ServerUdpBatchSender(boost::asio::ip::udp::socket &socket);
+
+    /// Appends a datagram of datagram_size bytes for the given endpoint to the batch.
+    /// Returns the buffer to write the datagram into, valid until the next addDatagram() call.
+    uint8_t *addDatagram(const boost::asio::ip::udp::endpoint &endpoint, size_t datagram_size);
+
+    /// Appends a datagram sent straight out of the given buffer, without copying it.
+    /// The buffer has to stay valid until the batch is cleared.
+    void addDatagramReference(const boost::asio::ip::udp::endpoint &endpoint, const uint8_t *data, size_t datagram_size);
+
+    inline int getDatagramCount() const
+    { return static_cast<int>(m_datagrams.size()); }
+
+    /// Sends every datagram in the batch. Returns how many of them were sent successfully.
+    /// The error of each datagram can be looked up with getSendError() until the batch is cleared.
+    int sendAll();
+
+    const boost::system::error_code &getSendError(int datagram_index) const;
+
+    /// Empties the batch. The storage is kept around for the next batch.
+    void clear();
+
+protected:
+    const uint8_t *get_datagram_data(size_t datagram_index) const;
+    void send_individually(size_t first_datagram_index);
+#ifdef __linux__
+    void send_mmsg();
+#endif
+
+private:
+    struct Datagram
+    {
+        boost::asio::ip::udp::endpoint endpoint;
+        const uint8_t *external_data; // nullptr when the datagram lives in m_payload_buffer
+        size_t buffer_offset;
+        size_t size;
+        boost::system::error_code send_error;
+    };
+
+    boost::asio::ip::udp::socket &m_socket;
+
+    // The payloads of all of the copied datagrams, back to back
+    std::vector<uint8_t> m_payload_buffer;
+    std::vector<Datagram> m_datagrams;
+
+#ifdef __linux__
+    std::vector<struct mmsghdr> m_message_headers;
+    std::vector<struct iovec> m_message_iovecs;
+#endif
+};
+
+#endif  // SERVER_UDP_BATCH_SENDER_H
@@ -21,6 +21,11 @@
 #else
 	#include <sys/time.h>
 	#include <time.h>
+	#include <thread>
+	#if defined __linux__
+		#include <pthread.h>
+		#include <sched.h>
+	#endif
 	#if defined __MACH__ && defined __APPLE__
 		#include <mach/mach.h>
 		#include <mach/mach_time.h>
@@ -234,11 +239,52 @@ namespace ServerUtility
         {
         }
     }
+
+    bool set_current_thread_affinity(int cpu_index)
+    {
+        DWORD_PTR process_mask, system_mask;
+        bool bSuccess= false;
+
+        if (cpu_index >= 0 && GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+        {
+            const int core_count= static_cast<int>(sizeof(DWORD_PTR) * 8);
+            const DWORD_PTR thread_mask= static_cast<DWORD_PTR>(1) << (cpu_index % core_count);
+
+            if ((thread_mask & process_mask) != 0)
+            {
+                bSuccess= SetThreadAffinityMask(GetCurrentThread(), thread_mask) != 0;
+            }
+        }
+
+        return bSuccess;
+    }
 #else
     void set_current_thread_name(const char* threadName)
     {
         // Not sure how to implement this on linux/osx, so left empty...
     }
+
+    bool set_current_thread_affinity(int cpu_index)
+    {
+    #if defined __linux__
+        const int core_count= static_cast<int>(std::thread::hardware_concurrency());
+        bool bSuccess= false;
+
+        if (cpu_index >= 0 && core_count > 0)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cpu_index % core_count, &cpu_set);
+
+            bSuccess= pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+        }
+
+        return bSuccess;
+    #else
+        // OSX only supports affinity "tags" as scheduler hints, so don't pretend we pinned the thread
+        return false;
+    #endif
+    }
 #endif
 
     void sleep_ms(int milliseconds)
@@ -252,4 +298,19 @@ namespace ServerUtility
         nanosleep(&req, (struct timespec *)NULL);
 #endif
     }	
+
+    double get_monotonic_time_seconds()
+    {
+        const std::chrono::duration<double> time_since_epoch= std::chrono::steady_clock::now().time_since_epoch();
+
+        return time_since_epoch.count();
+    }
+
+    double to_monotonic_time_seconds(const std::chrono::time_point<std::chrono::high_resolution_clock> &timestamp)
+    {
+        // The high resolution clock isn't guaranteed to be steady, so go through its distance to now
+        const std::chrono::duration<double> age= std::chrono::high_resolution_clock::now() - timestamp;
+
+        return get_monotonic_time_seconds() - age.count();
+    }
 };
\ No newline at end of file
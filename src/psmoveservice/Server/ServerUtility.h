@@ -2,6 +2,7 @@
 #define SERVER_UTILITY_H
 
 #include "stdlib.h" // size_t
+#include <chrono>
 #include <string>
 
 //-- macros -----
@@ -54,8 +55,22 @@ namespace ServerUtility
     /// Sets the name of the current thread
     void set_current_thread_name(const char* thread_name);
 
+    /// Pins the current thread to the given cpu core index
+    /// \param cpu_index The zero-based index of the core to run on (wrapped to the core count)
+    /// \return false if thread affinity isn't supported on this platform or the request failed
+    bool set_current_thread_affinity(int cpu_index);
+
     /// Sleeps the current thread for the given number of milliseconds
     void sleep_ms(int milliseconds);	
+
+    /// Returns the service monotonic clock in seconds.
+    /// This is the clock data frame timestamps are given in and that GET_SERVICE_TIME reports.
+    double get_monotonic_time_seconds();
+
+    /// Converts a high resolution clock time stamp (e.g. an input report arrival time) to the service monotonic clock
+    /// \param timestamp A time stamp taken from std::chrono::high_resolution_clock
+    /// \return The same point in time in service monotonic clock seconds
+    double to_monotonic_time_seconds(const std::chrono::time_point<std::chrono::high_resolution_clock> &timestamp);
 };
 
 #endif // SERVER_REQUEST_HANDLER_H
\ No newline at end of file
@@ -14,9 +14,6 @@
 #endif
 #include <math.h>
 
-// -- constants -----
-#define VIRTUAL_HMD_STATE_BUFFER_MAX 4
-
 // -- private methods
 
 // -- public interface
@@ -217,12 +214,7 @@ VirtualHMD::poll()
         newState.PollSequenceNumber = NextPollSequenceNumber;
         ++NextPollSequenceNumber;
 
-        // Make room for new entry if at the max queue size
-        if (HMDStates.size() >= VIRTUAL_HMD_STATE_BUFFER_MAX)
-        {
-            HMDStates.erase(HMDStates.begin(), HMDStates.begin() + HMDStates.size() - VIRTUAL_HMD_STATE_BUFFER_MAX);
-        }
-
+        // Pushing into a full history drops the oldest state
         HMDStates.push_back(newState);
     }
 
@@ -269,9 +261,7 @@ const CommonDeviceState *
 VirtualHMD::getState(
     int lookBack) const
 {
-    const int queueSize = static_cast<int>(HMDStates.size());
-    const CommonDeviceState * result =
-        (lookBack < queueSize) ? &HMDStates.at(queueSize - lookBack - 1) : nullptr;
+    const CommonDeviceState * result= HMDStates.getLookBack(lookBack);
 
     return result;
 }
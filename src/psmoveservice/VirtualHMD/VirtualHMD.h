@@ -4,12 +4,14 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
 #include "MathUtility.h"
 #include <string>
 #include <vector>
-#include <deque>
 #include <array>
 
+// Number of most recent states kept around for getState()
+#define VIRTUAL_HMD_STATE_BUFFER_MAX 4
 
 class VirtualHMDConfig : public PSMoveConfig
 {
@@ -129,7 +131,7 @@ private:
 
     // Read HMD State
     int NextPollSequenceNumber;
-    std::deque<VirtualHMDState> HMDStates;
+    DeviceStateRingBuffer<VirtualHMDState, VIRTUAL_HMD_STATE_BUFFER_MAX> HMDStates;
 
 	bool bIsTracking;
 };
@@ -0,0 +1,112 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "ClientClockOffsetEstimator.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const double k_offset_tolerance = 1e-9;
+
+//-- public interface -----
+bool run_clock_offset_estimator_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("clock_offset_estimator")
+		UNIT_TEST_MODULE_CALL_TEST(clock_offset_estimator_test_shortest_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(clock_offset_estimator_test_rejected_sample);
+		UNIT_TEST_MODULE_CALL_TEST(clock_offset_estimator_test_window_wrap);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static bool is_nearly_equal(double a, double b)
+{
+	return fabs(a - b) <= k_offset_tolerance;
+}
+
+bool
+clock_offset_estimator_test_shortest_round_trip()
+{
+	UNIT_TEST_BEGIN("shortest round trip")
+
+	ClientClockOffsetEstimator estimator;
+
+	// No estimate until the first round trip
+	success = !estimator.get_has_estimate() && estimator.get_service_to_client_offset() == 0.0;
+	assert(success);
+
+	if (success)
+	{
+		// Service clock runs 100s behind the client clock.
+		// The slow round trip spent its extra time on the way back, which skews its offset.
+		estimator.add_sample(1000.000, 900.002, 1000.010);
+		estimator.add_sample(1001.000, 901.001, 1001.002);
+		estimator.add_sample(1002.000, 902.001, 1002.030);
+
+		success =
+			estimator.get_sample_count() == 3 &&
+			is_nearly_equal(estimator.get_service_to_client_offset(), 100.0) &&
+			is_nearly_equal(estimator.get_round_trip_seconds(), 0.002);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+clock_offset_estimator_test_rejected_sample()
+{
+	UNIT_TEST_BEGIN("rejected sample")
+
+	ClientClockOffsetEstimator estimator;
+
+	// A response can't arrive before its request was sent
+	success = !estimator.add_sample(10.0, 5.0, 9.0) && !estimator.get_has_estimate();
+	assert(success);
+
+	if (success)
+	{
+		success = estimator.add_sample(10.0, 5.0, 10.0) && is_nearly_equal(estimator.get_service_to_client_offset(), 5.0);
+		assert(success);
+	}
+
+	if (success)
+	{
+		estimator.reset();
+		success = !estimator.get_has_estimate() && estimator.get_round_trip_seconds() == 0.0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+clock_offset_estimator_test_window_wrap()
+{
+	UNIT_TEST_BEGIN("window wrap")
+
+	ClientClockOffsetEstimator estimator;
+
+	// A very short round trip with an old offset...
+	estimator.add_sample(0.0, -50.0, 0.0);
+
+	// ...is forgotten once a full window of newer (slower) round trips went by
+	for (int sample_index = 0; sample_index < ClientClockOffsetEstimator::k_sample_window_size; ++sample_index)
+	{
+		const double send_time = 1.0 + static_cast<double>(sample_index);
+
+		success &= is_nearly_equal(estimator.get_service_to_client_offset(), 50.0);
+		estimator.add_sample(send_time, send_time - 20.0 + 0.005, send_time + 0.010);
+	}
+
+	success =
+		success &&
+		estimator.get_sample_count() == ClientClockOffsetEstimator::k_sample_window_size &&
+		is_nearly_equal(estimator.get_service_to_client_offset(), 20.0) &&
+		is_nearly_equal(estimator.get_round_trip_seconds(), 0.010);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,214 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "DeviceClockModel.h"
+#include "unit_test.h"
+
+//-- definitions -----
+/// A device streaming IMU samples at a fixed rate on its own clock,
+/// whose input reports reach the host after a varying transport delay
+struct SimulatedDevice
+{
+    double tick_seconds;
+    double sample_period_seconds;
+    double host_start_seconds;
+    int sample_index;
+    unsigned int random_state;
+
+    SimulatedDevice(double device_tick_seconds, double device_sample_period_seconds)
+        : tick_seconds(device_tick_seconds)
+        , sample_period_seconds(device_sample_period_seconds)
+        , host_start_seconds(1000.0)
+        , sample_index(0)
+        , random_state(12345)
+    {}
+
+    double getSampleTimeSeconds() const
+    {
+        return host_start_seconds + static_cast<double>(sample_index) * sample_period_seconds;
+    }
+
+    unsigned int getRawTimestamp() const
+    {
+        const double ticks = static_cast<double>(sample_index) * sample_period_seconds / tick_seconds;
+
+        return static_cast<unsigned int>(static_cast<long long>(ticks) & 0xFFFF);
+    }
+
+    // 1ms of latency plus up to 3ms of jitter
+    double getArrivalTimeSeconds()
+    {
+        random_state = random_state * 1103515245u + 12345u;
+
+        return getSampleTimeSeconds() + 0.001 + 0.003 * static_cast<double>((random_state >> 16) & 0x7FFF) / 32768.0;
+    }
+
+    void streamSamples(DeviceClockModel &model, int sample_count)
+    {
+        for (int i = 0; i < sample_count; ++i)
+        {
+            model.addSample(getRawTimestamp(), getArrivalTimeSeconds());
+            ++sample_index;
+        }
+    }
+};
+
+//-- constants -----
+static const double k_ds4_tick_seconds = 16.0 / 3.0 / 1000000.0;
+static const double k_sample_period_seconds = 0.004;
+
+//-- public interface -----
+bool run_device_clock_model_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("device_clock_model")
+		UNIT_TEST_MODULE_CALL_TEST(device_clock_model_test_calibration);
+		UNIT_TEST_MODULE_CALL_TEST(device_clock_model_test_wrap_around_gap);
+		UNIT_TEST_MODULE_CALL_TEST(device_clock_model_test_clock_drift);
+		UNIT_TEST_MODULE_CALL_TEST(device_clock_model_test_unusable_timestamp);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static bool is_nearly_equal(double a, double b, double tolerance)
+{
+	return fabs(a - b) <= tolerance;
+}
+
+bool
+device_clock_model_test_calibration()
+{
+	UNIT_TEST_BEGIN("calibration")
+
+	SimulatedDevice device(k_ds4_tick_seconds, k_sample_period_seconds);
+	DeviceClockModel model;
+
+	model.init(16);
+
+	// Nothing to go on until the tick has been measured for a while
+	device.streamSamples(model, 250);
+	success = !model.getIsValid() && model.getTickSeconds() == 0.0;
+	assert(success);
+
+	if (success)
+	{
+		device.streamSamples(model, 300);
+
+		// A few ms of jitter over the calibration leaves the tick within a fraction of a percent
+		success =
+			model.getIsValid() &&
+			is_nearly_equal(model.getTickSeconds(), k_ds4_tick_seconds, k_ds4_tick_seconds * 0.005) &&
+			is_nearly_equal(model.getSampleTimeDeltaSeconds(), k_sample_period_seconds, k_sample_period_seconds * 0.01);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+device_clock_model_test_wrap_around_gap()
+{
+	UNIT_TEST_BEGIN("wrap around gap")
+
+	SimulatedDevice device(k_ds4_tick_seconds, k_sample_period_seconds);
+	DeviceClockModel model;
+
+	model.init(16);
+	device.streamSamples(model, 1000);
+
+	// Drop enough samples for the timestamp to wrap around (about every 0.35s) but not enough to start over
+	device.sample_index += 150;
+	device.streamSamples(model, 1);
+
+	success =
+		model.getIsValid() &&
+		is_nearly_equal(model.getSampleTimeDeltaSeconds(), 151.0 * k_sample_period_seconds, 0.01);
+	assert(success);
+
+	// Stopping for longer starts over, keeping the tick that was measured
+	if (success)
+	{
+		device.sample_index += 500;
+
+		const double arrival_time = device.getArrivalTimeSeconds();
+		model.addSample(device.getRawTimestamp(), arrival_time);
+		++device.sample_index;
+
+		success = !model.getIsValid() && model.getSampleTimeSeconds() == arrival_time && model.getTickSeconds() > 0.0;
+		assert(success);
+	}
+
+	if (success)
+	{
+		device.streamSamples(model, 1);
+
+		success = model.getIsValid();
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+device_clock_model_test_clock_drift()
+{
+	UNIT_TEST_BEGIN("clock drift")
+
+	// Device clock 500ppm slow, with a calibration that starts off skewed by the jitter
+	const double device_tick_seconds = k_ds4_tick_seconds * 1.0005;
+	SimulatedDevice device(device_tick_seconds, k_sample_period_seconds);
+	DeviceClockModel model;
+	double max_interval_error = 0.0;
+
+	model.init(16);
+	device.streamSamples(model, 500);
+
+	for (int i = 0; i < 30000; ++i)
+	{
+		device.streamSamples(model, 1);
+
+		if (model.getIsValid())
+		{
+			max_interval_error =
+				fmax(max_interval_error, fabs(model.getSampleTimeDeltaSeconds() - k_sample_period_seconds));
+		}
+	}
+
+	// Sample intervals stay within a percent of the device's even while the clock estimate settles,
+	// and the sample times end up at the least delayed arrival rather than following the jitter
+	success =
+		model.getIsValid() &&
+		max_interval_error < k_sample_period_seconds * 0.01 &&
+		is_nearly_equal(model.getTickSeconds(), device_tick_seconds, device_tick_seconds * 0.0001);
+	assert(success);
+
+	if (success)
+	{
+		const double last_sample_time = device.host_start_seconds + static_cast<double>(device.sample_index - 1) * k_sample_period_seconds;
+
+		success = is_nearly_equal(model.getSampleTimeSeconds(), last_sample_time + 0.001, 0.0005);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+device_clock_model_test_unusable_timestamp()
+{
+	UNIT_TEST_BEGIN("unusable timestamp")
+
+	// Wraps around every 33ms, too fast to trust after a few dropped input reports
+	SimulatedDevice device(0.0000005, k_sample_period_seconds);
+	DeviceClockModel model;
+
+	model.init(16);
+	device.streamSamples(model, 1000);
+
+	success = !model.getIsValid() && model.getTickSeconds() == 0.0;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,230 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#include "DeviceInputRecording.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const char *k_test_recording_path = "device_input_recording_unit_test.bin";
+
+//-- public interface -----
+bool run_device_input_recording_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("device_input_recording")
+		UNIT_TEST_MODULE_CALL_TEST(device_input_recording_test_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(device_input_recording_test_monotonic_timestamps);
+		UNIT_TEST_MODULE_CALL_TEST(device_input_recording_test_truncated_chunk);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+// Every report gets filled from its index, so a mixed up or corrupted report shows up as a mismatch
+static void fill_report(int report_index, unsigned char *report, size_t report_size)
+{
+	for (size_t byte_index = 0; byte_index < report_size; ++byte_index)
+	{
+		report[byte_index] = static_cast<unsigned char>(report_index + byte_index);
+	}
+}
+
+static bool is_report_consistent(int report_index, const unsigned char *report, size_t report_size)
+{
+	unsigned char expected[64];
+
+	assert(report_size <= sizeof(expected));
+	fill_report(report_index, expected, report_size);
+
+	return memcmp(expected, report, report_size) == 0;
+}
+
+bool
+device_input_recording_test_round_trip()
+{
+	UNIT_TEST_BEGIN("round trip")
+
+	const int k_report_count = 1000;
+	const size_t k_report_size = 49; // A PSMove input report, not a multiple of the record alignment
+
+	// Write two interleaved streams over many small chunks
+	{
+		DeviceInputRecordingWriter writer;
+		unsigned char report[64];
+
+		success = writer.open(k_test_recording_path, 1024);
+
+		for (int report_index = 0; success && report_index < k_report_count; ++report_index)
+		{
+			fill_report(report_index, report, k_report_size);
+			success =
+				writer.writeRecord(
+					report_index % 2, _deviceInputRecordType_HidReport,
+					static_cast<uint64_t>(report_index) * 1000, report, k_report_size);
+		}
+
+		writer.close();
+	}
+
+	// Read them back in the same order
+	if (success)
+	{
+		DeviceInputRecordingReader reader;
+		DeviceInputRecordingReader::Record record;
+		int report_index = 0;
+
+		success = reader.open(k_test_recording_path);
+
+		while (success && reader.readNextRecord(record))
+		{
+			success =
+				record.stream_id == report_index % 2 &&
+				record.record_type == _deviceInputRecordType_HidReport &&
+				record.timestamp_ns == static_cast<uint64_t>(report_index) * 1000 &&
+				record.payload_size == k_report_size &&
+				is_report_consistent(report_index, record.payload, k_report_size);
+			++report_index;
+		}
+
+		success &= report_index == k_report_count;
+
+		// Rewinding starts over at the first record
+		uint64_t first_timestamp_ns = 1;
+		reader.rewind();
+		success &= reader.peekNextTimestamp(first_timestamp_ns) && first_timestamp_ns == 0;
+	}
+
+	remove(k_test_recording_path);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+device_input_recording_test_monotonic_timestamps()
+{
+	UNIT_TEST_BEGIN("monotonic timestamps")
+
+	const uint64_t k_stream_0_timestamps[] = {100, 50, 200};
+	const uint64_t k_stream_1_timestamps[] = {10, 20, 5};
+	const uint64_t k_expected_stream_0_timestamps[] = {100, 100, 200};
+	const uint64_t k_expected_stream_1_timestamps[] = {10, 20, 20};
+	unsigned char report[8] = {0};
+
+	{
+		DeviceInputRecordingWriter writer;
+
+		success = writer.open(k_test_recording_path);
+
+		for (int record_index = 0; success && record_index < 3; ++record_index)
+		{
+			success =
+				writer.writeRecord(0, _deviceInputRecordType_HidReport, k_stream_0_timestamps[record_index], report, sizeof(report)) &&
+				writer.writeRecord(1, _deviceInputRecordType_HidReport, k_stream_1_timestamps[record_index], report, sizeof(report));
+		}
+
+		writer.close();
+	}
+
+	// A timestamp going backwards gets clamped, but only within its own stream
+	if (success)
+	{
+		DeviceInputRecordingReader reader;
+		DeviceInputRecordingReader::Record record;
+
+		success = reader.open(k_test_recording_path);
+
+		for (int record_index = 0; success && record_index < 3; ++record_index)
+		{
+			success =
+				reader.readNextRecord(record) && record.stream_id == 0 &&
+				record.timestamp_ns == k_expected_stream_0_timestamps[record_index] &&
+				reader.readNextRecord(record) && record.stream_id == 1 &&
+				record.timestamp_ns == k_expected_stream_1_timestamps[record_index];
+		}
+
+		success &= !reader.readNextRecord(record);
+	}
+
+	remove(k_test_recording_path);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+device_input_recording_test_truncated_chunk()
+{
+	UNIT_TEST_BEGIN("truncated chunk")
+
+	const size_t k_report_size = 32;
+	const size_t k_chunk_size = 4 * (sizeof(DeviceInputRecordHeader) + k_report_size);
+	unsigned char report[64];
+
+	// Two full chunks of four records each
+	{
+		DeviceInputRecordingWriter writer;
+
+		success = writer.open(k_test_recording_path, k_chunk_size);
+
+		for (int report_index = 0; success && report_index < 8; ++report_index)
+		{
+			fill_report(report_index, report, k_report_size);
+			success = writer.writeRecord(0, _deviceInputRecordType_HidReport, report_index, report, k_report_size);
+		}
+
+		writer.close();
+	}
+
+	// Cut off the end of the last chunk, like a service that died while writing it
+	if (success)
+	{
+		std::vector<unsigned char> file_data;
+		FILE *file = fopen(k_test_recording_path, "rb");
+
+		success = file != nullptr;
+		if (success)
+		{
+			unsigned char buffer[256];
+			size_t read_size;
+
+			while ((read_size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			{
+				file_data.insert(file_data.end(), buffer, buffer + read_size);
+			}
+			fclose(file);
+
+			file = fopen(k_test_recording_path, "wb");
+			success = file != nullptr && fwrite(file_data.data(), file_data.size() - 10, 1, file) == 1;
+			if (file != nullptr)
+			{
+				fclose(file);
+			}
+		}
+	}
+
+	// Only the records of the intact chunk come back
+	if (success)
+	{
+		DeviceInputRecordingReader reader;
+		DeviceInputRecordingReader::Record record;
+		int report_index = 0;
+
+		success = reader.open(k_test_recording_path);
+
+		while (success && reader.readNextRecord(record))
+		{
+			success = is_report_consistent(report_index, record.payload, record.payload_size);
+			++report_index;
+		}
+
+		success &= report_index == 4;
+	}
+
+	remove(k_test_recording_path);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
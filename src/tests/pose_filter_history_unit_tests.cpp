@@ -0,0 +1,236 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "PoseFilterHistory.h"
+#include "unit_test.h"
+
+//-- definitions -----
+/// Integrates the accelerometer into a position and pulls it half way toward the optical position when tracked.
+/// Simple enough that replaying the same samples gives bit identical results.
+class TestPoseFilter : public IPoseFilter
+{
+public:
+    TestPoseFilter()
+        : m_position(Eigen::Vector3f::Zero())
+        , m_velocity(Eigen::Vector3f::Zero())
+        , m_state_time_seconds(0.0)
+        , m_bIsValid(false)
+    {}
+
+    // -- IStateFilter --
+    bool getIsStateValid() const override { return m_bIsValid; }
+    void update(const float delta_time, const PoseFilterPacket &packet) override
+    {
+        m_velocity += packet.imu_accelerometer_g_units * delta_time;
+        m_position += m_velocity * delta_time;
+
+        if (packet.tracking_projection_area_px_sqr > 0.f)
+        {
+            m_position = (m_position + packet.optical_position_cm) * 0.5f;
+        }
+
+        m_bIsValid = true;
+    }
+    void resetState() override
+    {
+        m_position = Eigen::Vector3f::Zero();
+        m_velocity = Eigen::Vector3f::Zero();
+        m_state_time_seconds = 0.0;
+        m_bIsValid = false;
+    }
+    void recenterOrientation(const Eigen::Quaternionf&) override {}
+
+    // -- IPoseFilter --
+    bool getIsPositionStateValid() const override { return m_bIsValid; }
+    bool getIsOrientationStateValid() const override { return m_bIsValid; }
+    Eigen::Quaternionf getOrientation(float = 0.f) const override { return Eigen::Quaternionf::Identity(); }
+    Eigen::Vector3f getAngularVelocityRadPerSec() const override { return Eigen::Vector3f::Zero(); }
+    Eigen::Vector3f getAngularAccelerationRadPerSecSqr() const override { return Eigen::Vector3f::Zero(); }
+    Eigen::Vector3f getPositionCm(float time = 0.f) const override { return m_position + m_velocity * time; }
+    Eigen::Vector3f getVelocityCmPerSec() const override { return m_velocity; }
+    Eigen::Vector3f getAccelerationCmPerSecSqr() const override { return Eigen::Vector3f::Zero(); }
+    void updateAtTime(const double sample_time_seconds, const PoseFilterPacket &packet) override
+    {
+        update(compute_pose_filter_time_delta(m_state_time_seconds, sample_time_seconds, 0.01f), packet);
+        m_state_time_seconds = sample_time_seconds;
+    }
+    double getStateTimeSeconds() const override { return m_state_time_seconds; }
+    IPoseFilter *clone() const override { return new TestPoseFilter(*this); }
+    void copyState(const IPoseFilter *other) override { *this = *static_cast<const TestPoseFilter *>(other); }
+
+private:
+    Eigen::Vector3f m_position;
+    Eigen::Vector3f m_velocity;
+    double m_state_time_seconds;
+    bool m_bIsValid;
+};
+
+//-- constants -----
+static const double k_sample_period_seconds = 0.004;
+static const double k_first_sample_time_seconds = 100.0;
+
+//-- public interface -----
+bool run_pose_filter_history_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("pose_filter_history")
+		UNIT_TEST_MODULE_CALL_TEST(pose_filter_history_test_late_optical_measurement);
+		UNIT_TEST_MODULE_CALL_TEST(pose_filter_history_test_stale_optical_measurement);
+		UNIT_TEST_MODULE_CALL_TEST(pose_filter_history_test_history_wrap_around);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static PoseSensorPacket make_imu_packet(int sample_index)
+{
+    PoseSensorPacket packet;
+
+    packet.optical_position_cm = Eigen::Vector3f::Zero();
+    packet.optical_orientation = Eigen::Quaternionf::Identity();
+    packet.tracking_projection_area_px_sqr = 0.f;
+    packet.imu_accelerometer_g_units = Eigen::Vector3f(static_cast<float>(sample_index % 7) - 3.f, 1.f, 0.5f);
+    packet.imu_magnetometer_unit = Eigen::Vector3f::Zero();
+    packet.imu_gyroscope_rad_per_sec = Eigen::Vector3f::Zero();
+
+    return packet;
+}
+
+static PoseSensorPacket make_optical_packet(float x)
+{
+    PoseSensorPacket packet = make_imu_packet(0);
+
+    packet.optical_position_cm = Eigen::Vector3f(x, 2.f * x, -x);
+    packet.tracking_projection_area_px_sqr = 100.f;
+
+    return packet;
+}
+
+static double get_sample_time(int sample_index)
+{
+    return k_first_sample_time_seconds + static_cast<double>(sample_index) * k_sample_period_seconds;
+}
+
+bool
+pose_filter_history_test_late_optical_measurement()
+{
+	UNIT_TEST_BEGIN("late optical measurement")
+
+	const int k_sample_count = 20;
+	const PoseSensorPacket optical_a = make_optical_packet(10.f);
+	const PoseSensorPacket optical_b = make_optical_packet(-4.f);
+	const double capture_time_a = get_sample_time(3) + 0.001;
+	const double capture_time_b = get_sample_time(11) + 0.001;
+	PoseFilterSpace filter_space;
+
+	// Reference: every optical measurement applied to the samples after its capture, in time order
+	TestPoseFilter reference_filter;
+	for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+	{
+		const double sample_time = get_sample_time(sample_index);
+		PoseSensorPacket sensor_packet = make_imu_packet(sample_index);
+		PoseFilterPacket filter_packet;
+
+		if (sample_time > capture_time_b)
+		{
+			sensor_packet.optical_position_cm = optical_b.optical_position_cm;
+			sensor_packet.tracking_projection_area_px_sqr = optical_b.tracking_projection_area_px_sqr;
+		}
+		else if (sample_time > capture_time_a)
+		{
+			sensor_packet.optical_position_cm = optical_a.optical_position_cm;
+			sensor_packet.tracking_projection_area_px_sqr = optical_a.tracking_projection_area_px_sqr;
+		}
+
+		filter_space.createFilterPacket(sensor_packet, &reference_filter, filter_packet);
+		reference_filter.updateAtTime(sample_time, filter_packet);
+	}
+
+	// Same samples, but each optical measurement only shows up several samples after it was captured
+	TestPoseFilter filter;
+	PoseFilterHistory history;
+
+	success = history.init(&filter, 32);
+	for (int sample_index = 0; success && sample_index < k_sample_count; ++sample_index)
+	{
+		history.applySample(get_sample_time(sample_index), make_imu_packet(sample_index), &filter_space, &filter);
+
+		if (sample_index == 8)
+		{
+			success &= history.applyOpticalMeasurement(capture_time_a, optical_a, &filter_space, &filter) == 5;
+		}
+		else if (sample_index == 15)
+		{
+			success &= history.applyOpticalMeasurement(capture_time_b, optical_b, &filter_space, &filter) == 4;
+		}
+	}
+
+	success &=
+		filter.getPositionCm() == reference_filter.getPositionCm() &&
+		filter.getVelocityCmPerSec() == reference_filter.getVelocityCmPerSec() &&
+		filter.getStateTimeSeconds() == reference_filter.getStateTimeSeconds();
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_filter_history_test_stale_optical_measurement()
+{
+	UNIT_TEST_BEGIN("stale optical measurement")
+
+	PoseFilterSpace filter_space;
+	TestPoseFilter filter;
+	PoseFilterHistory history;
+
+	success = history.init(&filter, 32);
+	for (int sample_index = 0; success && sample_index < 10; ++sample_index)
+	{
+		history.applySample(get_sample_time(sample_index), make_imu_packet(sample_index), &filter_space, &filter);
+	}
+
+	// Something captured before the current measurement doesn't change anything
+	success &= history.applyOpticalMeasurement(get_sample_time(6), make_optical_packet(1.f), &filter_space, &filter) == 3;
+
+	const Eigen::Vector3f position = filter.getPositionCm();
+	success &= history.applyOpticalMeasurement(get_sample_time(4), make_optical_packet(2.f), &filter_space, &filter) == 0;
+	success &= filter.getPositionCm() == position && history.getOpticalCaptureTimeSeconds() == get_sample_time(6);
+
+	// Nor does the same measurement again (i.e. still untracked)
+	success &= history.applyOpticalMeasurement(get_sample_time(7), make_optical_packet(1.f), &filter_space, &filter) == 0;
+	success &= filter.getPositionCm() == position && history.getOpticalCaptureTimeSeconds() == get_sample_time(7);
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+pose_filter_history_test_history_wrap_around()
+{
+	UNIT_TEST_BEGIN("history wrap around")
+
+	const int k_max_sample_count = 4;
+	PoseFilterSpace filter_space;
+	TestPoseFilter filter;
+	PoseFilterHistory history;
+
+	success = history.init(&filter, k_max_sample_count);
+	for (int sample_index = 0; success && sample_index < 10; ++sample_index)
+	{
+		history.applySample(get_sample_time(sample_index), make_imu_packet(sample_index), &filter_space, &filter);
+	}
+	success &= history.getSampleCount() == k_max_sample_count;
+
+	// Older than anything left in the history, so it gets applied from the oldest sample on
+	success &=
+		history.applyOpticalMeasurement(get_sample_time(1), make_optical_packet(3.f), &filter_space, &filter) ==
+		k_max_sample_count;
+	success &= filter.getStateTimeSeconds() == get_sample_time(9);
+
+	// Cleared histories start over
+	history.clear();
+	success &= history.getSampleCount() == 0 && !history.getHasOpticalMeasurement();
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
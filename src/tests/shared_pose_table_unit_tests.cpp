@@ -0,0 +1,144 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "SharedPoseState.h"
+#include "unit_test.h"
+
+//-- private types -----
+// A pose table in (cache line aligned) process memory
+class SharedPoseTableBuffer
+{
+public:
+	SharedPoseTableBuffer()
+		: m_memory(SharedPoseTableHeader::computeTotalSize() + 64)
+	{
+		void *aligned_memory = reinterpret_cast<void *>((reinterpret_cast<size_t>(m_memory.data()) + 63) & ~static_cast<size_t>(63));
+
+		m_header = new (aligned_memory) SharedPoseTableHeader();
+		m_header->initializeSlots();
+	}
+
+	SharedPoseTableHeader *get() { return m_header; }
+
+private:
+	std::vector<unsigned char> m_memory;
+	SharedPoseTableHeader *m_header;
+};
+
+//-- public interface -----
+bool run_shared_pose_table_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("shared_pose_table")
+		UNIT_TEST_MODULE_CALL_TEST(shared_pose_table_test_read_write);
+		UNIT_TEST_MODULE_CALL_TEST(shared_pose_table_test_concurrent_writer);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+// Every field of the pose gets derived from the sequence number, so a torn read shows up as a mismatch
+static void fill_pose_data(int sequence_num, SharedPoseData &pose_data)
+{
+	const float value = static_cast<float>(sequence_num);
+
+	memset(&pose_data, 0, sizeof(SharedPoseData));
+	pose_data.device_type = 0;
+	pose_data.sequence_num = sequence_num;
+	pose_data.status_flags = SHARED_POSE_STATUS_CONNECTED | SHARED_POSE_STATUS_ORIENTATION_VALID;
+	pose_data.pose.position_cm = {value, value, value};
+	pose_data.pose.orientation = {value, value, value, value};
+	pose_data.physics_data.velocity_cm_per_sec = {value, value, value};
+	pose_data.physics_data.angular_acceleration_rad_per_sec_sqr = {value, value, value};
+}
+
+static bool is_pose_data_consistent(const SharedPoseData &pose_data)
+{
+	SharedPoseData expected;
+
+	fill_pose_data(pose_data.sequence_num, expected);
+
+	return memcmp(&expected, &pose_data, sizeof(SharedPoseData)) == 0;
+}
+
+bool
+shared_pose_table_test_read_write()
+{
+	UNIT_TEST_BEGIN("read write")
+
+	SharedPoseTableBuffer shared_buffer;
+	SharedPoseTableHeader *header = shared_buffer.get();
+	SharedPoseData pose_data;
+
+	// Slots start out without a device
+	success =
+		SharedPoseTableHeader::readSlot(header->getControllerSlot(0), pose_data) &&
+		pose_data.device_type == -1 &&
+		SharedPoseTableHeader::readSlot(header->getHMDSlot(PSMOVESERVICE_MAX_HMD_COUNT - 1), pose_data) &&
+		pose_data.device_type == -1;
+	assert(success);
+
+	// Controller and HMD slots don't overlap
+	if (success)
+	{
+		SharedPoseData written;
+
+		fill_pose_data(7, written);
+		header->writeControllerPose(PSMOVESERVICE_MAX_CONTROLLER_COUNT - 1, written);
+		fill_pose_data(11, written);
+		header->writeHMDPose(0, written);
+
+		success =
+			SharedPoseTableHeader::readSlot(header->getControllerSlot(PSMOVESERVICE_MAX_CONTROLLER_COUNT - 1), pose_data) &&
+			pose_data.sequence_num == 7 && is_pose_data_consistent(pose_data) &&
+			SharedPoseTableHeader::readSlot(header->getHMDSlot(0), pose_data) &&
+			pose_data.sequence_num == 11 && is_pose_data_consistent(pose_data);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_pose_table_test_concurrent_writer()
+{
+	UNIT_TEST_BEGIN("concurrent writer")
+
+	SharedPoseTableBuffer shared_buffer;
+	SharedPoseTableHeader *header = shared_buffer.get();
+	std::atomic_bool writer_done(false);
+
+	std::thread writer_thread([header, &writer_done]() {
+		SharedPoseData pose_data;
+
+		for (int write_count = 1; write_count <= 200000; ++write_count)
+		{
+			fill_pose_data(write_count, pose_data);
+			header->writeControllerPose(0, pose_data);
+		}
+
+		writer_done = true;
+	});
+
+	int last_sequence_num = 0;
+
+	while (success && !writer_done)
+	{
+		SharedPoseData pose_data;
+
+		if (SharedPoseTableHeader::readSlot(header->getControllerSlot(0), pose_data) && pose_data.device_type != -1)
+		{
+			// Never torn and never older than what we already read
+			success = is_pose_data_consistent(pose_data) && pose_data.sequence_num >= last_sequence_num;
+			last_sequence_num = pose_data.sequence_num;
+		}
+	}
+
+	writer_thread.join();
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
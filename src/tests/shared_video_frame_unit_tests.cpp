@@ -0,0 +1,184 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "SharedTrackerState.h"
+#include "unit_test.h"
+
+//-- constants -----
+static const int k_frame_width = 64;
+static const int k_frame_height = 48;
+static const int k_frame_stride = 3 * k_frame_width;
+
+//-- private types -----
+// A video stream header and its slots in (cache line aligned) process memory
+class SharedVideoFrameBuffer
+{
+public:
+	SharedVideoFrameBuffer()
+		: m_memory(SharedVideoFrameHeader::computeTotalSize(k_frame_stride, k_frame_height, SharedVideoFrameHeader::k_default_slot_count) + 64)
+	{
+		void *aligned_memory = reinterpret_cast<void *>((reinterpret_cast<size_t>(m_memory.data()) + 63) & ~static_cast<size_t>(63));
+
+		m_header = new (aligned_memory) SharedVideoFrameHeader();
+		m_header->width = k_frame_width;
+		m_header->height = k_frame_height;
+		m_header->stride = k_frame_stride;
+		m_header->slot_count = SharedVideoFrameHeader::k_default_slot_count;
+		m_header->initializeSlots();
+	}
+
+	SharedVideoFrameHeader *get() { return m_header; }
+
+private:
+	std::vector<unsigned char> m_memory;
+	SharedVideoFrameHeader *m_header;
+};
+
+//-- public interface -----
+bool run_shared_video_frame_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("shared_video_frame")
+		UNIT_TEST_MODULE_CALL_TEST(shared_video_frame_test_read_latest);
+		UNIT_TEST_MODULE_CALL_TEST(shared_video_frame_test_no_copy_overwrite);
+		UNIT_TEST_MODULE_CALL_TEST(shared_video_frame_test_concurrent_writer);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static bool is_frame_filled_with(const unsigned char *buffer, unsigned char value)
+{
+	for (int byte_index = 0; byte_index < k_frame_stride*k_frame_height; ++byte_index)
+	{
+		if (buffer[byte_index] != value)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+shared_video_frame_test_read_latest()
+{
+	UNIT_TEST_BEGIN("read latest")
+
+	SharedVideoFrameBuffer shared_buffer;
+	SharedVideoFrameHeader *header = shared_buffer.get();
+	std::vector<unsigned char> frame(k_frame_stride*k_frame_height);
+	std::vector<unsigned char> read_frame(frame.size());
+	int frame_index = -1;
+
+	// Nothing to read before the first frame is written
+	success = !header->readLatestVideoFrame(read_frame.data(), frame_index);
+	assert(success);
+
+	for (int write_count = 1; success && write_count <= 10; ++write_count)
+	{
+		std::fill(frame.begin(), frame.end(), static_cast<unsigned char>(write_count));
+		header->writeVideoFrame(frame.data());
+
+		success =
+			header->readLatestVideoFrame(read_frame.data(), frame_index) &&
+			frame_index == write_count &&
+			is_frame_filled_with(read_frame.data(), static_cast<unsigned char>(write_count));
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_video_frame_test_no_copy_overwrite()
+{
+	UNIT_TEST_BEGIN("no copy overwrite")
+
+	SharedVideoFrameBuffer shared_buffer;
+	SharedVideoFrameHeader *header = shared_buffer.get();
+	std::vector<unsigned char> frame(k_frame_stride*k_frame_height, 1);
+	int frame_index = 0;
+
+	header->writeVideoFrame(frame.data());
+	const unsigned char *buffer = header->getLatestVideoFrame(frame_index);
+
+	success = buffer != nullptr && frame_index == 1 && is_frame_filled_with(buffer, 1);
+	assert(success);
+
+	// The slot survives until the writer comes back around to it
+	for (int write_count = 2; success && write_count <= SharedVideoFrameHeader::k_default_slot_count; ++write_count)
+	{
+		header->writeVideoFrame(frame.data());
+		success = header->getIsVideoFrameIntact(frame_index);
+		assert(success);
+	}
+
+	if (success)
+	{
+		header->writeVideoFrame(frame.data());
+		success = !header->getIsVideoFrameIntact(frame_index);
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_video_frame_test_concurrent_writer()
+{
+	UNIT_TEST_BEGIN("concurrent writer")
+
+	SharedVideoFrameBuffer shared_buffer;
+	SharedVideoFrameHeader *header = shared_buffer.get();
+	std::atomic_bool writer_done(false);
+
+	// Every frame is filled with its own index, so a torn read shows up as mixed bytes
+	std::thread writer_thread([header, &writer_done]() {
+		std::vector<unsigned char> frame(k_frame_stride*k_frame_height);
+
+		for (int write_count = 1; write_count <= 20000; ++write_count)
+		{
+			std::fill(frame.begin(), frame.end(), static_cast<unsigned char>(write_count));
+			header->writeVideoFrame(frame.data());
+		}
+
+		writer_done = true;
+	});
+
+	std::vector<unsigned char> read_frame(k_frame_stride*k_frame_height);
+	int read_count = 0;
+
+	while (success && !writer_done)
+	{
+		int frame_index = 0;
+
+		if (header->readLatestVideoFrame(read_frame.data(), frame_index))
+		{
+			success = is_frame_filled_with(read_frame.data(), static_cast<unsigned char>(frame_index));
+			++read_count;
+		}
+
+		const unsigned char *buffer = header->getLatestVideoFrame(frame_index);
+		if (success && buffer != nullptr)
+		{
+			const unsigned char first_byte = buffer[0];
+			const unsigned char last_byte = buffer[k_frame_stride*k_frame_height - 1];
+
+			if (header->getIsVideoFrameIntact(frame_index))
+			{
+				success =
+					first_byte == static_cast<unsigned char>(frame_index) &&
+					last_byte == static_cast<unsigned char>(frame_index);
+			}
+		}
+	}
+
+	writer_thread.join();
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,137 @@
+// Checks BGRToHSVConverter against cv::cvtColor for every 24-bit color, then times it
+// against the 256^3 entry lookup table and cv::cvtColor on camera sized frames.
+
+#include "BGRToHSVConverter.h"
+#include "opencv2/opencv.hpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+typedef cv::Point3_<uint8_t> ColorTuple;
+
+static const int k_benchmark_iterations = 200;
+
+// Same lookup table the tracker used to build at startup
+static cv::Mat *build_lookup_table()
+{
+    cv::Mat *bgr2hsv = new cv::Mat(256*256*256, 1, CV_8UC3);
+
+    int LUTIndex = 0;
+    for (int r = 0; r < 256; ++r)
+    {
+        for (int g = 0; g < 256; ++g)
+        {
+            for (int b = 0; b < 256; ++b)
+            {
+                bgr2hsv->at<ColorTuple>(LUTIndex, 0) = ColorTuple(b, g, r);
+                ++LUTIndex;
+            }
+        }
+    }
+
+    cv::cvtColor(*bgr2hsv, *bgr2hsv, cv::COLOR_BGR2HSV);
+
+    return bgr2hsv;
+}
+
+static void lookup_table_cvtColor(const cv::Mat *bgr2hsv, const cv::Mat &bgrBuffer, cv::Mat &hsvBuffer)
+{
+    hsvBuffer.forEach<ColorTuple>([&bgrBuffer, bgr2hsv](ColorTuple &hsvColor, const int position[]) -> void {
+        const ColorTuple &bgrColor = bgrBuffer.at<ColorTuple>(position[0], position[1]);
+        const int LUTIndex = (256 * 256)*bgrColor.z + 256*bgrColor.y + bgrColor.x;
+
+        hsvColor = bgr2hsv->at<ColorTuple>(LUTIndex, 0);
+    });
+}
+
+static bool test_every_color()
+{
+    // Every 24-bit color laid out as a 4096x4096 image
+    cv::Mat bgr(4096, 4096, CV_8UC3);
+    for (int color = 0; color < 256*256*256; ++color)
+    {
+        bgr.at<ColorTuple>(color / 4096, color % 4096) = ColorTuple(color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff);
+    }
+
+    cv::Mat expected, actual(bgr.size(), CV_8UC3);
+    cv::cvtColor(bgr, expected, cv::COLOR_BGR2HSV);
+    BGRToHSVConverter::convertImage(bgr.data, static_cast<int>(bgr.step), actual.data, static_cast<int>(actual.step), bgr.cols, bgr.rows);
+
+    int mismatch_count = 0;
+    for (int color = 0; color < 256*256*256; ++color)
+    {
+        const ColorTuple &e = expected.at<ColorTuple>(color / 4096, color % 4096);
+        const ColorTuple &a = actual.at<ColorTuple>(color / 4096, color % 4096);
+
+        if (e != a)
+        {
+            if (mismatch_count < 10)
+            {
+                printf("  BGR(%d,%d,%d): expected HSV(%d,%d,%d), got HSV(%d,%d,%d)\n",
+                    color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff,
+                    e.x, e.y, e.z, a.x, a.y, a.z);
+            }
+            ++mismatch_count;
+        }
+    }
+
+    printf("Exhaustive comparison against cv::cvtColor: %d mismatches\n", mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+template <typename t_convert_func>
+static double time_conversion_ms(t_convert_func convert)
+{
+    // Warm up
+    convert();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < k_benchmark_iterations; ++iteration)
+    {
+        convert();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / k_benchmark_iterations;
+}
+
+static void benchmark_resolution(const cv::Mat *bgr2hsv, int width, int height)
+{
+    cv::Mat bgr(height, width, CV_8UC3);
+    cv::Mat hsv(height, width, CV_8UC3);
+    cv::randu(bgr, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    const double simd_ms = time_conversion_ms([&]() {
+        BGRToHSVConverter::convertImage(bgr.data, static_cast<int>(bgr.step), hsv.data, static_cast<int>(hsv.step), width, height);
+    });
+    const double lut_ms = time_conversion_ms([&]() {
+        lookup_table_cvtColor(bgr2hsv, bgr, hsv);
+    });
+    const double opencv_ms = time_conversion_ms([&]() {
+        cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+    });
+
+    printf("%dx%d: %s %.3fms, lookup table %.3fms, cv::cvtColor %.3fms (per frame, %d frames)\n",
+        width, height, BGRToHSVConverter::getKernelName(), simd_ms, lut_ms, opencv_ms, k_benchmark_iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    printf("BGRToHSVConverter kernel: %s\n", BGRToHSVConverter::getKernelName());
+
+    const bool bSuccess = test_every_color();
+
+    const auto lut_start = std::chrono::high_resolution_clock::now();
+    cv::Mat *bgr2hsv = build_lookup_table();
+    const auto lut_end = std::chrono::high_resolution_clock::now();
+    printf("Lookup table construction: %.1fms\n", std::chrono::duration<double, std::milli>(lut_end - lut_start).count());
+
+    benchmark_resolution(bgr2hsv, 320, 240);
+    benchmark_resolution(bgr2hsv, 640, 480);
+
+    delete bgr2hsv;
+
+    return bSuccess ? 0 : -1;
+}
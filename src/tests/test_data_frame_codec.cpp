@@ -0,0 +1,397 @@
+// Encodes PSMove controller data frames with the service's encoders (ControllerDataFrameEncoder.h)
+// and decodes them with the client library's apply functions (ClientControllerDataFrame.h),
+// in both the protobuf format and the fixed-layout raw format (RawDataFrame.h).
+// Checks that both formats decode to the same controller state and times them.
+
+#include "ClientControllerDataFrame.h"
+#include "ControllerDataFrameEncoder.h"
+#include "PackedMessage.h"
+#include "PSMoveProtocol.pb.h"
+#include "PSMoveProtocolInterface.h"
+#include "RawDataFrame.h"
+#include "ServerRequestHandler.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const int k_iteration_count = 1000000;
+static const int k_controller_id = 1;
+static const int k_selected_tracker_id = 1;
+
+struct StreamOptions
+{
+    const char *label;
+    bool include_position_data;
+    bool include_physics_data;
+    bool include_raw_sensor_data;
+    bool include_calibrated_sensor_data;
+    bool include_raw_tracker_data;
+};
+
+// What ServerControllerView reads out of the controller, its pose filter and the trackers
+static PSMoveDataFrameSource make_source(int sequence_num)
+{
+    PSMoveDataFrameSource source;
+    const float t = static_cast<float>(sequence_num) * 0.001f;
+
+    memset(&source, 0, sizeof(PSMoveDataFrameSource));
+    source.bIsConnected = true;
+    source.bHasControllerState = true;
+    source.bHasValidHardwareCalibration = true;
+    source.bIsTrackingEnabled = true;
+    source.bIsCurrentlyTracking = (sequence_num & 0x4) != 0;
+    source.bIsOrientationValid = true;
+    source.bIsPositionValid = (sequence_num & 0x8) != 0;
+
+    source.pose.PositionCm.x = 10.f + sinf(t);
+    source.pose.PositionCm.y = 120.f + cosf(t);
+    source.pose.PositionCm.z = -30.f + t;
+    source.pose.Orientation.w = cosf(t * 0.5f);
+    source.pose.Orientation.x = 0.f;
+    source.pose.Orientation.y = sinf(t * 0.5f);
+    source.pose.Orientation.z = 0.f;
+
+    source.physics.VelocityCmPerSec.i = t;
+    source.physics.VelocityCmPerSec.j = t - 1.f;
+    source.physics.VelocityCmPerSec.k = t - 2.f;
+    source.physics.AccelerationCmPerSecSqr.i = 2.f * t;
+    source.physics.AccelerationCmPerSecSqr.j = 2.f * t - 1.f;
+    source.physics.AccelerationCmPerSecSqr.k = 2.f * t - 2.f;
+    source.physics.AngularVelocityRadPerSec.i = 3.f * t;
+    source.physics.AngularVelocityRadPerSec.j = 3.f * t - 1.f;
+    source.physics.AngularVelocityRadPerSec.k = 3.f * t - 2.f;
+    source.physics.AngularAccelerationRadPerSecSqr.i = 4.f * t;
+    source.physics.AngularAccelerationRadPerSecSqr.j = 4.f * t - 1.f;
+    source.physics.AngularAccelerationRadPerSecSqr.k = 4.f * t - 2.f;
+
+    source.button_bitmask = (sequence_num & 0x1ff);
+    source.trigger_value = static_cast<unsigned char>(sequence_num & 0xff);
+    source.battery_value = 4;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        source.raw_magnetometer[axis] = (sequence_num + axis * 100) % 32768 - 16384;
+        source.raw_accelerometer[axis] = (sequence_num * 2 + axis * 100) % 32768 - 16384;
+        source.raw_gyroscope[axis] = (sequence_num * 3 + axis * 100) % 32768 - 16384;
+        source.calibrated_magnetometer[axis] = static_cast<float>(source.raw_magnetometer[axis]) / 16384.f;
+        source.calibrated_accelerometer[axis] = static_cast<float>(source.raw_accelerometer[axis]) / 16384.f;
+        source.calibrated_gyroscope[axis] = static_cast<float>(source.raw_gyroscope[axis]) / 16384.f;
+    }
+
+    // The selected tracker and the multicam estimate come and go independently
+    source.valid_tracker_bitmask = (sequence_num >> 4) & 0x7;
+    source.bHasSelectedTrackerProjection = (source.valid_tracker_bitmask & (1 << k_selected_tracker_id)) != 0;
+    if (source.bHasSelectedTrackerProjection)
+    {
+        source.selected_tracker_id = k_selected_tracker_id;
+        source.selected_tracker_screen_location.x = 320.f + 100.f * sinf(t);
+        source.selected_tracker_screen_location.y = 240.f + 100.f * cosf(t);
+        source.selected_tracker_relative_position_cm.x = sinf(t);
+        source.selected_tracker_relative_position_cm.y = cosf(t);
+        source.selected_tracker_relative_position_cm.z = 100.f + t;
+        source.selected_tracker_projection.shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
+        source.selected_tracker_projection.shape.ellipse.center = source.selected_tracker_screen_location;
+        source.selected_tracker_projection.shape.ellipse.half_x_extent = 12.f + t;
+        source.selected_tracker_projection.shape.ellipse.half_y_extent = 10.f + t;
+        source.selected_tracker_projection.shape.ellipse.angle = t;
+    }
+    source.bHasMulticamPosition = (sequence_num & 0x80) != 0;
+    if (source.bHasMulticamPosition)
+    {
+        source.multicam_position_cm.x = source.pose.PositionCm.x + 0.5f;
+        source.multicam_position_cm.y = source.pose.PositionCm.y - 0.5f;
+        source.multicam_position_cm.z = source.pose.PositionCm.z;
+    }
+
+    return source;
+}
+
+static ControllerStreamInfo make_stream_info(const StreamOptions &options)
+{
+    ControllerStreamInfo stream_info;
+
+    stream_info.Clear();
+    stream_info.include_position_data = options.include_position_data;
+    stream_info.include_physics_data = options.include_physics_data;
+    stream_info.include_raw_sensor_data = options.include_raw_sensor_data;
+    stream_info.include_calibrated_sensor_data = options.include_calibrated_sensor_data;
+    stream_info.include_raw_tracker_data = options.include_raw_tracker_data;
+    stream_info.selected_tracker_index = k_selected_tracker_id;
+
+    return stream_info;
+}
+
+// -- Protobuf format: ServerControllerView::generate_controller_data_frame_for_stream() and PSMoveClient --
+// Returns the size of the datagram written to buffer
+static int encode_protobuf(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo &stream_info,
+    int sequence_num,
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame,
+    uint8_t *buffer)
+{
+    auto *controller_data_frame = data_frame->mutable_controller_data_packet();
+
+    controller_data_frame->set_controller_id(k_controller_id);
+    controller_data_frame->set_sequence_num(sequence_num);
+    controller_data_frame->set_isconnected(source.bIsConnected);
+    encode_psmove_data_frame(source, &stream_info, data_frame);
+    data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER);
+
+    const int msg_size = static_cast<int>(data_frame->ByteSizeLong());
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame>::pack_exact(*data_frame, buffer, msg_size);
+
+    return HEADER_SIZE + msg_size;
+}
+
+static bool decode_protobuf(
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> &packed_data_frame,
+    const uint8_t *buffer,
+    unsigned buffer_size,
+    PSMPSMove *psmove)
+{
+    const unsigned msg_len = packed_data_frame.decode_header(buffer, buffer_size);
+    if (!packed_data_frame.unpack(buffer, HEADER_SIZE + msg_len))
+        return false;
+
+    applyPSMoveDataFrame(packed_data_frame.get_msg()->controller_data_packet(), psmove);
+
+    return true;
+}
+
+// -- Raw format: ServerControllerView::generate_controller_raw_data_frame_for_stream() and PSMoveClient --
+static void encode_raw(
+    const PSMoveDataFrameSource &source,
+    const ControllerStreamInfo &stream_info,
+    int sequence_num,
+    RawPSMoveDataFrame *raw_frame,
+    uint8_t *buffer)
+{
+    memset(raw_frame, 0, sizeof(RawPSMoveDataFrame));
+    init_raw_data_frame_header(
+        raw_frame->header, sizeof(RawPSMoveDataFrame),
+        PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER, PSMoveProtocol::PSMOVE,
+        k_controller_id, sequence_num);
+    encode_psmove_raw_data_frame(source, &stream_info, raw_frame);
+
+    memcpy(buffer, raw_frame, sizeof(RawPSMoveDataFrame));
+}
+
+static bool decode_raw(
+    const uint8_t *buffer,
+    size_t buffer_size,
+    PSMPSMove *psmove)
+{
+    RawDataFrameHeader header;
+    if (!decode_raw_data_frame_header(buffer, buffer_size, header) || header.frame_size < sizeof(RawPSMoveDataFrame))
+        return false;
+
+    // The datagram buffer has no alignment guarantees, so copy the whole frame out
+    RawPSMoveDataFrame raw_frame;
+    memcpy(&raw_frame, buffer, sizeof(RawPSMoveDataFrame));
+
+    applyRawPSMoveDataFrame(raw_frame, psmove);
+
+    return true;
+}
+
+// -- Benchmark --
+struct CodecResult
+{
+    double encode_ns;
+    double decode_ns;
+    size_t datagram_size;
+    float checksum;
+};
+
+static float psmove_checksum(const PSMPSMove &psmove)
+{
+    return
+        psmove.Pose.Position.x + psmove.Pose.Position.y + psmove.Pose.Position.z +
+        psmove.Pose.Orientation.w + psmove.Pose.Orientation.y +
+        psmove.PhysicsData.AngularVelocityRadPerSec.z +
+        static_cast<float>(psmove.RawSensorData.Gyroscope.x) +
+        psmove.CalibratedSensorData.Accelerometer.y +
+        psmove.RawTrackerData.ScreenLocation.x + psmove.RawTrackerData.MulticamPositionCm.z +
+        static_cast<float>(psmove.TriggerValue + psmove.TriangleButton + psmove.TriggerButton);
+}
+
+static CodecResult run_protobuf(const StreamOptions &options)
+{
+    CodecResult result;
+    const ControllerStreamInfo stream_info = make_stream_info(options);
+    google::protobuf::Arena arena;
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_data_frame(
+        PackedMessage<PSMoveProtocol::DeviceOutputDataFrame>::MessagePointer(new PSMoveProtocol::DeviceOutputDataFrame));
+    uint8_t buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    PSMPSMove psmove;
+    std::chrono::duration<double, std::nano> encode_time(0);
+    std::chrono::duration<double, std::nano> decode_time(0);
+
+    memset(&psmove, 0, sizeof(PSMPSMove));
+    result.checksum = 0.f;
+    result.datagram_size = 0;
+
+    for (int iteration = 0; iteration < k_iteration_count; ++iteration)
+    {
+        const PSMoveDataFrameSource source = make_source(iteration);
+
+        // The service builds each data frame on an arena that is reset after publishing
+        const std::chrono::time_point<std::chrono::high_resolution_clock> encode_start = std::chrono::high_resolution_clock::now();
+        PSMoveProtocol::DeviceOutputDataFrame *data_frame =
+            google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(&arena);
+        const int datagram_size = encode_protobuf(source, stream_info, iteration, data_frame, buffer);
+        arena.Reset();
+        const std::chrono::time_point<std::chrono::high_resolution_clock> decode_start = std::chrono::high_resolution_clock::now();
+
+        decode_protobuf(packed_data_frame, buffer, datagram_size, &psmove);
+        const std::chrono::time_point<std::chrono::high_resolution_clock> decode_end = std::chrono::high_resolution_clock::now();
+
+        encode_time += decode_start - encode_start;
+        decode_time += decode_end - decode_start;
+        result.checksum += psmove_checksum(psmove);
+        result.datagram_size = datagram_size;
+    }
+
+    result.encode_ns = encode_time.count() / static_cast<double>(k_iteration_count);
+    result.decode_ns = decode_time.count() / static_cast<double>(k_iteration_count);
+
+    return result;
+}
+
+static CodecResult run_raw(const StreamOptions &options)
+{
+    CodecResult result;
+    const ControllerStreamInfo stream_info = make_stream_info(options);
+    RawPSMoveDataFrame raw_frame;
+    uint8_t buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    PSMPSMove psmove;
+    std::chrono::duration<double, std::nano> encode_time(0);
+    std::chrono::duration<double, std::nano> decode_time(0);
+
+    memset(&psmove, 0, sizeof(PSMPSMove));
+    result.checksum = 0.f;
+    result.datagram_size = sizeof(RawPSMoveDataFrame);
+
+    for (int iteration = 0; iteration < k_iteration_count; ++iteration)
+    {
+        const PSMoveDataFrameSource source = make_source(iteration);
+
+        const std::chrono::time_point<std::chrono::high_resolution_clock> encode_start = std::chrono::high_resolution_clock::now();
+        encode_raw(source, stream_info, iteration, &raw_frame, buffer);
+        const std::chrono::time_point<std::chrono::high_resolution_clock> decode_start = std::chrono::high_resolution_clock::now();
+
+        decode_raw(buffer, sizeof(RawPSMoveDataFrame), &psmove);
+        const std::chrono::time_point<std::chrono::high_resolution_clock> decode_end = std::chrono::high_resolution_clock::now();
+
+        encode_time += decode_start - encode_start;
+        decode_time += decode_end - decode_start;
+        result.checksum += psmove_checksum(psmove);
+    }
+
+    result.encode_ns = encode_time.count() / static_cast<double>(k_iteration_count);
+    result.decode_ns = decode_time.count() / static_cast<double>(k_iteration_count);
+
+    return result;
+}
+
+// Both formats have to produce the same client side controller state
+static bool test_formats_match(const StreamOptions &options)
+{
+    const ControllerStreamInfo stream_info = make_stream_info(options);
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_data_frame(
+        PackedMessage<PSMoveProtocol::DeviceOutputDataFrame>::MessagePointer(new PSMoveProtocol::DeviceOutputDataFrame));
+    PSMoveProtocol::DeviceOutputDataFrame data_frame;
+    RawPSMoveDataFrame raw_frame;
+    uint8_t protobuf_buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    uint8_t raw_buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    PSMPSMove protobuf_psmove;
+    PSMPSMove raw_psmove;
+    int mismatch_count = 0;
+
+    // Zero the padding too, so the structs can be compared with memcmp.
+    // Both keep their state across frames, the way the client's controller state does.
+    memset(&protobuf_psmove, 0, sizeof(PSMPSMove));
+    memset(&raw_psmove, 0, sizeof(PSMPSMove));
+
+    for (int iteration = 0; iteration < 1000; ++iteration)
+    {
+        const int sequence_num = iteration * 37;
+        const PSMoveDataFrameSource source = make_source(sequence_num);
+
+        data_frame.Clear();
+        const int datagram_size = encode_protobuf(source, stream_info, sequence_num, &data_frame, protobuf_buffer);
+        encode_raw(source, stream_info, sequence_num, &raw_frame, raw_buffer);
+
+        const bool decoded =
+            !is_raw_data_frame(protobuf_buffer, datagram_size) &&
+            is_raw_data_frame(raw_buffer, sizeof(RawPSMoveDataFrame)) &&
+            decode_protobuf(packed_data_frame, protobuf_buffer, datagram_size, &protobuf_psmove) &&
+            decode_raw(raw_buffer, sizeof(RawPSMoveDataFrame), &raw_psmove);
+
+        if (!decoded || memcmp(&protobuf_psmove, &raw_psmove, sizeof(PSMPSMove)) != 0)
+        {
+            ++mismatch_count;
+        }
+    }
+
+    // A cut short or mismatched version raw frame must be rejected
+    RawDataFrameHeader header;
+    if (decode_raw_data_frame_header(raw_buffer, sizeof(RawPSMoveDataFrame) - 1, header))
+    {
+        ++mismatch_count;
+    }
+    raw_frame.header.version = RAW_DATA_FRAME_VERSION + 1;
+    memcpy(raw_buffer, &raw_frame, sizeof(RawPSMoveDataFrame));
+    if (decode_raw_data_frame_header(raw_buffer, sizeof(RawPSMoveDataFrame), header))
+    {
+        ++mismatch_count;
+    }
+
+    printf("  %s: %d mismatches between the decoded formats\n", options.label, mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+int main()
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const StreamOptions stream_options[] = {
+        { "Pose only", false, false, false, false, false },
+        { "Position + physics", true, true, false, false, false },
+        { "Raw sensors only", false, false, true, false, false },
+        { "Everything but tracker data", true, true, true, true, false },
+        { "Everything", true, true, true, true, true },
+    };
+    const int stream_option_count = static_cast<int>(sizeof(stream_options) / sizeof(stream_options[0]));
+    bool success = true;
+
+    printf("PSMove data frame codecs, %d iterations\n", k_iteration_count);
+
+    for (int option_index = 0; option_index < stream_option_count; ++option_index)
+    {
+        success &= test_formats_match(stream_options[option_index]);
+    }
+
+    for (int option_index = 0; option_index < stream_option_count; ++option_index)
+    {
+        const StreamOptions &options = stream_options[option_index];
+        const CodecResult protobuf_result = run_protobuf(options);
+        const CodecResult raw_result = run_raw(options);
+
+        printf("  %s\n", options.label);
+        printf("    protobuf: encode %6.1f ns, decode %6.1f ns, %3d byte datagram\n",
+            protobuf_result.encode_ns, protobuf_result.decode_ns, static_cast<int>(protobuf_result.datagram_size));
+        printf("    raw:      encode %6.1f ns, decode %6.1f ns, %3d byte datagram\n",
+            raw_result.encode_ns, raw_result.decode_ns, static_cast<int>(raw_result.datagram_size));
+
+        success &= (protobuf_result.checksum == raw_result.checksum);
+    }
+
+    google::protobuf::ShutdownProtobufLibrary();
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,161 @@
+// Checks DeviceStateRingBuffer against the std::deque state history the devices used to keep,
+// then times the per-poll push + look back pattern of both.
+
+#include "DeviceInterface.h"
+#include "DeviceStateRingBuffer.h"
+
+#include <chrono>
+#include <deque>
+#include <stdio.h>
+
+#define BENCHMARK_STATE_BUFFER_MAX 16
+
+// Roughly the size of the controller states
+struct BenchmarkState : public CommonControllerState
+{
+    float RawSensorData[48];
+};
+
+static const int k_benchmark_iterations = 10000000;
+static const int k_states_per_update = 2; // states polled per main loop update
+
+// The container the devices used before
+class DequeStateHistory
+{
+public:
+    void push_back(const BenchmarkState &state)
+    {
+        if (m_states.size() >= BENCHMARK_STATE_BUFFER_MAX)
+        {
+            m_states.erase(m_states.begin(), m_states.begin() + m_states.size() - BENCHMARK_STATE_BUFFER_MAX);
+        }
+
+        m_states.push_back(state);
+    }
+
+    const BenchmarkState *getLookBack(int lookBack) const
+    {
+        const int queueSize = static_cast<int>(m_states.size());
+
+        return (lookBack < queueSize) ? &m_states.at(queueSize - lookBack - 1) : nullptr;
+    }
+
+private:
+    std::deque<BenchmarkState> m_states;
+};
+
+static BenchmarkState make_state(int sequence_number)
+{
+    BenchmarkState state;
+
+    state.PollSequenceNumber = sequence_number;
+    for (int i = 0; i < 48; ++i)
+    {
+        state.RawSensorData[i] = static_cast<float>(sequence_number + i);
+    }
+
+    return state;
+}
+
+static bool test_matches_deque()
+{
+    DequeStateHistory expected;
+    DeviceStateRingBuffer<BenchmarkState, BENCHMARK_STATE_BUFFER_MAX> actual;
+    int mismatch_count = 0;
+
+    for (int sequence_number = 0; sequence_number < 5 * BENCHMARK_STATE_BUFFER_MAX; ++sequence_number)
+    {
+        const BenchmarkState state = make_state(sequence_number);
+
+        expected.push_back(state);
+        actual.push_back(state);
+
+        // The deque trimmed itself before pushing, so it kept one state more than the max around
+        for (int lookBack = 0; lookBack < BENCHMARK_STATE_BUFFER_MAX; ++lookBack)
+        {
+            const BenchmarkState *e = expected.getLookBack(lookBack);
+            const BenchmarkState *a = actual.getLookBack(lookBack);
+
+            if ((e == nullptr) != (a == nullptr) ||
+                (e != nullptr && e->PollSequenceNumber != a->PollSequenceNumber))
+            {
+                if (mismatch_count < 10)
+                {
+                    printf("  after push %d, look back %d: expected state %d, got state %d\n",
+                        sequence_number, lookBack,
+                        e != nullptr ? e->PollSequenceNumber : -1,
+                        a != nullptr ? a->PollSequenceNumber : -1);
+                }
+                ++mismatch_count;
+            }
+        }
+    }
+
+    if (actual.back().PollSequenceNumber != 5 * BENCHMARK_STATE_BUFFER_MAX - 1 ||
+        actual.size() != BENCHMARK_STATE_BUFFER_MAX ||
+        actual.getLookBack(BENCHMARK_STATE_BUFFER_MAX) != nullptr)
+    {
+        ++mismatch_count;
+    }
+
+    actual.clear();
+    if (!actual.empty() || actual.getLookBack(0) != nullptr)
+    {
+        ++mismatch_count;
+    }
+
+    printf("Look back comparison against std::deque: %d mismatches\n", mismatch_count);
+
+    return mismatch_count == 0;
+}
+
+// Push the states of one update, then walk back over them like the device views do
+template <class t_history>
+static double time_history(t_history &history, int &out_checksum)
+{
+    const BenchmarkState state = make_state(0);
+    int checksum = 0;
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+    for (int iteration = 0; iteration < k_benchmark_iterations; ++iteration)
+    {
+        for (int state_index = 0; state_index < k_states_per_update; ++state_index)
+        {
+            history.push_back(state);
+        }
+
+        for (int lookBack = k_states_per_update - 1; lookBack >= 0; --lookBack)
+        {
+            checksum += history.getLookBack(lookBack)->PollSequenceNumber;
+        }
+    }
+
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    out_checksum = checksum;
+
+    return elapsed.count() / static_cast<double>(k_benchmark_iterations);
+}
+
+int main()
+{
+    bool success = test_matches_deque();
+
+    int deque_checksum = 0;
+    int ring_checksum = 0;
+    DequeStateHistory deque_history;
+    DeviceStateRingBuffer<BenchmarkState, BENCHMARK_STATE_BUFFER_MAX> ring_history;
+
+    const double deque_ns = time_history(deque_history, deque_checksum);
+    const double ring_ns = time_history(ring_history, ring_checksum);
+
+    printf("%d states per update, %d byte states, %d state history\n",
+        k_states_per_update, static_cast<int>(sizeof(BenchmarkState)), BENCHMARK_STATE_BUFFER_MAX);
+    printf("  std::deque erase + push_back: %.1f ns/update\n", deque_ns);
+    printf("  DeviceStateRingBuffer:        %.1f ns/update\n", ring_ns);
+
+    success &= (deque_checksum == ring_checksum);
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,191 @@
+// Checks that the tile cached HSV buffer of OpenCVBufferState (per tile debayering and conversion,
+// shared between overlapping ROIs) matches converting the whole frame in one go,
+// for every BGR to HSV converter and every way a frame gets into the buffer.
+
+#include "TrackerFrameProcessing.h"
+#include "opencv2/opencv.hpp"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+enum eSourceFrameType
+{
+    _source_bgr,            // writeVideoFrame()
+    _source_bayer_tiles,    // writeBayerFrame(), debayered per tile
+    _source_bayer_full,     // writeBayerFrame(), debayered up front for the video stream
+
+    _source_count
+};
+
+static const char *k_source_names[_source_count] = { "bgr", "bayer per tile", "bayer full frame" };
+static const char *k_converter_names[] = { "lookup_table", "simd", "opencv" };
+static const int k_frame_count = 3;
+
+// Overlapping ROIs like the ones several tracked objects end up with,
+// with odd coordinates and some hanging over the edges of the frame
+static void build_frame_rois(int width, int height, int frame_index, std::vector<cv::Rect2i> &out_rois)
+{
+    const int shift = 17 * frame_index;
+
+    out_rois.clear();
+    out_rois.push_back(cv::Rect2i(width / 4 + shift, height / 4, 75, 61));
+    out_rois.push_back(cv::Rect2i(width / 4 + shift + 40, height / 4 + 29, 83, 47));
+    out_rois.push_back(cv::Rect2i(-13, height / 2 - shift, 51, 33));
+    out_rois.push_back(cv::Rect2i(width - 45, height - 37, 64, 64));
+    out_rois.push_back(cv::Rect2i(width / 2 + 1, 3 + shift, 9, 7));
+}
+
+static void render_source_frame(
+    eSourceFrameType source_type,
+    cv::Mat &out_source,
+    cv::Mat &out_expected_hsv)
+{
+    cv::Mat expected_bgr;
+
+    // Noise, so that any pixel debayered or converted from the wrong neighborhood shows up
+    cv::randu(out_source, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    if (source_type == _source_bgr)
+    {
+        expected_bgr = out_source;
+    }
+    else
+    {
+        cv::cvtColor(out_source, expected_bgr, cv::COLOR_BayerGB2BGR);
+    }
+
+    cv::cvtColor(expected_bgr, out_expected_hsv, cv::COLOR_BGR2HSV);
+}
+
+// Every tile the ROIs touch has to be converted, and every converted tile has to match the full frame conversion
+static int count_mismatched_tiles(
+    const OpenCVBufferState &buffer_state,
+    const std::vector<cv::Rect2i> &rois,
+    const cv::Mat &expected_hsv,
+    int &out_checked_tile_count)
+{
+    int mismatched_tile_count = 0;
+
+    out_checked_tile_count = 0;
+
+    for (const cv::Rect2i &roi : rois)
+    {
+        const cv::Rect2i clamped_roi = buffer_state.clampROI(roi);
+
+        for (int tile_row = clamped_roi.y / k_hsv_cache_tile_size;
+            tile_row <= (clamped_roi.y + clamped_roi.height - 1) / k_hsv_cache_tile_size;
+            ++tile_row)
+        {
+            for (int tile_col = clamped_roi.x / k_hsv_cache_tile_size;
+                tile_col <= (clamped_roi.x + clamped_roi.width - 1) / k_hsv_cache_tile_size;
+                ++tile_col)
+            {
+                if (!buffer_state.hsvTileValid[tile_row*buffer_state.hsvTileColumnCount + tile_col])
+                {
+                    printf("    tile (%d, %d) under ROI (%d, %d, %d, %d) was never converted\n",
+                        tile_col, tile_row, roi.x, roi.y, roi.width, roi.height);
+                    ++mismatched_tile_count;
+                }
+            }
+        }
+    }
+
+    for (int tile_row = 0; tile_row < buffer_state.hsvTileRowCount; ++tile_row)
+    {
+        for (int tile_col = 0; tile_col < buffer_state.hsvTileColumnCount; ++tile_col)
+        {
+            if (!buffer_state.hsvTileValid[tile_row*buffer_state.hsvTileColumnCount + tile_col])
+            {
+                continue;
+            }
+
+            const cv::Rect2i tile =
+                cv::Rect2i(tile_col*k_hsv_cache_tile_size, tile_row*k_hsv_cache_tile_size, k_hsv_cache_tile_size, k_hsv_cache_tile_size) &
+                cv::Rect2i(0, 0, buffer_state.frameWidth, buffer_state.frameHeight);
+
+            if (cv::norm(cv::Mat(*buffer_state.hsvBuffer, tile), cv::Mat(expected_hsv, tile), cv::NORM_INF) != 0.0)
+            {
+                if (mismatched_tile_count < 10)
+                {
+                    printf("    tile (%d, %d) differs from the full frame conversion\n", tile_col, tile_row);
+                }
+                ++mismatched_tile_count;
+            }
+
+            ++out_checked_tile_count;
+        }
+    }
+
+    return mismatched_tile_count;
+}
+
+static bool test_tile_cache(const char *converter_name, eSourceFrameType source_type, int width, int height)
+{
+    OpenCVBufferState buffer_state(width, height, converter_name);
+    cv::Mat source(height, width, (source_type == _source_bgr) ? CV_8UC3 : CV_8UC1);
+    cv::Mat expected_hsv;
+    std::vector<cv::Rect2i> rois;
+    int mismatched_tile_count = 0;
+    int checked_tile_count = 0;
+
+    // Several frames in a row, so that tiles cached on one frame must not leak into the next
+    for (int frame_index = 0; frame_index < k_frame_count; ++frame_index)
+    {
+        render_source_frame(source_type, source, expected_hsv);
+
+        switch (source_type)
+        {
+        case _source_bgr:
+            buffer_state.writeVideoFrame(source.data);
+            break;
+        case _source_bayer_tiles:
+            buffer_state.writeBayerFrame(source.data, false);
+            break;
+        case _source_bayer_full:
+            buffer_state.writeBayerFrame(source.data, true);
+            break;
+        default:
+            break;
+        }
+
+        build_frame_rois(width, height, frame_index, rois);
+        for (const cv::Rect2i &roi : rois)
+        {
+            buffer_state.selectROI(roi);
+        }
+
+        int frame_checked_tile_count = 0;
+        mismatched_tile_count += count_mismatched_tiles(buffer_state, rois, expected_hsv, frame_checked_tile_count);
+        checked_tile_count += frame_checked_tile_count;
+    }
+
+    printf("  %dx%d, %s converter, %s: %d of %d tiles mismatched\n",
+        width, height, converter_name, k_source_names[source_type], mismatched_tile_count, checked_tile_count);
+
+    return mismatched_tile_count == 0 && checked_tile_count > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // The Bayer formats need even frame sizes. 322x242 leaves partial tiles on the right and bottom edges.
+    const cv::Size k_frame_sizes[] = { cv::Size(640, 480), cv::Size(322, 242) };
+    bool bSuccess = true;
+
+    printf("Tile cached HSV buffer vs full frame conversion (%d pixel tiles):\n", k_hsv_cache_tile_size);
+
+    for (const char *converter_name : k_converter_names)
+    {
+        for (const cv::Size &frame_size : k_frame_sizes)
+        {
+            for (int source_type = 0; source_type < _source_count; ++source_type)
+            {
+                bSuccess &= test_tile_cache(converter_name, static_cast<eSourceFrameType>(source_type), frame_size.width, frame_size.height);
+            }
+        }
+    }
+
+    printf(bSuccess ? "PASSED\n" : "FAILED\n");
+
+    return bSuccess ? 0 : -1;
+}
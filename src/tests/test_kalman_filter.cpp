@@ -7,6 +7,8 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <stdio.h>
 #include <vector>
 
@@ -379,15 +381,26 @@ static void apply_filter(
 	ControllerInputStream &stationary_stream,
 	ControllerInputStream &movement_stream,
 	FilterOutputStream &output_stream);
+static void benchmark_pose_filter_precision(
+	ControllerInputStream &stationary_stream,
+	ControllerInputStream &movement_stream);
+static void init_filter_for_controller(
+	const ControllerInputStream &stationary_stream,
+	const ControllerInputStream &movement_stream,
+	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
+	PoseFilterSpace **out_pose_filter_space, IPoseFilter **out_pose_filter);
 static void init_filter_for_psdualshock4(
 	const ControllerInputStream &stationary_stream,
 	const Eigen::Vector3f &initial_position, const Eigen::Quaternionf &initial_orientation,
 	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
 	PoseFilterSpace **out_pose_filter_space, IPoseFilter **out_pose_filter);
 static void init_filter_for_psmove(
 	const ControllerInputStream &stationary_stream,
 	const Eigen::Vector3f &initial_position, const Eigen::Quaternionf &initial_orientation,
 	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
 	PoseFilterSpace **out_pose_filter_space, IPoseFilter **out_pose_filter);
 
 int main(int argc, char *argv[])
@@ -427,6 +440,12 @@ int main(int argc, char *argv[])
 	//	movement_stream,
 	//	posefilter_output_stream);
 
+	// Per update cost of the full pose kalman filter in float vs double,
+	// and how far the float version drifts from the double one on the same recording
+	benchmark_pose_filter_precision(
+		stationary_stream,
+		movement_stream);
+
 	return 0;
 }
 
@@ -440,29 +459,12 @@ apply_filter(
 	PoseFilterSpace *pose_filter_space = nullptr;
 	IPoseFilter *pose_filter = nullptr;
 
-	const ControllerSample &initialSample = movement_stream.getSample(0);
-	Eigen::Vector3f initial_pos(initialSample.pos[0], initialSample.pos[1], initialSample.pos[2]);
-	Eigen::Quaternionf initial_ori(initialSample.ori[0], initialSample.ori[1], initialSample.ori[2], initialSample.ori[3]);
-
-	switch (movement_stream.getControllerType())
-	{
-	case CommonDeviceState::PSMove:
-		init_filter_for_psmove(
-			stationary_stream,
-			initial_pos, initial_ori,
-			bUseCompoundFilter,
-			&pose_filter_space, &pose_filter);
-		break;
-	case CommonDeviceState::PSDualShock4:
-		init_filter_for_psdualshock4(
-			stationary_stream,
-			initial_pos, initial_ori,
-			bUseCompoundFilter,
-			&pose_filter_space, &pose_filter);
-		break;
-	default:
-		break;
-	}
+	init_filter_for_controller(
+		stationary_stream,
+		movement_stream,
+		bUseCompoundFilter,
+		KalmanFilterPrecisionFloat,
+		&pose_filter_space, &pose_filter);
 
 	float lastTime = movement_stream.getSample(0).time - stationary_stream.computeMeanTimeDelta();
 
@@ -498,12 +500,151 @@ apply_filter(
 	}
 }
 
+static void
+benchmark_pose_filter_precision(
+	ControllerInputStream &stationary_stream,
+	ControllerInputStream &movement_stream)
+{
+	PoseFilterSpace *float_filter_space = nullptr;
+	IPoseFilter *float_filter = nullptr;
+	PoseFilterSpace *double_filter_space = nullptr;
+	IPoseFilter *double_filter = nullptr;
+
+	init_filter_for_controller(
+		stationary_stream, movement_stream,
+		false, // use full pose kalman filter
+		KalmanFilterPrecisionFloat,
+		&float_filter_space, &float_filter);
+	init_filter_for_controller(
+		stationary_stream, movement_stream,
+		false, // use full pose kalman filter
+		KalmanFilterPrecisionDouble,
+		&double_filter_space, &double_filter);
+
+	if (float_filter == nullptr || double_filter == nullptr)
+	{
+		printf("Pose filter precision benchmark: unsupported controller type\n");
+		delete float_filter_space;
+		delete float_filter;
+		delete double_filter_space;
+		delete double_filter;
+		return;
+	}
+
+	std::chrono::duration<double, std::micro> float_update_time(0);
+	std::chrono::duration<double, std::micro> double_update_time(0);
+	double max_position_error_cm = 0.0;
+	double sum_position_error_cm = 0.0;
+	double max_angle_error_deg = 0.0;
+	double sum_angle_error_deg = 0.0;
+	int update_count = 0;
+
+	float lastTime = movement_stream.getSample(0).time - stationary_stream.computeMeanTimeDelta();
+
+	movement_stream.reset();
+	while (movement_stream.hasNext())
+	{
+		const ControllerSample &sample = movement_stream.next();
+		const float dT = sample.time - lastTime;
+
+		PoseSensorPacket sensorPacket;
+		sensorPacket.imu_accelerometer_g_units = Eigen::Vector3f(sample.acc[0], sample.acc[1], sample.acc[2]);
+		sensorPacket.imu_gyroscope_rad_per_sec = Eigen::Vector3f(sample.gyro[0], sample.gyro[1], sample.gyro[2]);
+		sensorPacket.imu_magnetometer_unit = Eigen::Vector3f(sample.mag[0], sample.mag[1], sample.mag[2]);
+		sensorPacket.optical_orientation = Eigen::Quaternionf(sample.ori[0], sample.ori[1], sample.ori[2], sample.ori[3]);
+		sensorPacket.tracking_projection_area_px_sqr = sample.area;
+		sensorPacket.optical_position_cm = Eigen::Vector3f(sample.pos[0], sample.pos[1], sample.pos[2]);
+
+		// Each filter derives its packet from its own state
+		PoseFilterPacket floatFilterPacket;
+		PoseFilterPacket doubleFilterPacket;
+		float_filter_space->createFilterPacket(sensorPacket, float_filter, floatFilterPacket);
+		double_filter_space->createFilterPacket(sensorPacket, double_filter, doubleFilterPacket);
+
+		// Only time the filter updates themselves
+		auto float_start = std::chrono::high_resolution_clock::now();
+		float_filter->update(dT, floatFilterPacket);
+		auto float_end = std::chrono::high_resolution_clock::now();
+		double_filter->update(dT, doubleFilterPacket);
+		auto double_end = std::chrono::high_resolution_clock::now();
+
+		float_update_time += float_end - float_start;
+		double_update_time += double_end - float_end;
+		lastTime = sample.time;
+
+		const double position_error_cm =
+			(float_filter->getPositionCm() - double_filter->getPositionCm()).cast<double>().norm();
+		const double orientation_dot =
+			std::min(1.0, fabs(static_cast<double>(float_filter->getOrientation().dot(double_filter->getOrientation()))));
+		const double angle_error_deg = 2.0 * acos(orientation_dot) * k_radians_to_degreees;
+
+		max_position_error_cm = std::max(max_position_error_cm, position_error_cm);
+		sum_position_error_cm += position_error_cm;
+		max_angle_error_deg = std::max(max_angle_error_deg, angle_error_deg);
+		sum_angle_error_deg += angle_error_deg;
+		++update_count;
+	}
+
+	if (update_count > 0)
+	{
+		printf("Pose filter precision benchmark (%d updates)\n", update_count);
+		printf("  float update: %.3f us mean\n", float_update_time.count() / update_count);
+		printf("  double update: %.3f us mean\n", double_update_time.count() / update_count);
+		printf("  float vs double position: %f cm max, %f cm mean\n",
+			max_position_error_cm, sum_position_error_cm / update_count);
+		printf("  float vs double orientation: %f deg max, %f deg mean\n",
+			max_angle_error_deg, sum_angle_error_deg / update_count);
+	}
+
+	delete float_filter_space;
+	delete float_filter;
+	delete double_filter_space;
+	delete double_filter;
+}
+
+static void
+init_filter_for_controller(
+	const ControllerInputStream &stationary_stream,
+	const ControllerInputStream &movement_stream,
+	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
+	PoseFilterSpace **out_pose_filter_space,
+	IPoseFilter **out_pose_filter)
+{
+	const ControllerSample &initialSample = movement_stream.getSample(0);
+	Eigen::Vector3f initial_pos(initialSample.pos[0], initialSample.pos[1], initialSample.pos[2]);
+	Eigen::Quaternionf initial_ori(initialSample.ori[0], initialSample.ori[1], initialSample.ori[2], initialSample.ori[3]);
+
+	switch (movement_stream.getControllerType())
+	{
+	case CommonDeviceState::PSMove:
+		init_filter_for_psmove(
+			stationary_stream,
+			initial_pos, initial_ori,
+			bUseCompoundFilter,
+			precision,
+			out_pose_filter_space, out_pose_filter);
+		break;
+	case CommonDeviceState::PSDualShock4:
+		init_filter_for_psdualshock4(
+			stationary_stream,
+			initial_pos, initial_ori,
+			bUseCompoundFilter,
+			precision,
+			out_pose_filter_space, out_pose_filter);
+		break;
+	default:
+		break;
+	}
+}
+
 static void
 init_filter_for_psmove(
 	const ControllerInputStream &stationary_stream,
 	const Eigen::Vector3f &initial_position,
 	const Eigen::Quaternionf &initial_orientation,
 	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
 	PoseFilterSpace **out_pose_filter_space,
 	IPoseFilter **out_pose_filter)
 {
@@ -568,7 +709,7 @@ init_filter_for_psmove(
 	}
 	else
 	{
-		KalmanPoseFilterPSMove *fullPoseFilter = new KalmanPoseFilterPSMove();
+		KalmanPoseFilterPSMove *fullPoseFilter = new KalmanPoseFilterPSMove(precision);
 		fullPoseFilter->init(constants, initial_position, initial_orientation);
 
 		*out_pose_filter = fullPoseFilter;
@@ -583,6 +724,7 @@ init_filter_for_psdualshock4(
 	const Eigen::Vector3f &initial_position,
 	const Eigen::Quaternionf &initial_orientation,
 	const bool bUseCompoundFilter,
+	const KalmanFilterPrecision precision,
 	PoseFilterSpace **out_pose_filter_space,
 	IPoseFilter **out_pose_filter)
 {
@@ -644,7 +786,7 @@ init_filter_for_psdualshock4(
 	}
 	else
 	{
-		KalmanPoseFilterPSMove *fullPoseFilter = new KalmanPoseFilterPSMove();
+		KalmanPoseFilterDS4 *fullPoseFilter = new KalmanPoseFilterDS4(precision);
 		fullPoseFilter->init(constants, initial_position, initial_orientation);
 
 		*out_pose_filter = fullPoseFilter;
@@ -0,0 +1,291 @@
+// Measures how long a client takes to connect to a running PSMoveService,
+// fetch the controller list and start a data stream on every controller.
+//
+// "blocking" mode uses the blocking C API calls, which return as soon as the response arrives.
+// "sleep-poll" mode issues the same requests asynchronously and polls for the responses
+// every 10ms, the way the blocking C API calls used to wait for them.
+//
+// Usage: test_startup_latency [blocking|sleep-poll|both] [iteration count]
+
+#include "PSMoveClient_CAPI.h"
+#include "ClientConstants.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux) || defined (__APPLE__)
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static const int k_default_iteration_count = 20;
+static const int k_sleep_poll_interval_ms = 10;
+
+enum eStartupStep
+{
+    _startupStep_Connect,
+    _startupStep_GetControllerList,
+    _startupStep_StartStreams,
+
+    _startupStep_Count
+};
+
+static const char *k_startup_step_names[_startupStep_Count] = {
+    "connect",
+    "get controller list",
+    "start streams"
+};
+
+struct StartupTimings
+{
+    double step_ms[_startupStep_Count];
+    int controller_count;
+};
+
+struct StepStatistics
+{
+    double total_ms;
+    double min_ms;
+    double max_ms;
+};
+
+struct PendingResponse
+{
+    bool received;
+    PSMResult result_code;
+    PSMControllerList controller_list;
+};
+
+typedef bool (*startup_function)(StartupTimings &out_timings);
+
+//-- helpers -----
+static double elapsed_milliseconds(const std::chrono::high_resolution_clock::time_point &start_time)
+{
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+
+    return elapsed.count();
+}
+
+static void handle_async_response(const PSMResponseMessage *response, void *userdata)
+{
+    PendingResponse *pending_response = reinterpret_cast<PendingResponse *>(userdata);
+
+    pending_response->received = true;
+    pending_response->result_code = response->result_code;
+    if (response->payload_type == PSMResponseMessage::_responsePayloadType_ControllerList)
+    {
+        pending_response->controller_list = response->payload.controller_list;
+    }
+}
+
+static bool sleep_poll_for_response(PSMRequestID request_id, PendingResponse &pending_response)
+{
+    memset(&pending_response, 0, sizeof(PendingResponse));
+
+    if (PSM_RegisterCallback(request_id, handle_async_response, &pending_response) != PSMResult_Success)
+    {
+        return false;
+    }
+
+    const std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    while (!pending_response.received && elapsed_milliseconds(start_time) < PSM_DEFAULT_TIMEOUT)
+    {
+        _PAUSE(k_sleep_poll_interval_ms);
+        PSM_Update();
+    }
+
+    if (!pending_response.received)
+    {
+        PSM_CancelCallback(request_id);
+    }
+
+    return pending_response.received && pending_response.result_code == PSMResult_Success;
+}
+
+static void stop_streams_and_shutdown(const PSMControllerList &controller_list)
+{
+    for (int list_index = 0; list_index < controller_list.count; ++list_index)
+    {
+        const PSMControllerID controller_id = controller_list.controller_id[list_index];
+
+        PSM_StopControllerDataStream(controller_id, PSM_DEFAULT_TIMEOUT);
+        PSM_FreeControllerListener(controller_id);
+    }
+
+    PSM_Shutdown();
+}
+
+//-- startup sequences -----
+static bool startup_blocking(StartupTimings &out_timings)
+{
+    PSMControllerList controller_list;
+    bool success = true;
+
+    memset(&controller_list, 0, sizeof(PSMControllerList));
+
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    success = PSM_Initialize(PSMOVESERVICE_DEFAULT_ADDRESS, PSMOVESERVICE_DEFAULT_PORT, PSM_DEFAULT_TIMEOUT) == PSMResult_Success;
+    out_timings.step_ms[_startupStep_Connect] = elapsed_milliseconds(start_time);
+
+    if (success)
+    {
+        start_time = std::chrono::high_resolution_clock::now();
+        success = PSM_GetControllerList(&controller_list, PSM_DEFAULT_TIMEOUT) == PSMResult_Success;
+        out_timings.step_ms[_startupStep_GetControllerList] = elapsed_milliseconds(start_time);
+    }
+
+    if (success)
+    {
+        start_time = std::chrono::high_resolution_clock::now();
+        for (int list_index = 0; success && list_index < controller_list.count; ++list_index)
+        {
+            const PSMControllerID controller_id = controller_list.controller_id[list_index];
+
+            success =
+                PSM_AllocateControllerListener(controller_id) == PSMResult_Success &&
+                PSM_StartControllerDataStream(controller_id, PSMStreamFlags_defaultStreamOptions, PSM_DEFAULT_TIMEOUT) == PSMResult_Success;
+        }
+        out_timings.step_ms[_startupStep_StartStreams] = elapsed_milliseconds(start_time);
+        out_timings.controller_count = controller_list.count;
+    }
+
+    stop_streams_and_shutdown(controller_list);
+
+    return success;
+}
+
+static bool startup_sleep_poll(StartupTimings &out_timings)
+{
+    PSMControllerList controller_list;
+    PendingResponse pending_response;
+    PSMRequestID request_id;
+    bool success = true;
+
+    memset(&controller_list, 0, sizeof(PSMControllerList));
+
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    success = PSM_InitializeAsync(PSMOVESERVICE_DEFAULT_ADDRESS, PSMOVESERVICE_DEFAULT_PORT) != PSMResult_Error;
+    while (success && !PSM_HasConnectionStatusChanged() && elapsed_milliseconds(start_time) < PSM_DEFAULT_TIMEOUT)
+    {
+        _PAUSE(k_sleep_poll_interval_ms);
+        PSM_Update();
+    }
+    success = success && PSM_GetIsConnected();
+    out_timings.step_ms[_startupStep_Connect] = elapsed_milliseconds(start_time);
+
+    if (success)
+    {
+        start_time = std::chrono::high_resolution_clock::now();
+        success =
+            PSM_GetControllerListAsync(&request_id) == PSMResult_RequestSent &&
+            sleep_poll_for_response(request_id, pending_response);
+        out_timings.step_ms[_startupStep_GetControllerList] = elapsed_milliseconds(start_time);
+
+        if (success)
+        {
+            controller_list = pending_response.controller_list;
+        }
+    }
+
+    if (success)
+    {
+        start_time = std::chrono::high_resolution_clock::now();
+        for (int list_index = 0; success && list_index < controller_list.count; ++list_index)
+        {
+            const PSMControllerID controller_id = controller_list.controller_id[list_index];
+
+            success =
+                PSM_AllocateControllerListener(controller_id) == PSMResult_Success &&
+                PSM_StartControllerDataStreamAsync(controller_id, PSMStreamFlags_defaultStreamOptions, &request_id) == PSMResult_RequestSent &&
+                sleep_poll_for_response(request_id, pending_response);
+        }
+        out_timings.step_ms[_startupStep_StartStreams] = elapsed_milliseconds(start_time);
+        out_timings.controller_count = controller_list.count;
+    }
+
+    stop_streams_and_shutdown(controller_list);
+
+    return success;
+}
+
+//-- benchmark -----
+static bool run_startup_benchmark(const char *label, startup_function startup, int iteration_count)
+{
+    StepStatistics statistics[_startupStep_Count];
+    int controller_count = 0;
+
+    for (int step = 0; step < _startupStep_Count; ++step)
+    {
+        statistics[step].total_ms = 0.0;
+        statistics[step].min_ms = 0.0;
+        statistics[step].max_ms = 0.0;
+    }
+
+    for (int iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        StartupTimings timings;
+        memset(&timings, 0, sizeof(StartupTimings));
+
+        if (!startup(timings))
+        {
+            fprintf(stderr, "%s: startup failed on iteration %d (is PSMoveService running?)\n", label, iteration);
+            return false;
+        }
+
+        for (int step = 0; step < _startupStep_Count; ++step)
+        {
+            StepStatistics &step_statistics = statistics[step];
+            const double step_ms = timings.step_ms[step];
+
+            step_statistics.total_ms += step_ms;
+            step_statistics.min_ms = (iteration == 0 || step_ms < step_statistics.min_ms) ? step_ms : step_statistics.min_ms;
+            step_statistics.max_ms = (iteration == 0 || step_ms > step_statistics.max_ms) ? step_ms : step_statistics.max_ms;
+        }
+
+        controller_count = timings.controller_count;
+    }
+
+    printf("%s (%d iterations, %d controllers)\n", label, iteration_count, controller_count);
+    for (int step = 0; step < _startupStep_Count; ++step)
+    {
+        const StepStatistics &step_statistics = statistics[step];
+
+        printf("  %-20s mean %8.3fms  min %8.3fms  max %8.3fms\n",
+            k_startup_step_names[step],
+            step_statistics.total_ms / static_cast<double>(iteration_count),
+            step_statistics.min_ms,
+            step_statistics.max_ms);
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = (argc > 1) ? argv[1] : "both";
+    const int iteration_count = (argc > 2) ? atoi(argv[2]) : k_default_iteration_count;
+    bool success = true;
+
+    if (iteration_count <= 0)
+    {
+        fprintf(stderr, "Usage: %s [blocking|sleep-poll|both] [iteration count]\n", argv[0]);
+        return -1;
+    }
+
+    if (success && (strcmp(mode, "blocking") == 0 || strcmp(mode, "both") == 0))
+    {
+        success = run_startup_benchmark("blocking", startup_blocking, iteration_count);
+    }
+
+    if (success && (strcmp(mode, "sleep-poll") == 0 || strcmp(mode, "both") == 0))
+    {
+        success = run_startup_benchmark("sleep-poll", startup_sleep_poll, iteration_count);
+    }
+
+    return success ? 0 : -1;
+}
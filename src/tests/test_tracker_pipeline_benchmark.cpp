@@ -0,0 +1,936 @@
+// Runs synthetic camera frames through every stage of the tracker pipeline, the way the service does,
+// and reports the p50/p99/max latency and the throughput of each stage as JSON,
+// so that regressions can be tracked across commits.
+//
+// The frames are raw Bayer frames with rendered tracking spheres (PSMove) and light bars (DS4)
+// in up to 8 tracking colors, moving around the frame from one frame to the next.
+// Segmentation and shape fitting run through the tracker's own code (TrackerFrameProcessing.h):
+// per tile debayering and HSV conversion, fused color labeling, contours, sphere and light bar fits.
+//
+// usage: test_tracker_pipeline_benchmark [--width <px>] [--height <px>] [--spheres <count>] [--lightbars <count>]
+//                                        [--objects <count[,count...]>]
+//                                        [--frames <count>] [--hsv-converter <lookup_table|simd|opencv>]
+//                                        [--label <text>] [--output <results.json>]
+//
+// --objects sweeps the number of tracked spheres sharing the frame (e.g. --objects 1,4,8),
+// with one run per count written to the same JSON file.
+
+#include "BGRToHSVConverter.h"
+#include "CompoundPoseFilter.h"
+#include "KalmanPoseFilter.h"
+#include "MathAlignment.h"
+#include "PackedMessage.h"
+#include "PSMoveProtocol.pb.h"
+#include "PSMoveProtocolInterface.h"
+#include "TrackerFrameProcessing.h"
+#include "opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const int k_warmup_frame_count = 10;
+static const int k_max_blob_count = 8; // One per tracking color, see build_tracking_colors()
+static const int k_min_roi_size = 32; // Same as ServerTrackerView
+static const float k_sphere_radius_cm = 2.25f;
+static const float k_lightbar_quad_width_cm = 5.2f; // DS4 light bar, see PSDualShock4Controller::getTrackingShape()
+static const float k_lightbar_quad_height_cm = 1.1f;
+static const float k_lightbar_triangle_width_cm = .9386f;
+static const float k_lightbar_triangle_height_cm = .6548f;
+static const float k_frame_time_delta = 1.f / 60.f;
+static const float k_stereo_baseline_cm = 50.f;
+
+// -- Benchmark settings --
+struct BenchmarkSettings
+{
+    int width;
+    int height;
+    int sphere_count;
+    int lightbar_count;
+    std::vector<int> object_counts; // sphere counts to sweep over (a single run when empty)
+    int frame_count;
+    std::string hsv_converter;
+    std::string label;
+    std::string output_path;
+};
+
+static bool parse_settings(int argc, char *argv[], BenchmarkSettings &settings)
+{
+    settings.width = 640;
+    settings.height = 480;
+    settings.sphere_count = 2;
+    settings.lightbar_count = 0;
+    settings.object_counts.clear();
+    settings.frame_count = 500;
+    settings.hsv_converter = "simd";
+    settings.label.clear();
+    settings.output_path = "tracker_pipeline_benchmark.json";
+
+    for (int arg_index = 1; arg_index + 1 < argc; arg_index += 2)
+    {
+        const char *option = argv[arg_index];
+        const char *value = argv[arg_index + 1];
+
+        if (strcmp(option, "--width") == 0)
+            settings.width = atoi(value);
+        else if (strcmp(option, "--height") == 0)
+            settings.height = atoi(value);
+        else if (strcmp(option, "--spheres") == 0)
+            settings.sphere_count = atoi(value);
+        else if (strcmp(option, "--lightbars") == 0)
+            settings.lightbar_count = atoi(value);
+        else if (strcmp(option, "--objects") == 0)
+        {
+            std::stringstream count_list(value);
+            std::string count;
+
+            while (std::getline(count_list, count, ','))
+            {
+                settings.object_counts.push_back(atoi(count.c_str()));
+            }
+        }
+        else if (strcmp(option, "--frames") == 0)
+            settings.frame_count = atoi(value);
+        else if (strcmp(option, "--hsv-converter") == 0)
+            settings.hsv_converter = value;
+        else if (strcmp(option, "--label") == 0)
+            settings.label = value;
+        else if (strcmp(option, "--output") == 0)
+            settings.output_path = value;
+        else
+        {
+            printf("Unknown option: %s\n", option);
+            return false;
+        }
+    }
+
+    const int blob_count = settings.sphere_count + settings.lightbar_count;
+    bool bValidObjectCounts = true;
+
+    for (int object_count : settings.object_counts)
+    {
+        bValidObjectCounts &= object_count >= 1 && object_count <= k_max_blob_count;
+    }
+
+    if ((argc % 2) == 0 ||
+        settings.width < 64 || settings.height < 64 || (settings.width % 2) != 0 || (settings.height % 2) != 0 ||
+        settings.sphere_count < 0 || settings.lightbar_count < 0 ||
+        blob_count < 1 || blob_count > k_max_blob_count ||
+        !bValidObjectCounts ||
+        settings.frame_count < 1 ||
+        (settings.hsv_converter != "lookup_table" && settings.hsv_converter != "simd" && settings.hsv_converter != "opencv"))
+    {
+        printf("usage: test_tracker_pipeline_benchmark [--width <px>] [--height <px>] [--spheres <count>] [--lightbars <count>]\n");
+        printf("                                       [--objects <count[,count...]>]\n");
+        printf("                                       [--frames <count>] [--hsv-converter <lookup_table|simd|opencv>]\n");
+        printf("                                       [--label <text>] [--output <results.json>]\n");
+        printf("  width and height must be even, between 1 and %d spheres + lightbars (and objects)\n", k_max_blob_count);
+        return false;
+    }
+
+    return true;
+}
+
+// -- Stage timing --
+enum eBenchmarkStage
+{
+    _stage_frame_copy,
+    _stage_debayer_hsv,
+    _stage_segmentation,
+    _stage_undistort,
+    _stage_shape_fit,
+    _stage_triangulation,
+    _stage_pose_filter_update,
+    _stage_data_frame_generation,
+    _stage_data_frame_serialization,
+    _stage_total,
+
+    _stage_count
+};
+
+struct StageInfo
+{
+    const char *name;
+    const char *unit; // what one sample covers
+};
+
+static const StageInfo k_stage_infos[_stage_count] = {
+    { "frame_copy", "frame" },
+    { "debayer_hsv", "frame" },
+    { "segmentation", "frame" },
+    { "undistort", "blob" },
+    { "shape_fit", "blob" },
+    { "triangulation", "blob" },
+    { "pose_filter_update", "blob" },
+    { "data_frame_generation", "blob" },
+    { "data_frame_serialization", "blob" },
+    { "total", "frame" },
+};
+
+struct StageStatistics
+{
+    int sample_count;
+    double p50_us;
+    double p99_us;
+    double max_us;
+    double mean_us;
+    double throughput_per_sec;
+};
+
+class StageTimings
+{
+public:
+    StageTimings()
+        : m_bIsRecording(false)
+    {
+    }
+
+    // Samples taken during the warm up frames get thrown away
+    void setIsRecording(bool bIsRecording)
+    {
+        m_bIsRecording = bIsRecording;
+    }
+
+    template <typename t_stage_func>
+    void time(eBenchmarkStage stage, t_stage_func stage_func)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+        stage_func();
+        const std::chrono::time_point<std::chrono::high_resolution_clock> end = std::chrono::high_resolution_clock::now();
+
+        addSample(stage, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    void addSample(eBenchmarkStage stage, double sample_ns)
+    {
+        if (m_bIsRecording)
+        {
+            m_samples[stage].push_back(sample_ns);
+        }
+    }
+
+    StageStatistics computeStatistics(eBenchmarkStage stage) const
+    {
+        std::vector<double> sorted_samples = m_samples[stage];
+        StageStatistics statistics;
+
+        memset(&statistics, 0, sizeof(StageStatistics));
+        statistics.sample_count = static_cast<int>(sorted_samples.size());
+
+        if (!sorted_samples.empty())
+        {
+            double total_ns = 0.0;
+
+            std::sort(sorted_samples.begin(), sorted_samples.end());
+            for (double sample_ns : sorted_samples)
+            {
+                total_ns += sample_ns;
+            }
+
+            statistics.p50_us = get_percentile(sorted_samples, 0.50) / 1000.0;
+            statistics.p99_us = get_percentile(sorted_samples, 0.99) / 1000.0;
+            statistics.max_us = sorted_samples.back() / 1000.0;
+            statistics.mean_us = total_ns / static_cast<double>(sorted_samples.size()) / 1000.0;
+            statistics.throughput_per_sec = (total_ns > 0.0) ? 1e9 * static_cast<double>(sorted_samples.size()) / total_ns : 0.0;
+        }
+
+        return statistics;
+    }
+
+private:
+    // Nearest rank percentile
+    static double get_percentile(const std::vector<double> &sorted_samples, double percentile)
+    {
+        const size_t rank = static_cast<size_t>(ceil(percentile * static_cast<double>(sorted_samples.size())));
+
+        return sorted_samples[std::max<size_t>(rank, 1) - 1];
+    }
+
+    std::vector<double> m_samples[_stage_count];
+    bool m_bIsRecording;
+};
+
+// -- Synthetic scene --
+struct TrackingColor
+{
+    const char *name;
+    cv::Vec3b bgr;
+    CommonHSVColorRange hsv_range;
+};
+
+struct SyntheticBlob
+{
+    bool bIsSphere; // otherwise a DS4 light bar
+    int color_index;
+    float orbit_phase;
+};
+
+// The default tracking colors of the service, plus orange and purple to fill the 8 label bits.
+// Red's hue range wraps around.
+static void build_tracking_colors(std::vector<TrackingColor> &out_colors)
+{
+    const TrackingColor k_colors[k_max_blob_count] = {
+        { "magenta", cv::Vec3b(255, 0, 255), CommonHSVColorRange() },
+        { "cyan", cv::Vec3b(255, 255, 0), CommonHSVColorRange() },
+        { "yellow", cv::Vec3b(0, 255, 255), CommonHSVColorRange() },
+        { "green", cv::Vec3b(0, 255, 0), CommonHSVColorRange() },
+        { "blue", cv::Vec3b(255, 0, 0), CommonHSVColorRange() },
+        { "red", cv::Vec3b(0, 0, 255), CommonHSVColorRange() },
+        { "orange", cv::Vec3b(0, 128, 255), CommonHSVColorRange() },
+        { "purple", cv::Vec3b(255, 0, 128), CommonHSVColorRange() },
+    };
+
+    out_colors.assign(k_colors, k_colors + k_max_blob_count);
+
+    // Same kind of range as the tracker color presets: a hue window around the color, any bright saturated pixel
+    for (TrackingColor &color : out_colors)
+    {
+        unsigned char hsv[3];
+
+        BGRToHSVConverter::convertRow(color.bgr.val, hsv, 1);
+        color.hsv_range.hue_range.center = static_cast<float>(hsv[0]);
+        color.hsv_range.hue_range.range = 7.f; // hues are at least 15 apart, so the ranges don't overlap
+        color.hsv_range.saturation_range.center = 159.5f; // 64 to 255
+        color.hsv_range.saturation_range.range = 95.5f;
+        color.hsv_range.value_range = color.hsv_range.saturation_range;
+    }
+}
+
+// Renders the blobs and mosaics the frame the way the PS3Eye delivers it (cv::COLOR_BayerGB2BGR layout)
+static void render_bayer_frame(
+    const std::vector<SyntheticBlob> &blobs,
+    const std::vector<TrackingColor> &colors,
+    int frame_index,
+    cv::Mat &bgr_scratch,
+    cv::Mat &out_bayer)
+{
+    const float t = static_cast<float>(frame_index) * k_frame_time_delta;
+    const int width = bgr_scratch.cols;
+    const int height = bgr_scratch.rows;
+
+    // Dark, noisy background
+    cv::randu(bgr_scratch, cv::Scalar::all(0), cv::Scalar::all(40));
+
+    for (const SyntheticBlob &blob : blobs)
+    {
+        const float angle = blob.orbit_phase + t * 0.8f;
+        const cv::Point2f center(
+            0.5f*width + 0.3f*width*cosf(angle),
+            0.5f*height + 0.3f*height*sinf(angle));
+        const cv::Scalar color(colors[blob.color_index].bgr[0], colors[blob.color_index].bgr[1], colors[blob.color_index].bgr[2]);
+        // Moves closer and further away from the camera
+        const float scale = (static_cast<float>(width) / 640.f) * (1.f + 0.5f*sinf(angle * 1.7f));
+
+        if (blob.bIsSphere)
+        {
+            cv::circle(bgr_scratch, center, std::max(static_cast<int>(18.f * scale), 3), color, -1, cv::LINE_AA);
+        }
+        else
+        {
+            const cv::RotatedRect light_bar(
+                center,
+                cv::Size2f(10.f * scale * k_lightbar_quad_width_cm / k_lightbar_quad_height_cm, 10.f * scale),
+                20.f * sinf(angle) * 57.29578f);
+            cv::Point2f corners_f[4];
+            cv::Point corners[4];
+
+            light_bar.points(corners_f);
+            for (int corner_index = 0; corner_index < 4; ++corner_index)
+            {
+                corners[corner_index] = corners_f[corner_index];
+            }
+            cv::fillConvexPoly(bgr_scratch, corners, 4, color, cv::LINE_AA);
+        }
+    }
+
+    // The lens blurs the blob edges a bit
+    cv::GaussianBlur(bgr_scratch, bgr_scratch, cv::Size(3, 3), 0.0);
+
+    // BayerGB in OpenCV terms: G R on the even rows, B G on the odd rows
+    for (int y = 0; y < height; ++y)
+    {
+        const cv::Vec3b *bgr_row = bgr_scratch.ptr<cv::Vec3b>(y);
+        unsigned char *bayer_row = out_bayer.ptr<unsigned char>(y);
+
+        for (int x = 0; x < width; ++x)
+        {
+            const bool bEvenRow = (y & 1) == 0;
+            const bool bEvenColumn = (x & 1) == 0;
+            const int channel = (bEvenRow == bEvenColumn) ? 1 : (bEvenRow ? 2 : 0);
+
+            bayer_row[x] = bgr_row[x][channel];
+        }
+    }
+}
+
+// -- Pipeline stages that aren't a single call --
+// PS3Eye at 640x480, scaled to the frame size
+static void compute_camera_intrinsics(
+    int width, int height,
+    cv::Matx33f &out_camera_matrix,
+    cv::Matx<float, 5, 1> &out_distortions)
+{
+    const float focal_length_px = 554.2563f * static_cast<float>(width) / 640.f;
+
+    out_camera_matrix = cv::Matx33f(
+        focal_length_px, 0.f, 0.5f*width,
+        0.f, focal_length_px, 0.5f*height,
+        0.f, 0.f, 1.f);
+    out_distortions = cv::Matx<float, 5, 1>(-0.10771770030260086f, 0.1213262677192688f, 0.04875476285815239f, 0.00091733073350042105f, 0.f);
+}
+
+// Same tracking shapes as PSMoveController::getTrackingShape() and PSDualShock4Controller::getTrackingShape()
+static void build_tracking_shapes(
+    CommonDeviceTrackingShape &out_sphere_shape,
+    CommonDeviceTrackingShape &out_lightbar_shape)
+{
+    const float quad_half_x = k_lightbar_quad_width_cm / 2.f;
+    const float quad_half_y = k_lightbar_quad_height_cm / 2.f;
+    const float tri_half_x = k_lightbar_triangle_width_cm / 2.f;
+    const float tri_lower_half_y = k_lightbar_triangle_height_cm - quad_half_y;
+
+    out_sphere_shape.shape_type = eCommonTrackingShapeType::Sphere;
+    out_sphere_shape.shape.sphere.radius_cm = k_sphere_radius_cm;
+
+    out_lightbar_shape.shape_type = eCommonTrackingShapeType::LightBar;
+    out_lightbar_shape.shape.light_bar.triangle[CommonDeviceTrackingShape::TriVertexLowerRight] = { tri_half_x, -tri_lower_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.triangle[CommonDeviceTrackingShape::TriVertexLowerLeft] = { -tri_half_x, -tri_lower_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.triangle[CommonDeviceTrackingShape::TriVertexUpperMiddle] = { 0.f, quad_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexUpperRight] = { quad_half_x, quad_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexUpperLeft] = { -quad_half_x, quad_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexLowerLeft] = { -quad_half_x, -quad_half_y, 0.f };
+    out_lightbar_shape.shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexLowerRight] = { quad_half_x, -quad_half_y, 0.f };
+}
+
+// Stand-in for computeTrackerROIForPoseProjection(): 
+// the last contour's bounds grown to twice their size, or the full frame when the blob got lost
+static cv::Rect2i compute_blob_roi(const cv::Rect2i &prior_bounds, bool bHasPriorBounds, int width, int height)
+{
+    if (!bHasPriorBounds)
+    {
+        return cv::Rect2i(0, 0, width, height);
+    }
+
+    const int roi_width = std::max(prior_bounds.width * 2, k_min_roi_size);
+    const int roi_height = std::max(prior_bounds.height * 2, k_min_roi_size);
+
+    return cv::Rect2i(
+        prior_bounds.x + prior_bounds.width / 2 - roi_width / 2,
+        prior_bounds.y + prior_bounds.height / 2 - roi_height / 2,
+        roi_width, roi_height);
+}
+
+static cv::Point2f project_point(const cv::Matx34f &pinhole_matrix, const Eigen::Vector3f &point)
+{
+    const cv::Vec3f projected = pinhole_matrix * cv::Vec4f(point.x(), point.y(), point.z(), 1.f);
+
+    return cv::Point2f(projected[0] / projected[2], projected[1] / projected[2]);
+}
+
+static IPoseFilter *create_pose_filter(PoseFilterSpace &pose_filter_space)
+{
+    // Typical PSMove calibration values
+    PoseFilterConstants constants;
+    constants.clear();
+
+    constants.orientation_constants.mean_update_time_delta = k_frame_time_delta;
+    constants.orientation_constants.gravity_calibration_direction = pose_filter_space.getGravityCalibrationDirection();
+    constants.orientation_constants.magnetometer_calibration_direction = pose_filter_space.getMagnetometerCalibrationDirection();
+    constants.orientation_constants.gyro_drift = Eigen::Vector3f(0.0015f, 0.0015f, 0.0015f);
+    constants.orientation_constants.gyro_variance = Eigen::Vector3f(1.5e-5f, 1.5e-5f, 1.5e-5f);
+    constants.orientation_constants.accelerometer_variance = Eigen::Vector3f(1.4e-4f, 1.4e-4f, 1.4e-4f);
+    constants.orientation_constants.magnetometer_variance = Eigen::Vector3f(2.e-3f, 2.e-3f, 2.e-3f);
+
+    constants.position_constants.accelerometer_variance = Eigen::Vector3f(1.4e-4f, 1.4e-4f, 1.4e-4f);
+    constants.position_constants.accelerometer_noise_radius = 0.0139137721f;
+    constants.position_constants.max_velocity = 1.0f;
+    constants.position_constants.position_variance_curve.A = 0.44888f;
+    constants.position_constants.position_variance_curve.B = -0.00402f;
+    constants.position_constants.position_variance_curve.MaxValue = 1.0f;
+    constants.position_constants.mean_update_time_delta = k_frame_time_delta;
+    constants.position_constants.gravity_calibration_direction = pose_filter_space.getGravityCalibrationDirection();
+
+    KalmanPoseFilterPSMove *pose_filter = new KalmanPoseFilterPSMove();
+    pose_filter->init(constants, Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity());
+
+    return pose_filter;
+}
+
+// Mirrors generate_psmove_data_frame_for_stream()
+static void generate_data_frame(
+    int controller_id,
+    int sequence_num,
+    const IPoseFilter *pose_filter,
+    const PoseSensorPacket &sensor_packet,
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame)
+{
+    auto *controller_data_frame = data_frame->mutable_controller_data_packet();
+    auto *psmove_data_frame = controller_data_frame->mutable_psmove_state();
+    const Eigen::Quaternionf orientation = pose_filter->getOrientation();
+    const Eigen::Vector3f position = pose_filter->getPositionCm();
+    const Eigen::Vector3f velocity = pose_filter->getVelocityCmPerSec();
+    const Eigen::Vector3f acceleration = pose_filter->getAccelerationCmPerSecSqr();
+    const Eigen::Vector3f angular_velocity = pose_filter->getAngularVelocityRadPerSec();
+    const Eigen::Vector3f angular_acceleration = pose_filter->getAngularAccelerationRadPerSecSqr();
+
+    controller_data_frame->set_controller_id(controller_id);
+    controller_data_frame->set_sequence_num(sequence_num);
+    controller_data_frame->set_isconnected(true);
+
+    psmove_data_frame->set_validhardwarecalibration(true);
+    psmove_data_frame->set_iscurrentlytracking(true);
+    psmove_data_frame->set_istrackingenabled(true);
+    psmove_data_frame->set_isorientationvalid(pose_filter->getIsOrientationStateValid());
+    psmove_data_frame->set_ispositionvalid(pose_filter->getIsPositionStateValid());
+
+    psmove_data_frame->mutable_orientation()->set_w(orientation.w());
+    psmove_data_frame->mutable_orientation()->set_x(orientation.x());
+    psmove_data_frame->mutable_orientation()->set_y(orientation.y());
+    psmove_data_frame->mutable_orientation()->set_z(orientation.z());
+
+    psmove_data_frame->mutable_position_cm()->set_x(position.x());
+    psmove_data_frame->mutable_position_cm()->set_y(position.y());
+    psmove_data_frame->mutable_position_cm()->set_z(position.z());
+
+    psmove_data_frame->set_trigger_value(0);
+    psmove_data_frame->set_battery_value(4);
+    controller_data_frame->set_button_down_bitmask(0);
+
+    {
+        auto *calibrated_sensor_data = psmove_data_frame->mutable_calibrated_sensor_data();
+        const Eigen::Vector3f *sensor_vectors[3] = {
+            &sensor_packet.imu_magnetometer_unit, &sensor_packet.imu_accelerometer_g_units, &sensor_packet.imu_gyroscope_rad_per_sec };
+        PSMoveProtocol::FloatVector *vectors[3] = {
+            calibrated_sensor_data->mutable_magnetometer(), calibrated_sensor_data->mutable_accelerometer(), calibrated_sensor_data->mutable_gyroscope() };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            vectors[i]->set_i(sensor_vectors[i]->x());
+            vectors[i]->set_j(sensor_vectors[i]->y());
+            vectors[i]->set_k(sensor_vectors[i]->z());
+        }
+    }
+
+    {
+        auto *physics_data = psmove_data_frame->mutable_physics_data();
+        const Eigen::Vector3f *physics_vectors[4] = { &velocity, &acceleration, &angular_velocity, &angular_acceleration };
+        PSMoveProtocol::FloatVector *vectors[4] = {
+            physics_data->mutable_velocity_cm_per_sec(), physics_data->mutable_acceleration_cm_per_sec_sqr(),
+            physics_data->mutable_angular_velocity_rad_per_sec(), physics_data->mutable_angular_acceleration_rad_per_sec_sqr() };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            vectors[i]->set_i(physics_vectors[i]->x());
+            vectors[i]->set_j(physics_vectors[i]->y());
+            vectors[i]->set_k(physics_vectors[i]->z());
+        }
+    }
+
+    controller_data_frame->set_controller_type(PSMoveProtocol::PSMOVE);
+    data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER);
+}
+
+// -- Benchmark --
+struct BenchmarkResult
+{
+    StageTimings timings;
+    int expected_blob_count;
+    int detected_blob_count;
+    size_t data_frame_bytes;
+};
+
+static void run_benchmark(const BenchmarkSettings &settings, BenchmarkResult &result)
+{
+    std::vector<TrackingColor> colors;
+    build_tracking_colors(colors);
+
+    // Spread the blobs out around the orbit so they don't overlap
+    const int blob_count = settings.sphere_count + settings.lightbar_count;
+    std::vector<SyntheticBlob> blobs(blob_count);
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        blobs[blob_index].bIsSphere = blob_index < settings.sphere_count;
+        blobs[blob_index].color_index = blob_index;
+        blobs[blob_index].orbit_phase = 6.2831853f * static_cast<float>(blob_index) / static_cast<float>(blob_count);
+    }
+
+    // Two cameras side by side for the triangulation
+    cv::Matx33f camera_matrix;
+    cv::Matx<float, 5, 1> distortions;
+    compute_camera_intrinsics(settings.width, settings.height, camera_matrix, distortions);
+    const cv::Matx34f pinhole_matrix_1 = camera_matrix * cv::Matx34f(
+        1.f, 0.f, 0.f, 0.f,
+        0.f, 1.f, 0.f, 0.f,
+        0.f, 0.f, 1.f, 0.f);
+    const cv::Matx34f pinhole_matrix_2 = camera_matrix * cv::Matx34f(
+        1.f, 0.f, 0.f, -k_stereo_baseline_cm,
+        0.f, 1.f, 0.f, 0.f,
+        0.f, 0.f, 1.f, 0.f);
+
+    // One pose filter per blob
+    PoseFilterSpace pose_filter_space;
+    pose_filter_space.setIdentityGravity(Eigen::Vector3f(0.f, 0.f, -1.f));
+    pose_filter_space.setIdentityMagnetometer(Eigen::Vector3f(0.234017432f, 0.873125494f, 0.42765367f));
+    pose_filter_space.setCalibrationTransform(*k_eigen_identity_pose_upright);
+    pose_filter_space.setSensorTransform(*k_eigen_sensor_transform_identity);
+
+    std::vector<IPoseFilter *> pose_filters(blob_count);
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        pose_filters[blob_index] = create_pose_filter(pose_filter_space);
+    }
+
+    // The tracker's own frame buffers, with one color job per blob
+    OpenCVBufferState buffer_state(settings.width, settings.height, settings.hsv_converter);
+    cv::Mat bgr_scratch(settings.height, settings.width, CV_8UC3);
+    cv::Mat bayer(settings.height, settings.width, CV_8UC1);
+    TrackerColorJobList color_jobs;
+    TrackerFrameResult frame_result;
+    std::vector<cv::Rect2i> prior_bounds(blob_count);
+    std::vector<bool> bHasPriorBounds(blob_count, false);
+
+    CommonDeviceTrackingShape sphere_shape, lightbar_shape;
+    build_tracking_shapes(sphere_shape, lightbar_shape);
+
+    google::protobuf::Arena arena;
+    uint8_t data_frame_buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    StageTimings &timings = result.timings;
+
+    result.expected_blob_count = 0;
+    result.detected_blob_count = 0;
+    result.data_frame_bytes = 0;
+
+    for (int frame_index = 0; frame_index < k_warmup_frame_count + settings.frame_count; ++frame_index)
+    {
+        const bool bIsRecording = frame_index >= k_warmup_frame_count;
+        timings.setIsRecording(bIsRecording);
+
+        render_bayer_frame(blobs, colors, frame_index, bgr_scratch, bayer);
+
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            TrackerColorJob &job = color_jobs.jobs[blob_index];
+
+            job.bIsActive = true;
+            // Only the HSV range matters to the segmentation (orange and purple have no color id)
+            job.color_id = (blob_index < MAX_TRACKING_COLOR_TYPES) ? static_cast<eCommonTrackingColorID>(blob_index) : INVALID_COLOR;
+            job.hsv_color_range = colors[blobs[blob_index].color_index].hsv_range;
+            job.ROI = compute_blob_roi(prior_bounds[blob_index], bHasPriorBounds[blob_index], settings.width, settings.height);
+            job.max_contour_count = 1;
+        }
+
+        const std::chrono::time_point<std::chrono::high_resolution_clock> frame_start = std::chrono::high_resolution_clock::now();
+
+        // No one watching the video stream: only the tiles under the ROIs get debayered
+        timings.time(_stage_frame_copy, [&]() {
+            buffer_state.writeBayerFrame(bayer.data, false);
+        });
+
+        // Fills the tile cache the way computeColorLabels() does on its first touch of each ROI,
+        // so the segmentation stage below only labels and extracts contours
+        timings.time(_stage_debayer_hsv, [&]() {
+            for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+            {
+                buffer_state.selectROI(color_jobs.jobs[blob_index].ROI);
+            }
+        });
+
+        timings.time(_stage_segmentation, [&]() {
+            computeContoursForColorJobs(&buffer_state, color_jobs, frame_result);
+        });
+
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            const TrackerColorResult *color_result = frame_result.getColorResult(blob_index);
+            const bool bIsSphere = blobs[blob_index].bIsSphere;
+
+            if (bIsRecording)
+            {
+                ++result.expected_blob_count;
+            }
+
+            bHasPriorBounds[blob_index] = color_result != nullptr && !color_result->contours.empty();
+            if (!bHasPriorBounds[blob_index])
+            {
+                continue;
+            }
+
+            const t_opencv_int_contour &biggest_contour = color_result->contours[0];
+            prior_bounds[blob_index] = cv::boundingRect(biggest_contour);
+
+            // Same steps as ServerTrackerView::computeProjectionForController()
+            t_opencv_float_contour undistorted_contour;
+            timings.time(_stage_undistort, [&]() {
+                if (bIsSphere)
+                {
+                    t_opencv_int_contour convex_contour;
+
+                    cv::convexHull(biggest_contour, convex_contour);
+                    computeUndistortedContour(convex_contour, camera_matrix, distortions, true, undistorted_contour);
+                }
+                else
+                {
+                    computeUndistortedContour(biggest_contour, camera_matrix, distortions, false, undistorted_contour);
+                }
+            });
+
+            // The light bar pose gets solved here too (ServerTrackerView::computePoseForProjection() with a single tracker)
+            CommonDevicePosition position_cm;
+            CommonDeviceTrackingProjection projection;
+            bool bFitSucceeded = false;
+            position_cm.clear();
+            memset(&projection, 0, sizeof(CommonDeviceTrackingProjection));
+            timings.time(_stage_shape_fit, [&]() {
+                if (bIsSphere)
+                {
+                    bFitSucceeded = 
+                        computeTrackerRelativeSphereProjection(
+                            &sphere_shape, undistorted_contour, camera_matrix, &position_cm, &projection);
+                }
+                else if (computeTrackerRelativeLightBarProjection(&lightbar_shape, undistorted_contour, &projection))
+                {
+                    CommonDeviceQuaternion orientation;
+                    bool bOrientationValid = false;
+
+                    bFitSucceeded =
+                        computeTrackerRelativeLightBarPose(
+                            camera_matrix, distortions, &lightbar_shape, &projection, nullptr,
+                            &position_cm, &orientation, &bOrientationValid);
+                }
+            });
+
+            if (!bFitSucceeded)
+            {
+                continue;
+            }
+
+            if (bIsRecording)
+            {
+                ++result.detected_blob_count;
+            }
+
+            Eigen::Vector3f optical_position_cm(position_cm.x, position_cm.y, position_cm.z);
+            const float projection_area = projection.screen_area;
+
+            // Same position seen by a second tracker, then triangulated back
+            timings.time(_stage_triangulation, [&]() {
+                cv::Mat projPoints1 = cv::Mat(project_point(pinhole_matrix_1, optical_position_cm));
+                cv::Mat projPoints2 = cv::Mat(project_point(pinhole_matrix_2, optical_position_cm));
+                cv::Mat projMat1 = cv::Mat(pinhole_matrix_1);
+                cv::Mat projMat2 = cv::Mat(pinhole_matrix_2);
+                cv::Mat point3D(1, 1, CV_32FC4);
+
+                cv::triangulatePoints(projMat1, projMat2, projPoints1, projPoints2, point3D);
+
+                const float w = point3D.at<float>(3, 0);
+                if (fabsf(w) > k_real_epsilon)
+                {
+                    optical_position_cm = Eigen::Vector3f(point3D.at<float>(0, 0), point3D.at<float>(1, 0), point3D.at<float>(2, 0)) / w;
+                }
+            });
+
+            // A controller held still, besides the optical position
+            PoseSensorPacket sensor_packet;
+            sensor_packet.optical_position_cm = optical_position_cm;
+            sensor_packet.optical_orientation = Eigen::Quaternionf::Identity();
+            sensor_packet.tracking_projection_area_px_sqr = projection_area;
+            sensor_packet.imu_accelerometer_g_units = Eigen::Vector3f(0.f, 0.f, -1.f);
+            sensor_packet.imu_magnetometer_unit = Eigen::Vector3f(0.234017432f, 0.873125494f, 0.42765367f);
+            sensor_packet.imu_gyroscope_rad_per_sec = Eigen::Vector3f::Zero();
+
+            timings.time(_stage_pose_filter_update, [&]() {
+                PoseFilterPacket filter_packet;
+
+                pose_filter_space.createFilterPacket(sensor_packet, pose_filters[blob_index], filter_packet);
+                pose_filters[blob_index]->update(k_frame_time_delta, filter_packet);
+            });
+
+            // The service builds each data frame on an arena that is reset after publishing
+            PSMoveProtocol::DeviceOutputDataFrame *data_frame = nullptr;
+            timings.time(_stage_data_frame_generation, [&]() {
+                data_frame = google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(&arena);
+                generate_data_frame(blob_index, frame_index, pose_filters[blob_index], sensor_packet, data_frame);
+            });
+
+            timings.time(_stage_data_frame_serialization, [&]() {
+                const int msg_size = data_frame->ByteSize();
+
+                PackedMessage<PSMoveProtocol::DeviceOutputDataFrame>::pack_exact(*data_frame, data_frame_buffer, msg_size);
+                result.data_frame_bytes = HEADER_SIZE + msg_size;
+            });
+
+            arena.Reset();
+        }
+
+        const std::chrono::time_point<std::chrono::high_resolution_clock> frame_end = std::chrono::high_resolution_clock::now();
+        timings.addSample(_stage_total, std::chrono::duration<double, std::nano>(frame_end - frame_start).count());
+    }
+
+    for (IPoseFilter *pose_filter : pose_filters)
+    {
+        delete pose_filter;
+    }
+}
+
+// -- Output --
+static std::string json_escape(const std::string &text)
+{
+    std::string escaped;
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+static void print_results(const BenchmarkSettings &settings, const BenchmarkResult &result)
+{
+    printf("Tracker pipeline: %dx%d, %d spheres, %d lightbars, %d frames (HSV converter: %s, SIMD kernel: %s)\n",
+        settings.width, settings.height, settings.sphere_count, settings.lightbar_count, settings.frame_count,
+        settings.hsv_converter.c_str(), BGRToHSVConverter::getKernelName());
+    printf("  %-26s %-6s %10s %10s %10s %14s\n", "stage", "per", "p50 (us)", "p99 (us)", "max (us)", "throughput/s");
+
+    for (int stage = 0; stage < _stage_count; ++stage)
+    {
+        const StageStatistics statistics = result.timings.computeStatistics(static_cast<eBenchmarkStage>(stage));
+
+        printf("  %-26s %-6s %10.2f %10.2f %10.2f %14.0f\n",
+            k_stage_infos[stage].name, k_stage_infos[stage].unit,
+            statistics.p50_us, statistics.p99_us, statistics.max_us, statistics.throughput_per_sec);
+    }
+
+    printf("  Detected %d of %d blobs, %d byte data frames\n",
+        result.detected_blob_count, result.expected_blob_count, static_cast<int>(result.data_frame_bytes));
+}
+
+// The config, detection rate and stage statistics of one run, each line prefixed with indent
+static void write_json_run(FILE *file, const BenchmarkSettings &settings, const BenchmarkResult &result, const char *indent)
+{
+    const double detection_rate =
+        (result.expected_blob_count > 0)
+        ? static_cast<double>(result.detected_blob_count) / static_cast<double>(result.expected_blob_count)
+        : 0.0;
+
+    fprintf(file, "%s\"config\": {\n", indent);
+    fprintf(file, "%s  \"width\": %d,\n", indent, settings.width);
+    fprintf(file, "%s  \"height\": %d,\n", indent, settings.height);
+    fprintf(file, "%s  \"spheres\": %d,\n", indent, settings.sphere_count);
+    fprintf(file, "%s  \"lightbars\": %d,\n", indent, settings.lightbar_count);
+    fprintf(file, "%s  \"frames\": %d,\n", indent, settings.frame_count);
+    fprintf(file, "%s  \"hsv_converter\": \"%s\",\n", indent, json_escape(settings.hsv_converter).c_str());
+    fprintf(file, "%s  \"hsv_kernel\": \"%s\"\n", indent, json_escape(BGRToHSVConverter::getKernelName()).c_str());
+    fprintf(file, "%s},\n", indent);
+    fprintf(file, "%s\"detection_rate\": %.4f,\n", indent, detection_rate);
+    fprintf(file, "%s\"data_frame_bytes\": %d,\n", indent, static_cast<int>(result.data_frame_bytes));
+    fprintf(file, "%s\"stages\": [\n", indent);
+
+    for (int stage = 0; stage < _stage_count; ++stage)
+    {
+        const StageStatistics statistics = result.timings.computeStatistics(static_cast<eBenchmarkStage>(stage));
+
+        fprintf(file,
+            "%s  { \"name\": \"%s\", \"unit\": \"%s\", \"samples\": %d, "
+            "\"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f, \"mean_us\": %.3f, \"throughput_per_sec\": %.1f }%s\n",
+            indent, k_stage_infos[stage].name, k_stage_infos[stage].unit, statistics.sample_count,
+            statistics.p50_us, statistics.p99_us, statistics.max_us, statistics.mean_us, statistics.throughput_per_sec,
+            (stage + 1 < _stage_count) ? "," : "");
+    }
+
+    fprintf(file, "%s]\n", indent);
+}
+
+// A single run keeps its results at the top level, an --objects sweep lists one entry per object count under "runs"
+static bool write_json_results(
+    const BenchmarkSettings &settings,
+    const std::vector<BenchmarkSettings> &run_settings,
+    const std::vector<BenchmarkResult> &run_results)
+{
+    FILE *file = fopen(settings.output_path.c_str(), "w");
+
+    if (file == nullptr)
+    {
+        printf("Failed to write the results to: %s\n", settings.output_path.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"benchmark\": \"tracker_pipeline\",\n");
+    fprintf(file, "  \"label\": \"%s\",\n", json_escape(settings.label).c_str());
+
+    if (settings.object_counts.empty())
+    {
+        write_json_run(file, run_settings[0], run_results[0], "  ");
+    }
+    else
+    {
+        fprintf(file, "  \"runs\": [\n");
+
+        for (size_t run_index = 0; run_index < run_results.size(); ++run_index)
+        {
+            fprintf(file, "    {\n");
+            write_json_run(file, run_settings[run_index], run_results[run_index], "      ");
+            fprintf(file, "    }%s\n", (run_index + 1 < run_results.size()) ? "," : "");
+        }
+
+        fprintf(file, "  ]\n");
+    }
+
+    fprintf(file, "}\n");
+    fclose(file);
+
+    printf("Results written to: %s\n", settings.output_path.c_str());
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    BenchmarkSettings settings;
+    if (!parse_settings(argc, argv, settings))
+    {
+        return -1;
+    }
+
+    // One run per object count when sweeping, each one tracking that many spheres
+    std::vector<BenchmarkSettings> run_settings;
+    if (settings.object_counts.empty())
+    {
+        run_settings.push_back(settings);
+    }
+    else
+    {
+        for (int object_count : settings.object_counts)
+        {
+            run_settings.push_back(settings);
+            run_settings.back().sphere_count = object_count;
+            run_settings.back().lightbar_count = 0;
+        }
+    }
+
+    std::vector<BenchmarkResult> run_results(run_settings.size());
+    for (size_t run_index = 0; run_index < run_settings.size(); ++run_index)
+    {
+        run_benchmark(run_settings[run_index], run_results[run_index]);
+        print_results(run_settings[run_index], run_results[run_index]);
+    }
+
+    return write_json_results(settings, run_settings, run_results) ? 0 : -1;
+}
@@ -0,0 +1,357 @@
+// Sends a tick's worth of data frames to a number of simulated clients on localhost,
+// first the way the network manager used to (one fixed size async write in flight at a time,
+// at most 32 io_service polls per update) and then with the ServerUdpBatchSender.
+
+#include "ServerUdpBatchSender.h"
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace asio = boost::asio;
+using asio::ip::udp;
+
+static const int k_client_count = 8;
+static const int k_frames_per_client_per_tick = 3; // e.g. two controllers and an HMD streaming
+static const int k_tick_count = 20000;
+
+// Stand-in for a serialized controller data frame (header + message)
+static const int k_data_frame_size = 120;
+// What the old code sent for every data frame: HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE
+static const int k_legacy_datagram_size = 504;
+// The old poll() gave up after this many io_service polls per update
+static const int k_legacy_max_iteration_count = 32;
+
+struct SimulatedClient
+{
+    SimulatedClient(asio::io_service &io_service)
+        : socket(io_service, udp::endpoint(asio::ip::address_v4::loopback(), 0))
+        , received_datagram_count(0)
+        , received_byte_count(0)
+        , bad_datagram_count(0)
+    {
+        socket.non_blocking(true);
+        socket.set_option(asio::socket_base::receive_buffer_size(1 << 20));
+    }
+
+    void drain(int client_index)
+    {
+        uint8_t buffer[1024];
+        boost::system::error_code error;
+
+        for (;;)
+        {
+            udp::endpoint sender_endpoint;
+            const size_t size = socket.receive_from(asio::buffer(buffer), sender_endpoint, 0, error);
+            if (error)
+            {
+                break;
+            }
+
+            // Every datagram starts with the id of the client it was addressed to
+            if (size < 1 || buffer[0] != static_cast<uint8_t>(client_index))
+            {
+                ++bad_datagram_count;
+            }
+
+            ++received_datagram_count;
+            received_byte_count += size;
+        }
+    }
+
+    udp::socket socket;
+    int received_datagram_count;
+    size_t received_byte_count;
+    int bad_datagram_count;
+};
+
+typedef std::vector<std::unique_ptr<SimulatedClient> > t_client_list;
+
+struct BenchmarkResult
+{
+    double send_ns_per_tick;
+    int sent_datagram_count;
+    int received_datagram_count;
+    size_t received_byte_count;
+    int bad_datagram_count;
+    int max_polls_per_tick;
+};
+
+static void reset_clients(t_client_list &clients)
+{
+    for (int client_index = 0; client_index < k_client_count; ++client_index)
+    {
+        clients[client_index]->drain(client_index);
+        clients[client_index]->received_datagram_count = 0;
+        clients[client_index]->received_byte_count = 0;
+        clients[client_index]->bad_datagram_count = 0;
+    }
+}
+
+static void collect_client_stats(t_client_list &clients, BenchmarkResult &result)
+{
+    result.received_datagram_count = 0;
+    result.received_byte_count = 0;
+    result.bad_datagram_count = 0;
+
+    for (int client_index = 0; client_index < k_client_count; ++client_index)
+    {
+        clients[client_index]->drain(client_index);
+        result.received_datagram_count += clients[client_index]->received_datagram_count;
+        result.received_byte_count += clients[client_index]->received_byte_count;
+        result.bad_datagram_count += clients[client_index]->bad_datagram_count;
+    }
+}
+
+// -- The old per connection send loop --
+class LegacySender
+{
+public:
+    LegacySender(asio::io_service &io_service, udp::socket &socket, const std::vector<udp::endpoint> &endpoints)
+        : m_io_service(io_service)
+        , m_socket(socket)
+        , m_endpoints(endpoints)
+        , m_pending_frame_counts(endpoints.size(), 0)
+        , m_has_pending_write(false)
+        , m_sent_count(0)
+    {
+        memset(m_buffer, 0, sizeof(m_buffer));
+    }
+
+    void queue_frames(int client_index, int frame_count)
+    {
+        m_pending_frame_counts[client_index] += frame_count;
+    }
+
+    // Mirrors the old ServerNetworkManagerImpl::poll()
+    int poll()
+    {
+        bool keep_polling = true;
+        int iteration_count = 0;
+
+        while (keep_polling && iteration_count < k_legacy_max_iteration_count)
+        {
+            start_write();
+            m_io_service.poll();
+            keep_polling = !m_has_pending_write && has_pending_frames();
+            ++iteration_count;
+        }
+
+        return iteration_count;
+    }
+
+    int get_sent_count() const
+    {
+        return m_sent_count;
+    }
+
+private:
+    bool has_pending_frames() const
+    {
+        for (int count : m_pending_frame_counts)
+        {
+            if (count > 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void start_write()
+    {
+        if (m_has_pending_write)
+        {
+            return;
+        }
+
+        for (size_t client_index = 0; client_index < m_endpoints.size(); ++client_index)
+        {
+            if (m_pending_frame_counts[client_index] > 0)
+            {
+                m_buffer[0] = static_cast<uint8_t>(client_index);
+                m_current_client_index = static_cast<int>(client_index);
+                m_has_pending_write = true;
+
+                m_socket.async_send_to(
+                    asio::buffer(m_buffer, sizeof(m_buffer)),
+                    m_endpoints[client_index],
+                    boost::bind(&LegacySender::handle_write_complete, this, asio::placeholders::error));
+                break;
+            }
+        }
+    }
+
+    void handle_write_complete(const boost::system::error_code &error)
+    {
+        m_has_pending_write = false;
+
+        if (!error)
+        {
+            --m_pending_frame_counts[m_current_client_index];
+            ++m_sent_count;
+        }
+    }
+
+    asio::io_service &m_io_service;
+    udp::socket &m_socket;
+    const std::vector<udp::endpoint> &m_endpoints;
+    std::vector<int> m_pending_frame_counts;
+    uint8_t m_buffer[k_legacy_datagram_size];
+    int m_current_client_index;
+    bool m_has_pending_write;
+    int m_sent_count;
+};
+
+static BenchmarkResult run_legacy(
+    asio::io_service &io_service,
+    udp::socket &server_socket,
+    const std::vector<udp::endpoint> &endpoints,
+    t_client_list &clients)
+{
+    BenchmarkResult result;
+    LegacySender sender(io_service, server_socket, endpoints);
+    std::chrono::duration<double, std::nano> send_time(0);
+
+    reset_clients(clients);
+    result.max_polls_per_tick = 0;
+
+    for (int tick = 0; tick < k_tick_count; ++tick)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+        for (int client_index = 0; client_index < k_client_count; ++client_index)
+        {
+            sender.queue_frames(client_index, k_frames_per_client_per_tick);
+        }
+
+        const int poll_count = sender.poll();
+
+        send_time += std::chrono::high_resolution_clock::now() - start;
+
+        if (poll_count > result.max_polls_per_tick)
+        {
+            result.max_polls_per_tick = poll_count;
+        }
+
+        for (int client_index = 0; client_index < k_client_count; ++client_index)
+        {
+            clients[client_index]->drain(client_index);
+        }
+    }
+
+    result.send_ns_per_tick = send_time.count() / static_cast<double>(k_tick_count);
+    result.sent_datagram_count = sender.get_sent_count();
+    collect_client_stats(clients, result);
+
+    return result;
+}
+
+static BenchmarkResult run_batched(
+    udp::socket &server_socket,
+    const std::vector<udp::endpoint> &endpoints,
+    t_client_list &clients)
+{
+    BenchmarkResult result;
+    ServerUdpBatchSender sender(server_socket);
+    std::chrono::duration<double, std::nano> send_time(0);
+
+    reset_clients(clients);
+    result.sent_datagram_count = 0;
+    result.max_polls_per_tick = 0;
+
+    for (int tick = 0; tick < k_tick_count; ++tick)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+        for (int client_index = 0; client_index < k_client_count; ++client_index)
+        {
+            for (int frame_index = 0; frame_index < k_frames_per_client_per_tick; ++frame_index)
+            {
+                uint8_t *datagram = sender.addDatagram(endpoints[client_index], k_data_frame_size);
+
+                memset(datagram, frame_index, k_data_frame_size);
+                datagram[0] = static_cast<uint8_t>(client_index);
+            }
+        }
+
+        result.sent_datagram_count += sender.sendAll();
+        sender.clear();
+
+        send_time += std::chrono::high_resolution_clock::now() - start;
+
+        for (int client_index = 0; client_index < k_client_count; ++client_index)
+        {
+            clients[client_index]->drain(client_index);
+        }
+    }
+
+    result.send_ns_per_tick = send_time.count() / static_cast<double>(k_tick_count);
+    collect_client_stats(clients, result);
+
+    return result;
+}
+
+static void print_result(const char *label, const BenchmarkResult &result)
+{
+    const int expected_count = k_tick_count * k_client_count * k_frames_per_client_per_tick;
+
+    printf("  %s\n", label);
+    printf("    %.1f us/tick, %.1f ns/data frame\n",
+        result.send_ns_per_tick / 1000.0,
+        result.send_ns_per_tick / static_cast<double>(k_client_count * k_frames_per_client_per_tick));
+    printf("    sent %d/%d data frames, received %d (%d misaddressed), %.1f bytes/data frame on the wire\n",
+        result.sent_datagram_count, expected_count,
+        result.received_datagram_count, result.bad_datagram_count,
+        result.received_datagram_count > 0
+            ? static_cast<double>(result.received_byte_count) / static_cast<double>(result.received_datagram_count)
+            : 0.0);
+    if (result.max_polls_per_tick > 0)
+    {
+        printf("    up to %d io_service polls per tick\n", result.max_polls_per_tick);
+    }
+}
+
+int main()
+{
+    asio::io_service io_service;
+    // The service always has an accept and a receive outstanding, so its io_service never runs out of work
+    asio::io_service::work io_service_work(io_service);
+    udp::socket server_socket(io_service, udp::endpoint(asio::ip::address_v4::loopback(), 0));
+    t_client_list clients;
+    std::vector<udp::endpoint> endpoints;
+
+    server_socket.set_option(asio::socket_base::send_buffer_size(1 << 20));
+
+    for (int client_index = 0; client_index < k_client_count; ++client_index)
+    {
+        clients.push_back(std::unique_ptr<SimulatedClient>(new SimulatedClient(io_service)));
+        endpoints.push_back(clients.back()->socket.local_endpoint());
+    }
+
+    printf("%d clients, %d data frames per client per tick, %d ticks\n",
+        k_client_count, k_frames_per_client_per_tick, k_tick_count);
+
+    const BenchmarkResult legacy_result = run_legacy(io_service, server_socket, endpoints, clients);
+    const BenchmarkResult batched_result = run_batched(server_socket, endpoints, clients);
+
+    print_result("One async_send_to in flight at a time (fixed size datagrams):", legacy_result);
+    print_result("ServerUdpBatchSender:", batched_result);
+
+    // Loopback doesn't drop datagrams as long as the clients keep up
+    const int expected_count = k_tick_count * k_client_count * k_frames_per_client_per_tick;
+    const bool success =
+        batched_result.sent_datagram_count == expected_count &&
+        batched_result.received_datagram_count == expected_count &&
+        batched_result.bad_datagram_count == 0 &&
+        batched_result.received_byte_count == static_cast<size_t>(expected_count) * k_data_frame_size;
+
+    return success ? 0 : -1;
+}
@@ -13,6 +13,12 @@ main(int argc, char* argv[])
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_alignment_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_eigen_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_utility_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_shared_video_frame_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_shared_pose_table_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_clock_offset_estimator_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_device_input_recording_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_pose_filter_history_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_device_clock_model_unit_tests);
 	UNIT_TEST_SUITE_END()
 
 	return success ? EXIT_SUCCESS : EXIT_FAILURE;